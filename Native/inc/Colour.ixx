@@ -4,6 +4,7 @@ module;
 export module Glib.Windows.Colour;
 import <cstdint>;
 import <type_traits>;
+import <stdexcept>;
 export import :Implement;
 
 export namespace gl::win32
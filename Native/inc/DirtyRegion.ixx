@@ -0,0 +1,93 @@
+export module Glib.DirtyRegion;
+import <cstddef>;
+import <vector>;
+import <span>;
+import <mutex>;
+import Glib.Rect;
+
+export namespace gl
+{
+	/// <summary>
+	/// Rectangles changed since the last present, merged as they are added
+	/// <para>A new rectangle swallows the ones it overlaps, touches or lies close to when their union wastes little area.</para>
+	/// <para>Past the limit of rectangles, the pair whose union wastes the least area is merged, so the list never grows.</para>
+	/// </summary>
+	class [[nodiscard]] DirtyRegion
+	{
+	public:
+		static constexpr std::size_t DefaultLimit = 16;
+
+		constexpr DirtyRegion() noexcept = default;
+		explicit DirtyRegion(std::size_t limit) noexcept;
+		~DirtyRegion() noexcept = default;
+
+		/// <summary>
+		/// Add a rectangle, the empty ones are ignored
+		/// </summary>
+		void Add(const Rect& rect);
+		/// <summary>
+		/// Cut every rectangle to the bounds, the rectangles outside are dropped
+		/// </summary>
+		void Clip(const Rect& bounds);
+		void Clear() noexcept;
+
+		[[nodiscard]] std::span<const Rect> GetRects() const noexcept;
+		/// <summary>
+		/// The rectangle around every rectangle, empty when the region is
+		/// </summary>
+		[[nodiscard]] Rect GetBounds() const noexcept;
+		/// <summary>
+		/// Pixels covered by the rectangles, which never overlap
+		/// </summary>
+		[[nodiscard]] long long GetArea() const noexcept;
+		[[nodiscard]] std::size_t GetLimit() const noexcept;
+		[[nodiscard]] bool IsEmpty() const noexcept;
+
+		DirtyRegion(const DirtyRegion&) = default;
+		DirtyRegion(DirtyRegion&&) noexcept = default;
+		DirtyRegion& operator=(const DirtyRegion&) = default;
+		DirtyRegion& operator=(DirtyRegion&&) noexcept = default;
+
+	private:
+		std::vector<Rect> myRects{};
+		std::size_t myLimit = DefaultLimit;
+	};
+
+	/// <summary>
+	/// A dirty region invalidated from any thread and taken whole by the paint
+	/// </summary>
+	class [[nodiscard]] SharedDirtyRegion
+	{
+	public:
+		SharedDirtyRegion() noexcept = default;
+		~SharedDirtyRegion() noexcept = default;
+
+		void Add(const Rect& rect);
+		/// <summary>
+		/// Replace every rectangle with one
+		/// </summary>
+		void Reset(const Rect& rect);
+		/// <summary>
+		/// Move the rectangles to the region of a paint, and start the next one empty
+		/// <para>The area the system asked to paint is added unless the rectangles already cover it, since it invalidates by itself when the window is uncovered.</para>
+		/// </summary>
+		/// <param name="bounds">The client area, every rectangle is cut to it</param>
+		void Take(const Rect& paint_rect, const Rect& bounds, DirtyRegion& output);
+
+		SharedDirtyRegion(const SharedDirtyRegion&) = delete;
+		SharedDirtyRegion(SharedDirtyRegion&&) = delete;
+		SharedDirtyRegion& operator=(const SharedDirtyRegion&) = delete;
+		SharedDirtyRegion& operator=(SharedDirtyRegion&&) = delete;
+
+	private:
+		DirtyRegion myRegion{};
+		std::mutex myGuard{};
+	};
+
+	[[nodiscard]] bool IsEmpty(const Rect& rect) noexcept;
+	[[nodiscard]] long long GetArea(const Rect& rect) noexcept;
+	[[nodiscard]] Rect GetUnion(const Rect& lhs, const Rect& rhs) noexcept;
+	/// <returns>An empty rectangle when they do not overlap</returns>
+	[[nodiscard]] Rect GetIntersection(const Rect& lhs, const Rect& rhs) noexcept;
+	[[nodiscard]] bool Contains(const Rect& outer, const Rect& inner) noexcept;
+}
@@ -87,6 +87,11 @@ export namespace gl::win32
 		MouseLast = WM_MOUSELAST,
 
 		ChangedCapture = WM_CAPTURECHANGED,
+
+		RawInput = WM_INPUT, // Must reach DefWindowProc to free the report
+		PointerDown = WM_POINTERDOWN,
+		PointerUpdate = WM_POINTERUPDATE,
+		PointerUp = WM_POINTERUP,
 	};
 
 	/// <summary>
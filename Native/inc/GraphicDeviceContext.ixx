@@ -1,5 +1,6 @@
 export module Glib.Windows.Context.Renderer;
 import <type_traits>;
+import Glib.Rect;
 import Glib.Windows.Definitions;
 export import Glib.Windows.IContext;
 
@@ -15,6 +16,10 @@ export namespace gl::win32
 
 		[[nodiscard]] native::PaintStruct& GetPaintStruct() noexcept;
 		[[nodiscard]] const native::PaintStruct& GetPaintStruct() const noexcept;
+		/// <summary>
+		/// The area the system asked to paint, in client coordinates
+		/// </summary>
+		[[nodiscard]] Rect GetPaintRect() const noexcept;
 
 		GraphicDeviceContext(const GraphicDeviceContext&) = delete;
 		GraphicDeviceContext(GraphicDeviceContext&&) = delete;
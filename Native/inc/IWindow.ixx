@@ -97,6 +97,10 @@ export namespace gl::win32
 
 		[[nodiscard]] Rect GetDimensions() const noexcept;
 		bool TryGetDimensions(Rect& output) const noexcept;
+		/// <summary>
+		/// The client area, from the origin of the client area
+		/// </summary>
+		[[nodiscard]] Rect GetClientDimensions() const noexcept;
 
 		[[nodiscard]] bool IsMinimized() const noexcept;
 		[[nodiscard]] bool IsMaximized() const noexcept;
@@ -11,6 +11,8 @@ import Utility.Atomic;
 import Utility.Monad;
 import Utility.Concurrency.Thread;
 import Glib.Rect;
+import Glib.DirtyRegion;
+import Glib.PointerSamples;
 import Glib.Windows.Definitions;
 import Glib.Windows.IO;
 export import Glib.Windows.Event;
@@ -79,6 +81,17 @@ namespace gl::win32
 
 		void SetPowerSave(const bool& flag) noexcept;
 		void SetCaptureMouse(const bool& flag = true) noexcept;
+		/// <summary>
+		/// Record every report of the mice and every coalesced sample of the pens, as they arrive
+		/// <para>Only on the main thread</para>
+		/// </summary>
+		/// <param name="background">Keep recording the mice while the window is not in the foreground</param>
+		bool SetRawInput(const bool& flag, const bool& background = false) noexcept;
+		/// <summary>
+		/// Append the samples recorded since the last drain, from the oldest
+		/// <para>Only on one thread at once, usually the one of the frame</para>
+		/// </summary>
+		std::size_t DrainPointerSamples(std::vector<PointerSample>& output);
 
 		void AddEventHandler(event_id_t id, const event_handler_t& procedure) noexcept;
 		void AddEventHandler(event_id_t id, event_handler_t&& procedure) noexcept;
@@ -94,8 +107,18 @@ namespace gl::win32
 		CharUpEventHandler SetCharUpHandler(CharUpEventHandler handler) noexcept;
 		void StartCoroutine(coro_t&& coroutine) noexcept;
 
-		bool ClearWindow(const Rect& rect) noexcept;
-		bool ClearWindow() noexcept;
+		/// <summary>
+		/// Invalidate a rectangle of the client area, merged with the others into the dirty region of the next paint
+		/// </summary>
+		bool ClearWindow(const Rect& rect);
+		/// <summary>
+		/// Invalidate the whole client area
+		/// </summary>
+		bool ClearWindow();
+		/// <summary>
+		/// The rectangles the current paint redraws, only valid inside the renderer
+		/// </summary>
+		[[nodiscard]] const DirtyRegion& GetFrameRegion() const noexcept;
 
 		[[nodiscard]] std::exception_ptr GetException() const noexcept;
 
@@ -118,6 +141,7 @@ namespace gl::win32
 		[[nodiscard]]
 		bool IsMouseCaptured() const noexcept;
 		void ResumeTopCoroutine() noexcept;
+		void BeginFrameRegion(const Rect& paint_rect);
 
 		static void KeyboardHandler(ManagedWindow&, unsigned long long, long long) noexcept;
 		static void CharKeyHandler(ManagedWindow&, unsigned long long, long long) noexcept;
@@ -126,6 +150,14 @@ namespace gl::win32
 		Window underlying;
 		Rect myDimensions{};
 
+		// Invalidated by the workers, taken by the paint on the main thread
+		SharedDirtyRegion myDirtyRegion{};
+		DirtyRegion myFrameRegion{};
+
+		// Pushed by the main thread, drained by the frame
+		SampleRing myPointerSamples{};
+		RawMouseDecoder myRawMouse{};
+
 		// flat map
 		event_storage_t myEventHandlers{};
 		static inline constexpr Event DefaultEvent = {};
@@ -153,6 +185,7 @@ namespace gl::win32
 		util::atomic_bool isCapturing = false;
 		util::atomic_bool isRenderingNow = false;
 		util::atomic_bool noPowerSaves = false;
+		util::atomic_bool isRawInput = false;
 
 		std::unique_ptr<coro_storage> myCoroutines{};
 
@@ -1,3 +1,4 @@
 export module Glib.Windows.IO.Mouse;
 export import :Buttons;
 export import :Utils;
+export import :RawInput;
@@ -0,0 +1,253 @@
+module;
+#include "Internal.hpp"
+export module Glib.Windows.IO.Mouse:RawInput;
+import <cstdint>;
+import <algorithm>;
+import <vector>;
+export import Glib.PointerSamples;
+
+namespace gl::win32::io
+{
+	[[nodiscard]]
+	long long ToMicroseconds(const long long& ticks) noexcept
+	{
+		static const long long frequency = [] {
+			::LARGE_INTEGER result{};
+			::QueryPerformanceFrequency(&result);
+			return result.QuadPart;
+		}();
+
+		// Split to not overflow the multiplication after some days of uptime
+		return ticks / frequency * 1'000'000 + ticks % frequency * 1'000'000 / frequency;
+	}
+
+	bool ReadReport(const ::RAWINPUT& input, RawMouseReport& output) noexcept
+	{
+		if (RIM_TYPEMOUSE != input.header.dwType)
+		{
+			return false;
+		}
+
+		const ::RAWMOUSE& mouse = input.data.mouse;
+		const unsigned short flags = mouse.usButtonFlags;
+
+		constexpr struct { unsigned short down, up; std::uint16_t button; } transitions[] =
+		{
+			{ RI_MOUSE_LEFT_BUTTON_DOWN, RI_MOUSE_LEFT_BUTTON_UP, pointer_buttons::Left },
+			{ RI_MOUSE_RIGHT_BUTTON_DOWN, RI_MOUSE_RIGHT_BUTTON_UP, pointer_buttons::Right },
+			{ RI_MOUSE_MIDDLE_BUTTON_DOWN, RI_MOUSE_MIDDLE_BUTTON_UP, pointer_buttons::Middle },
+			{ RI_MOUSE_BUTTON_4_DOWN, RI_MOUSE_BUTTON_4_UP, pointer_buttons::X1 },
+			{ RI_MOUSE_BUTTON_5_DOWN, RI_MOUSE_BUTTON_5_UP, pointer_buttons::X2 },
+		};
+
+		output = RawMouseReport{};
+
+		for (const auto& transition : transitions)
+		{
+			if (flags & transition.down)
+			{
+				output.pressed |= transition.button;
+			}
+			if (flags & transition.up)
+			{
+				output.released |= transition.button;
+			}
+		}
+
+		output.x = static_cast<int>(mouse.lLastX);
+		output.y = static_cast<int>(mouse.lLastY);
+		output.isAbsolute = 0 != (mouse.usFlags & MOUSE_MOVE_ABSOLUTE);
+
+		if (flags & RI_MOUSE_WHEEL)
+		{
+			output.wheel = static_cast<short>(mouse.usButtonData);
+		}
+		if (flags & RI_MOUSE_HWHEEL)
+		{
+			output.hwheel = static_cast<short>(mouse.usButtonData);
+		}
+
+		return true;
+	}
+}
+
+export namespace gl::win32::io
+{
+	/// <summary>
+	/// Microseconds of the performance counter, the clock of every pointer sample
+	/// </summary>
+	[[nodiscard]]
+	inline long long GetSampleTime() noexcept
+	{
+		::LARGE_INTEGER result{};
+		::QueryPerformanceCounter(&result);
+
+		return ToMicroseconds(result.QuadPart);
+	}
+
+	/// <summary>
+	/// Send every report of the mice to the window as WM_INPUT, beside the usual mouse messages
+	/// <para>Only on the main thread</para>
+	/// </summary>
+	/// <param name="background">Keep receiving while the window is not in the foreground</param>
+	bool RegisterRawMouse(const HWND& handle, const bool& background = false) noexcept
+	{
+		::RAWINPUTDEVICE device{};
+		device.usUsagePage = 0x01; // HID_USAGE_PAGE_GENERIC
+		device.usUsage = 0x02; // HID_USAGE_GENERIC_MOUSE
+		device.dwFlags = background ? RIDEV_INPUTSINK : 0;
+		device.hwndTarget = handle;
+
+		return FALSE != ::RegisterRawInputDevices(&device, 1, sizeof(device));
+	}
+
+	/// <summary>
+	/// Only on the main thread
+	/// </summary>
+	bool UnregisterRawMouse() noexcept
+	{
+		::RAWINPUTDEVICE device{};
+		device.usUsagePage = 0x01;
+		device.usUsage = 0x02;
+		device.dwFlags = RIDEV_REMOVE;
+		device.hwndTarget = nullptr;
+
+		return FALSE != ::RegisterRawInputDevices(&device, 1, sizeof(device));
+	}
+
+	/// <summary>
+	/// Read the report of a WM_INPUT, then every report still queued behind it, and push them through the decoder
+	/// <para>Only on the main thread, the window procedure still has to pass the message to DefWindowProc.</para>
+	/// </summary>
+	/// <returns>The number of samples pushed</returns>
+	std::size_t ReadRawMouse(const long long& lparam, RawMouseDecoder& decoder, SampleRing& ring) noexcept
+	{
+		const long long time = GetSampleTime();
+
+		static thread_local std::vector<RawMouseReport> reports{};
+		reports.clear();
+
+		RawMouseReport report{};
+
+		try
+		{
+			::RAWINPUT input{};
+			unsigned int size = sizeof(input);
+			if (static_cast<unsigned int>(-1) != ::GetRawInputData(reinterpret_cast<::HRAWINPUT>(lparam), RID_INPUT, &input, &size, sizeof(::RAWINPUTHEADER)))
+			{
+				if (ReadReport(input, report))
+				{
+					reports.push_back(report);
+				}
+			}
+
+			// A mouse polling faster than the frame queues many reports, reading them in batches saves a message for each
+			::RAWINPUT batch[32]{};
+
+			while (true)
+			{
+				unsigned int batch_size = sizeof(batch);
+				const unsigned int count = ::GetRawInputBuffer(batch, &batch_size, sizeof(::RAWINPUTHEADER));
+				if (0 == count || static_cast<unsigned int>(-1) == count)
+				{
+					break;
+				}
+
+				const ::RAWINPUT* it = batch;
+				for (unsigned int i = 0; i < count; ++i)
+				{
+					if (ReadReport(*it, report))
+					{
+						reports.push_back(report);
+					}
+
+					it = NEXTRAWINPUTBLOCK(it);
+				}
+			}
+		}
+		catch (...)
+		{
+			// Out of memory, the reports read so far are still pushed
+		}
+
+		return decoder.Push(reports, time, ring);
+	}
+
+	/// <summary>
+	/// Read every pen sample coalesced into a WM_POINTERUPDATE, WM_POINTERDOWN or WM_POINTERUP, from the oldest
+	/// <para>Only on the main thread, other kinds of pointer are ignored.</para>
+	/// </summary>
+	/// <returns>The number of samples pushed</returns>
+	std::size_t ReadPenHistory(const HWND& handle, const unsigned long long& wparam, SampleRing& ring) noexcept
+	{
+		const unsigned int id = GET_POINTERID_WPARAM(wparam);
+
+		::POINTER_INPUT_TYPE type{};
+		if (FALSE == ::GetPointerType(id, &type) || PT_PEN != type)
+		{
+			return 0;
+		}
+
+		::POINTER_PEN_INFO latest{};
+		if (FALSE == ::GetPointerPenInfo(id, &latest))
+		{
+			return 0;
+		}
+
+		static thread_local std::vector<::POINTER_PEN_INFO> history{};
+
+		unsigned int count = std::max(1U, static_cast<unsigned int>(latest.pointerInfo.historyCount));
+		try
+		{
+			history.resize(count);
+		}
+		catch (...)
+		{
+			return 0;
+		}
+
+		if (FALSE == ::GetPointerPenInfoHistory(id, &count, history.data()))
+		{
+			return 0;
+		}
+
+		const long long now = GetSampleTime();
+		std::size_t result = 0;
+
+		// The history starts from the latest
+		for (unsigned int i = count; 0 < i; --i)
+		{
+			const ::POINTER_PEN_INFO& info = history[i - 1];
+			const ::POINTER_INFO& pointer = info.pointerInfo;
+
+			::POINT position = pointer.ptPixelLocation;
+			::ScreenToClient(handle, &position);
+
+			PointerSample sample{};
+			sample.time = 0 != pointer.PerformanceCount ? ToMicroseconds(static_cast<long long>(pointer.PerformanceCount)) : now;
+			sample.x = static_cast<float>(position.x);
+			sample.y = static_cast<float>(position.y);
+			sample.source = PointerSource::Pen;
+			sample.isAbsolute = true;
+
+			if (pointer.pointerFlags & POINTER_FLAG_INCONTACT)
+			{
+				sample.buttons |= pointer_buttons::Contact;
+				// Pens without the pressure are on or off
+				sample.pressure = (info.penMask & PEN_MASK_PRESSURE) ? static_cast<float>(info.pressure) / 1024.0f : 1.0f;
+			}
+			if (info.penFlags & PEN_FLAG_BARREL)
+			{
+				sample.buttons |= pointer_buttons::Barrel;
+			}
+			if (info.penFlags & PEN_FLAG_ERASER)
+			{
+				sample.buttons |= pointer_buttons::Eraser;
+			}
+
+			result += ring.Push(sample);
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,82 @@
+export module Glib.Windows.Resource.PixelSurface;
+import <cstdint>;
+import <span>;
+import Glib.Rect;
+import Glib.DirtyRegion;
+import Glib.Windows.Definitions;
+import Glib.Windows.IContext;
+import Glib.Windows.Colour;
+
+export namespace gl::win32::resource
+{
+	/// <summary>
+	/// A pixel of a 32-bit DIB, in the blue, green, red order of the memory
+	/// </summary>
+	struct [[nodiscard]] SurfacePixel
+	{
+		std::uint8_t B, G, R, A;
+	};
+
+	/// <summary>
+	/// A top-down 32-bit DIB section selected into its own memory context for as long as it lives
+	/// <para>The pixels are written in place through GetPixels(), and the rectangles marked dirty are presented to a window with one blit each.</para>
+	/// <para>Call Flush() before touching the pixels after GDI drew into GetContext().</para>
+	/// </summary>
+	class [[nodiscard]] PixelSurface
+	{
+	public:
+		PixelSurface() noexcept = default;
+		~PixelSurface() noexcept;
+
+		bool Create(const int& width, const int& height);
+		/// <summary>
+		/// Create the surface again at another size, the pixels are lost and the whole surface is dirty
+		/// </summary>
+		bool Resize(const int& width, const int& height);
+		void Destroy() noexcept;
+
+		void Fill(const Colour& color);
+		void Fill(const Rect& rect, const Colour& color);
+		void SetPixel(const int& x, const int& y, const Colour& color);
+		[[nodiscard]] Colour GetPixel(const int& x, const int& y) const noexcept;
+
+		void MarkDirty(const Rect& rect);
+		void MarkDirty();
+		/// <summary>
+		/// Wait for the drawing of GDI into the memory context to reach the pixels
+		/// </summary>
+		void Flush() const noexcept;
+
+		/// <summary>
+		/// Copy the dirty rectangles to the context at an offset, then forget them
+		/// </summary>
+		bool Present(const IContext& destination, const int& x = 0, const int& y = 0);
+		bool Present(const IWindow& window, const int& x = 0, const int& y = 0);
+
+		[[nodiscard]] std::span<SurfacePixel> GetPixels() noexcept;
+		[[nodiscard]] std::span<const SurfacePixel> GetPixels() const noexcept;
+		[[nodiscard]] std::span<SurfacePixel> GetRow(const int& y) noexcept;
+		[[nodiscard]] std::span<const SurfacePixel> GetRow(const int& y) const noexcept;
+		[[nodiscard]] const DirtyRegion& GetDirtyRegion() const noexcept;
+		[[nodiscard]] const native::NativeContext& GetContext() const noexcept;
+		[[nodiscard]] const native::RawBitmap& GetBitmap() const noexcept;
+		[[nodiscard]] int GetWidth() const noexcept;
+		[[nodiscard]] int GetHeight() const noexcept;
+		[[nodiscard]] bool IsCreated() const noexcept;
+
+		PixelSurface(const PixelSurface&) = delete;
+		PixelSurface(PixelSurface&&) = delete;
+		PixelSurface& operator=(const PixelSurface&) = delete;
+		PixelSurface& operator=(PixelSurface&&) = delete;
+
+	private:
+		native::NativeContext myContext = nullptr;
+		native::RawBitmap myBitmap = nullptr;
+		// The bitmap the memory context was created with, put back before it is deleted
+		void* myPreviousBitmap = nullptr;
+		SurfacePixel* myPixels = nullptr;
+		int myWidth = 0, myHeight = 0;
+
+		DirtyRegion myDirtyRegion{};
+	};
+}
@@ -0,0 +1,178 @@
+export module Glib.PointerSamples;
+import <cstddef>;
+import <cstdint>;
+import <atomic>;
+import <memory>;
+import <vector>;
+import <span>;
+
+export namespace gl
+{
+	enum class [[nodiscard]] PointerSource : std::uint8_t
+	{
+		Mouse = 0,
+		Pen = 1,
+	};
+
+	/// <summary>
+	/// Bits of PointerSample::buttons
+	/// </summary>
+	namespace pointer_buttons
+	{
+		inline constexpr std::uint16_t Left = 1 << 0;
+		inline constexpr std::uint16_t Right = 1 << 1;
+		inline constexpr std::uint16_t Middle = 1 << 2;
+		inline constexpr std::uint16_t X1 = 1 << 3;
+		inline constexpr std::uint16_t X2 = 1 << 4;
+		inline constexpr std::uint16_t Contact = 1 << 5;
+		inline constexpr std::uint16_t Barrel = 1 << 6;
+		inline constexpr std::uint16_t Eraser = 1 << 7;
+	}
+
+	/// <summary>
+	/// One report of a pointing device, as it arrived and before any coalescing
+	/// <para>Relative samples carry the movement in device counts, absolute ones the position in client pixels.</para>
+	/// </summary>
+	struct [[nodiscard]] PointerSample
+	{
+		// Microseconds of the performance counter
+		long long time;
+		float x, y;
+		// From 0 to 1, always 1 for the mouse
+		float pressure;
+		// In the units of WHEEL_DELTA, 120 for a notch
+		short wheel, hwheel;
+		// The buttons held after the sample
+		std::uint16_t buttons;
+		PointerSource source;
+		bool isAbsolute;
+	};
+
+	struct [[nodiscard]] PointerMotion
+	{
+		float dx, dy;
+		int wheel, hwheel;
+		std::size_t count;
+	};
+
+	/// <summary>
+	/// A lock-free ring of samples for one producer and one consumer
+	/// <para>The window thread pushes every sample, the frame drains the whole history at once.</para>
+	/// <para>When the ring is full, the new samples are dropped and counted instead of overwriting the ones being read.</para>
+	/// </summary>
+	class [[nodiscard]] SampleRing
+	{
+	public:
+		// About two seconds of a mouse polling at 8000 Hz
+		static constexpr std::size_t DefaultCapacity = 1 << 14;
+
+		SampleRing();
+		/// <param name="capacity">Rounded up to a power of two</param>
+		explicit SampleRing(std::size_t capacity);
+		~SampleRing() noexcept = default;
+
+		/// <summary>
+		/// Only on the producer thread
+		/// </summary>
+		bool Push(const PointerSample& sample) noexcept;
+		/// <summary>
+		/// Append every sample pushed so far to the output, from the oldest
+		/// <para>Only on the consumer thread</para>
+		/// </summary>
+		std::size_t Drain(std::vector<PointerSample>& output);
+		/// <summary>
+		/// Move as many samples as the output holds, from the oldest
+		/// <para>Only on the consumer thread</para>
+		/// </summary>
+		std::size_t Drain(std::span<PointerSample> output) noexcept;
+		/// <summary>
+		/// Only on the consumer thread
+		/// </summary>
+		void Clear() noexcept;
+
+		/// <summary>
+		/// Samples lost to a full ring, reset on reading
+		/// </summary>
+		[[nodiscard]] std::size_t TakeDropped() noexcept;
+		[[nodiscard]] std::size_t GetSize() const noexcept;
+		[[nodiscard]] std::size_t GetCapacity() const noexcept;
+		[[nodiscard]] bool IsEmpty() const noexcept;
+
+		SampleRing(const SampleRing&) = delete;
+		SampleRing(SampleRing&&) = delete;
+		SampleRing& operator=(const SampleRing&) = delete;
+		SampleRing& operator=(SampleRing&&) = delete;
+
+	private:
+		std::unique_ptr<PointerSample[]> mySamples;
+		std::size_t myMask;
+
+		// Both only grow, the producer and the consumer sit on their own cache lines
+		alignas(64) std::atomic<std::size_t> myHead = 0;
+		alignas(64) std::atomic<std::size_t> myTail = 0;
+		alignas(64) std::atomic<std::size_t> myDropped = 0;
+	};
+
+	/// <summary>
+	/// One report of a mouse, read from the device before the system moves the cursor with it
+	/// </summary>
+	struct [[nodiscard]] RawMouseReport
+	{
+		// Device counts, unless absolute
+		int x, y;
+		// In the units of WHEEL_DELTA
+		short wheel, hwheel;
+		// Bits of pointer_buttons
+		std::uint16_t pressed, released;
+		// From remote sessions and tablets in the mouse mode
+		bool isAbsolute;
+	};
+
+	/// <summary>
+	/// Turns the reports of the mice into samples, holding the buttons between them
+	/// <para>The reports read at once only have the time of the read, so they are spread evenly over the interval since the previous read, the last at the time of the read.</para>
+	/// <para>The absolute reports turn into samples without motion when they turn a wheel or press or release a button, their positions reach the window with the pointer messages.</para>
+	/// </summary>
+	class [[nodiscard]] RawMouseDecoder
+	{
+	public:
+		// The slowest polling of a mouse, 125 Hz, so a batch after an idle time is not spread over all of it
+		static constexpr long long MaxReportInterval = 8000;
+
+		/// <summary>
+		/// Push the reports of a read, from the oldest
+		/// </summary>
+		/// <param name="time">Microseconds of the read</param>
+		/// <returns>The number of samples pushed</returns>
+		std::size_t Push(std::span<const RawMouseReport> reports, long long time, SampleRing& ring) noexcept;
+		/// <summary>
+		/// Release every button and forget the previous read
+		/// </summary>
+		void Reset() noexcept;
+
+		[[nodiscard]] std::uint16_t GetButtons() const noexcept;
+
+	private:
+		long long myLastTime = 0;
+		bool hasLastTime = false;
+		std::uint16_t myButtons = 0;
+	};
+
+	/// <summary>
+	/// The position at a time, linear between the absolute samples around it
+	/// <para>The history is in the order of time, the relative samples in it are skipped.</para>
+	/// </summary>
+	/// <returns>The nearest sample out of the history, or an empty one if it has no absolute sample</returns>
+	[[nodiscard]]
+	PointerSample Interpolate(std::span<const PointerSample> history, long long time) noexcept;
+	/// <summary>
+	/// Sum the movement and the wheel of the relative samples from the begin until the end, excluding it
+	/// </summary>
+	[[nodiscard]]
+	PointerMotion Accumulate(std::span<const PointerSample> history, long long begin, long long end) noexcept;
+	/// <summary>
+	/// Interpolate the history at a fixed step from the start, one sample for each output
+	/// <para>For a simulation ticking at its own rate over a stroke drawn at the rate of the device.</para>
+	/// </summary>
+	std::size_t Resample(std::span<const PointerSample> history, long long start, long long step, std::span<PointerSample> output) noexcept;
+}
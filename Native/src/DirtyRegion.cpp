@@ -0,0 +1,237 @@
+module Glib.DirtyRegion;
+import <algorithm>;
+import <limits>;
+import <utility>;
+
+gl::DirtyRegion::DirtyRegion(std::size_t limit)
+noexcept
+	: myLimit(std::max<std::size_t>(1, limit))
+{}
+
+void
+gl::DirtyRegion::Add(const gl::Rect& rect)
+{
+	if (gl::IsEmpty(rect))
+	{
+		return;
+	}
+
+	Rect merged = rect;
+
+	for (std::size_t i = 0; i < myRects.size();)
+	{
+		const Rect& other = myRects[i];
+		const long long overlap = gl::GetArea(GetIntersection(merged, other));
+		const long long covered = gl::GetArea(merged) + gl::GetArea(other) - overlap;
+		const long long wasted = gl::GetArea(GetUnion(merged, other)) - covered;
+
+		// Overlapping rectangles are always merged, so none of them overlap
+		if (0 < overlap || wasted * 4 <= covered)
+		{
+			merged = GetUnion(merged, other);
+			myRects[i] = myRects.back();
+			myRects.pop_back();
+
+			// The grown rectangle may reach the ones already passed
+			i = 0;
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	myRects.push_back(merged);
+
+	if (myRects.size() <= myLimit)
+	{
+		return;
+	}
+
+	std::size_t first = 0, second = 1;
+	long long least = std::numeric_limits<long long>::max();
+
+	for (std::size_t i = 0; i < myRects.size(); ++i)
+	{
+		for (std::size_t j = i + 1; j < myRects.size(); ++j)
+		{
+			const long long wasted = gl::GetArea(GetUnion(myRects[i], myRects[j])) - gl::GetArea(myRects[i]) - gl::GetArea(myRects[j]);
+			if (wasted < least)
+			{
+				least = wasted;
+				first = i;
+				second = j;
+			}
+		}
+	}
+
+	const Rect joined = GetUnion(myRects[first], myRects[second]);
+	myRects.erase(myRects.begin() + static_cast<std::ptrdiff_t>(second));
+	myRects.erase(myRects.begin() + static_cast<std::ptrdiff_t>(first));
+
+	// The union may overlap the others, adding it merges them
+	Add(joined);
+}
+
+void
+gl::DirtyRegion::Clip(const gl::Rect& bounds)
+{
+	for (Rect& rect : myRects)
+	{
+		rect = GetIntersection(rect, bounds);
+	}
+
+	std::erase_if(myRects, [](const Rect& rect) noexcept {
+		return gl::IsEmpty(rect);
+	});
+}
+
+void
+gl::DirtyRegion::Clear()
+noexcept
+{
+	myRects.clear();
+}
+
+std::span<const gl::Rect>
+gl::DirtyRegion::GetRects()
+const noexcept
+{
+	return myRects;
+}
+
+gl::Rect
+gl::DirtyRegion::GetBounds()
+const noexcept
+{
+	Rect result{};
+
+	for (const Rect& rect : myRects)
+	{
+		result = GetUnion(result, rect);
+	}
+
+	return result;
+}
+
+long long
+gl::DirtyRegion::GetArea()
+const noexcept
+{
+	long long result = 0;
+
+	for (const Rect& rect : myRects)
+	{
+		result += gl::GetArea(rect);
+	}
+
+	return result;
+}
+
+std::size_t
+gl::DirtyRegion::GetLimit()
+const noexcept
+{
+	return myLimit;
+}
+
+bool
+gl::DirtyRegion::IsEmpty()
+const noexcept
+{
+	return myRects.empty();
+}
+
+void
+gl::SharedDirtyRegion::Add(const gl::Rect& rect)
+{
+	std::lock_guard guard{ myGuard };
+
+	myRegion.Add(rect);
+}
+
+void
+gl::SharedDirtyRegion::Reset(const gl::Rect& rect)
+{
+	std::lock_guard guard{ myGuard };
+
+	myRegion.Clear();
+	myRegion.Add(rect);
+}
+
+void
+gl::SharedDirtyRegion::Take(const gl::Rect& paint_rect, const gl::Rect& bounds, gl::DirtyRegion& output)
+{
+	std::lock_guard guard{ myGuard };
+
+	if (not gl::Contains(myRegion.GetBounds(), paint_rect))
+	{
+		myRegion.Add(paint_rect);
+	}
+
+	myRegion.Clip(bounds);
+
+	std::swap(output, myRegion);
+	myRegion.Clear();
+}
+
+bool
+gl::IsEmpty(const gl::Rect& rect)
+noexcept
+{
+	return rect.w <= 0 || rect.h <= 0;
+}
+
+long long
+gl::GetArea(const gl::Rect& rect)
+noexcept
+{
+	return IsEmpty(rect) ? 0 : static_cast<long long>(rect.w) * rect.h;
+}
+
+gl::Rect
+gl::GetUnion(const gl::Rect& lhs, const gl::Rect& rhs)
+noexcept
+{
+	if (IsEmpty(lhs))
+	{
+		return rhs;
+	}
+	else if (IsEmpty(rhs))
+	{
+		return lhs;
+	}
+
+	const int left = std::min(lhs.x, rhs.x);
+	const int top = std::min(lhs.y, rhs.y);
+	const int right = std::max(lhs.x + lhs.w, rhs.x + rhs.w);
+	const int bottom = std::max(lhs.y + lhs.h, rhs.y + rhs.h);
+
+	return Rect{ left, top, right - left, bottom - top };
+}
+
+gl::Rect
+gl::GetIntersection(const gl::Rect& lhs, const gl::Rect& rhs)
+noexcept
+{
+	const int left = std::max(lhs.x, rhs.x);
+	const int top = std::max(lhs.y, rhs.y);
+	const int right = std::min(lhs.x + lhs.w, rhs.x + rhs.w);
+	const int bottom = std::min(lhs.y + lhs.h, rhs.y + rhs.h);
+
+	if (right <= left || bottom <= top)
+	{
+		return Rect{};
+	}
+
+	return Rect{ left, top, right - left, bottom - top };
+}
+
+bool
+gl::Contains(const gl::Rect& outer, const gl::Rect& inner)
+noexcept
+{
+	return outer.x <= inner.x && outer.y <= inner.y
+		&& inner.x + inner.w <= outer.x + outer.w
+		&& inner.y + inner.h <= outer.y + outer.h;
+}
@@ -28,3 +28,18 @@ const noexcept
 {
 	return myStatus;
 }
+
+gl::Rect
+gl::win32::GraphicDeviceContext::GetPaintRect()
+const noexcept
+{
+	const native::NativeRect& rect = myStatus.rcPaint;
+
+	return gl::Rect
+	{
+		rect.left,
+		rect.top,
+		rect.right - rect.left,
+		rect.bottom - rect.top
+	};
+}
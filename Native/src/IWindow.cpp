@@ -336,6 +336,22 @@ const noexcept
 	return result;
 }
 
+gl::Rect
+gl::win32::IWindow::GetClientDimensions()
+const noexcept
+{
+	native::NativeRect rect{};
+	Delegate(::GetClientRect, &rect);
+
+	return gl::Rect
+	{
+		rect.left,
+		rect.top,
+		rect.right - rect.left,
+		rect.bottom - rect.top
+	};
+}
+
 gl::win32::IWindow
 gl::win32::MakeNativeWindow(const ProcessInstance& hinst
 	, const std::wstring_view& class_name
@@ -114,6 +114,7 @@ noexcept
 
 			self->isRenderingNow.store(true, util::memory_order_relaxed);
 			GraphicDeviceContext render_ctx = control.AcquireRenderContext();
+			self->BeginFrameRegion(render_ctx.GetPaintRect());
 
 			if (auto& renderer = self->onRender; renderer)
 			{
@@ -272,6 +273,27 @@ noexcept
 			return control.DefaultWndProc(id, wparam, lparam);
 		}
 
+		case event_id_t::RawInput:
+		{
+			if (self && self->isRawInput)
+			{
+				io::ReadRawMouse(lparam, self->myRawMouse, self->myPointerSamples);
+			}
+
+			return control.DefaultWndProc(id, wparam, lparam);
+		}
+
+		case event_id_t::PointerDown:
+		case event_id_t::PointerUpdate:
+		case event_id_t::PointerUp:
+		{
+			if (self && self->isRawInput)
+			{
+				io::ReadPenHistory(control.GetHandle(), wparam, self->myPointerSamples);
+			}
+		}
+		[[fallthrough]];
+
 		default:
 		{
 			if (self)
@@ -502,6 +524,34 @@ noexcept
 	isCapturing = flag;
 }
 
+bool
+gl::win32::ManagedWindow::SetRawInput(const bool& flag, const bool& background)
+noexcept
+{
+	if (flag)
+	{
+		if (not io::RegisterRawMouse(underlying.GetHandle(), background))
+		{
+			return false;
+		}
+	}
+	else if (isRawInput)
+	{
+		io::UnregisterRawMouse();
+	}
+
+	myRawMouse.Reset();
+	isRawInput = flag;
+
+	return true;
+}
+
+std::size_t
+gl::win32::ManagedWindow::DrainPointerSamples(std::vector<gl::PointerSample>& output)
+{
+	return myPointerSamples.Drain(output);
+}
+
 bool
 gl::win32::ManagedWindow::TryCaptureMouse()
 noexcept
@@ -551,24 +601,37 @@ noexcept
 
 bool
 gl::win32::ManagedWindow::ClearWindow(const gl::Rect& rect)
-noexcept
 {
+	myDirtyRegion.Add(rect);
+
 	return underlying.Clear(rect);
 }
 
 bool
 gl::win32::ManagedWindow::ClearWindow()
-noexcept
 {
+	myDirtyRegion.Reset(underlying.GetClientDimensions());
+
 	return underlying.Clear();
 }
 
+const gl::DirtyRegion&
+gl::win32::ManagedWindow::GetFrameRegion()
+const noexcept
+{
+	return myFrameRegion;
+}
+
+void
+gl::win32::ManagedWindow::BeginFrameRegion(const gl::Rect& paint_rect)
+{
+	myDirtyRegion.Take(paint_rect, underlying.GetClientDimensions(), myFrameRegion);
+}
+
 void
 gl::win32::ManagedWindow::KeyboardHandler(gl::win32::ManagedWindow& self, unsigned long long wparam, long long lparam)
 noexcept
 {
-	self.ClearWindow();
-
 	const bool is_press = io::IsPressing(lparam);
 	const bool is_first = io::IsFirstPress(lparam);
 	const bool is_sys = io::IsWithAltKey(lparam);
@@ -0,0 +1,302 @@
+module;
+#include "Internal.hpp"
+
+module Glib.Windows.Resource.PixelSurface;
+import <cstdint>;
+import <algorithm>;
+import Glib.Windows.IWindow;
+import Glib.Windows.Context;
+
+namespace
+{
+	[[nodiscard]]
+	constexpr gl::win32::resource::SurfacePixel
+		MakePixel(const gl::win32::Colour& color)
+		noexcept
+	{
+		return gl::win32::resource::SurfacePixel{ color.B, color.G, color.R, color.A };
+	}
+}
+
+gl::win32::resource::PixelSurface::~PixelSurface()
+noexcept
+{
+	Destroy();
+}
+
+bool
+gl::win32::resource::PixelSurface::Create(const int& width, const int& height)
+{
+	if (IsCreated() || width <= 0 || height <= 0)
+	{
+		return false;
+	}
+
+	::BITMAPINFO info{};
+	info.bmiHeader.biSize = sizeof(::BITMAPINFOHEADER);
+	info.bmiHeader.biWidth = width;
+	// Negative for the rows to go from the top down
+	info.bmiHeader.biHeight = -height;
+	info.bmiHeader.biPlanes = 1;
+	info.bmiHeader.biBitCount = 32;
+	info.bmiHeader.biCompression = BI_RGB;
+
+	myContext = ::CreateCompatibleDC(nullptr);
+	if (nullptr == myContext)
+	{
+		return false;
+	}
+
+	void* bits = nullptr;
+	myBitmap = ::CreateDIBSection(myContext, &info, DIB_RGB_COLORS, &bits, nullptr, 0);
+	if (nullptr == myBitmap || nullptr == bits)
+	{
+		Destroy();
+		return false;
+	}
+
+	myPreviousBitmap = ::SelectObject(myContext, myBitmap);
+	myPixels = static_cast<SurfacePixel*>(bits);
+	myWidth = width;
+	myHeight = height;
+
+	myDirtyRegion.Clear();
+	MarkDirty();
+
+	return true;
+}
+
+bool
+gl::win32::resource::PixelSurface::Resize(const int& width, const int& height)
+{
+	if (IsCreated() && width == myWidth && height == myHeight)
+	{
+		return true;
+	}
+
+	Destroy();
+
+	return Create(width, height);
+}
+
+void
+gl::win32::resource::PixelSurface::Destroy()
+noexcept
+{
+	if (nullptr != myContext)
+	{
+		if (nullptr != myPreviousBitmap)
+		{
+			::SelectObject(myContext, myPreviousBitmap);
+			myPreviousBitmap = nullptr;
+		}
+
+		::DeleteDC(myContext);
+		myContext = nullptr;
+	}
+
+	if (nullptr != myBitmap)
+	{
+		::DeleteObject(myBitmap);
+		myBitmap = nullptr;
+	}
+
+	myPixels = nullptr;
+	myWidth = 0;
+	myHeight = 0;
+	myDirtyRegion.Clear();
+}
+
+void
+gl::win32::resource::PixelSurface::Fill(const gl::win32::Colour& color)
+{
+	if (not IsCreated())
+	{
+		return;
+	}
+
+	const std::span<SurfacePixel> pixels = GetPixels();
+	std::fill(pixels.begin(), pixels.end(), MakePixel(color));
+
+	MarkDirty();
+}
+
+void
+gl::win32::resource::PixelSurface::Fill(const gl::Rect& rect, const gl::win32::Colour& color)
+{
+	const Rect area = GetIntersection(rect, Rect{ 0, 0, myWidth, myHeight });
+	if (gl::IsEmpty(area))
+	{
+		return;
+	}
+
+	const SurfacePixel pixel = MakePixel(color);
+
+	for (int y = area.y; y < area.y + area.h; ++y)
+	{
+		const std::span<SurfacePixel> row = GetRow(y).subspan(static_cast<std::size_t>(area.x), static_cast<std::size_t>(area.w));
+		std::fill(row.begin(), row.end(), pixel);
+	}
+
+	MarkDirty(area);
+}
+
+void
+gl::win32::resource::PixelSurface::SetPixel(const int& x, const int& y, const gl::win32::Colour& color)
+{
+	if (x < 0 || y < 0 || myWidth <= x || myHeight <= y)
+	{
+		return;
+	}
+
+	myPixels[static_cast<std::size_t>(y) * myWidth + x] = MakePixel(color);
+
+	MarkDirty(Rect{ x, y, 1, 1 });
+}
+
+gl::win32::Colour
+gl::win32::resource::PixelSurface::GetPixel(const int& x, const int& y)
+const noexcept
+{
+	if (x < 0 || y < 0 || myWidth <= x || myHeight <= y)
+	{
+		return Colour{};
+	}
+
+	const SurfacePixel& pixel = myPixels[static_cast<std::size_t>(y) * myWidth + x];
+
+	return MakeColor(pixel.R, pixel.G, pixel.B, pixel.A);
+}
+
+void
+gl::win32::resource::PixelSurface::MarkDirty(const gl::Rect& rect)
+{
+	myDirtyRegion.Add(GetIntersection(rect, Rect{ 0, 0, myWidth, myHeight }));
+}
+
+void
+gl::win32::resource::PixelSurface::MarkDirty()
+{
+	myDirtyRegion.Clear();
+	myDirtyRegion.Add(Rect{ 0, 0, myWidth, myHeight });
+}
+
+void
+gl::win32::resource::PixelSurface::Flush()
+const noexcept
+{
+	::GdiFlush();
+}
+
+bool
+gl::win32::resource::PixelSurface::Present(const gl::win32::IContext& destination, const int& x, const int& y)
+{
+	if (not IsCreated())
+	{
+		return false;
+	}
+
+	// The pixels written by the CPU are read by GDI, anything GDI still has queued has to land first
+	::GdiFlush();
+
+	bool result = true;
+
+	for (const Rect& rect : myDirtyRegion.GetRects())
+	{
+		result &= (0 != ::BitBlt(destination
+			, x + rect.x, y + rect.y, rect.w, rect.h
+			, myContext, rect.x, rect.y
+			, SRCCOPY));
+	}
+
+	myDirtyRegion.Clear();
+
+	return result;
+}
+
+bool
+gl::win32::resource::PixelSurface::Present(const gl::win32::IWindow& window, const int& x, const int& y)
+{
+	if (myDirtyRegion.IsEmpty())
+	{
+		return true;
+	}
+
+	DeviceContext window_context = window.AcquireContext();
+	if (nullptr == window_context)
+	{
+		return false;
+	}
+
+	return Present(window_context, x, y);
+}
+
+std::span<gl::win32::resource::SurfacePixel>
+gl::win32::resource::PixelSurface::GetPixels()
+noexcept
+{
+	return std::span<SurfacePixel>{ myPixels, static_cast<std::size_t>(myWidth) * myHeight };
+}
+
+std::span<const gl::win32::resource::SurfacePixel>
+gl::win32::resource::PixelSurface::GetPixels()
+const noexcept
+{
+	return std::span<const SurfacePixel>{ myPixels, static_cast<std::size_t>(myWidth) * myHeight };
+}
+
+std::span<gl::win32::resource::SurfacePixel>
+gl::win32::resource::PixelSurface::GetRow(const int& y)
+noexcept
+{
+	return GetPixels().subspan(static_cast<std::size_t>(y) * myWidth, static_cast<std::size_t>(myWidth));
+}
+
+std::span<const gl::win32::resource::SurfacePixel>
+gl::win32::resource::PixelSurface::GetRow(const int& y)
+const noexcept
+{
+	return GetPixels().subspan(static_cast<std::size_t>(y) * myWidth, static_cast<std::size_t>(myWidth));
+}
+
+const gl::DirtyRegion&
+gl::win32::resource::PixelSurface::GetDirtyRegion()
+const noexcept
+{
+	return myDirtyRegion;
+}
+
+const gl::win32::native::NativeContext&
+gl::win32::resource::PixelSurface::GetContext()
+const noexcept
+{
+	return myContext;
+}
+
+const gl::win32::native::RawBitmap&
+gl::win32::resource::PixelSurface::GetBitmap()
+const noexcept
+{
+	return myBitmap;
+}
+
+int
+gl::win32::resource::PixelSurface::GetWidth()
+const noexcept
+{
+	return myWidth;
+}
+
+int
+gl::win32::resource::PixelSurface::GetHeight()
+const noexcept
+{
+	return myHeight;
+}
+
+bool
+gl::win32::resource::PixelSurface::IsCreated()
+const noexcept
+{
+	return nullptr != myPixels;
+}
@@ -0,0 +1,329 @@
+module Glib.PointerSamples;
+import <algorithm>;
+import <bit>;
+
+namespace
+{
+	[[nodiscard]]
+	gl::PointerSample
+		Lerp(const gl::PointerSample& before, const gl::PointerSample& after, long long time)
+		noexcept
+	{
+		const float t = static_cast<float>(time - before.time) / static_cast<float>(after.time - before.time);
+
+		gl::PointerSample result = before;
+		result.time = time;
+		result.x += (after.x - before.x) * t;
+		result.y += (after.y - before.y) * t;
+		result.pressure += (after.pressure - before.pressure) * t;
+		// Wheels are events, not states
+		result.wheel = 0;
+		result.hwheel = 0;
+
+		return result;
+	}
+}
+
+gl::SampleRing::SampleRing()
+	: SampleRing(DefaultCapacity)
+{}
+
+gl::SampleRing::SampleRing(std::size_t capacity)
+	: mySamples(std::make_unique<PointerSample[]>(std::bit_ceil(std::max<std::size_t>(2, capacity))))
+	, myMask(std::bit_ceil(std::max<std::size_t>(2, capacity)) - 1)
+{}
+
+bool
+gl::SampleRing::Push(const gl::PointerSample& sample)
+noexcept
+{
+	const std::size_t head = myHead.load(std::memory_order_relaxed);
+	const std::size_t tail = myTail.load(std::memory_order_acquire);
+
+	if (myMask < head - tail)
+	{
+		myDropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	mySamples[head & myMask] = sample;
+	myHead.store(head + 1, std::memory_order_release);
+
+	return true;
+}
+
+std::size_t
+gl::SampleRing::Drain(std::vector<gl::PointerSample>& output)
+{
+	const std::size_t tail = myTail.load(std::memory_order_relaxed);
+	const std::size_t head = myHead.load(std::memory_order_acquire);
+	const std::size_t count = head - tail;
+
+	if (0 == count)
+	{
+		return 0;
+	}
+
+	output.reserve(output.size() + count);
+
+	// At most two runs, before and after the end of the storage
+	const std::size_t first = tail & myMask;
+	const std::size_t first_count = std::min(count, GetCapacity() - first);
+
+	output.insert(output.end(), mySamples.get() + first, mySamples.get() + first + first_count);
+	output.insert(output.end(), mySamples.get(), mySamples.get() + (count - first_count));
+
+	myTail.store(head, std::memory_order_release);
+
+	return count;
+}
+
+std::size_t
+gl::SampleRing::Drain(std::span<gl::PointerSample> output)
+noexcept
+{
+	const std::size_t tail = myTail.load(std::memory_order_relaxed);
+	const std::size_t head = myHead.load(std::memory_order_acquire);
+	const std::size_t count = std::min(head - tail, output.size());
+
+	if (0 == count)
+	{
+		return 0;
+	}
+
+	const std::size_t first = tail & myMask;
+	const std::size_t first_count = std::min(count, GetCapacity() - first);
+
+	std::copy_n(mySamples.get() + first, first_count, output.begin());
+	std::copy_n(mySamples.get(), count - first_count, output.begin() + first_count);
+
+	myTail.store(tail + count, std::memory_order_release);
+
+	return count;
+}
+
+void
+gl::SampleRing::Clear()
+noexcept
+{
+	myTail.store(myHead.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+std::size_t
+gl::SampleRing::TakeDropped()
+noexcept
+{
+	return myDropped.exchange(0, std::memory_order_relaxed);
+}
+
+std::size_t
+gl::SampleRing::GetSize()
+const noexcept
+{
+	return myHead.load(std::memory_order_acquire) - myTail.load(std::memory_order_acquire);
+}
+
+std::size_t
+gl::SampleRing::GetCapacity()
+const noexcept
+{
+	return myMask + 1;
+}
+
+bool
+gl::SampleRing::IsEmpty()
+const noexcept
+{
+	return 0 == GetSize();
+}
+
+std::size_t
+gl::RawMouseDecoder::Push(std::span<const gl::RawMouseReport> reports, long long time, gl::SampleRing& ring)
+noexcept
+{
+	const long long count = static_cast<long long>(reports.size());
+	if (0 == count)
+	{
+		return 0;
+	}
+
+	// Without a previous read, the batch shares the time of this one
+	long long interval = 0;
+	if (hasLastTime && myLastTime < time)
+	{
+		interval = std::min(time - myLastTime, count * MaxReportInterval);
+	}
+
+	myLastTime = time;
+	hasLastTime = true;
+
+	std::size_t result = 0;
+
+	for (long long i = 0; i < count; ++i)
+	{
+		const RawMouseReport& report = reports[static_cast<std::size_t>(i)];
+
+		myButtons |= report.pressed;
+		myButtons &= ~report.released;
+
+		// The position of an absolute report is in the units of the whole desktop, only its wheels and buttons are kept
+		if (report.isAbsolute && 0 == report.wheel && 0 == report.hwheel && 0 == (report.pressed | report.released))
+		{
+			continue;
+		}
+
+		PointerSample sample{};
+		sample.time = time - interval * (count - 1 - i) / count;
+		sample.x = report.isAbsolute ? 0.0f : static_cast<float>(report.x);
+		sample.y = report.isAbsolute ? 0.0f : static_cast<float>(report.y);
+		sample.pressure = 1.0f;
+		sample.wheel = report.wheel;
+		sample.hwheel = report.hwheel;
+		sample.buttons = myButtons;
+		sample.source = PointerSource::Mouse;
+		sample.isAbsolute = false;
+
+		result += ring.Push(sample);
+	}
+
+	return result;
+}
+
+void
+gl::RawMouseDecoder::Reset()
+noexcept
+{
+	myLastTime = 0;
+	hasLastTime = false;
+	myButtons = 0;
+}
+
+std::uint16_t
+gl::RawMouseDecoder::GetButtons()
+const noexcept
+{
+	return myButtons;
+}
+
+gl::PointerSample
+gl::Interpolate(std::span<const gl::PointerSample> history, long long time)
+noexcept
+{
+	const PointerSample* before = nullptr;
+
+	for (const PointerSample& sample : history)
+	{
+		if (not sample.isAbsolute)
+		{
+			continue;
+		}
+
+		if (time < sample.time)
+		{
+			if (nullptr == before)
+			{
+				return sample;
+			}
+
+			return Lerp(*before, sample, time);
+		}
+
+		// The last of the samples sharing a time wins
+		before = &sample;
+	}
+
+	if (nullptr == before)
+	{
+		return PointerSample{};
+	}
+
+	return *before;
+}
+
+gl::PointerMotion
+gl::Accumulate(std::span<const gl::PointerSample> history, long long begin, long long end)
+noexcept
+{
+	PointerMotion result{};
+
+	for (const PointerSample& sample : history)
+	{
+		if (sample.isAbsolute || sample.time < begin || end <= sample.time)
+		{
+			continue;
+		}
+
+		result.dx += sample.x;
+		result.dy += sample.y;
+		result.wheel += sample.wheel;
+		result.hwheel += sample.hwheel;
+		++result.count;
+	}
+
+	return result;
+}
+
+std::size_t
+gl::Resample(std::span<const gl::PointerSample> history, long long start, long long step, std::span<gl::PointerSample> output)
+noexcept
+{
+	if (step <= 0)
+	{
+		return 0;
+	}
+
+	const PointerSample* before = nullptr;
+	const PointerSample* after = nullptr;
+	std::size_t cursor = 0;
+
+	// Both the history and the times go forward, so the samples around each time are found in one pass
+	const auto advance = [&](long long time) noexcept {
+		while (cursor < history.size())
+		{
+			const PointerSample& sample = history[cursor];
+			if (not sample.isAbsolute)
+			{
+				++cursor;
+				continue;
+			}
+
+			if (time < sample.time)
+			{
+				after = &sample;
+				return;
+			}
+
+			before = &sample;
+			++cursor;
+		}
+
+		after = nullptr;
+	};
+
+	long long time = start;
+	for (PointerSample& sample : output)
+	{
+		advance(time);
+
+		if (nullptr != before && nullptr != after)
+		{
+			sample = Lerp(*before, *after, time);
+		}
+		else if (nullptr != before || nullptr != after)
+		{
+			sample = nullptr != before ? *before : *after;
+			sample.time = time;
+			sample.wheel = 0;
+			sample.hwheel = 0;
+		}
+		else
+		{
+			// Not a single absolute sample
+			return 0;
+		}
+
+		time += step;
+	}
+
+	return output.size();
+}
@@ -1,14 +1,54 @@
 export module Glib:BufferLayout;
+import <cstdint>;
 import <vector>;
 import <tuple>;
 
+export namespace gl::vertex
+{
+	/// <summary>
+	/// IEEE 754 half precision float
+	/// </summary>
+	struct [[nodiscard]] Half
+	{
+		std::uint16_t bits;
+	};
+
+	/// <summary>
+	/// Four signed normalized components of 10, 10, 10 and 2 bits from the lowest, add it with a count of 4, normalized unless told otherwise
+	/// </summary>
+	struct [[nodiscard]] PackedSnorm
+	{
+		std::uint32_t bits;
+	};
+
+	/// <summary>
+	/// Four unsigned normalized components of 10, 10, 10 and 2 bits from the lowest, add it with a count of 4, normalized unless told otherwise
+	/// </summary>
+	struct [[nodiscard]] PackedUnorm
+	{
+		std::uint32_t bits;
+	};
+
+	/// <summary>
+	/// Unit vector folded onto an octahedron, two signed normalized shorts, add it with a count of 2, normalized unless told otherwise
+	/// </summary>
+	struct [[nodiscard]] Octahedral
+	{
+		std::int16_t x, y;
+	};
+}
+
 template<typename T>
 struct typename_table
 {
 	static inline constexpr int value = 0;
+	static inline constexpr int components = 1;
+	static inline constexpr bool normalized = false;
 };
 
-#define MAKE_TABLE_ENTRY(type, index) template<> struct typename_table<type> { static inline constexpr int value = index; };
+#define MAKE_TABLE_ENTRY(type, index) template<> struct typename_table<type> { static inline constexpr int value = index; static inline constexpr int components = 1; static inline constexpr bool normalized = false; };
+// Types which hold every component of an element in one value, they only make sense normalized
+#define MAKE_PACKED_TABLE_ENTRY(type, index, count) template<> struct typename_table<type> { static inline constexpr int value = index; static inline constexpr int components = count; static inline constexpr bool normalized = true; };
 
 MAKE_TABLE_ENTRY(bool, 0x1401); // GL_UNSIGNED_BYTE
 MAKE_TABLE_ENTRY(std::int8_t, 0x1400); // GL_BYTE
@@ -21,12 +61,30 @@ MAKE_TABLE_ENTRY(long, 0x1404); // GL_INT
 MAKE_TABLE_ENTRY(unsigned long, 0x1405); // GL_UNSIGNED_INT
 MAKE_TABLE_ENTRY(float, 0x1406); // GL_FLOAT
 MAKE_TABLE_ENTRY(double, 0x140A); // GL_DOUBLE
+MAKE_TABLE_ENTRY(gl::vertex::Half, 0x140B); // GL_HALF_FLOAT
+MAKE_PACKED_TABLE_ENTRY(gl::vertex::PackedSnorm, 0x8D9F, 4); // GL_INT_2_10_10_10_REV
+MAKE_PACKED_TABLE_ENTRY(gl::vertex::PackedUnorm, 0x8368, 4); // GL_UNSIGNED_INT_2_10_10_10_REV
+MAKE_PACKED_TABLE_ENTRY(gl::vertex::Octahedral, 0x1402, 2); // GL_SHORT
 
 template<typename T>
 [[nodiscard]]
 consteval int get_typeindex() noexcept
 {
-	return typename_table<T>::template value;
+	return typename_table<T>::value;
+}
+
+template<typename T>
+[[nodiscard]]
+consteval int get_components() noexcept
+{
+	return typename_table<T>::components;
+}
+
+template<typename T>
+[[nodiscard]]
+consteval bool get_normalized() noexcept
+{
+	return typename_table<T>::normalized;
 }
 
 export namespace gl
@@ -49,14 +107,14 @@ export namespace gl
 		}
 
 		template<typename T>
-		constexpr void AddElement(const int& count, const bool& normalized = false)
+		constexpr void AddElement(const int& count, const bool& normalized = get_normalized<T>())
 		{
 			AddUnsafeElement<T>(count, myStride, myOffset, normalized);
-			myOffset += count * sizeof(T);
+			myOffset += count * static_cast<int>(sizeof(T)) / get_components<T>();
 		}
 
 		template<typename T>
-		constexpr void AddUnsafeElement(const int& count, const int& stride, const ptrdiff_t& offset, const bool& normalized = false)
+		constexpr void AddUnsafeElement(const int& count, const int& stride, const ptrdiff_t& offset, const bool& normalized = get_normalized<T>())
 		{
 			myElements.emplace_back(count, get_typeindex<T>(), stride, offset, normalized);
 		}
@@ -1,4 +1,5 @@
 export module Glib:BufferObject;
+import Glib.ResourceTracker;
 import :Object;
 export import :BufferType;
 export import :BufferUsage;
@@ -33,6 +34,7 @@ namespace gl
 				std::swap(myUsage, other.myUsage);
 				std::swap(myLayout, other.myLayout);
 				std::swap(mySize, other.mySize);
+				std::swap(myResidency, other.myResidency);
 			}
 
 			constexpr void SetLayout(const BufferLayout& layout) noexcept
@@ -49,12 +51,12 @@ namespace gl
 			void Unbind() const noexcept;
 			void Use() const noexcept;
 
-			[[nodiscard]] constexpr buffer::BufferType GetType() const noexcept
+			[[nodiscard]] buffer::BufferType GetType() const noexcept
 			{
 				return myType;
 			}
 
-			[[nodiscard]] constexpr buffer::BufferUsage GetUsage() const noexcept
+			[[nodiscard]] buffer::BufferUsage GetUsage() const noexcept
 			{
 				return myUsage;
 			}
@@ -80,6 +82,8 @@ namespace gl
 
 			BufferLayout myLayout{};
 			size_t mySize = 0;
+			// Given by the resource tracker which was installed at the creation
+			residency::handle_t myResidency = residency::InvalidHandle;
 		};
 	}
 
@@ -0,0 +1,319 @@
+export module Glib.Font;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <array>;
+import <span>;
+import <string>;
+import <string_view>;
+import <optional>;
+import <unordered_map>;
+import <filesystem>;
+import <functional>;
+
+export namespace gl
+{
+	namespace font
+	{
+		// Pixels per em the glyphs are rasterized at, the text is scaled from it
+		inline constexpr std::uint32_t DefaultGlyphSize = 32;
+		// Pixels of distance encoded on each side of the edges
+		inline constexpr std::uint32_t DefaultSpread = 4;
+		inline constexpr std::uint32_t DefaultAtlasSize = 1024;
+		// Frames a shaped run stays cached without being used
+		inline constexpr std::uint32_t DefaultRunLifetime = 120;
+
+		struct [[nodiscard]] Point
+		{
+			float x, y;
+		};
+
+		/// <summary>
+		/// Glyph outline flattened into closed contours of line segments, in font units with the y axis going up
+		/// </summary>
+		struct [[nodiscard]] Outline
+		{
+			void Clear() noexcept;
+
+			std::vector<Point> points{};
+			// One past the last point of every contour
+			std::vector<std::uint32_t> contourEnds{};
+		};
+
+		struct [[nodiscard]] Metrics
+		{
+			std::uint32_t unitsPerEm = 0;
+			std::uint32_t glyphCount = 0;
+			float ascender = 0;
+			// Negative, below the baseline
+			float descender = 0;
+			float lineGap = 0;
+		};
+
+		/// <summary>
+		/// Signed distance field of a glyph, 128 on the edge and higher inside
+		/// </summary>
+		struct [[nodiscard]] Bitmap
+		{
+			std::uint32_t width = 0, height = 0;
+			// Position of the top left corner from the pen on the baseline, in pixels with the y axis going up
+			std::int32_t left = 0, top = 0;
+			std::vector<std::uint8_t> pixels{};
+		};
+
+		struct [[nodiscard]] Rect
+		{
+			std::uint32_t x = 0, y = 0;
+			std::uint32_t width = 0, height = 0;
+		};
+
+		/// <summary>
+		/// A glyph in the atlas, in pixels of the glyph size
+		/// </summary>
+		struct [[nodiscard]] Glyph
+		{
+			std::uint32_t index = 0;
+			// Empty for the glyphs without an outline, like the space
+			Rect rect{};
+			std::int32_t left = 0, top = 0;
+			float advance = 0;
+		};
+
+		/// <summary>
+		/// A glyph of a run, the pen position is on the baseline in pixels of the glyph size with the y axis going down
+		/// </summary>
+		struct [[nodiscard]] PositionedGlyph
+		{
+			// Slot of the glyph in the atlas
+			std::uint32_t slot;
+			float x, y;
+		};
+
+		struct [[nodiscard]] ShapedRun
+		{
+			std::vector<PositionedGlyph> glyphs{};
+			float width = 0;
+			float height = 0;
+			// The atlas generation the slots belong to
+			std::uint64_t generation = 0;
+			std::uint64_t lastFrame = 0;
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t glyphs = 0;
+			std::uint64_t rasterizedGlyphs = 0;
+			std::uint64_t runHits = 0;
+			std::uint64_t runMisses = 0;
+			std::uint64_t evictedRuns = 0;
+			// Times the atlas was full and started over
+			std::uint64_t resets = 0;
+			std::uint64_t usedArea = 0;
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			std::uint32_t glyphs = 0;
+			std::uint32_t threads = 0;
+			double singleThreadedSeconds = 0;
+			double parallelSeconds = 0;
+		};
+
+		/// <summary>
+		/// Decode UTF-8, the invalid sequences become U+FFFD
+		/// </summary>
+		void DecodeUtf8(std::string_view text, std::u32string& output);
+
+		/// <summary>
+		/// A TrueType font with glyf outlines
+		/// <para>Reads the character map (formats 4 and 12), the horizontal metrics, the kerning pairs and the simple and composite glyphs.</para>
+		/// </summary>
+		class [[nodiscard]] FontFile
+		{
+		public:
+			FontFile() noexcept = default;
+			explicit FontFile(std::vector<std::uint8_t>&& bytes) noexcept;
+			~FontFile() noexcept = default;
+
+			[[nodiscard]] static std::optional<FontFile> Open(const std::filesystem::path& path);
+
+			/// <returns>Zero, the missing glyph, for the characters which are not in the font</returns>
+			[[nodiscard]] std::uint32_t GetGlyphIndex(char32_t codepoint) const noexcept;
+			/// <returns>Font units</returns>
+			[[nodiscard]] float GetAdvance(std::uint32_t glyph) const noexcept;
+			/// <returns>Font units</returns>
+			[[nodiscard]] float GetKerning(std::uint32_t left, std::uint32_t right) const noexcept;
+			/// <param name="tolerance">Largest distance between a curve and its segments, in font units</param>
+			/// <returns>Whether the glyph has an outline</returns>
+			bool GetOutline(std::uint32_t glyph, Outline& output, float tolerance) const;
+
+			[[nodiscard]] const Metrics& GetMetrics() const noexcept;
+			[[nodiscard]] bool IsValid() const noexcept;
+
+			FontFile(const FontFile&) = delete;
+			FontFile(FontFile&&) noexcept = default;
+			FontFile& operator=(const FontFile&) = delete;
+			FontFile& operator=(FontFile&&) noexcept = default;
+
+		private:
+			struct KerningPair
+			{
+				std::uint32_t pair;
+				float value;
+			};
+
+			bool ReadTables() noexcept;
+			bool AppendOutline(std::uint32_t glyph, Outline& output, float tolerance, const std::array<float, 6>& transform, std::uint32_t depth) const;
+
+			std::vector<std::uint8_t> myBytes{};
+			Metrics myMetrics{};
+			std::uint32_t myCmap = 0;
+			std::uint32_t myCmapFormat = 0;
+			std::uint32_t myHmtx = 0;
+			std::uint32_t myMetricCount = 0;
+			std::uint32_t myLoca = 0;
+			std::uint32_t myGlyf = 0;
+			bool isLongLoca = false;
+			// Sorted by the pair, the left glyph in the high bits
+			std::vector<KerningPair> myKerning{};
+			bool isValid = false;
+		};
+
+		/// <summary>
+		/// Compute the signed distance field of an outline
+		/// <para>Each row only measures the segments within the spread of it, and takes the inside from the non zero winding of its crossings.</para>
+		/// </summary>
+		/// <param name="scale">Pixels per font unit</param>
+		void RasterizeSdf(const Outline& outline, float scale, std::uint32_t spread, Bitmap& output);
+
+		/// <summary>
+		/// Packs rectangles on horizontal shelves, each shelf as high as its first rectangle
+		/// </summary>
+		class [[nodiscard]] ShelfPacker
+		{
+		public:
+			ShelfPacker(std::uint32_t width, std::uint32_t height, std::uint32_t padding = 1) noexcept;
+
+			[[nodiscard]] std::optional<Rect> Pack(std::uint32_t width, std::uint32_t height);
+			void Clear() noexcept;
+
+			[[nodiscard]] std::uint64_t GetUsedArea() const noexcept;
+			[[nodiscard]] std::uint32_t GetWidth() const noexcept;
+			[[nodiscard]] std::uint32_t GetHeight() const noexcept;
+
+		private:
+			struct Shelf
+			{
+				std::uint32_t y, height, used;
+			};
+
+			std::uint32_t myWidth, myHeight, myPadding;
+			std::uint32_t myBottom = 0;
+			std::uint64_t myUsedArea = 0;
+			std::vector<Shelf> myShelves{};
+		};
+
+		/// <summary>
+		/// Rasterize the printable ASCII glyphs of a font, on one thread then on every thread
+		/// </summary>
+		[[nodiscard]]
+		Benchmark MeasureRasterization(const FontFile& font, std::uint32_t glyph_size = DefaultGlyphSize, std::uint32_t iterations = 4, std::uint32_t threads = 0);
+	}
+
+	/// <summary>
+	/// Signed distance field glyphs of a font, packed into a single channel atlas
+	/// <para>Shape() lays out a text with the advances and the kerning of the font and caches the run by its text.</para>
+	/// <para>The glyphs it misses are outlined, then rasterized in parallel, one glyph per task, and packed into the atlas.</para>
+	/// <para>When the atlas is full it starts over and its generation changes, which invalidates the slots of every run shaped before.</para>
+	/// <para>It makes no graphics call, a TextBatch uploads the dirty area of the pixels.</para>
+	/// </summary>
+	class [[nodiscard]] FontAtlas
+	{
+	public:
+		/// <param name="glyph_size">Pixels per em of the rasterized glyphs</param>
+		/// <param name="threads">Zero means the hardware concurrency</param>
+		FontAtlas(font::FontFile&& font, std::uint32_t glyph_size = font::DefaultGlyphSize, std::uint32_t atlas_size = font::DefaultAtlasSize, std::uint32_t spread = font::DefaultSpread, std::uint32_t threads = 0);
+		~FontAtlas() noexcept = default;
+
+		/// <summary>
+		/// Age the cached runs and drop the ones unused for too long
+		/// </summary>
+		void BeginFrame() noexcept;
+
+		/// <summary>
+		/// Make sure every glyph of the text is in the atlas
+		/// </summary>
+		/// <returns>Number of glyphs rasterized</returns>
+		std::size_t Prepare(std::u32string_view text);
+		/// <summary>
+		/// Lay out a UTF-8 text from its top left corner, new lines go down by the line height
+		/// </summary>
+		/// <returns>Valid until the run is evicted or the atlas starts over</returns>
+		const font::ShapedRun& Shape(std::string_view text);
+
+		/// <summary>
+		/// Drop every glyph and run
+		/// </summary>
+		void Clear() noexcept;
+		/// <summary>
+		/// Area written since the last call, which has to be uploaded
+		/// </summary>
+		[[nodiscard]] std::optional<font::Rect> TakeDirtyRect() noexcept;
+
+		[[nodiscard]] const font::Glyph& GetGlyph(std::uint32_t slot) const noexcept;
+		[[nodiscard]] std::span<const std::uint8_t> GetPixels() const noexcept;
+		[[nodiscard]] std::uint32_t GetSize() const noexcept;
+		[[nodiscard]] std::uint32_t GetGlyphSize() const noexcept;
+		[[nodiscard]] std::uint32_t GetSpread() const noexcept;
+		/// <summary>
+		/// Pixels of the glyph size from a baseline to the next
+		/// </summary>
+		[[nodiscard]] float GetLineHeight() const noexcept;
+		[[nodiscard]] float GetAscender() const noexcept;
+		[[nodiscard]] std::uint64_t GetGeneration() const noexcept;
+		[[nodiscard]] const font::FontFile& GetFont() const noexcept;
+		[[nodiscard]] const font::Statistics& GetStatistics() const noexcept;
+
+		FontAtlas(const FontAtlas&) = delete;
+		FontAtlas(FontAtlas&&) noexcept = default;
+		FontAtlas& operator=(const FontAtlas&) = delete;
+		FontAtlas& operator=(FontAtlas&&) noexcept = default;
+
+	private:
+		struct TextHash
+		{
+			using is_transparent = void;
+
+			[[nodiscard]] std::size_t operator()(std::string_view text) const noexcept;
+		};
+
+		[[nodiscard]] std::uint32_t GetGlyphIndex(char32_t codepoint) const noexcept;
+		/// <param name="force">Give the glyphs which don't fit an empty area instead of stopping</param>
+		/// <returns>Whether every glyph was packed</returns>
+		bool Rasterize(std::span<const std::uint32_t> glyphs, bool force);
+		void MarkDirty(const font::Rect& rect) noexcept;
+
+		font::FontFile myFont;
+		std::uint32_t myGlyphSize;
+		std::uint32_t mySize;
+		std::uint32_t mySpread;
+		std::uint32_t myThreads;
+		float myScale;
+
+		font::ShelfPacker myPacker;
+		std::vector<std::uint8_t> myPixels{};
+		std::optional<font::Rect> myDirtyRect{};
+
+		std::vector<font::Glyph> myGlyphs{};
+		// Slot of every glyph index in the atlas
+		std::unordered_map<std::uint32_t, std::uint32_t> mySlots{};
+		std::array<std::uint32_t, 128> myAsciiGlyphs{};
+
+		std::unordered_map<std::string, font::ShapedRun, TextHash, std::equal_to<>> myRuns{};
+		std::u32string myCodepoints{};
+		std::uint64_t myGeneration = 0;
+		std::uint64_t myFrame = 0;
+
+		font::Statistics myStatistics{};
+	};
+}
@@ -0,0 +1,158 @@
+export module Glib.FrameCapture;
+import <cstdint>;
+import <string>;
+import <vector>;
+import <deque>;
+import <future>;
+import <filesystem>;
+import Glib.Rect;
+
+export namespace gl
+{
+	namespace capture
+	{
+		inline constexpr std::uint32_t DefaultRingSize = 3;
+		inline constexpr std::uint32_t DefaultMaxEncodings = 8;
+
+		struct [[nodiscard]] Descriptor
+		{
+			std::filesystem::path directory{};
+			std::string prefix = "frame";
+
+			// Number of pixel pack buffers in flight
+			std::uint32_t ringSize = DefaultRingSize;
+			// Frames are dropped while this many images are still being encoded
+			std::uint32_t maxEncodings = DefaultMaxEncodings;
+			// Shared by every image being encoded, zero means the hardware concurrency
+			std::uint32_t encoderThreads = 0;
+			bool withAlpha = false;
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t capturedFrames = 0;
+			std::uint64_t encodedFrames = 0;
+			std::uint64_t droppedFrames = 0;
+			std::uint64_t failedFrames = 0;
+
+			std::uint64_t rawBytes = 0;
+			std::uint64_t encodedBytes = 0;
+			double encodeSeconds = 0;
+
+			/// <summary>
+			/// Encoding throughput of the raw pixels in MB/s
+			/// </summary>
+			[[nodiscard]]
+			constexpr double GetThroughput() const noexcept
+			{
+				if (encodeSeconds <= 0)
+				{
+					return 0;
+				}
+
+				return static_cast<double>(rawBytes) / (1024.0 * 1024.0) / encodeSeconds;
+			}
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			// MB/s of fpng_encode_image_to_memory
+			double singleThreaded = 0;
+			// MB/s of fpng_encode_image_to_memory_parallel
+			double parallel = 0;
+			std::uint32_t threads = 0;
+		};
+
+		struct [[nodiscard]] IsaBenchmark
+		{
+			// Name of the instruction set used by the crc, adler and filtering kernels
+			std::string isa{};
+			// MB/s of fpng_encode_image_to_memory
+			double encoding = 0;
+			// MB/s of fpng_decode_memory
+			double decoding = 0;
+		};
+
+		/// <summary>
+		/// Encode a top-down RGB or RGBA image into a png file in memory, using every encoder thread
+		/// </summary>
+		bool EncodePng(const std::uint8_t* pixels, std::size_t width, std::size_t height, std::size_t channels, std::vector<std::uint8_t>& output, std::uint32_t threads = 0);
+
+		/// <summary>
+		/// Compare the single threaded and the parallel encoder on the same image
+		/// </summary>
+		[[nodiscard]]
+		Benchmark MeasureEncoding(const std::uint8_t* pixels, std::size_t width, std::size_t height, std::size_t channels, std::uint32_t iterations = 8, std::uint32_t threads = 0);
+
+		/// <summary>
+		/// Encode and decode the same image once for every instruction set the processor supports, from scalar up
+		/// <para>Only the calling thread is capped, the captures encoding meanwhile keep the best kernels.</para>
+		/// </summary>
+		[[nodiscard]]
+		std::vector<IsaBenchmark> MeasureInstructionSets(const std::uint8_t* pixels, std::size_t width, std::size_t height, std::size_t channels, std::uint32_t iterations = 8);
+	}
+
+	/// <summary>
+	/// Asynchronous framebuffer capture into a png sequence
+	/// <para>Pixels are read back through a ring of pixel pack buffers, so the read never stalls the current frame.</para>
+	/// <para>Finished read backs are handed to worker threads which run the parallel png encoder.</para>
+	/// </summary>
+	class [[nodiscard]] FrameCapture
+	{
+	public:
+		explicit FrameCapture(const capture::Descriptor& descriptor);
+		~FrameCapture() noexcept;
+
+		bool Start(const Rect& area) noexcept;
+		void Stop() noexcept;
+
+		bool Capture() noexcept;
+		std::size_t Poll() noexcept;
+		void Flush() noexcept;
+
+		bool Screenshot(const std::filesystem::path& path) const noexcept;
+
+		[[nodiscard]] const capture::Statistics& GetStatistics() const noexcept;
+		[[nodiscard]] bool IsRunning() const noexcept;
+
+		FrameCapture(const FrameCapture&) = delete;
+		FrameCapture(FrameCapture&&) = delete;
+		FrameCapture& operator=(const FrameCapture&) = delete;
+		FrameCapture& operator=(FrameCapture&&) = delete;
+
+	private:
+		struct Slot
+		{
+			std::uint32_t buffer = 0;
+			// GLsync
+			void* fence = nullptr;
+			std::uint64_t frame = 0;
+		};
+
+		struct Encoding
+		{
+			std::size_t rawBytes = 0;
+			std::size_t encodedBytes = 0;
+			double seconds = 0;
+			bool succeed = false;
+		};
+
+		bool Resolve(Slot& slot, bool wait) noexcept;
+		void Collect(bool wait) noexcept;
+		[[nodiscard]] std::filesystem::path MakeFilePath(std::uint64_t frame) const;
+
+		capture::Descriptor mySettings;
+		// The share of the thread budget of each encoding
+		std::uint32_t myEncoderThreads = 1;
+		Rect myArea{};
+		std::size_t myFrameBytes = 0;
+
+		std::vector<Slot> mySlots{};
+		std::size_t nextSlot = 0;
+		std::uint64_t nextFrame = 0;
+
+		std::deque<std::future<Encoding>> myEncodings{};
+		capture::Statistics myStatistics{};
+		bool isRunning = false;
+	};
+}
@@ -0,0 +1,237 @@
+export module Glib.FrameGraph;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <string>;
+import <string_view>;
+import <span>;
+import <limits>;
+import <functional>;
+import Glib.RenderTarget;
+
+export namespace gl
+{
+	namespace graph
+	{
+		using ResourceId = std::uint32_t;
+		using PassId = std::uint32_t;
+		inline constexpr std::uint32_t Invalid = std::numeric_limits<std::uint32_t>::max();
+
+		/// <summary>
+		/// How a pass touches a resource, which decides the memory barrier a later pass needs
+		/// </summary>
+		enum class [[nodiscard]] Usage : std::uint32_t
+		{
+			// Framebuffer attachment, coherent with the later passes
+			Attachment,
+			// Sampled in a shader
+			Sampled,
+			// Image load and store
+			Image,
+			// Shader storage buffer
+			StorageBuffer,
+			Uniform,
+			Vertex,
+			Index,
+			// Indirect draw or dispatch arguments
+			Indirect,
+		};
+
+		/// <summary>
+		/// Memory barrier bits, the same as the GL_*_BARRIER_BIT values
+		/// </summary>
+		enum [[nodiscard]] BarrierBits : std::uint32_t
+		{
+			NoBarrier = 0,
+			VertexAttribBarrier = 0x0001,
+			ElementArrayBarrier = 0x0002,
+			UniformBarrier = 0x0004,
+			TextureFetchBarrier = 0x0008,
+			ShaderImageAccessBarrier = 0x0020,
+			CommandBarrier = 0x0040,
+			FramebufferBarrier = 0x0400,
+			ShaderStorageBarrier = 0x2000,
+		};
+
+		/// <summary>
+		/// Barrier which makes an earlier incoherent write visible to an access of the usage
+		/// </summary>
+		[[nodiscard]] std::uint32_t GetBarrierBits(Usage usage) noexcept;
+
+		/// <summary>
+		/// A live pass in execution order, with the transient resources it acquires first and releases last
+		/// </summary>
+		struct [[nodiscard]] ScheduledPass
+		{
+			PassId pass;
+			// Issued before the pass runs
+			std::uint32_t barriers;
+			std::uint32_t firstAcquire, acquireCount;
+			std::uint32_t firstRelease, releaseCount;
+		};
+
+		/// <summary>
+		/// Positions in the schedule of the first and of the last pass using a resource
+		/// </summary>
+		struct [[nodiscard]] Lifetime
+		{
+			std::uint32_t first = Invalid;
+			std::uint32_t last = Invalid;
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint32_t passes = 0;
+			std::uint32_t culledPasses = 0;
+			std::uint32_t resources = 0;
+			std::uint32_t transientResources = 0;
+			// Render targets needed once the transient resources with the same description share them
+			std::uint32_t physicalTargets = 0;
+			std::uint32_t barriers = 0;
+			std::uint64_t peakBytes = 0;
+			// Bytes the transient resources would take without aliasing
+			std::uint64_t unaliasedBytes = 0;
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			std::uint32_t passes = 0;
+			double seconds = 0;
+			double passesPerSecond = 0;
+			Statistics statistics{};
+		};
+
+		/// <summary>
+		/// Compile random graphs of post processing like chains, several texture reads per pass
+		/// </summary>
+		[[nodiscard]]
+		Benchmark MeasureCompilation(std::uint32_t passes = 1024, std::uint32_t iterations = 16);
+	}
+
+	/// <summary>
+	/// Frame made of passes which declare the resources they read and write
+	/// <para>Every frame, Reset() the graph, add the passes and their accesses, then Compile() and Execute() it.</para>
+	/// <para>Compile() culls the passes whose results nothing uses, orders the rest so the transient resources live shortly,</para>
+	/// <para>works out the lifetime of each transient resource for aliasing, and places memory barriers after the incoherent writes only.</para>
+	/// <para>A pass is kept when it has side effects, writes an imported resource, or produces something a kept pass reads.</para>
+	/// </summary>
+	class [[nodiscard]] FrameGraph
+	{
+	public:
+		/// <summary>
+		/// Draws the pass, the targets of its resources come from GetTarget() and GetFramebuffer() of the graph
+		/// </summary>
+		using executor_t = std::move_only_function<void() noexcept>;
+
+		FrameGraph() noexcept;
+		~FrameGraph() noexcept;
+
+		/// <summary>
+		/// Remove every pass and resource, keeping the memory
+		/// </summary>
+		void Reset() noexcept;
+
+		/// <summary>
+		/// Declare a render target the graph allocates while it is in use
+		/// </summary>
+		graph::ResourceId CreateTarget(std::string_view name, const target::Description& description);
+		/// <summary>
+		/// Declare a render target which outlives the frame, null for the default framebuffer
+		/// </summary>
+		graph::ResourceId ImportTarget(std::string_view name, const RenderTarget* target);
+		/// <summary>
+		/// Declare a buffer which outlives the frame, to order its writers and readers
+		/// </summary>
+		graph::ResourceId ImportBuffer(std::string_view name);
+
+		graph::PassId AddPass(std::string_view name, executor_t&& executor);
+		void Read(graph::PassId pass, graph::ResourceId resource, graph::Usage usage);
+		void Write(graph::PassId pass, graph::ResourceId resource, graph::Usage usage);
+		/// <summary>
+		/// Keep the pass even if nothing reads what it writes
+		/// </summary>
+		void SetSideEffect(graph::PassId pass) noexcept;
+
+		/// <summary>
+		/// Schedule the passes, without any graphics call
+		/// </summary>
+		void Compile();
+		/// <summary>
+		/// Run the scheduled passes, taking their transient targets from the pool
+		/// </summary>
+		void Execute(TransientTargets& targets);
+
+		/// <summary>
+		/// Target of a resource, only while the graph executes
+		/// </summary>
+		[[nodiscard]] const RenderTarget* GetTarget(graph::ResourceId resource) const noexcept;
+		/// <summary>
+		/// Framebuffer of transient targets, only while the graph executes
+		/// </summary>
+		[[nodiscard]] const Framebuffer& GetFramebuffer(std::span<const graph::ResourceId> colours, graph::ResourceId depth = graph::Invalid);
+
+		[[nodiscard]] std::span<const graph::ScheduledPass> GetSchedule() const noexcept;
+		/// <summary>
+		/// Resources a scheduled pass acquires before and releases after it runs
+		/// </summary>
+		[[nodiscard]] std::span<const graph::ResourceId> GetAcquired(const graph::ScheduledPass& pass) const noexcept;
+		[[nodiscard]] std::span<const graph::ResourceId> GetReleased(const graph::ScheduledPass& pass) const noexcept;
+		[[nodiscard]] graph::Lifetime GetLifetime(graph::ResourceId resource) const noexcept;
+		[[nodiscard]] bool IsCulled(graph::PassId pass) const noexcept;
+		[[nodiscard]] std::string_view GetPassName(graph::PassId pass) const noexcept;
+		[[nodiscard]] std::string_view GetResourceName(graph::ResourceId resource) const noexcept;
+		[[nodiscard]] const graph::Statistics& GetStatistics() const noexcept;
+
+		FrameGraph(const FrameGraph&) = delete;
+		FrameGraph(FrameGraph&&) noexcept = default;
+		FrameGraph& operator=(const FrameGraph&) = delete;
+		FrameGraph& operator=(FrameGraph&&) noexcept = default;
+
+	private:
+		struct Resource
+		{
+			std::string name;
+			target::Description description;
+			const RenderTarget* imported;
+			bool isImported;
+		};
+
+		struct Access
+		{
+			graph::ResourceId resource;
+			graph::Usage usage;
+			bool isWrite;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			executor_t executor;
+			std::vector<Access> accesses;
+			bool hasSideEffect;
+		};
+
+		void Schedule();
+		void AssignLifetimes();
+		void PlaceBarriers();
+
+		std::vector<Resource> myResources{};
+		std::vector<Pass> myPasses{};
+
+		// Compiled state, every vector is indexed by pass or by resource
+		std::vector<std::vector<graph::PassId>> mySuccessors{};
+		std::vector<std::vector<graph::PassId>> myProducers{};
+		std::vector<std::uint32_t> myPredecessorCounts{};
+		std::vector<bool> myLivePasses{};
+		std::vector<graph::ScheduledPass> mySchedule{};
+		std::vector<graph::Lifetime> myLifetimes{};
+		std::vector<graph::ResourceId> myAcquires{};
+		std::vector<graph::ResourceId> myReleases{};
+
+		// Handles of the transient targets while executing
+		TransientTargets* myTargets = nullptr;
+		std::vector<target::Handle> myHandles{};
+
+		graph::Statistics myStatistics{};
+	};
+}
@@ -5,6 +5,8 @@ import <string_view>;
 export import Glib;
 export import Glib.Rect;
 import Glib.Windows.Definitions;
+import Glib.Profiler;
+import Glib.Residency;
 import Glib.Windows.ManagedClient;
 export import Glib.Windows.Event;
 
@@ -74,6 +76,14 @@ export namespace gl
 		void RemoveEventHandler(EventID id) noexcept;
 
 		void SetRenderer(RenderDelegate handler) noexcept;
+		/// <summary>
+		/// Measure every frame on the CPU and on the GPU, null to stop
+		/// </summary>
+		void SetProfiler(GpuProfiler* profiler) noexcept;
+		/// <summary>
+		/// Track every texture and buffer created from now on, and keep them in the budget at the end of each frame, null to stop
+		/// </summary>
+		void SetResidencyManager(ResidencyManager* manager) noexcept;
 
 		[[nodiscard]] handle_t& GetHandle() noexcept;
 		[[nodiscard]] const handle_t& GetHandle() const noexcept;
@@ -85,6 +95,7 @@ export namespace gl
 		gl::Rect window_rect{};
 
 		opengl_system_t glSystem{ nullptr };
+		ResidencyManager* myResidency = nullptr;
 	};
 
 	[[nodiscard]] std::shared_ptr<Framework> CreateFramework() noexcept;
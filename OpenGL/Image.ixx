@@ -34,6 +34,8 @@ export namespace gl
 		Image() noexcept = default;
 		Image(const FilePath& filepath);
 
+		bool TryLoadPng(const FilePath& filepath) noexcept;
+
 		buffer_t imgBuffer;
 		size_t imgBufferSize;
 		size_t imgHSize, imgVSize;
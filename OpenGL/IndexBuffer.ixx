@@ -3,10 +3,23 @@ import <cstdint>;
 import <initializer_list>;
 import <concepts>;
 import <ranges>;
+import <span>;
 import :BufferObject;
 
 export namespace gl
 {
+	namespace buffer
+	{
+		enum class [[nodiscard]] IndexType : std::uint32_t
+		{
+			UnsignedShort = 0x1403,
+			UnsignedInt = 0x1405
+		};
+	}
+
+	/// <summary>
+	/// Element buffer which stores the indices in 16 bits whenever they fit
+	/// </summary>
 	class [[nodiscard]] IndexBuffer : public gl::BufferInterface<true>
 	{
 	private:
@@ -21,17 +34,48 @@ export namespace gl
 		template<std::ranges::contiguous_range R>
 		void Create(R&& buf, buffer::BufferUsage usage = buffer::BufferUsage::StaticDraw) noexcept;
 
+		/// <summary>
+		/// Type of the stored indices, for glDrawElements
+		/// </summary>
+		[[nodiscard]] constexpr buffer::IndexType GetIndexType() const noexcept
+		{
+			return myIndexType;
+		}
+
+		[[nodiscard]] constexpr std::size_t GetCount() const noexcept
+		{
+			return myCount;
+		}
+
 		IndexBuffer(const IndexBuffer&) = delete;
 		IndexBuffer(IndexBuffer&&) noexcept = default;
 		IndexBuffer& operator=(const IndexBuffer&) = delete;
 		IndexBuffer& operator=(IndexBuffer&&) noexcept = default;
+
+	private:
+		void Upload(std::span<const std::uint32_t> indices, buffer::BufferUsage usage) noexcept;
+		void Upload(std::span<const std::uint16_t> indices, buffer::BufferUsage usage) noexcept;
+
+		buffer::IndexType myIndexType = buffer::IndexType::UnsignedInt;
+		std::size_t myCount = 0;
 	};
 
 	template<std::ranges::contiguous_range R>
 	void IndexBuffer::Create(R&& buf, buffer::BufferUsage usage) noexcept
 	{
-		static_assert(sizeof(std::ranges::range_value_t<R>) == sizeof(std::int32_t));
+		using value_t = std::ranges::range_value_t<R>;
+		static_assert(std::integral<value_t> && (sizeof(value_t) == sizeof(std::uint16_t) || sizeof(value_t) == sizeof(std::uint32_t)));
+
+		const auto* data = std::ranges::data(buf);
+		const std::size_t count = std::ranges::size(buf);
 
-		base::Create(buffer::BufferType::ElementArray, buf.data(), buf.size(), usage);
+		if constexpr (sizeof(value_t) == sizeof(std::uint16_t))
+		{
+			Upload(std::span<const std::uint16_t>{ reinterpret_cast<const std::uint16_t*>(data), count }, usage);
+		}
+		else
+		{
+			Upload(std::span<const std::uint32_t>{ reinterpret_cast<const std::uint32_t*>(data), count }, usage);
+		}
 	}
 }
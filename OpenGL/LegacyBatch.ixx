@@ -0,0 +1,91 @@
+export module Glib.Legacy.Batch;
+import <cstdint>;
+import <vector>;
+import <span>;
+import Glib;
+
+export namespace gl::legacy
+{
+	/// <summary>
+	/// Interleaved vertex of the immediate mode emulation
+	/// </summary>
+	struct [[nodiscard]] BatchVertex
+	{
+		float position[3];
+		float normal[3];
+		float texcoord[2];
+		std::uint8_t colour[4];
+	};
+
+	/// <summary>
+	/// A run of vertices drawn with one call, the topology is always Points, Lines or Triangles
+	/// </summary>
+	struct [[nodiscard]] BatchRange
+	{
+		Primitive topology;
+		std::uint32_t first;
+		std::uint32_t count;
+	};
+
+	/// <summary>
+	/// Records glBegin/glEnd style calls into one vertex arena, without any opengl call
+	/// <para>Strips, fans, loops, quads and polygons are converted to lists when their block ends, incomplete primitives are dropped as opengl does.</para>
+	/// <para>Consecutive blocks which convert to the same topology are merged into a single range.</para>
+	/// </summary>
+	class [[nodiscard]] PrimitiveBatch
+	{
+	public:
+		PrimitiveBatch() noexcept = default;
+		~PrimitiveBatch() noexcept = default;
+
+		/// <summary>
+		/// Start a block, nested blocks are ignored
+		/// </summary>
+		void Begin(Primitive mode) noexcept;
+		/// <summary>
+		/// Convert the current block and append it to the ranges
+		/// </summary>
+		void End();
+
+		void AddVertex(float x, float y, float z);
+		void SetNormal(float x, float y, float z) noexcept;
+		void SetTexCoord(float s, float t) noexcept;
+		void SetColour(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a) noexcept;
+
+		/// <summary>
+		/// Drop every recorded vertex and range, the current attributes are kept
+		/// </summary>
+		void Clear() noexcept;
+
+		[[nodiscard]] std::span<const BatchVertex> GetVertices() const noexcept;
+		[[nodiscard]] std::span<const BatchRange> GetRanges() const noexcept;
+		[[nodiscard]] const BatchVertex& GetCurrent() const noexcept;
+		[[nodiscard]] bool IsRecording() const noexcept;
+		[[nodiscard]] bool IsEmpty() const noexcept;
+
+		/// <summary>
+		/// The list topology a primitive mode is converted to
+		/// </summary>
+		[[nodiscard]] static Primitive GetTopology(Primitive mode) noexcept;
+
+		PrimitiveBatch(const PrimitiveBatch&) = delete;
+		PrimitiveBatch(PrimitiveBatch&&) noexcept = default;
+		PrimitiveBatch& operator=(const PrimitiveBatch&) = delete;
+		PrimitiveBatch& operator=(PrimitiveBatch&&) noexcept = default;
+
+	private:
+		void Emit(std::size_t index);
+		void Append(Primitive topology, std::uint32_t first, std::uint32_t count);
+
+		// Converted vertices of the finished blocks, followed by the raw vertices of the current block
+		std::vector<BatchVertex> myVertices{};
+		std::vector<BatchRange> myRanges{};
+		// Raw vertices of a block being converted
+		std::vector<BatchVertex> myScratch{};
+
+		BatchVertex myCurrent{ { 0, 0, 0 }, { 0, 0, 1 }, { 0, 0 }, { 255, 255, 255, 255 } };
+		Primitive myMode = Primitive::Points;
+		std::size_t myBlockStart = 0;
+		bool isRecording = false;
+	};
+}
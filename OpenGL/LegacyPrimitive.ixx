@@ -2,6 +2,7 @@ export module Glib.Legacy.Primitive;
 import <cstdint>;
 import <span>;
 import Glib;
+export import Glib.Legacy.Batch;
 import Glib.Windows.Colour;
 
 export namespace gl::legacy
@@ -10,6 +11,33 @@ export namespace gl::legacy
 
 	namespace primitive
 	{
+		enum class [[nodiscard]] Backend : std::uint32_t
+		{
+			// Every call goes straight to the driver
+			Immediate = 0,
+			// Calls are recorded into a vertex arena and drawn from a streamed vertex buffer by Flush()
+			Batched,
+		};
+
+		/// <summary>
+		/// Switch the backend of every call below, the recorded vertices are flushed first
+		/// <para>The batched backend flushes itself before gl::global::SetState, blending, texture bindings and matrix changes.</para>
+		/// <para>Flush() still has to be called before opengl calls made outside of the library, other renderers, and presenting.</para>
+		/// </summary>
+		void SetBackend(Backend backend) noexcept;
+		[[nodiscard]] Backend GetBackend() noexcept;
+
+		/// <summary>
+		/// Draw the recorded vertices, then set the current colour, normal and texture coordinate as glEnd would have left them
+		/// <para>Does nothing with the immediate backend, or when nothing was recorded.</para>
+		/// </summary>
+		void Flush() noexcept;
+
+		/// <summary>
+		/// The recorded and not yet flushed vertices
+		/// </summary>
+		[[nodiscard]] const PrimitiveBatch& GetBatch() noexcept;
+
 		class [[nodiscard]] Context
 		{
 		public:
@@ -0,0 +1,166 @@
+export module Glib.LevelOfDetail;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <array>;
+import <span>;
+import <limits>;
+
+export namespace gl
+{
+	namespace lod
+	{
+		inline constexpr std::uint32_t MaxLevels = 8;
+
+		struct [[nodiscard]] SimplifyResult
+		{
+			std::size_t indexCount = 0;
+			// Worst area weighted root mean square distance of a collapsed vertex to the source planes around it, in the units of the positions
+			float error = 0;
+		};
+
+		struct [[nodiscard]] ChainOptions
+		{
+			// Levels including the source mesh
+			std::uint32_t levelCount = 4;
+			// Triangles of a level relative to the previous one
+			float reduction = 0.5f;
+			// The chain stops early at the level which can't get coarser without this much error
+			float maxError = std::numeric_limits<float>::infinity();
+		};
+
+		/// <summary>
+		/// Range of a level in the indices of the arena, the indices are relative to the base vertex of its mesh
+		/// </summary>
+		struct [[nodiscard]] Level
+		{
+			std::uint32_t firstIndex = 0;
+			std::uint32_t indexCount = 0;
+			float error = 0;
+		};
+
+		/// <summary>
+		/// Every level of a mesh shares the same vertices, the first level is the source
+		/// </summary>
+		struct [[nodiscard]] Mesh
+		{
+			std::uint32_t baseVertex = 0;
+			std::uint32_t vertexCount = 0;
+			std::uint32_t levelCount = 0;
+			std::array<Level, MaxLevels> levels{};
+		};
+
+		struct [[nodiscard]] Instance
+		{
+			std::uint32_t mesh;
+			// From the camera to the nearest point of the instance bounds
+			float distance;
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			std::size_t triangles = 0;
+			std::size_t resultTriangles = 0;
+			double seconds = 0;
+			double trianglesPerSecond = 0;
+			float error = 0;
+		};
+
+		/// <summary>
+		/// Simplify an indexed triangle list by quadric error edge collapses, the vertices are collapsed onto their neighbours so no vertex is added
+		/// <para>Vertices which share their position with another one, at the seams of the attributes, are kept as they are.</para>
+		/// </summary>
+		/// <param name="vertices">Interleaved vertices, with three floats of the position at position_offset</param>
+		/// <param name="target_index_count">The collapses stop once the result has this many indices or fewer</param>
+		/// <param name="max_error">No collapse is made whose error would be over this</param>
+		SimplifyResult Simplify(std::vector<std::uint32_t>& result, std::span<const std::uint32_t> indices, std::span<const std::byte> vertices, std::size_t vertex_size, std::size_t position_offset, std::size_t target_index_count, float max_error = std::numeric_limits<float>::infinity());
+
+		/// <summary>
+		/// Simplify a tessellated sphere to a quarter of its triangles
+		/// </summary>
+		[[nodiscard]]
+		Benchmark MeasureSimplification(std::uint32_t segments = 256);
+	}
+
+	/// <summary>
+	/// Shared vertex and index storage of the detail levels of many meshes, to be uploaded as one buffer of each
+	/// </summary>
+	class [[nodiscard]] LodArena
+	{
+	public:
+		/// <summary>
+		/// Throws std::invalid_argument when the vertices can't hold the three floats of the position at position_offset
+		/// </summary>
+		LodArena(std::size_t vertex_size, std::size_t position_offset = 0);
+		~LodArena() noexcept;
+
+		/// <summary>
+		/// Append a mesh and generate its levels, each one cache optimized
+		/// </summary>
+		/// <returns>Index of the mesh</returns>
+		std::uint32_t Add(std::span<const std::byte> vertices, std::span<const std::uint32_t> indices, const lod::ChainOptions& options = {});
+		void Clear() noexcept;
+
+		[[nodiscard]] const lod::Mesh& GetMesh(std::uint32_t mesh) const noexcept;
+		[[nodiscard]] std::span<const lod::Mesh> GetMeshes() const noexcept;
+		[[nodiscard]] std::span<const std::byte> GetVertices() const noexcept;
+		[[nodiscard]] std::span<const std::uint32_t> GetIndices() const noexcept;
+		[[nodiscard]] std::size_t GetVertexSize() const noexcept;
+
+		LodArena(const LodArena&) = delete;
+		LodArena(LodArena&&) noexcept = default;
+		LodArena& operator=(const LodArena&) = delete;
+		LodArena& operator=(LodArena&&) noexcept = default;
+
+	private:
+		std::size_t myVertexSize;
+		std::size_t myPositionOffset;
+
+		std::vector<std::byte> myVertices{};
+		std::vector<std::uint32_t> myIndices{};
+		std::vector<lod::Mesh> myMeshes{};
+	};
+
+	/// <summary>
+	/// Pick the coarsest level whose error projects under a threshold in pixels
+	/// <para>A level only gets coarser once its error is under the threshold by the hysteresis,</para>
+	/// <para>and only gets finer once its error is over the threshold by the hysteresis, so an instance near the limit doesn't flicker.</para>
+	/// </summary>
+	class [[nodiscard]] LodSelector
+	{
+	public:
+		/// <param name="threshold">Pixels of error which are let through</param>
+		/// <param name="hysteresis">Fraction of the threshold</param>
+		LodSelector(float threshold = 1.0f, float hysteresis = 0.25f) noexcept;
+		~LodSelector() noexcept;
+
+		/// <param name="vertical_fov">In radians</param>
+		void SetProjection(float vertical_fov, float viewport_height) noexcept;
+		void SetThreshold(float threshold) noexcept;
+		void SetHysteresis(float hysteresis) noexcept;
+
+		/// <summary>
+		/// Size in pixels of an error at the given distance
+		/// </summary>
+		[[nodiscard]] float GetProjectedError(float error, float distance) const noexcept;
+
+		/// <param name="current">Level of the previous frame, or MaxLevels for a new instance</param>
+		[[nodiscard]] std::uint32_t Select(const lod::Mesh& mesh, float distance, std::uint32_t current) const noexcept;
+		/// <summary>
+		/// Select the level of every instance, the levels of the previous frame are updated in place
+		/// </summary>
+		/// <returns>Indices to draw this frame</returns>
+		std::size_t Select(const LodArena& arena, std::span<const lod::Instance> instances, std::span<std::uint32_t> levels) const noexcept;
+
+		LodSelector(const LodSelector&) noexcept = default;
+		LodSelector(LodSelector&&) noexcept = default;
+		LodSelector& operator=(const LodSelector&) noexcept = default;
+		LodSelector& operator=(LodSelector&&) noexcept = default;
+
+	private:
+		// Pixels per unit of error at a distance of one
+		float myScale;
+		float myThreshold;
+		float myHysteresis;
+	};
+}
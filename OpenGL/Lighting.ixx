@@ -1,3 +1,187 @@
-export module Lighting;
+export module Glib.Lighting;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <array>;
+import <span>;
+import <string_view>;
+import Glib.Legacy.Lighting;
 
-export void MyFunc();
\ No newline at end of file
+export namespace gl
+{
+	namespace lighting
+	{
+		inline constexpr std::uint32_t DefaultClustersX = 16;
+		inline constexpr std::uint32_t DefaultClustersY = 9;
+		inline constexpr std::uint32_t DefaultClustersZ = 24;
+		// A light ends where its attenuated intensity falls under this
+		inline constexpr float IntensityCutoff = 1.0f / 256.0f;
+
+		/// <summary>
+		/// A light in view space as the shaders read it, std430 layout
+		/// </summary>
+		struct [[nodiscard]] GpuLight
+		{
+			// xyz: position, w: range
+			float position[4];
+			// rgb: diffuse colour, w: spot exponent
+			float colour[4];
+			// xyz: spot direction, w: cosine of the spot cutoff, -1 for a point light
+			float direction[4];
+			// Constant, linear and quadratic attenuation
+			float attenuation[4];
+		};
+
+		/// <summary>
+		/// Range of the lights of a cluster in the light indices, std430 layout
+		/// </summary>
+		struct [[nodiscard]] Cluster
+		{
+			std::uint32_t offset;
+			std::uint32_t count;
+		};
+
+		/// <summary>
+		/// What a shader needs to find the cluster of a fragment, the slice is floor(log(view depth) * sliceScale + sliceBias)
+		/// </summary>
+		struct [[nodiscard]] ShaderParameters
+		{
+			std::uint32_t grid[3];
+			float sliceScale;
+			float sliceBias;
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t lights = 0;
+			std::uint64_t culledLights = 0;
+			std::uint64_t clusters = 0;
+			std::uint64_t occupiedClusters = 0;
+			std::uint64_t references = 0;
+			std::uint64_t maxLightsPerCluster = 0;
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			std::size_t lights = 0;
+			std::uint32_t threads = 0;
+			double seconds = 0;
+			std::uint64_t references = 0;
+		};
+
+		/// <summary>
+		/// Storage blocks and the cluster lookup to paste into a fragment shader, the light buffers are bound by ClusteredLighting::Bind()
+		/// </summary>
+		inline constexpr std::string_view ShaderInterface = R"(
+struct ClusterLight { vec4 position; vec4 colour; vec4 direction; vec4 attenuation; };
+layout(std430, binding = 0) readonly buffer ClusterLights { ClusterLight clusterLights[]; };
+layout(std430, binding = 1) readonly buffer Clusters { uvec2 clusters[]; };
+layout(std430, binding = 2) readonly buffer ClusterIndices { uint clusterIndices[]; };
+uniform uvec3 clusterGrid;
+uniform vec2 clusterSlice;
+uniform vec2 clusterViewport;
+
+uvec2 GetClusterRange(vec2 fragment, float view_depth)
+{
+	uvec3 cell = uvec3(uvec2(fragment / clusterViewport * vec2(clusterGrid.xy)), uint(max(log(view_depth) * clusterSlice.x + clusterSlice.y, 0.0)));
+	cell = min(cell, clusterGrid - 1u);
+	return clusters[cell.x + clusterGrid.x * (cell.y + clusterGrid.y * cell.z)];
+}
+)";
+
+		/// <summary>
+		/// Distance where the attenuation brings the brightest channel of the diffuse colour under IntensityCutoff, infinite without attenuation
+		/// </summary>
+		[[nodiscard]]
+		float GetRange(const legacy::Light& light) noexcept;
+
+		/// <summary>
+		/// Bin random point and spot lights spread in front of the camera
+		/// </summary>
+		[[nodiscard]]
+		Benchmark MeasureBinning(std::size_t lights, std::uint32_t threads = 0, std::uint32_t iterations = 8);
+	}
+
+	/// <summary>
+	/// Clustered forward lighting, without the limit of the fixed function lights
+	/// <para>The view frustum is split into a grid of froxels, tiles on the screen and exponential slices in depth.</para>
+	/// <para>Build() bins every light into the froxels its bounding sphere touches, the lights are processed in parallel.</para>
+	/// <para>Upload() sends the lights, the clusters and the light indices to three shader storage buffers.</para>
+	/// </summary>
+	class [[nodiscard]] ClusteredLighting
+	{
+	public:
+		/// <param name="threads">Zero means the hardware concurrency</param>
+		ClusteredLighting(std::uint32_t x = lighting::DefaultClustersX, std::uint32_t y = lighting::DefaultClustersY, std::uint32_t z = lighting::DefaultClustersZ, std::uint32_t threads = 0);
+		~ClusteredLighting() noexcept;
+
+		/// <summary>
+		/// Column major view matrix and the perspective projection of the frame
+		/// </summary>
+		/// <param name="vertical_fov">In radians</param>
+		void SetView(const float(&view)[16], float vertical_fov, float aspect, float near_plane, float far_plane) noexcept;
+
+		void Clear() noexcept;
+		void Reserve(std::size_t count);
+		/// <summary>
+		/// Add a point light, or a spot light when its cutoff is under 90 degrees, in world space
+		/// </summary>
+		/// <returns>Index of the light in this frame</returns>
+		std::uint32_t Add(const legacy::Light& light);
+
+		void Build();
+		/// <summary>
+		/// Send the result of the last Build() to the storage buffers, created at the first call
+		/// </summary>
+		void Upload() noexcept;
+		/// <summary>
+		/// Bind the lights, the clusters and the light indices to the storage buffer bindings
+		/// </summary>
+		void Bind(std::uint32_t lights_binding = 0, std::uint32_t clusters_binding = 1, std::uint32_t indices_binding = 2) const noexcept;
+
+		/// <summary>
+		/// Slice of a view depth, the distance along the view direction
+		/// </summary>
+		[[nodiscard]] std::uint32_t GetSlice(float view_depth) const noexcept;
+		[[nodiscard]] std::uint32_t GetClusterIndex(std::uint32_t x, std::uint32_t y, std::uint32_t z) const noexcept;
+		[[nodiscard]] std::span<const lighting::Cluster> GetClusters() const noexcept;
+		[[nodiscard]] std::span<const std::uint32_t> GetLightIndices() const noexcept;
+		[[nodiscard]] std::span<const lighting::GpuLight> GetLights() const noexcept;
+		[[nodiscard]] lighting::ShaderParameters GetShaderParameters() const noexcept;
+		[[nodiscard]] const lighting::Statistics& GetStatistics() const noexcept;
+
+		ClusteredLighting(const ClusteredLighting&) = delete;
+		ClusteredLighting(ClusteredLighting&&) = delete;
+		ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+		ClusteredLighting& operator=(ClusteredLighting&&) = delete;
+
+	private:
+		void BuildBounds();
+
+		std::array<std::uint32_t, 3> myGrid;
+		std::uint32_t myThreads;
+
+		std::array<float, 16> myView{};
+		// Tangents of the half fields of view
+		float myTangentX = 1, myTangentY = 1;
+		float myNear = 0.1f, myFar = 1000.0f;
+
+		// View space bounds of every cluster, minimum then maximum
+		std::vector<std::array<float, 6>> myBounds{};
+
+		std::vector<legacy::Light> mySources{};
+		std::vector<lighting::GpuLight> myLights{};
+		std::vector<lighting::Cluster> myClusters{};
+		std::vector<std::uint32_t> myIndices{};
+
+		// Cluster and light pairs found by each worker, then the offsets of each worker into the clusters
+		std::vector<std::vector<std::uint64_t>> myWorkerPairs{};
+		std::vector<std::vector<std::uint32_t>> myWorkerCounts{};
+
+		std::uint32_t myLightBuffer = 0;
+		std::uint32_t myClusterBuffer = 0;
+		std::uint32_t myIndexBuffer = 0;
+
+		lighting::Statistics myStatistics{};
+	};
+}
@@ -0,0 +1,75 @@
+export module Glib.MeshOptimizer;
+import <cstdint>;
+import <cstddef>;
+import <span>;
+
+export namespace gl::mesh
+{
+	// Size of the post-transform cache the scores of the triangle ordering are made for
+	inline constexpr std::uint32_t ScoringCacheSize = 32;
+	// Size of the FIFO cache simulated by AnalyzeVertexCache(), close to what current hardware keeps
+	inline constexpr std::uint32_t DefaultCacheSize = 16;
+	// Vertices are fetched by lines of this many bytes
+	inline constexpr std::uint32_t FetchLineSize = 64;
+
+	struct [[nodiscard]] CacheStatistics
+	{
+		std::size_t triangles = 0;
+		std::size_t vertices = 0;
+		std::size_t misses = 0;
+		// Average cache miss ratio, transformed vertices per triangle, between 0.5 and 3
+		double acmr = 0;
+		// Average transform to vertex ratio, transformed vertices per referenced vertex, 1 at best
+		double atvr = 0;
+	};
+
+	struct [[nodiscard]] FetchStatistics
+	{
+		std::size_t bytesFetched = 0;
+		// Fetched bytes over the bytes of the referenced vertices, 1 at best
+		double overfetch = 0;
+	};
+
+	/// <summary>
+	/// Reorder the triangles of an indexed triangle list for the post-transform vertex cache, by the scores of Tom Forsyth
+	/// </summary>
+	void OptimizeVertexCache(std::span<std::uint32_t> indices, std::size_t vertex_count);
+
+	/// <summary>
+	/// Reorder clusters of a cache optimized triangle list so the outer ones come first, which reduces the overdraw
+	/// <para>The clusters are cut where the cache is flushed anyway, and where their cache miss ratio stays under threshold times the one of the whole run.</para>
+	/// </summary>
+	/// <param name="vertices">Interleaved vertices, with three floats of the position at position_offset</param>
+	/// <param name="threshold">1 keeps the cache efficiency, larger values trade it for less overdraw</param>
+	void OptimizeOverdraw(std::span<std::uint32_t> indices, std::span<const std::byte> vertices, std::size_t vertex_size, std::size_t position_offset = 0, float threshold = 1.05f);
+
+	/// <summary>
+	/// Reorder the vertices in the order of their first use and rewrite the indices, the unreferenced vertices are dropped
+	/// </summary>
+	/// <returns>Number of vertices left at the front of the vertices</returns>
+	std::size_t OptimizeVertexFetch(std::span<std::uint32_t> indices, std::span<std::byte> vertices, std::size_t vertex_size);
+
+	/// <summary>
+	/// Run the whole pipeline: vertex cache, overdraw, then vertex fetch
+	/// </summary>
+	/// <returns>Number of vertices left at the front of the vertices</returns>
+	std::size_t Optimize(std::span<std::uint32_t> indices, std::span<std::byte> vertices, std::size_t vertex_size, std::size_t position_offset = 0, float overdraw_threshold = 1.05f);
+
+	/// <summary>
+	/// Simulate a FIFO post-transform cache over the triangle list
+	/// </summary>
+	[[nodiscard]]
+	CacheStatistics AnalyzeVertexCache(std::span<const std::uint32_t> indices, std::size_t vertex_count, std::uint32_t cache_size = DefaultCacheSize);
+
+	/// <summary>
+	/// Simulate the vertex fetch by cache lines behind a FIFO post-transform cache
+	/// </summary>
+	[[nodiscard]]
+	FetchStatistics AnalyzeVertexFetch(std::span<const std::uint32_t> indices, std::size_t vertex_count, std::size_t vertex_size);
+
+	/// <summary>
+	/// Whether every index fits in 16 bits, the all ones value is left to the primitive restart
+	/// </summary>
+	[[nodiscard]]
+	bool FitsShortIndices(std::span<const std::uint32_t> indices) noexcept;
+}
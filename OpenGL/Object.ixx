@@ -15,7 +15,7 @@ export namespace gl
 		}
 
 		[[nodiscard]]
-		constexpr std::uint32_t GetID() const volatile noexcept
+		std::uint32_t GetID() const volatile noexcept
 		{
 			return myID;
 		}
@@ -27,7 +27,7 @@ export namespace gl
 		}
 
 		[[nodiscard]]
-		constexpr bool IsValid() const volatile noexcept
+		bool IsValid() const volatile noexcept
 		{
 			return myID != npos;
 		}
@@ -50,12 +50,12 @@ export namespace gl
 			myID = static_cast<std::uint32_t&&>(id);
 		}
 
-		constexpr void SetID(const std::uint32_t& id) volatile noexcept
+		void SetID(const std::uint32_t& id) volatile noexcept
 		{
 			myID = id;
 		}
 
-		constexpr void SetID(std::uint32_t&& id) volatile noexcept
+		void SetID(std::uint32_t&& id) volatile noexcept
 		{
 			myID = static_cast<std::uint32_t&&>(id);
 		}
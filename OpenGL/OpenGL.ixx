@@ -57,6 +57,16 @@ export namespace gl::global
 	void SetState(gl::State&& state, bool flag) noexcept;
 	void SetState(volatile gl::State&& state, bool flag) noexcept;
 
+	using StateListener = void(*)() noexcept;
+
+	/// <summary>
+	/// Install the listener called before the states, blending, texture bindings and matrices change, null to remove it
+	/// <para>Deferred drawing, as the batched legacy primitives, flushes there so its draws see the state they were recorded with.</para>
+	/// </summary>
+	void SetStateListener(StateListener listener) noexcept;
+	[[nodiscard]] StateListener GetStateListener() noexcept;
+	void NotifyStateChange() noexcept;
+
 	void SetBackgroundColour(const Colour& colour) noexcept;
 	void SetBackgroundColour(Colour&& colour) noexcept;
 	void SetBackgroundColour(const std::uint8_t& r, const std::uint8_t& g, const std::uint8_t& b, const std::uint8_t& a = 0xFFU) noexcept;
@@ -0,0 +1,104 @@
+export module Glib.Parallel;
+import <cstdint>;
+import <algorithm>;
+import <condition_variable>;
+import <exception>;
+import <memory>;
+import <mutex>;
+import <thread>;
+import <type_traits>;
+import <vector>;
+
+export namespace gl
+{
+	/// <summary>
+	/// Number of workers to use, zero means the hardware concurrency
+	/// </summary>
+	[[nodiscard]]
+	inline std::uint32_t
+	GetWorkerCount(std::uint32_t threads)
+	noexcept
+	{
+		return 0 == threads ? std::max(1U, std::thread::hardware_concurrency()) : threads;
+	}
+
+	/// <summary>
+	/// Threads kept alive between the parallel loops, so a loop only costs a wake up instead of a thread creation per worker
+	/// <para>The pool grows to the largest loop it ran, and runs one loop at a time. A loop started from inside a loop runs on its caller.</para>
+	/// </summary>
+	class [[nodiscard]] WorkerPool
+	{
+	public:
+		using Task = void(*)(void* context, std::uint32_t index, std::uint32_t worker);
+
+		WorkerPool() noexcept = default;
+		~WorkerPool() noexcept;
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+		WorkerPool(WorkerPool&&) = delete;
+		WorkerPool& operator=(WorkerPool&&) = delete;
+
+		/// <summary>
+		/// Run task(context, index, worker) for every index on up to threads workers, the calling thread is the worker zero
+		/// <para>The first exception thrown by a task is rethrown once every worker stopped.</para>
+		/// </summary>
+		void Run(std::uint32_t threads, std::uint32_t count, Task task, void* context);
+
+		/// <summary>
+		/// Number of threads started so far, the caller of Run not included
+		/// </summary>
+		[[nodiscard]] std::uint32_t GetThreadCount() const noexcept;
+
+		/// <summary>
+		/// The pool of ParallelFor
+		/// </summary>
+		[[nodiscard]] static WorkerPool& GetShared() noexcept;
+
+	private:
+		struct Job;
+
+		void Grow(std::uint32_t threads);
+		void Work() noexcept;
+
+		std::vector<std::thread> myThreads{};
+
+		// Serialises the loops of different callers
+		std::mutex myRunning{};
+		mutable std::mutex myMutex{};
+		std::condition_variable myWakeup{};
+		std::condition_variable myFinished{};
+
+		Job* myJob = nullptr;
+		std::uint64_t myGeneration = 0;
+		std::uint32_t myBusyThreads = 0;
+		bool isStopping = false;
+	};
+
+	/// <summary>
+	/// Run func(index, worker) for every index, spreading them over the workers of the shared pool
+	/// <para>The calling thread is the worker zero, and with a single worker everything runs on it in order.</para>
+	/// </summary>
+	template<typename Fn>
+	void
+	ParallelFor(std::uint32_t threads, std::uint32_t count, Fn&& func)
+	{
+		threads = std::min(threads, count);
+
+		if (threads <= 1)
+		{
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				func(i, 0U);
+			}
+
+			return;
+		}
+
+		using Function = std::remove_reference_t<Fn>;
+
+		WorkerPool::GetShared().Run(threads, count, [](void* context, std::uint32_t index, std::uint32_t worker) {
+			(*static_cast<Function*>(context))(index, worker);
+		}, const_cast<void*>(static_cast<const void*>(std::addressof(func))));
+	}
+}
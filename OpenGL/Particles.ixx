@@ -0,0 +1,246 @@
+export module Glib.Particles;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <array>;
+import <span>;
+import <memory>;
+import Glib;
+
+export namespace gl
+{
+	namespace particle
+	{
+		// Particles alive at once, the pools never grow past it
+		inline constexpr std::size_t DefaultCapacity = 1U << 20;
+		// Particles a task of the workers simulates, a multiple of the SIMD width
+		inline constexpr std::size_t ChunkSize = 1U << 14;
+
+		using EmitterId = std::uint32_t;
+
+		// Overlapping particles add up their light
+		inline constexpr BlendMode AdditiveAlpha{ BlendOption::SourceAlpha, BlendOption::One };
+
+		/// <summary>
+		/// A new particle
+		/// </summary>
+		struct [[nodiscard]] Particle
+		{
+			float x = 0, y = 0, z = 0;
+			float vx = 0, vy = 0, vz = 0;
+			// Seconds
+			float lifetime = 1;
+			float size = 1;
+		};
+
+		/// <summary>
+		/// Per instance attributes of the vertex stream, the colour is RGBA8 normalized
+		/// </summary>
+		struct [[nodiscard]] Instance
+		{
+			float x, y, z;
+			float size;
+			std::uint32_t colour;
+		};
+
+		/// <summary>
+		/// Colour and size over the life of the particles, from their birth to their death
+		/// </summary>
+		struct [[nodiscard]] Gradient
+		{
+			// RGBA from zero to one
+			std::array<float, 4> begin{ 1, 1, 1, 1 };
+			std::array<float, 4> end{ 1, 1, 1, 0 };
+			// Size at the death, as a fraction of the size at the birth
+			float endSize = 1;
+		};
+
+		struct [[nodiscard]] Forces
+		{
+			std::array<float, 3> gravity{ 0, -9.8f, 0 };
+			// Fraction of the velocity lost per second
+			float drag = 0;
+		};
+
+		/// <summary>
+		/// Spawns particles at a rate, with a velocity spread in a box around its own
+		/// </summary>
+		struct [[nodiscard]] Emitter
+		{
+			std::array<float, 3> position{};
+			std::array<float, 3> velocity{};
+			std::array<float, 3> spread{ 1, 1, 1 };
+			// Particles per second
+			float rate = 100;
+			float minLifetime = 1, maxLifetime = 2;
+			float minSize = 1, maxSize = 1;
+			std::uint64_t seed = 1;
+			bool isActive = true;
+
+			// Fraction of a particle left over from the previous updates
+			float accumulator = 0;
+		};
+
+		/// <summary>
+		/// Particles laid out by field, every field sized to the capacity once so spawning and killing never allocate
+		/// </summary>
+		struct [[nodiscard]] Pool
+		{
+			explicit Pool(std::size_t capacity = DefaultCapacity);
+
+			/// <returns>Whether there was room for it</returns>
+			bool Spawn(const Particle& particle) noexcept;
+			/// <summary>
+			/// Remove a particle by moving the last one into its place
+			/// </summary>
+			void Kill(std::size_t index) noexcept;
+			/// <summary>
+			/// Kill every particle past its lifetime
+			/// </summary>
+			/// <returns>Number of particles killed</returns>
+			std::size_t RemoveDead() noexcept;
+			void Clear() noexcept;
+
+			[[nodiscard]] std::size_t GetSize() const noexcept;
+			[[nodiscard]] std::size_t GetCapacity() const noexcept;
+
+			std::vector<float> x{}, y{}, z{};
+			std::vector<float> vx{}, vy{}, vz{};
+			// Seconds lived and the inverse of the lifetime, the particle dies when their product reaches one
+			std::vector<float> age{}, inverseLifetime{};
+			std::vector<float> size{};
+			std::size_t count = 0;
+			std::size_t capacity = 0;
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t alive = 0;
+			std::uint64_t spawned = 0;
+			std::uint64_t killed = 0;
+			// Spawns refused because the pool was full
+			std::uint64_t dropped = 0;
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			std::size_t particles = 0;
+			std::uint32_t threads = 0;
+			// Particles integrated per second
+			double scalarPerSecond = 0;
+			double simdPerSecond = 0;
+			double parallelPerSecond = 0;
+			// Particles written into the instance stream per second, on every thread
+			double instancesPerSecond = 0;
+		};
+
+		/// <summary>
+		/// Move the particles of a range by a step of semi implicit Euler, four at a time
+		/// </summary>
+		void Integrate(Pool& pool, std::size_t begin, std::size_t end, float delta_time, const Forces& forces) noexcept;
+		void IntegrateScalar(Pool& pool, std::size_t begin, std::size_t end, float delta_time, const Forces& forces) noexcept;
+
+		/// <summary>
+		/// Write the instances of a range with their colour and size over life, four at a time
+		/// </summary>
+		/// <param name="destination">One instance per particle of the range</param>
+		void WriteInstances(const Pool& pool, std::size_t begin, std::size_t end, const Gradient& gradient, Instance* destination) noexcept;
+
+		/// <summary>
+		/// Simulation throughput over a full pool, without any graphics call
+		/// </summary>
+		[[nodiscard]]
+		Benchmark MeasureSimulation(std::size_t particles = DefaultCapacity, std::uint32_t iterations = 8, std::uint32_t threads = 0);
+	}
+
+	/// <summary>
+	/// Emits, simulates and kills the particles of a pool on the worker pool
+	/// <para>Update() gives every emitter a contiguous range of the pool for its new particles and fills the ranges in parallel,</para>
+	/// <para>integrates the pool in chunks across the workers, then swap removes the dead particles.</para>
+	/// <para>WriteInstances() turns the alive particles into the instance stream, ParticleRenderer writes it straight into a mapped buffer.</para>
+	/// </summary>
+	class [[nodiscard]] ParticleSystem
+	{
+	public:
+		/// <param name="threads">Zero means the hardware concurrency</param>
+		ParticleSystem(std::size_t capacity = particle::DefaultCapacity, std::uint32_t threads = 0);
+		~ParticleSystem() noexcept = default;
+
+		particle::EmitterId AddEmitter(const particle::Emitter& emitter);
+		[[nodiscard]] particle::Emitter& GetEmitter(particle::EmitterId id) noexcept;
+		void ClearEmitters() noexcept;
+
+		void SetForces(const particle::Forces& forces) noexcept;
+		void SetGradient(const particle::Gradient& gradient) noexcept;
+
+		/// <param name="delta_time">Seconds</param>
+		void Update(float delta_time);
+		/// <summary>
+		/// Kill every particle
+		/// </summary>
+		void Clear() noexcept;
+
+		/// <param name="destination">Room for GetSize() instances</param>
+		/// <returns>Number of instances written</returns>
+		std::size_t WriteInstances(std::span<particle::Instance> destination) const;
+
+		[[nodiscard]] const particle::Pool& GetPool() const noexcept;
+		[[nodiscard]] const particle::Statistics& GetStatistics() const noexcept;
+		[[nodiscard]] std::size_t GetSize() const noexcept;
+
+		ParticleSystem(const ParticleSystem&) = delete;
+		ParticleSystem(ParticleSystem&&) noexcept = default;
+		ParticleSystem& operator=(const ParticleSystem&) = delete;
+		ParticleSystem& operator=(ParticleSystem&&) noexcept = default;
+
+	private:
+		particle::Pool myPool;
+		std::uint32_t myThreads;
+
+		std::vector<particle::Emitter> myEmitters{};
+		// First particle and number of particles of every emitter in this update
+		std::vector<std::size_t> mySpawnOffsets{};
+		std::vector<std::size_t> mySpawnCounts{};
+
+		particle::Forces myForces{};
+		particle::Gradient myGradient{};
+		particle::Statistics myStatistics{};
+	};
+
+	/// <summary>
+	/// Draws the particles of a system as camera facing quads, one instance per particle
+	/// </summary>
+	class [[nodiscard]] ParticleRenderer
+	{
+	public:
+		ParticleRenderer() noexcept = default;
+		~ParticleRenderer() noexcept;
+
+		/// <summary>
+		/// Create the buffers and the shaders, the context has to be current
+		/// </summary>
+		bool Create() noexcept;
+		void Destroy() noexcept;
+
+		/// <summary>
+		/// Write the instances into the orphaned buffer and draw them, the matrices are column major
+		/// <para>The program, the vertex array and the array buffer bound before are bound again afterwards.</para>
+		/// </summary>
+		/// <returns>Number of particles drawn</returns>
+		std::size_t Draw(const ParticleSystem& system, const std::array<float, 16>& view, const std::array<float, 16>& projection, const BlendMode& blend = particle::AdditiveAlpha);
+
+		[[nodiscard]] bool IsCreated() const noexcept;
+
+		ParticleRenderer(const ParticleRenderer&) = delete;
+		ParticleRenderer(ParticleRenderer&&) = delete;
+		ParticleRenderer& operator=(const ParticleRenderer&) = delete;
+		ParticleRenderer& operator=(ParticleRenderer&&) = delete;
+
+	private:
+		std::unique_ptr<Pipeline> myPipeline{};
+		std::uint32_t myVertexArray = 0;
+		std::uint32_t myInstanceBuffer = 0;
+		// Instances the buffer holds
+		std::size_t myCapacity = 0;
+	};
+}
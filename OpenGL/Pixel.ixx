@@ -1,4 +1,5 @@
 export module Glib:Pixel;
+import <cstdint>;
 import Glib.Windows.Colour;
 
 export namespace gl
@@ -15,4 +16,18 @@ export namespace gl
 		Colour colour;
 		float depth;
 	};
+
+	/// <summary>
+	/// A colour of the vertex streams, read as four normalized unsigned bytes with red in the lowest one
+	/// </summary>
+	[[nodiscard]]
+	constexpr std::uint32_t
+	PackColour(const Colour& colour)
+	noexcept
+	{
+		return static_cast<std::uint32_t>(colour.R)
+			| static_cast<std::uint32_t>(colour.G) << 8
+			| static_cast<std::uint32_t>(colour.B) << 16
+			| static_cast<std::uint32_t>(colour.A) << 24;
+	}
 }
@@ -0,0 +1,59 @@
+export module Glib.Png;
+import <cstdint>;
+import <vector>;
+import <filesystem>;
+
+export namespace gl
+{
+	namespace png
+	{
+		enum class [[nodiscard]] DecodeResult : std::uint32_t
+		{
+			Success = 0,
+			// The signature is missing
+			NotPng,
+			// IHDR is missing, malformed or describes an image too large to decode
+			InvalidHeader,
+			// A critical chunk this decoder doesn't know about
+			UnsupportedChunk,
+			// A chunk runs past the end of the file or its crc doesn't match
+			CorruptChunk,
+			// The zlib stream or the filtered rows are malformed
+			CorruptData,
+			OutOfMemory,
+		};
+
+		struct [[nodiscard]] Header
+		{
+			std::uint32_t width = 0;
+			std::uint32_t height = 0;
+			std::uint8_t bitDepth = 0;
+			std::uint8_t colourType = 0;
+			bool interlaced = false;
+		};
+
+		/// <summary>
+		/// Whether the path ends in .png, in any case
+		/// </summary>
+		[[nodiscard]]
+		bool HasPngExtension(const std::filesystem::path& path) noexcept;
+
+		/// <summary>
+		/// Read the signature and IHDR of a png file in memory
+		/// </summary>
+		DecodeResult ReadHeader(const std::uint8_t* data, std::size_t size, Header& header) noexcept;
+
+		/// <summary>
+		/// Decode any conforming png file into top-down 8-bit RGBA
+		/// <para>Every colour type, bit depth, filter and Adam7 interlacing are supported. 16-bit samples keep their high byte.</para>
+		/// <para>Transparency from tRNS is applied, gamma and colour space chunks are ignored.</para>
+		/// </summary>
+		DecodeResult Decode(const std::uint8_t* data, std::size_t size, std::vector<std::uint8_t>& rgba, std::size_t& width, std::size_t& height) noexcept;
+
+		/// <summary>
+		/// Decoding throughput of a png file in MB/s of decoded RGBA pixels, zero if it can't be decoded
+		/// </summary>
+		[[nodiscard]]
+		double MeasureDecoding(const std::uint8_t* data, std::size_t size, std::uint32_t iterations = 8);
+	}
+}
@@ -0,0 +1,279 @@
+export module Glib.Profiler;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <string>;
+import <string_view>;
+import <span>;
+import <limits>;
+import <chrono>;
+
+export namespace gl
+{
+	class GpuProfiler;
+
+	namespace profiler
+	{
+		// Frames a query result may take before it is read, so reading never waits for the GPU
+		inline constexpr std::uint32_t DefaultLatency = 3;
+		inline constexpr std::uint32_t DefaultMaxScopes = 64;
+		// Characters of a scope name kept, the longer ones are cut so a scope never allocates
+		inline constexpr std::size_t MaxScopeName = 47;
+
+		using ScopeId = std::uint32_t;
+		inline constexpr ScopeId InvalidScope = std::numeric_limits<ScopeId>::max();
+
+		/// <summary>
+		/// Which processor took longer over a frame or over a pass
+		/// </summary>
+		enum class [[nodiscard]] Bound : std::uint32_t
+		{
+			Cpu,
+			Gpu,
+		};
+
+		/// <summary>
+		/// A pass measured on both processors, in nanoseconds since the CPU began the frame
+		/// <para>The GPU times are moved onto the CPU clock, so the two can be drawn on the same timeline.</para>
+		/// </summary>
+		struct [[nodiscard]] ScopeTiming
+		{
+			std::string name{};
+			std::uint32_t depth = 0;
+			// Index of the enclosing scope in the frame, InvalidScope at the top level
+			ScopeId parent = InvalidScope;
+
+			std::int64_t cpuBegin = 0, cpuEnd = 0;
+			std::int64_t gpuBegin = 0, gpuEnd = 0;
+
+			[[nodiscard]]
+			constexpr std::int64_t GetCpuTime() const noexcept
+			{
+				return cpuEnd - cpuBegin;
+			}
+
+			[[nodiscard]]
+			constexpr std::int64_t GetGpuTime() const noexcept
+			{
+				return gpuEnd - gpuBegin;
+			}
+
+			/// <summary>
+			/// The GPU bounds the pass when it runs longer than the CPU took to submit it
+			/// </summary>
+			[[nodiscard]]
+			constexpr Bound GetBound() const noexcept
+			{
+				return GetCpuTime() < GetGpuTime() ? Bound::Gpu : Bound::Cpu;
+			}
+		};
+
+		/// <summary>
+		/// A resolved frame, from System::BeginRendering to System::EndRendering
+		/// </summary>
+		struct [[nodiscard]] FrameTimeline
+		{
+			std::uint64_t frame = 0;
+			// Frames begun from this one until it was read back
+			std::uint32_t latency = 0;
+
+			std::int64_t cpuEnd = 0;
+			std::int64_t gpuBegin = 0, gpuEnd = 0;
+			std::vector<ScopeTiming> scopes{};
+
+			[[nodiscard]]
+			constexpr std::int64_t GetCpuTime() const noexcept
+			{
+				return cpuEnd;
+			}
+
+			[[nodiscard]]
+			constexpr std::int64_t GetGpuTime() const noexcept
+			{
+				return gpuEnd - gpuBegin;
+			}
+
+			[[nodiscard]]
+			constexpr Bound GetBound() const noexcept
+			{
+				return GetCpuTime() < GetGpuTime() ? Bound::Gpu : Bound::Cpu;
+			}
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t frames = 0;
+			std::uint64_t resolvedFrames = 0;
+			// Frames left unmeasured because the queries of their ring slot were still in flight
+			std::uint64_t skippedFrames = 0;
+			// Scopes beyond the maximum of a frame, left unmeasured
+			std::uint64_t droppedScopes = 0;
+			std::uint64_t queries = 0;
+			std::uint64_t cpuBoundFrames = 0;
+			std::uint64_t gpuBoundFrames = 0;
+			// Running averages over the resolved frames, in milliseconds
+			double averageCpuTime = 0;
+			double averageGpuTime = 0;
+		};
+
+		/// <summary>
+		/// The timestamp queries the profiler is made with, replaceable by a fake implementation to check the ring without a context
+		/// </summary>
+		class Backend
+		{
+		public:
+			virtual ~Backend() noexcept = default;
+
+			virtual void CreateQueries(std::span<std::uint32_t> queries) noexcept = 0;
+			virtual void DeleteQueries(std::span<const std::uint32_t> queries) noexcept = 0;
+			/// <summary>
+			/// Record the GPU time once the commands before are done
+			/// </summary>
+			virtual void WriteTimestamp(std::uint32_t query) noexcept = 0;
+			/// <summary>
+			/// Whether the result is ready, without waiting for it
+			/// </summary>
+			[[nodiscard]] virtual bool IsAvailable(std::uint32_t query) noexcept = 0;
+			/// <returns>Nanoseconds</returns>
+			[[nodiscard]] virtual std::uint64_t GetTimestamp(std::uint32_t query) noexcept = 0;
+			/// <summary>
+			/// The GPU time at which the commands issued so far reach the GPU, only asked for when the profiler calibrates its clocks
+			/// </summary>
+			[[nodiscard]] virtual std::uint64_t GetCurrentTimestamp() noexcept = 0;
+		};
+
+		/// <summary>
+		/// The backend of the current OpenGL context
+		/// </summary>
+		[[nodiscard]] Backend& GetBackend() noexcept;
+
+		/// <summary>
+		/// Measure the enclosing block as a pass of the current frame
+		/// </summary>
+		class [[nodiscard]] Scope
+		{
+		public:
+			Scope(GpuProfiler& profiler, std::string_view name) noexcept;
+			~Scope() noexcept;
+
+			Scope(const Scope&) = delete;
+			Scope(Scope&&) = delete;
+			Scope& operator=(const Scope&) = delete;
+			Scope& operator=(Scope&&) = delete;
+
+		private:
+			GpuProfiler& myProfiler;
+			ScopeId myId;
+		};
+	}
+
+	/// <summary>
+	/// Measures the passes of the frames on the CPU and on the GPU at once
+	/// <para>Every scope writes a timestamp query at its beginning and at its end, in a ring of slots with one frame each.</para>
+	/// <para>A slot is read back only when all of its results are available, a few frames later, so the profiler never stalls the pipeline;</para>
+	/// <para>a frame whose slot is still in flight is left unmeasured instead.</para>
+	/// <para>Give it to System::SetProfiler() to bracket every frame between BeginRendering and EndRendering.</para>
+	/// </summary>
+	class [[nodiscard]] GpuProfiler
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+
+		/// <param name="latency">Number of frames in the ring</param>
+		/// <param name="max_scopes">Scopes measured in a frame</param>
+		GpuProfiler(profiler::Backend& backend = profiler::GetBackend(), std::uint32_t latency = profiler::DefaultLatency, std::uint32_t max_scopes = profiler::DefaultMaxScopes);
+		~GpuProfiler() noexcept;
+
+		/// <summary>
+		/// Read back the finished frames and start measuring a new one, the context has to be current
+		/// </summary>
+		void BeginFrame();
+		/// <summary>
+		/// Close the scopes left open and stop measuring the frame
+		/// </summary>
+		void EndFrame() noexcept;
+
+		/// <returns>InvalidScope when the frame is not measured</returns>
+		profiler::ScopeId BeginScope(std::string_view name) noexcept;
+		void EndScope(profiler::ScopeId scope) noexcept;
+
+		/// <summary>
+		/// Read back the finished frames without beginning one
+		/// </summary>
+		/// <returns>Number of frames resolved</returns>
+		std::size_t Resolve();
+		/// <summary>
+		/// Line up the GPU clock with the CPU clock again at the next frame, they drift apart over long sessions
+		/// <para>It is done once when the queries are created, as asking the GPU for its time waits for the commands to reach it.</para>
+		/// </summary>
+		void Calibrate() noexcept;
+		/// <summary>
+		/// Delete the queries, the context has to be current
+		/// </summary>
+		void Release() noexcept;
+
+		void SetEnabled(bool flag) noexcept;
+		[[nodiscard]] bool IsEnabled() const noexcept;
+
+		/// <summary>
+		/// The last frame read back, null until there is one
+		/// </summary>
+		[[nodiscard]] const profiler::FrameTimeline* GetLatest() const noexcept;
+		[[nodiscard]] const profiler::Statistics& GetStatistics() const noexcept;
+		[[nodiscard]] std::uint64_t GetFrame() const noexcept;
+
+		GpuProfiler(const GpuProfiler&) = delete;
+		GpuProfiler(GpuProfiler&&) noexcept = default;
+		GpuProfiler& operator=(const GpuProfiler&) = delete;
+		GpuProfiler& operator=(GpuProfiler&&) noexcept = default;
+
+	private:
+		struct PendingScope
+		{
+			std::string name{};
+			std::uint32_t depth = 0;
+			profiler::ScopeId parent = profiler::InvalidScope;
+			clock::time_point cpuBegin{}, cpuEnd{};
+			bool isOpen = false;
+		};
+
+		struct Slot
+		{
+			// First of its queries, the begin and end of the frame then the begin and end of every scope
+			std::uint32_t firstQuery = 0;
+			std::vector<PendingScope> scopes{};
+			std::uint32_t scopeCount = 0;
+			std::uint64_t frame = 0;
+			clock::time_point cpuBegin{}, cpuEnd{};
+			// GPU nanoseconds when the CPU began the frame, the origin of the GPU times on the timeline
+			std::int64_t gpuReference = 0;
+			bool isPending = false;
+		};
+
+		[[nodiscard]] bool IsReady(const Slot& slot) const noexcept;
+		void ResolveSlot(Slot& slot);
+		[[nodiscard]] std::int64_t ReadGpuTime(const Slot& slot, std::uint32_t query) const noexcept;
+
+		profiler::Backend* myBackend;
+		std::uint32_t myMaxScopes;
+		bool isEnabled = true;
+
+		// Allocated up front, created on the first frame when the context is current
+		std::vector<std::uint32_t> myQueries{};
+		bool hasQueries = false;
+		std::vector<Slot> mySlots{};
+		// The slot of the frame being measured
+		std::size_t myCurrent = 0;
+		bool isMeasuring = false;
+		profiler::ScopeId myOpenScope = profiler::InvalidScope;
+		std::uint64_t myFrame = 0;
+
+		// GPU nanoseconds minus CPU nanoseconds, measured at calibration
+		std::int64_t myClockOffset = 0;
+		bool isCalibrated = false;
+
+		profiler::FrameTimeline myLatest{};
+		bool hasLatest = false;
+		profiler::Statistics myStatistics{};
+	};
+}
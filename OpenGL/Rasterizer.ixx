@@ -0,0 +1,178 @@
+export module Glib.Rasterizer;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <span>;
+import <array>;
+import Glib;
+import Glib.Culling;
+
+export namespace gl
+{
+	namespace raster
+	{
+		// Edge length in pixels of the tiles which triangles are binned into
+		inline constexpr std::uint32_t TileSize = 64;
+		// Keeps the fixed point edge functions of the clipped triangles inside 32 bits
+		inline constexpr std::uint32_t MaxDimension = 8192;
+
+		struct [[nodiscard]] DrawState
+		{
+			bool depthTesting = true;
+			bool depthWriting = true;
+			Comparator depthComparator = Comparator::Less;
+
+			bool blending = false;
+			BlendMode blendMode = Opaque;
+
+			bool culling = false;
+			Face cullFace = Face::Back;
+			// Same as CullingDirection(), counter clockwise triangles are the front ones by default
+			bool clockwise = false;
+
+			// Used when the layout has no colour element
+			Colour colour{ 1.0f, 1.0f, 1.0f, 1.0f };
+		};
+
+		/// <summary>
+		/// The same vertex bytes and layout given to a BufferObject, which keeps no CPU copy of its own
+		/// </summary>
+		struct [[nodiscard]] VertexInput
+		{
+			std::span<const std::byte> vertices{};
+			const BufferLayout* layout = nullptr;
+			// Element of the layout holding 2 to 4 position components
+			std::size_t positionElement = 0;
+			// Element of the layout holding 3 or 4 colour components, negative when there is none
+			std::ptrdiff_t colourElement = -1;
+			// Triangle list indices, empty to draw the vertices in order
+			std::span<const std::uint32_t> indices{};
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t submittedTriangles = 0;
+			std::uint64_t clippedTriangles = 0;
+			std::uint64_t culledTriangles = 0;
+			std::uint64_t binnedTriangles = 0;
+			std::uint64_t shadedPixels = 0;
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			std::uint32_t threads = 0;
+			double trianglesPerSecond = 0;
+		};
+	}
+
+	/// <summary>
+	/// Tile based software rasterizer for triangle lists
+	/// <para>Draw() transforms, clips and bins the triangles in parallel, every worker fills its own tile bins.</para>
+	/// <para>Finish() rasterizes the tiles in parallel, each tile walks the bins in submission order so blending stays ordered.</para>
+	/// <para>Rows are stored top-down. Depth is the window depth in [0, 1].</para>
+	/// </summary>
+	class [[nodiscard]] SoftwareRasterizer
+	{
+	public:
+		/// <param name="threads">Zero means the hardware concurrency</param>
+		SoftwareRasterizer(std::uint32_t width, std::uint32_t height, std::uint32_t threads = 0);
+		~SoftwareRasterizer() noexcept;
+
+		void Clear(const Colour& colour, float depth = 1.0f) noexcept;
+
+		/// <summary>
+		/// Column major model-view-projection matrix, as given by transform::GetCurrentMatrix()
+		/// </summary>
+		void SetTransform(const float(&matrix)[16]) noexcept;
+		void SetState(const raster::DrawState& state) noexcept;
+
+		/// <summary>
+		/// Set up and bin a triangle list with the current transform and state
+		/// </summary>
+		bool Draw(const raster::VertexInput& input);
+		/// <summary>
+		/// Rasterize every binned triangle into the framebuffer
+		/// </summary>
+		void Finish();
+
+		[[nodiscard]] std::span<const ScreenPixel> GetPixels() const noexcept;
+		[[nodiscard]] std::uint32_t GetWidth() const noexcept;
+		[[nodiscard]] std::uint32_t GetHeight() const noexcept;
+		[[nodiscard]] std::uint32_t GetThreads() const noexcept;
+		[[nodiscard]] const raster::Statistics& GetStatistics() const noexcept;
+
+		SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+		SoftwareRasterizer(SoftwareRasterizer&&) noexcept = default;
+		SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+		SoftwareRasterizer& operator=(SoftwareRasterizer&&) noexcept = default;
+
+	private:
+		// Screen space value of an attribute: origin + dx * (x - x0) + dy * (y - y0)
+		struct Plane
+		{
+			float origin;
+			float dx;
+			float dy;
+		};
+
+		struct Triangle
+		{
+			// Vertices in 28.4 fixed point pixels
+			std::int32_t x[3];
+			std::int32_t y[3];
+			// Edge i runs from vertex i to vertex i + 1 and is positive inside, these are its steps per fixed point unit
+			std::int32_t stepX[3];
+			std::int32_t stepY[3];
+			// -1 for the edges which don't own the pixels lying exactly on them
+			std::int32_t bias[3];
+
+			// Inclusive pixel bounds, clamped to the framebuffer
+			std::int32_t minX, minY, maxX, maxY;
+
+			// Relative to the first vertex, in pixels
+			float originX, originY;
+			Plane depth;
+			// Perspective correct colour: 1 / w and the channels divided by w
+			Plane inverseW;
+			Plane colour[4];
+		};
+
+		struct Bin
+		{
+			std::vector<Triangle> triangles{};
+			// Indices into triangles, per tile
+			std::vector<std::vector<std::uint32_t>> tiles{};
+		};
+
+		struct Batch
+		{
+			raster::DrawState state{};
+			// One per worker, in submission order
+			std::vector<Bin> bins{};
+		};
+
+		void RasterizeTile(std::uint32_t tile, raster::Statistics& statistics) noexcept;
+
+		std::uint32_t myWidth;
+		std::uint32_t myHeight;
+		std::uint32_t myThreads;
+		std::uint32_t tilesX;
+		std::uint32_t tilesY;
+
+		std::vector<ScreenPixel> myPixels{};
+		std::array<float, 16> myTransform{};
+		raster::DrawState myState{};
+
+		std::vector<Batch> myBatches{};
+		raster::Statistics myStatistics{};
+	};
+
+	namespace raster
+	{
+		/// <summary>
+		/// Triangles per second of a scene of small random triangles, once per thread count from one up to the hardware concurrency
+		/// </summary>
+		[[nodiscard]]
+		std::vector<Benchmark> MeasureThroughput(std::uint32_t width, std::uint32_t height, std::uint32_t triangles, std::uint32_t iterations = 4);
+	}
+}
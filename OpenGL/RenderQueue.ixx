@@ -0,0 +1,166 @@
+export module Glib.RenderQueue;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <span>;
+import Glib;
+import Glib.Texture;
+
+export namespace gl
+{
+	namespace render
+	{
+		// Bits of the sort key from the top: layer, translucency, then the state and the depth
+		inline constexpr std::uint32_t LayerBits = 8;
+		inline constexpr std::uint32_t PipelineBits = 12;
+		inline constexpr std::uint32_t MaterialBits = 16;
+		inline constexpr std::uint32_t DepthBits = 24;
+
+		/// <summary>
+		/// Pack a sort key, items are drawn by ascending keys
+		/// <para>Opaque items are grouped by pipeline and material, then go front to back.</para>
+		/// <para>Translucent items come after the opaque ones of their layer and go back to front, so the depth comes before the state.</para>
+		/// </summary>
+		/// <param name="depth">View depth in [0, 1], zero is the nearest. NaN is taken as zero</param>
+		[[nodiscard]]
+		constexpr std::uint64_t
+		MakeSortKey(std::uint8_t layer, std::uint16_t pipeline, std::uint16_t material, float depth, bool translucent)
+		noexcept
+		{
+			constexpr std::uint64_t depth_mask = (1ULL << DepthBits) - 1;
+			constexpr std::uint64_t pipeline_mask = (1ULL << PipelineBits) - 1;
+
+			// Written so a NaN fails the first test, converting it would be undefined
+			const float clamped = not (0 < depth) ? 0 : (1 < depth ? 1 : depth);
+			const std::uint64_t quantized = static_cast<std::uint64_t>(clamped * static_cast<float>(depth_mask)) & depth_mask;
+
+			std::uint64_t key = static_cast<std::uint64_t>(layer) << 56;
+
+			if (translucent)
+			{
+				key |= 1ULL << 55;
+				key |= (depth_mask - quantized) << 31;
+				key |= (pipeline & pipeline_mask) << 19;
+				key |= static_cast<std::uint64_t>(material) << 3;
+			}
+			else
+			{
+				key |= (pipeline & pipeline_mask) << 43;
+				key |= static_cast<std::uint64_t>(material) << 27;
+				key |= quantized << 3;
+			}
+
+			return key;
+		}
+
+		/// <summary>
+		/// One draw, every state left as nullptr is not touched
+		/// </summary>
+		struct [[nodiscard]] DrawItem
+		{
+			std::uint64_t key = 0;
+
+			Pipeline* pipeline = nullptr;
+			const Texture* texture = nullptr;
+			// Bound with Use(), which also enables the attributes of its layout
+			const BufferObject* buffer = nullptr;
+
+			bool blending = false;
+			BlendMode blendMode = Opaque;
+
+			Primitive primitive = Primitive::Triangles;
+			std::uint32_t count = 0;
+			// Draws instead of pipeline->Render() when given, after the states are bound
+			Pipeline::renderer_t renderer{};
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t items = 0;
+			std::uint64_t drawCalls = 0;
+			std::uint64_t pipelineChanges = 0;
+			std::uint64_t textureChanges = 0;
+			std::uint64_t bufferChanges = 0;
+			std::uint64_t blendChanges = 0;
+			// Binds which repeated the state of the previous item
+			std::uint64_t skippedChanges = 0;
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			std::size_t items = 0;
+			std::uint32_t threads = 0;
+			double radixSeconds = 0;
+			double comparisonSeconds = 0;
+		};
+
+		/// <summary>
+		/// Compare the radix sort of the queue with std::sort over random keys
+		/// </summary>
+		[[nodiscard]]
+		Benchmark MeasureSorting(std::size_t items = 100000, std::uint32_t iterations = 8, std::uint32_t threads = 0);
+	}
+
+	/// <summary>
+	/// Queue of draw items, sorted by their keys before they are issued
+	/// <para>Sort() is a least significant digit radix sort over the keys, the histograms and the scatter of each pass run in parallel.</para>
+	/// <para>Submit() binds only the states which differ from the previous item and counts every change.</para>
+	/// </summary>
+	class [[nodiscard]] RenderQueue
+	{
+	public:
+		/// <param name="threads">Zero means the hardware concurrency</param>
+		RenderQueue(std::uint32_t threads = 0);
+		~RenderQueue() noexcept;
+
+		void Clear() noexcept;
+		void Reserve(std::size_t count);
+		void Push(render::DrawItem&& item);
+
+		/// <summary>
+		/// Order the items by their keys, equal keys keep their submission order
+		/// </summary>
+		void Sort();
+		/// <summary>
+		/// Sort if needed, then issue every item
+		/// <para>The bound states are left as the last item set them.</para>
+		/// </summary>
+		void Submit();
+
+		/// <summary>
+		/// Indices of the items in draw order, after Sort()
+		/// </summary>
+		[[nodiscard]] std::span<const std::uint32_t> GetOrder() const noexcept;
+		[[nodiscard]] std::span<const render::DrawItem> GetItems() const noexcept;
+		[[nodiscard]] const render::Statistics& GetStatistics() const noexcept;
+		[[nodiscard]] std::size_t GetSize() const noexcept;
+		[[nodiscard]] bool IsEmpty() const noexcept;
+
+		RenderQueue(const RenderQueue&) = delete;
+		RenderQueue(RenderQueue&&) noexcept = default;
+		RenderQueue& operator=(const RenderQueue&) = delete;
+		RenderQueue& operator=(RenderQueue&&) noexcept = default;
+
+	private:
+		std::uint32_t myThreads;
+		bool isSorted = true;
+
+		std::vector<render::DrawItem> myItems{};
+
+		// Sorted keys and the item indices in draw order, then the scratch of the radix sort
+		std::vector<std::uint64_t> myKeys{};
+		std::vector<std::uint32_t> myOrder{};
+		std::vector<std::uint64_t> myScratchKeys{};
+		std::vector<std::uint32_t> myScratchIndices{};
+
+		render::Statistics myStatistics{};
+	};
+
+	namespace render
+	{
+		/// <summary>
+		/// Stable sort of the keys and their payloads, the parallel radix sort used by RenderQueue
+		/// </summary>
+		void RadixSort(std::span<std::uint64_t> keys, std::span<std::uint32_t> values, std::span<std::uint64_t> scratch_keys, std::span<std::uint32_t> scratch_values, std::uint32_t threads);
+	}
+}
@@ -0,0 +1,245 @@
+export module Glib.RenderTarget;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <deque>;
+import <array>;
+import <span>;
+import <limits>;
+import Glib;
+
+export namespace gl
+{
+	namespace target
+	{
+		/// <summary>
+		/// Sized internal formats of the render targets
+		/// </summary>
+		enum class [[nodiscard]] Format : std::uint32_t
+		{
+			R8 = 0x8229,
+			RG8 = 0x822B,
+			RGBA8 = 0x8058,
+			R32UI = 0x8236,
+			R32F = 0x822E,
+			RG16F = 0x822F,
+			RGBA16F = 0x881A,
+			RGBA32F = 0x8814,
+			R11G11B10F = 0x8C3A,
+			Depth24 = 0x81A6,
+			Depth32F = 0x8CAC,
+			Depth24Stencil8 = 0x88F0,
+		};
+
+		using Handle = std::uint32_t;
+		inline constexpr Handle InvalidHandle = std::numeric_limits<Handle>::max();
+		inline constexpr std::uint32_t MaxColourAttachments = 8;
+
+		struct [[nodiscard]] Description
+		{
+			std::uint32_t width = 0;
+			std::uint32_t height = 0;
+			Format format = Format::RGBA8;
+
+			[[nodiscard]] constexpr bool operator==(const Description&) const noexcept = default;
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t acquired = 0;
+			std::uint64_t created = 0;
+			// Acquisitions served by a target of an earlier frame
+			std::uint64_t reused = 0;
+			// Acquisitions served by a target another pass released in this frame
+			std::uint64_t aliased = 0;
+			std::uint64_t destroyed = 0;
+			std::uint64_t liveTargets = 0;
+			std::uint64_t liveFramebuffers = 0;
+			std::uint64_t residentBytes = 0;
+			// Most bytes in use at once during the frame
+			std::uint64_t peakBytes = 0;
+		};
+
+		[[nodiscard]] bool IsDepthFormat(Format format) noexcept;
+		[[nodiscard]] bool HasStencil(Format format) noexcept;
+		[[nodiscard]] std::uint32_t GetBytesPerPixel(Format format) noexcept;
+		[[nodiscard]] std::uint64_t GetByteSize(const Description& description) noexcept;
+
+		/// <summary>
+		/// The graphics calls the render targets are made with, replaceable by a recording implementation to check them without a context
+		/// </summary>
+		class Device
+		{
+		public:
+			virtual ~Device() noexcept = default;
+
+			[[nodiscard]] virtual std::uint32_t CreateTexture(const Description& description) noexcept = 0;
+			virtual void DeleteTexture(std::uint32_t texture) noexcept = 0;
+			virtual void BindTexture(std::uint32_t unit, std::uint32_t texture) noexcept = 0;
+
+			/// <param name="depth">Zero for no depth attachment</param>
+			/// <returns>Zero when the framebuffer is incomplete</returns>
+			[[nodiscard]] virtual std::uint32_t CreateFramebuffer(std::span<const std::uint32_t> colours, std::uint32_t depth, Format depth_format) noexcept = 0;
+			virtual void DeleteFramebuffer(std::uint32_t framebuffer) noexcept = 0;
+			/// <summary>
+			/// Bind a framebuffer and set the viewport to its size, zero is the default framebuffer
+			/// </summary>
+			virtual void BindFramebuffer(std::uint32_t framebuffer, std::uint32_t width, std::uint32_t height) noexcept = 0;
+		};
+
+		/// <summary>
+		/// The device of the current OpenGL context
+		/// </summary>
+		[[nodiscard]] Device& GetDevice() noexcept;
+	}
+
+	/// <summary>
+	/// A texture which can be drawn into
+	/// </summary>
+	class [[nodiscard]] RenderTarget : public gl::Object
+	{
+	public:
+		using base = gl::Object;
+
+		RenderTarget() noexcept = default;
+		RenderTarget(const target::Description& description, target::Device& device = target::GetDevice()) noexcept;
+		~RenderTarget() noexcept;
+
+		void Bind(std::uint32_t unit) const noexcept;
+		void Destroy() noexcept;
+
+		[[nodiscard]] const target::Description& GetDescription() const noexcept;
+		[[nodiscard]] std::uint32_t GetWidth() const noexcept;
+		[[nodiscard]] std::uint32_t GetHeight() const noexcept;
+		[[nodiscard]] target::Format GetFormat() const noexcept;
+		[[nodiscard]] std::uint64_t GetByteSize() const noexcept;
+
+		RenderTarget(const RenderTarget&) = delete;
+		RenderTarget(RenderTarget&& other) noexcept;
+		RenderTarget& operator=(const RenderTarget&) = delete;
+		RenderTarget& operator=(RenderTarget&& other) noexcept;
+
+	private:
+		target::Device* myDevice = nullptr;
+		target::Description myDescription{};
+	};
+
+	/// <summary>
+	/// Colour and depth render targets of the same size bound together
+	/// </summary>
+	class [[nodiscard]] Framebuffer : public gl::Object
+	{
+	public:
+		using base = gl::Object;
+
+		Framebuffer() noexcept = default;
+		/// <param name="depth">Null for no depth attachment</param>
+		Framebuffer(std::span<const RenderTarget* const> colours, const RenderTarget* depth, target::Device& device = target::GetDevice()) noexcept;
+		~Framebuffer() noexcept;
+
+		/// <summary>
+		/// Draw into the targets, over their whole size
+		/// </summary>
+		void Bind() const noexcept;
+		/// <summary>
+		/// Go back to the default framebuffer, whose viewport is left for the caller to restore
+		/// </summary>
+		void Unbind() const noexcept;
+		void Destroy() noexcept;
+
+		[[nodiscard]] std::uint32_t GetWidth() const noexcept;
+		[[nodiscard]] std::uint32_t GetHeight() const noexcept;
+		[[nodiscard]] std::uint32_t GetColourCount() const noexcept;
+
+		Framebuffer(const Framebuffer&) = delete;
+		Framebuffer(Framebuffer&& other) noexcept;
+		Framebuffer& operator=(const Framebuffer&) = delete;
+		Framebuffer& operator=(Framebuffer&& other) noexcept;
+
+	private:
+		target::Device* myDevice = nullptr;
+		std::uint32_t myWidth = 0;
+		std::uint32_t myHeight = 0;
+		std::uint32_t myColourCount = 0;
+	};
+
+	/// <summary>
+	/// Pool of the render targets which only live for a few passes of a frame
+	/// <para>Acquire() hands out a free target of the same description, or creates one.</para>
+	/// <para>A target released by a pass is aliased by the next pass acquiring the same description,</para>
+	/// <para>and the targets which stay unused for a few frames are destroyed, so the memory stays flat from frame to frame.</para>
+	/// </summary>
+	class [[nodiscard]] TransientTargets
+	{
+	public:
+		/// <param name="idle_frames">Frames a free target is kept for</param>
+		TransientTargets(target::Device& device = target::GetDevice(), std::uint32_t idle_frames = 2) noexcept;
+		~TransientTargets() noexcept;
+
+		void BeginFrame() noexcept;
+		/// <summary>
+		/// Release the targets still in use and destroy the idle ones
+		/// </summary>
+		void EndFrame() noexcept;
+
+		[[nodiscard]] target::Handle Acquire(const target::Description& description);
+		/// <summary>
+		/// Give a target back after its last pass of the frame
+		/// </summary>
+		void Release(target::Handle handle) noexcept;
+
+		/// <summary>
+		/// The reference stays valid until the target is destroyed
+		/// </summary>
+		[[nodiscard]] const RenderTarget& GetTarget(target::Handle handle) const noexcept;
+		/// <summary>
+		/// Framebuffer of the targets, kept until one of them is destroyed
+		/// </summary>
+		/// <param name="depth">InvalidHandle for no depth attachment</param>
+		[[nodiscard]] const Framebuffer& GetFramebuffer(std::span<const target::Handle> colours, target::Handle depth = target::InvalidHandle);
+
+		/// <summary>
+		/// Destroy every target and framebuffer
+		/// </summary>
+		void Clear() noexcept;
+
+		[[nodiscard]] const target::Statistics& GetStatistics() const noexcept;
+		[[nodiscard]] std::uint64_t GetFrame() const noexcept;
+
+		TransientTargets(const TransientTargets&) = delete;
+		TransientTargets(TransientTargets&&) noexcept = default;
+		TransientTargets& operator=(const TransientTargets&) = delete;
+		TransientTargets& operator=(TransientTargets&&) noexcept = default;
+
+	private:
+		struct Slot
+		{
+			RenderTarget target;
+			std::uint64_t lastFrame = 0;
+			bool isUsed = false;
+			// Released earlier in the current frame
+			bool isReleased = false;
+		};
+
+		struct CachedFramebuffer
+		{
+			// Textures of the colour attachments then of the depth attachment, zero for none
+			std::array<std::uint32_t, target::MaxColourAttachments + 1> textures{};
+			Framebuffer framebuffer;
+		};
+
+		void DestroySlot(std::size_t index) noexcept;
+
+		target::Device* myDevice;
+		std::uint32_t myIdleFrames;
+		std::uint64_t myFrame = 0;
+		std::uint64_t myUsedBytes = 0;
+
+		// Neither grows by moving its elements, so the references handed out stay valid
+		std::deque<Slot> mySlots{};
+		std::vector<std::uint32_t> myEmptySlots{};
+		std::deque<CachedFramebuffer> myFramebuffers{};
+
+		target::Statistics myStatistics{};
+	};
+}
@@ -0,0 +1,195 @@
+export module Glib.Residency;
+import <cstdint>;
+import <list>;
+import <unordered_map>;
+import <functional>;
+export import Glib.ResourceTracker;
+
+export namespace gl
+{
+	namespace residency
+	{
+		enum class [[nodiscard]] EvictAction : std::uint32_t
+		{
+			None = 0,
+			// The most detailed resident mip level has to be released
+			DropMip,
+			// Every byte of the resource has to be released
+			Evict,
+			// The resource was uploaded and its CPU copy is not needed anymore
+			ReleaseCpuCopy,
+			// Every mip level is resident again
+			Restore,
+		};
+
+		inline constexpr std::size_t DefaultBudget = 512ULL * 1024ULL * 1024ULL;
+
+		struct [[nodiscard]] Allocation
+		{
+			handle_t handle = InvalidHandle;
+			ResourceKind kind = ResourceKind::None;
+			// Name of the underlying opengl object, zero for simulated allocations
+			std::uint32_t object = 0;
+
+			// Size of the most detailed mip level
+			std::size_t baseBytes = 0;
+			std::size_t residentBytes = 0;
+			std::size_t cpuBytes = 0;
+
+			std::uint32_t mipLevels = 1;
+			// The most detailed mip level which is still resident
+			std::uint32_t residentMip = 0;
+
+			std::uint64_t lastUsedFrame = 0;
+			bool isResident = true;
+
+			// Given by the owner of the CPU copy, empty for simulated allocations
+			std::function<void()> releaseCpuCopy = nullptr;
+			// Uploads the contents again from the CPU copy, so it goes with the copy
+			std::function<void()> reload = nullptr;
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::size_t budget = 0;
+			std::size_t residentBytes = 0;
+			std::size_t cpuBytes = 0;
+			std::size_t peakBytes = 0;
+
+			std::size_t numberOfAllocations = 0;
+			std::size_t droppedMips = 0;
+			std::size_t evictions = 0;
+			std::size_t releasedCpuCopies = 0;
+			std::size_t reloads = 0;
+		};
+
+		/// <summary>
+		/// Number of bytes occupied by the mip chain [first_mip, mip_levels)
+		/// </summary>
+		[[nodiscard]]
+		constexpr std::size_t ComputeMipChainBytes(const std::size_t& base_bytes, const std::uint32_t& mip_levels, const std::uint32_t& first_mip = 0) noexcept
+		{
+			std::size_t result = 0;
+
+			for (std::uint32_t level = first_mip; level < mip_levels; ++level)
+			{
+				const std::size_t shift = static_cast<std::size_t>(level) * 2;
+				const std::size_t bytes = shift < 64 ? (base_bytes >> shift) : 0;
+
+				result += 0 < bytes ? bytes : 1;
+			}
+
+			return result;
+		}
+
+		[[nodiscard]]
+		constexpr std::uint32_t ComputeMipLevels(std::size_t width, std::size_t height) noexcept
+		{
+			std::uint32_t result = 1;
+
+			while (1 < width || 1 < height)
+			{
+				width = 1 < width ? width / 2 : 1;
+				height = 1 < height ? height / 2 : 1;
+				++result;
+			}
+
+			return result;
+		}
+
+		/// <summary>
+		/// Default handler which forwards the eviction to opengl
+		/// <para>Dropped mips are clamped by the base level, evicted contents are invalidated to let the driver page them out.</para>
+		/// <para>Restored textures sample from the base level again, and CPU copies are released through their owner.</para>
+		/// </summary>
+		void ApplyEviction(const Allocation& allocation, EvictAction action) noexcept;
+	}
+
+	/// <summary>
+	/// Accounts every texture and buffer allocation against a memory budget.
+	/// <para>Eviction walks the least recently used resources and drops their detailed mips before evicting them completely.</para>
+	/// <para>Only resources which can be uploaded again are evicted, and touching one uploads it again before it is used.</para>
+	/// <para>The manager does not call opengl by itself but through its evict handler, so it also works with simulated allocations.</para>
+	/// <para>Installed as the tracker, it receives every texture and buffer created afterwards.</para>
+	/// </summary>
+	class [[nodiscard]] ResidencyManager : public residency::Tracker
+	{
+	public:
+		using handle_t = residency::handle_t;
+		using allocation_t = residency::Allocation;
+		using evict_handler_t = std::function<void(const allocation_t&, residency::EvictAction)>;
+
+		ResidencyManager() noexcept;
+		explicit ResidencyManager(const std::size_t& budget) noexcept;
+		~ResidencyManager() noexcept;
+
+		handle_t Allocate(residency::ResourceKind kind, const std::size_t& base_bytes, const std::uint32_t& mip_levels = 1, const std::size_t& cpu_bytes = 0, const std::uint32_t& object = 0);
+		void Free(const handle_t& handle) noexcept;
+
+		/// <summary>
+		/// Mark the resource used in this frame, uploading again what was evicted from it
+		/// </summary>
+		/// <returns>Whether every mip level is resident</returns>
+		bool Touch(const handle_t& handle) noexcept;
+		/// <summary>
+		/// Account every mip level again after the contents were uploaded again
+		/// </summary>
+		void Restore(const handle_t& handle) noexcept;
+		void MarkUploaded(const handle_t& handle) noexcept;
+		void ReleaseCpuCopy(const handle_t& handle) noexcept;
+
+		/// <summary>
+		/// Track the resources created from now on, until another tracker is installed or the manager is destroyed
+		/// </summary>
+		void Install() noexcept;
+		void Uninstall() noexcept;
+
+		handle_t OnCreate(residency::ResourceKind kind, const std::uint32_t& object, const std::size_t& base_bytes, const std::uint32_t& mip_levels, const std::size_t& cpu_bytes, std::function<void()> release_cpu_copy, std::function<void()> reload) override;
+		void OnUse(const handle_t& handle) noexcept override;
+		void OnUpload(const handle_t& handle) noexcept override;
+		void OnReleaseCpuCopy(const handle_t& handle) noexcept override;
+		void OnDestroy(const handle_t& handle) noexcept override;
+
+		void BeginFrame() noexcept;
+		std::size_t Enforce() noexcept;
+
+		void SetBudget(const std::size_t& budget) noexcept;
+		void SetEvictHandler(evict_handler_t handler) noexcept;
+		/// <summary>
+		/// Release the CPU copies as soon as they are uploaded
+		/// <para>Those resources have nothing left to upload again from, so they are never evicted afterwards.</para>
+		/// </summary>
+		void ReleaseCpuCopies(const bool& flag) noexcept;
+
+		[[nodiscard]] const allocation_t* Find(const handle_t& handle) const noexcept;
+		[[nodiscard]] const residency::Statistics& GetStatistics() const noexcept;
+		[[nodiscard]] std::size_t GetBudget() const noexcept;
+		[[nodiscard]] std::size_t GetResidentBytes() const noexcept;
+		[[nodiscard]] std::uint64_t GetFrame() const noexcept;
+		[[nodiscard]] bool IsOverBudget() const noexcept;
+
+		ResidencyManager(const ResidencyManager&) = delete;
+		ResidencyManager(ResidencyManager&&) = delete;
+		ResidencyManager& operator=(const ResidencyManager&) = delete;
+		ResidencyManager& operator=(ResidencyManager&&) = delete;
+
+	private:
+		// front is the least recently used
+		using lru_t = std::list<allocation_t>;
+		using index_t = std::unordered_map<handle_t, lru_t::iterator>;
+
+		void Notify(const allocation_t& allocation, residency::EvictAction action);
+		void Account(allocation_t& allocation, const std::size_t& new_bytes) noexcept;
+		void Reload(allocation_t& allocation) noexcept;
+		void DropCpuCopy(allocation_t& allocation) noexcept;
+		[[nodiscard]] static bool IsEvictable(const allocation_t& allocation) noexcept;
+
+		lru_t myAllocations{};
+		index_t myIndices{};
+		evict_handler_t onEvict = residency::ApplyEviction;
+
+		residency::Statistics myStatistics{};
+		std::uint64_t currentFrame = 0;
+		bool shouldReleaseCpuCopies = false;
+	};
+}
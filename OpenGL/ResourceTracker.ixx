@@ -0,0 +1,51 @@
+export module Glib.ResourceTracker;
+import <cstdint>;
+import <cstddef>;
+import <functional>;
+
+export namespace gl::residency
+{
+	enum class [[nodiscard]] ResourceKind : std::uint32_t
+	{
+		None = 0,
+		Texture,
+		Buffer,
+	};
+
+	using handle_t = std::uint64_t;
+	inline constexpr handle_t InvalidHandle = 0;
+
+	/// <summary>
+	/// Told about every texture and buffer created, used or destroyed while it is installed
+	/// <para>The resources keep the handle returned on creation and report through it, unknown handles are ignored.</para>
+	/// </summary>
+	class [[nodiscard]] Tracker
+	{
+	public:
+		virtual ~Tracker() noexcept = default;
+
+		/// <param name="object">Name of the opengl object, zero when the resource has none yet</param>
+		/// <param name="release_cpu_copy">Drops the pixels kept on the CPU, empty when there is no copy</param>
+		/// <param name="reload">Uploads the contents again from the CPU copy, empty when they can not come back once evicted</param>
+		virtual handle_t OnCreate(ResourceKind kind, const std::uint32_t& object, const std::size_t& base_bytes, const std::uint32_t& mip_levels, const std::size_t& cpu_bytes, std::function<void()> release_cpu_copy, std::function<void()> reload) = 0;
+		/// <summary>
+		/// The resource is about to be used, so whatever was evicted has to be uploaded again first
+		/// </summary>
+		virtual void OnUse(const handle_t& handle) noexcept = 0;
+		/// <summary>
+		/// The contents were written again, so everything evicted is back
+		/// </summary>
+		virtual void OnUpload(const handle_t& handle) noexcept = 0;
+		/// <summary>
+		/// The owner drops its CPU copy by itself, after the tracker is told
+		/// </summary>
+		virtual void OnReleaseCpuCopy(const handle_t& handle) noexcept = 0;
+		virtual void OnDestroy(const handle_t& handle) noexcept = 0;
+	};
+
+	/// <summary>
+	/// Install the tracker of the resources created from now on, null to stop tracking
+	/// </summary>
+	void SetTracker(Tracker* tracker) noexcept;
+	[[nodiscard]] Tracker* GetTracker() noexcept;
+}
@@ -0,0 +1,137 @@
+export module Glib.SceneIndex;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <span>;
+import <limits>;
+import Glib.Visibility;
+
+export namespace gl
+{
+	namespace scene
+	{
+		using visibility::BoundingBox;
+		using visibility::Frustum;
+
+		inline constexpr std::uint32_t InvalidObject = std::numeric_limits<std::uint32_t>::max();
+		// Nodes with this many objects or fewer become leaves
+		inline constexpr std::uint32_t MaxLeafSize = 4;
+		// Candidate split planes per axis of the surface area heuristic
+		inline constexpr std::uint32_t SplitBins = 16;
+
+		struct [[nodiscard]] Node
+		{
+			float min[3];
+			// First child of an inner node, the second one follows it. First entry of the objects of a leaf
+			std::uint32_t first;
+			float max[3];
+			// Zero for an inner node
+			std::uint32_t count;
+		};
+
+		struct [[nodiscard]] Ray
+		{
+			float origin[3];
+			float direction[3];
+			float maxDistance = std::numeric_limits<float>::infinity();
+		};
+
+		/// <summary>
+		/// Nearest bounding box along a ray, object is InvalidObject on a miss
+		/// </summary>
+		struct [[nodiscard]] RayHit
+		{
+			std::uint32_t object = InvalidObject;
+			float distance = std::numeric_limits<float>::infinity();
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			std::size_t objects = 0;
+			std::uint32_t threads = 0;
+			double buildSeconds = 0;
+			double refitSeconds = 0;
+			double frustumQueriesPerSecond = 0;
+			double rayQueriesPerSecond = 0;
+			double boxQueriesPerSecond = 0;
+		};
+
+		/// <summary>
+		/// Build, refit and query throughput over a random scene, the queries run batched on every thread
+		/// </summary>
+		[[nodiscard]]
+		Benchmark MeasureSceneIndex(std::size_t objects, std::size_t queries, std::uint32_t threads = 0);
+	}
+
+	/// <summary>
+	/// Bounding volume hierarchy over the bounding boxes of a scene, flattened into one array of 32 byte nodes
+	/// <para>Build() splits the nodes by the binned surface area heuristic, the subtrees are built in parallel.</para>
+	/// <para>Moving objects are handled by Update() and Refit(), which keep the topology, so Build() again once the boxes have moved far.</para>
+	/// <para>Objects are identified by their index in the array given to Build().</para>
+	/// </summary>
+	class [[nodiscard]] SceneIndex
+	{
+	public:
+		SceneIndex() noexcept;
+		~SceneIndex() noexcept;
+
+		/// <param name="threads">Zero means the hardware concurrency</param>
+		void Build(std::span<const scene::BoundingBox> bounds, std::uint32_t threads = 0);
+		void Clear() noexcept;
+
+		/// <summary>
+		/// Move an object, the hierarchy isn't valid again until Refit()
+		/// </summary>
+		void Update(std::uint32_t object, const scene::BoundingBox& bounds) noexcept;
+		/// <summary>
+		/// Recompute the bounds of every node from the objects, bottom up
+		/// </summary>
+		void Refit() noexcept;
+
+		/// <summary>
+		/// Append the objects whose box touches the frustum to the result
+		/// </summary>
+		void QueryFrustum(const scene::Frustum& frustum, std::vector<std::uint32_t>& result) const;
+		/// <summary>
+		/// Append the objects whose box overlaps the given box to the result
+		/// </summary>
+		void QueryBox(const scene::BoundingBox& box, std::vector<std::uint32_t>& result) const;
+		/// <summary>
+		/// Nearest object box hit by the ray, for picking
+		/// </summary>
+		[[nodiscard]] scene::RayHit Raycast(const scene::Ray& ray) const;
+
+		/// <summary>
+		/// Run many queries at once over the workers, every query gets its own result
+		/// </summary>
+		void QueryFrustums(std::span<const scene::Frustum> frustums, std::vector<std::vector<std::uint32_t>>& results, std::uint32_t threads = 0) const;
+		void QueryBoxes(std::span<const scene::BoundingBox> boxes, std::vector<std::vector<std::uint32_t>>& results, std::uint32_t threads = 0) const;
+		void Raycast(std::span<const scene::Ray> rays, std::span<scene::RayHit> hits, std::uint32_t threads = 0) const;
+
+		[[nodiscard]] const scene::BoundingBox& GetBounds(std::uint32_t object) const noexcept;
+		/// <summary>
+		/// The flattened hierarchy, the root comes first and every child comes after its parent
+		/// </summary>
+		[[nodiscard]] std::span<const scene::Node> GetNodes() const noexcept;
+		/// <summary>
+		/// Objects in leaf order, a leaf refers to count of them starting at first
+		/// </summary>
+		[[nodiscard]] std::span<const std::uint32_t> GetObjects() const noexcept;
+		[[nodiscard]] std::size_t GetObjectCount() const noexcept;
+		[[nodiscard]] std::size_t GetNodeCount() const noexcept;
+		[[nodiscard]] std::uint32_t GetDepth() const noexcept;
+		[[nodiscard]] bool IsEmpty() const noexcept;
+
+		SceneIndex(const SceneIndex&) = delete;
+		SceneIndex(SceneIndex&&) noexcept = default;
+		SceneIndex& operator=(const SceneIndex&) = delete;
+		SceneIndex& operator=(SceneIndex&&) noexcept = default;
+
+	private:
+		std::vector<scene::Node> myNodes{};
+		// Objects in leaf order
+		std::vector<std::uint32_t> myObjects{};
+		std::vector<scene::BoundingBox> myBounds{};
+		std::uint32_t myDepth = 0;
+	};
+}
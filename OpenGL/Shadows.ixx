@@ -0,0 +1,225 @@
+export module Glib.Shadows;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <array>;
+import <span>;
+import <optional>;
+import <functional>;
+import Glib;
+import Glib.SceneIndex;
+
+export namespace gl
+{
+	namespace shadow
+	{
+		inline constexpr std::uint32_t MaxCascades = 4;
+		inline constexpr std::uint32_t DefaultAtlasSize = 4096;
+		// Smallest tile the atlas hands out
+		inline constexpr std::uint32_t MinimumTileSize = 64;
+
+		/// <summary>
+		/// Square region of the atlas in texels
+		/// </summary>
+		struct [[nodiscard]] Tile
+		{
+			std::uint32_t x = 0;
+			std::uint32_t y = 0;
+			std::uint32_t size = 0;
+		};
+
+		struct [[nodiscard]] Cascade
+		{
+			// Column major, from world space to the clip space of the cascade
+			float viewProjection[16];
+			// Scale and offset from the [0, 1] coordinates of the cascade to the atlas
+			float atlasTransform[4];
+			// View depths covered by the cascade
+			float nearDepth;
+			float farDepth;
+			// Size of a shadow texel in world units
+			float texelSize;
+			Tile tile;
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint32_t cascades = 0;
+			std::array<std::uint64_t, MaxCascades> casters{};
+			// Objects out of the frustum of a cascade, counted once per cascade
+			std::uint64_t culled = 0;
+		};
+
+		/// <summary>
+		/// View depths of the cascade boundaries, a blend of logarithmic and uniform splits
+		/// </summary>
+		/// <param name="lambda">One gives logarithmic splits, zero uniform ones</param>
+		/// <returns>count + 1 depths from near_plane to far_plane</returns>
+		[[nodiscard]]
+		std::array<float, MaxCascades + 1> ComputeSplits(float near_plane, float far_plane, std::uint32_t count, float lambda = 0.75f) noexcept;
+
+		/// <summary>
+		/// Orthographic light projection around a slice of the camera frustum
+		/// <para>The slice is bounded by a sphere and the projection is snapped to whole texels,</para>
+		/// <para>so the shadow doesn't shimmer when the camera moves or turns.</para>
+		/// </summary>
+		/// <param name="view">Column major rigid view matrix of the camera</param>
+		/// <param name="vertical_fov">In radians</param>
+		/// <param name="light_direction">Direction the light travels in world space</param>
+		/// <param name="caster_distance">How far towards the light casters are kept in front of the slice</param>
+		[[nodiscard]]
+		Cascade ComputeCascade(const float(&view)[16], float vertical_fov, float aspect, float near_depth, float far_depth, const float(&light_direction)[3], std::uint32_t resolution, float caster_distance = 0) noexcept;
+	}
+
+	/// <summary>
+	/// One depth texture shared by the shadow maps of every light, divided into square tiles by a quadtree
+	/// <para>The allocation is on the CPU, Create() makes the texture and its depth only framebuffer.</para>
+	/// </summary>
+	class [[nodiscard]] ShadowAtlas
+	{
+	public:
+		ShadowAtlas(std::uint32_t size = shadow::DefaultAtlasSize, std::uint32_t min_tile = shadow::MinimumTileSize);
+		~ShadowAtlas() noexcept;
+
+		/// <summary>
+		/// Take a tile of at least the given size, rounded up to a power of two
+		/// </summary>
+		[[nodiscard]] std::optional<shadow::Tile> Allocate(std::uint32_t size);
+		/// <summary>
+		/// Return a tile, merging it with its free siblings
+		/// </summary>
+		void Free(const shadow::Tile& tile);
+		void Clear();
+
+		/// <summary>
+		/// Create the depth texture and the framebuffer
+		/// </summary>
+		/// <returns>Whether the framebuffer is complete</returns>
+		bool Create() noexcept;
+		void Destroy() noexcept;
+
+		/// <summary>
+		/// Polygon offset of the depth passes, against shadow acne
+		/// </summary>
+		void SetDepthBias(float slope_factor, float units) noexcept;
+
+		/// <summary>
+		/// Bind the framebuffer and turn off the colour writes, End() restores every state changed here
+		/// </summary>
+		void Begin() noexcept;
+		/// <summary>
+		/// Restrict the drawing to a tile and clear its depth
+		/// </summary>
+		void BeginTile(const shadow::Tile& tile) noexcept;
+		void End() noexcept;
+		/// <summary>
+		/// Bind the depth texture for sampling, with depth comparison
+		/// </summary>
+		void Bind(std::uint32_t unit) const noexcept;
+
+		[[nodiscard]] std::uint32_t GetSize() const noexcept;
+		[[nodiscard]] std::uint64_t GetFreeArea() const noexcept;
+		[[nodiscard]] std::uint32_t GetTexture() const noexcept;
+		[[nodiscard]] bool IsCreated() const noexcept;
+
+		ShadowAtlas(const ShadowAtlas&) = delete;
+		ShadowAtlas(ShadowAtlas&&) = delete;
+		ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+		ShadowAtlas& operator=(ShadowAtlas&&) = delete;
+
+	private:
+		[[nodiscard]] std::uint32_t GetLevel(std::uint32_t size) const noexcept;
+
+		std::uint32_t mySize;
+		std::uint32_t myLevelCount;
+		// Free tiles of each level, the first level is the whole atlas
+		std::vector<std::vector<std::array<std::uint32_t, 2>>> myFreeTiles{};
+		std::uint64_t myFreeArea = 0;
+
+		std::uint32_t myTexture = 0;
+		std::uint32_t myFramebuffer = 0;
+		float mySlopeBias = 2.0f;
+		float myConstantBias = 4.0f;
+
+		// What Begin() changes, saved for End()
+		struct PreviousState
+		{
+			std::int32_t framebuffer = 0;
+			std::int32_t viewport[4]{};
+			std::int32_t scissor[4]{};
+			std::int32_t depthFunction = 0;
+			float polygonOffset[2]{};
+			std::uint8_t colourMask[4]{};
+			std::uint8_t depthMask = 0;
+			std::uint8_t depthTesting = 0;
+			std::uint8_t scissoring = 0;
+			std::uint8_t offsetting = 0;
+		};
+
+		PreviousState myPrevious{};
+	};
+
+	/// <summary>
+	/// Cascaded shadow maps of a directional light, each cascade in its own atlas tile
+	/// <para>Update() fits the cascades to the camera, Cull() finds the casters of each cascade in a scene index,</para>
+	/// <para>and Render() draws them through a depth only pipeline. The pipeline should hold no fragment shader.</para>
+	/// </summary>
+	class [[nodiscard]] CascadedShadows
+	{
+	public:
+		/// <summary>
+		/// Binds the buffers of an object and calls Render() of the pipeline
+		/// </summary>
+		using drawer_t = std::move_only_function<void(std::uint32_t object) noexcept>;
+
+		CascadedShadows(std::uint32_t cascades = shadow::MaxCascades, std::uint32_t resolution = 1024, float lambda = 0.75f) noexcept;
+		~CascadedShadows() noexcept;
+
+		/// <summary>
+		/// Take a tile of the resolution for each cascade
+		/// </summary>
+		bool Allocate(ShadowAtlas& atlas);
+		void Release(ShadowAtlas& atlas);
+
+		void SetCasterDistance(float distance) noexcept;
+		/// <param name="view">Column major rigid view matrix of the camera</param>
+		/// <param name="vertical_fov">In radians</param>
+		/// <param name="light_direction">Direction the light travels in world space</param>
+		void Update(const float(&view)[16], float vertical_fov, float aspect, float near_plane, float far_plane, const float(&light_direction)[3]) noexcept;
+
+		/// <summary>
+		/// Query the objects in the frustum of every cascade, the cascades are processed in parallel
+		/// </summary>
+		void Cull(const SceneIndex& scene, std::uint32_t threads = 0);
+		/// <summary>
+		/// Draw the casters of every cascade into its tile
+		/// </summary>
+		/// <param name="matrix_location">Uniform of the pipeline receiving the view-projection of the cascade</param>
+		void Render(ShadowAtlas& atlas, Pipeline& pipeline, std::int32_t matrix_location, drawer_t drawer);
+
+		[[nodiscard]] std::span<const shadow::Cascade> GetCascades() const noexcept;
+		[[nodiscard]] std::span<const float> GetSplits() const noexcept;
+		[[nodiscard]] scene::Frustum GetFrustum(std::uint32_t cascade) const noexcept;
+		[[nodiscard]] std::span<const std::uint32_t> GetCasters(std::uint32_t cascade) const noexcept;
+		[[nodiscard]] const shadow::Statistics& GetStatistics() const noexcept;
+
+		CascadedShadows(const CascadedShadows&) = delete;
+		CascadedShadows(CascadedShadows&&) noexcept = default;
+		CascadedShadows& operator=(const CascadedShadows&) = delete;
+		CascadedShadows& operator=(CascadedShadows&&) noexcept = default;
+
+	private:
+		std::uint32_t myCount;
+		std::uint32_t myResolution;
+		float myLambda;
+		float myCasterDistance = 0;
+		std::uint32_t myAtlasSize = 0;
+
+		std::array<shadow::Tile, shadow::MaxCascades> myTiles{};
+		std::array<shadow::Cascade, shadow::MaxCascades> myCascades{};
+		std::array<float, shadow::MaxCascades + 1> mySplits{};
+		std::vector<std::vector<std::uint32_t>> myCasters{};
+
+		shadow::Statistics myStatistics{};
+	};
+}
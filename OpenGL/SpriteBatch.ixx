@@ -0,0 +1,215 @@
+export module Glib.SpriteBatch;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <array>;
+import <span>;
+import <memory>;
+import <unordered_map>;
+import Glib;
+import Glib.Texture;
+
+export namespace gl
+{
+	namespace sprite
+	{
+		// Sprites in a section of the vertex ring, more sprites in a batch go through several sections
+		inline constexpr std::uint32_t DefaultCapacity = 1U << 16;
+		// Sections of the ring, the GPU may still read the previous ones while the next one is written
+		inline constexpr std::uint32_t DefaultSections = 3;
+
+		/// <summary>
+		/// Order of the sprites of a batch
+		/// </summary>
+		enum class [[nodiscard]] SortMode : std::uint32_t
+		{
+			// Submission order, only the consecutive sprites of the same texture and blending are drawn together
+			Deferred,
+			// Grouped by blending then by texture, for sprites which don't overlap or are opaque
+			Texture,
+		};
+
+		/// <summary>
+		/// Vertex of the stream, the colour is RGBA8 normalized
+		/// </summary>
+		struct [[nodiscard]] Vertex
+		{
+			float x, y;
+			float u, v;
+			std::uint32_t colour;
+		};
+
+		/// <summary>
+		/// Area of the texture, or of an atlas page, in texture coordinates
+		/// </summary>
+		struct [[nodiscard]] Region
+		{
+			float u0 = 0, v0 = 0;
+			float u1 = 1, v1 = 1;
+		};
+
+		struct [[nodiscard]] Sprite
+		{
+			float x = 0, y = 0;
+			float width = 0, height = 0;
+			// Point of the sprite at its position and around which it rotates, as a fraction of its size
+			float originX = 0, originY = 0;
+			// Radians
+			float rotation = 0;
+			Region region{};
+			Colour colour = win32::colors::White;
+		};
+
+		/// <summary>
+		/// Sprites laid out by field, the input of the vertex generation
+		/// </summary>
+		struct [[nodiscard]] Streams
+		{
+			void Append(const Sprite& sprite);
+			void Reserve(std::size_t count);
+			void Clear() noexcept;
+
+			[[nodiscard]] std::size_t GetSize() const noexcept;
+
+			std::vector<float> x{}, y{};
+			// Corners relative to the position, before the rotation
+			std::vector<float> left{}, right{}, top{}, bottom{};
+			std::vector<float> cos{}, sin{};
+			std::vector<float> u0{}, v0{}, u1{}, v1{};
+			std::vector<std::uint32_t> colour{};
+		};
+
+		/// <summary>
+		/// Counts of the last batch, from Begin() to End()
+		/// </summary>
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t sprites = 0;
+			std::uint64_t drawCalls = 0;
+			std::uint64_t textureChanges = 0;
+			std::uint64_t blendChanges = 0;
+			// Sections of the ring written
+			std::uint64_t sections = 0;
+			// Sections the GPU was still reading when they were needed again
+			std::uint64_t stalls = 0;
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			std::size_t sprites = 0;
+			// Sprites turned into vertices per second, in submission order and in a shuffled order
+			double simdPerSecond = 0;
+			double shuffledPerSecond = 0;
+			double scalarPerSecond = 0;
+		};
+
+		/// <summary>
+		/// Projection of a view in pixels, with the origin at the top left and the y axis going down
+		/// </summary>
+		[[nodiscard]] std::array<float, 16> MakeProjection(float width, float height) noexcept;
+
+		/// <summary>
+		/// Region of a texture in pixels
+		/// </summary>
+		[[nodiscard]] Region MakeRegion(const Texture& texture, float x, float y, float width, float height) noexcept;
+
+		/// <summary>
+		/// Write the four corners of every sprite in the order, four sprites at a time
+		/// </summary>
+		/// <param name="destination">Four vertices per sprite of the order</param>
+		void GenerateVertices(const Streams& streams, std::span<const std::uint32_t> order, std::span<Vertex> destination) noexcept;
+		void GenerateVerticesScalar(const Streams& streams, std::span<const std::uint32_t> order, std::span<Vertex> destination) noexcept;
+
+		/// <summary>
+		/// Vertex generation throughput over random rotated sprites, without any graphics call
+		/// </summary>
+		[[nodiscard]]
+		Benchmark MeasureGeneration(std::size_t sprites = 100000, std::uint32_t iterations = 16);
+	}
+
+	/// <summary>
+	/// Batches textured, coloured and rotated quads into one vertex stream for the 2D contents
+	/// <para>Draw() only records the sprite, End() sorts them, generates their vertices straight into a persistently mapped buffer,</para>
+	/// <para>and draws every run of the same texture and blending with one call.</para>
+	/// <para>The buffer is a ring of sections guarded by fences, so writing the next batch doesn't wait for the GPU to read the previous one.</para>
+	/// </summary>
+	class [[nodiscard]] SpriteBatch
+	{
+	public:
+		/// <param name="capacity">Sprites in a section of the ring</param>
+		SpriteBatch(std::uint32_t capacity = sprite::DefaultCapacity, std::uint32_t sections = sprite::DefaultSections);
+		~SpriteBatch() noexcept;
+
+		/// <summary>
+		/// Create the buffers and the shaders, the context has to be current
+		/// </summary>
+		bool Create() noexcept;
+		void Destroy() noexcept;
+
+		void Begin(const std::array<float, 16>& projection, sprite::SortMode mode = sprite::SortMode::Deferred) noexcept;
+		/// <summary>
+		/// Record a sprite, a batch of more than 256 blendings or 65536 textures draws the sprites recorded so far first
+		/// </summary>
+		/// <param name="layer">Layers are drawn in ascending order, whatever the sort mode</param>
+		void Draw(const Texture& texture, const sprite::Sprite& sprite, const BlendMode& blend = DefaultAlpha, std::uint8_t layer = 0);
+		/// <summary>
+		/// Draw the recorded sprites, then bind again the program, the vertex array, the array buffer and the texture of the first unit bound before
+		/// </summary>
+		void End();
+
+		[[nodiscard]] const sprite::Statistics& GetStatistics() const noexcept;
+		[[nodiscard]] std::size_t GetSize() const noexcept;
+		[[nodiscard]] bool IsCreated() const noexcept;
+		[[nodiscard]] bool IsPersistent() const noexcept;
+
+		SpriteBatch(const SpriteBatch&) = delete;
+		SpriteBatch(SpriteBatch&&) = delete;
+		SpriteBatch& operator=(const SpriteBatch&) = delete;
+		SpriteBatch& operator=(SpriteBatch&&) = delete;
+
+	private:
+		/// <summary>
+		/// Draw and forget the recorded sprites
+		/// </summary>
+		void Flush();
+		void Clear() noexcept;
+		[[nodiscard]] bool IsFull(const Texture& texture, const BlendMode& blend) const noexcept;
+		[[nodiscard]] std::uint16_t GetTextureIndex(const Texture& texture);
+		[[nodiscard]] std::uint8_t GetBlendIndex(const BlendMode& blend);
+		[[nodiscard]] sprite::Vertex* MapSection(std::uint32_t section) noexcept;
+		void UnmapSection() noexcept;
+
+		std::uint32_t myCapacity;
+		std::uint32_t mySectionCount;
+		std::uint32_t myNextSection = 0;
+
+		sprite::Streams myStreams{};
+		// Blending index and texture index of every sprite
+		std::vector<std::uint32_t> myStates{};
+		std::vector<std::uint64_t> myKeys{};
+		std::vector<std::uint32_t> myOrder{};
+		std::vector<std::uint64_t> myScratchKeys{};
+		std::vector<std::uint32_t> myScratchIndices{};
+		bool isSorted = true;
+
+		std::vector<const Texture*> myTextures{};
+		std::unordered_map<const Texture*, std::uint16_t> myTextureIndices{};
+		std::vector<BlendMode> myBlendModes{};
+
+		std::array<float, 16> myProjection{};
+		sprite::SortMode mySortMode = sprite::SortMode::Deferred;
+
+		std::unique_ptr<Pipeline> myPipeline{};
+		std::uint32_t myVertexArray = 0;
+		std::uint32_t myVertexBuffer = 0;
+		// Quads of a section, the sections are drawn with a base vertex
+		std::uint32_t myIndexBuffer = 0;
+		// Whole ring when the storage is persistent
+		sprite::Vertex* myMapping = nullptr;
+		// GLsync of each section
+		std::vector<void*> myFences{};
+		bool isPersistent = false;
+
+		sprite::Statistics myStatistics{};
+	};
+}
@@ -4,6 +4,7 @@ import Glib.Rect;
 import Glib.Windows.Definitions;
 import Glib.Windows.IHandle;
 import Glib.Windows.Colour;
+import Glib.Profiler;
 
 export namespace gl
 {
@@ -25,6 +26,8 @@ export namespace gl
 			bool doubleBuffered = true;
 			bool keepAspectRatio = true;
 			bool vSync = false;
+			// Ask for a pixel format which copies the back buffer on swaps, so a frame may redraw only its dirty area
+			bool partialRedraw = false;
 		};
 	}
 
@@ -53,11 +56,20 @@ export namespace gl
 		void UpdateViewPort(int client_hsize, int client_vsize) noexcept;
 
 		void KeepAspectRatio(bool keep_ratio) noexcept;
+		/// <summary>
+		/// Measure every frame between BeginRendering() and EndRendering(), null to stop
+		/// </summary>
+		void SetProfiler(GpuProfiler* profiler) noexcept;
 
 		bool BeginOpenGLContext(win32::IContext& ctx) const noexcept;
 		bool BeginOpenGLContext(win32::IContext&& ctx) const noexcept;
 		bool EndOpenGLContext() const noexcept;
 		bool BeginRendering(win32::IContext& painter) noexcept;
+		/// <summary>
+		/// Clear and draw only inside the dirty rectangle of the client area, when the frame buffer keeps the previous frame
+		/// <para>The whole frame is drawn when the pixel format exchanges its buffers, or when the rectangle is empty.</para>
+		/// </summary>
+		bool BeginRendering(win32::IContext& painter, const Rect& dirty) noexcept;
 		bool EndRendering() noexcept;
 
 		[[nodiscard]] const Rect& ViewPort() const noexcept;
@@ -70,6 +82,8 @@ export namespace gl
 		[[nodiscard]] const int& ViewWidth() const noexcept;
 		[[nodiscard]] const int& ViewHeight() const noexcept;
 		[[nodiscard]] double AspectRatio() const noexcept;
+		[[nodiscard]] GpuProfiler* GetProfiler() const noexcept;
+		[[nodiscard]] bool IsPreservingFrame() const noexcept;
 
 	private:
 		unsigned long _InitializeSystem() noexcept;
@@ -77,11 +91,15 @@ export namespace gl
 		system::Descriptor mySettings{};
 
 		int clientWidth = 0, clientHeight = 0;
+		// Whether the back buffer still holds the previous frame after a swap
+		bool isPreservingFrame = false;
+		bool isScissoring = false;
 		double aspectRatio = 1.0;
 
 		Painter myPainter = nullptr;
 		win32::IContext* nativeContext = nullptr;
 		const Blender* myBlender = nullptr;
+		GpuProfiler* myProfiler = nullptr;
 	};
 
 	[[nodiscard]]
@@ -0,0 +1,113 @@
+export module Glib.TextBatch;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <array>;
+import <string>;
+import <string_view>;
+import <memory>;
+import Glib;
+import Glib.Font;
+import Glib.SpriteBatch;
+
+export namespace gl
+{
+	namespace text
+	{
+		/// <summary>
+		/// Counts of the last batch
+		/// </summary>
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t texts = 0;
+			std::uint64_t glyphs = 0;
+			std::uint64_t drawCalls = 0;
+			// Bytes of the atlas sent to the texture
+			std::uint64_t uploadedBytes = 0;
+			// Times the atlas started over while the vertices were generated, which generates them again
+			std::uint64_t rebuilds = 0;
+		};
+
+		struct [[nodiscard]] Extent
+		{
+			float width = 0, height = 0;
+		};
+
+		/// <summary>
+		/// Append four vertices for every visible glyph of a run, from the top left corner of the text
+		/// </summary>
+		/// <param name="size">Pixels per em</param>
+		/// <returns>Number of quads appended</returns>
+		std::size_t GenerateQuads(const FontAtlas& atlas, const font::ShapedRun& run, float x, float y, float size, std::uint32_t colour, std::vector<sprite::Vertex>& output);
+	}
+
+	/// <summary>
+	/// Draws the texts of a frame from a signed distance field atlas with one draw call
+	/// <para>Draw() only records the text, End() shapes the texts through the run cache of the atlas, uploads the area of the atlas the new glyphs were written to,</para>
+	/// <para>and draws every glyph quad at once. The edges stay sharp at any size, the fragment shader smooths them over a pixel of the screen.</para>
+	/// </summary>
+	class [[nodiscard]] TextBatch
+	{
+	public:
+		explicit TextBatch(FontAtlas& atlas) noexcept;
+		~TextBatch() noexcept;
+
+		/// <summary>
+		/// Create the texture of the atlas, the buffers and the shaders, the context has to be current
+		/// </summary>
+		bool Create() noexcept;
+		void Destroy() noexcept;
+
+		void Begin(const std::array<float, 16>& projection) noexcept;
+		/// <param name="x">Left of the text</param>
+		/// <param name="y">Top of the first line</param>
+		/// <param name="size">Pixels per em</param>
+		void Draw(std::string_view text, float x, float y, float size, const Colour& colour = win32::colors::White);
+		/// <summary>
+		/// Draw the recorded texts, the program, the vertex array and the texture are unbound afterwards
+		/// </summary>
+		void End();
+
+		/// <summary>
+		/// Size of a text drawn at a size, without drawing it
+		/// </summary>
+		[[nodiscard]] text::Extent Measure(std::string_view text, float size);
+
+		[[nodiscard]] FontAtlas& GetAtlas() const noexcept;
+		[[nodiscard]] const text::Statistics& GetStatistics() const noexcept;
+		[[nodiscard]] bool IsCreated() const noexcept;
+
+		TextBatch(const TextBatch&) = delete;
+		TextBatch(TextBatch&&) = delete;
+		TextBatch& operator=(const TextBatch&) = delete;
+		TextBatch& operator=(TextBatch&&) = delete;
+
+	private:
+		struct Request
+		{
+			// Part of the recorded characters
+			std::size_t offset, length;
+			float x, y, size;
+			std::uint32_t colour;
+		};
+
+		void Reserve(std::size_t quads) noexcept;
+
+		FontAtlas* myAtlas;
+
+		std::string myCharacters{};
+		std::vector<Request> myRequests{};
+		std::vector<sprite::Vertex> myVertices{};
+		std::array<float, 16> myProjection{};
+
+		std::unique_ptr<Pipeline> myPipeline{};
+		std::uint32_t myVertexArray = 0;
+		std::uint32_t myVertexBuffer = 0;
+		std::uint32_t myIndexBuffer = 0;
+		// Quads the buffers hold
+		std::size_t myCapacity = 0;
+		std::uint32_t myTexture = 0;
+
+		text::Statistics myStatistics{};
+	};
+}
@@ -4,6 +4,7 @@ import <string_view>;
 import <filesystem>;
 import <memory>;
 import Glib;
+import Glib.ResourceTracker;
 export import Glib.Image;
 
 export namespace gl
@@ -53,9 +54,30 @@ export namespace gl
 
 		struct [[nodiscard]] Blob : public std::enable_shared_from_this<Blob>
 		{
-			constexpr void swap(Blob& other) noexcept
+			Blob() noexcept = default;
+			/// <summary>
+			/// Reports the destruction to the resource tracker and deletes the opengl texture
+			/// </summary>
+			~Blob() noexcept;
+
+			/// <summary>
+			/// The registration follows the contents, its anchor is pointed at the blob holding them now
+			/// </summary>
+			void swap(Blob& other) noexcept
 			{
 				imgBuffer.swap(other.imgBuffer);
+				std::swap(textureID, other.textureID);
+				std::swap(residencyHandle, other.residencyHandle);
+				residencyAnchor.swap(other.residencyAnchor);
+				if (residencyAnchor)
+				{
+					*residencyAnchor = this;
+				}
+				if (other.residencyAnchor)
+				{
+					*other.residencyAnchor = std::addressof(other);
+				}
+
 				std::swap(width, other.width);
 				std::swap(height, other.height);
 				std::swap(texType, other.texType);
@@ -72,6 +94,12 @@ export namespace gl
 			texture::WrapMode vWrap = DefaultTexVWrap;
 			texture::FilterMode minFilter = DefaultTexMinFt;
 			texture::FilterMode magFilter = DefaultTexMaxFt;
+			// Name of the opengl texture, shared by every copy of the texture
+			std::uint32_t textureID = 0;
+			// Given by the resource tracker which was installed when the pixels were loaded
+			residency::handle_t residencyHandle = residency::InvalidHandle;
+			// The callbacks given to the tracker reach the blob through it, null once the blob is gone
+			std::shared_ptr<Blob*> residencyAnchor = nullptr;
 		};
 	}
 
@@ -91,6 +119,7 @@ export namespace gl
 		[[nodiscard]] Texture Copy() const;
 		bool TryCopy(Texture& output) const;
 		void Destroy() noexcept;
+		void ReleaseCpuCopy() noexcept;
 
 		[[nodiscard]] texture::Type GetType() const noexcept;
 		[[nodiscard]] texture::WrapMode GetHorizontalWrapMode() const noexcept;
@@ -101,6 +130,7 @@ export namespace gl
 		[[nodiscard]] std::size_t GetHeight() const noexcept;
 
 		[[nodiscard]] bool IsEmpty() const noexcept;
+		[[nodiscard]] bool HasCpuCopy() const noexcept;
 
 		Texture(Texture&&) noexcept = default;
 		Texture& operator=(Texture&&) noexcept = default;
@@ -0,0 +1,292 @@
+export module Glib.VectorGraphics;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <array>;
+import <span>;
+import <memory>;
+import <unordered_map>;
+import Glib;
+import Glib.Windows.Resource.Pen;
+import Glib.Windows.Resource.Brush;
+import Glib.Windows.Resource.Brush.Component;
+
+export namespace gl
+{
+	namespace vector
+	{
+		// Largest distance of the flattened curves and arcs from the real ones, in pixels
+		inline constexpr float DefaultTolerance = 0.25f;
+		// Frames a tessellated path stays cached without being drawn
+		inline constexpr std::uint32_t DefaultCacheLifetime = 120;
+
+		enum class [[nodiscard]] LineJoin : std::uint32_t
+		{
+			Miter,
+			Bevel,
+			Round,
+		};
+
+		enum class [[nodiscard]] LineCap : std::uint32_t
+		{
+			Butt,
+			// Extended by half of the width
+			Square,
+			Round,
+		};
+
+		/// <summary>
+		/// Dash patterns of the pen styles, scaled by the width
+		/// </summary>
+		enum class [[nodiscard]] DashStyle : std::uint32_t
+		{
+			Solid,
+			Dash,
+			Dots,
+			DashDot,
+		};
+
+		struct [[nodiscard]] Point
+		{
+			float x, y;
+		};
+
+		struct [[nodiscard]] Stroke
+		{
+			float width = 1;
+			Colour colour = win32::colors::Black;
+			LineJoin join = LineJoin::Miter;
+			LineCap cap = LineCap::Butt;
+			DashStyle dash = DashStyle::Solid;
+			// Longest miter as a multiple of the half width, sharper joins are bevelled
+			float miterLimit = 4;
+		};
+
+		/// <summary>
+		/// Vertex of the stream, the colour is RGBA8 normalized
+		/// </summary>
+		struct [[nodiscard]] Vertex
+		{
+			float x, y;
+			std::uint32_t colour;
+		};
+
+		/// <summary>
+		/// Triangles of a tessellated path, without colour
+		/// </summary>
+		struct [[nodiscard]] Mesh
+		{
+			void Clear() noexcept;
+
+			std::vector<Point> positions{};
+			std::vector<std::uint32_t> indices{};
+		};
+
+		/// <summary>
+		/// Contours of line segments, the curves and arcs are flattened as they are added
+		/// </summary>
+		class [[nodiscard]] Path
+		{
+		public:
+			Path& MoveTo(float x, float y);
+			Path& LineTo(float x, float y);
+			Path& QuadraticTo(float control_x, float control_y, float x, float y);
+			/// <summary>
+			/// Join the last point of the contour to its first one
+			/// </summary>
+			Path& Close() noexcept;
+
+			Path& AddRect(float x, float y, float width, float height);
+			Path& AddRoundedRect(float x, float y, float width, float height, float radius);
+			Path& AddCircle(float center_x, float center_y, float radius);
+			Path& AddEllipse(float center_x, float center_y, float radius_x, float radius_y);
+
+			void Clear() noexcept;
+
+			/// <summary>
+			/// Hash of the shape relative to its first point, so a moved path still hits the cache
+			/// </summary>
+			[[nodiscard]] std::uint64_t GetHash() const noexcept;
+			[[nodiscard]] Point GetOrigin() const noexcept;
+			[[nodiscard]] bool IsEmpty() const noexcept;
+
+			[[nodiscard]] std::span<const Point> GetPoints() const noexcept;
+			// One past the last point of every contour
+			[[nodiscard]] std::span<const std::uint32_t> GetContourEnds() const noexcept;
+			[[nodiscard]] bool IsClosed(std::size_t contour) const noexcept;
+
+		private:
+			void AddArc(float center_x, float center_y, float radius_x, float radius_y, float begin, float end);
+
+			std::vector<Point> myPoints{};
+			std::vector<std::uint32_t> myContourEnds{};
+			std::vector<bool> myClosedContours{};
+			bool isOpen = false;
+		};
+
+		/// <summary>
+		/// Fill every contour of the path on its own, by ear clipping, holes are not cut out
+		/// </summary>
+		void TessellateFill(const Path& path, Mesh& output);
+		/// <summary>
+		/// Outline the contours of the path with the width, joins, caps and dashes of the stroke
+		/// </summary>
+		void TessellateStroke(const Path& path, const Stroke& stroke, Mesh& output);
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t paths = 0;
+			std::uint64_t cacheHits = 0;
+			std::uint64_t cacheMisses = 0;
+			std::uint64_t evicted = 0;
+			std::uint64_t vertices = 0;
+			std::uint64_t indices = 0;
+			std::uint64_t drawCalls = 0;
+		};
+
+		/// <summary>
+		/// Meshes of the paths drawn recently, relative to their origin and keyed by their shape and stroke
+		/// </summary>
+		class [[nodiscard]] TessellationCache
+		{
+		public:
+			/// <summary>
+			/// Drop the meshes unused for too long
+			/// </summary>
+			/// <returns>Number of meshes dropped</returns>
+			std::size_t BeginFrame() noexcept;
+
+			/// <param name="hit">Whether the mesh came from the cache</param>
+			const Mesh& GetFill(const Path& path, bool& hit);
+			const Mesh& GetStroke(const Path& path, const Stroke& stroke, bool& hit);
+
+			void Clear() noexcept;
+			[[nodiscard]] std::size_t GetSize() const noexcept;
+
+		private:
+			/// <summary>
+			/// What a mesh was tessellated from, compared on a hit as different shapes may share a hash
+			/// </summary>
+			struct Shape
+			{
+				[[nodiscard]] bool operator==(const Shape&) const noexcept = default;
+
+				// Relative to the origin, in 256ths of a pixel
+				std::vector<std::int32_t> points{};
+				// One past the last point of every contour, shifted left with the closing in the lowest bit
+				std::vector<std::uint32_t> contours{};
+				bool isStroke = false;
+				float width = 0, miterLimit = 0;
+				LineJoin join = LineJoin::Miter;
+				LineCap cap = LineCap::Butt;
+				DashStyle dash = DashStyle::Solid;
+			};
+
+			struct Entry
+			{
+				Mesh mesh{};
+				Shape shape{};
+				std::uint64_t lastFrame = 0;
+			};
+
+			/// <summary>
+			/// The entry of the shape, emptied when the one under its hash was another
+			/// </summary>
+			Entry& Find(const Shape& shape, bool& hit);
+
+			std::unordered_map<std::uint64_t, Entry> myEntries{};
+			// Reused by every lookup
+			Shape myShape{};
+			std::uint64_t myFrame = 0;
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			std::size_t paths = 0;
+			std::size_t vertices = 0;
+			// Paths tessellated per second, then paths found in the cache per second
+			double tessellatedPerSecond = 0;
+			double cachedPerSecond = 0;
+		};
+
+		/// <summary>
+		/// Tessellation throughput over random polylines, rounded rectangles and circles, without any graphics call
+		/// </summary>
+		[[nodiscard]]
+		Benchmark MeasureTessellation(std::size_t paths = 1000, std::uint32_t iterations = 8);
+
+		/// <summary>
+		/// The stroke a GDI pen would draw, a null pen has no width
+		/// </summary>
+		[[nodiscard]] Stroke MakeStroke(const win32::resource::Pen& pen) noexcept;
+		/// <summary>
+		/// The colour of a solid or hatched brush
+		/// </summary>
+		[[nodiscard]] Colour GetBrushColour(const win32::resource::ColorBrush& brush) noexcept;
+		[[nodiscard]] Colour GetComponentColour(win32::ColoredComponent component) noexcept;
+	}
+
+	/// <summary>
+	/// Draws lines, polygons, rounded rectangles and circles in 2D through one vertex stream
+	/// <para>The paths are tessellated on the CPU relative to their first point and cached by their shape,</para>
+	/// <para>so the shapes which only move between frames are tessellated once. End() draws every triangle with one call.</para>
+	/// </summary>
+	class [[nodiscard]] VectorRenderer
+	{
+	public:
+		VectorRenderer() noexcept = default;
+		~VectorRenderer() noexcept;
+
+		/// <summary>
+		/// Create the buffers and the shaders, the context has to be current
+		/// </summary>
+		bool Create() noexcept;
+		void Destroy() noexcept;
+
+		void Begin(const std::array<float, 16>& projection) noexcept;
+		void Fill(const vector::Path& path, const Colour& colour);
+		void Draw(const vector::Path& path, const vector::Stroke& stroke);
+
+		void DrawLine(float x0, float y0, float x1, float y1, const vector::Stroke& stroke);
+		void DrawPolyline(std::span<const vector::Point> points, bool closed, const vector::Stroke& stroke);
+		void FillPolygon(std::span<const vector::Point> points, const Colour& colour);
+		void DrawRect(float x, float y, float width, float height, const vector::Stroke& stroke);
+		void FillRect(float x, float y, float width, float height, const Colour& colour);
+		void DrawRoundedRect(float x, float y, float width, float height, float radius, const vector::Stroke& stroke);
+		void FillRoundedRect(float x, float y, float width, float height, float radius, const Colour& colour);
+		void DrawCircle(float center_x, float center_y, float radius, const vector::Stroke& stroke);
+		void FillCircle(float center_x, float center_y, float radius, const Colour& colour);
+
+		/// <summary>
+		/// Draw the recorded triangles, then bind again the program, the vertex array and the array buffer bound before
+		/// <para>The joins of a stroke meet its segments without overlapping, so a translucent pen blends once,</para>
+		/// <para>but the parts of a path crossing itself or turning back within its width still blend twice.</para>
+		/// </summary>
+		void End();
+
+		[[nodiscard]] const vector::Statistics& GetStatistics() const noexcept;
+		[[nodiscard]] bool IsCreated() const noexcept;
+
+		VectorRenderer(const VectorRenderer&) = delete;
+		VectorRenderer(VectorRenderer&&) = delete;
+		VectorRenderer& operator=(const VectorRenderer&) = delete;
+		VectorRenderer& operator=(VectorRenderer&&) = delete;
+
+	private:
+		void Append(const vector::Mesh& mesh, const vector::Point& origin, const Colour& colour);
+
+		vector::TessellationCache myCache{};
+		vector::Path myScratchPath{};
+
+		std::vector<vector::Vertex> myVertices{};
+		std::vector<std::uint32_t> myIndices{};
+		std::array<float, 16> myProjection{};
+
+		std::unique_ptr<Pipeline> myPipeline{};
+		std::uint32_t myVertexArray = 0;
+		std::uint32_t myVertexBuffer = 0;
+		std::uint32_t myIndexBuffer = 0;
+
+		vector::Statistics myStatistics{};
+	};
+}
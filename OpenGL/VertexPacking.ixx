@@ -0,0 +1,54 @@
+export module Glib.VertexPacking;
+import <cstdint>;
+import <cstddef>;
+import <span>;
+import <array>;
+import Glib;
+
+export namespace gl::vertex
+{
+	struct [[nodiscard]] Benchmark
+	{
+		std::size_t values = 0;
+		// Floats converted per second
+		double halfPerSecond = 0;
+		double scalarHalfPerSecond = 0;
+		// Vectors packed per second
+		double snormPerSecond = 0;
+		double octahedralPerSecond = 0;
+	};
+
+	/// <summary>
+	/// Convert floats to half floats, rounded to the nearest even, out of range values become infinities
+	/// </summary>
+	void PackHalf(std::span<const float> source, std::span<Half> destination) noexcept;
+	void UnpackHalf(std::span<const Half> source, std::span<float> destination) noexcept;
+
+	/// <summary>
+	/// Pack vectors of the given number of components, the missing ones are zero
+	/// </summary>
+	/// <param name="components">Three or four floats per vector in the source, clamped to [-1, 1]</param>
+	void PackSnorm(std::span<const float> source, std::span<PackedSnorm> destination, std::uint32_t components = 4) noexcept;
+	/// <param name="components">Three or four floats per vector in the source, clamped to [0, 1]</param>
+	void PackUnorm(std::span<const float> source, std::span<PackedUnorm> destination, std::uint32_t components = 4) noexcept;
+
+	/// <summary>
+	/// Encode normals of three floats each, they don't have to be normalized
+	/// </summary>
+	void PackOctahedral(std::span<const float> normals, std::span<Octahedral> destination) noexcept;
+
+	[[nodiscard]] Half ToHalf(float value) noexcept;
+	[[nodiscard]] float FromHalf(Half value) noexcept;
+	[[nodiscard]] std::array<float, 4> Unpack(PackedSnorm value) noexcept;
+	[[nodiscard]] std::array<float, 4> Unpack(PackedUnorm value) noexcept;
+	/// <summary>
+	/// Decode to a unit vector
+	/// </summary>
+	[[nodiscard]] std::array<float, 3> Unpack(Octahedral value) noexcept;
+
+	/// <summary>
+	/// Packing throughput over random vertex data, the half conversion is also measured without SIMD
+	/// </summary>
+	[[nodiscard]]
+	Benchmark MeasurePacking(std::size_t values = 1 << 20, std::uint32_t iterations = 8);
+}
@@ -0,0 +1,161 @@
+export module Glib.Visibility;
+import <cstdint>;
+import <cstddef>;
+import <vector>;
+import <array>;
+import <span>;
+import <optional>;
+import Glib;
+import Glib.Rasterizer;
+
+export namespace gl
+{
+	namespace visibility
+	{
+		// Objects are tested against the frustum this many at a time
+		inline constexpr std::size_t BatchSize = 8;
+
+		struct [[nodiscard]] BoundingSphere
+		{
+			float x, y, z;
+			float radius;
+		};
+
+		struct [[nodiscard]] BoundingBox
+		{
+			float min[3];
+			float max[3];
+		};
+
+		/// <summary>
+		/// Normalized planes (a, b, c, d) of a view volume, a point is inside when ax + by + cz + d is not negative
+		/// </summary>
+		struct [[nodiscard]] Frustum
+		{
+			std::array<std::array<float, 4>, 6> planes;
+
+			/// <summary>
+			/// Extract the left, right, bottom, top, near and far planes of a column major view-projection matrix
+			/// </summary>
+			[[nodiscard]]
+			static Frustum FromMatrix(const float(&matrix)[16]) noexcept;
+		};
+
+		struct [[nodiscard]] Statistics
+		{
+			std::uint64_t submitted = 0;
+			std::uint64_t frustumCulled = 0;
+			std::uint64_t occlusionCulled = 0;
+			std::uint64_t visible = 0;
+		};
+
+		struct [[nodiscard]] Benchmark
+		{
+			std::size_t objects = 0;
+			// Frustum tests per second of the batched and of the one by one paths
+			double batchedPerSecond = 0;
+			double scalarPerSecond = 0;
+		};
+
+		/// <summary>
+		/// Frustum test throughput over a random scene of spheres and boxes, roughly half of which are outside
+		/// </summary>
+		[[nodiscard]]
+		Benchmark MeasureCulling(std::size_t objects, std::uint32_t iterations = 16);
+	}
+
+	/// <summary>
+	/// CPU visibility stage ahead of Pipeline::Render
+	/// <para>Submit the bounds of every object each frame, Cull() rejects the ones outside of the view frustum,</para>
+	/// <para>and with occlusion enabled, the ones behind the occluders drawn into a small software depth buffer.</para>
+	/// <para>Render() then draws the survivors in submission order.</para>
+	/// </summary>
+	class [[nodiscard]] VisibilityStage
+	{
+	public:
+		using renderer_t = Pipeline::renderer_t;
+
+		VisibilityStage() noexcept;
+		~VisibilityStage() noexcept;
+
+		/// <summary>
+		/// Drop the objects, occluders and statistics of the previous frame
+		/// </summary>
+		void Clear() noexcept;
+
+		/// <summary>
+		/// Column major view-projection matrix of the frame, the bounds are given in the same space it transforms from
+		/// </summary>
+		void SetViewProjection(const float(&matrix)[16]) noexcept;
+
+		/// <summary>
+		/// Enable the hierarchical depth test with an occlusion buffer of the given size, a few hundred pixels wide is enough
+		/// </summary>
+		void EnableOcclusion(std::uint32_t width, std::uint32_t height, std::uint32_t threads = 1);
+		void DisableOcclusion() noexcept;
+		[[nodiscard]] bool IsOccluding() const noexcept;
+
+		/// <summary>
+		/// Draw an occluder mesh into the occlusion buffer with the current view-projection
+		/// </summary>
+		bool AddOccluder(const raster::VertexInput& input);
+		bool AddOccluder(const visibility::BoundingBox& box);
+
+		/// <summary>
+		/// Queue an object, the renderer binds its buffers before pipeline.Render(primitive, count) is called
+		/// </summary>
+		/// <returns>Index of the object in this frame</returns>
+		std::uint32_t Submit(const visibility::BoundingSphere& bounds, Primitive primitive, std::uint32_t vertices_count, renderer_t&& renderer = {});
+		std::uint32_t Submit(const visibility::BoundingBox& bounds, Primitive primitive, std::uint32_t vertices_count, renderer_t&& renderer = {});
+
+		/// <summary>
+		/// Test every submitted object, the statistics of the frame are available afterwards
+		/// </summary>
+		void Cull();
+		/// <summary>
+		/// Emit the survivors of the last Cull() to the pipeline
+		/// </summary>
+		void Render(const Pipeline& pipeline);
+
+		/// <summary>
+		/// Indices of the objects which survived the last Cull()
+		/// </summary>
+		[[nodiscard]] std::span<const std::uint32_t> GetVisible() const noexcept;
+		[[nodiscard]] const visibility::Statistics& GetStatistics() const noexcept;
+		[[nodiscard]] const visibility::Frustum& GetFrustum() const noexcept;
+
+		VisibilityStage(const VisibilityStage&) = delete;
+		VisibilityStage(VisibilityStage&&) noexcept = default;
+		VisibilityStage& operator=(const VisibilityStage&) = delete;
+		VisibilityStage& operator=(VisibilityStage&&) noexcept = default;
+
+	private:
+		struct Drawable
+		{
+			Primitive primitive;
+			std::uint32_t count;
+			renderer_t renderer;
+		};
+
+		std::uint32_t Append(float cx, float cy, float cz, float ex, float ey, float ez, float radius, Primitive primitive, std::uint32_t vertices_count, renderer_t&& renderer);
+		void BuildHierarchy();
+		[[nodiscard]] bool IsOccluded(std::size_t index) const noexcept;
+
+		std::array<float, 16> myViewProjection{};
+		visibility::Frustum myFrustum{};
+
+		// Bounds in structure of arrays, padded to the batch size. A sphere has no extents, a box has no radius
+		std::vector<float> myCentreX{}, myCentreY{}, myCentreZ{};
+		std::vector<float> myExtentX{}, myExtentY{}, myExtentZ{};
+		std::vector<float> myRadius{};
+		std::vector<Drawable> myDrawables{};
+		std::vector<std::uint32_t> myVisible{};
+
+		std::optional<SoftwareRasterizer> myOccluder{};
+		// Farthest depth of each texel, the first level is the occlusion buffer itself
+		std::vector<std::vector<float>> myHierarchy{};
+		std::vector<std::array<std::uint32_t, 2>> myLevelSizes{};
+
+		visibility::Statistics myStatistics{};
+	};
+}
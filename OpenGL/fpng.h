@@ -22,11 +22,32 @@ namespace fpng
 	// fpng_init() must have been called first, or it'll assert and return false.
 	bool fpng_cpu_supports_sse41();
 
-	// Fast CRC-32 SSE4.1+pclmul or a scalar fallback (slice by 4)
+	// ---- Instruction sets of the CRC-32, Adler-32 and filtering kernels, picked at runtime.
+	enum
+	{
+		FPNG_ISA_SCALAR = 0,
+		FPNG_ISA_SSE41,		// SSE 4.1, plus pclmul for CRC-32
+		FPNG_ISA_AVX2,		// plus 256-bit VPCLMULQDQ for CRC-32 when available
+		FPNG_ISA_AVX512,	// AVX-512 F/BW, plus 512-bit VPCLMULQDQ for CRC-32 when available
+	};
+
+	// Returns the widest instruction set the CPU and the OS support. fpng_init() must have been called first.
+	uint32_t fpng_cpu_best_isa();
+
+	// Returns the instruction set the calling thread uses, the best one capped by fpng_set_max_isa().
+	uint32_t fpng_get_isa();
+
+	// Caps the instruction set of the calling thread, to compare the kernels on the same machine. Returns the previous cap.
+	// The other threads keep theirs, and fpng_encode_image_to_memory_parallel() gives its workers the cap of its caller.
+	uint32_t fpng_set_max_isa(uint32_t isa);
+
+	const char* fpng_isa_name(uint32_t isa);
+
+	// Fast CRC-32 AVX-512/AVX2 VPCLMULQDQ, SSE4.1+pclmul or a scalar fallback (slice by 4)
 	const uint32_t FPNG_CRC32_INIT = 0;
 	uint32_t fpng_crc32(const void* pData, size_t size, uint32_t prev_crc32 = FPNG_CRC32_INIT);
 
-	// Fast Adler32 SSE4.1 Adler-32 with a scalar fallback.
+	// Fast Adler32 AVX-512/AVX2/SSE4.1 Adler-32 with a scalar fallback.
 	const uint32_t FPNG_ADLER32_INIT = 1;
 	uint32_t fpng_adler32(const void* pData, size_t size, uint32_t adler = FPNG_ADLER32_INIT);
 
@@ -47,6 +68,11 @@ namespace fpng
 	// num_chans must be 3 or 4. 
 	bool fpng_encode_image_to_memory(const void* pImage, size_t w, size_t h, size_t num_chans, std::vector<uint8_t>& out_buf, uint32_t flags = 0);
 
+	// Parallel PNG encoding. The image is split into stripes of rows which are compressed on num_threads threads (0 = hardware concurrency)
+	// and stitched into a single Deflate block, so the result is still decodable by fpng_decode_memory().
+	// Always uses the fast single pass tables; falls back to fpng_encode_image_to_memory() for tiny images.
+	bool fpng_encode_image_to_memory_parallel(const void* pImage, size_t w, size_t h, size_t num_chans, std::vector<uint8_t>& out_buf, uint32_t num_threads = 0);
+
 #ifndef FPNG_NO_STDIO
 	// Fast PNG encoding to the specified file.
 	bool fpng_encode_image_to_file(const char* pFilename, const void* pImage, uint32_t w, uint32_t h, uint32_t num_chans, uint32_t flags = 0);
@@ -73,7 +99,10 @@ namespace fpng
 		FPNG_DECODE_FILE_OPEN_FAILED,
 		FPNG_DECODE_FILE_TOO_LARGE,
 		FPNG_DECODE_FILE_READ_FAILED,
-		FPNG_DECODE_FILE_SEEK_FAILED
+		FPNG_DECODE_FILE_SEEK_FAILED,
+
+		// fpng_decode_stream() specific errors
+		FPNG_DECODE_ABORTED						// the row callback returned false
 	};
 
 	// Fast PNG decoding of files ONLY created by fpng_encode_image_to_memory() or fpng_encode_image_to_file().
@@ -111,6 +140,27 @@ namespace fpng
 	int fpng_decode_file(const char* pFilename, std::vector<uint8_t>& out, size_t& width, size_t& height, size_t& channels_in_file, size_t desired_channels);
 #endif
 
+	// ---- Streaming decompression
+	// Reads up to size bytes of the PNG file into pDst. Returns the number of bytes read, or 0 at the end of the data or on failure.
+	typedef size_t (*fpng_read_func)(void* pUser, void* pDst, size_t size);
+
+	// Receives the decoded rows from top to bottom. pRow holds width * channels bytes and is only valid during the call.
+	// Return false to stop decoding.
+	typedef bool (*fpng_row_func)(void* pUser, const uint8_t* pRow, size_t y, size_t width, size_t height, size_t channels);
+
+	// fpng_decode_stream() decompresses the same files as fpng_decode_memory(), but pulls the file through pRead in small pieces
+	// and hands every row to pRow as soon as it is reconstructed.
+	// Besides a 64KB (or two worst case scanlines) IDAT window, only the previous and the current scanlines are kept in memory.
+	// Rows which were already passed to pRow stay valid when decoding fails later on.
+	int fpng_decode_stream(fpng_read_func pRead, void* pRead_user, fpng_row_func pRow, void* pRow_user, size_t& width, size_t& height, size_t& channels_in_file, size_t desired_channels);
+
+	// Streams the rows of a PNG file which is already in memory, e.g. a mapped file or a pack entry.
+	int fpng_decode_memory_rows(const void* pImage, size_t image_size, fpng_row_func pRow, void* pRow_user, size_t& width, size_t& height, size_t& channels_in_file, size_t desired_channels);
+
+#ifndef FPNG_NO_STDIO
+	int fpng_decode_file_rows(const char* pFilename, fpng_row_func pRow, void* pRow_user, size_t& width, size_t& height, size_t& channels_in_file, size_t desired_channels);
+#endif
+
 	// ---- Internal API used for Huffman table training purposes
 
 #if FPNG_TRAIN_HUFFMAN_TABLES
@@ -64,6 +64,7 @@ noexcept
 
 	if (BlendOption::Invalid != prevMove.dstOption)
 	{
+		global::NotifyStateChange();
 		::glBlendFunc(static_cast<GLenum>(prevMove.srcOption), static_cast<GLenum>(prevMove.dstOption));
 	}
 }
@@ -5,6 +5,7 @@ module;
 
 module Glib;
 import <tuple>;
+import Glib.ResourceTracker;
 import :BufferObject;
 
 gl::BufferObject::~BufferObject()
@@ -59,11 +60,35 @@ noexcept
 
 	mySize = size;
 	myUsage = usage;
+
+	if (gl::residency::Tracker* const tracker = gl::residency::GetTracker(); nullptr != tracker)
+	{
+		try
+		{
+			// Filled from the data of the caller, which is not kept, so it is never evicted
+			myResidency = tracker->OnCreate(gl::residency::ResourceKind::Buffer, myID, size, 1, 0, nullptr, nullptr);
+		}
+		catch (...)
+		{
+			// Left untracked
+			myResidency = gl::residency::InvalidHandle;
+		}
+	}
 }
 
 void
 gl::detail::BufferImplement::Destroy()
 {
+	if (gl::residency::InvalidHandle != myResidency)
+	{
+		if (gl::residency::Tracker* const tracker = gl::residency::GetTracker(); nullptr != tracker)
+		{
+			tracker->OnDestroy(myResidency);
+		}
+
+		myResidency = gl::residency::InvalidHandle;
+	}
+
 	::glDeleteBuffers(1, std::addressof(myID));
 }
 
@@ -76,6 +101,14 @@ noexcept
 	::glBufferSubData(binder.bftype, offset, size, src_data);
 
 	mySize = size;
+
+	if (gl::residency::InvalidHandle != myResidency)
+	{
+		if (gl::residency::Tracker* const tracker = gl::residency::GetTracker(); nullptr != tracker)
+		{
+			tracker->OnUpload(myResidency);
+		}
+	}
 }
 
 void
@@ -96,6 +129,14 @@ gl::detail::BufferImplement::Bind()
 const noexcept
 {
 	::glBindBuffer(static_cast<GLenum>(myType), myID);
+
+	if (gl::residency::InvalidHandle != myResidency)
+	{
+		if (gl::residency::Tracker* const tracker = gl::residency::GetTracker(); nullptr != tracker)
+		{
+			tracker->OnUse(myResidency);
+		}
+	}
 }
 
 void
@@ -124,11 +165,4 @@ const noexcept
 
 		index++;
 	}
-
-	for (; 0 <= index; --index)
-	{
-		::glDisableVertexAttribArray(index);
-	}
-
-	Unbind();
 }
@@ -0,0 +1,1468 @@
+module Glib.Font;
+import <algorithm>;
+import <utility>;
+import <cmath>;
+import <fstream>;
+import <iterator>;
+import <optional>;
+import <chrono>;
+import Glib.Parallel;
+
+namespace
+{
+	constexpr std::uint32_t MakeTag(const char(&name)[5]) noexcept
+	{
+		return static_cast<std::uint32_t>(name[0]) << 24 | static_cast<std::uint32_t>(name[1]) << 16
+			| static_cast<std::uint32_t>(name[2]) << 8 | static_cast<std::uint32_t>(name[3]);
+	}
+
+	// Composite glyphs deeper than it are malformed or malicious
+	constexpr std::uint32_t MaxCompositeDepth = 8;
+	// Segments a curve is flattened into at most
+	constexpr std::uint32_t MaxCurveSegments = 32;
+	// Largest distance of the flattened curves from the real ones, in pixels
+	constexpr float FlatteningTolerance = 0.25f;
+	constexpr char32_t ReplacementCharacter = 0xFFFD;
+	// Spaces a tabulation advances by
+	constexpr float TabulationWidth = 4;
+	// Glyph indices are 16 bits, so no glyph has this one
+	constexpr std::uint32_t NoGlyph = 0xFFFFFFFFU;
+
+	/// <summary>
+	/// Big endian reads, zero when out of the bytes
+	/// </summary>
+	class Reader
+	{
+	public:
+		explicit Reader(std::span<const std::uint8_t> bytes) noexcept
+			: myBytes(bytes)
+		{}
+
+		[[nodiscard]]
+		std::uint8_t
+		U8(std::size_t offset)
+		const noexcept
+		{
+			return offset < myBytes.size() ? myBytes[offset] : 0;
+		}
+
+		[[nodiscard]]
+		std::uint16_t
+		U16(std::size_t offset)
+		const noexcept
+		{
+			if (myBytes.size() < 2 || myBytes.size() - 2 < offset)
+			{
+				return 0;
+			}
+
+			return static_cast<std::uint16_t>(myBytes[offset] << 8 | myBytes[offset + 1]);
+		}
+
+		[[nodiscard]]
+		std::int16_t
+		I16(std::size_t offset)
+		const noexcept
+		{
+			return static_cast<std::int16_t>(U16(offset));
+		}
+
+		[[nodiscard]]
+		std::uint32_t
+		U32(std::size_t offset)
+		const noexcept
+		{
+			return static_cast<std::uint32_t>(U16(offset)) << 16 | U16(offset + 2);
+		}
+
+		[[nodiscard]]
+		bool
+		Has(std::size_t offset, std::size_t size)
+		const noexcept
+		{
+			return offset <= myBytes.size() && size <= myBytes.size() - offset;
+		}
+
+	private:
+		std::span<const std::uint8_t> myBytes;
+	};
+
+	[[nodiscard]]
+	gl::font::Point
+	Transform(const std::array<float, 6>& transform, float x, float y)
+	noexcept
+	{
+		return gl::font::Point
+		{
+			transform[0] * x + transform[2] * y + transform[4],
+			transform[1] * x + transform[3] * y + transform[5],
+		};
+	}
+
+	[[nodiscard]]
+	gl::font::Point
+	Middle(const gl::font::Point& a, const gl::font::Point& b)
+	noexcept
+	{
+		return gl::font::Point{ (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f };
+	}
+
+	/// <summary>
+	/// Append the quadratic curve from the last point, without its first point
+	/// </summary>
+	void
+	FlattenCurve(std::vector<gl::font::Point>& points, const gl::font::Point& from, const gl::font::Point& control, const gl::font::Point& to, float tolerance)
+	{
+		// The distance of n segments from the curve is at most |from - 2 control + to| / (8 n^2)
+		const float dx = from.x - 2 * control.x + to.x;
+		const float dy = from.y - 2 * control.y + to.y;
+		const float deviation = std::sqrt(dx * dx + dy * dy);
+		const std::uint32_t count = std::clamp(static_cast<std::uint32_t>(std::ceil(std::sqrt(deviation / (8 * tolerance)))), 1U, MaxCurveSegments);
+
+		for (std::uint32_t i = 1; i <= count; ++i)
+		{
+			const float t = static_cast<float>(i) / static_cast<float>(count);
+			const float s = 1 - t;
+
+			points.push_back(gl::font::Point
+			{
+				s * s * from.x + 2 * s * t * control.x + t * t * to.x,
+				s * s * from.y + 2 * s * t * control.y + t * t * to.y,
+			});
+		}
+	}
+
+	struct Edge
+	{
+		float ax, ay, bx, by;
+		float minX, maxX, minY, maxY;
+	};
+
+	struct Crossing
+	{
+		float x;
+		std::int32_t winding;
+	};
+
+	[[nodiscard]]
+	float
+	GetSquaredDistance(const Edge& edge, float x, float y)
+	noexcept
+	{
+		const float ex = edge.bx - edge.ax;
+		const float ey = edge.by - edge.ay;
+		const float px = x - edge.ax;
+		const float py = y - edge.ay;
+		const float length = ex * ex + ey * ey;
+
+		const float t = 0 < length ? std::clamp((px * ex + py * ey) / length, 0.0f, 1.0f) : 0.0f;
+		const float dx = px - ex * t;
+		const float dy = py - ey * t;
+
+		return dx * dx + dy * dy;
+	}
+}
+
+void
+gl::font::DecodeUtf8(std::string_view text, std::u32string& output)
+{
+	output.clear();
+	output.reserve(text.size());
+
+	const std::size_t size = text.size();
+	std::size_t i = 0;
+
+	while (i < size)
+	{
+		const std::uint8_t lead = static_cast<std::uint8_t>(text[i]);
+
+		std::uint32_t length = 0;
+		char32_t codepoint = 0;
+		char32_t minimum = 0;
+
+		if (lead < 0x80)
+		{
+			output.push_back(lead);
+			++i;
+			continue;
+		}
+		else if (0xC0 == (lead & 0xE0))
+		{
+			length = 2;
+			codepoint = lead & 0x1F;
+			minimum = 0x80;
+		}
+		else if (0xE0 == (lead & 0xF0))
+		{
+			length = 3;
+			codepoint = lead & 0x0F;
+			minimum = 0x800;
+		}
+		else if (0xF0 == (lead & 0xF8))
+		{
+			length = 4;
+			codepoint = lead & 0x07;
+			minimum = 0x10000;
+		}
+		else
+		{
+			output.push_back(ReplacementCharacter);
+			++i;
+			continue;
+		}
+
+		std::uint32_t read = 1;
+		while (read < length && i + read < size && 0x80 == (static_cast<std::uint8_t>(text[i + read]) & 0xC0))
+		{
+			codepoint = codepoint << 6 | (static_cast<std::uint8_t>(text[i + read]) & 0x3F);
+			++read;
+		}
+
+		// Truncated, overlong, surrogate or beyond the code space
+		if (read < length || codepoint < minimum || 0x10FFFF < codepoint || (0xD800 <= codepoint && codepoint <= 0xDFFF))
+		{
+			codepoint = ReplacementCharacter;
+		}
+
+		output.push_back(codepoint);
+		i += read;
+	}
+}
+
+void
+gl::font::Outline::Clear()
+noexcept
+{
+	points.clear();
+	contourEnds.clear();
+}
+
+gl::font::FontFile::FontFile(std::vector<std::uint8_t>&& bytes)
+noexcept
+	: myBytes(std::move(bytes))
+{
+	isValid = ReadTables();
+}
+
+std::optional<gl::font::FontFile>
+gl::font::FontFile::Open(const std::filesystem::path& path)
+{
+	std::ifstream stream{ path, std::ios::binary };
+	if (not stream)
+	{
+		return std::nullopt;
+	}
+
+	std::vector<std::uint8_t> bytes{ std::istreambuf_iterator<char>{ stream }, std::istreambuf_iterator<char>{} };
+
+	FontFile result{ std::move(bytes) };
+	if (not result.IsValid())
+	{
+		return std::nullopt;
+	}
+
+	return std::optional<FontFile>{ std::move(result) };
+}
+
+bool
+gl::font::FontFile::ReadTables()
+noexcept
+{
+	const Reader reader{ myBytes };
+
+	const std::uint32_t version = reader.U32(0);
+	// TrueType outlines only, the CFF ones are tagged 'OTTO'
+	if (0x00010000 != version && MakeTag("true") != version)
+	{
+		return false;
+	}
+
+	std::uint32_t head = 0, maxp = 0, hhea = 0, cmap = 0, kern = 0;
+
+	const std::uint16_t table_count = reader.U16(4);
+	for (std::uint16_t i = 0; i < table_count; ++i)
+	{
+		const std::size_t record = 12 + 16 * static_cast<std::size_t>(i);
+		const std::uint32_t tag = reader.U32(record);
+		const std::uint32_t offset = reader.U32(record + 8);
+		const std::uint32_t length = reader.U32(record + 12);
+
+		if (not reader.Has(offset, length))
+		{
+			continue;
+		}
+
+		switch (tag)
+		{
+		case MakeTag("head"): head = offset; break;
+		case MakeTag("maxp"): maxp = offset; break;
+		case MakeTag("hhea"): hhea = offset; break;
+		case MakeTag("hmtx"): myHmtx = offset; break;
+		case MakeTag("loca"): myLoca = offset; break;
+		case MakeTag("glyf"): myGlyf = offset; break;
+		case MakeTag("cmap"): cmap = offset; break;
+		case MakeTag("kern"): kern = offset; break;
+		default: break;
+		}
+	}
+
+	if (0 == head || 0 == maxp || 0 == hhea || 0 == myHmtx || 0 == myLoca || 0 == myGlyf || 0 == cmap)
+	{
+		return false;
+	}
+
+	myMetrics.unitsPerEm = reader.U16(head + 18);
+	myMetrics.glyphCount = reader.U16(maxp + 4);
+	myMetrics.ascender = reader.I16(hhea + 4);
+	myMetrics.descender = reader.I16(hhea + 6);
+	myMetrics.lineGap = reader.I16(hhea + 8);
+	myMetricCount = reader.U16(hhea + 34);
+	isLongLoca = 0 != reader.I16(head + 50);
+
+	if (0 == myMetrics.unitsPerEm || 0 == myMetrics.glyphCount || 0 == myMetricCount)
+	{
+		return false;
+	}
+
+	// The full Unicode map first, then the basic plane one
+	std::uint32_t best_rank = 0;
+	const std::uint16_t encoding_count = reader.U16(cmap + 2);
+	for (std::uint16_t i = 0; i < encoding_count; ++i)
+	{
+		const std::size_t record = cmap + 4 + 8 * static_cast<std::size_t>(i);
+		const std::uint16_t platform = reader.U16(record);
+		const std::uint16_t encoding = reader.U16(record + 2);
+		const std::uint32_t offset = cmap + reader.U32(record + 4);
+		const std::uint16_t format = reader.U16(offset);
+
+		const bool is_unicode = 0 == platform || (3 == platform && (1 == encoding || 10 == encoding));
+		if (not is_unicode)
+		{
+			continue;
+		}
+
+		const std::uint32_t rank = 12 == format ? 2 : 4 == format ? 1 : 0;
+		if (best_rank < rank)
+		{
+			best_rank = rank;
+			myCmap = offset;
+			myCmapFormat = format;
+		}
+	}
+
+	if (0 == best_rank)
+	{
+		return false;
+	}
+
+	// The horizontal pairs of the format 0 subtables, the pairs of the GPOS table are not read
+	if (0 != kern && 0 == reader.U16(kern))
+	{
+		std::size_t subtable = kern + 4;
+
+		const std::uint16_t subtable_count = reader.U16(kern + 2);
+		for (std::uint16_t i = 0; i < subtable_count && reader.Has(subtable, 6); ++i)
+		{
+			const std::uint16_t length = reader.U16(subtable + 2);
+			const std::uint16_t coverage = reader.U16(subtable + 4);
+
+			// Horizontal, not minimum values nor cross stream, format 0
+			if (0x0001 == (coverage & 0xFF07))
+			{
+				const std::uint16_t pair_count = reader.U16(subtable + 6);
+				myKerning.reserve(myKerning.size() + pair_count);
+
+				for (std::uint16_t j = 0; j < pair_count; ++j)
+				{
+					const std::size_t pair = subtable + 14 + 6 * static_cast<std::size_t>(j);
+					myKerning.push_back(KerningPair{ reader.U32(pair), static_cast<float>(reader.I16(pair + 4)) });
+				}
+			}
+
+			if (0 == length)
+			{
+				break;
+			}
+
+			subtable += length;
+		}
+
+		std::ranges::stable_sort(myKerning, {}, &KerningPair::pair);
+	}
+
+	return true;
+}
+
+std::uint32_t
+gl::font::FontFile::GetGlyphIndex(char32_t codepoint)
+const noexcept
+{
+	if (not isValid)
+	{
+		return 0;
+	}
+
+	const Reader reader{ myBytes };
+	const std::uint32_t code = static_cast<std::uint32_t>(codepoint);
+
+	if (12 == myCmapFormat)
+	{
+		std::uint32_t low = 0;
+		std::uint32_t high = reader.U32(myCmap + 12);
+
+		while (low < high)
+		{
+			const std::uint32_t middle = low + (high - low) / 2;
+			const std::size_t group = myCmap + 16 + 12 * static_cast<std::size_t>(middle);
+
+			if (code < reader.U32(group))
+			{
+				high = middle;
+			}
+			else if (reader.U32(group + 4) < code)
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				const std::uint32_t glyph = reader.U32(group + 8) + code - reader.U32(group);
+
+				return glyph < myMetrics.glyphCount ? glyph : 0;
+			}
+		}
+
+		return 0;
+	}
+
+	if (0xFFFF < code)
+	{
+		return 0;
+	}
+
+	const std::uint32_t segment_count = reader.U16(myCmap + 6) / 2;
+	const std::size_t end_codes = myCmap + 14;
+	const std::size_t start_codes = end_codes + 2 * static_cast<std::size_t>(segment_count) + 2;
+	const std::size_t deltas = start_codes + 2 * static_cast<std::size_t>(segment_count);
+	const std::size_t range_offsets = deltas + 2 * static_cast<std::size_t>(segment_count);
+
+	// The first segment ending at or after the character
+	std::uint32_t low = 0;
+	std::uint32_t high = segment_count;
+	while (low < high)
+	{
+		const std::uint32_t middle = low + (high - low) / 2;
+
+		if (reader.U16(end_codes + 2 * static_cast<std::size_t>(middle)) < code)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	if (segment_count <= low)
+	{
+		return 0;
+	}
+
+	const std::size_t segment = 2 * static_cast<std::size_t>(low);
+	const std::uint16_t start = reader.U16(start_codes + segment);
+	if (code < start)
+	{
+		return 0;
+	}
+
+	const std::uint16_t delta = reader.U16(deltas + segment);
+	const std::uint16_t range_offset = reader.U16(range_offsets + segment);
+
+	std::uint32_t glyph = 0;
+	if (0 == range_offset)
+	{
+		glyph = (code + delta) & 0xFFFF;
+	}
+	else
+	{
+		// Relative to the range offset itself
+		glyph = reader.U16(range_offsets + segment + range_offset + 2 * static_cast<std::size_t>(code - start));
+		if (0 != glyph)
+		{
+			glyph = (glyph + delta) & 0xFFFF;
+		}
+	}
+
+	return glyph < myMetrics.glyphCount ? glyph : 0;
+}
+
+float
+gl::font::FontFile::GetAdvance(std::uint32_t glyph)
+const noexcept
+{
+	if (not isValid)
+	{
+		return 0;
+	}
+
+	// The glyphs after the last metric share its advance
+	const std::uint32_t metric = std::min(glyph, myMetricCount - 1);
+
+	return Reader{ myBytes }.U16(myHmtx + 4 * static_cast<std::size_t>(metric));
+}
+
+float
+gl::font::FontFile::GetKerning(std::uint32_t left, std::uint32_t right)
+const noexcept
+{
+	if (myKerning.empty())
+	{
+		return 0;
+	}
+
+	const std::uint32_t pair = left << 16 | (right & 0xFFFF);
+	const auto it = std::ranges::lower_bound(myKerning, pair, {}, &KerningPair::pair);
+
+	float result = 0;
+	for (auto kerning = it; kerning != myKerning.end() && pair == kerning->pair; ++kerning)
+	{
+		result += kerning->value;
+	}
+
+	return result;
+}
+
+bool
+gl::font::FontFile::GetOutline(std::uint32_t glyph, gl::font::Outline& output, float tolerance)
+const
+{
+	output.Clear();
+
+	if (not isValid || myMetrics.glyphCount <= glyph)
+	{
+		return false;
+	}
+
+	constexpr std::array<float, 6> identity{ 1, 0, 0, 1, 0, 0 };
+	AppendOutline(glyph, output, std::max(tolerance, 1e-3f), identity, 0);
+
+	return not output.contourEnds.empty();
+}
+
+bool
+gl::font::FontFile::AppendOutline(std::uint32_t glyph, gl::font::Outline& output, float tolerance, const std::array<float, 6>& transform, std::uint32_t depth)
+const
+{
+	const Reader reader{ myBytes };
+
+	std::size_t begin = 0, end = 0;
+	if (isLongLoca)
+	{
+		begin = reader.U32(myLoca + 4 * static_cast<std::size_t>(glyph));
+		end = reader.U32(myLoca + 4 * static_cast<std::size_t>(glyph) + 4);
+	}
+	else
+	{
+		begin = 2 * static_cast<std::size_t>(reader.U16(myLoca + 2 * static_cast<std::size_t>(glyph)));
+		end = 2 * static_cast<std::size_t>(reader.U16(myLoca + 2 * static_cast<std::size_t>(glyph) + 2));
+	}
+
+	// No outline, like the space
+	if (end <= begin || not reader.Has(myGlyf + begin, end - begin))
+	{
+		return false;
+	}
+
+	const std::size_t offset = myGlyf + begin;
+	const std::int16_t contour_count = reader.I16(offset);
+
+	if (contour_count < 0)
+	{
+		if (MaxCompositeDepth <= depth)
+		{
+			return false;
+		}
+
+		constexpr std::uint16_t ArgumentsAreWords = 0x0001;
+		constexpr std::uint16_t ArgumentsAreOffsets = 0x0002;
+		constexpr std::uint16_t HasScale = 0x0008;
+		constexpr std::uint16_t HasMoreComponents = 0x0020;
+		constexpr std::uint16_t HasScaleXY = 0x0040;
+		constexpr std::uint16_t HasMatrix = 0x0080;
+
+		constexpr auto ReadF2Dot14 = [](const Reader& reader, std::size_t offset) noexcept {
+			return static_cast<float>(reader.I16(offset)) / 16384.0f;
+		};
+
+		std::size_t component = offset + 10;
+		std::uint16_t flags = HasMoreComponents;
+
+		while (0 != (flags & HasMoreComponents) && reader.Has(component, 4))
+		{
+			flags = reader.U16(component);
+			const std::uint16_t index = reader.U16(component + 2);
+			component += 4;
+
+			float dx = 0, dy = 0;
+			if (0 != (flags & ArgumentsAreWords))
+			{
+				dx = reader.I16(component);
+				dy = reader.I16(component + 2);
+				component += 4;
+			}
+			else
+			{
+				dx = static_cast<std::int8_t>(reader.U8(component));
+				dy = static_cast<std::int8_t>(reader.U8(component + 1));
+				component += 2;
+			}
+
+			// Components placed by matching their points are not positioned
+			if (0 == (flags & ArgumentsAreOffsets))
+			{
+				dx = dy = 0;
+			}
+
+			std::array<float, 6> local{ 1, 0, 0, 1, dx, dy };
+			if (0 != (flags & HasScale))
+			{
+				local[0] = local[3] = ReadF2Dot14(reader, component);
+				component += 2;
+			}
+			else if (0 != (flags & HasScaleXY))
+			{
+				local[0] = ReadF2Dot14(reader, component);
+				local[3] = ReadF2Dot14(reader, component + 2);
+				component += 4;
+			}
+			else if (0 != (flags & HasMatrix))
+			{
+				local[0] = ReadF2Dot14(reader, component);
+				local[1] = ReadF2Dot14(reader, component + 2);
+				local[2] = ReadF2Dot14(reader, component + 4);
+				local[3] = ReadF2Dot14(reader, component + 6);
+				component += 8;
+			}
+
+			const std::array<float, 6> combined
+			{
+				transform[0] * local[0] + transform[2] * local[1],
+				transform[1] * local[0] + transform[3] * local[1],
+				transform[0] * local[2] + transform[2] * local[3],
+				transform[1] * local[2] + transform[3] * local[3],
+				transform[0] * local[4] + transform[2] * local[5] + transform[4],
+				transform[1] * local[4] + transform[3] * local[5] + transform[5],
+			};
+
+			if (index < myMetrics.glyphCount)
+			{
+				AppendOutline(index, output, tolerance, combined, depth + 1);
+			}
+		}
+
+		return true;
+	}
+
+	if (0 == contour_count)
+	{
+		return false;
+	}
+
+	const std::size_t end_points = offset + 10;
+	const std::uint32_t point_count = static_cast<std::uint32_t>(reader.U16(end_points + 2 * static_cast<std::size_t>(contour_count - 1))) + 1;
+	const std::size_t instructions = end_points + 2 * static_cast<std::size_t>(contour_count);
+	std::size_t cursor = instructions + 2 + reader.U16(instructions);
+
+	constexpr std::uint8_t OnCurve = 0x01;
+	constexpr std::uint8_t ShortX = 0x02;
+	constexpr std::uint8_t ShortY = 0x04;
+	constexpr std::uint8_t Repeat = 0x08;
+	constexpr std::uint8_t SameOrPositiveX = 0x10;
+	constexpr std::uint8_t SameOrPositiveY = 0x20;
+
+	std::vector<std::uint8_t> flags(point_count);
+	for (std::uint32_t i = 0; i < point_count; )
+	{
+		const std::uint8_t flag = reader.U8(cursor++);
+		flags[i++] = flag;
+
+		if (0 != (flag & Repeat))
+		{
+			for (std::uint8_t repeat = reader.U8(cursor++); 0 < repeat && i < point_count; --repeat)
+			{
+				flags[i++] = flag;
+			}
+		}
+	}
+
+	std::vector<Point> points(point_count);
+
+	const auto read_coordinates = [&](std::uint8_t short_flag, std::uint8_t same_flag, float Point::* member) {
+		std::int32_t value = 0;
+
+		for (std::uint32_t i = 0; i < point_count; ++i)
+		{
+			const std::uint8_t flag = flags[i];
+
+			if (0 != (flag & short_flag))
+			{
+				const std::int32_t delta = reader.U8(cursor++);
+				value += 0 != (flag & same_flag) ? delta : -delta;
+			}
+			else if (0 == (flag & same_flag))
+			{
+				value += reader.I16(cursor);
+				cursor += 2;
+			}
+
+			points[i].*member = static_cast<float>(value);
+		}
+	};
+
+	read_coordinates(ShortX, SameOrPositiveX, &Point::x);
+	read_coordinates(ShortY, SameOrPositiveY, &Point::y);
+
+	if (not reader.Has(0, cursor))
+	{
+		return false;
+	}
+
+	for (Point& point : points)
+	{
+		point = Transform(transform, point.x, point.y);
+	}
+
+	std::uint32_t first = 0;
+	for (std::int16_t contour = 0; contour < contour_count; ++contour)
+	{
+		const std::uint32_t last = std::min(static_cast<std::uint32_t>(reader.U16(end_points + 2 * static_cast<std::size_t>(contour))), point_count - 1);
+		if (last < first)
+		{
+			break;
+		}
+
+		const std::uint32_t count = last - first + 1;
+		const auto is_on = [&](std::uint32_t i) noexcept {
+			return 0 != (flags[first + i] & OnCurve);
+		};
+		const auto at = [&](std::uint32_t i) noexcept -> const Point& {
+			return points[first + i];
+		};
+
+		// Start on a point of the curve, the midpoint of the two ends when neither is on it
+		Point start{};
+		std::uint32_t from = 0, to = count;
+		if (is_on(0))
+		{
+			start = at(0);
+			from = 1;
+		}
+		else if (is_on(count - 1))
+		{
+			start = at(count - 1);
+			to = count - 1;
+		}
+		else
+		{
+			start = Middle(at(count - 1), at(0));
+		}
+
+		const std::size_t contour_begin = output.points.size();
+		output.points.push_back(start);
+
+		Point current = start;
+		std::optional<Point> control{};
+
+		for (std::uint32_t i = from; i < to; ++i)
+		{
+			const Point& point = at(i);
+
+			if (is_on(i))
+			{
+				if (control)
+				{
+					FlattenCurve(output.points, current, *control, point, tolerance);
+					control.reset();
+				}
+				else
+				{
+					output.points.push_back(point);
+				}
+
+				current = point;
+			}
+			else if (control)
+			{
+				// Two controls in a row imply a point of the curve between them
+				const Point middle = Middle(*control, point);
+				FlattenCurve(output.points, current, *control, middle, tolerance);
+
+				current = middle;
+				control = point;
+			}
+			else
+			{
+				control = point;
+			}
+		}
+
+		if (control)
+		{
+			FlattenCurve(output.points, current, *control, start, tolerance);
+		}
+
+		// The contours are closed from their last point to their first one
+		if (1 < output.points.size() - contour_begin)
+		{
+			const Point& back = output.points.back();
+			if (back.x == start.x && back.y == start.y)
+			{
+				output.points.pop_back();
+			}
+		}
+
+		output.contourEnds.push_back(static_cast<std::uint32_t>(output.points.size()));
+		first = last + 1;
+	}
+
+	return true;
+}
+
+const gl::font::Metrics&
+gl::font::FontFile::GetMetrics()
+const noexcept
+{
+	return myMetrics;
+}
+
+bool
+gl::font::FontFile::IsValid()
+const noexcept
+{
+	return isValid;
+}
+
+void
+gl::font::RasterizeSdf(const gl::font::Outline& outline, float scale, std::uint32_t spread, gl::font::Bitmap& output)
+{
+	output.width = output.height = 0;
+	output.left = output.top = 0;
+	output.pixels.clear();
+
+	if (outline.points.empty())
+	{
+		return;
+	}
+
+	// In pixels, with the y axis going up
+	std::vector<Edge> edges{};
+	edges.reserve(outline.points.size());
+
+	float min_x = outline.points[0].x * scale, max_x = min_x;
+	float min_y = outline.points[0].y * scale, max_y = min_y;
+
+	std::uint32_t first = 0;
+	for (const std::uint32_t end : outline.contourEnds)
+	{
+		for (std::uint32_t i = first; i < end; ++i)
+		{
+			const Point& a = outline.points[i];
+			const Point& b = outline.points[i + 1 < end ? i + 1 : first];
+
+			const float ax = a.x * scale, ay = a.y * scale;
+			const float bx = b.x * scale, by = b.y * scale;
+
+			const Edge edge{ ax, ay, bx, by, std::min(ax, bx), std::max(ax, bx), std::min(ay, by), std::max(ay, by) };
+
+			min_x = std::min(min_x, edge.minX);
+			max_x = std::max(max_x, edge.maxX);
+			min_y = std::min(min_y, edge.minY);
+			max_y = std::max(max_y, edge.maxY);
+
+			edges.push_back(edge);
+		}
+
+		first = end;
+	}
+
+	const std::int32_t padding = static_cast<std::int32_t>(spread);
+	const std::int32_t left = static_cast<std::int32_t>(std::floor(min_x)) - padding;
+	const std::int32_t right = static_cast<std::int32_t>(std::ceil(max_x)) + padding;
+	const std::int32_t bottom = static_cast<std::int32_t>(std::floor(min_y)) - padding;
+	const std::int32_t top = static_cast<std::int32_t>(std::ceil(max_y)) + padding;
+
+	output.left = left;
+	output.top = top;
+	output.width = static_cast<std::uint32_t>(right - left);
+	output.height = static_cast<std::uint32_t>(top - bottom);
+	output.pixels.resize(static_cast<std::size_t>(output.width) * output.height);
+
+	const float range = static_cast<float>(std::max(1U, spread));
+	const float range_squared = range * range;
+
+	std::vector<const Edge*> nearby{};
+	std::vector<Crossing> crossings{};
+
+	for (std::uint32_t row = 0; row < output.height; ++row)
+	{
+		const float y = static_cast<float>(top) - static_cast<float>(row) - 0.5f;
+
+		nearby.clear();
+		crossings.clear();
+
+		for (const Edge& edge : edges)
+		{
+			if (edge.minY - range <= y && y <= edge.maxY + range)
+			{
+				nearby.push_back(std::addressof(edge));
+			}
+
+			// Half open, so a vertex shared by two edges is crossed once
+			if (edge.ay <= y && y < edge.by)
+			{
+				crossings.push_back(Crossing{ edge.ax + (y - edge.ay) * (edge.bx - edge.ax) / (edge.by - edge.ay), 1 });
+			}
+			else if (edge.by <= y && y < edge.ay)
+			{
+				crossings.push_back(Crossing{ edge.ax + (y - edge.ay) * (edge.bx - edge.ax) / (edge.by - edge.ay), -1 });
+			}
+		}
+
+		std::ranges::sort(crossings, {}, &Crossing::x);
+
+		std::uint8_t* destination = output.pixels.data() + static_cast<std::size_t>(row) * output.width;
+		std::size_t next_crossing = 0;
+		std::int32_t winding = 0;
+
+		for (std::uint32_t column = 0; column < output.width; ++column)
+		{
+			const float x = static_cast<float>(left) + static_cast<float>(column) + 0.5f;
+
+			while (next_crossing < crossings.size() && crossings[next_crossing].x < x)
+			{
+				winding += crossings[next_crossing++].winding;
+			}
+
+			float nearest = range_squared;
+			for (const Edge* edge : nearby)
+			{
+				if (x < edge->minX - range || edge->maxX + range < x)
+				{
+					continue;
+				}
+
+				nearest = std::min(nearest, GetSquaredDistance(*edge, x, y));
+			}
+
+			// Non zero winding is inside
+			const float distance = 0 != winding ? std::sqrt(nearest) : -std::sqrt(nearest);
+			const float value = 127.5f + distance / range * 127.5f;
+
+			destination[column] = static_cast<std::uint8_t>(std::clamp(value + 0.5f, 0.0f, 255.0f));
+		}
+	}
+}
+
+gl::font::ShelfPacker::ShelfPacker(std::uint32_t width, std::uint32_t height, std::uint32_t padding)
+noexcept
+	: myWidth(width), myHeight(height), myPadding(padding)
+{}
+
+std::optional<gl::font::Rect>
+gl::font::ShelfPacker::Pack(std::uint32_t width, std::uint32_t height)
+{
+	const std::uint32_t padded_width = width + myPadding;
+	const std::uint32_t padded_height = height + myPadding;
+
+	if (myWidth < padded_width || myHeight < padded_height)
+	{
+		return std::nullopt;
+	}
+
+	// The lowest shelf it fits in without wasting more than a third of the shelf
+	Shelf* best = nullptr;
+	for (Shelf& shelf : myShelves)
+	{
+		if (padded_height <= shelf.height && shelf.height * 2 <= padded_height * 3 && padded_width <= myWidth - shelf.used)
+		{
+			if (nullptr == best || shelf.height < best->height)
+			{
+				best = std::addressof(shelf);
+			}
+		}
+	}
+
+	if (nullptr == best)
+	{
+		if (myHeight - myBottom < padded_height)
+		{
+			return std::nullopt;
+		}
+
+		best = std::addressof(myShelves.emplace_back(Shelf{ myBottom, padded_height, 0 }));
+		myBottom += padded_height;
+	}
+
+	const Rect result{ best->used, best->y, width, height };
+	best->used += padded_width;
+	myUsedArea += static_cast<std::uint64_t>(width) * height;
+
+	return result;
+}
+
+void
+gl::font::ShelfPacker::Clear()
+noexcept
+{
+	myShelves.clear();
+	myBottom = 0;
+	myUsedArea = 0;
+}
+
+std::uint64_t
+gl::font::ShelfPacker::GetUsedArea()
+const noexcept
+{
+	return myUsedArea;
+}
+
+std::uint32_t
+gl::font::ShelfPacker::GetWidth()
+const noexcept
+{
+	return myWidth;
+}
+
+std::uint32_t
+gl::font::ShelfPacker::GetHeight()
+const noexcept
+{
+	return myHeight;
+}
+
+gl::font::Benchmark
+gl::font::MeasureRasterization(const gl::font::FontFile& font, std::uint32_t glyph_size, std::uint32_t iterations, std::uint32_t threads)
+{
+	using clock = std::chrono::steady_clock;
+
+	Benchmark result{};
+	result.threads = GetWorkerCount(threads);
+
+	if (not font.IsValid())
+	{
+		return result;
+	}
+
+	std::vector<std::uint32_t> glyphs{};
+	for (char32_t codepoint = U'!'; codepoint <= U'~'; ++codepoint)
+	{
+		glyphs.push_back(font.GetGlyphIndex(codepoint));
+	}
+
+	result.glyphs = static_cast<std::uint32_t>(glyphs.size());
+
+	const float scale = static_cast<float>(glyph_size) / static_cast<float>(font.GetMetrics().unitsPerEm);
+	const float tolerance = FlatteningTolerance / scale;
+
+	const auto rasterize = [&](std::uint32_t workers) {
+		std::vector<Bitmap> bitmaps(glyphs.size());
+
+		ParallelFor(workers, result.glyphs, [&](std::uint32_t i, std::uint32_t) {
+			Outline outline{};
+			if (font.GetOutline(glyphs[i], outline, tolerance))
+			{
+				RasterizeSdf(outline, scale, DefaultSpread, bitmaps[i]);
+			}
+		});
+	};
+
+	double single = 1e9, parallel = 1e9;
+	for (std::uint32_t i = 0; i < std::max(1U, iterations); ++i)
+	{
+		const auto single_begin = clock::now();
+		rasterize(1);
+		single = std::min(single, std::chrono::duration<double>(clock::now() - single_begin).count());
+
+		const auto parallel_begin = clock::now();
+		rasterize(result.threads);
+		parallel = std::min(parallel, std::chrono::duration<double>(clock::now() - parallel_begin).count());
+	}
+
+	result.singleThreadedSeconds = single;
+	result.parallelSeconds = parallel;
+
+	return result;
+}
+
+std::size_t
+gl::FontAtlas::TextHash::operator()(std::string_view text)
+const noexcept
+{
+	return std::hash<std::string_view>{}(text);
+}
+
+gl::FontAtlas::FontAtlas(gl::font::FontFile&& font, std::uint32_t glyph_size, std::uint32_t atlas_size, std::uint32_t spread, std::uint32_t threads)
+	: myFont(std::move(font))
+	, myGlyphSize(std::max(1U, glyph_size))
+	, mySize(std::max(1U, atlas_size))
+	, mySpread(spread)
+	, myThreads(GetWorkerCount(threads))
+	, myScale(0)
+	, myPacker(mySize, mySize)
+	, myPixels(static_cast<std::size_t>(mySize) * mySize)
+{
+	if (myFont.IsValid())
+	{
+		myScale = static_cast<float>(myGlyphSize) / static_cast<float>(myFont.GetMetrics().unitsPerEm);
+	}
+
+	for (std::uint32_t i = 0; i < myAsciiGlyphs.size(); ++i)
+	{
+		myAsciiGlyphs[i] = myFont.GetGlyphIndex(static_cast<char32_t>(i));
+	}
+}
+
+void
+gl::FontAtlas::BeginFrame()
+noexcept
+{
+	++myFrame;
+
+	myStatistics.evictedRuns += std::erase_if(myRuns, [this](const auto& pair) noexcept {
+		return myGeneration != pair.second.generation || font::DefaultRunLifetime < myFrame - pair.second.lastFrame;
+	});
+}
+
+std::size_t
+gl::FontAtlas::Prepare(std::u32string_view text)
+{
+	if (not myFont.IsValid())
+	{
+		return 0;
+	}
+
+	const auto collect = [&](std::vector<std::uint32_t>& glyphs) {
+		glyphs.clear();
+
+		for (const char32_t codepoint : text)
+		{
+			// The controls are laid out without a glyph
+			if (codepoint < U' ')
+			{
+				continue;
+			}
+
+			const std::uint32_t glyph = GetGlyphIndex(codepoint);
+			if (not mySlots.contains(glyph) && glyphs.end() == std::ranges::find(glyphs, glyph))
+			{
+				glyphs.push_back(glyph);
+			}
+		}
+	};
+
+	std::vector<std::uint32_t> glyphs{};
+	collect(glyphs);
+
+	if (glyphs.empty())
+	{
+		return 0;
+	}
+
+	std::size_t result = glyphs.size();
+
+	if (not Rasterize(glyphs, false))
+	{
+		// Full, start over with the glyphs of this text alone
+		Clear();
+		++myStatistics.resets;
+
+		collect(glyphs);
+		Rasterize(glyphs, true);
+		result += glyphs.size();
+	}
+
+	return result;
+}
+
+const gl::font::ShapedRun&
+gl::FontAtlas::Shape(std::string_view text)
+{
+	if (const auto it = myRuns.find(text); myRuns.end() != it && myGeneration == it->second.generation)
+	{
+		++myStatistics.runHits;
+		it->second.lastFrame = myFrame;
+
+		return it->second;
+	}
+
+	++myStatistics.runMisses;
+
+	font::DecodeUtf8(text, myCodepoints);
+	Prepare(myCodepoints);
+
+	// Found after the preparation, which may have cleared the runs
+	font::ShapedRun& run = myRuns.try_emplace(std::string{ text }).first->second;
+	run.glyphs.clear();
+	run.generation = myGeneration;
+	run.lastFrame = myFrame;
+
+	const float line_height = GetLineHeight();
+	const float ascender = GetAscender();
+
+	float x = 0, y = ascender;
+	float width = 0;
+	std::uint32_t lines = 1;
+	// Kerned against the next glyph of the line
+	std::uint32_t previous = NoGlyph;
+
+	for (const char32_t codepoint : myCodepoints)
+	{
+		if (U'\n' == codepoint)
+		{
+			x = 0;
+			y += line_height;
+			++lines;
+			previous = NoGlyph;
+			continue;
+		}
+		else if (U'\t' == codepoint)
+		{
+			x += TabulationWidth * myFont.GetAdvance(GetGlyphIndex(U' ')) * myScale;
+			width = std::max(width, x);
+			previous = NoGlyph;
+			continue;
+		}
+		else if (codepoint < U' ')
+		{
+			continue;
+		}
+
+		const std::uint32_t index = GetGlyphIndex(codepoint);
+		const auto slot = mySlots.find(index);
+		if (mySlots.end() == slot)
+		{
+			continue;
+		}
+
+		if (NoGlyph != previous)
+		{
+			x += myFont.GetKerning(previous, index) * myScale;
+		}
+
+		run.glyphs.push_back(font::PositionedGlyph{ slot->second, x, y });
+
+		x += myGlyphs[slot->second].advance;
+		width = std::max(width, x);
+		previous = index;
+	}
+
+	run.width = width;
+	run.height = static_cast<float>(lines) * line_height;
+
+	return run;
+}
+
+void
+gl::FontAtlas::Clear()
+noexcept
+{
+	myPacker.Clear();
+	std::ranges::fill(myPixels, std::uint8_t{ 0 });
+
+	myGlyphs.clear();
+	mySlots.clear();
+	myRuns.clear();
+	++myGeneration;
+
+	myStatistics.glyphs = 0;
+	myStatistics.usedArea = 0;
+
+	MarkDirty(font::Rect{ 0, 0, mySize, mySize });
+}
+
+std::optional<gl::font::Rect>
+gl::FontAtlas::TakeDirtyRect()
+noexcept
+{
+	return std::exchange(myDirtyRect, std::nullopt);
+}
+
+const gl::font::Glyph&
+gl::FontAtlas::GetGlyph(std::uint32_t slot)
+const noexcept
+{
+	return myGlyphs[slot];
+}
+
+std::span<const std::uint8_t>
+gl::FontAtlas::GetPixels()
+const noexcept
+{
+	return myPixels;
+}
+
+std::uint32_t
+gl::FontAtlas::GetSize()
+const noexcept
+{
+	return mySize;
+}
+
+std::uint32_t
+gl::FontAtlas::GetGlyphSize()
+const noexcept
+{
+	return myGlyphSize;
+}
+
+std::uint32_t
+gl::FontAtlas::GetSpread()
+const noexcept
+{
+	return mySpread;
+}
+
+float
+gl::FontAtlas::GetLineHeight()
+const noexcept
+{
+	const font::Metrics& metrics = myFont.GetMetrics();
+
+	return (metrics.ascender - metrics.descender + metrics.lineGap) * myScale;
+}
+
+float
+gl::FontAtlas::GetAscender()
+const noexcept
+{
+	return myFont.GetMetrics().ascender * myScale;
+}
+
+std::uint64_t
+gl::FontAtlas::GetGeneration()
+const noexcept
+{
+	return myGeneration;
+}
+
+const gl::font::FontFile&
+gl::FontAtlas::GetFont()
+const noexcept
+{
+	return myFont;
+}
+
+const gl::font::Statistics&
+gl::FontAtlas::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+std::uint32_t
+gl::FontAtlas::GetGlyphIndex(char32_t codepoint)
+const noexcept
+{
+	if (codepoint < myAsciiGlyphs.size())
+	{
+		return myAsciiGlyphs[codepoint];
+	}
+
+	return myFont.GetGlyphIndex(codepoint);
+}
+
+bool
+gl::FontAtlas::Rasterize(std::span<const std::uint32_t> glyphs, bool force)
+{
+	const std::uint32_t count = static_cast<std::uint32_t>(glyphs.size());
+	const float tolerance = FlatteningTolerance / myScale;
+
+	// The outlines are read and rasterized on the workers, the font is only read
+	std::vector<font::Bitmap> bitmaps(count);
+	ParallelFor(myThreads, count, [&](std::uint32_t i, std::uint32_t) {
+		font::Outline outline{};
+		if (myFont.GetOutline(glyphs[i], outline, tolerance))
+		{
+			font::RasterizeSdf(outline, myScale, mySpread, bitmaps[i]);
+		}
+	});
+
+	myStatistics.rasterizedGlyphs += count;
+
+	// The tallest first, so the shelves waste less
+	std::vector<std::uint32_t> order(count);
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		order[i] = i;
+	}
+
+	std::ranges::stable_sort(order, std::ranges::greater{}, [&](std::uint32_t i) noexcept {
+		return bitmaps[i].height;
+	});
+
+	bool result = true;
+
+	for (const std::uint32_t i : order)
+	{
+		const font::Bitmap& bitmap = bitmaps[i];
+
+		font::Glyph glyph{};
+		glyph.index = glyphs[i];
+		glyph.advance = myFont.GetAdvance(glyphs[i]) * myScale;
+
+		if (0 < bitmap.width && 0 < bitmap.height)
+		{
+			const std::optional<font::Rect> rect = myPacker.Pack(bitmap.width, bitmap.height);
+			if (not rect)
+			{
+				if (not force)
+				{
+					return false;
+				}
+
+				// Laid out, but invisible
+				result = false;
+			}
+			else
+			{
+				for (std::uint32_t row = 0; row < bitmap.height; ++row)
+				{
+					std::ranges::copy_n(bitmap.pixels.data() + static_cast<std::size_t>(row) * bitmap.width, bitmap.width
+						, myPixels.data() + static_cast<std::size_t>(rect->y + row) * mySize + rect->x);
+				}
+
+				glyph.rect = *rect;
+				glyph.left = bitmap.left;
+				glyph.top = bitmap.top;
+				MarkDirty(*rect);
+			}
+		}
+
+		mySlots.emplace(glyph.index, static_cast<std::uint32_t>(myGlyphs.size()));
+		myGlyphs.push_back(glyph);
+	}
+
+	myStatistics.glyphs = myGlyphs.size();
+	myStatistics.usedArea = myPacker.GetUsedArea();
+
+	return result;
+}
+
+void
+gl::FontAtlas::MarkDirty(const gl::font::Rect& rect)
+noexcept
+{
+	if (not myDirtyRect)
+	{
+		myDirtyRect = rect;
+		return;
+	}
+
+	font::Rect& dirty = *myDirtyRect;
+	const std::uint32_t right = std::max(dirty.x + dirty.width, rect.x + rect.width);
+	const std::uint32_t bottom = std::max(dirty.y + dirty.height, rect.y + rect.height);
+
+	dirty.x = std::min(dirty.x, rect.x);
+	dirty.y = std::min(dirty.y, rect.y);
+	dirty.width = right - dirty.x;
+	dirty.height = bottom - dirty.y;
+}
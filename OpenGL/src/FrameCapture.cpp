@@ -0,0 +1,475 @@
+module;
+#include <Windows.h>
+#include "glew.h"
+#include <GL/GL.h>
+#include "../fpng.h"
+
+module Glib.FrameCapture;
+import <utility>;
+import <chrono>;
+import <format>;
+import <fstream>;
+import <thread>;
+import <algorithm>;
+
+static void
+FlipRows(std::vector<std::uint8_t>& pixels, const std::size_t& row_bytes, const std::size_t& rows)
+noexcept
+{
+	std::vector<std::uint8_t> temp(row_bytes);
+
+	for (std::size_t y = 0; y < rows / 2; ++y)
+	{
+		std::uint8_t* const top = pixels.data() + y * row_bytes;
+		std::uint8_t* const bottom = pixels.data() + (rows - 1 - y) * row_bytes;
+
+		std::copy_n(top, row_bytes, temp.data());
+		std::copy_n(bottom, row_bytes, top);
+		std::copy_n(temp.data(), row_bytes, bottom);
+	}
+}
+
+static std::uint32_t
+ResolveThreads(const std::uint32_t& threads)
+noexcept
+{
+	return 0 == threads ? std::max(1U, std::thread::hardware_concurrency()) : threads;
+}
+
+static bool
+WriteFile(const std::filesystem::path& path, const std::vector<std::uint8_t>& bytes)
+noexcept
+{
+	std::ofstream stream{ path, std::ios::binary | std::ios::trunc };
+	if (not stream)
+	{
+		return false;
+	}
+
+	stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+	return stream.good();
+}
+
+bool
+gl::capture::EncodePng(const std::uint8_t* pixels
+	, std::size_t width, std::size_t height, std::size_t channels
+	, std::vector<std::uint8_t>& output, std::uint32_t threads)
+{
+	fpng::fpng_init();
+
+	return fpng::fpng_encode_image_to_memory_parallel(pixels, width, height, channels, output, ResolveThreads(threads));
+}
+
+gl::capture::Benchmark
+gl::capture::MeasureEncoding(const std::uint8_t* pixels
+	, std::size_t width, std::size_t height, std::size_t channels
+	, std::uint32_t iterations, std::uint32_t threads)
+{
+	using clock = std::chrono::steady_clock;
+
+	fpng::fpng_init();
+
+	Benchmark result{};
+	result.threads = ResolveThreads(threads);
+
+	iterations = std::max(1U, iterations);
+	const double megabytes = static_cast<double>(width * height * channels) * iterations / (1024.0 * 1024.0);
+
+	std::vector<std::uint8_t> output{};
+
+	const auto single_begin = clock::now();
+	for (std::uint32_t i = 0; i < iterations; ++i)
+	{
+		fpng::fpng_encode_image_to_memory(pixels, width, height, channels, output);
+	}
+	const std::chrono::duration<double> single_time = clock::now() - single_begin;
+
+	const auto parallel_begin = clock::now();
+	for (std::uint32_t i = 0; i < iterations; ++i)
+	{
+		fpng::fpng_encode_image_to_memory_parallel(pixels, width, height, channels, output, result.threads);
+	}
+	const std::chrono::duration<double> parallel_time = clock::now() - parallel_begin;
+
+	result.singleThreaded = megabytes / std::max(single_time.count(), 1e-9);
+	result.parallel = megabytes / std::max(parallel_time.count(), 1e-9);
+
+	return result;
+}
+
+std::vector<gl::capture::IsaBenchmark>
+gl::capture::MeasureInstructionSets(const std::uint8_t* pixels
+	, std::size_t width, std::size_t height, std::size_t channels
+	, std::uint32_t iterations)
+{
+	using clock = std::chrono::steady_clock;
+
+	fpng::fpng_init();
+
+	iterations = std::max(1U, iterations);
+	const double megabytes = static_cast<double>(width * height * channels) * iterations / (1024.0 * 1024.0);
+
+	std::vector<IsaBenchmark> result{};
+
+	std::vector<std::uint8_t> encoded{};
+	std::vector<std::uint8_t> decoded{};
+	std::size_t decoded_width = 0, decoded_height = 0, decoded_channels = 0;
+
+	const std::uint32_t best = fpng::fpng_cpu_best_isa();
+	const std::uint32_t previous = fpng::fpng_set_max_isa(fpng::FPNG_ISA_SCALAR);
+
+	for (std::uint32_t isa = fpng::FPNG_ISA_SCALAR; isa <= best; ++isa)
+	{
+		fpng::fpng_set_max_isa(isa);
+
+		const auto encode_begin = clock::now();
+		for (std::uint32_t i = 0; i < iterations; ++i)
+		{
+			fpng::fpng_encode_image_to_memory(pixels, width, height, channels, encoded);
+		}
+		const std::chrono::duration<double> encode_time = clock::now() - encode_begin;
+
+		const auto decode_begin = clock::now();
+		for (std::uint32_t i = 0; i < iterations; ++i)
+		{
+			fpng::fpng_decode_memory(encoded.data(), encoded.size(), decoded, decoded_width, decoded_height, decoded_channels, channels);
+		}
+		const std::chrono::duration<double> decode_time = clock::now() - decode_begin;
+
+		IsaBenchmark& entry = result.emplace_back();
+		entry.isa = fpng::fpng_isa_name(isa);
+		entry.encoding = megabytes / std::max(encode_time.count(), 1e-9);
+		entry.decoding = megabytes / std::max(decode_time.count(), 1e-9);
+	}
+
+	fpng::fpng_set_max_isa(previous);
+
+	return result;
+}
+
+gl::FrameCapture::FrameCapture(const gl::capture::Descriptor& descriptor)
+	: mySettings(descriptor)
+{
+	mySettings.ringSize = std::max(1U, mySettings.ringSize);
+	mySettings.maxEncodings = std::max(1U, mySettings.maxEncodings);
+
+	// Every encoding in flight runs its own stripes, so the budget is split to never run more threads than it
+	myEncoderThreads = std::max(1U, ResolveThreads(mySettings.encoderThreads) / mySettings.maxEncodings);
+
+	fpng::fpng_init();
+}
+
+gl::FrameCapture::~FrameCapture()
+noexcept
+{
+	Stop();
+}
+
+bool
+gl::FrameCapture::Start(const gl::Rect& area)
+noexcept
+{
+	if (isRunning || area.w <= 0 || area.h <= 0)
+	{
+		return false;
+	}
+
+	const std::size_t channels = mySettings.withAlpha ? 4 : 3;
+
+	myArea = area;
+	myFrameBytes = static_cast<std::size_t>(area.w) * static_cast<std::size_t>(area.h) * channels;
+
+	mySlots.resize(mySettings.ringSize);
+	for (Slot& slot : mySlots)
+	{
+		::glGenBuffers(1, std::addressof(slot.buffer));
+		::glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		::glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(myFrameBytes), nullptr, GL_STREAM_READ);
+	}
+	::glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	nextSlot = 0;
+	isRunning = true;
+
+	return true;
+}
+
+void
+gl::FrameCapture::Stop()
+noexcept
+{
+	if (not isRunning)
+	{
+		return;
+	}
+
+	Flush();
+
+	for (Slot& slot : mySlots)
+	{
+		if (nullptr != slot.fence)
+		{
+			::glDeleteSync(static_cast<GLsync>(slot.fence));
+		}
+
+		::glDeleteBuffers(1, std::addressof(slot.buffer));
+	}
+
+	mySlots.clear();
+	isRunning = false;
+}
+
+bool
+gl::FrameCapture::Capture()
+noexcept
+{
+	if (not isRunning)
+	{
+		return false;
+	}
+
+	Slot& slot = mySlots[nextSlot];
+
+	// The oldest read back has to leave its buffer before we can reuse it
+	if (nullptr != slot.fence)
+	{
+		(void)Resolve(slot, true);
+	}
+
+	::glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	::glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	::glReadPixels(myArea.x, myArea.y, myArea.w, myArea.h
+		, mySettings.withAlpha ? GL_RGBA : GL_RGB
+		, GL_UNSIGNED_BYTE, nullptr);
+	::glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = ::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame = nextFrame++;
+
+	nextSlot = (nextSlot + 1) % mySlots.size();
+	++myStatistics.capturedFrames;
+
+	return true;
+}
+
+std::size_t
+gl::FrameCapture::Poll()
+noexcept
+{
+	std::size_t resolved = 0;
+
+	// Resolve from the oldest slot
+	for (std::size_t i = 0; i < mySlots.size(); ++i)
+	{
+		Slot& slot = mySlots[(nextSlot + i) % mySlots.size()];
+
+		if (nullptr != slot.fence && Resolve(slot, false))
+		{
+			++resolved;
+		}
+	}
+
+	Collect(false);
+
+	return resolved;
+}
+
+void
+gl::FrameCapture::Flush()
+noexcept
+{
+	for (std::size_t i = 0; i < mySlots.size(); ++i)
+	{
+		Slot& slot = mySlots[(nextSlot + i) % mySlots.size()];
+
+		if (nullptr != slot.fence)
+		{
+			(void)Resolve(slot, true);
+		}
+	}
+
+	Collect(true);
+}
+
+bool
+gl::FrameCapture::Screenshot(const std::filesystem::path& path)
+const noexcept
+{
+	GLint viewport[4]{};
+	::glGetIntegerv(GL_VIEWPORT, viewport);
+
+	const std::size_t channels = mySettings.withAlpha ? 4 : 3;
+	const std::size_t width = static_cast<std::size_t>(viewport[2]);
+	const std::size_t height = static_cast<std::size_t>(viewport[3]);
+
+	if (0 == width || 0 == height)
+	{
+		return false;
+	}
+
+	try
+	{
+		std::vector<std::uint8_t> pixels(width * height * channels);
+
+		::glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		::glReadPixels(viewport[0], viewport[1], viewport[2], viewport[3]
+			, mySettings.withAlpha ? GL_RGBA : GL_RGB
+			, GL_UNSIGNED_BYTE, pixels.data());
+
+		FlipRows(pixels, width * channels, height);
+
+		std::vector<std::uint8_t> encoded{};
+		if (not capture::EncodePng(pixels.data(), width, height, channels, encoded, mySettings.encoderThreads))
+		{
+			return false;
+		}
+
+		return WriteFile(path, encoded);
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+const gl::capture::Statistics&
+gl::FrameCapture::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+bool
+gl::FrameCapture::IsRunning()
+const noexcept
+{
+	return isRunning;
+}
+
+bool
+gl::FrameCapture::Resolve(Slot& slot, bool wait)
+noexcept
+{
+	const GLsync fence = static_cast<GLsync>(slot.fence);
+	const GLuint64 timeout = wait ? GL_TIMEOUT_IGNORED : 0;
+
+	const GLenum status = ::glClientWaitSync(fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+	if (not wait && GL_TIMEOUT_EXPIRED == status)
+	{
+		// Still in flight
+		return false;
+	}
+
+	// The fence is spent however the wait ended, a failed one loses the frame
+	::glDeleteSync(fence);
+	slot.fence = nullptr;
+
+	if (GL_ALREADY_SIGNALED != status && GL_CONDITION_SATISFIED != status)
+	{
+		++myStatistics.droppedFrames;
+		return false;
+	}
+
+	if (mySettings.maxEncodings <= myEncodings.size())
+	{
+		Collect(false);
+
+		if (mySettings.maxEncodings <= myEncodings.size())
+		{
+			++myStatistics.droppedFrames;
+			return true;
+		}
+	}
+
+	try
+	{
+		std::vector<std::uint8_t> pixels(myFrameBytes);
+
+		::glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		const void* mapped = ::glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(myFrameBytes), GL_MAP_READ_BIT);
+		if (nullptr != mapped)
+		{
+			std::copy_n(static_cast<const std::uint8_t*>(mapped), myFrameBytes, pixels.data());
+			::glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		::glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		if (nullptr == mapped)
+		{
+			++myStatistics.failedFrames;
+			return true;
+		}
+
+		const std::size_t width = static_cast<std::size_t>(myArea.w);
+		const std::size_t height = static_cast<std::size_t>(myArea.h);
+		const std::size_t channels = mySettings.withAlpha ? 4 : 3;
+		const std::uint32_t threads = myEncoderThreads;
+
+		myEncodings.push_back(std::async(std::launch::async
+			, [pixels = std::move(pixels), path = MakeFilePath(slot.frame), width, height, channels, threads]() mutable -> Encoding {
+			using clock = std::chrono::steady_clock;
+
+			Encoding result{};
+			result.rawBytes = pixels.size();
+
+			const auto begin = clock::now();
+
+			// opengl reads from the bottom row
+			FlipRows(pixels, width * channels, height);
+
+			std::vector<std::uint8_t> encoded{};
+			if (fpng::fpng_encode_image_to_memory_parallel(pixels.data(), width, height, channels, encoded, threads))
+			{
+				result.encodedBytes = encoded.size();
+				result.seconds = std::chrono::duration<double>(clock::now() - begin).count();
+				result.succeed = WriteFile(path, encoded);
+			}
+
+			return result;
+		}));
+	}
+	catch (...)
+	{
+		++myStatistics.failedFrames;
+	}
+
+	return true;
+}
+
+void
+gl::FrameCapture::Collect(bool wait)
+noexcept
+{
+	while (not myEncodings.empty())
+	{
+		std::future<Encoding>& front = myEncodings.front();
+
+		if (not wait && std::future_status::ready != front.wait_for(std::chrono::seconds{ 0 }))
+		{
+			break;
+		}
+
+		const Encoding result = front.get();
+		myEncodings.pop_front();
+
+		if (result.succeed)
+		{
+			++myStatistics.encodedFrames;
+			myStatistics.rawBytes += result.rawBytes;
+			myStatistics.encodedBytes += result.encodedBytes;
+			myStatistics.encodeSeconds += result.seconds;
+		}
+		else
+		{
+			++myStatistics.failedFrames;
+		}
+	}
+}
+
+std::filesystem::path
+gl::FrameCapture::MakeFilePath(std::uint64_t frame)
+const
+{
+	return mySettings.directory / std::format("{}_{:06}.png", mySettings.prefix, frame);
+}
@@ -0,0 +1,742 @@
+module;
+#define NOMINMAX
+#include <Windows.h>
+#include "glew.h"
+#include <gl\gl.h>
+module Glib.FrameGraph;
+import <algorithm>;
+import <array>;
+import <utility>;
+import <chrono>;
+import <random>;
+
+std::uint32_t
+gl::graph::GetBarrierBits(gl::graph::Usage usage)
+noexcept
+{
+	switch (usage)
+	{
+		case Usage::Attachment:
+		return FramebufferBarrier;
+
+		case Usage::Sampled:
+		return TextureFetchBarrier;
+
+		case Usage::Image:
+		return ShaderImageAccessBarrier;
+
+		case Usage::StorageBuffer:
+		return ShaderStorageBarrier;
+
+		case Usage::Uniform:
+		return UniformBarrier;
+
+		case Usage::Vertex:
+		return VertexAttribBarrier;
+
+		case Usage::Index:
+		return ElementArrayBarrier;
+
+		case Usage::Indirect:
+		return CommandBarrier;
+
+		default:
+		return NoBarrier;
+	}
+}
+
+gl::FrameGraph::FrameGraph()
+noexcept
+{}
+
+gl::FrameGraph::~FrameGraph()
+noexcept
+{}
+
+void
+gl::FrameGraph::Reset()
+noexcept
+{
+	myResources.clear();
+	myPasses.clear();
+	mySchedule.clear();
+	myAcquires.clear();
+	myReleases.clear();
+	myStatistics = {};
+}
+
+gl::graph::ResourceId
+gl::FrameGraph::CreateTarget(std::string_view name, const gl::target::Description& description)
+{
+	myResources.push_back(Resource{ std::string{ name }, description, nullptr, false });
+
+	return static_cast<graph::ResourceId>(myResources.size() - 1);
+}
+
+gl::graph::ResourceId
+gl::FrameGraph::ImportTarget(std::string_view name, const gl::RenderTarget* target)
+{
+	myResources.push_back(Resource{ std::string{ name }, nullptr != target ? target->GetDescription() : target::Description{}, target, true });
+
+	return static_cast<graph::ResourceId>(myResources.size() - 1);
+}
+
+gl::graph::ResourceId
+gl::FrameGraph::ImportBuffer(std::string_view name)
+{
+	myResources.push_back(Resource{ std::string{ name }, {}, nullptr, true });
+
+	return static_cast<graph::ResourceId>(myResources.size() - 1);
+}
+
+gl::graph::PassId
+gl::FrameGraph::AddPass(std::string_view name, gl::FrameGraph::executor_t&& executor)
+{
+	myPasses.push_back(Pass{ std::string{ name }, std::move(executor), {}, false });
+
+	return static_cast<graph::PassId>(myPasses.size() - 1);
+}
+
+void
+gl::FrameGraph::Read(gl::graph::PassId pass, gl::graph::ResourceId resource, gl::graph::Usage usage)
+{
+	myPasses[pass].accesses.push_back(Access{ resource, usage, false });
+}
+
+void
+gl::FrameGraph::Write(gl::graph::PassId pass, gl::graph::ResourceId resource, gl::graph::Usage usage)
+{
+	myPasses[pass].accesses.push_back(Access{ resource, usage, true });
+}
+
+void
+gl::FrameGraph::SetSideEffect(gl::graph::PassId pass)
+noexcept
+{
+	myPasses[pass].hasSideEffect = true;
+}
+
+void
+gl::FrameGraph::Compile()
+{
+	const std::size_t pass_count = myPasses.size();
+	const std::size_t resource_count = myResources.size();
+
+	myStatistics = {};
+	myStatistics.passes = static_cast<std::uint32_t>(pass_count);
+	myStatistics.resources = static_cast<std::uint32_t>(resource_count);
+
+	mySuccessors.resize(pass_count);
+	myProducers.resize(pass_count);
+	for (std::size_t i = 0; i < pass_count; ++i)
+	{
+		mySuccessors[i].clear();
+		myProducers[i].clear();
+	}
+
+	// A read depends on the last writer of the resource before it
+	std::vector<graph::PassId> writers(resource_count, graph::Invalid);
+
+	for (graph::PassId pass = 0; pass < pass_count; ++pass)
+	{
+		for (const Access& access : myPasses[pass].accesses)
+		{
+			const graph::PassId writer = writers[access.resource];
+			if (!access.isWrite && graph::Invalid != writer && writer != pass)
+			{
+				myProducers[pass].push_back(writer);
+			}
+		}
+
+		for (const Access& access : myPasses[pass].accesses)
+		{
+			if (access.isWrite)
+			{
+				writers[access.resource] = pass;
+			}
+		}
+	}
+
+	// Walk back from the passes which matter outside of the graph
+	myLivePasses.assign(pass_count, false);
+
+	std::vector<graph::PassId> stack{};
+	for (graph::PassId pass = 0; pass < pass_count; ++pass)
+	{
+		const Pass& info = myPasses[pass];
+
+		const bool is_root = info.hasSideEffect || std::ranges::any_of(info.accesses, [&](const Access& access) noexcept {
+			return access.isWrite && myResources[access.resource].isImported;
+		});
+
+		if (is_root)
+		{
+			myLivePasses[pass] = true;
+			stack.push_back(pass);
+		}
+	}
+
+	while (!stack.empty())
+	{
+		const graph::PassId pass = stack.back();
+		stack.pop_back();
+
+		for (const graph::PassId producer : myProducers[pass])
+		{
+			if (!myLivePasses[producer])
+			{
+				myLivePasses[producer] = true;
+				stack.push_back(producer);
+			}
+		}
+	}
+
+	// Between the live passes, a read waits for the last writer,
+	// and a write waits for the last writer and for every reader since then
+	std::vector<std::vector<graph::PassId>> readers(resource_count);
+	writers.assign(resource_count, graph::Invalid);
+
+	for (graph::PassId pass = 0; pass < pass_count; ++pass)
+	{
+		if (!myLivePasses[pass])
+		{
+			continue;
+		}
+
+		for (const Access& access : myPasses[pass].accesses)
+		{
+			const graph::PassId writer = writers[access.resource];
+			if (!access.isWrite && graph::Invalid != writer && writer != pass)
+			{
+				mySuccessors[writer].push_back(pass);
+			}
+
+			if (!access.isWrite)
+			{
+				readers[access.resource].push_back(pass);
+			}
+		}
+
+		for (const Access& access : myPasses[pass].accesses)
+		{
+			if (!access.isWrite)
+			{
+				continue;
+			}
+
+			const graph::PassId writer = writers[access.resource];
+			if (graph::Invalid != writer && writer != pass)
+			{
+				mySuccessors[writer].push_back(pass);
+			}
+
+			for (const graph::PassId reader : readers[access.resource])
+			{
+				if (reader != pass)
+				{
+					mySuccessors[reader].push_back(pass);
+				}
+			}
+
+			readers[access.resource].clear();
+			writers[access.resource] = pass;
+		}
+	}
+
+	myStatistics.culledPasses = static_cast<std::uint32_t>(std::ranges::count(myLivePasses, false));
+
+	Schedule();
+	AssignLifetimes();
+	PlaceBarriers();
+}
+
+void
+gl::FrameGraph::Execute(gl::TransientTargets& targets)
+{
+	myTargets = std::addressof(targets);
+	myHandles.assign(myResources.size(), target::InvalidHandle);
+
+	for (const graph::ScheduledPass& scheduled : mySchedule)
+	{
+		if (graph::NoBarrier != scheduled.barriers)
+		{
+			::glMemoryBarrier(scheduled.barriers);
+		}
+
+		for (const graph::ResourceId resource : GetAcquired(scheduled))
+		{
+			myHandles[resource] = targets.Acquire(myResources[resource].description);
+		}
+
+		if (executor_t& executor = myPasses[scheduled.pass].executor; executor)
+		{
+			executor();
+		}
+
+		for (const graph::ResourceId resource : GetReleased(scheduled))
+		{
+			targets.Release(myHandles[resource]);
+			myHandles[resource] = target::InvalidHandle;
+		}
+	}
+
+	myTargets = nullptr;
+}
+
+const gl::RenderTarget*
+gl::FrameGraph::GetTarget(gl::graph::ResourceId resource)
+const noexcept
+{
+	const Resource& info = myResources[resource];
+	if (info.isImported)
+	{
+		return info.imported;
+	}
+
+	if (nullptr == myTargets || target::InvalidHandle == myHandles[resource])
+	{
+		return nullptr;
+	}
+
+	return std::addressof(myTargets->GetTarget(myHandles[resource]));
+}
+
+const gl::Framebuffer&
+gl::FrameGraph::GetFramebuffer(std::span<const gl::graph::ResourceId> colours, gl::graph::ResourceId depth)
+{
+	std::array<target::Handle, target::MaxColourAttachments> handles{};
+
+	const std::size_t count = std::min(colours.size(), handles.size());
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		handles[i] = myHandles[colours[i]];
+	}
+
+	return myTargets->GetFramebuffer(std::span{ handles.data(), count }, graph::Invalid != depth ? myHandles[depth] : target::InvalidHandle);
+}
+
+std::span<const gl::graph::ScheduledPass>
+gl::FrameGraph::GetSchedule()
+const noexcept
+{
+	return mySchedule;
+}
+
+std::span<const gl::graph::ResourceId>
+gl::FrameGraph::GetAcquired(const gl::graph::ScheduledPass& pass)
+const noexcept
+{
+	return std::span{ myAcquires }.subspan(pass.firstAcquire, pass.acquireCount);
+}
+
+std::span<const gl::graph::ResourceId>
+gl::FrameGraph::GetReleased(const gl::graph::ScheduledPass& pass)
+const noexcept
+{
+	return std::span{ myReleases }.subspan(pass.firstRelease, pass.releaseCount);
+}
+
+gl::graph::Lifetime
+gl::FrameGraph::GetLifetime(gl::graph::ResourceId resource)
+const noexcept
+{
+	return myLifetimes[resource];
+}
+
+bool
+gl::FrameGraph::IsCulled(gl::graph::PassId pass)
+const noexcept
+{
+	return !myLivePasses[pass];
+}
+
+std::string_view
+gl::FrameGraph::GetPassName(gl::graph::PassId pass)
+const noexcept
+{
+	return myPasses[pass].name;
+}
+
+std::string_view
+gl::FrameGraph::GetResourceName(gl::graph::ResourceId resource)
+const noexcept
+{
+	return myResources[resource].name;
+}
+
+const gl::graph::Statistics&
+gl::FrameGraph::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+void
+gl::FrameGraph::Schedule()
+{
+	const std::size_t pass_count = myPasses.size();
+
+	myPredecessorCounts.assign(pass_count, 0);
+	for (graph::PassId pass = 0; pass < pass_count; ++pass)
+	{
+		if (!myLivePasses[pass])
+		{
+			continue;
+		}
+
+		for (const graph::PassId successor : mySuccessors[pass])
+		{
+			++myPredecessorCounts[successor];
+		}
+	}
+
+	// Accesses of each transient resource left to schedule
+	std::vector<std::uint32_t> remaining(myResources.size(), 0);
+	std::vector<bool> started(myResources.size(), false);
+
+	for (graph::PassId pass = 0; pass < pass_count; ++pass)
+	{
+		if (myLivePasses[pass])
+		{
+			for (const Access& access : myPasses[pass].accesses)
+			{
+				++remaining[access.resource];
+			}
+		}
+	}
+
+	std::vector<graph::PassId> ready{};
+	for (graph::PassId pass = 0; pass < pass_count; ++pass)
+	{
+		if (myLivePasses[pass] && 0 == myPredecessorCounts[pass])
+		{
+			ready.push_back(pass);
+		}
+	}
+
+	// Bytes a pass frees by ending lifetimes, minus the bytes it starts
+	const auto score = [&](graph::PassId pass) noexcept {
+		const std::vector<Access>& accesses = myPasses[pass].accesses;
+
+		std::int64_t result = 0;
+		for (std::size_t i = 0; i < accesses.size(); ++i)
+		{
+			const graph::ResourceId resource = accesses[i].resource;
+			const Resource& info = myResources[resource];
+
+			if (info.isImported || std::any_of(accesses.begin(), accesses.begin() + i, [resource](const Access& other) noexcept { return other.resource == resource; }))
+			{
+				continue;
+			}
+
+			const std::uint32_t uses = static_cast<std::uint32_t>(std::count_if(accesses.begin() + i, accesses.end(), [resource](const Access& other) noexcept { return other.resource == resource; }));
+			const std::int64_t bytes = static_cast<std::int64_t>(target::GetByteSize(info.description));
+
+			if (!started[resource])
+			{
+				result -= bytes;
+			}
+
+			if (remaining[resource] == uses)
+			{
+				result += bytes;
+			}
+		}
+
+		return result;
+	};
+
+	mySchedule.clear();
+	while (!ready.empty())
+	{
+		std::size_t best = 0;
+		std::int64_t best_score = score(ready[0]);
+
+		for (std::size_t i = 1; i < ready.size(); ++i)
+		{
+			const std::int64_t candidate = score(ready[i]);
+			if (best_score < candidate || (best_score == candidate && ready[i] < ready[best]))
+			{
+				best = i;
+				best_score = candidate;
+			}
+		}
+
+		const graph::PassId pass = ready[best];
+		ready[best] = ready.back();
+		ready.pop_back();
+
+		mySchedule.push_back(graph::ScheduledPass{ pass, graph::NoBarrier, 0, 0, 0, 0 });
+
+		for (const Access& access : myPasses[pass].accesses)
+		{
+			--remaining[access.resource];
+			started[access.resource] = true;
+		}
+
+		for (const graph::PassId successor : mySuccessors[pass])
+		{
+			if (0 == --myPredecessorCounts[successor])
+			{
+				ready.push_back(successor);
+			}
+		}
+	}
+}
+
+void
+gl::FrameGraph::AssignLifetimes()
+{
+	const std::size_t resource_count = myResources.size();
+	const std::uint32_t position_count = static_cast<std::uint32_t>(mySchedule.size());
+
+	myLifetimes.assign(resource_count, graph::Lifetime{});
+
+	for (std::uint32_t position = 0; position < position_count; ++position)
+	{
+		for (const Access& access : myPasses[mySchedule[position].pass].accesses)
+		{
+			graph::Lifetime& lifetime = myLifetimes[access.resource];
+
+			lifetime.first = std::min(lifetime.first, position);
+			lifetime.last = graph::Invalid == lifetime.last ? position : std::max(lifetime.last, position);
+		}
+	}
+
+	// Count the acquisitions and releases of each position, then fill them in resource order
+	for (graph::ScheduledPass& scheduled : mySchedule)
+	{
+		scheduled.acquireCount = 0;
+		scheduled.releaseCount = 0;
+	}
+
+	for (graph::ResourceId resource = 0; resource < resource_count; ++resource)
+	{
+		const graph::Lifetime& lifetime = myLifetimes[resource];
+		if (myResources[resource].isImported || graph::Invalid == lifetime.first)
+		{
+			continue;
+		}
+
+		++mySchedule[lifetime.first].acquireCount;
+		++mySchedule[lifetime.last].releaseCount;
+		++myStatistics.transientResources;
+		myStatistics.unaliasedBytes += target::GetByteSize(myResources[resource].description);
+	}
+
+	std::uint32_t acquires = 0, releases = 0;
+	for (graph::ScheduledPass& scheduled : mySchedule)
+	{
+		scheduled.firstAcquire = acquires;
+		scheduled.firstRelease = releases;
+		acquires += scheduled.acquireCount;
+		releases += scheduled.releaseCount;
+
+		scheduled.acquireCount = 0;
+		scheduled.releaseCount = 0;
+	}
+
+	myAcquires.resize(acquires);
+	myReleases.resize(releases);
+
+	for (graph::ResourceId resource = 0; resource < resource_count; ++resource)
+	{
+		const graph::Lifetime& lifetime = myLifetimes[resource];
+		if (myResources[resource].isImported || graph::Invalid == lifetime.first)
+		{
+			continue;
+		}
+
+		graph::ScheduledPass& first = mySchedule[lifetime.first];
+		myAcquires[first.firstAcquire + first.acquireCount++] = resource;
+
+		graph::ScheduledPass& last = mySchedule[lifetime.last];
+		myReleases[last.firstRelease + last.releaseCount++] = resource;
+	}
+
+	// Replay the allocations the way TransientTargets serves them, to count the targets and the peak
+	std::vector<std::pair<target::Description, std::uint32_t>> free_targets{};
+	std::uint64_t bytes = 0;
+
+	for (const graph::ScheduledPass& scheduled : mySchedule)
+	{
+		for (const graph::ResourceId resource : GetAcquired(scheduled))
+		{
+			const target::Description& description = myResources[resource].description;
+
+			auto it = std::ranges::find_if(free_targets, [&](const auto& entry) noexcept {
+				return entry.first == description && 0 < entry.second;
+			});
+
+			if (it != free_targets.end())
+			{
+				--it->second;
+			}
+			else
+			{
+				++myStatistics.physicalTargets;
+			}
+
+			bytes += target::GetByteSize(description);
+		}
+
+		myStatistics.peakBytes = std::max(myStatistics.peakBytes, bytes);
+
+		for (const graph::ResourceId resource : GetReleased(scheduled))
+		{
+			const target::Description& description = myResources[resource].description;
+
+			auto it = std::ranges::find_if(free_targets, [&](const auto& entry) noexcept {
+				return entry.first == description;
+			});
+
+			if (it != free_targets.end())
+			{
+				++it->second;
+			}
+			else
+			{
+				free_targets.emplace_back(description, 1U);
+			}
+
+			bytes -= target::GetByteSize(description);
+		}
+	}
+}
+
+void
+gl::FrameGraph::PlaceBarriers()
+{
+	// Resources whose last write went around the framebuffer, and the barriers issued since
+	std::vector<bool> pending(myResources.size(), false);
+	std::vector<std::uint32_t> issued(myResources.size(), graph::NoBarrier);
+	std::vector<graph::ResourceId> pending_resources{};
+
+	for (graph::ScheduledPass& scheduled : mySchedule)
+	{
+		const std::vector<Access>& accesses = myPasses[scheduled.pass].accesses;
+
+		std::uint32_t barriers = graph::NoBarrier;
+		for (const Access& access : accesses)
+		{
+			const std::uint32_t bits = graph::GetBarrierBits(access.usage);
+			if (pending[access.resource] && 0 == (issued[access.resource] & bits))
+			{
+				barriers |= bits;
+			}
+		}
+
+		// A barrier covers every earlier write, not only the ones of this pass
+		if (graph::NoBarrier != barriers)
+		{
+			scheduled.barriers = barriers;
+			++myStatistics.barriers;
+
+			for (const graph::ResourceId resource : pending_resources)
+			{
+				issued[resource] |= barriers;
+			}
+		}
+
+		for (const Access& access : accesses)
+		{
+			if (!access.isWrite)
+			{
+				continue;
+			}
+
+			const bool is_incoherent = graph::Usage::Image == access.usage || graph::Usage::StorageBuffer == access.usage;
+			if (is_incoherent && !pending[access.resource])
+			{
+				pending_resources.push_back(access.resource);
+			}
+
+			pending[access.resource] = is_incoherent;
+			issued[access.resource] = graph::NoBarrier;
+		}
+
+		std::erase_if(pending_resources, [&](graph::ResourceId resource) noexcept {
+			return !pending[resource];
+		});
+	}
+}
+
+gl::graph::Benchmark
+gl::graph::MeasureCompilation(std::uint32_t passes, std::uint32_t iterations)
+{
+	std::mt19937 engine{ 0x5EED };
+	std::uniform_int_distribution<std::uint32_t> size{ 0, 2 }, reads{ 1, 3 }, distance{ 1, 8 };
+	std::bernoulli_distribution compute{ 0.2 }, output{ 0.05 };
+
+	const target::Description descriptions[]{
+		{ 1920, 1080, target::Format::RGBA16F },
+		{ 960, 540, target::Format::RGBA16F },
+		{ 1920, 1080, target::Format::Depth24Stencil8 },
+	};
+
+	// The same random graph every iteration
+	struct Declaration
+	{
+		std::uint32_t description;
+		std::vector<std::uint32_t> inputs;
+		bool isCompute;
+		bool isOutput;
+	};
+
+	std::vector<Declaration> declarations(passes);
+	for (std::uint32_t pass = 0; pass < passes; ++pass)
+	{
+		Declaration& declaration = declarations[pass];
+		declaration.description = size(engine);
+		declaration.isCompute = compute(engine);
+		declaration.isOutput = output(engine) || pass + 1 == passes;
+
+		const std::uint32_t count = pass == 0 ? 0 : reads(engine);
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			declaration.inputs.push_back(pass - std::min(pass, distance(engine)));
+		}
+	}
+
+	FrameGraph graph{};
+
+	Benchmark result{};
+	result.passes = passes;
+	result.seconds = std::numeric_limits<double>::max();
+
+	for (std::uint32_t i = 0; i < std::max(1U, iterations); ++i)
+	{
+		graph.Reset();
+
+		const ResourceId backbuffer = graph.ImportTarget("Backbuffer", nullptr);
+		for (std::uint32_t pass = 0; pass < passes; ++pass)
+		{
+			const Declaration& declaration = declarations[pass];
+
+			const PassId id = graph.AddPass("Pass", {});
+			const ResourceId output = graph.CreateTarget("Target", descriptions[declaration.description]);
+
+			// Resources are created in pass order, after the backbuffer
+			for (const std::uint32_t input : declaration.inputs)
+			{
+				graph.Read(id, input + 1, Usage::Sampled);
+			}
+
+			graph.Write(id, output, declaration.isCompute ? Usage::Image : Usage::Attachment);
+
+			if (declaration.isOutput)
+			{
+				graph.Write(id, backbuffer, Usage::Attachment);
+			}
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		graph.Compile();
+		result.seconds = std::min(result.seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	result.passesPerSecond = static_cast<double>(passes) / result.seconds;
+	result.statistics = graph.GetStatistics();
+
+	return result;
+}
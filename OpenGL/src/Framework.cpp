@@ -9,6 +9,7 @@ import Glib.Windows.Context;
 import Glib.Windows.Context.Renderer;
 import Glib.Windows.Client;
 import Glib.Windows.Client.Factory;
+import Glib.DirtyRegion;
 
 void ReadyDisplay() noexcept;
 
@@ -133,15 +134,50 @@ noexcept
 {
 	myInstance->SetRenderer(
 		[this, localRenderer = std::move(handler)](
-		[[maybe_unused]] ManagedWindow& window,
+		ManagedWindow& window,
 		gl::win32::IContext& ctx) noexcept {
 
-		glSystem->BeginRendering(ctx);
+		if (nullptr != myResidency)
+		{
+			myResidency->BeginFrame();
+		}
+
+		glSystem->BeginRendering(ctx, window.GetFrameRegion().GetBounds());
 		localRenderer();
 		glSystem->EndRendering();
+
+		// The resources drawn in this frame are touched, the others may go
+		if (nullptr != myResidency)
+		{
+			myResidency->Enforce();
+		}
 	});
 }
 
+void
+gl::Framework::SetProfiler(gl::GpuProfiler* profiler)
+noexcept
+{
+	glSystem->SetProfiler(profiler);
+}
+
+void
+gl::Framework::SetResidencyManager(gl::ResidencyManager* manager)
+noexcept
+{
+	if (nullptr != myResidency)
+	{
+		myResidency->Uninstall();
+	}
+
+	myResidency = manager;
+
+	if (nullptr != myResidency)
+	{
+		myResidency->Install();
+	}
+}
+
 gl::Framework::handle_t&
 gl::Framework::GetHandle()
 noexcept
@@ -1,12 +1,43 @@
 ﻿module;
 #include <Windows.h>
 #include <atlimage.h>
+#include "../fpng.h"
 #undef LoadImage
 
 module Glib.Image;
 import <cstdint>;
 import <cstdio>;
 import <stdexcept>;
+import <fstream>;
+import <vector>;
+import Glib.Png;
+
+static std::size_t
+ReadPngStream(void* user, void* dst, std::size_t size)
+{
+	std::ifstream& stream = *static_cast<std::ifstream*>(user);
+	stream.read(static_cast<char*>(dst), static_cast<std::streamsize>(size));
+
+	return static_cast<std::size_t>(stream.gcount());
+}
+
+static bool
+WritePngRow(void* user, const std::uint8_t* row, std::size_t y, std::size_t width, std::size_t height, std::size_t)
+{
+	gl::Image::buffer_t& buffer = *static_cast<gl::Image::buffer_t*>(user);
+	if (nullptr == buffer)
+	{
+		buffer = std::make_unique<gl::BitmapPixel[]>(width * height);
+	}
+
+	gl::BitmapPixel* const pixels = buffer.get() + y * width;
+	for (std::size_t x = 0; x < width; ++x, row += 4)
+	{
+		pixels[x] = gl::BitmapPixel{ gl::Colour{ row[0], row[1], row[2], row[3] } };
+	}
+
+	return true;
+}
 
 gl::Image
 gl::LoadImage(const gl::FilePath& filepath)
@@ -16,6 +47,19 @@ gl::LoadImage(const gl::FilePath& filepath)
 
 gl::Image::Image(const gl::FilePath& filepath)
 {
+	// Every png goes through fpng or the generic decoder, ATL only handles the other formats
+	if (png::HasPngExtension(filepath))
+	{
+		if (not TryLoadPng(filepath))
+		{
+			std::wprintf(L"Failed to load image: %s\n", filepath.c_str());
+			throw std::runtime_error{ "Failed to load image" };
+		}
+
+		std::wprintf(L"Loaded image: %s\n", filepath.c_str());
+		return;
+	}
+
 	ATL::CImage image{};
 
 	HRESULT check = image.Load(filepath.c_str());
@@ -75,6 +119,78 @@ gl::Image::Image(const gl::FilePath& filepath)
 	image.Destroy();
 }
 
+bool
+gl::Image::TryLoadPng(const gl::FilePath& filepath)
+noexcept
+{
+	std::ifstream stream{ filepath, std::ios::binary };
+	if (not stream)
+	{
+		return false;
+	}
+
+	// Rows go straight into the pixel buffer, the file and the decoded image never coexist in memory
+	buffer_t buffer = nullptr;
+	std::size_t width = 0, height = 0, channels = 0;
+
+	try
+	{
+		fpng::fpng_init();
+
+		const int status = fpng::fpng_decode_stream(ReadPngStream, std::addressof(stream)
+			, WritePngRow, std::addressof(buffer)
+			, width, height, channels, 4);
+
+		if (fpng::FPNG_DECODE_NOT_FPNG == status)
+		{
+			// Written by another encoder, decode the whole file at once
+			stream.clear();
+			stream.seekg(0, std::ios::end);
+			const std::streamoff file_size = stream.tellg();
+			stream.seekg(0, std::ios::beg);
+
+			if (file_size <= 0)
+			{
+				return false;
+			}
+
+			std::vector<std::uint8_t> file(static_cast<std::size_t>(file_size));
+			if (not stream.read(reinterpret_cast<char*>(file.data()), file_size))
+			{
+				return false;
+			}
+
+			std::vector<std::uint8_t> rgba{};
+			if (png::DecodeResult::Success != png::Decode(file.data(), file.size(), rgba, width, height))
+			{
+				return false;
+			}
+
+			buffer = std::make_unique<gl::BitmapPixel[]>(width * height);
+			for (std::size_t y = 0; y < height; ++y)
+			{
+				(void)WritePngRow(std::addressof(buffer), rgba.data() + y * width * 4, y, width, height, 4);
+			}
+		}
+		else if (fpng::FPNG_DECODE_SUCCESS != status)
+		{
+			return false;
+		}
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	imgBuffer = std::move(buffer);
+	imgHSize = width;
+	imgVSize = height;
+	imgBufferSize = width * height * 4;
+	bitsPerPixel = 32;
+
+	return true;
+}
+
 gl::Image::buffer_t&
 gl::Image::GetBuffer()
 noexcept
@@ -1,18 +1,83 @@
 module;
 module Glib;
+import <algorithm>;
+import <array>;
 import <type_traits>;
 import :IndexBuffer;
+import Glib.MeshOptimizer;
+
+// Indices narrowed at once on the stack, larger lists are uploaded by pieces of this size
+static constexpr std::size_t NarrowingChunk = 4096;
+
+static void
+Narrow(std::span<const std::uint32_t> indices, std::uint16_t* output)
+noexcept
+{
+	std::ranges::transform(indices, output, [](std::uint32_t index) noexcept {
+		return static_cast<std::uint16_t>(index);
+	});
+}
 
 void
 gl::IndexBuffer::Create(std::initializer_list<std::int32_t> list, buffer::BufferUsage usage)
 noexcept 
 {
-	base::Create(buffer::BufferType::ElementArray, usage, list.begin(), list.size());
+	Upload(std::span<const std::uint32_t>{ reinterpret_cast<const std::uint32_t*>(list.begin()), list.size() }, usage);
 }
 
 void
 gl::IndexBuffer::Create(std::initializer_list<std::uint32_t> list, buffer::BufferUsage usage)
 noexcept
 {
-	base::Create(buffer::BufferType::ElementArray, usage, list.begin(), list.size());
+	Upload(std::span<const std::uint32_t>{ list.begin(), list.size() }, usage);
+}
+
+void
+gl::IndexBuffer::Upload(std::span<const std::uint32_t> indices, buffer::BufferUsage usage)
+noexcept
+{
+	if (mesh::FitsShortIndices(indices))
+	{
+		std::array<std::uint16_t, NarrowingChunk> narrow;
+
+		if (indices.size() <= NarrowingChunk)
+		{
+			Narrow(indices, narrow.data());
+
+			Upload(std::span<const std::uint16_t>{ narrow.data(), indices.size() }, usage);
+			return;
+		}
+
+		base::Create(buffer::BufferType::ElementArray, usage, nullptr, indices.size() * sizeof(std::uint16_t));
+
+		for (std::size_t first = 0; first < indices.size(); first += NarrowingChunk)
+		{
+			const std::size_t count = std::min(NarrowingChunk, indices.size() - first);
+			Narrow(indices.subspan(first, count), narrow.data());
+
+			base::CopyFrom(narrow.data(), count * sizeof(std::uint16_t), static_cast<std::ptrdiff_t>(first * sizeof(std::uint16_t)));
+		}
+
+		// CopyFrom keeps the size of the last piece
+		mySize = indices.size() * sizeof(std::uint16_t);
+		myIndexType = buffer::IndexType::UnsignedShort;
+		myCount = indices.size();
+	}
+	else
+	{
+		base::Create(buffer::BufferType::ElementArray, usage, indices.data(), indices.size_bytes());
+
+		myIndexType = buffer::IndexType::UnsignedInt;
+		myCount = indices.size();
+	}
+}
+
+void
+gl::IndexBuffer::Upload(std::span<const std::uint16_t> indices, buffer::BufferUsage usage)
+noexcept
+{
+	base::Create(buffer::BufferType::ElementArray, usage, indices.data(), indices.size_bytes());
+
+	myIndexType = buffer::IndexType::UnsignedShort;
+	myCount = indices.size();
 }
@@ -0,0 +1,295 @@
+module Glib.Legacy.Batch;
+
+void
+gl::legacy::PrimitiveBatch::Begin(gl::Primitive mode)
+noexcept
+{
+	if (isRecording)
+	{
+		return;
+	}
+
+	myMode = mode;
+	myBlockStart = myVertices.size();
+	isRecording = true;
+}
+
+void
+gl::legacy::PrimitiveBatch::End()
+{
+	if (not isRecording)
+	{
+		return;
+	}
+
+	isRecording = false;
+
+	const std::size_t count = myVertices.size() - myBlockStart;
+	const std::uint32_t first = static_cast<std::uint32_t>(myBlockStart);
+
+	switch (myMode)
+	{
+		// Lists stay in place, only the incomplete tail goes away
+		case Primitive::Points:
+		{
+			Append(Primitive::Points, first, static_cast<std::uint32_t>(count));
+			return;
+		}
+
+		case Primitive::Lines:
+		{
+			myVertices.resize(myBlockStart + count - count % 2);
+			Append(Primitive::Lines, first, static_cast<std::uint32_t>(count - count % 2));
+			return;
+		}
+
+		case Primitive::Triangles:
+		{
+			myVertices.resize(myBlockStart + count - count % 3);
+			Append(Primitive::Triangles, first, static_cast<std::uint32_t>(count - count % 3));
+			return;
+		}
+
+		default:
+		break;
+	}
+
+	// The other modes are rebuilt from a copy of the block
+	myScratch.assign(myVertices.begin() + static_cast<std::ptrdiff_t>(myBlockStart), myVertices.end());
+	myVertices.resize(myBlockStart);
+
+	switch (myMode)
+	{
+		case Primitive::LineStrip:
+		case Primitive::LineLoop:
+		{
+			if (count < 2)
+			{
+				break;
+			}
+
+			for (std::size_t i = 0; i + 1 < count; ++i)
+			{
+				Emit(i);
+				Emit(i + 1);
+			}
+
+			if (Primitive::LineLoop == myMode)
+			{
+				Emit(count - 1);
+				Emit(0);
+			}
+		}
+		break;
+
+		case Primitive::TriangleStrip:
+		{
+			// Every other triangle swaps its first two vertices to keep the winding
+			for (std::size_t i = 0; i + 2 < count; ++i)
+			{
+				if (0 == i % 2)
+				{
+					Emit(i);
+					Emit(i + 1);
+				}
+				else
+				{
+					Emit(i + 1);
+					Emit(i);
+				}
+
+				Emit(i + 2);
+			}
+		}
+		break;
+
+		case Primitive::TriangleFan:
+		case Primitive::Polygon:
+		{
+			for (std::size_t i = 1; i + 1 < count; ++i)
+			{
+				Emit(0);
+				Emit(i);
+				Emit(i + 1);
+			}
+		}
+		break;
+
+		case Primitive::Quads:
+		{
+			for (std::size_t i = 0; i + 3 < count; i += 4)
+			{
+				Emit(i);
+				Emit(i + 1);
+				Emit(i + 2);
+
+				Emit(i);
+				Emit(i + 2);
+				Emit(i + 3);
+			}
+		}
+		break;
+
+		case Primitive::QuadStrip:
+		{
+			// The quad of each pair goes 2i, 2i + 1, 2i + 3, 2i + 2
+			for (std::size_t i = 0; i + 3 < count; i += 2)
+			{
+				Emit(i);
+				Emit(i + 1);
+				Emit(i + 3);
+
+				Emit(i);
+				Emit(i + 3);
+				Emit(i + 2);
+			}
+		}
+		break;
+
+		default:
+		break;
+	}
+
+	Append(GetTopology(myMode), first, static_cast<std::uint32_t>(myVertices.size() - myBlockStart));
+}
+
+void
+gl::legacy::PrimitiveBatch::AddVertex(float x, float y, float z)
+{
+	// Vertices outside of a block are ignored by opengl
+	if (not isRecording)
+	{
+		return;
+	}
+
+	BatchVertex& vertex = myVertices.emplace_back(myCurrent);
+	vertex.position[0] = x;
+	vertex.position[1] = y;
+	vertex.position[2] = z;
+}
+
+void
+gl::legacy::PrimitiveBatch::SetNormal(float x, float y, float z)
+noexcept
+{
+	myCurrent.normal[0] = x;
+	myCurrent.normal[1] = y;
+	myCurrent.normal[2] = z;
+}
+
+void
+gl::legacy::PrimitiveBatch::SetTexCoord(float s, float t)
+noexcept
+{
+	myCurrent.texcoord[0] = s;
+	myCurrent.texcoord[1] = t;
+}
+
+void
+gl::legacy::PrimitiveBatch::SetColour(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a)
+noexcept
+{
+	myCurrent.colour[0] = r;
+	myCurrent.colour[1] = g;
+	myCurrent.colour[2] = b;
+	myCurrent.colour[3] = a;
+}
+
+void
+gl::legacy::PrimitiveBatch::Clear()
+noexcept
+{
+	myVertices.clear();
+	myRanges.clear();
+	myBlockStart = 0;
+	isRecording = false;
+}
+
+std::span<const gl::legacy::BatchVertex>
+gl::legacy::PrimitiveBatch::GetVertices()
+const noexcept
+{
+	// The block being recorded isn't converted yet
+	return std::span<const BatchVertex>{ myVertices.data(), isRecording ? myBlockStart : myVertices.size() };
+}
+
+std::span<const gl::legacy::BatchRange>
+gl::legacy::PrimitiveBatch::GetRanges()
+const noexcept
+{
+	return myRanges;
+}
+
+const gl::legacy::BatchVertex&
+gl::legacy::PrimitiveBatch::GetCurrent()
+const noexcept
+{
+	return myCurrent;
+}
+
+bool
+gl::legacy::PrimitiveBatch::IsRecording()
+const noexcept
+{
+	return isRecording;
+}
+
+bool
+gl::legacy::PrimitiveBatch::IsEmpty()
+const noexcept
+{
+	return myRanges.empty();
+}
+
+gl::Primitive
+gl::legacy::PrimitiveBatch::GetTopology(gl::Primitive mode)
+noexcept
+{
+	switch (mode)
+	{
+		case Primitive::Points:
+		{
+			return Primitive::Points;
+		}
+
+		case Primitive::Lines:
+		case Primitive::LineLoop:
+		case Primitive::LineStrip:
+		{
+			return Primitive::Lines;
+		}
+
+		default:
+		{
+			return Primitive::Triangles;
+		}
+	}
+}
+
+void
+gl::legacy::PrimitiveBatch::Emit(std::size_t index)
+{
+	myVertices.push_back(myScratch[index]);
+}
+
+void
+gl::legacy::PrimitiveBatch::Append(gl::Primitive topology, std::uint32_t first, std::uint32_t count)
+{
+	if (0 == count)
+	{
+		return;
+	}
+
+	if (not myRanges.empty())
+	{
+		BatchRange& last = myRanges.back();
+
+		if (last.topology == topology && last.first + last.count == first)
+		{
+			last.count += count;
+			return;
+		}
+	}
+
+	myRanges.push_back(BatchRange{ topology, first, count });
+}
@@ -1,25 +1,253 @@
 module;
 #define NOMINMAX
 #include <Windows.h>
+#include "glew.h"
 #include <gl\gl.h>
+#include <cstddef>
 module Glib.Legacy.Primitive;
+import <algorithm>;
+import <cstring>;
+
+// Vertices recorded before the arena is flushed on its own
+static constexpr std::size_t FlushThreshold = 1U << 16;
+// Initial size of the streamed vertex buffer, it grows to the largest flush
+static constexpr GLsizeiptr DefaultStreamSize = 4 * 1024 * 1024;
+
+static gl::legacy::primitive::Backend currentBackend = gl::legacy::primitive::Backend::Immediate;
+static gl::legacy::PrimitiveBatch recordedBatch{};
+
+static GLuint streamBuffer = 0;
+static GLsizeiptr streamCapacity = 0;
+static GLsizeiptr streamOffset = 0;
+
+[[nodiscard]]
+static bool
+IsBatching()
+noexcept
+{
+	return gl::legacy::primitive::Backend::Batched == currentBackend;
+}
+
+[[nodiscard]]
+static std::uint8_t
+ToColourByte(double ratio)
+noexcept
+{
+	return static_cast<std::uint8_t>(std::clamp(ratio, 0.0, 1.0) * 255.0 + 0.5);
+}
+
+// Signed integers map to [-1, 1] as glColor and glNormal do
+[[nodiscard]]
+static double
+ToSignedRatio(std::int32_t value)
+noexcept
+{
+	return (2.0 * value + 1.0) / 4294967295.0;
+}
+
+static void
+RecordVertex(float x, float y, float z)
+noexcept
+{
+	try
+	{
+		recordedBatch.AddVertex(x, y, z);
+	}
+	catch (...)
+	{
+	}
+}
+
+static void
+StreamBatch(const gl::legacy::PrimitiveBatch& batch)
+noexcept
+{
+	using gl::legacy::BatchVertex;
+
+	const auto vertices = batch.GetVertices();
+	const GLsizeiptr bytes = static_cast<GLsizeiptr>(vertices.size_bytes());
+
+	GLint previous_buffer = 0;
+	::glGetIntegerv(GL_ARRAY_BUFFER_BINDING, std::addressof(previous_buffer));
+
+	if (0 == streamBuffer)
+	{
+		::glGenBuffers(1, std::addressof(streamBuffer));
+	}
+
+	::glBindBuffer(GL_ARRAY_BUFFER, streamBuffer);
+
+	// Orphan the storage when it's full, the driver keeps the old one alive for the draws in flight
+	if (streamCapacity < bytes || streamCapacity - streamOffset < bytes)
+	{
+		streamCapacity = std::max(std::max(streamCapacity, DefaultStreamSize), bytes);
+		streamOffset = 0;
+
+		::glBufferData(GL_ARRAY_BUFFER, streamCapacity, nullptr, GL_STREAM_DRAW);
+	}
+
+	void* mapped = ::glMapBufferRange(GL_ARRAY_BUFFER, streamOffset, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (nullptr != mapped)
+	{
+		std::memcpy(mapped, vertices.data(), static_cast<std::size_t>(bytes));
+		::glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	else
+	{
+		::glBufferSubData(GL_ARRAY_BUFFER, streamOffset, bytes, vertices.data());
+	}
+
+	const auto attribute = [](std::size_t member) noexcept -> const void* {
+		return reinterpret_cast<const void*>(static_cast<std::uintptr_t>(streamOffset) + member);
+	};
+
+	// The fixed function pipeline reads the arrays, so lighting, texturing and fog behave as in immediate mode
+	::glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+	::glEnableClientState(GL_VERTEX_ARRAY);
+	::glEnableClientState(GL_NORMAL_ARRAY);
+	::glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	::glEnableClientState(GL_COLOR_ARRAY);
+
+	::glVertexPointer(3, GL_FLOAT, sizeof(BatchVertex), attribute(offsetof(BatchVertex, position)));
+	::glNormalPointer(GL_FLOAT, sizeof(BatchVertex), attribute(offsetof(BatchVertex, normal)));
+	::glTexCoordPointer(2, GL_FLOAT, sizeof(BatchVertex), attribute(offsetof(BatchVertex, texcoord)));
+	::glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BatchVertex), attribute(offsetof(BatchVertex, colour)));
+
+	for (const gl::legacy::BatchRange& range : batch.GetRanges())
+	{
+		::glDrawArrays(static_cast<GLenum>(range.topology), static_cast<GLint>(range.first), static_cast<GLsizei>(range.count));
+	}
+
+	::glPopClientAttrib();
+	::glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(previous_buffer));
+
+	streamOffset += bytes;
+}
+
+// Arrays don't touch the current attributes, immediate mode leaves the last ones behind
+static void
+RestoreCurrent()
+noexcept
+{
+	const gl::legacy::BatchVertex& current = recordedBatch.GetCurrent();
+	::glColor4ubv(current.colour);
+	::glNormal3fv(current.normal);
+	::glTexCoord2fv(current.texcoord);
+}
+
+// The batch starts from the attributes the immediate calls left behind
+static void
+CaptureCurrent()
+noexcept
+{
+	GLfloat colour[4]{ 1.0f, 1.0f, 1.0f, 1.0f };
+	GLfloat normal[3]{ 0.0f, 0.0f, 1.0f };
+	GLfloat texcoord[4]{};
+	::glGetFloatv(GL_CURRENT_COLOR, colour);
+	::glGetFloatv(GL_CURRENT_NORMAL, normal);
+	::glGetFloatv(GL_CURRENT_TEXTURE_COORDS, texcoord);
+
+	recordedBatch.SetColour(ToColourByte(colour[0]), ToColourByte(colour[1]), ToColourByte(colour[2]), ToColourByte(colour[3]));
+	recordedBatch.SetNormal(normal[0], normal[1], normal[2]);
+	recordedBatch.SetTexCoord(texcoord[0], texcoord[1]);
+}
+
+// Draws the recorded vertices, false when there were none
+static bool
+DrawRecorded()
+noexcept
+{
+	if (recordedBatch.IsRecording() or recordedBatch.IsEmpty())
+	{
+		return false;
+	}
+
+	StreamBatch(recordedBatch);
+	recordedBatch.Clear();
+
+	return true;
+}
+
+void
+gl::legacy::primitive::SetBackend(gl::legacy::primitive::Backend backend)
+noexcept
+{
+	if (backend == currentBackend)
+	{
+		return;
+	}
+
+	if (IsBatching())
+	{
+		gl::global::SetStateListener(nullptr);
+
+		// The immediate calls carry on from the last recorded attributes, drawn or not
+		(void)DrawRecorded();
+		RestoreCurrent();
+	}
+
+	currentBackend = backend;
+
+	if (IsBatching())
+	{
+		CaptureCurrent();
+
+		gl::global::SetStateListener(Flush);
+	}
+}
+
+gl::legacy::primitive::Backend
+gl::legacy::primitive::GetBackend()
+noexcept
+{
+	return currentBackend;
+}
+
+void
+gl::legacy::primitive::Flush()
+noexcept
+{
+	if (not IsBatching())
+	{
+		return;
+	}
+
+	if (DrawRecorded())
+	{
+		RestoreCurrent();
+	}
+}
+
+const gl::legacy::PrimitiveBatch&
+gl::legacy::primitive::GetBatch()
+noexcept
+{
+	return recordedBatch;
+}
 
 gl::legacy::primitive::Context::Context(gl::Primitive mode)
 noexcept
 {
-	::glBegin(static_cast<GLenum>(mode));
+	Begin(mode);
 }
 
 gl::legacy::primitive::Context::~Context()
 noexcept
 {
-	::glEnd();
+	End();
 }
 
 void
 gl::legacy::primitive::Begin(gl::Primitive mode)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.Begin(mode);
+		return;
+	}
+
 	::glBegin(static_cast<GLenum>(mode));
 }
 
@@ -27,6 +255,25 @@ void
 gl::legacy::primitive::End()
 noexcept
 {
+	if (IsBatching())
+	{
+		try
+		{
+			recordedBatch.End();
+		}
+		catch (...)
+		{
+			recordedBatch.Clear();
+		}
+
+		if (FlushThreshold <= recordedBatch.GetVertices().size())
+		{
+			Flush();
+		}
+
+		return;
+	}
+
 	::glEnd();
 }
 
@@ -34,6 +281,12 @@ void
 gl::legacy::primitive::Vertex(std::int32_t x, std::int32_t y, std::int32_t z)
 noexcept
 {
+	if (IsBatching())
+	{
+		RecordVertex(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
+		return;
+	}
+
 	::glVertex3i(x, y, z);
 }
 
@@ -41,6 +294,12 @@ void
 gl::legacy::primitive::Vertex(float x, float y, float z)
 noexcept
 {
+	if (IsBatching())
+	{
+		RecordVertex(x, y, z);
+		return;
+	}
+
 	::glVertex3f(x, y, z);
 }
 
@@ -48,6 +307,12 @@ void
 gl::legacy::primitive::Vertex(double x, double y, double z)
 noexcept
 {
+	if (IsBatching())
+	{
+		RecordVertex(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
+		return;
+	}
+
 	::glVertex3d(x, y, z);
 }
 
@@ -55,13 +320,51 @@ void
 gl::legacy::primitive::Vertex(std::span<std::int32_t, 3> list)
 noexcept
 {
+	if (IsBatching())
+	{
+		RecordVertex(static_cast<float>(list[0]), static_cast<float>(list[1]), static_cast<float>(list[2]));
+		return;
+	}
+
 	::glVertex3iv(list.data());
 }
 
+void
+gl::legacy::primitive::Vertex(std::span<float, 3> list)
+noexcept
+{
+	if (IsBatching())
+	{
+		RecordVertex(list[0], list[1], list[2]);
+		return;
+	}
+
+	::glVertex3fv(list.data());
+}
+
+void
+gl::legacy::primitive::Vertex(std::span<double, 3> list)
+noexcept
+{
+	if (IsBatching())
+	{
+		RecordVertex(static_cast<float>(list[0]), static_cast<float>(list[1]), static_cast<float>(list[2]));
+		return;
+	}
+
+	::glVertex3dv(list.data());
+}
+
 void
 gl::legacy::primitive::Normal(std::int32_t x, std::int32_t y, std::int32_t z)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetNormal(static_cast<float>(ToSignedRatio(x)), static_cast<float>(ToSignedRatio(y)), static_cast<float>(ToSignedRatio(z)));
+		return;
+	}
+
 	::glNormal3i(x, y, z);
 }
 
@@ -69,6 +372,12 @@ void
 gl::legacy::primitive::Normal(float x, float y, float z)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetNormal(x, y, z);
+		return;
+	}
+
 	::glNormal3f(x, y, z);
 }
 
@@ -76,6 +385,12 @@ void
 gl::legacy::primitive::Normal(double x, double y, double z)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetNormal(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
+		return;
+	}
+
 	::glNormal3d(x, y, z);
 }
 
@@ -83,13 +398,51 @@ void
 gl::legacy::primitive::Normal(std::span<std::int32_t, 3> list)
 noexcept
 {
+	if (IsBatching())
+	{
+		Normal(list[0], list[1], list[2]);
+		return;
+	}
+
 	::glNormal3iv(list.data());
 }
 
+void
+gl::legacy::primitive::Normal(std::span<float, 3> list)
+noexcept
+{
+	if (IsBatching())
+	{
+		recordedBatch.SetNormal(list[0], list[1], list[2]);
+		return;
+	}
+
+	::glNormal3fv(list.data());
+}
+
+void
+gl::legacy::primitive::Normal(std::span<double, 3> list)
+noexcept
+{
+	if (IsBatching())
+	{
+		recordedBatch.SetNormal(static_cast<float>(list[0]), static_cast<float>(list[1]), static_cast<float>(list[2]));
+		return;
+	}
+
+	::glNormal3dv(list.data());
+}
+
 void
 gl::legacy::primitive::TexCoord(std::int32_t s, std::int32_t t)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetTexCoord(static_cast<float>(s), static_cast<float>(t));
+		return;
+	}
+
 	::glTexCoord2i(s, t);
 }
 
@@ -97,6 +450,12 @@ void
 gl::legacy::primitive::TexCoord(float s, float t)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetTexCoord(s, t);
+		return;
+	}
+
 	::glTexCoord2f(s, t);
 }
 
@@ -104,6 +463,12 @@ void
 gl::legacy::primitive::TexCoord(double s, double t)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetTexCoord(static_cast<float>(s), static_cast<float>(t));
+		return;
+	}
+
 	::glTexCoord2d(s, t);
 }
 
@@ -111,6 +476,12 @@ void
 gl::legacy::primitive::TexCoord(std::span<std::int32_t, 2> list)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetTexCoord(static_cast<float>(list[0]), static_cast<float>(list[1]));
+		return;
+	}
+
 	::glTexCoord2iv(list.data());
 }
 
@@ -118,6 +489,12 @@ void
 gl::legacy::primitive::TexCoord(std::span<float, 2> list)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetTexCoord(list[0], list[1]);
+		return;
+	}
+
 	::glTexCoord2fv(list.data());
 }
 
@@ -125,6 +502,12 @@ void
 gl::legacy::primitive::TexCoord(std::span<double, 2> list)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetTexCoord(static_cast<float>(list[0]), static_cast<float>(list[1]));
+		return;
+	}
+
 	::glTexCoord2dv(list.data());
 }
 
@@ -132,20 +515,26 @@ void
 gl::legacy::primitive::SetColour(const gl::Colour& color)
 noexcept
 {
-	::glColor4ub(color.R, color.G, color.B, color.A);
+	SetColour(color.R, color.G, color.B, color.A);
 }
 
 void
 gl::legacy::primitive::SetColour(gl::Colour&& color)
 noexcept
 {
-	::glColor4ub(color.R, color.G, color.B, color.A);
+	SetColour(color.R, color.G, color.B, color.A);
 }
 
 void
 gl::legacy::primitive::SetColour(std::uint8_t r, std::uint8_t g, std::uint8_t b)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetColour(r, g, b, 0xFFU);
+		return;
+	}
+
 	::glColor3ub(r, g, b);
 }
 
@@ -153,6 +542,12 @@ void
 gl::legacy::primitive::SetColour(std::int32_t r, std::int32_t g, std::int32_t b)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetColour(ToColourByte(ToSignedRatio(r)), ToColourByte(ToSignedRatio(g)), ToColourByte(ToSignedRatio(b)), 0xFFU);
+		return;
+	}
+
 	::glColor3i(r, g, b);
 }
 
@@ -160,6 +555,12 @@ void
 gl::legacy::primitive::SetColour(float ratio_r, float ratio_g, float ratio_b)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetColour(ToColourByte(ratio_r), ToColourByte(ratio_g), ToColourByte(ratio_b), 0xFFU);
+		return;
+	}
+
 	::glColor3f(ratio_r, ratio_g, ratio_b);
 }
 
@@ -167,6 +568,12 @@ void
 gl::legacy::primitive::SetColour(double ratio_r, double ratio_g, double ratio_b)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetColour(ToColourByte(ratio_r), ToColourByte(ratio_g), ToColourByte(ratio_b), 0xFFU);
+		return;
+	}
+
 	::glColor3d(ratio_r, ratio_g, ratio_b);
 }
 
@@ -174,6 +581,12 @@ void
 gl::legacy::primitive::SetColour(std::int32_t r, std::int32_t g, std::int32_t b, std::int32_t a)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetColour(ToColourByte(ToSignedRatio(r)), ToColourByte(ToSignedRatio(g)), ToColourByte(ToSignedRatio(b)), ToColourByte(ToSignedRatio(a)));
+		return;
+	}
+
 	::glColor4i(r, g, b, a);
 }
 
@@ -181,6 +594,12 @@ void
 gl::legacy::primitive::SetColour(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetColour(r, g, b, a);
+		return;
+	}
+
 	::glColor4ub(r, g, b, a);
 }
 
@@ -188,6 +607,12 @@ void
 gl::legacy::primitive::SetColour(float ratio_r, float ratio_g, float ratio_b, float ratio_a)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetColour(ToColourByte(ratio_r), ToColourByte(ratio_g), ToColourByte(ratio_b), ToColourByte(ratio_a));
+		return;
+	}
+
 	::glColor4f(ratio_r, ratio_g, ratio_b, ratio_a);
 }
 
@@ -195,5 +620,11 @@ void
 gl::legacy::primitive::SetColour(double ratio_r, double ratio_g, double ratio_b, double ratio_a)
 noexcept
 {
+	if (IsBatching())
+	{
+		recordedBatch.SetColour(ToColourByte(ratio_r), ToColourByte(ratio_g), ToColourByte(ratio_b), ToColourByte(ratio_a));
+		return;
+	}
+
 	::glColor4d(ratio_r, ratio_g, ratio_b, ratio_a);
 }
@@ -0,0 +1,652 @@
+module Glib.LevelOfDetail;
+import <cmath>;
+import <algorithm>;
+import <numeric>;
+import <cstring>;
+import <chrono>;
+import <utility>;
+import <stdexcept>;
+import Glib.MeshOptimizer;
+
+namespace
+{
+	using Position = std::array<float, 3>;
+
+	// Cosine of the largest turn of a triangle normal a collapse may cause
+	constexpr double MaxTurnCosine = 0.25;
+
+	/// <summary>
+	/// Weighted sum of the squared distances to a set of planes, as the symmetric 4x4 matrix of Garland and Heckbert
+	/// </summary>
+	struct Quadric
+	{
+		double a2 = 0, ab = 0, ac = 0, ad = 0;
+		double b2 = 0, bc = 0, bd = 0;
+		double c2 = 0, cd = 0;
+		double d2 = 0;
+		double weight = 0;
+
+		void AddPlane(double a, double b, double c, double d, double plane_weight) noexcept
+		{
+			a2 += a * a * plane_weight; ab += a * b * plane_weight; ac += a * c * plane_weight; ad += a * d * plane_weight;
+			b2 += b * b * plane_weight; bc += b * c * plane_weight; bd += b * d * plane_weight;
+			c2 += c * c * plane_weight; cd += c * d * plane_weight;
+			d2 += d * d * plane_weight;
+			weight += plane_weight;
+		}
+
+		Quadric& operator+=(const Quadric& other) noexcept
+		{
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+			weight += other.weight;
+
+			return *this;
+		}
+
+		/// <summary>
+		/// Weighted mean of the squared distances
+		/// </summary>
+		[[nodiscard]]
+		double Evaluate(const Position& position) const noexcept
+		{
+			if (weight <= 0)
+			{
+				return 0;
+			}
+
+			const double x = position[0], y = position[1], z = position[2];
+
+			const double result = a2 * x * x + b2 * y * y + c2 * z * z
+				+ 2 * (ab * x * y + ac * x * z + bc * y * z)
+				+ 2 * (ad * x + bd * y + cd * z)
+				+ d2;
+
+			// The rounding may leave a tiny negative
+			return std::max(result, 0.0) / weight;
+		}
+	};
+
+	struct Collapse
+	{
+		double cost;
+		std::uint32_t from;
+		std::uint32_t to;
+	};
+
+	[[nodiscard]]
+	Position Cross(const Position& a, const Position& b, const Position& c) noexcept
+	{
+		const float e1[3]{ b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const float e2[3]{ c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+		return { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+	}
+
+	[[nodiscard]]
+	double Dot(const Position& a, const Position& b) noexcept
+	{
+		return static_cast<double>(a[0]) * b[0] + static_cast<double>(a[1]) * b[1] + static_cast<double>(a[2]) * b[2];
+	}
+}
+
+gl::lod::SimplifyResult
+gl::lod::Simplify(std::vector<std::uint32_t>& result, std::span<const std::uint32_t> indices, std::span<const std::byte> vertices, std::size_t vertex_size, std::size_t position_offset, std::size_t target_index_count, float max_error)
+{
+	result.assign(indices.begin(), indices.end());
+
+	SimplifyResult outcome{ result.size(), 0 };
+	if (0 == vertex_size || vertex_size < position_offset + sizeof(Position) || 0 != result.size() % 3 || result.size() <= target_index_count)
+	{
+		return outcome;
+	}
+
+	const std::size_t vertex_count = vertices.size() / vertex_size;
+	if (std::any_of(result.begin(), result.end(), [vertex_count](std::uint32_t index) noexcept { return vertex_count <= index; }))
+	{
+		return outcome;
+	}
+
+	std::vector<Position> positions(vertex_count);
+	for (std::size_t v = 0; v < vertex_count; ++v)
+	{
+		std::memcpy(positions[v].data(), vertices.data() + v * vertex_size + position_offset, sizeof(Position));
+	}
+
+	// Vertices sharing a position split the attributes, moving one of them would tear the surface
+	std::vector<bool> locked(vertex_count, false);
+	{
+		std::vector<std::uint32_t> sorted(vertex_count);
+		std::iota(sorted.begin(), sorted.end(), 0U);
+		std::sort(sorted.begin(), sorted.end(), [&positions](std::uint32_t lhs, std::uint32_t rhs) noexcept {
+			return positions[lhs] < positions[rhs];
+		});
+
+		for (std::size_t i = 1; i < vertex_count; ++i)
+		{
+			if (positions[sorted[i - 1]] == positions[sorted[i]])
+			{
+				locked[sorted[i - 1]] = true;
+				locked[sorted[i]] = true;
+			}
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertex_count);
+	std::vector<Position> normals(result.size() / 3);
+	// Undirected edges with the triangle they came from
+	std::vector<std::pair<std::uint64_t, std::uint32_t>> edges{};
+	edges.reserve(result.size());
+
+	for (std::size_t t = 0; t < result.size() / 3; ++t)
+	{
+		const std::uint32_t* corner = result.data() + t * 3;
+		const Position normal = Cross(positions[corner[0]], positions[corner[1]], positions[corner[2]]);
+		const double length = std::sqrt(Dot(normal, normal));
+
+		if (0 < length)
+		{
+			const double a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+			const double d = -(a * positions[corner[0]][0] + b * positions[corner[0]][1] + c * positions[corner[0]][2]);
+
+			// Weighted by the area, so the slivers don't outweigh the large faces
+			for (std::uint32_t k = 0; k < 3; ++k)
+			{
+				quadrics[corner[k]].AddPlane(a, b, c, d, length * 0.5);
+			}
+		}
+
+		normals[t] = normal;
+
+		for (std::uint32_t k = 0; k < 3; ++k)
+		{
+			const std::uint32_t a = corner[k];
+			const std::uint32_t b = corner[(k + 1) % 3];
+
+			edges.emplace_back(static_cast<std::uint64_t>(std::min(a, b)) << 32 | std::max(a, b), static_cast<std::uint32_t>(t));
+		}
+	}
+
+	// Edges of a single triangle are on a border, a plane across each keeps the border from sliding inwards
+	std::sort(edges.begin(), edges.end());
+	for (std::size_t i = 0; i < edges.size(); ++i)
+	{
+		const std::uint64_t key = edges[i].first;
+		const bool single = (0 == i || edges[i - 1].first != key) && (i + 1 == edges.size() || edges[i + 1].first != key);
+		if (not single)
+		{
+			continue;
+		}
+
+		const std::uint32_t a = static_cast<std::uint32_t>(key >> 32);
+		const std::uint32_t b = static_cast<std::uint32_t>(key);
+
+		const Position& normal = normals[edges[i].second];
+		const Position edge{ positions[b][0] - positions[a][0], positions[b][1] - positions[a][1], positions[b][2] - positions[a][2] };
+		const Position across{ edge[1] * normal[2] - edge[2] * normal[1], edge[2] * normal[0] - edge[0] * normal[2], edge[0] * normal[1] - edge[1] * normal[0] };
+		const double length = std::sqrt(Dot(across, across));
+
+		if (0 < length)
+		{
+			const double pa = across[0] / length, pb = across[1] / length, pc = across[2] / length;
+			const double pd = -(pa * positions[a][0] + pb * positions[a][1] + pc * positions[a][2]);
+
+			// Weighted by the squared length of the edge, like the area of a face
+			quadrics[a].AddPlane(pa, pb, pc, pd, Dot(edge, edge));
+			quadrics[b].AddPlane(pa, pb, pc, pd, Dot(edge, edge));
+		}
+	}
+
+	const double max_cost = std::isinf(max_error) ? std::numeric_limits<double>::infinity() : static_cast<double>(max_error) * max_error;
+	double worst = 0;
+
+	std::vector<std::uint32_t> remap(vertex_count);
+	std::vector<bool> touched(vertex_count);
+	std::vector<std::uint32_t> offsets(vertex_count + 1);
+	std::vector<std::uint32_t> adjacency{};
+	std::vector<Collapse> candidates{};
+	// Set once a pass found nothing under its cost limit, the next one may take anything under max_error
+	bool relaxed = false;
+
+	// Every pass collapses a set of edges whose fans don't overlap, cheapest first
+	while (target_index_count < result.size())
+	{
+		const std::size_t triangle_count = result.size() / 3;
+
+		std::fill(offsets.begin(), offsets.end(), 0);
+		for (const std::uint32_t index : result)
+		{
+			++offsets[index + 1];
+		}
+
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		adjacency.resize(result.size());
+		{
+			std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			for (std::size_t i = 0; i < result.size(); ++i)
+			{
+				adjacency[fill[result[i]]++] = static_cast<std::uint32_t>(i / 3);
+			}
+		}
+
+		candidates.clear();
+		for (std::size_t i = 0; i < result.size(); ++i)
+		{
+			const std::uint32_t a = result[i];
+			const std::uint32_t b = result[i - i % 3 + (i + 1) % 3];
+
+			Quadric sum = quadrics[a];
+			sum += quadrics[b];
+
+			if (not locked[a])
+			{
+				candidates.push_back({ sum.Evaluate(positions[b]), a, b });
+			}
+
+			if (not locked[b])
+			{
+				candidates.push_back({ sum.Evaluate(positions[a]), b, a });
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse& lhs, const Collapse& rhs) noexcept {
+			return lhs.cost < rhs.cost;
+		});
+
+		std::iota(remap.begin(), remap.end(), 0U);
+		std::fill(touched.begin(), touched.end(), false);
+
+		const std::size_t goal = std::max<std::size_t>((result.size() - target_index_count) / 3, 1);
+		std::size_t removed = 0;
+
+		// A pass stays near the cost of the cheapest collapses which would reach the goal,
+		// else the expensive ones get in while cheaper ones are only blocked by this pass
+		double pass_cost = max_cost;
+		if (not relaxed and not candidates.empty())
+		{
+			pass_cost = std::min(max_cost, candidates[std::min(goal, candidates.size()) - 1].cost * 1.5);
+		}
+
+		for (const Collapse& collapse : candidates)
+		{
+			if (pass_cost < collapse.cost)
+			{
+				break;
+			}
+
+			if (touched[collapse.from] || touched[collapse.to])
+			{
+				continue;
+			}
+
+			// The triangles which keep their area must not flip
+			bool flipped = false;
+			std::size_t degenerate = 0;
+
+			for (std::uint32_t k = offsets[collapse.from]; k < offsets[collapse.from + 1] && not flipped; ++k)
+			{
+				const std::uint32_t* corner = result.data() + adjacency[k] * 3;
+
+				if (corner[0] == collapse.to || corner[1] == collapse.to || corner[2] == collapse.to)
+				{
+					++degenerate;
+					continue;
+				}
+
+				std::array<Position, 3> moved{ positions[corner[0]], positions[corner[1]], positions[corner[2]] };
+				const Position before = Cross(moved[0], moved[1], moved[2]);
+
+				for (std::uint32_t c = 0; c < 3; ++c)
+				{
+					if (corner[c] == collapse.from)
+					{
+						moved[c] = positions[collapse.to];
+					}
+				}
+
+				// Turning by more than about 75 degrees is refused too, the slivers it makes flip over in the next passes
+				const Position after = Cross(moved[0], moved[1], moved[2]);
+				flipped = Dot(before, after) <= MaxTurnCosine * std::sqrt(Dot(before, before) * Dot(after, after));
+			}
+
+			if (flipped || 0 == degenerate)
+			{
+				continue;
+			}
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to] += quadrics[collapse.from];
+			worst = std::max(worst, collapse.cost);
+
+			for (std::uint32_t k = offsets[collapse.from]; k < offsets[collapse.from + 1]; ++k)
+			{
+				const std::uint32_t* corner = result.data() + adjacency[k] * 3;
+
+				touched[corner[0]] = true;
+				touched[corner[1]] = true;
+				touched[corner[2]] = true;
+			}
+
+			removed += degenerate;
+			if (goal <= removed)
+			{
+				break;
+			}
+		}
+
+		if (0 == removed)
+		{
+			if (relaxed or pass_cost == max_cost)
+			{
+				break;
+			}
+
+			relaxed = true;
+			continue;
+		}
+
+		relaxed = false;
+
+		std::size_t write = 0;
+		for (std::size_t t = 0; t < triangle_count; ++t)
+		{
+			const std::uint32_t a = remap[result[t * 3 + 0]];
+			const std::uint32_t b = remap[result[t * 3 + 1]];
+			const std::uint32_t c = remap[result[t * 3 + 2]];
+
+			if (a != b && b != c && c != a)
+			{
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+		}
+
+		result.resize(write);
+	}
+
+	outcome.indexCount = result.size();
+	outcome.error = static_cast<float>(std::sqrt(worst));
+
+	return outcome;
+}
+
+gl::lod::Benchmark
+gl::lod::MeasureSimplification(std::uint32_t segments)
+{
+	segments = std::max(segments, 4U);
+	const std::uint32_t rings = segments / 2;
+
+	std::vector<Position> positions{};
+	for (std::uint32_t y = 0; y <= rings; ++y)
+	{
+		for (std::uint32_t x = 0; x <= segments; ++x)
+		{
+			const float u = 6.2831853f * static_cast<float>(x) / static_cast<float>(segments);
+			const float v = 3.1415926f * static_cast<float>(y) / static_cast<float>(rings);
+
+			positions.push_back({ std::cos(u) * std::sin(v), std::cos(v), std::sin(u) * std::sin(v) });
+		}
+	}
+
+	std::vector<std::uint32_t> indices{};
+	for (std::uint32_t y = 0; y < rings; ++y)
+	{
+		for (std::uint32_t x = 0; x < segments; ++x)
+		{
+			const std::uint32_t a = y * (segments + 1) + x;
+			const std::uint32_t c = a + segments + 1;
+
+			indices.insert(indices.end(), { a, c, a + 1, a + 1, c, c + 1 });
+		}
+	}
+
+	Benchmark result{};
+	result.triangles = indices.size() / 3;
+
+	std::vector<std::uint32_t> simplified{};
+
+	const auto start = std::chrono::steady_clock::now();
+	const SimplifyResult outcome = Simplify(simplified, indices, std::as_bytes(std::span{ positions }), sizeof(Position), 0, indices.size() / 4);
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	result.resultTriangles = outcome.indexCount / 3;
+	result.error = outcome.error;
+	result.trianglesPerSecond = 0 < result.seconds ? static_cast<double>(result.triangles) / result.seconds : 0;
+
+	return result;
+}
+
+gl::LodArena::LodArena(std::size_t vertex_size, std::size_t position_offset)
+	: myVertexSize(vertex_size), myPositionOffset(position_offset)
+{
+	// Every offset in the arena is divided by the vertex size
+	if (0 == vertex_size || vertex_size < position_offset + sizeof(Position))
+	{
+		throw std::invalid_argument{ "Invalid vertex layout" };
+	}
+}
+
+gl::LodArena::~LodArena()
+noexcept
+{}
+
+std::uint32_t
+gl::LodArena::Add(std::span<const std::byte> vertices, std::span<const std::uint32_t> indices, const lod::ChainOptions& options)
+{
+	lod::Mesh mesh{};
+	mesh.baseVertex = static_cast<std::uint32_t>(myVertices.size() / myVertexSize);
+
+	// The source level decides the order of the vertices every level shares
+	std::vector<std::byte> local_vertices(vertices.begin(), vertices.end());
+	std::vector<std::uint32_t> level(indices.begin(), indices.end());
+
+	mesh::OptimizeVertexCache(level, local_vertices.size() / myVertexSize);
+	const std::size_t vertex_count = mesh::OptimizeVertexFetch(level, local_vertices, myVertexSize);
+	local_vertices.resize(vertex_count * myVertexSize);
+
+	mesh.vertexCount = static_cast<std::uint32_t>(vertex_count);
+	myVertices.insert(myVertices.end(), local_vertices.begin(), local_vertices.end());
+
+	const auto append = [&](std::span<const std::uint32_t> level_indices, float error) {
+		mesh.levels[mesh.levelCount++] = lod::Level{ static_cast<std::uint32_t>(myIndices.size()), static_cast<std::uint32_t>(level_indices.size()), error };
+		myIndices.insert(myIndices.end(), level_indices.begin(), level_indices.end());
+	};
+
+	append(level, 0);
+
+	const std::uint32_t level_count = std::clamp(options.levelCount, 1U, lod::MaxLevels);
+	const std::vector<std::uint32_t> source = level;
+	std::vector<std::uint32_t> simplified{};
+	float target = static_cast<float>(source.size());
+
+	while (mesh.levelCount < level_count)
+	{
+		target *= options.reduction;
+
+		const std::size_t target_count = static_cast<std::size_t>(target) / 3 * 3;
+		if (target_count < 3)
+		{
+			break;
+		}
+
+		// Every level starts from the source, so its error is measured against the source
+		const lod::SimplifyResult outcome = lod::Simplify(simplified, source, local_vertices, myVertexSize, myPositionOffset, target_count, options.maxError);
+
+		// Stop where the error limit or the locked vertices leave too little to remove
+		const std::uint32_t previous_count = mesh.levels[mesh.levelCount - 1].indexCount;
+		if (static_cast<float>(previous_count) * 0.95f < static_cast<float>(outcome.indexCount))
+		{
+			break;
+		}
+
+		mesh::OptimizeVertexCache(simplified, vertex_count);
+
+		append(simplified, std::max(outcome.error, mesh.levels[mesh.levelCount - 1].error));
+	}
+
+	myMeshes.push_back(mesh);
+
+	return static_cast<std::uint32_t>(myMeshes.size() - 1);
+}
+
+void
+gl::LodArena::Clear()
+noexcept
+{
+	myVertices.clear();
+	myIndices.clear();
+	myMeshes.clear();
+}
+
+const gl::lod::Mesh&
+gl::LodArena::GetMesh(std::uint32_t mesh)
+const noexcept
+{
+	return myMeshes[mesh];
+}
+
+std::span<const gl::lod::Mesh>
+gl::LodArena::GetMeshes()
+const noexcept
+{
+	return myMeshes;
+}
+
+std::span<const std::byte>
+gl::LodArena::GetVertices()
+const noexcept
+{
+	return myVertices;
+}
+
+std::span<const std::uint32_t>
+gl::LodArena::GetIndices()
+const noexcept
+{
+	return myIndices;
+}
+
+std::size_t
+gl::LodArena::GetVertexSize()
+const noexcept
+{
+	return myVertexSize;
+}
+
+gl::LodSelector::LodSelector(float threshold, float hysteresis)
+noexcept
+	: myScale(1), myThreshold(threshold), myHysteresis(hysteresis)
+{
+	// Sixty degrees over a full HD viewport until told otherwise
+	SetProjection(1.0471976f, 1080.0f);
+}
+
+gl::LodSelector::~LodSelector()
+noexcept
+{}
+
+void
+gl::LodSelector::SetProjection(float vertical_fov, float viewport_height)
+noexcept
+{
+	myScale = viewport_height / (2.0f * std::tan(vertical_fov * 0.5f));
+}
+
+void
+gl::LodSelector::SetThreshold(float threshold)
+noexcept
+{
+	myThreshold = threshold;
+}
+
+void
+gl::LodSelector::SetHysteresis(float hysteresis)
+noexcept
+{
+	myHysteresis = hysteresis;
+}
+
+float
+gl::LodSelector::GetProjectedError(float error, float distance)
+const noexcept
+{
+	if (error <= 0)
+	{
+		return 0;
+	}
+
+	if (distance <= 0)
+	{
+		return std::numeric_limits<float>::infinity();
+	}
+
+	return error * myScale / distance;
+}
+
+std::uint32_t
+gl::LodSelector::Select(const lod::Mesh& mesh, float distance, std::uint32_t current)
+const noexcept
+{
+	if (mesh.levelCount <= 1)
+	{
+		return 0;
+	}
+
+	const auto projected = [&](std::uint32_t level) noexcept {
+		return GetProjectedError(mesh.levels[level].error, distance);
+	};
+
+	// The errors grow with the levels
+	std::uint32_t desired = 0;
+	while (desired + 1 < mesh.levelCount && projected(desired + 1) <= myThreshold)
+	{
+		++desired;
+	}
+
+	if (mesh.levelCount <= current)
+	{
+		return desired;
+	}
+
+	if (current < desired)
+	{
+		const float coarser_limit = myThreshold * (1.0f - myHysteresis);
+
+		std::uint32_t result = current;
+		while (result < desired && projected(result + 1) <= coarser_limit)
+		{
+			++result;
+		}
+
+		return result;
+	}
+
+	if (desired < current && myThreshold * (1.0f + myHysteresis) < projected(current))
+	{
+		return desired;
+	}
+
+	return current;
+}
+
+std::size_t
+gl::LodSelector::Select(const LodArena& arena, std::span<const lod::Instance> instances, std::span<std::uint32_t> levels)
+const noexcept
+{
+	std::size_t result = 0;
+
+	const std::size_t count = std::min(instances.size(), levels.size());
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const lod::Mesh& mesh = arena.GetMesh(instances[i].mesh);
+
+		levels[i] = Select(mesh, instances[i].distance, levels[i]);
+		result += mesh.levels[levels[i]].indexCount;
+	}
+
+	return result;
+}
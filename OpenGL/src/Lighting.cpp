@@ -0,0 +1,533 @@
+module;
+#define NOMINMAX
+#include <Windows.h>
+#include "glew.h"
+#include <gl\gl.h>
+module Glib.Lighting;
+import <algorithm>;
+import <cmath>;
+import <limits>;
+import <numbers>;
+import <chrono>;
+import <random>;
+import Glib.Parallel;
+
+namespace
+{
+	// Below this many lights per worker, the threads cost more than they save
+	constexpr std::size_t MinimumLightsPerWorker = 64;
+	// Spot lights over this cutoff are binned as point lights
+	constexpr float SpotCutoffLimit = 90.0f;
+
+	[[nodiscard]]
+	constexpr float
+	ToRadians(float degrees)
+	noexcept
+	{
+		return degrees * std::numbers::pi_v<float> / 180.0f;
+	}
+
+	void
+	TransformPoint(const std::array<float, 16>& m, const float(&point)[3], float* result)
+	noexcept
+	{
+		for (std::uint32_t i = 0; i < 3; ++i)
+		{
+			result[i] = m[i] * point[0] + m[4 + i] * point[1] + m[8 + i] * point[2] + m[12 + i];
+		}
+	}
+
+	void
+	TransformDirection(const std::array<float, 16>& m, const float(&direction)[3], float* result)
+	noexcept
+	{
+		for (std::uint32_t i = 0; i < 3; ++i)
+		{
+			result[i] = m[i] * direction[0] + m[4 + i] * direction[1] + m[8 + i] * direction[2];
+		}
+
+		const float length = std::sqrt(result[0] * result[0] + result[1] * result[1] + result[2] * result[2]);
+		if (0 < length)
+		{
+			result[0] /= length;
+			result[1] /= length;
+			result[2] /= length;
+		}
+	}
+
+	/// <summary>
+	/// Sphere around the cone of a spot light, or around the range of a point light
+	/// </summary>
+	[[nodiscard]]
+	std::array<float, 4>
+	GetBoundingSphere(const gl::lighting::GpuLight& light, float cutoff)
+	noexcept
+	{
+		const float range = light.position[3];
+		const float* origin = light.position;
+		const float* axis = light.direction;
+
+		// Without a direction the light shines everywhere
+		const bool has_axis = 0 < axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+		if (SpotCutoffLimit <= cutoff || !has_axis || !std::isfinite(range))
+		{
+			return { origin[0], origin[1], origin[2], range };
+		}
+
+		// A wide cone is bounded around its base, a narrow one by the sphere through its apex and its base
+		const float angle = ToRadians(cutoff);
+
+		float distance, radius;
+		if (std::numbers::pi_v<float> / 4 < angle)
+		{
+			distance = range * std::cos(angle);
+			radius = range * std::sin(angle);
+		}
+		else
+		{
+			distance = range / (2.0f * std::cos(angle));
+			radius = distance;
+		}
+
+		return { origin[0] + axis[0] * distance, origin[1] + axis[1] * distance, origin[2] + axis[2] * distance, radius };
+	}
+
+	[[nodiscard]]
+	std::uint32_t
+	GetTile(float ndc, std::uint32_t count)
+	noexcept
+	{
+		const float tile = std::floor((ndc + 1.0f) * 0.5f * static_cast<float>(count));
+
+		return static_cast<std::uint32_t>(std::clamp(tile, 0.0f, static_cast<float>(count - 1)));
+	}
+
+	void
+	UploadStorage(std::uint32_t& buffer, const void* data, std::size_t size)
+	noexcept
+	{
+		if (0 == buffer)
+		{
+			::glGenBuffers(1, std::addressof(buffer));
+		}
+
+		// An empty storage block still needs a buffer behind it
+		::glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		::glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(std::max<std::size_t>(size, 16)), 0 == size ? nullptr : data, GL_DYNAMIC_DRAW);
+		::glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+}
+
+float
+gl::lighting::GetRange(const gl::legacy::Light& light)
+noexcept
+{
+	float diffuse[4]{};
+	light.diffuse.Extract(diffuse);
+
+	const float brightest = std::max({ diffuse[0], diffuse[1], diffuse[2] });
+	if (brightest <= 0)
+	{
+		return 0;
+	}
+
+	// Solve constant + linear * d + quadratic * d^2 = brightest / cutoff
+	const float target = brightest / IntensityCutoff;
+	const float c = light.constantAttenuation - target;
+	const float l = light.linearAttenuation;
+	const float q = light.quadraticAttenuation;
+
+	if (0 <= c)
+	{
+		return 0;
+	}
+
+	if (0 < q)
+	{
+		return (-l + std::sqrt(l * l - 4.0f * q * c)) / (2.0f * q);
+	}
+	else if (0 < l)
+	{
+		return -c / l;
+	}
+	else
+	{
+		return std::numeric_limits<float>::infinity();
+	}
+}
+
+gl::ClusteredLighting::ClusteredLighting(std::uint32_t x, std::uint32_t y, std::uint32_t z, std::uint32_t threads)
+	: myGrid{ std::max(1U, x), std::max(1U, y), std::max(1U, z) }
+	, myThreads(GetWorkerCount(threads))
+{
+	myView = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+	BuildBounds();
+}
+
+gl::ClusteredLighting::~ClusteredLighting()
+noexcept
+{
+	for (std::uint32_t* buffer : { std::addressof(myLightBuffer), std::addressof(myClusterBuffer), std::addressof(myIndexBuffer) })
+	{
+		if (0 != *buffer)
+		{
+			::glDeleteBuffers(1, buffer);
+		}
+	}
+}
+
+void
+gl::ClusteredLighting::SetView(const float(&view)[16], float vertical_fov, float aspect, float near_plane, float far_plane)
+noexcept
+{
+	std::copy_n(view, 16, myView.begin());
+
+	const float tangent_y = std::tan(vertical_fov * 0.5f);
+	const float tangent_x = tangent_y * aspect;
+	near_plane = std::max(near_plane, std::numeric_limits<float>::min());
+	far_plane = std::max(far_plane, near_plane * 1.001f);
+
+	if (tangent_x != myTangentX || tangent_y != myTangentY || near_plane != myNear || far_plane != myFar)
+	{
+		myTangentX = tangent_x;
+		myTangentY = tangent_y;
+		myNear = near_plane;
+		myFar = far_plane;
+
+		BuildBounds();
+	}
+}
+
+void
+gl::ClusteredLighting::Clear()
+noexcept
+{
+	mySources.clear();
+}
+
+void
+gl::ClusteredLighting::Reserve(std::size_t count)
+{
+	mySources.reserve(count);
+	myLights.reserve(count);
+}
+
+std::uint32_t
+gl::ClusteredLighting::Add(const gl::legacy::Light& light)
+{
+	const std::uint32_t index = static_cast<std::uint32_t>(mySources.size());
+	mySources.push_back(light);
+
+	return index;
+}
+
+void
+gl::ClusteredLighting::Build()
+{
+	const std::size_t light_count = mySources.size();
+	const std::uint32_t cluster_count = myGrid[0] * myGrid[1] * myGrid[2];
+
+	myLights.resize(light_count);
+
+	const std::uint32_t workers = static_cast<std::uint32_t>(std::clamp<std::size_t>(light_count / MinimumLightsPerWorker, 1, myThreads));
+	myWorkerPairs.resize(workers);
+	myWorkerCounts.resize(workers);
+
+	// Every worker bins a contiguous chunk of the lights, so the lights of a cluster stay in order
+	const auto chunk_begin = [&](std::uint32_t worker) noexcept {
+		return light_count * worker / workers;
+	};
+
+	ParallelFor(workers, workers, [&](std::uint32_t worker, std::uint32_t) {
+		std::vector<std::uint64_t>& pairs = myWorkerPairs[worker];
+		std::vector<std::uint32_t>& counts = myWorkerCounts[worker];
+		pairs.clear();
+		counts.assign(cluster_count, 0);
+
+		const std::size_t end = chunk_begin(worker + 1);
+		for (std::size_t index = chunk_begin(worker); index < end; ++index)
+		{
+			const legacy::Light& source = mySources[index];
+			lighting::GpuLight& light = myLights[index];
+
+			const bool is_spot = source.spotCutoff < SpotCutoffLimit;
+			const float range = lighting::GetRange(source);
+
+			TransformPoint(myView, source.position, light.position);
+			TransformDirection(myView, source.spotDirection, light.direction);
+			light.position[3] = range;
+
+			source.diffuse.Extract(light.colour);
+			light.colour[3] = source.spotExponent;
+			light.direction[3] = is_spot ? std::cos(ToRadians(source.spotCutoff)) : -1.0f;
+
+			light.attenuation[0] = source.constantAttenuation;
+			light.attenuation[1] = source.linearAttenuation;
+			light.attenuation[2] = source.quadraticAttenuation;
+			light.attenuation[3] = 0;
+
+			const std::array<float, 4> sphere = GetBoundingSphere(light, source.spotCutoff);
+
+			if (!(0 < range))
+			{
+				continue;
+			}
+
+			// The camera looks down the negative z
+			const float depth = -sphere[2];
+			const float radius = sphere[3];
+			const float nearest = std::max(depth - radius, myNear);
+			const float farthest = std::min(depth + radius, myFar);
+
+			if (farthest < nearest)
+			{
+				continue;
+			}
+
+			// Conservative range of the tiles, from the box around the sphere at both ends of its depth
+			const float left = std::min((sphere[0] - radius) / (nearest * myTangentX), (sphere[0] - radius) / (farthest * myTangentX));
+			const float right = std::max((sphere[0] + radius) / (nearest * myTangentX), (sphere[0] + radius) / (farthest * myTangentX));
+			const float bottom = std::min((sphere[1] - radius) / (nearest * myTangentY), (sphere[1] - radius) / (farthest * myTangentY));
+			const float top = std::max((sphere[1] + radius) / (nearest * myTangentY), (sphere[1] + radius) / (farthest * myTangentY));
+
+			if (right < -1.0f || 1.0f < left || top < -1.0f || 1.0f < bottom)
+			{
+				continue;
+			}
+
+			const std::uint32_t x0 = GetTile(left, myGrid[0]), x1 = GetTile(right, myGrid[0]);
+			const std::uint32_t y0 = GetTile(bottom, myGrid[1]), y1 = GetTile(top, myGrid[1]);
+			const std::uint32_t z0 = GetSlice(nearest), z1 = GetSlice(farthest);
+			const float radius_squared = radius * radius;
+
+			for (std::uint32_t z = z0; z <= z1; ++z)
+			{
+				for (std::uint32_t y = y0; y <= y1; ++y)
+				{
+					for (std::uint32_t x = x0; x <= x1; ++x)
+					{
+						const std::uint32_t cluster = GetClusterIndex(x, y, z);
+						const std::array<float, 6>& bounds = myBounds[cluster];
+
+						float distance = 0;
+						for (std::uint32_t axis = 0; axis < 3; ++axis)
+						{
+							const float gap = std::max({ bounds[axis] - sphere[axis], 0.0f, sphere[axis] - bounds[axis + 3] });
+							distance += gap * gap;
+						}
+
+						if (distance <= radius_squared)
+						{
+							pairs.push_back(static_cast<std::uint64_t>(cluster) << 32 | index);
+							++counts[cluster];
+						}
+					}
+				}
+			}
+		}
+	});
+
+	// Offsets go cluster by cluster, then worker by worker
+	myClusters.resize(cluster_count);
+
+	std::uint32_t offset = 0;
+	myStatistics = {};
+	for (std::uint32_t cluster = 0; cluster < cluster_count; ++cluster)
+	{
+		const std::uint32_t begin = offset;
+		for (std::vector<std::uint32_t>& counts : myWorkerCounts)
+		{
+			const std::uint32_t size = counts[cluster];
+			counts[cluster] = offset;
+			offset += size;
+		}
+
+		const std::uint32_t count = offset - begin;
+		myClusters[cluster] = { begin, count };
+
+		myStatistics.occupiedClusters += 0 < count ? 1 : 0;
+		myStatistics.maxLightsPerCluster = std::max<std::uint64_t>(myStatistics.maxLightsPerCluster, count);
+	}
+
+	myIndices.resize(offset);
+
+	ParallelFor(workers, workers, [&](std::uint32_t worker, std::uint32_t) {
+		std::vector<std::uint32_t>& offsets = myWorkerCounts[worker];
+
+		for (const std::uint64_t pair : myWorkerPairs[worker])
+		{
+			myIndices[offsets[pair >> 32]++] = static_cast<std::uint32_t>(pair);
+		}
+	});
+
+	// A light which touches no cluster is out of the frustum or too dim
+	std::vector<bool> touched(light_count, false);
+	for (const std::uint32_t index : myIndices)
+	{
+		touched[index] = true;
+	}
+
+	myStatistics.lights = light_count;
+	myStatistics.culledLights = static_cast<std::uint64_t>(std::count(touched.begin(), touched.end(), false));
+	myStatistics.clusters = cluster_count;
+	myStatistics.references = offset;
+}
+
+void
+gl::ClusteredLighting::Upload()
+noexcept
+{
+	UploadStorage(myLightBuffer, myLights.data(), myLights.size() * sizeof(lighting::GpuLight));
+	UploadStorage(myClusterBuffer, myClusters.data(), myClusters.size() * sizeof(lighting::Cluster));
+	UploadStorage(myIndexBuffer, myIndices.data(), myIndices.size() * sizeof(std::uint32_t));
+}
+
+void
+gl::ClusteredLighting::Bind(std::uint32_t lights_binding, std::uint32_t clusters_binding, std::uint32_t indices_binding)
+const noexcept
+{
+	::glBindBufferBase(GL_SHADER_STORAGE_BUFFER, lights_binding, myLightBuffer);
+	::glBindBufferBase(GL_SHADER_STORAGE_BUFFER, clusters_binding, myClusterBuffer);
+	::glBindBufferBase(GL_SHADER_STORAGE_BUFFER, indices_binding, myIndexBuffer);
+}
+
+std::uint32_t
+gl::ClusteredLighting::GetSlice(float view_depth)
+const noexcept
+{
+	if (view_depth <= myNear)
+	{
+		return 0;
+	}
+
+	const float slice = std::floor(std::log(view_depth / myNear) * static_cast<float>(myGrid[2]) / std::log(myFar / myNear));
+
+	return static_cast<std::uint32_t>(std::min(slice, static_cast<float>(myGrid[2] - 1)));
+}
+
+std::uint32_t
+gl::ClusteredLighting::GetClusterIndex(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+const noexcept
+{
+	return x + myGrid[0] * (y + myGrid[1] * z);
+}
+
+std::span<const gl::lighting::Cluster>
+gl::ClusteredLighting::GetClusters()
+const noexcept
+{
+	return myClusters;
+}
+
+std::span<const std::uint32_t>
+gl::ClusteredLighting::GetLightIndices()
+const noexcept
+{
+	return myIndices;
+}
+
+std::span<const gl::lighting::GpuLight>
+gl::ClusteredLighting::GetLights()
+const noexcept
+{
+	return myLights;
+}
+
+gl::lighting::ShaderParameters
+gl::ClusteredLighting::GetShaderParameters()
+const noexcept
+{
+	const float scale = static_cast<float>(myGrid[2]) / std::log(myFar / myNear);
+
+	return { { myGrid[0], myGrid[1], myGrid[2] }, scale, -std::log(myNear) * scale };
+}
+
+const gl::lighting::Statistics&
+gl::ClusteredLighting::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+void
+gl::ClusteredLighting::BuildBounds()
+{
+	myBounds.resize(static_cast<std::size_t>(myGrid[0]) * myGrid[1] * myGrid[2]);
+
+	const float ratio = myFar / myNear;
+
+	for (std::uint32_t z = 0; z < myGrid[2]; ++z)
+	{
+		// Exponential slices keep the clusters about as deep as they are wide
+		const float front = myNear * std::pow(ratio, static_cast<float>(z) / static_cast<float>(myGrid[2]));
+		const float back = myNear * std::pow(ratio, static_cast<float>(z + 1) / static_cast<float>(myGrid[2]));
+
+		for (std::uint32_t y = 0; y < myGrid[1]; ++y)
+		{
+			const float bottom = (-1.0f + 2.0f * static_cast<float>(y) / static_cast<float>(myGrid[1])) * myTangentY;
+			const float top = (-1.0f + 2.0f * static_cast<float>(y + 1) / static_cast<float>(myGrid[1])) * myTangentY;
+
+			for (std::uint32_t x = 0; x < myGrid[0]; ++x)
+			{
+				const float left = (-1.0f + 2.0f * static_cast<float>(x) / static_cast<float>(myGrid[0])) * myTangentX;
+				const float right = (-1.0f + 2.0f * static_cast<float>(x + 1) / static_cast<float>(myGrid[0])) * myTangentX;
+
+				myBounds[GetClusterIndex(x, y, z)] = {
+					std::min(left * front, left * back), std::min(bottom * front, bottom * back), -back,
+					std::max(right * front, right * back), std::max(top * front, top * back), -front
+				};
+			}
+		}
+	}
+}
+
+gl::lighting::Benchmark
+gl::lighting::MeasureBinning(std::size_t lights, std::uint32_t threads, std::uint32_t iterations)
+{
+	std::mt19937 engine{ 0x5EED };
+	std::uniform_real_distribution<float> spread{ -60.0f, 60.0f }, depth{ -120.0f, -1.0f }, unit{ -1.0f, 1.0f };
+	std::uniform_real_distribution<float> falloff{ 1.0f, 10.0f }, cutoff{ 15.0f, 60.0f };
+	std::bernoulli_distribution spot{ 0.3 };
+
+	ClusteredLighting clustered{ DefaultClustersX, DefaultClustersY, DefaultClustersZ, threads };
+	const float view[16]{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	clustered.SetView(view, std::numbers::pi_v<float> / 3, 16.0f / 9.0f, 0.1f, 200.0f);
+	clustered.Reserve(lights);
+
+	for (std::size_t i = 0; i < lights; ++i)
+	{
+		legacy::Light light{};
+		light.position[0] = spread(engine);
+		light.position[1] = spread(engine) * 0.5f;
+		light.position[2] = depth(engine);
+		light.quadraticAttenuation = falloff(engine);
+
+		if (spot(engine))
+		{
+			light.spotCutoff = cutoff(engine);
+			light.spotDirection[0] = unit(engine);
+			light.spotDirection[1] = unit(engine);
+			light.spotDirection[2] = unit(engine);
+		}
+
+		clustered.Add(light);
+	}
+
+	Benchmark result{};
+	result.lights = lights;
+	result.threads = GetWorkerCount(threads);
+	result.seconds = std::numeric_limits<double>::max();
+
+	for (std::uint32_t i = 0; i < std::max(1U, iterations); ++i)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		clustered.Build();
+		result.seconds = std::min(result.seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	result.references = clustered.GetStatistics().references;
+
+	return result;
+}
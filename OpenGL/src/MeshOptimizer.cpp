@@ -0,0 +1,559 @@
+module Glib.MeshOptimizer;
+import <cmath>;
+import <algorithm>;
+import <numeric>;
+import <limits>;
+import <array>;
+import <vector>;
+import <cstring>;
+
+namespace
+{
+	constexpr std::uint32_t InvalidIndex = std::numeric_limits<std::uint32_t>::max();
+
+	// Scores of "Linear-Speed Vertex Cache Optimisation" by Tom Forsyth
+	constexpr float CacheDecayPower = 1.5f;
+	constexpr float LastTriangleScore = 0.75f;
+	constexpr float ValenceBoostScale = 2.0f;
+	constexpr float ValenceBoostPower = 0.5f;
+	// Vertices used by more triangles than this share the same valence boost
+	constexpr std::uint32_t MaxValence = 64;
+
+	// Lines kept by the fetch cache between the post-transform cache and the memory
+	constexpr std::uint32_t FetchCacheLines = 64;
+
+	struct ScoreTable
+	{
+		std::array<float, gl::mesh::ScoringCacheSize> cache;
+		std::array<float, MaxValence> valence;
+
+		ScoreTable() noexcept
+		{
+			for (std::uint32_t i = 0; i < gl::mesh::ScoringCacheSize; ++i)
+			{
+				if (i < 3)
+				{
+					// The last triangle is scored down, so it isn't picked again at once through its own vertices
+					cache[i] = LastTriangleScore;
+				}
+				else
+				{
+					const float scale = 1.0f / static_cast<float>(gl::mesh::ScoringCacheSize - 3);
+					cache[i] = std::pow(1.0f - static_cast<float>(i - 3) * scale, CacheDecayPower);
+				}
+			}
+
+			valence[0] = 0;
+			for (std::uint32_t i = 1; i < MaxValence; ++i)
+			{
+				// Vertices with few triangles left are favoured, so the lone triangles aren't left behind
+				valence[i] = ValenceBoostScale * std::pow(static_cast<float>(i), -ValenceBoostPower);
+			}
+		}
+
+		[[nodiscard]]
+		float Get(std::int32_t cache_position, std::uint32_t remaining) const noexcept
+		{
+			if (0 == remaining)
+			{
+				return -1.0f;
+			}
+
+			const float score = 0 <= cache_position ? cache[cache_position] : 0.0f;
+			return score + valence[std::min(remaining, MaxValence - 1)];
+		}
+	};
+
+	/// <summary>
+	/// FIFO cache by the time stamps of the insertions, a vertex is cached while fewer than size vertices came after it
+	/// </summary>
+	class FifoCache
+	{
+	public:
+		FifoCache(std::size_t count, std::uint32_t size)
+			: myStamps(count, 0), myTime(size + 1), mySize(size)
+		{}
+
+		/// <returns>Whether the entry missed and was inserted</returns>
+		bool Access(std::uint32_t entry) noexcept
+		{
+			if (myTime - myStamps[entry] > mySize)
+			{
+				myStamps[entry] = myTime++;
+				return true;
+			}
+
+			return false;
+		}
+
+		void Flush() noexcept
+		{
+			myTime += mySize + 1;
+		}
+
+	private:
+		std::vector<std::uint32_t> myStamps;
+		std::uint32_t myTime;
+		std::uint32_t mySize;
+	};
+
+	[[nodiscard]]
+	bool IsValid(std::span<const std::uint32_t> indices, std::size_t vertex_count) noexcept
+	{
+		return 0 == indices.size() % 3
+			&& std::all_of(indices.begin(), indices.end(), [vertex_count](std::uint32_t index) noexcept {
+			return index < vertex_count;
+		});
+	}
+
+	[[nodiscard]]
+	std::array<float, 3> ReadPosition(std::span<const std::byte> vertices, std::size_t vertex_size, std::size_t position_offset, std::uint32_t index) noexcept
+	{
+		std::array<float, 3> result;
+		std::memcpy(result.data(), vertices.data() + index * vertex_size + position_offset, sizeof(result));
+
+		return result;
+	}
+}
+
+void
+gl::mesh::OptimizeVertexCache(std::span<std::uint32_t> indices, std::size_t vertex_count)
+{
+	const std::size_t triangle_count = indices.size() / 3;
+	if (triangle_count < 2 || not IsValid(indices, vertex_count))
+	{
+		return;
+	}
+
+	static const ScoreTable scores{};
+
+	// Triangles of every vertex, the live ones are kept in front of each range
+	std::vector<std::uint32_t> remaining(vertex_count, 0);
+	for (const std::uint32_t index : indices)
+	{
+		++remaining[index];
+	}
+
+	std::vector<std::uint32_t> offsets(vertex_count + 1, 0);
+	std::inclusive_scan(remaining.begin(), remaining.end(), offsets.begin() + 1);
+
+	std::vector<std::uint32_t> adjacency(indices.size());
+	{
+		std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (std::size_t i = 0; i < indices.size(); ++i)
+		{
+			adjacency[fill[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+		}
+	}
+
+	std::vector<float> vertex_scores(vertex_count);
+	for (std::size_t v = 0; v < vertex_count; ++v)
+	{
+		vertex_scores[v] = scores.Get(-1, remaining[v]);
+	}
+
+	std::vector<float> triangle_scores(triangle_count);
+	std::vector<bool> emitted(triangle_count, false);
+
+	std::uint32_t best_triangle = 0;
+	for (std::size_t t = 0; t < triangle_count; ++t)
+	{
+		const std::uint32_t* corner = indices.data() + t * 3;
+		triangle_scores[t] = vertex_scores[corner[0]] + vertex_scores[corner[1]] + vertex_scores[corner[2]];
+
+		if (triangle_scores[best_triangle] < triangle_scores[t])
+		{
+			best_triangle = static_cast<std::uint32_t>(t);
+		}
+	}
+
+	std::vector<std::uint32_t> result(indices.size());
+	std::array<std::uint32_t, ScoringCacheSize + 3> cache{};
+	std::array<std::uint32_t, ScoringCacheSize + 3> next_cache{};
+	std::uint32_t cache_count = 0;
+	// Next triangle to start from when the cache has nothing left
+	std::uint32_t cursor = 0;
+
+	for (std::size_t output = 0; output < triangle_count; ++output)
+	{
+		if (InvalidIndex == best_triangle)
+		{
+			while (emitted[cursor])
+			{
+				++cursor;
+			}
+
+			best_triangle = cursor;
+		}
+
+		const std::uint32_t* corner = indices.data() + best_triangle * 3;
+		std::copy_n(corner, 3, result.data() + output * 3);
+		emitted[best_triangle] = true;
+
+		// The vertices of the triangle go to the front, the others are pushed back
+		std::uint32_t next_count = 0;
+		for (std::uint32_t k = 0; k < 3; ++k)
+		{
+			const std::uint32_t vertex = corner[k];
+			next_cache[next_count++] = vertex;
+
+			const std::uint32_t begin = offsets[vertex];
+			const std::uint32_t live_end = begin + remaining[vertex];
+
+			for (std::uint32_t i = begin; i < live_end; ++i)
+			{
+				if (adjacency[i] == best_triangle)
+				{
+					std::swap(adjacency[i], adjacency[live_end - 1]);
+					break;
+				}
+			}
+
+			--remaining[vertex];
+		}
+
+		for (std::uint32_t i = 0; i < cache_count; ++i)
+		{
+			const std::uint32_t vertex = cache[i];
+			if (vertex != corner[0] && vertex != corner[1] && vertex != corner[2])
+			{
+				next_cache[next_count++] = vertex;
+			}
+		}
+
+		// Rescore the vertices of the cache and of the evicted ones, then the triangles around them
+		best_triangle = InvalidIndex;
+		float best_score = -std::numeric_limits<float>::infinity();
+
+		for (std::uint32_t i = 0; i < next_count; ++i)
+		{
+			const std::uint32_t vertex = next_cache[i];
+			const std::int32_t position = i < ScoringCacheSize ? static_cast<std::int32_t>(i) : -1;
+
+			const float score = scores.Get(position, remaining[vertex]);
+			const float delta = score - vertex_scores[vertex];
+			vertex_scores[vertex] = score;
+
+			const std::uint32_t begin = offsets[vertex];
+			const std::uint32_t live_end = begin + remaining[vertex];
+
+			for (std::uint32_t k = begin; k < live_end; ++k)
+			{
+				const std::uint32_t triangle = adjacency[k];
+				triangle_scores[triangle] += delta;
+
+				if (best_score < triangle_scores[triangle])
+				{
+					best_score = triangle_scores[triangle];
+					best_triangle = triangle;
+				}
+			}
+		}
+
+		cache_count = std::min(next_count, ScoringCacheSize);
+		std::copy_n(next_cache.begin(), cache_count, cache.begin());
+	}
+
+	std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void
+gl::mesh::OptimizeOverdraw(std::span<std::uint32_t> indices, std::span<const std::byte> vertices, std::size_t vertex_size, std::size_t position_offset, float threshold)
+{
+	const std::size_t triangle_count = indices.size() / 3;
+	if (triangle_count < 2 || 0 == vertex_size || vertex_size < position_offset + sizeof(float) * 3)
+	{
+		return;
+	}
+
+	const std::size_t vertex_count = vertices.size() / vertex_size;
+	if (not IsValid(indices, vertex_count))
+	{
+		return;
+	}
+
+	// The cache is flushed where a triangle misses every vertex, such triangles start the runs
+	std::vector<std::uint32_t> runs{};
+	{
+		FifoCache cache{ vertex_count, DefaultCacheSize };
+
+		for (std::size_t t = 0; t < triangle_count; ++t)
+		{
+			std::uint32_t misses = 0;
+			for (std::uint32_t k = 0; k < 3; ++k)
+			{
+				misses += cache.Access(indices[t * 3 + k]);
+			}
+
+			if (3 == misses)
+			{
+				runs.push_back(static_cast<std::uint32_t>(t));
+			}
+		}
+	}
+
+	runs.push_back(static_cast<std::uint32_t>(triangle_count));
+
+	// Cut the runs into clusters which keep the miss ratio of their run
+	std::vector<std::uint32_t> clusters{};
+	{
+		FifoCache cache{ vertex_count, DefaultCacheSize };
+
+		for (std::size_t r = 0; r + 1 < runs.size(); ++r)
+		{
+			const std::uint32_t begin = runs[r];
+			const std::uint32_t end = runs[r + 1];
+
+			std::size_t run_misses = 0;
+			cache.Flush();
+			for (std::uint32_t i = begin * 3; i < end * 3; ++i)
+			{
+				run_misses += cache.Access(indices[i]);
+			}
+
+			const double limit = static_cast<double>(threshold) * static_cast<double>(run_misses) / static_cast<double>(end - begin);
+
+			clusters.push_back(begin);
+			cache.Flush();
+
+			std::size_t misses = 0;
+			std::size_t size = 0;
+			for (std::uint32_t t = begin; t < end; ++t)
+			{
+				for (std::uint32_t k = 0; k < 3; ++k)
+				{
+					misses += cache.Access(indices[t * 3 + k]);
+				}
+
+				++size;
+
+				if (t + 1 < end && static_cast<double>(misses) <= limit * static_cast<double>(size))
+				{
+					clusters.push_back(t + 1);
+					cache.Flush();
+
+					misses = 0;
+					size = 0;
+				}
+			}
+		}
+	}
+
+	clusters.push_back(static_cast<std::uint32_t>(triangle_count));
+
+	// Area weighted centroids and normals of the clusters and of the whole mesh
+	const std::size_t cluster_count = clusters.size() - 1;
+	std::vector<std::array<float, 3>> centroids(cluster_count);
+	std::vector<std::array<float, 3>> normals(cluster_count);
+	std::array<double, 3> mesh_centroid{};
+	double mesh_area = 0;
+
+	for (std::size_t c = 0; c < cluster_count; ++c)
+	{
+		std::array<float, 3> centroid{};
+		std::array<float, 3> normal{};
+		float area = 0;
+
+		for (std::uint32_t t = clusters[c]; t < clusters[c + 1]; ++t)
+		{
+			const auto p0 = ReadPosition(vertices, vertex_size, position_offset, indices[t * 3 + 0]);
+			const auto p1 = ReadPosition(vertices, vertex_size, position_offset, indices[t * 3 + 1]);
+			const auto p2 = ReadPosition(vertices, vertex_size, position_offset, indices[t * 3 + 2]);
+
+			const float e1[3]{ p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const float e2[3]{ p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			const float n[3]{ e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			const float weight = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (std::uint32_t k = 0; k < 3; ++k)
+			{
+				centroid[k] += (p0[k] + p1[k] + p2[k]) * weight / 3;
+				normal[k] += n[k];
+			}
+
+			area += weight;
+		}
+
+		for (std::uint32_t k = 0; k < 3; ++k)
+		{
+			mesh_centroid[k] += centroid[k];
+			centroids[c][k] = 0 < area ? centroid[k] / area : 0;
+		}
+
+		mesh_area += area;
+		normals[c] = normal;
+	}
+
+	for (double& value : mesh_centroid)
+	{
+		value = 0 < mesh_area ? value / mesh_area : 0;
+	}
+
+	// Clusters facing away from the centre are drawn first, they are more likely to hide the others
+	std::vector<float> sort_keys(cluster_count);
+	for (std::size_t c = 0; c < cluster_count; ++c)
+	{
+		const auto& n = normals[c];
+		const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+		float dot = 0;
+		for (std::uint32_t k = 0; k < 3; ++k)
+		{
+			dot += (centroids[c][k] - static_cast<float>(mesh_centroid[k])) * n[k];
+		}
+
+		sort_keys[c] = 0 < length ? dot / length : 0;
+	}
+
+	std::vector<std::uint32_t> order(cluster_count);
+	std::iota(order.begin(), order.end(), 0U);
+	std::stable_sort(order.begin(), order.end(), [&sort_keys](std::uint32_t lhs, std::uint32_t rhs) noexcept {
+		return sort_keys[rhs] < sort_keys[lhs];
+	});
+
+	std::vector<std::uint32_t> result{};
+	result.reserve(indices.size());
+
+	for (const std::uint32_t c : order)
+	{
+		result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+	}
+
+	std::copy(result.begin(), result.end(), indices.begin());
+}
+
+std::size_t
+gl::mesh::OptimizeVertexFetch(std::span<std::uint32_t> indices, std::span<std::byte> vertices, std::size_t vertex_size)
+{
+	if (0 == vertex_size)
+	{
+		return 0;
+	}
+
+	const std::size_t vertex_count = vertices.size() / vertex_size;
+	if (not IsValid(indices, vertex_count))
+	{
+		return vertex_count;
+	}
+
+	std::vector<std::uint32_t> remap(vertex_count, InvalidIndex);
+	std::vector<std::byte> result{};
+	result.reserve(vertices.size());
+
+	std::uint32_t next = 0;
+	for (std::uint32_t& index : indices)
+	{
+		if (InvalidIndex == remap[index])
+		{
+			const std::byte* source = vertices.data() + index * vertex_size;
+			result.insert(result.end(), source, source + vertex_size);
+
+			remap[index] = next++;
+		}
+
+		index = remap[index];
+	}
+
+	std::copy(result.begin(), result.end(), vertices.begin());
+
+	return next;
+}
+
+std::size_t
+gl::mesh::Optimize(std::span<std::uint32_t> indices, std::span<std::byte> vertices, std::size_t vertex_size, std::size_t position_offset, float overdraw_threshold)
+{
+	if (0 == vertex_size)
+	{
+		return 0;
+	}
+
+	OptimizeVertexCache(indices, vertices.size() / vertex_size);
+	OptimizeOverdraw(indices, vertices, vertex_size, position_offset, overdraw_threshold);
+
+	return OptimizeVertexFetch(indices, vertices, vertex_size);
+}
+
+gl::mesh::CacheStatistics
+gl::mesh::AnalyzeVertexCache(std::span<const std::uint32_t> indices, std::size_t vertex_count, std::uint32_t cache_size)
+{
+	CacheStatistics result{};
+	if (indices.empty() || 0 == cache_size || not IsValid(indices, vertex_count))
+	{
+		return result;
+	}
+
+	FifoCache cache{ vertex_count, cache_size };
+	std::vector<bool> referenced(vertex_count, false);
+
+	for (const std::uint32_t index : indices)
+	{
+		result.misses += cache.Access(index);
+
+		if (not referenced[index])
+		{
+			referenced[index] = true;
+			++result.vertices;
+		}
+	}
+
+	result.triangles = indices.size() / 3;
+	result.acmr = static_cast<double>(result.misses) / static_cast<double>(result.triangles);
+	result.atvr = static_cast<double>(result.misses) / static_cast<double>(result.vertices);
+
+	return result;
+}
+
+gl::mesh::FetchStatistics
+gl::mesh::AnalyzeVertexFetch(std::span<const std::uint32_t> indices, std::size_t vertex_count, std::size_t vertex_size)
+{
+	FetchStatistics result{};
+	if (indices.empty() || 0 == vertex_size || not IsValid(indices, vertex_count))
+	{
+		return result;
+	}
+
+	const std::size_t line_count = (vertex_count * vertex_size + FetchLineSize - 1) / FetchLineSize;
+
+	FifoCache vertex_cache{ vertex_count, DefaultCacheSize };
+	FifoCache line_cache{ line_count, FetchCacheLines };
+	std::vector<bool> referenced(vertex_count, false);
+	std::size_t unique = 0;
+
+	for (const std::uint32_t index : indices)
+	{
+		if (not referenced[index])
+		{
+			referenced[index] = true;
+			++unique;
+		}
+
+		if (not vertex_cache.Access(index))
+		{
+			continue;
+		}
+
+		const std::size_t first = index * vertex_size / FetchLineSize;
+		const std::size_t last = ((index + 1) * vertex_size - 1) / FetchLineSize;
+
+		for (std::size_t line = first; line <= last; ++line)
+		{
+			if (line_cache.Access(static_cast<std::uint32_t>(line)))
+			{
+				result.bytesFetched += FetchLineSize;
+			}
+		}
+	}
+
+	result.overfetch = static_cast<double>(result.bytesFetched) / static_cast<double>(unique * vertex_size);
+
+	return result;
+}
+
+bool
+gl::mesh::FitsShortIndices(std::span<const std::uint32_t> indices)
+noexcept
+{
+	return std::all_of(indices.begin(), indices.end(), [](std::uint32_t index) noexcept {
+		return index < std::numeric_limits<std::uint16_t>::max();
+	});
+}
@@ -17,6 +17,9 @@ constinit static const GLubyte* version_render = nullptr;
 constinit static const GLubyte* version_shader = nullptr;
 constinit static const GLubyte* version_extent = nullptr;
 
+// The context is bound to one thread, so is the listener
+constinit static gl::global::StateListener state_listener = nullptr;
+
 std::string_view
 gl::info::GetVersion()
 noexcept
@@ -61,6 +64,8 @@ void
 gl::global::SetState(const gl::State& state)
 noexcept
 {
+	NotifyStateChange();
+
 	::glEnable(static_cast<GLenum>(state));
 }
 
@@ -68,6 +73,8 @@ void
 gl::global::SetState(gl::State&& state)
 noexcept
 {
+	NotifyStateChange();
+
 	::glEnable(static_cast<GLenum>(state));
 }
 
@@ -75,6 +82,8 @@ void
 gl::global::SetState(const volatile gl::State& state)
 noexcept
 {
+	NotifyStateChange();
+
 	::glEnable(static_cast<GLenum>(state));
 }
 
@@ -82,6 +91,8 @@ void
 gl::global::SetState(volatile gl::State&& state)
 noexcept
 {
+	NotifyStateChange();
+
 	::glEnable(static_cast<GLenum>(state));
 }
 
@@ -89,6 +100,8 @@ void
 gl::global::SetState(const gl::State& state, bool flag)
 noexcept
 {
+	NotifyStateChange();
+
 	if (flag)
 	{
 		::glEnable(static_cast<GLenum>(state));
@@ -103,6 +116,8 @@ void
 gl::global::SetState(const volatile gl::State& state, bool flag)
 noexcept
 {
+	NotifyStateChange();
+
 	if (flag)
 	{
 		::glEnable(static_cast<GLenum>(state));
@@ -117,6 +132,8 @@ void
 gl::global::SetState(gl::State&& state, bool flag)
 noexcept
 {
+	NotifyStateChange();
+
 	if (flag)
 	{
 		::glEnable(static_cast<GLenum>(state));
@@ -131,6 +148,8 @@ void
 gl::global::SetState(volatile gl::State&& state, bool flag)
 noexcept
 {
+	NotifyStateChange();
+
 	if (flag)
 	{
 		::glEnable(static_cast<GLenum>(state));
@@ -141,6 +160,30 @@ noexcept
 	}
 }
 
+void
+gl::global::SetStateListener(gl::global::StateListener listener)
+noexcept
+{
+	state_listener = listener;
+}
+
+gl::global::StateListener
+gl::global::GetStateListener()
+noexcept
+{
+	return state_listener;
+}
+
+void
+gl::global::NotifyStateChange()
+noexcept
+{
+	if (nullptr != state_listener)
+	{
+		state_listener();
+	}
+}
+
 void
 gl::global::SetBackgroundColour(const gl::win32::Colour& colour)
 noexcept
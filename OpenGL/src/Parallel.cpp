@@ -0,0 +1,182 @@
+module Glib.Parallel;
+import <atomic>;
+
+namespace
+{
+	// Set on the pool threads, and on a caller while it takes part in its loop
+	constinit thread_local bool isInsideLoop = false;
+}
+
+struct gl::WorkerPool::Job
+{
+	Task task;
+	void* context;
+	std::uint32_t count;
+	std::uint32_t threads;
+
+	std::atomic<std::uint32_t> next{ 0 };
+	// The caller is the worker zero
+	std::atomic<std::uint32_t> joined{ 1 };
+
+	std::mutex errorMutex{};
+	std::exception_ptr error{};
+
+	void
+	Execute(std::uint32_t worker)
+	noexcept
+	{
+		try
+		{
+			for (std::uint32_t i = next++; i < count; i = next++)
+			{
+				task(context, i, worker);
+			}
+		}
+		catch (...)
+		{
+			// The other workers stop at their next index
+			next = count;
+
+			std::lock_guard lock{ errorMutex };
+			if (not error)
+			{
+				error = std::current_exception();
+			}
+		}
+	}
+};
+
+gl::WorkerPool::~WorkerPool()
+noexcept
+{
+	{
+		std::lock_guard lock{ myMutex };
+		isStopping = true;
+	}
+
+	myWakeup.notify_all();
+
+	for (std::thread& thread : myThreads)
+	{
+		thread.join();
+	}
+}
+
+void
+gl::WorkerPool::Run(std::uint32_t threads, std::uint32_t count, gl::WorkerPool::Task task, void* context)
+{
+	threads = std::min(threads, count);
+
+	// A loop inside a loop would wait for the workers running its parent
+	if (threads <= 1 or isInsideLoop)
+	{
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			task(context, i, 0U);
+		}
+
+		return;
+	}
+
+	std::lock_guard running{ myRunning };
+
+	Grow(threads - 1);
+
+	Job job{ task, context, count, threads };
+
+	{
+		std::lock_guard lock{ myMutex };
+		myJob = std::addressof(job);
+		++myGeneration;
+	}
+
+	myWakeup.notify_all();
+
+	isInsideLoop = true;
+	job.Execute(0);
+	isInsideLoop = false;
+
+	{
+		// The job lives on this stack, so every thread which picked it up has to let go first
+		std::unique_lock lock{ myMutex };
+		myJob = nullptr;
+		myFinished.wait(lock, [this]() noexcept {
+			return 0 == myBusyThreads;
+		});
+	}
+
+	if (job.error)
+	{
+		std::rethrow_exception(job.error);
+	}
+}
+
+std::uint32_t
+gl::WorkerPool::GetThreadCount()
+const noexcept
+{
+	std::lock_guard lock{ myMutex };
+
+	return static_cast<std::uint32_t>(myThreads.size());
+}
+
+gl::WorkerPool&
+gl::WorkerPool::GetShared()
+noexcept
+{
+	static WorkerPool pool{};
+
+	return pool;
+}
+
+void
+gl::WorkerPool::Grow(std::uint32_t threads)
+{
+	std::lock_guard lock{ myMutex };
+
+	while (myThreads.size() < threads)
+	{
+		myThreads.emplace_back(&WorkerPool::Work, this);
+	}
+}
+
+void
+gl::WorkerPool::Work()
+noexcept
+{
+	isInsideLoop = true;
+
+	std::uint64_t seen = 0;
+	std::unique_lock lock{ myMutex };
+
+	while (true)
+	{
+		myWakeup.wait(lock, [&]() noexcept {
+			return isStopping or (nullptr != myJob and seen != myGeneration);
+		});
+
+		if (isStopping)
+		{
+			return;
+		}
+
+		seen = myGeneration;
+		Job& job = *myJob;
+		++myBusyThreads;
+
+		lock.unlock();
+
+		// The pool may have more threads than this loop wants
+		if (const std::uint32_t worker = job.joined++; worker < job.threads)
+		{
+			job.Execute(worker);
+		}
+
+		lock.lock();
+
+		if (0 == --myBusyThreads)
+		{
+			myFinished.notify_all();
+		}
+	}
+}
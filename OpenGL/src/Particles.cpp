@@ -0,0 +1,756 @@
+module;
+#define NOMINMAX
+#include <Windows.h>
+#include "glew.h"
+#include <gl\gl.h>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define GLIB_PARTICLE_SSE 1
+#else
+#define GLIB_PARTICLE_SSE 0
+#endif
+
+module Glib.Particles;
+import <cmath>;
+import <string_view>;
+import <algorithm>;
+import <utility>;
+import <chrono>;
+import <random>;
+import Glib.Parallel;
+
+namespace
+{
+	constexpr std::string_view VertexSource = R"(#version 430 core
+layout(location = 0) in vec4 instance;
+layout(location = 1) in vec4 colour;
+
+layout(location = 0) uniform mat4 view;
+layout(location = 1) uniform mat4 projection;
+
+out vec2 particleCorner;
+out vec4 particleColour;
+
+void main()
+{
+	// The corners of the strip come from the vertex index, only the instances are streamed
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+	vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+	vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+	vec3 position = instance.xyz + (corner.x * right + corner.y * up) * (instance.w * 0.5);
+
+	particleCorner = corner;
+	particleColour = colour;
+	gl_Position = projection * view * vec4(position, 1.0);
+}
+)";
+
+	constexpr std::string_view FragmentSource = R"(#version 430 core
+in vec2 particleCorner;
+in vec4 particleColour;
+
+out vec4 fragment;
+
+void main()
+{
+	float falloff = clamp(1.0 - dot(particleCorner, particleCorner), 0.0, 1.0);
+
+	fragment = vec4(particleColour.rgb, particleColour.a * falloff);
+}
+)";
+
+	// Instances the buffer is created for, it grows by doubling
+	constexpr std::size_t InitialCapacity = 1U << 14;
+
+	void
+	Store(gl::particle::Pool& pool, std::size_t index, const gl::particle::Particle& particle)
+	noexcept
+	{
+		pool.x[index] = particle.x;
+		pool.y[index] = particle.y;
+		pool.z[index] = particle.z;
+		pool.vx[index] = particle.vx;
+		pool.vy[index] = particle.vy;
+		pool.vz[index] = particle.vz;
+		pool.age[index] = 0;
+		pool.inverseLifetime[index] = 1.0f / std::max(particle.lifetime, 1e-6f);
+		pool.size[index] = particle.size;
+	}
+
+	[[nodiscard]]
+	std::uint64_t
+	NextRandom(std::uint64_t& state)
+	noexcept
+	{
+		// xorshift64*, a zero state would stay zero
+		if (0 == state)
+		{
+			state = 0x9E3779B97F4A7C15ULL;
+		}
+
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+
+		return state * 0x2545F4914F6CDD1DULL;
+	}
+
+	[[nodiscard]]
+	float
+	Uniform(std::uint64_t& state, float low, float high)
+	noexcept
+	{
+		const float unit = static_cast<float>(NextRandom(state) >> 40) * (1.0f / 16777216.0f);
+
+		return low + (high - low) * unit;
+	}
+
+	[[nodiscard]]
+	std::uint32_t
+	PackUnit(float value)
+	noexcept
+	{
+		// Rounded to the nearest even like the SIMD conversion
+		return static_cast<std::uint32_t>(std::nearbyint(std::clamp(value * 255.0f, 0.0f, 255.0f)));
+	}
+
+	void
+	WriteInstance(const gl::particle::Pool& pool, std::size_t index, const gl::particle::Gradient& gradient, gl::particle::Instance& output)
+	noexcept
+	{
+		const float t = std::min(pool.age[index] * pool.inverseLifetime[index], 1.0f);
+
+		std::uint32_t colour = 0;
+		for (std::uint32_t channel = 0; channel < 4; ++channel)
+		{
+			const float value = gradient.begin[channel] + (gradient.end[channel] - gradient.begin[channel]) * t;
+			colour |= PackUnit(value) << (8 * channel);
+		}
+
+		output.x = pool.x[index];
+		output.y = pool.y[index];
+		output.z = pool.z[index];
+		output.size = pool.size[index] * (1 + (gradient.endSize - 1) * t);
+		output.colour = colour;
+	}
+
+#if GLIB_PARTICLE_SSE
+	[[nodiscard]]
+	__m128i
+	PackChannel(__m128 begin, __m128 difference, __m128 t)
+	noexcept
+	{
+		const __m128 value = _mm_add_ps(begin, _mm_mul_ps(difference, t));
+		const __m128 scaled = _mm_min_ps(_mm_max_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_setzero_ps()), _mm_set1_ps(255.0f));
+
+		return _mm_cvtps_epi32(scaled);
+	}
+#endif
+}
+
+gl::particle::Pool::Pool(std::size_t capacity)
+	: capacity(capacity)
+{
+	for (std::vector<float>* field : { &x, &y, &z, &vx, &vy, &vz, &age, &inverseLifetime, &size })
+	{
+		field->resize(capacity);
+	}
+}
+
+bool
+gl::particle::Pool::Spawn(const gl::particle::Particle& particle)
+noexcept
+{
+	if (capacity <= count)
+	{
+		return false;
+	}
+
+	Store(*this, count++, particle);
+
+	return true;
+}
+
+void
+gl::particle::Pool::Kill(std::size_t index)
+noexcept
+{
+	if (count <= index)
+	{
+		return;
+	}
+
+	const std::size_t last = --count;
+	if (index == last)
+	{
+		return;
+	}
+
+	for (std::vector<float>* field : { &x, &y, &z, &vx, &vy, &vz, &age, &inverseLifetime, &size })
+	{
+		(*field)[index] = (*field)[last];
+	}
+}
+
+std::size_t
+gl::particle::Pool::RemoveDead()
+noexcept
+{
+	std::size_t result = 0;
+	std::size_t i = 0;
+
+	while (i < count)
+	{
+#if GLIB_PARTICLE_SSE
+		// Most groups of four have no dead particle, skip them with one comparison
+		if (i + 4 <= count)
+		{
+			const __m128 life = _mm_mul_ps(_mm_loadu_ps(age.data() + i), _mm_loadu_ps(inverseLifetime.data() + i));
+			if (0 == _mm_movemask_ps(_mm_cmpge_ps(life, _mm_set1_ps(1.0f))))
+			{
+				i += 4;
+				continue;
+			}
+		}
+#endif
+
+		// The last particle moved in its place is checked on the next iteration
+		if (1.0f <= age[i] * inverseLifetime[i])
+		{
+			Kill(i);
+			++result;
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	return result;
+}
+
+void
+gl::particle::Pool::Clear()
+noexcept
+{
+	count = 0;
+}
+
+std::size_t
+gl::particle::Pool::GetSize()
+const noexcept
+{
+	return count;
+}
+
+std::size_t
+gl::particle::Pool::GetCapacity()
+const noexcept
+{
+	return capacity;
+}
+
+void
+gl::particle::Integrate(gl::particle::Pool& pool, std::size_t begin, std::size_t end, float delta_time, const gl::particle::Forces& forces)
+noexcept
+{
+	std::size_t i = begin;
+
+#if GLIB_PARTICLE_SSE
+	const float damping = std::max(0.0f, 1.0f - forces.drag * delta_time);
+
+	const __m128 dt = _mm_set1_ps(delta_time);
+	const __m128 damp = _mm_set1_ps(damping);
+	const __m128 gx = _mm_set1_ps(forces.gravity[0] * delta_time);
+	const __m128 gy = _mm_set1_ps(forces.gravity[1] * delta_time);
+	const __m128 gz = _mm_set1_ps(forces.gravity[2] * delta_time);
+
+	float* const x = pool.x.data();
+	float* const y = pool.y.data();
+	float* const z = pool.z.data();
+	float* const vx = pool.vx.data();
+	float* const vy = pool.vy.data();
+	float* const vz = pool.vz.data();
+	float* const age = pool.age.data();
+
+	for (; i + 4 <= end; i += 4)
+	{
+		const __m128 nvx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vx + i), damp), gx);
+		const __m128 nvy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vy + i), damp), gy);
+		const __m128 nvz = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vz + i), damp), gz);
+
+		_mm_storeu_ps(vx + i, nvx);
+		_mm_storeu_ps(vy + i, nvy);
+		_mm_storeu_ps(vz + i, nvz);
+
+		_mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(nvx, dt)));
+		_mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(nvy, dt)));
+		_mm_storeu_ps(z + i, _mm_add_ps(_mm_loadu_ps(z + i), _mm_mul_ps(nvz, dt)));
+		_mm_storeu_ps(age + i, _mm_add_ps(_mm_loadu_ps(age + i), dt));
+	}
+#endif
+
+	IntegrateScalar(pool, i, end, delta_time, forces);
+}
+
+void
+gl::particle::IntegrateScalar(gl::particle::Pool& pool, std::size_t begin, std::size_t end, float delta_time, const gl::particle::Forces& forces)
+noexcept
+{
+	// The velocity first, then the position with the new velocity
+	const float damping = std::max(0.0f, 1.0f - forces.drag * delta_time);
+	const float gx = forces.gravity[0] * delta_time;
+	const float gy = forces.gravity[1] * delta_time;
+	const float gz = forces.gravity[2] * delta_time;
+
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		pool.vx[i] = pool.vx[i] * damping + gx;
+		pool.vy[i] = pool.vy[i] * damping + gy;
+		pool.vz[i] = pool.vz[i] * damping + gz;
+
+		pool.x[i] += pool.vx[i] * delta_time;
+		pool.y[i] += pool.vy[i] * delta_time;
+		pool.z[i] += pool.vz[i] * delta_time;
+		pool.age[i] += delta_time;
+	}
+}
+
+void
+gl::particle::WriteInstances(const gl::particle::Pool& pool, std::size_t begin, std::size_t end, const gl::particle::Gradient& gradient, gl::particle::Instance* destination)
+noexcept
+{
+	std::size_t i = begin;
+
+#if GLIB_PARTICLE_SSE
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 size_change = _mm_set1_ps(gradient.endSize - 1);
+
+	__m128 channel_begin[4], channel_difference[4];
+	for (std::uint32_t channel = 0; channel < 4; ++channel)
+	{
+		channel_begin[channel] = _mm_set1_ps(gradient.begin[channel]);
+		channel_difference[channel] = _mm_set1_ps(gradient.end[channel] - gradient.begin[channel]);
+	}
+
+	for (; i + 4 <= end; i += 4)
+	{
+		const __m128 t = _mm_min_ps(_mm_mul_ps(_mm_loadu_ps(pool.age.data() + i), _mm_loadu_ps(pool.inverseLifetime.data() + i)), one);
+
+		__m128i packed = PackChannel(channel_begin[0], channel_difference[0], t);
+		packed = _mm_or_si128(packed, _mm_slli_epi32(PackChannel(channel_begin[1], channel_difference[1], t), 8));
+		packed = _mm_or_si128(packed, _mm_slli_epi32(PackChannel(channel_begin[2], channel_difference[2], t), 16));
+		packed = _mm_or_si128(packed, _mm_slli_epi32(PackChannel(channel_begin[3], channel_difference[3], t), 24));
+		const __m128 colour = _mm_castsi128_ps(packed);
+
+		__m128 p0 = _mm_loadu_ps(pool.x.data() + i);
+		__m128 p1 = _mm_loadu_ps(pool.y.data() + i);
+		__m128 p2 = _mm_loadu_ps(pool.z.data() + i);
+		__m128 p3 = _mm_mul_ps(_mm_loadu_ps(pool.size.data() + i), _mm_add_ps(one, _mm_mul_ps(size_change, t)));
+
+		// Rows of x, y, z and size into one register per particle
+		_MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+		// Five registers of twenty floats, the colour of each particle slotted after its size
+		const __m128 s1c1 = _mm_shuffle_ps(p1, colour, _MM_SHUFFLE(1, 1, 3, 3));
+		const __m128 c2x3 = _mm_shuffle_ps(colour, p3, _MM_SHUFFLE(0, 0, 2, 2));
+		const __m128 s3c3 = _mm_shuffle_ps(p3, colour, _MM_SHUFFLE(3, 3, 3, 3));
+
+		float* const output = reinterpret_cast<float*>(destination + (i - begin));
+		_mm_storeu_ps(output, p0);
+		_mm_storeu_ps(output + 4, _mm_move_ss(_mm_shuffle_ps(p1, p1, _MM_SHUFFLE(2, 1, 0, 0)), colour));
+		_mm_storeu_ps(output + 8, _mm_shuffle_ps(s1c1, p2, _MM_SHUFFLE(1, 0, 2, 0)));
+		_mm_storeu_ps(output + 12, _mm_shuffle_ps(p2, c2x3, _MM_SHUFFLE(2, 0, 3, 2)));
+		_mm_storeu_ps(output + 16, _mm_shuffle_ps(p3, s3c3, _MM_SHUFFLE(2, 0, 2, 1)));
+	}
+#endif
+
+	for (; i < end; ++i)
+	{
+		WriteInstance(pool, i, gradient, destination[i - begin]);
+	}
+}
+
+gl::particle::Benchmark
+gl::particle::MeasureSimulation(std::size_t particles, std::uint32_t iterations, std::uint32_t threads)
+{
+	using clock = std::chrono::steady_clock;
+
+	Benchmark result{};
+	result.particles = particles;
+	result.threads = GetWorkerCount(threads);
+
+	Pool pool{ particles };
+
+	std::mt19937 random{ 7 };
+	std::uniform_real_distribution<float> position{ -100.0f, 100.0f };
+	std::uniform_real_distribution<float> velocity{ -10.0f, 10.0f };
+
+	for (std::size_t i = 0; i < particles; ++i)
+	{
+		// Long lived, so the pool stays full over the iterations
+		static_cast<void>(pool.Spawn(Particle
+		{
+			position(random), position(random), position(random),
+			velocity(random), velocity(random), velocity(random),
+			1000.0f, 1.0f
+		}));
+	}
+
+	std::vector<Instance> instances(particles);
+
+	const Forces forces{ { 0, -9.8f, 0 }, 0.1f };
+	const Gradient gradient{};
+	constexpr float delta_time = 1.0f / 60.0f;
+
+	const std::uint32_t chunks = static_cast<std::uint32_t>((particles + ChunkSize - 1) / ChunkSize);
+
+	const auto measure = [&](auto&& func) {
+		double best = 1e9;
+
+		for (std::uint32_t i = 0; i < std::max(1U, iterations); ++i)
+		{
+			const auto start = clock::now();
+			func();
+			best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+		}
+
+		return static_cast<double>(particles) / std::max(best, 1e-9);
+	};
+
+	result.scalarPerSecond = measure([&] {
+		IntegrateScalar(pool, 0, particles, delta_time, forces);
+	});
+
+	result.simdPerSecond = measure([&] {
+		Integrate(pool, 0, particles, delta_time, forces);
+	});
+
+	result.parallelPerSecond = measure([&] {
+		ParallelFor(result.threads, chunks, [&](std::uint32_t chunk, std::uint32_t) {
+			const std::size_t begin = chunk * ChunkSize;
+			Integrate(pool, begin, std::min(particles, begin + ChunkSize), delta_time, forces);
+		});
+	});
+
+	result.instancesPerSecond = measure([&] {
+		ParallelFor(result.threads, chunks, [&](std::uint32_t chunk, std::uint32_t) {
+			const std::size_t begin = chunk * ChunkSize;
+			WriteInstances(pool, begin, std::min(particles, begin + ChunkSize), gradient, instances.data() + begin);
+		});
+	});
+
+	return result;
+}
+
+gl::ParticleSystem::ParticleSystem(std::size_t capacity, std::uint32_t threads)
+	: myPool(capacity)
+	, myThreads(GetWorkerCount(threads))
+{}
+
+gl::particle::EmitterId
+gl::ParticleSystem::AddEmitter(const gl::particle::Emitter& emitter)
+{
+	myEmitters.push_back(emitter);
+	mySpawnOffsets.push_back(0);
+	mySpawnCounts.push_back(0);
+
+	return static_cast<particle::EmitterId>(myEmitters.size() - 1);
+}
+
+gl::particle::Emitter&
+gl::ParticleSystem::GetEmitter(gl::particle::EmitterId id)
+noexcept
+{
+	return myEmitters[id];
+}
+
+void
+gl::ParticleSystem::ClearEmitters()
+noexcept
+{
+	myEmitters.clear();
+	mySpawnOffsets.clear();
+	mySpawnCounts.clear();
+}
+
+void
+gl::ParticleSystem::SetForces(const gl::particle::Forces& forces)
+noexcept
+{
+	myForces = forces;
+}
+
+void
+gl::ParticleSystem::SetGradient(const gl::particle::Gradient& gradient)
+noexcept
+{
+	myGradient = gradient;
+}
+
+void
+gl::ParticleSystem::Update(float delta_time)
+{
+	particle::Statistics statistics{};
+
+	// Every emitter gets its own range past the alive particles, in order, until the pool is full
+	const std::size_t room = myPool.capacity - myPool.count;
+	std::size_t spawned = 0;
+
+	for (std::size_t i = 0; i < myEmitters.size(); ++i)
+	{
+		particle::Emitter& emitter = myEmitters[i];
+		mySpawnCounts[i] = 0;
+
+		if (not emitter.isActive || emitter.rate <= 0)
+		{
+			continue;
+		}
+
+		emitter.accumulator += emitter.rate * delta_time;
+		const float whole = std::floor(emitter.accumulator);
+		emitter.accumulator -= whole;
+
+		const std::size_t wanted = static_cast<std::size_t>(whole);
+		const std::size_t given = std::min(wanted, room - spawned);
+
+		mySpawnOffsets[i] = myPool.count + spawned;
+		mySpawnCounts[i] = given;
+		spawned += given;
+		statistics.dropped += wanted - given;
+	}
+
+	ParallelFor(myThreads, static_cast<std::uint32_t>(myEmitters.size()), [&](std::uint32_t i, std::uint32_t) {
+		particle::Emitter& emitter = myEmitters[i];
+		const std::size_t offset = mySpawnOffsets[i];
+
+		for (std::size_t j = 0; j < mySpawnCounts[i]; ++j)
+		{
+			std::uint64_t& state = emitter.seed;
+
+			const particle::Particle particle
+			{
+				emitter.position[0], emitter.position[1], emitter.position[2],
+				emitter.velocity[0] + Uniform(state, -emitter.spread[0], emitter.spread[0]),
+				emitter.velocity[1] + Uniform(state, -emitter.spread[1], emitter.spread[1]),
+				emitter.velocity[2] + Uniform(state, -emitter.spread[2], emitter.spread[2]),
+				Uniform(state, emitter.minLifetime, emitter.maxLifetime),
+				Uniform(state, emitter.minSize, emitter.maxSize),
+			};
+
+			Store(myPool, offset + j, particle);
+		}
+	});
+
+	myPool.count += spawned;
+	statistics.spawned = spawned;
+
+	const std::size_t count = myPool.count;
+	const std::uint32_t chunks = static_cast<std::uint32_t>((count + particle::ChunkSize - 1) / particle::ChunkSize);
+
+	ParallelFor(myThreads, chunks, [&](std::uint32_t chunk, std::uint32_t) {
+		const std::size_t begin = chunk * particle::ChunkSize;
+		particle::Integrate(myPool, begin, std::min(count, begin + particle::ChunkSize), delta_time, myForces);
+	});
+
+	statistics.killed = myPool.RemoveDead();
+	statistics.alive = myPool.count;
+
+	myStatistics = statistics;
+}
+
+void
+gl::ParticleSystem::Clear()
+noexcept
+{
+	myPool.Clear();
+	myStatistics.alive = 0;
+}
+
+std::size_t
+gl::ParticleSystem::WriteInstances(std::span<gl::particle::Instance> destination)
+const
+{
+	const std::size_t count = std::min(myPool.count, destination.size());
+	const std::uint32_t chunks = static_cast<std::uint32_t>((count + particle::ChunkSize - 1) / particle::ChunkSize);
+
+	ParallelFor(myThreads, chunks, [&](std::uint32_t chunk, std::uint32_t) {
+		const std::size_t begin = chunk * particle::ChunkSize;
+		particle::WriteInstances(myPool, begin, std::min(count, begin + particle::ChunkSize), myGradient, destination.data() + begin);
+	});
+
+	return count;
+}
+
+const gl::particle::Pool&
+gl::ParticleSystem::GetPool()
+const noexcept
+{
+	return myPool;
+}
+
+const gl::particle::Statistics&
+gl::ParticleSystem::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+std::size_t
+gl::ParticleSystem::GetSize()
+const noexcept
+{
+	return myPool.count;
+}
+
+gl::ParticleRenderer::~ParticleRenderer()
+noexcept
+{
+	Destroy();
+}
+
+bool
+gl::ParticleRenderer::Create()
+noexcept
+{
+	if (IsCreated())
+	{
+		return true;
+	}
+
+	myPipeline = std::make_unique<Pipeline>();
+
+	Shader vertex_shader{ shader::ShaderType::Vertex };
+	Shader fragment_shader{ shader::ShaderType::Fragment };
+
+	if (not myPipeline->IsValid()
+		|| shader::ErrorCode::Success != vertex_shader.Compile(VertexSource)
+		|| shader::ErrorCode::Success != fragment_shader.Compile(FragmentSource))
+	{
+		myPipeline.reset();
+		return false;
+	}
+
+	myPipeline->AddShader(std::move(vertex_shader));
+	myPipeline->AddShader(std::move(fragment_shader));
+	myPipeline->Start();
+
+	GLint linked = GL_FALSE;
+	::glGetProgramiv(myPipeline->GetID(), GL_LINK_STATUS, std::addressof(linked));
+	if (GL_FALSE == linked)
+	{
+		myPipeline.reset();
+		return false;
+	}
+
+	myCapacity = InitialCapacity;
+
+	::glGenVertexArrays(1, std::addressof(myVertexArray));
+	::glBindVertexArray(myVertexArray);
+
+	::glGenBuffers(1, std::addressof(myInstanceBuffer));
+	::glBindBuffer(GL_ARRAY_BUFFER, myInstanceBuffer);
+	::glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(myCapacity * sizeof(particle::Instance)), nullptr, GL_STREAM_DRAW);
+
+	constexpr GLsizei stride = sizeof(particle::Instance);
+
+	::glEnableVertexAttribArray(0);
+	::glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(particle::Instance, x)));
+	::glVertexAttribDivisor(0, 1);
+	::glEnableVertexAttribArray(1);
+	::glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(particle::Instance, colour)));
+	::glVertexAttribDivisor(1, 1);
+
+	::glBindVertexArray(0);
+	::glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return true;
+}
+
+void
+gl::ParticleRenderer::Destroy()
+noexcept
+{
+	if (0 != myInstanceBuffer)
+	{
+		::glDeleteBuffers(1, std::addressof(myInstanceBuffer));
+		myInstanceBuffer = 0;
+	}
+
+	if (0 != myVertexArray)
+	{
+		::glDeleteVertexArrays(1, std::addressof(myVertexArray));
+		myVertexArray = 0;
+	}
+
+	myPipeline.reset();
+	myCapacity = 0;
+}
+
+std::size_t
+gl::ParticleRenderer::Draw(const gl::ParticleSystem& system, const std::array<float, 16>& view, const std::array<float, 16>& projection, const gl::BlendMode& blend)
+{
+	const std::size_t count = system.GetSize();
+	if (0 == count || not IsCreated())
+	{
+		return 0;
+	}
+
+	while (myCapacity < count)
+	{
+		myCapacity *= 2;
+	}
+
+	// The bindings of the caller are bound again once the particles are drawn
+	GLint previous_program = 0, previous_array = 0, previous_buffer = 0;
+	::glGetIntegerv(GL_CURRENT_PROGRAM, std::addressof(previous_program));
+	::glGetIntegerv(GL_VERTEX_ARRAY_BINDING, std::addressof(previous_array));
+	::glGetIntegerv(GL_ARRAY_BUFFER_BINDING, std::addressof(previous_buffer));
+
+	// Orphaned, then written by the workers straight into the mapping
+	const GLsizeiptr capacity_bytes = static_cast<GLsizeiptr>(myCapacity * sizeof(particle::Instance));
+	const GLsizeiptr used_bytes = static_cast<GLsizeiptr>(count * sizeof(particle::Instance));
+
+	::glBindBuffer(GL_ARRAY_BUFFER, myInstanceBuffer);
+	::glBufferData(GL_ARRAY_BUFFER, capacity_bytes, nullptr, GL_STREAM_DRAW);
+
+	void* const mapping = ::glMapBufferRange(GL_ARRAY_BUFFER, 0, used_bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (nullptr == mapping)
+	{
+		::glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(previous_buffer));
+		return 0;
+	}
+
+	const std::size_t written = system.WriteInstances(std::span<particle::Instance>{ static_cast<particle::Instance*>(mapping), count });
+
+	::glUnmapBuffer(GL_ARRAY_BUFFER);
+
+	myPipeline->Use();
+	::glUniformMatrix4fv(0, 1, GL_FALSE, view.data());
+	::glUniformMatrix4fv(1, 1, GL_FALSE, projection.data());
+	::glBindVertexArray(myVertexArray);
+
+	// Tested against the depth but not written to it, so the order of the particles doesn't matter
+	GLboolean depth_mask = GL_TRUE;
+	::glGetBooleanv(GL_DEPTH_WRITEMASK, std::addressof(depth_mask));
+	::glDepthMask(GL_FALSE);
+
+	{
+		Blender blender{ blend };
+		::glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(written));
+	}
+
+	::glDepthMask(depth_mask);
+	::glBindVertexArray(static_cast<GLuint>(previous_array));
+	::glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(previous_buffer));
+	::glUseProgram(static_cast<GLuint>(previous_program));
+
+	return written;
+}
+
+bool
+gl::ParticleRenderer::IsCreated()
+const noexcept
+{
+	return nullptr != myPipeline && 0 != myVertexArray;
+}
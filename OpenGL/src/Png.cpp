@@ -0,0 +1,1359 @@
+module;
+#include "../fpng.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define GLIB_PNG_SSE2 1
+#else
+#define GLIB_PNG_SSE2 0
+#endif
+
+module Glib.Png;
+import <cstring>;
+import <chrono>;
+import <algorithm>;
+import <new>;
+
+namespace
+{
+	using gl::png::DecodeResult;
+
+	constexpr std::uint8_t Signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+	// Keeps every row and image size computation inside 64 bits
+	constexpr std::uint32_t MaxDimension = 1U << 24;
+	constexpr std::uint64_t MaxPixels = 1ULL << 29;
+
+	enum ColourType : std::uint8_t
+	{
+		Greyscale = 0,
+		Truecolour = 2,
+		Indexed = 3,
+		GreyscaleAlpha = 4,
+		TruecolourAlpha = 6,
+	};
+
+	[[nodiscard]]
+	constexpr std::uint32_t
+	ReadBigEndian(const std::uint8_t* p)
+	noexcept
+	{
+		return (static_cast<std::uint32_t>(p[0]) << 24) | (static_cast<std::uint32_t>(p[1]) << 16) | (static_cast<std::uint32_t>(p[2]) << 8) | p[3];
+	}
+
+	[[nodiscard]]
+	constexpr std::uint32_t
+	MakeChunkType(const char(&name)[5])
+	noexcept
+	{
+		return (static_cast<std::uint32_t>(name[0]) << 24) | (static_cast<std::uint32_t>(name[1]) << 16) | (static_cast<std::uint32_t>(name[2]) << 8) | static_cast<std::uint32_t>(name[3]);
+	}
+
+	[[nodiscard]]
+	constexpr std::uint32_t
+	GetChannels(std::uint8_t colour_type)
+	noexcept
+	{
+		switch (colour_type)
+		{
+			case Greyscale: return 1;
+			case Truecolour: return 3;
+			case Indexed: return 1;
+			case GreyscaleAlpha: return 2;
+			case TruecolourAlpha: return 4;
+			default: return 0;
+		}
+	}
+
+	[[nodiscard]]
+	constexpr bool
+	IsValidDepth(std::uint8_t colour_type, std::uint8_t depth)
+	noexcept
+	{
+		switch (colour_type)
+		{
+			case Greyscale: return 1 == depth || 2 == depth || 4 == depth || 8 == depth || 16 == depth;
+			case Indexed: return 1 == depth || 2 == depth || 4 == depth || 8 == depth;
+			case Truecolour:
+			case GreyscaleAlpha:
+			case TruecolourAlpha: return 8 == depth || 16 == depth;
+			default: return false;
+		}
+	}
+
+	// Adam7 passes: x start, y start, x step, y step
+	constexpr std::uint32_t Adam7[7][4] =
+	{
+		{ 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 },
+	};
+
+	// ---- Inflate (RFC 1951)
+
+	constexpr std::uint32_t FastBits = 10;
+	constexpr std::uint32_t MaxSymbols = 288;
+
+	constexpr std::uint16_t LengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	constexpr std::uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr std::uint16_t DistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	constexpr std::uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	constexpr std::uint8_t CodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	[[nodiscard]]
+	constexpr std::uint32_t
+	ReverseBits(std::uint32_t code, std::uint32_t length)
+	noexcept
+	{
+		std::uint32_t result = 0;
+		for (std::uint32_t i = 0; i < length; ++i, code >>= 1)
+		{
+			result = (result << 1) | (code & 1);
+		}
+
+		return result;
+	}
+
+	/// <summary>
+	/// Canonical huffman decoding table
+	/// <para>Codes up to FastBits long resolve with one lookup, longer ones walk the per length ranges.</para>
+	/// </summary>
+	struct Huffman
+	{
+		// (length << 9) | symbol, zero when the code is longer than FastBits
+		std::uint16_t fast[1U << FastBits];
+		std::uint16_t firstCode[17];
+		std::uint16_t firstSymbol[17];
+		// First code past each length, shifted to 16 bits
+		std::uint32_t maxCode[18];
+		std::uint8_t lengths[MaxSymbols];
+		std::uint16_t symbols[MaxSymbols];
+
+		[[nodiscard]]
+		bool
+		Build(const std::uint8_t* code_lengths, std::uint32_t count)
+		noexcept
+		{
+			std::uint32_t counts[16]{};
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				++counts[code_lengths[i]];
+			}
+			counts[0] = 0;
+
+			std::uint32_t next_code[16]{};
+			std::uint32_t code = 0, symbol = 0;
+			for (std::uint32_t length = 1; length < 16; ++length)
+			{
+				if ((1U << length) < counts[length])
+				{
+					return false;
+				}
+
+				next_code[length] = code;
+				firstCode[length] = static_cast<std::uint16_t>(code);
+				firstSymbol[length] = static_cast<std::uint16_t>(symbol);
+
+				code += counts[length];
+				if (0 != counts[length] && (1U << length) <= code - 1)
+				{
+					return false;
+				}
+
+				maxCode[length] = code << (16 - length);
+				code <<= 1;
+				symbol += counts[length];
+			}
+			maxCode[16] = 0x10000;
+
+			std::fill(std::begin(fast), std::end(fast), static_cast<std::uint16_t>(0));
+
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				const std::uint32_t length = code_lengths[i];
+				if (0 == length)
+				{
+					continue;
+				}
+
+				const std::uint32_t slot = next_code[length] - firstCode[length] + firstSymbol[length];
+				lengths[slot] = static_cast<std::uint8_t>(length);
+				symbols[slot] = static_cast<std::uint16_t>(i);
+
+				if (length <= FastBits)
+				{
+					const std::uint16_t entry = static_cast<std::uint16_t>((length << 9) | i);
+					for (std::uint32_t j = ReverseBits(next_code[length], length); j < (1U << FastBits); j += 1U << length)
+					{
+						fast[j] = entry;
+					}
+				}
+
+				++next_code[length];
+			}
+
+			return true;
+		}
+	};
+
+	class Inflater
+	{
+	public:
+		Inflater(const std::uint8_t* source, std::size_t source_size, std::uint8_t* destination, std::size_t capacity) noexcept
+			: mySource(source), mySourceSize(source_size)
+			, myBegin(destination), myOutput(destination), myEnd(destination + capacity)
+		{}
+
+		/// <summary>
+		/// Inflate a zlib stream, the output has to fill the destination exactly
+		/// </summary>
+		[[nodiscard]]
+		bool
+		Run()
+		noexcept
+		{
+			const std::uint32_t cmf = Bits(8), flg = Bits(8);
+
+			// Deflate with a window up to 32KB, no preset dictionary
+			if (8 != (cmf & 15) || 7 < (cmf >> 4) || 0 != ((cmf << 8) | flg) % 31 || 0 != (flg & 32))
+			{
+				return false;
+			}
+
+			bool final = false;
+			while (not final)
+			{
+				if (IsOverrun())
+				{
+					return false;
+				}
+
+				final = 0 != Bits(1);
+
+				bool succeed = false;
+				switch (Bits(2))
+				{
+					case 0: succeed = Stored(); break;
+					case 1: succeed = Compressed(GetFixedTables()[0], GetFixedTables()[1]); break;
+					case 2: succeed = Dynamic(); break;
+					default: break;
+				}
+
+				if (not succeed)
+				{
+					return false;
+				}
+			}
+
+			if (myOutput != myEnd)
+			{
+				return false;
+			}
+
+			Consume(myBitCount & 7);
+
+			std::uint32_t adler = 0;
+			for (std::uint32_t i = 0; i < 4; ++i)
+			{
+				adler = (adler << 8) | Bits(8);
+			}
+
+			if (IsOverrun())
+			{
+				return false;
+			}
+
+			return adler == fpng::fpng_adler32(myBegin, static_cast<std::size_t>(myEnd - myBegin));
+		}
+
+	private:
+		void
+		Refill()
+		noexcept
+		{
+			if (myPosition + 8 <= mySourceSize)
+			{
+				// Little endian load of the next bytes, only the whole ones that fit are counted
+				std::uint64_t word;
+				std::memcpy(&word, mySource + myPosition, sizeof(word));
+
+				myBits |= word << myBitCount;
+				myPosition += (63 - myBitCount) >> 3;
+				myBitCount |= 56;
+				return;
+			}
+
+			// Past the end, zeros are fed and IsOverrun() reports them once they are consumed
+			while (myBitCount <= 56)
+			{
+				const std::uint64_t byte = myPosition < mySourceSize ? mySource[myPosition] : 0;
+
+				myBits |= byte << myBitCount;
+				myBitCount += 8;
+				++myPosition;
+			}
+		}
+
+		void
+		Consume(std::uint32_t count)
+		noexcept
+		{
+			myBits >>= count;
+			myBitCount -= count;
+		}
+
+		[[nodiscard]]
+		std::uint32_t
+		Bits(std::uint32_t count)
+		noexcept
+		{
+			if (myBitCount < count)
+			{
+				Refill();
+			}
+
+			const std::uint32_t result = static_cast<std::uint32_t>(myBits & ((1ULL << count) - 1));
+			Consume(count);
+
+			return result;
+		}
+
+		[[nodiscard]]
+		bool
+		IsOverrun()
+		const noexcept
+		{
+			return mySourceSize + myBitCount / 8 < myPosition;
+		}
+
+		[[nodiscard]]
+		int
+		Decode(const Huffman& table)
+		noexcept
+		{
+			if (myBitCount < 16)
+			{
+				Refill();
+			}
+
+			const std::uint32_t entry = table.fast[myBits & ((1U << FastBits) - 1)];
+			if (0 != entry)
+			{
+				Consume(entry >> 9);
+				return static_cast<int>(entry & 511);
+			}
+
+			const std::uint32_t code = ReverseBits(static_cast<std::uint32_t>(myBits & 0xFFFF), 16);
+
+			std::uint32_t length = FastBits + 1;
+			while (table.maxCode[length] <= code)
+			{
+				++length;
+			}
+
+			if (16 <= length)
+			{
+				return -1;
+			}
+
+			const std::uint32_t slot = (code >> (16 - length)) - table.firstCode[length] + table.firstSymbol[length];
+			if (MaxSymbols <= slot || table.lengths[slot] != length)
+			{
+				return -1;
+			}
+
+			Consume(length);
+
+			return table.symbols[slot];
+		}
+
+		[[nodiscard]]
+		bool
+		Stored()
+		noexcept
+		{
+			Consume(myBitCount & 7);
+
+			const std::uint32_t length = Bits(16);
+			const std::uint32_t complement = Bits(16);
+			if ((length ^ 0xFFFF) != complement || static_cast<std::size_t>(myEnd - myOutput) < length)
+			{
+				return false;
+			}
+
+			std::uint32_t remaining = length;
+
+			// Whole bytes still sitting in the bit buffer go first
+			for (; 0 < remaining && 8 <= myBitCount; --remaining)
+			{
+				*myOutput++ = static_cast<std::uint8_t>(Bits(8));
+			}
+
+			if (0 < remaining)
+			{
+				// The bit buffer may hold bytes ahead of the position, which are about to be skipped
+				myBits = 0;
+
+				if (mySourceSize < myPosition || mySourceSize - myPosition < remaining)
+				{
+					return false;
+				}
+
+				std::memcpy(myOutput, mySource + myPosition, remaining);
+				myOutput += remaining;
+				myPosition += remaining;
+			}
+
+			return true;
+		}
+
+		[[nodiscard]]
+		bool
+		Dynamic()
+		noexcept
+		{
+			const std::uint32_t literals = Bits(5) + 257;
+			const std::uint32_t distances = Bits(5) + 1;
+			const std::uint32_t code_lengths = Bits(4) + 4;
+
+			if (286 < literals || 30 < distances)
+			{
+				return false;
+			}
+
+			std::uint8_t lengths[19]{};
+			for (std::uint32_t i = 0; i < code_lengths; ++i)
+			{
+				lengths[CodeLengthOrder[i]] = static_cast<std::uint8_t>(Bits(3));
+			}
+
+			Huffman code_table;
+			if (not code_table.Build(lengths, 19))
+			{
+				return false;
+			}
+
+			std::uint8_t symbol_lengths[286 + 30]{};
+			const std::uint32_t total = literals + distances;
+
+			for (std::uint32_t i = 0; i < total;)
+			{
+				const int symbol = Decode(code_table);
+				if (symbol < 0)
+				{
+					return false;
+				}
+
+				if (symbol < 16)
+				{
+					symbol_lengths[i++] = static_cast<std::uint8_t>(symbol);
+					continue;
+				}
+
+				std::uint8_t fill = 0;
+				std::uint32_t repeat = 0;
+				if (16 == symbol)
+				{
+					if (0 == i)
+					{
+						return false;
+					}
+
+					fill = symbol_lengths[i - 1];
+					repeat = Bits(2) + 3;
+				}
+				else if (17 == symbol)
+				{
+					repeat = Bits(3) + 3;
+				}
+				else
+				{
+					repeat = Bits(7) + 11;
+				}
+
+				if (total - i < repeat)
+				{
+					return false;
+				}
+
+				std::fill_n(symbol_lengths + i, repeat, fill);
+				i += repeat;
+			}
+
+			// The end of block code has to exist
+			if (0 == symbol_lengths[256])
+			{
+				return false;
+			}
+
+			Huffman literal_table, distance_table;
+			if (not literal_table.Build(symbol_lengths, literals) || not distance_table.Build(symbol_lengths + literals, distances))
+			{
+				return false;
+			}
+
+			return Compressed(literal_table, distance_table);
+		}
+
+		[[nodiscard]]
+		bool
+		Compressed(const Huffman& literal_table, const Huffman& distance_table)
+		noexcept
+		{
+			for (;;)
+			{
+				int symbol = Decode(literal_table);
+				if (symbol < 0)
+				{
+					return false;
+				}
+
+				if (symbol < 256)
+				{
+					if (myOutput == myEnd)
+					{
+						return false;
+					}
+
+					*myOutput++ = static_cast<std::uint8_t>(symbol);
+					continue;
+				}
+
+				if (256 == symbol)
+				{
+					return true;
+				}
+
+				symbol -= 257;
+				if (29 <= symbol)
+				{
+					return false;
+				}
+
+				const std::size_t length = LengthBase[symbol] + Bits(LengthExtra[symbol]);
+
+				const int distance_symbol = Decode(distance_table);
+				if (distance_symbol < 0 || 30 <= distance_symbol)
+				{
+					return false;
+				}
+
+				const std::size_t distance = DistanceBase[distance_symbol] + Bits(DistanceExtra[distance_symbol]);
+				if (static_cast<std::size_t>(myOutput - myBegin) < distance || static_cast<std::size_t>(myEnd - myOutput) < length)
+				{
+					return false;
+				}
+
+				Copy(distance, length);
+
+				if (IsOverrun())
+				{
+					return false;
+				}
+			}
+		}
+
+		void
+		Copy(std::size_t distance, std::size_t length)
+		noexcept
+		{
+			const std::uint8_t* from = myOutput - distance;
+
+			if (1 == distance)
+			{
+				std::memset(myOutput, *from, length);
+			}
+			else if (8 <= distance && length + 8 <= static_cast<std::size_t>(myEnd - myOutput))
+			{
+				// Each 8 bytes chunk only reads bytes written before it
+				for (std::size_t i = 0; i < length; i += 8)
+				{
+					std::memcpy(myOutput + i, from + i, 8);
+				}
+			}
+			else
+			{
+				for (std::size_t i = 0; i < length; ++i)
+				{
+					myOutput[i] = from[i];
+				}
+			}
+
+			myOutput += length;
+		}
+
+		[[nodiscard]]
+		static const Huffman*
+		GetFixedTables()
+		noexcept
+		{
+			static const auto tables = []() noexcept {
+				struct Pair { Huffman table[2]; } result{};
+
+				std::uint8_t lengths[MaxSymbols]{};
+				std::fill(lengths, lengths + 144, static_cast<std::uint8_t>(8));
+				std::fill(lengths + 144, lengths + 256, static_cast<std::uint8_t>(9));
+				std::fill(lengths + 256, lengths + 280, static_cast<std::uint8_t>(7));
+				std::fill(lengths + 280, lengths + 288, static_cast<std::uint8_t>(8));
+				(void)result.table[0].Build(lengths, MaxSymbols);
+
+				std::fill(lengths, lengths + 30, static_cast<std::uint8_t>(5));
+				(void)result.table[1].Build(lengths, 30);
+
+				return result;
+			}();
+
+			return tables.table;
+		}
+
+		const std::uint8_t* mySource;
+		std::size_t mySourceSize;
+		std::size_t myPosition = 0;
+
+		std::uint64_t myBits = 0;
+		std::uint32_t myBitCount = 0;
+
+		std::uint8_t* myBegin;
+		std::uint8_t* myOutput;
+		std::uint8_t* myEnd;
+	};
+
+	// ---- Unfiltering
+
+	[[nodiscard]]
+	constexpr std::uint8_t
+	PaethPredictor(int a, int b, int c)
+	noexcept
+	{
+		const int pa = b - c < 0 ? c - b : b - c;
+		const int pb = a - c < 0 ? c - a : a - c;
+		const int pc = a + b - c - c < 0 ? c + c - a - b : a + b - c - c;
+
+		if (pa <= pb && pa <= pc)
+		{
+			return static_cast<std::uint8_t>(a);
+		}
+
+		return static_cast<std::uint8_t>(pb <= pc ? b : c);
+	}
+
+	void
+	UnfilterScalar(std::uint32_t filter, std::uint8_t* row, const std::uint8_t* prior, std::size_t size, std::size_t bpp)
+	noexcept
+	{
+		switch (filter)
+		{
+			case 1:
+			{
+				for (std::size_t i = bpp; i < size; ++i)
+				{
+					row[i] = static_cast<std::uint8_t>(row[i] + row[i - bpp]);
+				}
+			}
+			break;
+
+			case 2:
+			{
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					row[i] = static_cast<std::uint8_t>(row[i] + prior[i]);
+				}
+			}
+			break;
+
+			case 3:
+			{
+				for (std::size_t i = 0; i < bpp; ++i)
+				{
+					row[i] = static_cast<std::uint8_t>(row[i] + (prior[i] >> 1));
+				}
+
+				for (std::size_t i = bpp; i < size; ++i)
+				{
+					row[i] = static_cast<std::uint8_t>(row[i] + ((row[i - bpp] + prior[i]) >> 1));
+				}
+			}
+			break;
+
+			case 4:
+			{
+				for (std::size_t i = 0; i < bpp; ++i)
+				{
+					row[i] = static_cast<std::uint8_t>(row[i] + prior[i]);
+				}
+
+				for (std::size_t i = bpp; i < size; ++i)
+				{
+					row[i] = static_cast<std::uint8_t>(row[i] + PaethPredictor(row[i - bpp], prior[i], prior[i - bpp]));
+				}
+			}
+			break;
+
+			default:
+			break;
+		}
+	}
+
+#if GLIB_PNG_SSE2
+	// 3 and 4 bytes pixels carry one pixel per step through the serial filters, the Up filter is wide
+	template<std::size_t Bpp>
+	[[nodiscard]]
+	__m128i
+	LoadPixel(const std::uint8_t* p)
+	noexcept
+	{
+		std::int32_t value = 0;
+		std::memcpy(&value, p, Bpp);
+
+		return _mm_cvtsi32_si128(value);
+	}
+
+	template<std::size_t Bpp>
+	void
+	StorePixel(std::uint8_t* p, __m128i value)
+	noexcept
+	{
+		const std::int32_t result = _mm_cvtsi128_si32(value);
+		std::memcpy(p, &result, Bpp);
+	}
+
+	void
+	UnfilterUpSse2(std::uint8_t* row, const std::uint8_t* prior, std::size_t size)
+	noexcept
+	{
+		std::size_t i = 0;
+		for (; i + 16 <= size; i += 16)
+		{
+			const __m128i sum = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), sum);
+		}
+
+		for (; i < size; ++i)
+		{
+			row[i] = static_cast<std::uint8_t>(row[i] + prior[i]);
+		}
+	}
+
+	template<std::size_t Bpp>
+	void
+	UnfilterSubSse2(std::uint8_t* row, std::size_t size)
+	noexcept
+	{
+		__m128i a = _mm_setzero_si128();
+
+		for (std::size_t i = 0; i < size; i += Bpp)
+		{
+			a = _mm_add_epi8(a, LoadPixel<Bpp>(row + i));
+			StorePixel<Bpp>(row + i, a);
+		}
+	}
+
+	template<std::size_t Bpp>
+	void
+	UnfilterAverageSse2(std::uint8_t* row, const std::uint8_t* prior, std::size_t size)
+	noexcept
+	{
+		const __m128i one = _mm_set1_epi8(1);
+		__m128i a = _mm_setzero_si128();
+
+		for (std::size_t i = 0; i < size; i += Bpp)
+		{
+			const __m128i b = LoadPixel<Bpp>(prior + i);
+
+			// avg_epu8 rounds up, the filter rounds down
+			const __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+
+			a = _mm_add_epi8(LoadPixel<Bpp>(row + i), average);
+			StorePixel<Bpp>(row + i, a);
+		}
+	}
+
+	[[nodiscard]]
+	__m128i
+	Select(__m128i mask, __m128i if_true, __m128i if_false)
+	noexcept
+	{
+		return _mm_or_si128(_mm_and_si128(mask, if_true), _mm_andnot_si128(mask, if_false));
+	}
+
+	[[nodiscard]]
+	__m128i
+	Absolute16(__m128i value)
+	noexcept
+	{
+		return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+	}
+
+	template<std::size_t Bpp>
+	void
+	UnfilterPaethSse2(std::uint8_t* row, const std::uint8_t* prior, std::size_t size)
+	noexcept
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i low_bytes = _mm_set1_epi16(0xFF);
+
+		// Widened to 16 bits: a is left, b is above, c is above left
+		__m128i a = zero, c = zero;
+
+		for (std::size_t i = 0; i < size; i += Bpp)
+		{
+			const __m128i b = _mm_unpacklo_epi8(LoadPixel<Bpp>(prior + i), zero);
+			const __m128i d = _mm_unpacklo_epi8(LoadPixel<Bpp>(row + i), zero);
+
+			// p = a + b - c, so p - a = b - c, p - b = a - c and p - c is their sum
+			__m128i pa = _mm_sub_epi16(b, c);
+			__m128i pb = _mm_sub_epi16(a, c);
+			__m128i pc = _mm_add_epi16(pa, pb);
+
+			pa = Absolute16(pa);
+			pb = Absolute16(pb);
+			pc = Absolute16(pc);
+
+			const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+			// Ties favour a over b over c
+			__m128i nearest = Select(_mm_cmpeq_epi16(smallest, pb), b, c);
+			nearest = Select(_mm_cmpeq_epi16(smallest, pa), a, nearest);
+
+			a = _mm_and_si128(_mm_add_epi16(d, nearest), low_bytes);
+			c = b;
+
+			StorePixel<Bpp>(row + i, _mm_packus_epi16(a, a));
+		}
+	}
+
+	template<std::size_t Bpp>
+	void
+	UnfilterSse2(std::uint32_t filter, std::uint8_t* row, const std::uint8_t* prior, std::size_t size)
+	noexcept
+	{
+		switch (filter)
+		{
+			case 1: UnfilterSubSse2<Bpp>(row, size); break;
+			case 2: UnfilterUpSse2(row, prior, size); break;
+			case 3: UnfilterAverageSse2<Bpp>(row, prior, size); break;
+			case 4: UnfilterPaethSse2<Bpp>(row, prior, size); break;
+			default: break;
+		}
+	}
+#endif
+
+	/// <summary>
+	/// Undo the filter of one row in place. prior is the previous unfiltered row, zeros for the first one.
+	/// </summary>
+	[[nodiscard]]
+	bool
+	Unfilter(std::uint32_t filter, std::uint8_t* row, const std::uint8_t* prior, std::size_t size, std::size_t bpp)
+	noexcept
+	{
+		if (4 < filter)
+		{
+			return false;
+		}
+
+#if GLIB_PNG_SSE2
+		if (4 == bpp)
+		{
+			UnfilterSse2<4>(filter, row, prior, size);
+			return true;
+		}
+		else if (3 == bpp)
+		{
+			UnfilterSse2<3>(filter, row, prior, size);
+			return true;
+		}
+		else if (2 == filter)
+		{
+			UnfilterUpSse2(row, prior, size);
+			return true;
+		}
+#endif
+
+		UnfilterScalar(filter, row, prior, size, bpp);
+		return true;
+	}
+
+	// ---- Sample conversion
+
+	struct ImageInfo
+	{
+		gl::png::Header header{};
+
+		// RGBA, missing entries are opaque black
+		std::uint8_t palette[256][4]{};
+		std::uint32_t paletteSize = 0;
+
+		// tRNS colour key of greyscale and truecolour images, in the sample depth
+		std::uint16_t key[3]{};
+		bool hasKey = false;
+	};
+
+	[[nodiscard]]
+	constexpr std::uint32_t
+	GetSample(const std::uint8_t* row, std::size_t index, std::uint32_t depth)
+	noexcept
+	{
+		if (16 == depth)
+		{
+			return (static_cast<std::uint32_t>(row[index * 2]) << 8) | row[index * 2 + 1];
+		}
+		else if (8 == depth)
+		{
+			return row[index];
+		}
+
+		const std::size_t bit = index * depth;
+		const std::uint32_t shift = 8 - depth - static_cast<std::uint32_t>(bit & 7);
+
+		return (row[bit >> 3] >> shift) & ((1U << depth) - 1);
+	}
+
+	[[nodiscard]]
+	constexpr std::uint8_t
+	ScaleSample(std::uint32_t sample, std::uint32_t depth)
+	noexcept
+	{
+		switch (depth)
+		{
+			case 1: return static_cast<std::uint8_t>(sample * 255);
+			case 2: return static_cast<std::uint8_t>(sample * 85);
+			case 4: return static_cast<std::uint8_t>(sample * 17);
+			case 16: return static_cast<std::uint8_t>(sample >> 8);
+			default: return static_cast<std::uint8_t>(sample);
+		}
+	}
+
+	/// <summary>
+	/// Expand one unfiltered row into RGBA, dst_step is the distance in bytes between two output pixels
+	/// </summary>
+	void
+	ConvertRow(const ImageInfo& image, const std::uint8_t* row, std::size_t width, std::uint8_t* dst, std::size_t dst_step)
+	noexcept
+	{
+		const std::uint32_t depth = image.header.bitDepth;
+
+		switch (image.header.colourType)
+		{
+			case Greyscale:
+			{
+				for (std::size_t x = 0; x < width; ++x, dst += dst_step)
+				{
+					const std::uint32_t sample = GetSample(row, x, depth);
+					const std::uint8_t grey = ScaleSample(sample, depth);
+
+					dst[0] = grey;
+					dst[1] = grey;
+					dst[2] = grey;
+					dst[3] = image.hasKey && sample == image.key[0] ? 0 : 255;
+				}
+			}
+			break;
+
+			case Truecolour:
+			{
+				for (std::size_t x = 0; x < width; ++x, dst += dst_step)
+				{
+					const std::uint32_t r = GetSample(row, x * 3, depth);
+					const std::uint32_t g = GetSample(row, x * 3 + 1, depth);
+					const std::uint32_t b = GetSample(row, x * 3 + 2, depth);
+
+					dst[0] = ScaleSample(r, depth);
+					dst[1] = ScaleSample(g, depth);
+					dst[2] = ScaleSample(b, depth);
+					dst[3] = image.hasKey && r == image.key[0] && g == image.key[1] && b == image.key[2] ? 0 : 255;
+				}
+			}
+			break;
+
+			case Indexed:
+			{
+				for (std::size_t x = 0; x < width; ++x, dst += dst_step)
+				{
+					std::memcpy(dst, image.palette[GetSample(row, x, depth)], 4);
+				}
+			}
+			break;
+
+			case GreyscaleAlpha:
+			{
+				for (std::size_t x = 0; x < width; ++x, dst += dst_step)
+				{
+					const std::uint8_t grey = ScaleSample(GetSample(row, x * 2, depth), depth);
+
+					dst[0] = grey;
+					dst[1] = grey;
+					dst[2] = grey;
+					dst[3] = ScaleSample(GetSample(row, x * 2 + 1, depth), depth);
+				}
+			}
+			break;
+
+			case TruecolourAlpha:
+			{
+				if (8 == depth && 4 == dst_step)
+				{
+					std::memcpy(dst, row, width * 4);
+					break;
+				}
+
+				for (std::size_t x = 0; x < width; ++x, dst += dst_step)
+				{
+					dst[0] = ScaleSample(GetSample(row, x * 4, depth), depth);
+					dst[1] = ScaleSample(GetSample(row, x * 4 + 1, depth), depth);
+					dst[2] = ScaleSample(GetSample(row, x * 4 + 2, depth), depth);
+					dst[3] = ScaleSample(GetSample(row, x * 4 + 3, depth), depth);
+				}
+			}
+			break;
+
+			default:
+			break;
+		}
+	}
+
+	[[nodiscard]]
+	constexpr std::size_t
+	GetRowBytes(const gl::png::Header& header, std::size_t width)
+	noexcept
+	{
+		return (width * GetChannels(header.colourType) * header.bitDepth + 7) / 8;
+	}
+
+	/// <summary>
+	/// Size of the inflated image data: every row of every pass with its filter byte
+	/// </summary>
+	[[nodiscard]]
+	std::size_t
+	GetFilteredSize(const gl::png::Header& header)
+	noexcept
+	{
+		if (not header.interlaced)
+		{
+			return (GetRowBytes(header, header.width) + 1) * header.height;
+		}
+
+		std::size_t result = 0;
+		for (const auto& pass : Adam7)
+		{
+			const std::size_t width = (header.width - pass[0] + pass[2] - 1) / pass[2];
+			const std::size_t height = (header.height - pass[1] + pass[3] - 1) / pass[3];
+
+			if (pass[0] < header.width && pass[1] < header.height)
+			{
+				result += (GetRowBytes(header, width) + 1) * height;
+			}
+		}
+
+		return result;
+	}
+
+	[[nodiscard]]
+	bool
+	ReconstructPass(const ImageInfo& image, std::uint8_t*& filtered
+		, std::size_t pass_width, std::size_t pass_height
+		, std::size_t x_start, std::size_t y_start, std::size_t x_step, std::size_t y_step
+		, std::vector<std::uint8_t>& zeros, std::uint8_t* rgba)
+	noexcept
+	{
+		const gl::png::Header& header = image.header;
+		const std::size_t row_bytes = GetRowBytes(header, pass_width);
+		const std::size_t bpp = std::max<std::size_t>(1, GetChannels(header.colourType) * header.bitDepth / 8);
+
+		const std::uint8_t* prior = zeros.data();
+
+		for (std::size_t y = 0; y < pass_height; ++y)
+		{
+			const std::uint32_t filter = filtered[0];
+			std::uint8_t* const row = filtered + 1;
+
+			if (not Unfilter(filter, row, prior, row_bytes, bpp))
+			{
+				return false;
+			}
+
+			std::uint8_t* const dst = rgba + ((y_start + y * y_step) * header.width + x_start) * 4;
+			ConvertRow(image, row, pass_width, dst, x_step * 4);
+
+			prior = row;
+			filtered += row_bytes + 1;
+		}
+
+		return true;
+	}
+
+	[[nodiscard]]
+	DecodeResult
+	ParseHeader(const std::uint8_t* data, std::size_t size, gl::png::Header& header)
+	noexcept
+	{
+		if (size < sizeof(Signature) || 0 != std::memcmp(data, Signature, sizeof(Signature)))
+		{
+			return DecodeResult::NotPng;
+		}
+
+		// Signature, IHDR length and type, 13 bytes of IHDR and its crc
+		if (size < 8 + 8 + 13 + 4)
+		{
+			return DecodeResult::InvalidHeader;
+		}
+
+		const std::uint8_t* const chunk = data + 8;
+		if (13 != ReadBigEndian(chunk) || MakeChunkType("IHDR") != ReadBigEndian(chunk + 4))
+		{
+			return DecodeResult::InvalidHeader;
+		}
+
+		if (ReadBigEndian(chunk + 8 + 13) != fpng::fpng_crc32(chunk + 4, 4 + 13))
+		{
+			return DecodeResult::CorruptChunk;
+		}
+
+		const std::uint8_t* const fields = chunk + 8;
+
+		header.width = ReadBigEndian(fields);
+		header.height = ReadBigEndian(fields + 4);
+		header.bitDepth = fields[8];
+		header.colourType = fields[9];
+		header.interlaced = 1 == fields[12];
+
+		// Compression and filter methods are always zero, interlacing is none or Adam7
+		if (0 == header.width || 0 == header.height || MaxDimension < header.width || MaxDimension < header.height
+			|| MaxPixels < static_cast<std::uint64_t>(header.width) * header.height
+			|| not IsValidDepth(header.colourType, header.bitDepth)
+			|| 0 != fields[10] || 0 != fields[11] || 1 < fields[12])
+		{
+			return DecodeResult::InvalidHeader;
+		}
+
+		return DecodeResult::Success;
+	}
+}
+
+bool
+gl::png::HasPngExtension(const std::filesystem::path& path)
+noexcept
+{
+	// Looks at the native string in place, so no path is built for the extension
+	const std::filesystem::path::string_type& name = path.native();
+
+	constexpr char extension[] = ".png";
+	constexpr std::size_t length = sizeof(extension) - 1;
+
+	if (name.size() <= length)
+	{
+		return false;
+	}
+
+	// A file named only ".png" has no extension
+	const auto before = name[name.size() - length - 1];
+	if ('/' == before || '\\' == before)
+	{
+		return false;
+	}
+
+	for (std::size_t i = 0; i < length; ++i)
+	{
+		const auto c = name[name.size() - length + i];
+		const auto lower = ('A' <= c && c <= 'Z') ? c - 'A' + 'a' : c;
+
+		if (static_cast<std::filesystem::path::value_type>(extension[i]) != lower)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+gl::png::DecodeResult
+gl::png::ReadHeader(const std::uint8_t* data, std::size_t size, gl::png::Header& header)
+noexcept
+{
+	return ParseHeader(data, size, header);
+}
+
+gl::png::DecodeResult
+gl::png::Decode(const std::uint8_t* data, std::size_t size
+	, std::vector<std::uint8_t>& rgba, std::size_t& width, std::size_t& height)
+noexcept
+{
+	width = 0;
+	height = 0;
+
+	ImageInfo image{};
+	for (auto& entry : image.palette)
+	{
+		entry[3] = 255;
+	}
+	if (const DecodeResult check = ParseHeader(data, size, image.header); DecodeResult::Success != check)
+	{
+		return check;
+	}
+
+	const Header& header = image.header;
+
+	try
+	{
+		std::vector<std::uint8_t> compressed{};
+		bool has_palette = false;
+		bool has_end = false;
+
+		// Walk the chunks after IHDR
+		for (std::size_t offset = 8 + 8 + 13 + 4; not has_end && offset < size;)
+		{
+			if (size - offset < 12)
+			{
+				return DecodeResult::CorruptChunk;
+			}
+
+			const std::uint8_t* const chunk = data + offset;
+			const std::uint32_t length = ReadBigEndian(chunk);
+			const std::uint32_t type = ReadBigEndian(chunk + 4);
+
+			if (0x7FFFFFFFU < length || size - offset - 12 < length)
+			{
+				return DecodeResult::CorruptChunk;
+			}
+
+			if (ReadBigEndian(chunk + 8 + length) != fpng::fpng_crc32(chunk + 4, 4 + static_cast<std::size_t>(length)))
+			{
+				return DecodeResult::CorruptChunk;
+			}
+
+			const std::uint8_t* const payload = chunk + 8;
+			offset += 12 + static_cast<std::size_t>(length);
+
+			if (MakeChunkType("IDAT") == type)
+			{
+				compressed.insert(compressed.end(), payload, payload + length);
+			}
+			else if (MakeChunkType("PLTE") == type)
+			{
+				if (0 == length || 768 < length || 0 != length % 3)
+				{
+					return DecodeResult::CorruptChunk;
+				}
+
+				image.paletteSize = length / 3;
+				for (std::uint32_t i = 0; i < image.paletteSize; ++i)
+				{
+					image.palette[i][0] = payload[i * 3];
+					image.palette[i][1] = payload[i * 3 + 1];
+					image.palette[i][2] = payload[i * 3 + 2];
+					image.palette[i][3] = 255;
+				}
+
+				has_palette = true;
+			}
+			else if (MakeChunkType("tRNS") == type)
+			{
+				if (Indexed == header.colourType)
+				{
+					for (std::uint32_t i = 0; i < length && i < 256; ++i)
+					{
+						image.palette[i][3] = payload[i];
+					}
+				}
+				else if (Greyscale == header.colourType && 2 <= length)
+				{
+					image.key[0] = static_cast<std::uint16_t>((payload[0] << 8) | payload[1]);
+					image.hasKey = true;
+				}
+				else if (Truecolour == header.colourType && 6 <= length)
+				{
+					image.key[0] = static_cast<std::uint16_t>((payload[0] << 8) | payload[1]);
+					image.key[1] = static_cast<std::uint16_t>((payload[2] << 8) | payload[3]);
+					image.key[2] = static_cast<std::uint16_t>((payload[4] << 8) | payload[5]);
+					image.hasKey = true;
+				}
+			}
+			else if (MakeChunkType("IEND") == type)
+			{
+				has_end = true;
+			}
+			else if (0 == (chunk[4] & 0x20))
+			{
+				// Bit 5 of the first letter clear marks a critical chunk
+				return DecodeResult::UnsupportedChunk;
+			}
+		}
+
+		if (compressed.empty() || (Indexed == header.colourType && not has_palette))
+		{
+			return DecodeResult::CorruptChunk;
+		}
+
+		std::vector<std::uint8_t> filtered(GetFilteredSize(header));
+
+		Inflater inflater{ compressed.data(), compressed.size(), filtered.data(), filtered.size() };
+		if (not inflater.Run())
+		{
+			return DecodeResult::CorruptData;
+		}
+
+		rgba.resize(static_cast<std::size_t>(header.width) * header.height * 4);
+
+		std::vector<std::uint8_t> zeros(GetRowBytes(header, header.width));
+		std::uint8_t* cursor = filtered.data();
+
+		if (not header.interlaced)
+		{
+			if (not ReconstructPass(image, cursor, header.width, header.height, 0, 0, 1, 1, zeros, rgba.data()))
+			{
+				return DecodeResult::CorruptData;
+			}
+		}
+		else
+		{
+			for (const auto& pass : Adam7)
+			{
+				if (header.width <= pass[0] || header.height <= pass[1])
+				{
+					continue;
+				}
+
+				const std::size_t pass_width = (header.width - pass[0] + pass[2] - 1) / pass[2];
+				const std::size_t pass_height = (header.height - pass[1] + pass[3] - 1) / pass[3];
+
+				if (not ReconstructPass(image, cursor, pass_width, pass_height, pass[0], pass[1], pass[2], pass[3], zeros, rgba.data()))
+				{
+					return DecodeResult::CorruptData;
+				}
+			}
+		}
+	}
+	catch (const std::bad_alloc&)
+	{
+		return DecodeResult::OutOfMemory;
+	}
+
+	width = header.width;
+	height = header.height;
+
+	return DecodeResult::Success;
+}
+
+double
+gl::png::MeasureDecoding(const std::uint8_t* data, std::size_t size, std::uint32_t iterations)
+{
+	using clock = std::chrono::steady_clock;
+
+	fpng::fpng_init();
+
+	iterations = std::max(1U, iterations);
+
+	std::vector<std::uint8_t> rgba{};
+	std::size_t width = 0, height = 0;
+
+	const auto begin = clock::now();
+	for (std::uint32_t i = 0; i < iterations; ++i)
+	{
+		if (DecodeResult::Success != Decode(data, size, rgba, width, height))
+		{
+			return 0;
+		}
+	}
+	const std::chrono::duration<double> time = clock::now() - begin;
+
+	const double megabytes = static_cast<double>(rgba.size()) * iterations / (1024.0 * 1024.0);
+
+	return megabytes / std::max(time.count(), 1e-9);
+}
@@ -0,0 +1,438 @@
+module;
+#define NOMINMAX
+#include <Windows.h>
+#include "glew.h"
+#include <gl\gl.h>
+module Glib.Profiler;
+import <algorithm>;
+import <utility>;
+
+namespace
+{
+	class OpenGLBackend final : public gl::profiler::Backend
+	{
+	public:
+		void
+		CreateQueries(std::span<std::uint32_t> queries)
+		noexcept override
+		{
+			::glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+		}
+
+		void
+		DeleteQueries(std::span<const std::uint32_t> queries)
+		noexcept override
+		{
+			::glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+		}
+
+		void
+		WriteTimestamp(std::uint32_t query)
+		noexcept override
+		{
+			::glQueryCounter(query, GL_TIMESTAMP);
+		}
+
+		[[nodiscard]]
+		bool
+		IsAvailable(std::uint32_t query)
+		noexcept override
+		{
+			GLint available = GL_FALSE;
+			::glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, std::addressof(available));
+
+			return GL_FALSE != available;
+		}
+
+		[[nodiscard]]
+		std::uint64_t
+		GetTimestamp(std::uint32_t query)
+		noexcept override
+		{
+			GLuint64 result = 0;
+			::glGetQueryObjectui64v(query, GL_QUERY_RESULT, std::addressof(result));
+
+			return result;
+		}
+
+		[[nodiscard]]
+		std::uint64_t
+		GetCurrentTimestamp()
+		noexcept override
+		{
+			// Returns once the commands before reach the GPU, without waiting for them to run
+			GLint64 result = 0;
+			::glGetInteger64v(GL_TIMESTAMP, std::addressof(result));
+
+			return static_cast<std::uint64_t>(result);
+		}
+	};
+
+	[[nodiscard]]
+	std::int64_t
+	ToNanoseconds(gl::GpuProfiler::clock::duration duration)
+	noexcept
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+	}
+
+	[[nodiscard]]
+	constexpr std::uint32_t
+	GetQueriesPerFrame(std::uint32_t max_scopes)
+	noexcept
+	{
+		return 2 + 2 * max_scopes;
+	}
+}
+
+gl::profiler::Backend&
+gl::profiler::GetBackend()
+noexcept
+{
+	static OpenGLBackend backend{};
+
+	return backend;
+}
+
+gl::profiler::Scope::Scope(gl::GpuProfiler& profiler, std::string_view name)
+noexcept
+	: myProfiler(profiler), myId(profiler.BeginScope(name))
+{}
+
+gl::profiler::Scope::~Scope()
+noexcept
+{
+	myProfiler.EndScope(myId);
+}
+
+gl::GpuProfiler::GpuProfiler(gl::profiler::Backend& backend, std::uint32_t latency, std::uint32_t max_scopes)
+	: myBackend(std::addressof(backend))
+	, myMaxScopes(max_scopes)
+	, mySlots(std::max(1U, latency))
+{
+	const std::uint32_t queries_per_frame = GetQueriesPerFrame(myMaxScopes);
+
+	// Everything a frame writes is allocated here, the scopes only fill it in
+	for (std::uint32_t i = 0; i < mySlots.size(); ++i)
+	{
+		mySlots[i].firstQuery = i * queries_per_frame;
+		mySlots[i].scopes.resize(myMaxScopes);
+
+		for (PendingScope& scope : mySlots[i].scopes)
+		{
+			scope.name.reserve(profiler::MaxScopeName);
+		}
+	}
+
+	myQueries.resize(mySlots.size() * queries_per_frame);
+	myLatest.scopes.reserve(myMaxScopes);
+}
+
+gl::GpuProfiler::~GpuProfiler()
+noexcept
+{
+	Release();
+}
+
+void
+gl::GpuProfiler::BeginFrame()
+{
+	if (hasQueries)
+	{
+		Resolve();
+	}
+
+	if (not isEnabled)
+	{
+		return;
+	}
+
+	if (not hasQueries)
+	{
+		myBackend->CreateQueries(myQueries);
+		hasQueries = true;
+		isCalibrated = false;
+	}
+
+	if (not isCalibrated)
+	{
+		const std::int64_t gpu_now = static_cast<std::int64_t>(myBackend->GetCurrentTimestamp());
+		myClockOffset = gpu_now - ToNanoseconds(clock::now().time_since_epoch());
+		isCalibrated = true;
+	}
+
+	++myStatistics.frames;
+
+	const std::size_t index = myFrame++ % mySlots.size();
+	Slot& slot = mySlots[index];
+
+	// The GPU is still behind by the whole ring, reading the slot now would stall
+	if (slot.isPending)
+	{
+		++myStatistics.skippedFrames;
+		isMeasuring = false;
+		return;
+	}
+
+	slot.frame = myFrame - 1;
+	slot.scopeCount = 0;
+	slot.cpuBegin = clock::now();
+	slot.gpuReference = ToNanoseconds(slot.cpuBegin.time_since_epoch()) + myClockOffset;
+
+	myBackend->WriteTimestamp(myQueries[slot.firstQuery]);
+	++myStatistics.queries;
+
+	myCurrent = index;
+	myOpenScope = profiler::InvalidScope;
+	isMeasuring = true;
+}
+
+void
+gl::GpuProfiler::EndFrame()
+noexcept
+{
+	if (not isMeasuring)
+	{
+		return;
+	}
+
+	Slot& slot = mySlots[myCurrent];
+
+	while (profiler::InvalidScope != myOpenScope)
+	{
+		EndScope(myOpenScope);
+	}
+
+	myBackend->WriteTimestamp(myQueries[slot.firstQuery + 1]);
+	++myStatistics.queries;
+
+	slot.cpuEnd = clock::now();
+	slot.isPending = true;
+	isMeasuring = false;
+}
+
+gl::profiler::ScopeId
+gl::GpuProfiler::BeginScope(std::string_view name)
+noexcept
+{
+	if (not isMeasuring)
+	{
+		return profiler::InvalidScope;
+	}
+
+	Slot& slot = mySlots[myCurrent];
+	if (myMaxScopes <= slot.scopeCount)
+	{
+		++myStatistics.droppedScopes;
+		return profiler::InvalidScope;
+	}
+
+	const profiler::ScopeId id = slot.scopeCount++;
+
+	PendingScope& scope = slot.scopes[id];
+	scope.name.assign(name.substr(0, profiler::MaxScopeName));
+	scope.parent = myOpenScope;
+	scope.depth = profiler::InvalidScope == myOpenScope ? 0 : slot.scopes[myOpenScope].depth + 1;
+	scope.isOpen = true;
+	scope.cpuBegin = clock::now();
+
+	myBackend->WriteTimestamp(myQueries[slot.firstQuery + 2 + 2 * id]);
+	++myStatistics.queries;
+
+	myOpenScope = id;
+
+	return id;
+}
+
+void
+gl::GpuProfiler::EndScope(gl::profiler::ScopeId scope)
+noexcept
+{
+	if (not isMeasuring)
+	{
+		return;
+	}
+
+	Slot& slot = mySlots[myCurrent];
+	if (slot.scopeCount <= scope || not slot.scopes[scope].isOpen)
+	{
+		return;
+	}
+
+	// The scopes nested in it and left open end with it
+	while (slot.scopes[scope].isOpen)
+	{
+		PendingScope& inner = slot.scopes[myOpenScope];
+
+		myBackend->WriteTimestamp(myQueries[slot.firstQuery + 3 + 2 * myOpenScope]);
+		++myStatistics.queries;
+
+		inner.cpuEnd = clock::now();
+		inner.isOpen = false;
+		myOpenScope = inner.parent;
+	}
+}
+
+std::size_t
+gl::GpuProfiler::Resolve()
+{
+	std::size_t result = 0;
+
+	// In the order of the frames, so the latest one is always the newest
+	while (true)
+	{
+		Slot* oldest = nullptr;
+
+		for (Slot& slot : mySlots)
+		{
+			if (slot.isPending && (nullptr == oldest || slot.frame < oldest->frame))
+			{
+				oldest = std::addressof(slot);
+			}
+		}
+
+		if (nullptr == oldest || not IsReady(*oldest))
+		{
+			break;
+		}
+
+		ResolveSlot(*oldest);
+		++result;
+	}
+
+	return result;
+}
+
+void
+gl::GpuProfiler::Release()
+noexcept
+{
+	if (hasQueries)
+	{
+		myBackend->DeleteQueries(myQueries);
+		hasQueries = false;
+	}
+
+	for (Slot& slot : mySlots)
+	{
+		slot.isPending = false;
+	}
+
+	isMeasuring = false;
+	myOpenScope = profiler::InvalidScope;
+}
+
+void
+gl::GpuProfiler::SetEnabled(bool flag)
+noexcept
+{
+	isEnabled = flag;
+}
+
+void
+gl::GpuProfiler::Calibrate()
+noexcept
+{
+	isCalibrated = false;
+}
+
+bool
+gl::GpuProfiler::IsEnabled()
+const noexcept
+{
+	return isEnabled;
+}
+
+const gl::profiler::FrameTimeline*
+gl::GpuProfiler::GetLatest()
+const noexcept
+{
+	return hasLatest ? std::addressof(myLatest) : nullptr;
+}
+
+const gl::profiler::Statistics&
+gl::GpuProfiler::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+std::uint64_t
+gl::GpuProfiler::GetFrame()
+const noexcept
+{
+	return myFrame;
+}
+
+bool
+gl::GpuProfiler::IsReady(const gl::GpuProfiler::Slot& slot)
+const noexcept
+{
+	// The end of the frame is written last, so it is the first one to check
+	if (not myBackend->IsAvailable(myQueries[slot.firstQuery + 1]))
+	{
+		return false;
+	}
+
+	const std::uint32_t count = GetQueriesPerFrame(slot.scopeCount);
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		if (not myBackend->IsAvailable(myQueries[slot.firstQuery + i]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void
+gl::GpuProfiler::ResolveSlot(gl::GpuProfiler::Slot& slot)
+{
+	myLatest.frame = slot.frame;
+	myLatest.latency = static_cast<std::uint32_t>(myFrame - slot.frame);
+	myLatest.cpuEnd = ToNanoseconds(slot.cpuEnd - slot.cpuBegin);
+	myLatest.gpuBegin = ReadGpuTime(slot, 0);
+	myLatest.gpuEnd = ReadGpuTime(slot, 1);
+	myLatest.scopes.resize(slot.scopeCount);
+
+	for (std::uint32_t i = 0; i < slot.scopeCount; ++i)
+	{
+		const PendingScope& scope = slot.scopes[i];
+		profiler::ScopeTiming& timing = myLatest.scopes[i];
+
+		timing.name.assign(scope.name);
+		timing.depth = scope.depth;
+		timing.parent = scope.parent;
+		timing.cpuBegin = ToNanoseconds(scope.cpuBegin - slot.cpuBegin);
+		timing.cpuEnd = ToNanoseconds(scope.cpuEnd - slot.cpuBegin);
+		timing.gpuBegin = ReadGpuTime(slot, 2 + 2 * i);
+		timing.gpuEnd = ReadGpuTime(slot, 3 + 2 * i);
+	}
+
+	slot.isPending = false;
+	hasLatest = true;
+
+	const double count = static_cast<double>(++myStatistics.resolvedFrames);
+	const double cpu_time = static_cast<double>(myLatest.GetCpuTime()) * 1e-6;
+	const double gpu_time = static_cast<double>(myLatest.GetGpuTime()) * 1e-6;
+
+	myStatistics.averageCpuTime += (cpu_time - myStatistics.averageCpuTime) / count;
+	myStatistics.averageGpuTime += (gpu_time - myStatistics.averageGpuTime) / count;
+
+	if (profiler::Bound::Gpu == myLatest.GetBound())
+	{
+		++myStatistics.gpuBoundFrames;
+	}
+	else
+	{
+		++myStatistics.cpuBoundFrames;
+	}
+}
+
+std::int64_t
+gl::GpuProfiler::ReadGpuTime(const gl::GpuProfiler::Slot& slot, std::uint32_t query)
+const noexcept
+{
+	return static_cast<std::int64_t>(myBackend->GetTimestamp(myQueries[slot.firstQuery + query])) - slot.gpuReference;
+}
@@ -0,0 +1,1059 @@
+module;
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define GLIB_RASTER_SSE2 1
+#else
+#define GLIB_RASTER_SSE2 0
+#endif
+
+module Glib.Rasterizer;
+import <cmath>;
+import <cstring>;
+import <algorithm>;
+import <chrono>;
+import <random>;
+import <stdexcept>;
+import <tuple>;
+import Glib.Parallel;
+import Glib.VertexPacking;
+
+namespace
+{
+	// 28.4 fixed point
+	constexpr std::int32_t SubpixelBits = 4;
+	constexpr std::int32_t SubpixelOne = 1 << SubpixelBits;
+	constexpr std::int32_t SubpixelHalf = SubpixelOne / 2;
+
+	// Coverage is tested by 8x8 blocks inside the tiles
+	constexpr std::int32_t BlockSize = 8;
+	constexpr std::int32_t BlockSpan = (BlockSize - 1) * SubpixelOne;
+
+	// Clipped screen coordinates stay within this many pixels of the origin
+	constexpr float GuardBand = 16384.0f;
+
+	struct ClipVertex
+	{
+		float position[4];
+		float colour[4];
+	};
+
+	[[nodiscard]]
+	constexpr std::size_t
+	GetTypeSize(int type)
+	noexcept
+	{
+		switch (type)
+		{
+			case 0x1400: // GL_BYTE
+			case 0x1401: // GL_UNSIGNED_BYTE
+			return 1;
+
+			case 0x1402: // GL_SHORT
+			case 0x1403: // GL_UNSIGNED_SHORT
+			case 0x140B: // GL_HALF_FLOAT
+			return 2;
+
+			case 0x1404: // GL_INT
+			case 0x1405: // GL_UNSIGNED_INT
+			case 0x1406: // GL_FLOAT
+			return 4;
+
+			case 0x140A: // GL_DOUBLE
+			return 8;
+
+			// The whole element
+			case 0x8D9F: // GL_INT_2_10_10_10_REV
+			case 0x8368: // GL_UNSIGNED_INT_2_10_10_10_REV
+			return 4;
+
+			default:
+			return 0;
+		}
+	}
+
+	// Four components of 10, 10, 10 and 2 bits in one value, opengl only takes them with a count of 4
+	[[nodiscard]]
+	constexpr bool
+	IsPackedType(int type)
+	noexcept
+	{
+		return 0x8D9F == type || 0x8368 == type;
+	}
+
+	template<typename T>
+	[[nodiscard]]
+	T
+	LoadUnaligned(const std::byte* data)
+	noexcept
+	{
+		T result;
+		std::memcpy(&result, data, sizeof(T));
+
+		return result;
+	}
+
+	[[nodiscard]]
+	float
+	ReadComponent(const std::byte* data, int type, bool normalized)
+	noexcept
+	{
+		switch (type)
+		{
+			case 0x1400:
+			{
+				const float value = LoadUnaligned<std::int8_t>(data);
+				return normalized ? std::max(value / 127.0f, -1.0f) : value;
+			}
+
+			case 0x1401:
+			{
+				const float value = LoadUnaligned<std::uint8_t>(data);
+				return normalized ? value / 255.0f : value;
+			}
+
+			case 0x1402:
+			{
+				const float value = LoadUnaligned<std::int16_t>(data);
+				return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+			}
+
+			case 0x1403:
+			{
+				const float value = LoadUnaligned<std::uint16_t>(data);
+				return normalized ? value / 65535.0f : value;
+			}
+
+			case 0x1404:
+			{
+				const double value = LoadUnaligned<std::int32_t>(data);
+				return static_cast<float>(normalized ? std::max(value / 2147483647.0, -1.0) : value);
+			}
+
+			case 0x1405:
+			{
+				const double value = LoadUnaligned<std::uint32_t>(data);
+				return static_cast<float>(normalized ? value / 4294967295.0 : value);
+			}
+
+			case 0x1406:
+			{
+				return LoadUnaligned<float>(data);
+			}
+
+			case 0x140A:
+			{
+				return static_cast<float>(LoadUnaligned<double>(data));
+			}
+
+			case 0x140B:
+			{
+				return gl::vertex::FromHalf(LoadUnaligned<gl::vertex::Half>(data));
+			}
+
+			default:
+			{
+				return 0;
+			}
+		}
+	}
+
+	// Normalized as opengl 4.2 does it, the unnormalized components are the plain integers
+	void
+	ReadPacked(const std::byte* data, int type, bool normalized, float(&output)[4])
+	noexcept
+	{
+		const std::uint32_t bits = LoadUnaligned<std::uint32_t>(data);
+
+		std::array<float, 4> components;
+		if (0x8368 == type)
+		{
+			components = normalized ? gl::vertex::Unpack(gl::vertex::PackedUnorm{ bits })
+				: std::array<float, 4>{ float(bits & 0x3FF), float(bits >> 10 & 0x3FF), float(bits >> 20 & 0x3FF), float(bits >> 30) };
+		}
+		else if (normalized)
+		{
+			components = gl::vertex::Unpack(gl::vertex::PackedSnorm{ bits });
+		}
+		else
+		{
+			// Sign extended from the top of the value
+			components = {
+				float(static_cast<std::int32_t>(bits << 22) >> 22),
+				float(static_cast<std::int32_t>(bits << 12) >> 22),
+				float(static_cast<std::int32_t>(bits << 2) >> 22),
+				float(static_cast<std::int32_t>(bits) >> 30)
+			};
+		}
+
+		std::copy(components.begin(), components.end(), output);
+	}
+
+	/// <summary>
+	/// Where an element of a layout lives in the vertex bytes
+	/// </summary>
+	struct ElementReader
+	{
+		std::ptrdiff_t offset = 0;
+		std::size_t stride = 0;
+		std::size_t size = 0;
+		int count = 0;
+		int type = 0;
+		bool normalized = false;
+
+		[[nodiscard]]
+		static ElementReader
+		From(const gl::BufferLayout::element_t& element)
+		noexcept
+		{
+			ElementReader result{};
+			result.count = std::get<0>(element);
+			result.type = std::get<1>(element);
+			result.offset = std::get<3>(element);
+			result.normalized = std::get<4>(element);
+
+			if (IsPackedType(result.type))
+			{
+				// Any other count is refused by the size
+				result.size = 4 == result.count ? GetTypeSize(result.type) : 0;
+			}
+			else
+			{
+				result.size = GetTypeSize(result.type) * static_cast<std::size_t>(std::max(result.count, 0));
+			}
+
+			// Zero stride means tightly packed, as in opengl
+			const int stride = std::get<2>(element);
+			result.stride = 0 < stride ? static_cast<std::size_t>(stride) : result.size;
+
+			return result;
+		}
+
+		[[nodiscard]]
+		std::size_t
+		GetVertexCount(std::size_t bytes)
+		const noexcept
+		{
+			if (0 == size || 0 == stride || offset < 0 || bytes < static_cast<std::size_t>(offset) + size)
+			{
+				return 0;
+			}
+
+			return (bytes - static_cast<std::size_t>(offset) - size) / stride + 1;
+		}
+
+		void
+		Read(const std::byte* vertices, std::size_t index, float(&output)[4])
+		const noexcept
+		{
+			const std::byte* const data = vertices + offset + index * stride;
+
+			if (IsPackedType(type))
+			{
+				ReadPacked(data, type, normalized, output);
+				return;
+			}
+
+			const std::size_t component = GetTypeSize(type);
+
+			for (int i = 0; i < count && i < 4; ++i)
+			{
+				output[i] = ReadComponent(data + i * component, type, normalized);
+			}
+		}
+	};
+
+	// Inside when the dot product with the plane isn't negative
+	[[nodiscard]]
+	float
+	PlaneDistance(const ClipVertex& vertex, std::uint32_t plane, float guard_x, float guard_y)
+	noexcept
+	{
+		const float* const p = vertex.position;
+
+		switch (plane)
+		{
+			case 0: return p[2] + p[3];
+			case 1: return p[3] - p[2];
+			case 2: return p[0] + guard_x * p[3];
+			case 3: return guard_x * p[3] - p[0];
+			case 4: return p[1] + guard_y * p[3];
+			default: return guard_y * p[3] - p[1];
+		}
+	}
+
+	[[nodiscard]]
+	ClipVertex
+	Lerp(const ClipVertex& a, const ClipVertex& b, float t)
+	noexcept
+	{
+		ClipVertex result;
+		for (int i = 0; i < 4; ++i)
+		{
+			result.position[i] = a.position[i] + (b.position[i] - a.position[i]) * t;
+			result.colour[i] = a.colour[i] + (b.colour[i] - a.colour[i]) * t;
+		}
+
+		return result;
+	}
+
+	/// <summary>
+	/// Clip a triangle against the near, far and guard band planes, the result is a convex polygon
+	/// </summary>
+	[[nodiscard]]
+	std::uint32_t
+	ClipTriangle(const ClipVertex(&triangle)[3], ClipVertex(&polygon)[9], float guard_x, float guard_y)
+	noexcept
+	{
+		std::uint32_t outside_all = 0x3F, outside_any = 0;
+		for (const ClipVertex& vertex : triangle)
+		{
+			std::uint32_t code = 0;
+			for (std::uint32_t plane = 0; plane < 6; ++plane)
+			{
+				if (PlaneDistance(vertex, plane, guard_x, guard_y) < 0)
+				{
+					code |= 1U << plane;
+				}
+			}
+
+			outside_all &= code;
+			outside_any |= code;
+		}
+
+		if (0 != outside_all)
+		{
+			return 0;
+		}
+
+		polygon[0] = triangle[0];
+		polygon[1] = triangle[1];
+		polygon[2] = triangle[2];
+
+		if (0 == outside_any)
+		{
+			return 3;
+		}
+
+		std::uint32_t count = 3;
+		ClipVertex buffer[9];
+
+		for (std::uint32_t plane = 0; plane < 6 && 0 < count; ++plane)
+		{
+			if (0 == (outside_any & (1U << plane)))
+			{
+				continue;
+			}
+
+			std::uint32_t clipped = 0;
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				const ClipVertex& current = polygon[i];
+				const ClipVertex& next = polygon[(i + 1) % count];
+
+				const float d0 = PlaneDistance(current, plane, guard_x, guard_y);
+				const float d1 = PlaneDistance(next, plane, guard_x, guard_y);
+
+				if (0 <= d0)
+				{
+					buffer[clipped++] = current;
+				}
+
+				if ((0 <= d0) != (0 <= d1))
+				{
+					buffer[clipped++] = Lerp(current, next, d0 / (d0 - d1));
+				}
+			}
+
+			count = clipped;
+			std::copy_n(buffer, count, polygon);
+		}
+
+		return count;
+	}
+
+	[[nodiscard]]
+	bool
+	Compare(gl::Comparator comparator, float incoming, float stored)
+	noexcept
+	{
+		switch (comparator)
+		{
+			case gl::Comparator::Never: return false;
+			case gl::Comparator::Equal: return incoming == stored;
+			case gl::Comparator::NotEqual: return incoming != stored;
+			case gl::Comparator::Less: return incoming < stored;
+			case gl::Comparator::LessOrEqual: return incoming <= stored;
+			case gl::Comparator::Greater: return incoming > stored;
+			case gl::Comparator::GreaterOrEqual: return incoming >= stored;
+			default: return true;
+		}
+	}
+
+	[[nodiscard]]
+	float
+	GetBlendFactor(gl::BlendOption option, const float(&src)[4], const float(&dst)[4], int channel)
+	noexcept
+	{
+		switch (option)
+		{
+			case gl::BlendOption::Zero: return 0;
+			case gl::BlendOption::One: return 1;
+			case gl::BlendOption::SourceColour: return src[channel];
+			case gl::BlendOption::InvertedSrcColour: return 1 - src[channel];
+			case gl::BlendOption::SourceAlpha: return src[3];
+			case gl::BlendOption::InvertedSrcAlpha: return 1 - src[3];
+			case gl::BlendOption::DestColour: return dst[channel];
+			case gl::BlendOption::InvertedDstColour: return 1 - dst[channel];
+			case gl::BlendOption::DestAlpha: return dst[3];
+			case gl::BlendOption::InvertedDstAlpha: return 1 - dst[3];
+			case gl::BlendOption::SaturateSourceAlpha: return 3 == channel ? 1 : std::min(src[3], 1 - dst[3]);
+			default: return 0;
+		}
+	}
+
+	[[nodiscard]]
+	std::uint8_t
+	ToByte(float value)
+	noexcept
+	{
+		return static_cast<std::uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	[[nodiscard]]
+	constexpr std::int32_t
+	FloorDivide(std::int32_t value, std::int32_t divisor)
+	noexcept
+	{
+		return (value >= 0 ? value : value - divisor + 1) / divisor;
+	}
+}
+
+gl::SoftwareRasterizer::SoftwareRasterizer(std::uint32_t width, std::uint32_t height, std::uint32_t threads)
+	: myWidth(width), myHeight(height)
+	, myThreads(GetWorkerCount(threads))
+	, tilesX((width + raster::TileSize - 1) / raster::TileSize)
+	, tilesY((height + raster::TileSize - 1) / raster::TileSize)
+{
+	if (0 == width || 0 == height || raster::MaxDimension < width || raster::MaxDimension < height)
+	{
+		throw std::invalid_argument{ "Invalid framebuffer size" };
+	}
+
+	myPixels.resize(static_cast<std::size_t>(width) * height, ScreenPixel{ Colour{ 0.0f, 0.0f, 0.0f, 1.0f }, 1.0f });
+
+	// Identity
+	myTransform = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+}
+
+gl::SoftwareRasterizer::~SoftwareRasterizer()
+noexcept
+{}
+
+void
+gl::SoftwareRasterizer::Clear(const gl::Colour& colour, float depth)
+noexcept
+{
+	std::fill(myPixels.begin(), myPixels.end(), ScreenPixel{ colour, depth });
+
+	myBatches.clear();
+	myStatistics = {};
+}
+
+void
+gl::SoftwareRasterizer::SetTransform(const float(&matrix)[16])
+noexcept
+{
+	std::copy_n(matrix, 16, myTransform.begin());
+}
+
+void
+gl::SoftwareRasterizer::SetState(const gl::raster::DrawState& state)
+noexcept
+{
+	myState = state;
+}
+
+bool
+gl::SoftwareRasterizer::Draw(const gl::raster::VertexInput& input)
+{
+	if (nullptr == input.layout || input.layout->GetElements().size() <= input.positionElement)
+	{
+		return false;
+	}
+
+	const auto& elements = input.layout->GetElements();
+
+	const ElementReader position = ElementReader::From(elements[input.positionElement]);
+	if (position.count < 2 || 4 < position.count || 0 == position.size)
+	{
+		return false;
+	}
+
+	const bool has_colour = 0 <= input.colourElement && static_cast<std::size_t>(input.colourElement) < elements.size();
+
+	ElementReader colour{};
+	std::size_t vertex_count = position.GetVertexCount(input.vertices.size());
+
+	if (has_colour)
+	{
+		colour = ElementReader::From(elements[static_cast<std::size_t>(input.colourElement)]);
+		if (colour.count < 3 || 4 < colour.count || 0 == colour.size)
+		{
+			return false;
+		}
+
+		vertex_count = std::min(vertex_count, colour.GetVertexCount(input.vertices.size()));
+	}
+
+	const std::size_t triangle_count = (input.indices.empty() ? vertex_count : input.indices.size()) / 3;
+	if (0 == triangle_count)
+	{
+		return true;
+	}
+
+	const float default_colour[4] =
+	{
+		myState.colour.R / 255.0f, myState.colour.G / 255.0f, myState.colour.B / 255.0f, myState.colour.A / 255.0f
+	};
+
+	// The guard band keeps the clipped screen coordinates inside the fixed point range
+	const float guard_x = std::max(1.0f, GuardBand / static_cast<float>(myWidth) - 1.0f);
+	const float guard_y = std::max(1.0f, GuardBand / static_cast<float>(myHeight) - 1.0f);
+
+	const float width = static_cast<float>(myWidth);
+	const float height = static_cast<float>(myHeight);
+	const std::array<float, 16>& m = myTransform;
+
+	Batch& batch = myBatches.emplace_back();
+	batch.state = myState;
+	batch.bins.resize(myThreads);
+
+	std::vector<raster::Statistics> statistics(myThreads);
+
+	const auto fetch = [&](std::size_t index, ClipVertex& vertex) noexcept {
+		float p[4] = { 0, 0, 0, 1 };
+		position.Read(input.vertices.data(), index, p);
+
+		for (int row = 0; row < 4; ++row)
+		{
+			vertex.position[row] = m[row] * p[0] + m[4 + row] * p[1] + m[8 + row] * p[2] + m[12 + row] * p[3];
+		}
+
+		std::copy_n(default_colour, 4, vertex.colour);
+		if (has_colour)
+		{
+			float c[4] = { 0, 0, 0, 1 };
+			colour.Read(input.vertices.data(), index, c);
+			std::copy_n(c, 4, vertex.colour);
+		}
+	};
+
+	const raster::DrawState& state = batch.state;
+
+	ParallelFor(myThreads, myThreads, [&](std::uint32_t chunk, std::uint32_t worker) {
+		raster::Statistics& stats = statistics[worker];
+
+		Bin& bin = batch.bins[chunk];
+		bin.tiles.resize(static_cast<std::size_t>(tilesX) * tilesY);
+
+		const std::size_t first = triangle_count * chunk / myThreads;
+		const std::size_t last = triangle_count * (chunk + 1) / myThreads;
+
+		for (std::size_t t = first; t < last; ++t)
+		{
+			++stats.submittedTriangles;
+
+			ClipVertex corners[3];
+			bool valid = true;
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				const std::size_t index = input.indices.empty() ? t * 3 + k : input.indices[t * 3 + k];
+				if (vertex_count <= index)
+				{
+					valid = false;
+					break;
+				}
+
+				fetch(index, corners[k]);
+			}
+
+			if (not valid)
+			{
+				continue;
+			}
+
+			ClipVertex polygon[9];
+			const std::uint32_t count = ClipTriangle(corners, polygon, guard_x, guard_y);
+			if (count < 3)
+			{
+				++stats.clippedTriangles;
+				continue;
+			}
+
+			// Fan out the clipped polygon
+			for (std::uint32_t k = 1; k + 1 < count; ++k)
+			{
+				const ClipVertex* const source[3] = { polygon, polygon + k, polygon + k + 1 };
+
+				float sx[3], sy[3], sz[3], inv_w[3];
+				Triangle tri{};
+				bool degenerate = false;
+
+				for (int v = 0; v < 3; ++v)
+				{
+					const float w = source[v]->position[3];
+					if (not (0 < w))
+					{
+						degenerate = true;
+						break;
+					}
+
+					inv_w[v] = 1 / w;
+					sx[v] = (source[v]->position[0] * inv_w[v] + 1) * 0.5f * width;
+					sy[v] = (1 - source[v]->position[1] * inv_w[v]) * 0.5f * height;
+					sz[v] = source[v]->position[2] * inv_w[v] * 0.5f + 0.5f;
+
+					tri.x[v] = static_cast<std::int32_t>(std::lround(sx[v] * SubpixelOne));
+					tri.y[v] = static_cast<std::int32_t>(std::lround(sy[v] * SubpixelOne));
+				}
+
+				if (degenerate)
+				{
+					++stats.clippedTriangles;
+					continue;
+				}
+
+				std::int64_t area = static_cast<std::int64_t>(tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - static_cast<std::int64_t>(tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+				if (0 == area)
+				{
+					++stats.culledTriangles;
+					continue;
+				}
+
+				// Rows go down, so counter clockwise triangles in normalized device coordinates have a negative area
+				const bool front_facing = (area < 0) != state.clockwise;
+				if (state.culling)
+				{
+					const bool culled = Face::FrontAndBack == state.cullFace
+						|| (Face::Back == state.cullFace && not front_facing)
+						|| (Face::Front == state.cullFace && front_facing);
+
+					if (culled)
+					{
+						++stats.culledTriangles;
+						continue;
+					}
+				}
+
+				int order[3] = { 0, 1, 2 };
+				if (area < 0)
+				{
+					std::swap(order[1], order[2]);
+					std::swap(tri.x[1], tri.x[2]);
+					std::swap(tri.y[1], tri.y[2]);
+					area = -area;
+				}
+
+				for (int e = 0; e < 3; ++e)
+				{
+					const int n = (e + 1) % 3;
+
+					tri.stepX[e] = tri.y[e] - tri.y[n];
+					tri.stepY[e] = tri.x[n] - tri.x[e];
+
+					// Shared edges run in opposite directions, so exactly one of the two triangles owns them
+					const bool owner = 0 < tri.stepX[e] || (0 == tri.stepX[e] && 0 < tri.stepY[e]);
+					tri.bias[e] = owner ? 0 : -1;
+				}
+
+				const std::int32_t min_x = std::min({ tri.x[0], tri.x[1], tri.x[2] });
+				const std::int32_t max_x = std::max({ tri.x[0], tri.x[1], tri.x[2] });
+				const std::int32_t min_y = std::min({ tri.y[0], tri.y[1], tri.y[2] });
+				const std::int32_t max_y = std::max({ tri.y[0], tri.y[1], tri.y[2] });
+
+				// Pixels whose centre lies within the bounds
+				tri.minX = std::max(0, FloorDivide(min_x - SubpixelHalf + SubpixelOne - 1, SubpixelOne));
+				tri.maxX = std::min(static_cast<std::int32_t>(myWidth) - 1, FloorDivide(max_x - SubpixelHalf, SubpixelOne));
+				tri.minY = std::max(0, FloorDivide(min_y - SubpixelHalf + SubpixelOne - 1, SubpixelOne));
+				tri.maxY = std::min(static_cast<std::int32_t>(myHeight) - 1, FloorDivide(max_y - SubpixelHalf, SubpixelOne));
+
+				if (tri.maxX < tri.minX || tri.maxY < tri.minY)
+				{
+					++stats.culledTriangles;
+					continue;
+				}
+
+				// Attribute planes over the snapped vertices
+				const float x0 = tri.x[0] / static_cast<float>(SubpixelOne), y0 = tri.y[0] / static_cast<float>(SubpixelOne);
+				const float dx1 = tri.x[1] / static_cast<float>(SubpixelOne) - x0, dy1 = tri.y[1] / static_cast<float>(SubpixelOne) - y0;
+				const float dx2 = tri.x[2] / static_cast<float>(SubpixelOne) - x0, dy2 = tri.y[2] / static_cast<float>(SubpixelOne) - y0;
+				const float determinant = dx1 * dy2 - dx2 * dy1;
+
+				const auto make_plane = [&](float v0, float v1, float v2) noexcept -> Plane {
+					const float d1 = v1 - v0, d2 = v2 - v0;
+					return Plane{ v0, (d1 * dy2 - d2 * dy1) / determinant, (d2 * dx1 - d1 * dx2) / determinant };
+				};
+
+				tri.originX = x0;
+				tri.originY = y0;
+				tri.depth = make_plane(sz[order[0]], sz[order[1]], sz[order[2]]);
+				tri.inverseW = make_plane(inv_w[order[0]], inv_w[order[1]], inv_w[order[2]]);
+
+				for (int c = 0; c < 4; ++c)
+				{
+					tri.colour[c] = make_plane(source[order[0]]->colour[c] * inv_w[order[0]]
+						, source[order[1]]->colour[c] * inv_w[order[1]]
+						, source[order[2]]->colour[c] * inv_w[order[2]]);
+				}
+
+				const std::uint32_t index = static_cast<std::uint32_t>(bin.triangles.size());
+				bin.triangles.push_back(tri);
+
+				const std::uint32_t tile_x0 = static_cast<std::uint32_t>(tri.minX) / raster::TileSize;
+				const std::uint32_t tile_x1 = static_cast<std::uint32_t>(tri.maxX) / raster::TileSize;
+				const std::uint32_t tile_y0 = static_cast<std::uint32_t>(tri.minY) / raster::TileSize;
+				const std::uint32_t tile_y1 = static_cast<std::uint32_t>(tri.maxY) / raster::TileSize;
+
+				for (std::uint32_t ty = tile_y0; ty <= tile_y1; ++ty)
+				{
+					for (std::uint32_t tx = tile_x0; tx <= tile_x1; ++tx)
+					{
+						bin.tiles[ty * tilesX + tx].push_back(index);
+					}
+				}
+
+				++stats.binnedTriangles;
+			}
+		}
+	});
+
+	for (const raster::Statistics& stats : statistics)
+	{
+		myStatistics.submittedTriangles += stats.submittedTriangles;
+		myStatistics.clippedTriangles += stats.clippedTriangles;
+		myStatistics.culledTriangles += stats.culledTriangles;
+		myStatistics.binnedTriangles += stats.binnedTriangles;
+	}
+
+	return true;
+}
+
+void
+gl::SoftwareRasterizer::Finish()
+{
+	std::vector<raster::Statistics> statistics(myThreads);
+
+	ParallelFor(myThreads, tilesX * tilesY, [&](std::uint32_t tile, std::uint32_t worker) {
+		RasterizeTile(tile, statistics[worker]);
+	});
+
+	for (const raster::Statistics& stats : statistics)
+	{
+		myStatistics.shadedPixels += stats.shadedPixels;
+	}
+
+	myBatches.clear();
+}
+
+void
+gl::SoftwareRasterizer::RasterizeTile(std::uint32_t tile, gl::raster::Statistics& statistics)
+noexcept
+{
+	const std::int32_t tile_x0 = static_cast<std::int32_t>((tile % tilesX) * raster::TileSize);
+	const std::int32_t tile_y0 = static_cast<std::int32_t>((tile / tilesX) * raster::TileSize);
+	const std::int32_t tile_x1 = std::min(tile_x0 + static_cast<std::int32_t>(raster::TileSize), static_cast<std::int32_t>(myWidth)) - 1;
+	const std::int32_t tile_y1 = std::min(tile_y0 + static_cast<std::int32_t>(raster::TileSize), static_cast<std::int32_t>(myHeight)) - 1;
+
+	for (const Batch& batch : myBatches)
+	{
+		const raster::DrawState& state = batch.state;
+
+		for (const Bin& bin : batch.bins)
+		{
+			if (bin.tiles.empty())
+			{
+				continue;
+			}
+
+			for (const std::uint32_t index : bin.tiles[tile])
+			{
+				const Triangle& tri = bin.triangles[index];
+
+				const std::int32_t x0 = std::max(tri.minX, tile_x0), x1 = std::min(tri.maxX, tile_x1);
+				const std::int32_t y0 = std::max(tri.minY, tile_y0), y1 = std::min(tri.maxY, tile_y1);
+
+				const auto shade = [&](std::int32_t px, std::int32_t py) noexcept {
+					const float fx = px + 0.5f - tri.originX;
+					const float fy = py + 0.5f - tri.originY;
+
+					ScreenPixel& pixel = myPixels[static_cast<std::size_t>(py) * myWidth + px];
+
+					const float z = tri.depth.origin + tri.depth.dx * fx + tri.depth.dy * fy;
+					if (state.depthTesting && not Compare(state.depthComparator, z, pixel.depth))
+					{
+						return;
+					}
+
+					const float w = 1 / (tri.inverseW.origin + tri.inverseW.dx * fx + tri.inverseW.dy * fy);
+
+					float src[4];
+					for (int c = 0; c < 4; ++c)
+					{
+						src[c] = std::clamp((tri.colour[c].origin + tri.colour[c].dx * fx + tri.colour[c].dy * fy) * w, 0.0f, 1.0f);
+					}
+
+					if (state.blending)
+					{
+						const float dst[4] = { pixel.colour.R / 255.0f, pixel.colour.G / 255.0f, pixel.colour.B / 255.0f, pixel.colour.A / 255.0f };
+
+						float blended[4];
+						for (int c = 0; c < 4; ++c)
+						{
+							blended[c] = src[c] * GetBlendFactor(state.blendMode.srcOption, src, dst, c) + dst[c] * GetBlendFactor(state.blendMode.dstOption, src, dst, c);
+						}
+
+						std::copy_n(blended, 4, src);
+					}
+
+					pixel.colour = Colour{ ToByte(src[0]), ToByte(src[1]), ToByte(src[2]), ToByte(src[3]) };
+
+					// As in opengl, the depth is only written while testing
+					if (state.depthTesting && state.depthWriting)
+					{
+						pixel.depth = z;
+					}
+
+					++statistics.shadedPixels;
+				};
+
+				for (std::int32_t by = y0 & ~(BlockSize - 1); by <= y1; by += BlockSize)
+				{
+					for (std::int32_t bx = x0 & ~(BlockSize - 1); bx <= x1; bx += BlockSize)
+					{
+						// Edge values at the centre of the top left pixel of the block
+						std::int64_t origin[3];
+						bool inside[3];
+						bool rejected = false;
+
+						for (int e = 0; e < 3; ++e)
+						{
+							const std::int64_t px = static_cast<std::int64_t>(bx) * SubpixelOne + SubpixelHalf - tri.x[e];
+							const std::int64_t py = static_cast<std::int64_t>(by) * SubpixelOne + SubpixelHalf - tri.y[e];
+
+							origin[e] = tri.stepX[e] * px + tri.stepY[e] * py + tri.bias[e];
+
+							const std::int64_t highest = origin[e] + std::max(tri.stepX[e], 0) * static_cast<std::int64_t>(BlockSpan) + std::max(tri.stepY[e], 0) * static_cast<std::int64_t>(BlockSpan);
+							const std::int64_t lowest = origin[e] + std::min(tri.stepX[e], 0) * static_cast<std::int64_t>(BlockSpan) + std::min(tri.stepY[e], 0) * static_cast<std::int64_t>(BlockSpan);
+
+							rejected = rejected || highest < 0;
+							inside[e] = 0 <= lowest;
+						}
+
+						if (rejected)
+						{
+							continue;
+						}
+
+						const std::int32_t row_begin = std::max(by, y0), row_end = std::min(by + BlockSize - 1, y1);
+						const std::int32_t column_begin = std::max(bx, x0), column_end = std::min(bx + BlockSize - 1, x1);
+
+						if (inside[0] && inside[1] && inside[2])
+						{
+							for (std::int32_t py = row_begin; py <= row_end; ++py)
+							{
+								for (std::int32_t px = column_begin; px <= column_end; ++px)
+								{
+									shade(px, py);
+								}
+							}
+
+							continue;
+						}
+
+						// Partially covered, so the edge values inside the block fit in 32 bits
+						std::int32_t start[3], step_x[3], step_y[3];
+						for (int e = 0; e < 3; ++e)
+						{
+							// Edges which cover the whole block are left out of the test
+							start[e] = inside[e] ? 0 : static_cast<std::int32_t>(origin[e]);
+							step_x[e] = inside[e] ? 0 : tri.stepX[e] * SubpixelOne;
+							step_y[e] = inside[e] ? 0 : tri.stepY[e] * SubpixelOne;
+						}
+
+						// Columns of the block which are in range
+						const std::uint32_t columns = ((1U << (column_end - bx + 1)) - 1) & ~((1U << (column_begin - bx)) - 1);
+
+#if GLIB_RASTER_SSE2
+						// Edge values of the first row, four columns per lane group
+						__m128i left[3], right[3], down[3];
+						for (int e = 0; e < 3; ++e)
+						{
+							const std::int32_t first = start[e] + step_y[e] * (row_begin - by);
+							left[e] = _mm_setr_epi32(first, first + step_x[e], first + step_x[e] * 2, first + step_x[e] * 3);
+							right[e] = _mm_add_epi32(left[e], _mm_set1_epi32(step_x[e] * 4));
+							down[e] = _mm_set1_epi32(step_y[e]);
+						}
+
+						const __m128i negative = _mm_set1_epi32(-1);
+#endif
+
+						for (std::int32_t py = row_begin; py <= row_end; ++py)
+						{
+#if GLIB_RASTER_SSE2
+							__m128i covered_left = _mm_cmpgt_epi32(left[0], negative);
+							__m128i covered_right = _mm_cmpgt_epi32(right[0], negative);
+
+							for (int e = 1; e < 3; ++e)
+							{
+								covered_left = _mm_and_si128(covered_left, _mm_cmpgt_epi32(left[e], negative));
+								covered_right = _mm_and_si128(covered_right, _mm_cmpgt_epi32(right[e], negative));
+							}
+
+							for (int e = 0; e < 3; ++e)
+							{
+								left[e] = _mm_add_epi32(left[e], down[e]);
+								right[e] = _mm_add_epi32(right[e], down[e]);
+							}
+
+							const std::uint32_t coverage = static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(covered_left)))
+								| (static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(covered_right))) << 4);
+#else
+							const std::int32_t row = py - by;
+
+							std::uint32_t coverage = 0;
+							for (std::int32_t column = 0; column < BlockSize; ++column)
+							{
+								const bool covered = 0 <= start[0] + step_y[0] * row + step_x[0] * column
+									&& 0 <= start[1] + step_y[1] * row + step_x[1] * column
+									&& 0 <= start[2] + step_y[2] * row + step_x[2] * column;
+
+								coverage |= static_cast<std::uint32_t>(covered) << column;
+							}
+#endif
+
+							for (std::uint32_t mask = coverage & columns; 0 != mask; mask &= mask - 1)
+							{
+								std::int32_t column = 0;
+								while (0 == (mask & (1U << column)))
+								{
+									++column;
+								}
+
+								shade(bx + column, py);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+std::span<const gl::ScreenPixel>
+gl::SoftwareRasterizer::GetPixels()
+const noexcept
+{
+	return myPixels;
+}
+
+std::uint32_t
+gl::SoftwareRasterizer::GetWidth()
+const noexcept
+{
+	return myWidth;
+}
+
+std::uint32_t
+gl::SoftwareRasterizer::GetHeight()
+const noexcept
+{
+	return myHeight;
+}
+
+std::uint32_t
+gl::SoftwareRasterizer::GetThreads()
+const noexcept
+{
+	return myThreads;
+}
+
+const gl::raster::Statistics&
+gl::SoftwareRasterizer::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+std::vector<gl::raster::Benchmark>
+gl::raster::MeasureThroughput(std::uint32_t width, std::uint32_t height, std::uint32_t triangles, std::uint32_t iterations)
+{
+	struct Vertex
+	{
+		float position[3];
+		float colour[4];
+	};
+
+	// Small random triangles in normalized device coordinates, about a hundred pixels each
+	std::mt19937 engine{ 0x5EED };
+	std::uniform_real_distribution<float> centre{ -1.0f, 1.0f };
+	std::uniform_real_distribution<float> offset{ -0.02f, 0.02f };
+	std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+
+	std::vector<Vertex> vertices(static_cast<std::size_t>(triangles) * 3);
+	for (std::size_t i = 0; i < triangles; ++i)
+	{
+		const float cx = centre(engine), cy = centre(engine), cz = unit(engine);
+
+		for (std::size_t k = 0; k < 3; ++k)
+		{
+			vertices[i * 3 + k] = Vertex{ { cx + offset(engine), cy + offset(engine), cz }, { unit(engine), unit(engine), unit(engine), 1.0f } };
+		}
+	}
+
+	BufferLayout layout{};
+	layout.SetStride(sizeof(Vertex));
+	layout.AddElement<float>(3);
+	layout.AddElement<float>(4);
+
+	raster::VertexInput input{};
+	input.vertices = std::as_bytes(std::span{ vertices });
+	input.layout = &layout;
+	input.colourElement = 1;
+
+	std::vector<Benchmark> result{};
+
+	// Powers of two, then the hardware concurrency itself
+	const std::uint32_t concurrency = GetWorkerCount(0);
+
+	std::vector<std::uint32_t> thread_counts{};
+	for (std::uint32_t threads = 1; threads < concurrency; threads *= 2)
+	{
+		thread_counts.push_back(threads);
+	}
+	thread_counts.push_back(concurrency);
+
+	for (const std::uint32_t threads : thread_counts)
+	{
+		SoftwareRasterizer rasterizer{ width, height, threads };
+
+		double best = 0;
+		for (std::uint32_t i = 0; i < std::max(1U, iterations); ++i)
+		{
+			rasterizer.Clear(Colour{ 0.0f, 0.0f, 0.0f, 1.0f });
+
+			const auto start = std::chrono::steady_clock::now();
+			rasterizer.Draw(input);
+			rasterizer.Finish();
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+			if (0 < elapsed.count())
+			{
+				best = std::max(best, triangles / elapsed.count());
+			}
+		}
+
+		result.push_back(Benchmark{ threads, best });
+	}
+
+	return result;
+}
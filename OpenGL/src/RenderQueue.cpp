@@ -0,0 +1,365 @@
+module;
+#define NOMINMAX
+#include <Windows.h>
+#include "glew.h"
+#include <gl\gl.h>
+module Glib.RenderQueue;
+import <algorithm>;
+import <array>;
+import <numeric>;
+import <limits>;
+import <utility>;
+import <chrono>;
+import <random>;
+import Glib.Parallel;
+
+namespace
+{
+	constexpr std::uint32_t DigitBits = 8;
+	constexpr std::uint32_t DigitCount = 1U << DigitBits;
+	constexpr std::uint32_t PassCount = 64 / DigitBits;
+
+	// Below this many keys per worker, the threads cost more than they save
+	constexpr std::size_t MinimumItemsPerWorker = 16384;
+
+	using Histogram = std::array<std::uint32_t, DigitCount>;
+
+	[[nodiscard]]
+	constexpr std::uint32_t
+	GetDigit(std::uint64_t key, std::uint32_t pass)
+	noexcept
+	{
+		return static_cast<std::uint32_t>(key >> (pass * DigitBits)) & (DigitCount - 1);
+	}
+}
+
+void
+gl::render::RadixSort(std::span<std::uint64_t> keys, std::span<std::uint32_t> values, std::span<std::uint64_t> scratch_keys, std::span<std::uint32_t> scratch_values, std::uint32_t threads)
+{
+	const std::size_t count = keys.size();
+	if (count < 2)
+	{
+		return;
+	}
+
+	const std::uint32_t workers = static_cast<std::uint32_t>(std::clamp<std::size_t>(count / MinimumItemsPerWorker, 1, GetWorkerCount(threads)));
+
+	// Every worker keeps the same contiguous chunk through the passes, which makes the sort stable
+	const auto chunk_begin = [&](std::uint32_t worker) noexcept {
+		return count * worker / workers;
+	};
+
+	std::vector<Histogram> histograms(workers);
+
+	std::uint64_t* source_keys = keys.data();
+	std::uint32_t* source_values = values.data();
+	std::uint64_t* target_keys = scratch_keys.data();
+	std::uint32_t* target_values = scratch_values.data();
+
+	for (std::uint32_t pass = 0; pass < PassCount; ++pass)
+	{
+		ParallelFor(workers, workers, [&](std::uint32_t worker, std::uint32_t) {
+			Histogram& histogram = histograms[worker];
+			histogram.fill(0);
+
+			const std::size_t end = chunk_begin(worker + 1);
+			for (std::size_t i = chunk_begin(worker); i < end; ++i)
+			{
+				++histogram[GetDigit(source_keys[i], pass)];
+			}
+		});
+
+		// A digit which every key shares doesn't reorder anything
+		const std::uint32_t first_digit = GetDigit(source_keys[0], pass);
+
+		std::size_t same = 0;
+		for (const Histogram& histogram : histograms)
+		{
+			same += histogram[first_digit];
+		}
+
+		if (count == same)
+		{
+			continue;
+		}
+
+		// Offsets go digit by digit, then worker by worker
+		std::uint32_t offset = 0;
+		for (std::uint32_t digit = 0; digit < DigitCount; ++digit)
+		{
+			for (Histogram& histogram : histograms)
+			{
+				const std::uint32_t size = histogram[digit];
+				histogram[digit] = offset;
+				offset += size;
+			}
+		}
+
+		ParallelFor(workers, workers, [&](std::uint32_t worker, std::uint32_t) {
+			Histogram& offsets = histograms[worker];
+
+			const std::size_t end = chunk_begin(worker + 1);
+			for (std::size_t i = chunk_begin(worker); i < end; ++i)
+			{
+				const std::uint32_t target = offsets[GetDigit(source_keys[i], pass)]++;
+
+				target_keys[target] = source_keys[i];
+				target_values[target] = source_values[i];
+			}
+		});
+
+		std::swap(source_keys, target_keys);
+		std::swap(source_values, target_values);
+	}
+
+	if (source_keys != keys.data())
+	{
+		std::copy_n(source_keys, count, keys.data());
+		std::copy_n(source_values, count, values.data());
+	}
+}
+
+gl::RenderQueue::RenderQueue(std::uint32_t threads)
+	: myThreads(GetWorkerCount(threads))
+{}
+
+gl::RenderQueue::~RenderQueue()
+noexcept
+{}
+
+void
+gl::RenderQueue::Clear()
+noexcept
+{
+	myItems.clear();
+	myKeys.clear();
+	myOrder.clear();
+	myStatistics = {};
+	isSorted = true;
+}
+
+void
+gl::RenderQueue::Reserve(std::size_t count)
+{
+	myItems.reserve(count);
+	myKeys.reserve(count);
+	myOrder.reserve(count);
+}
+
+void
+gl::RenderQueue::Push(gl::render::DrawItem&& item)
+{
+	myItems.push_back(std::move(item));
+	isSorted = false;
+}
+
+void
+gl::RenderQueue::Sort()
+{
+	const std::size_t count = myItems.size();
+
+	myKeys.resize(count);
+	myOrder.resize(count);
+	myScratchKeys.resize(count);
+	myScratchIndices.resize(count);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		myKeys[i] = myItems[i].key;
+	}
+
+	std::iota(myOrder.begin(), myOrder.end(), 0U);
+
+	render::RadixSort(myKeys, myOrder, myScratchKeys, myScratchIndices, myThreads);
+
+	isSorted = true;
+}
+
+void
+gl::RenderQueue::Submit()
+{
+	if (not isSorted || myOrder.size() != myItems.size())
+	{
+		Sort();
+	}
+
+	render::Statistics statistics{};
+	statistics.items = myItems.size();
+
+	const Pipeline* last_pipeline = nullptr;
+	const Texture* last_texture = nullptr;
+	const BufferObject* last_buffer = nullptr;
+
+	// Whatever was current before the first item is unknown, so it always sets the blending
+	bool has_blending = false;
+	bool last_blending = false;
+	BlendMode last_mode = Opaque;
+
+	for (const std::uint32_t index : myOrder)
+	{
+		render::DrawItem& item = myItems[index];
+
+		if (nullptr != item.pipeline)
+		{
+			if (item.pipeline != last_pipeline)
+			{
+				item.pipeline->Use();
+				last_pipeline = item.pipeline;
+				++statistics.pipelineChanges;
+			}
+			else
+			{
+				++statistics.skippedChanges;
+			}
+		}
+
+		if (nullptr != item.texture)
+		{
+			if (item.texture != last_texture)
+			{
+				item.texture->Bind();
+				last_texture = item.texture;
+				++statistics.textureChanges;
+			}
+			else
+			{
+				++statistics.skippedChanges;
+			}
+		}
+
+		if (nullptr != item.buffer)
+		{
+			if (item.buffer != last_buffer)
+			{
+				item.buffer->Use();
+				last_buffer = item.buffer;
+				++statistics.bufferChanges;
+			}
+			else
+			{
+				++statistics.skippedChanges;
+			}
+		}
+
+		const bool same_blending = has_blending && item.blending == last_blending
+			&& (not item.blending || (item.blendMode.srcOption == last_mode.srcOption && item.blendMode.dstOption == last_mode.dstOption));
+
+		if (same_blending)
+		{
+			++statistics.skippedChanges;
+		}
+		else
+		{
+			global::SetState(State::Blending, item.blending);
+
+			if (item.blending)
+			{
+				::glBlendFunc(static_cast<GLenum>(item.blendMode.srcOption), static_cast<GLenum>(item.blendMode.dstOption));
+			}
+
+			has_blending = true;
+			last_blending = item.blending;
+			last_mode = item.blendMode;
+			++statistics.blendChanges;
+		}
+
+		if (item.renderer)
+		{
+			item.renderer();
+		}
+		else if (nullptr != item.pipeline)
+		{
+			item.pipeline->Render(item.primitive, item.count);
+		}
+		else
+		{
+			global::EmitPrimitives(item.primitive, 0, item.count);
+		}
+
+		++statistics.drawCalls;
+	}
+
+	myStatistics = statistics;
+}
+
+std::span<const std::uint32_t>
+gl::RenderQueue::GetOrder()
+const noexcept
+{
+	return myOrder;
+}
+
+std::span<const gl::render::DrawItem>
+gl::RenderQueue::GetItems()
+const noexcept
+{
+	return myItems;
+}
+
+const gl::render::Statistics&
+gl::RenderQueue::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+std::size_t
+gl::RenderQueue::GetSize()
+const noexcept
+{
+	return myItems.size();
+}
+
+bool
+gl::RenderQueue::IsEmpty()
+const noexcept
+{
+	return myItems.empty();
+}
+
+gl::render::Benchmark
+gl::render::MeasureSorting(std::size_t items, std::uint32_t iterations, std::uint32_t threads)
+{
+	std::mt19937 engine{ 0x5EED };
+	std::uniform_int_distribution<std::uint32_t> layer{ 0, 3 }, pipeline{ 0, 31 }, material{ 0, 511 };
+	std::uniform_real_distribution<float> depth{ 0.0f, 1.0f };
+	std::bernoulli_distribution translucent{ 0.2 };
+
+	std::vector<std::uint64_t> source(items);
+	for (std::uint64_t& key : source)
+	{
+		key = MakeSortKey(static_cast<std::uint8_t>(layer(engine)), static_cast<std::uint16_t>(pipeline(engine)), static_cast<std::uint16_t>(material(engine)), depth(engine), translucent(engine));
+	}
+
+	Benchmark result{};
+	result.items = items;
+	result.threads = GetWorkerCount(threads);
+	result.radixSeconds = std::numeric_limits<double>::max();
+	result.comparisonSeconds = std::numeric_limits<double>::max();
+
+	std::vector<std::uint64_t> keys(items), scratch_keys(items);
+	std::vector<std::uint32_t> values(items), scratch_values(items);
+
+	for (std::uint32_t i = 0; i < std::max(1U, iterations); ++i)
+	{
+		keys = source;
+		std::iota(values.begin(), values.end(), 0U);
+
+		auto start = std::chrono::steady_clock::now();
+		RadixSort(keys, values, scratch_keys, scratch_values, threads);
+		result.radixSeconds = std::min(result.radixSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+		// The same pairs through a comparison sort
+		std::vector<std::pair<std::uint64_t, std::uint32_t>> pairs(items);
+		for (std::size_t k = 0; k < items; ++k)
+		{
+			pairs[k] = { source[k], static_cast<std::uint32_t>(k) };
+		}
+
+		start = std::chrono::steady_clock::now();
+		std::sort(pairs.begin(), pairs.end());
+		result.comparisonSeconds = std::min(result.comparisonSeconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	return result;
+}
@@ -0,0 +1,626 @@
+module;
+#define NOMINMAX
+#include <Windows.h>
+#include "glew.h"
+#include <gl\gl.h>
+module Glib.RenderTarget;
+import <algorithm>;
+import <utility>;
+
+namespace
+{
+	class OpenGLDevice final : public gl::target::Device
+	{
+	public:
+		[[nodiscard]]
+		std::uint32_t
+		CreateTexture(const gl::target::Description& description)
+		noexcept override
+		{
+			// Integer and depth formats can't be filtered
+			const bool is_nearest = gl::target::Format::R32UI == description.format || gl::target::IsDepthFormat(description.format);
+			const GLint filter = is_nearest ? GL_NEAREST : GL_LINEAR;
+
+			GLuint texture = 0;
+			::glGenTextures(1, std::addressof(texture));
+			::glBindTexture(GL_TEXTURE_2D, texture);
+			::glTexStorage2D(GL_TEXTURE_2D, 1, static_cast<GLenum>(description.format), static_cast<GLsizei>(description.width), static_cast<GLsizei>(description.height));
+			::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+			::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+			::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			::glBindTexture(GL_TEXTURE_2D, 0);
+
+			return texture;
+		}
+
+		void
+		DeleteTexture(std::uint32_t texture)
+		noexcept override
+		{
+			::glDeleteTextures(1, std::addressof(texture));
+		}
+
+		void
+		BindTexture(std::uint32_t unit, std::uint32_t texture)
+		noexcept override
+		{
+			::glActiveTexture(GL_TEXTURE0 + unit);
+			::glBindTexture(GL_TEXTURE_2D, texture);
+		}
+
+		[[nodiscard]]
+		std::uint32_t
+		CreateFramebuffer(std::span<const std::uint32_t> colours, std::uint32_t depth, gl::target::Format depth_format)
+		noexcept override
+		{
+			GLint previous = 0;
+			::glGetIntegerv(GL_FRAMEBUFFER_BINDING, std::addressof(previous));
+
+			GLuint framebuffer = 0;
+			::glGenFramebuffers(1, std::addressof(framebuffer));
+			::glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+			std::array<GLenum, gl::target::MaxColourAttachments> attachments{};
+			const GLsizei count = static_cast<GLsizei>(std::min<std::size_t>(colours.size(), attachments.size()));
+
+			for (GLsizei i = 0; i < count; ++i)
+			{
+				attachments[i] = GL_COLOR_ATTACHMENT0 + i;
+				::glFramebufferTexture2D(GL_FRAMEBUFFER, attachments[i], GL_TEXTURE_2D, colours[i], 0);
+			}
+
+			if (0 != depth)
+			{
+				const GLenum attachment = gl::target::HasStencil(depth_format) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+				::glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, depth, 0);
+			}
+
+			// A depth only framebuffer has no colour to draw or to read
+			if (0 < count)
+			{
+				::glDrawBuffers(count, attachments.data());
+				::glReadBuffer(GL_COLOR_ATTACHMENT0);
+			}
+			else
+			{
+				::glDrawBuffer(GL_NONE);
+				::glReadBuffer(GL_NONE);
+			}
+
+			const bool complete = GL_FRAMEBUFFER_COMPLETE == ::glCheckFramebufferStatus(GL_FRAMEBUFFER);
+			::glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+
+			if (!complete)
+			{
+				::glDeleteFramebuffers(1, std::addressof(framebuffer));
+				return 0;
+			}
+
+			return framebuffer;
+		}
+
+		void
+		DeleteFramebuffer(std::uint32_t framebuffer)
+		noexcept override
+		{
+			::glDeleteFramebuffers(1, std::addressof(framebuffer));
+		}
+
+		void
+		BindFramebuffer(std::uint32_t framebuffer, std::uint32_t width, std::uint32_t height)
+		noexcept override
+		{
+			::glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+			if (0 < width && 0 < height)
+			{
+				::glViewport(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+			}
+		}
+	};
+}
+
+bool
+gl::target::IsDepthFormat(gl::target::Format format)
+noexcept
+{
+	return Format::Depth24 == format || Format::Depth32F == format || Format::Depth24Stencil8 == format;
+}
+
+bool
+gl::target::HasStencil(gl::target::Format format)
+noexcept
+{
+	return Format::Depth24Stencil8 == format;
+}
+
+std::uint32_t
+gl::target::GetBytesPerPixel(gl::target::Format format)
+noexcept
+{
+	switch (format)
+	{
+		case Format::R8:
+		return 1;
+
+		case Format::RG8:
+		return 2;
+
+		case Format::RGBA16F:
+		return 8;
+
+		case Format::RGBA32F:
+		return 16;
+
+		default:
+		return 4;
+	}
+}
+
+std::uint64_t
+gl::target::GetByteSize(const gl::target::Description& description)
+noexcept
+{
+	return static_cast<std::uint64_t>(description.width) * description.height * GetBytesPerPixel(description.format);
+}
+
+gl::target::Device&
+gl::target::GetDevice()
+noexcept
+{
+	static OpenGLDevice device{};
+
+	return device;
+}
+
+gl::RenderTarget::RenderTarget(const gl::target::Description& description, gl::target::Device& device)
+noexcept
+	: base(device.CreateTexture(description))
+	, myDevice(std::addressof(device))
+	, myDescription(description)
+{}
+
+gl::RenderTarget::~RenderTarget()
+noexcept
+{
+	Destroy();
+}
+
+gl::RenderTarget::RenderTarget(gl::RenderTarget&& other)
+noexcept
+	: base(std::exchange(other.myID, 0))
+	, myDevice(std::exchange(other.myDevice, nullptr))
+	, myDescription(std::exchange(other.myDescription, {}))
+{}
+
+gl::RenderTarget&
+gl::RenderTarget::operator=(gl::RenderTarget&& other)
+noexcept
+{
+	if (this != std::addressof(other))
+	{
+		Destroy();
+
+		myID = std::exchange(other.myID, 0);
+		myDevice = std::exchange(other.myDevice, nullptr);
+		myDescription = std::exchange(other.myDescription, {});
+	}
+
+	return *this;
+}
+
+void
+gl::RenderTarget::Bind(std::uint32_t unit)
+const noexcept
+{
+	if (IsValid())
+	{
+		myDevice->BindTexture(unit, myID);
+	}
+}
+
+void
+gl::RenderTarget::Destroy()
+noexcept
+{
+	if (IsValid())
+	{
+		myDevice->DeleteTexture(myID);
+		myID = 0;
+	}
+}
+
+const gl::target::Description&
+gl::RenderTarget::GetDescription()
+const noexcept
+{
+	return myDescription;
+}
+
+std::uint32_t
+gl::RenderTarget::GetWidth()
+const noexcept
+{
+	return myDescription.width;
+}
+
+std::uint32_t
+gl::RenderTarget::GetHeight()
+const noexcept
+{
+	return myDescription.height;
+}
+
+gl::target::Format
+gl::RenderTarget::GetFormat()
+const noexcept
+{
+	return myDescription.format;
+}
+
+std::uint64_t
+gl::RenderTarget::GetByteSize()
+const noexcept
+{
+	return target::GetByteSize(myDescription);
+}
+
+gl::Framebuffer::Framebuffer(std::span<const gl::RenderTarget* const> colours, const gl::RenderTarget* depth, gl::target::Device& device)
+noexcept
+	: base()
+	, myDevice(std::addressof(device))
+{
+	std::array<std::uint32_t, target::MaxColourAttachments> textures{};
+	myColourCount = static_cast<std::uint32_t>(std::min<std::size_t>(colours.size(), textures.size()));
+
+	for (std::uint32_t i = 0; i < myColourCount; ++i)
+	{
+		textures[i] = colours[i]->GetID();
+		myWidth = colours[i]->GetWidth();
+		myHeight = colours[i]->GetHeight();
+	}
+
+	if (nullptr != depth)
+	{
+		myWidth = depth->GetWidth();
+		myHeight = depth->GetHeight();
+	}
+
+	myID = device.CreateFramebuffer(std::span{ textures.data(), myColourCount }, nullptr != depth ? depth->GetID() : 0, nullptr != depth ? depth->GetFormat() : target::Format::Depth24);
+}
+
+gl::Framebuffer::~Framebuffer()
+noexcept
+{
+	Destroy();
+}
+
+gl::Framebuffer::Framebuffer(gl::Framebuffer&& other)
+noexcept
+	: base(std::exchange(other.myID, 0))
+	, myDevice(std::exchange(other.myDevice, nullptr))
+	, myWidth(std::exchange(other.myWidth, 0))
+	, myHeight(std::exchange(other.myHeight, 0))
+	, myColourCount(std::exchange(other.myColourCount, 0))
+{}
+
+gl::Framebuffer&
+gl::Framebuffer::operator=(gl::Framebuffer&& other)
+noexcept
+{
+	if (this != std::addressof(other))
+	{
+		Destroy();
+
+		myID = std::exchange(other.myID, 0);
+		myDevice = std::exchange(other.myDevice, nullptr);
+		myWidth = std::exchange(other.myWidth, 0);
+		myHeight = std::exchange(other.myHeight, 0);
+		myColourCount = std::exchange(other.myColourCount, 0);
+	}
+
+	return *this;
+}
+
+void
+gl::Framebuffer::Bind()
+const noexcept
+{
+	if (IsValid())
+	{
+		myDevice->BindFramebuffer(myID, myWidth, myHeight);
+	}
+}
+
+void
+gl::Framebuffer::Unbind()
+const noexcept
+{
+	if (nullptr != myDevice)
+	{
+		myDevice->BindFramebuffer(0, 0, 0);
+	}
+}
+
+void
+gl::Framebuffer::Destroy()
+noexcept
+{
+	if (IsValid())
+	{
+		myDevice->DeleteFramebuffer(myID);
+		myID = 0;
+	}
+}
+
+std::uint32_t
+gl::Framebuffer::GetWidth()
+const noexcept
+{
+	return myWidth;
+}
+
+std::uint32_t
+gl::Framebuffer::GetHeight()
+const noexcept
+{
+	return myHeight;
+}
+
+std::uint32_t
+gl::Framebuffer::GetColourCount()
+const noexcept
+{
+	return myColourCount;
+}
+
+gl::TransientTargets::TransientTargets(gl::target::Device& device, std::uint32_t idle_frames)
+noexcept
+	: myDevice(std::addressof(device))
+	, myIdleFrames(idle_frames)
+{}
+
+gl::TransientTargets::~TransientTargets()
+noexcept
+{
+	Clear();
+}
+
+void
+gl::TransientTargets::BeginFrame()
+noexcept
+{
+	++myFrame;
+
+	const target::Statistics previous = myStatistics;
+	myStatistics = {};
+	myStatistics.liveTargets = previous.liveTargets;
+	myStatistics.liveFramebuffers = previous.liveFramebuffers;
+	myStatistics.residentBytes = previous.residentBytes;
+
+	for (Slot& slot : mySlots)
+	{
+		slot.isReleased = false;
+	}
+}
+
+void
+gl::TransientTargets::EndFrame()
+noexcept
+{
+	for (std::size_t i = 0; i < mySlots.size(); ++i)
+	{
+		Slot& slot = mySlots[i];
+		if (!slot.target.IsValid())
+		{
+			continue;
+		}
+
+		slot.isUsed = false;
+
+		if (slot.lastFrame + myIdleFrames < myFrame)
+		{
+			DestroySlot(i);
+		}
+	}
+
+	myUsedBytes = 0;
+}
+
+gl::target::Handle
+gl::TransientTargets::Acquire(const gl::target::Description& description)
+{
+	++myStatistics.acquired;
+
+	// A target released in this frame is preferred, it is the one the driver has touched last
+	std::size_t found = mySlots.size();
+	for (std::size_t i = 0; i < mySlots.size(); ++i)
+	{
+		const Slot& slot = mySlots[i];
+		if (slot.isUsed || !slot.target.IsValid() || slot.target.GetDescription() != description)
+		{
+			continue;
+		}
+
+		if (found == mySlots.size() || (slot.isReleased && !mySlots[found].isReleased) || (slot.isReleased == mySlots[found].isReleased && mySlots[found].lastFrame < slot.lastFrame))
+		{
+			found = i;
+		}
+	}
+
+	if (found < mySlots.size())
+	{
+		if (mySlots[found].isReleased)
+		{
+			++myStatistics.aliased;
+		}
+		else
+		{
+			++myStatistics.reused;
+		}
+	}
+	else
+	{
+		RenderTarget target{ description, *myDevice };
+
+		if (myEmptySlots.empty())
+		{
+			found = mySlots.size();
+			mySlots.push_back(Slot{ std::move(target) });
+		}
+		else
+		{
+			found = myEmptySlots.back();
+			myEmptySlots.pop_back();
+			mySlots[found].target = std::move(target);
+		}
+
+		++myStatistics.created;
+		++myStatistics.liveTargets;
+		myStatistics.residentBytes += target::GetByteSize(description);
+	}
+
+	Slot& slot = mySlots[found];
+	slot.isUsed = true;
+	slot.isReleased = false;
+	slot.lastFrame = myFrame;
+
+	myUsedBytes += slot.target.GetByteSize();
+	myStatistics.peakBytes = std::max(myStatistics.peakBytes, myUsedBytes);
+
+	return static_cast<target::Handle>(found);
+}
+
+void
+gl::TransientTargets::Release(gl::target::Handle handle)
+noexcept
+{
+	if (mySlots.size() <= handle || !mySlots[handle].isUsed)
+	{
+		return;
+	}
+
+	Slot& slot = mySlots[handle];
+	slot.isUsed = false;
+	slot.isReleased = true;
+
+	myUsedBytes -= slot.target.GetByteSize();
+}
+
+const gl::RenderTarget&
+gl::TransientTargets::GetTarget(gl::target::Handle handle)
+const noexcept
+{
+	return mySlots[handle].target;
+}
+
+const gl::Framebuffer&
+gl::TransientTargets::GetFramebuffer(std::span<const gl::target::Handle> colours, gl::target::Handle depth)
+{
+	std::array<const RenderTarget*, target::MaxColourAttachments> targets{};
+	std::array<std::uint32_t, target::MaxColourAttachments + 1> textures{};
+
+	const std::size_t count = std::min<std::size_t>(colours.size(), targets.size());
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		targets[i] = std::addressof(mySlots[colours[i]].target);
+		textures[i] = targets[i]->GetID();
+	}
+
+	const RenderTarget* depth_target = target::InvalidHandle != depth ? std::addressof(mySlots[depth].target) : nullptr;
+	if (nullptr != depth_target)
+	{
+		textures.back() = depth_target->GetID();
+	}
+
+	CachedFramebuffer* empty = nullptr;
+	for (CachedFramebuffer& cached : myFramebuffers)
+	{
+		if (cached.textures == textures && cached.framebuffer.IsValid())
+		{
+			return cached.framebuffer;
+		}
+
+		if (nullptr == empty && !cached.framebuffer.IsValid())
+		{
+			empty = std::addressof(cached);
+		}
+	}
+
+	if (nullptr == empty)
+	{
+		empty = std::addressof(myFramebuffers.emplace_back());
+	}
+
+	empty->textures = textures;
+	empty->framebuffer = Framebuffer{ std::span{ targets.data(), count }, depth_target, *myDevice };
+
+	if (empty->framebuffer.IsValid())
+	{
+		++myStatistics.liveFramebuffers;
+	}
+
+	return empty->framebuffer;
+}
+
+void
+gl::TransientTargets::Clear()
+noexcept
+{
+	for (std::size_t i = 0; i < mySlots.size(); ++i)
+	{
+		if (mySlots[i].target.IsValid())
+		{
+			DestroySlot(i);
+		}
+	}
+
+	myFramebuffers.clear();
+	mySlots.clear();
+	myEmptySlots.clear();
+	myUsedBytes = 0;
+}
+
+const gl::target::Statistics&
+gl::TransientTargets::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+std::uint64_t
+gl::TransientTargets::GetFrame()
+const noexcept
+{
+	return myFrame;
+}
+
+void
+gl::TransientTargets::DestroySlot(std::size_t index)
+noexcept
+{
+	Slot& slot = mySlots[index];
+	const std::uint32_t texture = slot.target.GetID();
+
+	// The framebuffers the target is attached to go with it
+	for (CachedFramebuffer& cached : myFramebuffers)
+	{
+		if (cached.framebuffer.IsValid() && std::ranges::find(cached.textures, texture) != cached.textures.end())
+		{
+			cached.framebuffer.Destroy();
+			cached.textures = {};
+
+			--myStatistics.liveFramebuffers;
+		}
+	}
+
+	myStatistics.residentBytes -= slot.target.GetByteSize();
+	--myStatistics.liveTargets;
+	++myStatistics.destroyed;
+
+	slot.target.Destroy();
+	slot.isUsed = false;
+	slot.isReleased = false;
+	myEmptySlots.push_back(static_cast<std::uint32_t>(index));
+}
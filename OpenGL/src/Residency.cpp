@@ -0,0 +1,487 @@
+module;
+#include <Windows.h>
+#include "glew.h"
+#include <GL/GL.h>
+
+module Glib.Residency;
+import <utility>;
+import <algorithm>;
+import <atomic>;
+
+namespace
+{
+	// Handles never repeat across managers, so a resource created under one manager is unknown to the next
+	constinit std::atomic<gl::residency::handle_t> nextHandle = 1;
+}
+
+gl::ResidencyManager::ResidencyManager()
+noexcept
+	: ResidencyManager(residency::DefaultBudget)
+{}
+
+gl::ResidencyManager::ResidencyManager(const std::size_t& budget)
+noexcept
+{
+	myStatistics.budget = budget;
+}
+
+gl::ResidencyManager::~ResidencyManager()
+noexcept
+{
+	Uninstall();
+}
+
+gl::residency::handle_t
+gl::ResidencyManager::Allocate(gl::residency::ResourceKind kind
+	, const std::size_t& base_bytes, const std::uint32_t& mip_levels
+	, const std::size_t& cpu_bytes, const std::uint32_t& object)
+{
+	allocation_t allocation{};
+	allocation.handle = nextHandle.fetch_add(1, std::memory_order_relaxed);
+	allocation.kind = kind;
+	allocation.object = object;
+	allocation.baseBytes = base_bytes;
+	allocation.mipLevels = std::max(1U, mip_levels);
+	allocation.residentMip = 0;
+	allocation.cpuBytes = cpu_bytes;
+	allocation.lastUsedFrame = currentFrame;
+	allocation.isResident = true;
+
+	Account(allocation, residency::ComputeMipChainBytes(base_bytes, allocation.mipLevels));
+	myStatistics.cpuBytes += cpu_bytes;
+	myStatistics.numberOfAllocations++;
+
+	const handle_t handle = allocation.handle;
+	myAllocations.push_back(std::move(allocation));
+	myIndices.emplace(handle, std::prev(myAllocations.end()));
+
+	return handle;
+}
+
+void
+gl::ResidencyManager::Free(const handle_t& handle)
+noexcept
+{
+	if (auto it = myIndices.find(handle); myIndices.end() != it)
+	{
+		allocation_t& allocation = *(it->second);
+
+		Account(allocation, 0);
+		myStatistics.cpuBytes -= allocation.cpuBytes;
+		myStatistics.numberOfAllocations--;
+
+		myAllocations.erase(it->second);
+		myIndices.erase(it);
+	}
+}
+
+bool
+gl::ResidencyManager::Touch(const handle_t& handle)
+noexcept
+{
+	if (auto it = myIndices.find(handle); myIndices.end() != it)
+	{
+		allocation_t& allocation = *(it->second);
+		allocation.lastUsedFrame = currentFrame;
+
+		// Move it to the most recently used position
+		myAllocations.splice(myAllocations.end(), myAllocations, it->second);
+
+		if ((not allocation.isResident || 0 < allocation.residentMip) && allocation.reload)
+		{
+			Reload(allocation);
+		}
+
+		return allocation.isResident && 0 == allocation.residentMip;
+	}
+
+	return false;
+}
+
+void
+gl::ResidencyManager::Restore(const handle_t& handle)
+noexcept
+{
+	if (auto it = myIndices.find(handle); myIndices.end() != it)
+	{
+		allocation_t& allocation = *(it->second);
+
+		if (not allocation.isResident || 0 < allocation.residentMip)
+		{
+			allocation.isResident = true;
+			allocation.residentMip = 0;
+			Account(allocation, residency::ComputeMipChainBytes(allocation.baseBytes, allocation.mipLevels));
+
+			Notify(allocation, residency::EvictAction::Restore);
+		}
+
+		(void)Touch(handle);
+	}
+}
+
+void
+gl::ResidencyManager::MarkUploaded(const handle_t& handle)
+noexcept
+{
+	if (not shouldReleaseCpuCopies)
+	{
+		return;
+	}
+
+	if (auto it = myIndices.find(handle); myIndices.end() != it)
+	{
+		DropCpuCopy(*(it->second));
+	}
+}
+
+void
+gl::ResidencyManager::ReleaseCpuCopy(const handle_t& handle)
+noexcept
+{
+	if (auto it = myIndices.find(handle); myIndices.end() != it)
+	{
+		allocation_t& allocation = *(it->second);
+
+		// The copy is the last place the evicted contents are kept
+		if ((not allocation.isResident || 0 < allocation.residentMip) && allocation.reload)
+		{
+			Reload(allocation);
+		}
+
+		DropCpuCopy(allocation);
+	}
+}
+
+void
+gl::ResidencyManager::Install()
+noexcept
+{
+	residency::SetTracker(this);
+}
+
+void
+gl::ResidencyManager::Uninstall()
+noexcept
+{
+	if (residency::GetTracker() == this)
+	{
+		residency::SetTracker(nullptr);
+	}
+}
+
+gl::residency::handle_t
+gl::ResidencyManager::OnCreate(gl::residency::ResourceKind kind
+	, const std::uint32_t& object, const std::size_t& base_bytes, const std::uint32_t& mip_levels
+	, const std::size_t& cpu_bytes, std::function<void()> release_cpu_copy, std::function<void()> reload)
+{
+	const handle_t handle = Allocate(kind, base_bytes, mip_levels, release_cpu_copy ? cpu_bytes : 0, object);
+
+	allocation_t& allocation = *myIndices.at(handle);
+	allocation.releaseCpuCopy = std::move(release_cpu_copy);
+	allocation.reload = std::move(reload);
+
+	return handle;
+}
+
+void
+gl::ResidencyManager::OnUse(const handle_t& handle)
+noexcept
+{
+	(void)Touch(handle);
+}
+
+void
+gl::ResidencyManager::OnUpload(const handle_t& handle)
+noexcept
+{
+	Restore(handle);
+	MarkUploaded(handle);
+}
+
+void
+gl::ResidencyManager::OnReleaseCpuCopy(const handle_t& handle)
+noexcept
+{
+	ReleaseCpuCopy(handle);
+}
+
+void
+gl::ResidencyManager::OnDestroy(const handle_t& handle)
+noexcept
+{
+	Free(handle);
+}
+
+void
+gl::ResidencyManager::BeginFrame()
+noexcept
+{
+	++currentFrame;
+}
+
+std::size_t
+gl::ResidencyManager::Enforce()
+noexcept
+{
+	if (not IsOverBudget())
+	{
+		return 0;
+	}
+
+	const std::size_t before = myStatistics.residentBytes;
+
+	// Drop one mip level at a time from the least recently used resources
+	for (bool progressed = true; progressed && IsOverBudget(); )
+	{
+		progressed = false;
+
+		for (allocation_t& allocation : myAllocations)
+		{
+			// Resources touched in this frame are still in use
+			if (allocation.lastUsedFrame == currentFrame)
+			{
+				break;
+			}
+
+			if (not IsEvictable(allocation) || not allocation.isResident || allocation.mipLevels <= allocation.residentMip + 1)
+			{
+				continue;
+			}
+
+			Notify(allocation, residency::EvictAction::DropMip);
+
+			allocation.residentMip++;
+			Account(allocation, residency::ComputeMipChainBytes(allocation.baseBytes, allocation.mipLevels, allocation.residentMip));
+			myStatistics.droppedMips++;
+			progressed = true;
+
+			if (not IsOverBudget())
+			{
+				break;
+			}
+		}
+	}
+
+	// Evict the rest completely
+	for (allocation_t& allocation : myAllocations)
+	{
+		if (not IsOverBudget() || allocation.lastUsedFrame == currentFrame)
+		{
+			break;
+		}
+
+		if (not IsEvictable(allocation) || not allocation.isResident)
+		{
+			continue;
+		}
+
+		Notify(allocation, residency::EvictAction::Evict);
+
+		allocation.isResident = false;
+		allocation.residentMip = allocation.mipLevels;
+		Account(allocation, 0);
+		myStatistics.evictions++;
+	}
+
+	return before - myStatistics.residentBytes;
+}
+
+void
+gl::ResidencyManager::SetBudget(const std::size_t& budget)
+noexcept
+{
+	myStatistics.budget = budget;
+}
+
+void
+gl::ResidencyManager::SetEvictHandler(evict_handler_t handler)
+noexcept
+{
+	onEvict = std::move(handler);
+}
+
+void
+gl::ResidencyManager::ReleaseCpuCopies(const bool& flag)
+noexcept
+{
+	shouldReleaseCpuCopies = flag;
+}
+
+const gl::residency::Allocation*
+gl::ResidencyManager::Find(const handle_t& handle)
+const noexcept
+{
+	if (auto it = myIndices.find(handle); myIndices.cend() != it)
+	{
+		return std::addressof(*(it->second));
+	}
+	else
+	{
+		return nullptr;
+	}
+}
+
+const gl::residency::Statistics&
+gl::ResidencyManager::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+std::size_t
+gl::ResidencyManager::GetBudget()
+const noexcept
+{
+	return myStatistics.budget;
+}
+
+std::size_t
+gl::ResidencyManager::GetResidentBytes()
+const noexcept
+{
+	return myStatistics.residentBytes;
+}
+
+std::uint64_t
+gl::ResidencyManager::GetFrame()
+const noexcept
+{
+	return currentFrame;
+}
+
+bool
+gl::ResidencyManager::IsOverBudget()
+const noexcept
+{
+	return myStatistics.budget < myStatistics.residentBytes;
+}
+
+void
+gl::ResidencyManager::Notify(const allocation_t& allocation, gl::residency::EvictAction action)
+{
+	if (onEvict)
+	{
+		onEvict(allocation, action);
+	}
+}
+
+void
+gl::ResidencyManager::Account(allocation_t& allocation, const std::size_t& new_bytes)
+noexcept
+{
+	myStatistics.residentBytes -= allocation.residentBytes;
+	myStatistics.residentBytes += new_bytes;
+	allocation.residentBytes = new_bytes;
+
+	myStatistics.peakBytes = std::max(myStatistics.peakBytes, myStatistics.residentBytes);
+}
+
+void
+gl::ResidencyManager::Reload(allocation_t& allocation)
+noexcept
+{
+	// The whole mip chain is sampled again before the contents come back, so they can be generated from the first level
+	allocation.isResident = true;
+	allocation.residentMip = 0;
+	Account(allocation, residency::ComputeMipChainBytes(allocation.baseBytes, allocation.mipLevels));
+
+	Notify(allocation, residency::EvictAction::Restore);
+
+	try
+	{
+		allocation.reload();
+		myStatistics.reloads++;
+	}
+	catch (...)
+	{
+		// Drawn with whatever the driver kept
+	}
+}
+
+void
+gl::ResidencyManager::DropCpuCopy(allocation_t& allocation)
+noexcept
+{
+	if (0 < allocation.cpuBytes)
+	{
+		Notify(allocation, residency::EvictAction::ReleaseCpuCopy);
+
+		myStatistics.cpuBytes -= allocation.cpuBytes;
+		myStatistics.releasedCpuCopies++;
+		allocation.cpuBytes = 0;
+	}
+
+	// Nothing is left to upload the contents from
+	allocation.releaseCpuCopy = nullptr;
+	allocation.reload = nullptr;
+}
+
+bool
+gl::ResidencyManager::IsEvictable(const allocation_t& allocation)
+noexcept
+{
+	// Simulated allocations have no contents to lose
+	return 0 == allocation.object || static_cast<bool>(allocation.reload);
+}
+
+void
+gl::residency::ApplyEviction(const gl::residency::Allocation& allocation, gl::residency::EvictAction action)
+noexcept
+{
+	// The copy belongs to the owner of the resource, not to opengl
+	if (EvictAction::ReleaseCpuCopy == action)
+	{
+		if (allocation.releaseCpuCopy)
+		{
+			allocation.releaseCpuCopy();
+		}
+
+		return;
+	}
+
+	if (0 == allocation.object)
+	{
+		return;
+	}
+
+	switch (action)
+	{
+		case EvictAction::DropMip:
+		{
+			if (ResourceKind::Texture == allocation.kind)
+			{
+				::glTextureParameteri(allocation.object, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(allocation.residentMip + 1));
+				::glInvalidateTexImage(allocation.object, static_cast<GLint>(allocation.residentMip));
+			}
+		}
+		break;
+
+		case EvictAction::Evict:
+		{
+			if (ResourceKind::Texture == allocation.kind)
+			{
+				for (std::uint32_t level = allocation.residentMip; level < allocation.mipLevels; ++level)
+				{
+					::glInvalidateTexImage(allocation.object, static_cast<GLint>(level));
+				}
+			}
+			else if (ResourceKind::Buffer == allocation.kind)
+			{
+				::glInvalidateBufferData(allocation.object);
+			}
+		}
+		break;
+
+		case EvictAction::Restore:
+		{
+			if (ResourceKind::Texture == allocation.kind)
+			{
+				::glTextureParameteri(allocation.object, GL_TEXTURE_BASE_LEVEL, 0);
+			}
+		}
+		break;
+
+		default:
+		break;
+	}
+}
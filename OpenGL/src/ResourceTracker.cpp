@@ -0,0 +1,21 @@
+module Glib.ResourceTracker;
+import <atomic>;
+
+namespace
+{
+	constinit std::atomic<gl::residency::Tracker*> currentTracker = nullptr;
+}
+
+void
+gl::residency::SetTracker(gl::residency::Tracker* tracker)
+noexcept
+{
+	currentTracker.store(tracker, std::memory_order_release);
+}
+
+gl::residency::Tracker*
+gl::residency::GetTracker()
+noexcept
+{
+	return currentTracker.load(std::memory_order_acquire);
+}
@@ -0,0 +1,906 @@
+module Glib.SceneIndex;
+import <cmath>;
+import <algorithm>;
+import <numeric>;
+import <array>;
+import <chrono>;
+import <random>;
+import Glib.Parallel;
+
+namespace
+{
+	using gl::scene::BoundingBox;
+	using gl::scene::Frustum;
+	using gl::scene::Node;
+
+	struct BuildContext
+	{
+		const BoundingBox* bounds;
+		const std::array<float, 3>* centroids;
+		std::uint32_t* objects;
+	};
+
+	// A node whose objects are still to be split
+	struct BuildRange
+	{
+		std::uint32_t node;
+		std::uint32_t first;
+		std::uint32_t count;
+		std::uint32_t depth;
+	};
+
+	struct SplitBin
+	{
+		BoundingBox bounds;
+		std::uint32_t count;
+	};
+
+	[[nodiscard]]
+	constexpr BoundingBox
+	MakeEmptyBox()
+	noexcept
+	{
+		constexpr float huge = std::numeric_limits<float>::max();
+
+		return BoundingBox{ { huge, huge, huge }, { -huge, -huge, -huge } };
+	}
+
+	constexpr void
+	Grow(BoundingBox& box, const float(&min)[3], const float(&max)[3])
+	noexcept
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			box.min[axis] = std::min(box.min[axis], min[axis]);
+			box.max[axis] = std::max(box.max[axis], max[axis]);
+		}
+	}
+
+	[[nodiscard]]
+	constexpr float
+	GetSurfaceArea(const BoundingBox& box)
+	noexcept
+	{
+		const float dx = std::max(box.max[0] - box.min[0], 0.0f);
+		const float dy = std::max(box.max[1] - box.min[1], 0.0f);
+		const float dz = std::max(box.max[2] - box.min[2], 0.0f);
+
+		return 2 * (dx * dy + dy * dz + dz * dx);
+	}
+
+	[[nodiscard]]
+	Node
+	MakeNode(const BuildContext& context, std::uint32_t first, std::uint32_t count)
+	noexcept
+	{
+		BoundingBox box = MakeEmptyBox();
+		for (std::uint32_t i = first; i < first + count; ++i)
+		{
+			const BoundingBox& object = context.bounds[context.objects[i]];
+			Grow(box, object.min, object.max);
+		}
+
+		return Node{ { box.min[0], box.min[1], box.min[2] }, first, { box.max[0], box.max[1], box.max[2] }, count };
+	}
+
+	/// <summary>
+	/// Partition the objects of a range by the cheapest binned split, and give the bounds of both sides
+	/// </summary>
+	/// <returns>Number of objects going to the first child</returns>
+	[[nodiscard]]
+	std::uint32_t
+	Split(const BuildContext& context, std::uint32_t first, std::uint32_t count, BoundingBox& left_bounds, BoundingBox& right_bounds)
+	noexcept
+	{
+		using gl::scene::SplitBins;
+
+		std::uint32_t* const objects = context.objects + first;
+
+		float centre_min[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+		float centre_max[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			const std::array<float, 3>& centre = context.centroids[objects[i]];
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				centre_min[axis] = std::min(centre_min[axis], centre[axis]);
+				centre_max[axis] = std::max(centre_max[axis], centre[axis]);
+			}
+		}
+
+		float scale[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float extent = centre_max[axis] - centre_min[axis];
+			scale[axis] = 0 < extent ? SplitBins / extent : 0;
+		}
+
+		const auto get_bin = [&](std::uint32_t object, int axis) noexcept {
+			return std::min(SplitBins - 1, static_cast<std::uint32_t>((context.centroids[object][axis] - centre_min[axis]) * scale[axis]));
+		};
+
+		// Every axis is binned in the same pass over the objects
+		std::array<std::array<SplitBin, SplitBins>, 3> bins;
+		for (auto& axis_bins : bins)
+		{
+			axis_bins.fill(SplitBin{ MakeEmptyBox(), 0 });
+		}
+
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			const std::uint32_t object = objects[i];
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				SplitBin& bin = bins[axis][get_bin(object, axis)];
+
+				Grow(bin.bounds, context.bounds[object].min, context.bounds[object].max);
+				++bin.count;
+			}
+		}
+
+		float best_cost = std::numeric_limits<float>::infinity();
+		int best_axis = -1;
+		std::uint32_t best_split = 0;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (0 == scale[axis])
+			{
+				continue;
+			}
+
+			// Costs of the objects left of each plane, then sweep back from the right
+			std::array<float, SplitBins - 1> left_costs;
+			BoundingBox left = MakeEmptyBox();
+			std::uint32_t left_count = 0;
+
+			for (std::uint32_t plane = 0; plane + 1 < SplitBins; ++plane)
+			{
+				Grow(left, bins[axis][plane].bounds.min, bins[axis][plane].bounds.max);
+				left_count += bins[axis][plane].count;
+				left_costs[plane] = static_cast<float>(left_count) * GetSurfaceArea(left);
+			}
+
+			BoundingBox right = MakeEmptyBox();
+			std::uint32_t right_count = 0;
+
+			for (std::uint32_t plane = SplitBins - 1; 0 < plane; --plane)
+			{
+				Grow(right, bins[axis][plane].bounds.min, bins[axis][plane].bounds.max);
+				right_count += bins[axis][plane].count;
+
+				if (0 == right_count || count == right_count)
+				{
+					continue;
+				}
+
+				const float cost = left_costs[plane - 1] + static_cast<float>(right_count) * GetSurfaceArea(right);
+				if (cost < best_cost)
+				{
+					best_cost = cost;
+					best_axis = axis;
+					best_split = plane;
+				}
+			}
+		}
+
+		// Every centroid is at the same place, so any half will do
+		if (best_axis < 0)
+		{
+			const std::uint32_t middle = count / 2;
+			const Node left = MakeNode(context, first, middle), right = MakeNode(context, first + middle, count - middle);
+
+			left_bounds = BoundingBox{ { left.min[0], left.min[1], left.min[2] }, { left.max[0], left.max[1], left.max[2] } };
+			right_bounds = BoundingBox{ { right.min[0], right.min[1], right.min[2] }, { right.max[0], right.max[1], right.max[2] } };
+
+			return middle;
+		}
+
+		left_bounds = MakeEmptyBox();
+		right_bounds = MakeEmptyBox();
+
+		for (std::uint32_t plane = 0; plane < SplitBins; ++plane)
+		{
+			const SplitBin& bin = bins[best_axis][plane];
+			Grow(plane < best_split ? left_bounds : right_bounds, bin.bounds.min, bin.bounds.max);
+		}
+
+		return static_cast<std::uint32_t>(std::partition(objects, objects + count, [&](std::uint32_t object) noexcept {
+			return get_bin(object, best_axis) < best_split;
+		}) - objects);
+	}
+
+	[[nodiscard]]
+	constexpr Node
+	MakeNode(const BoundingBox& box, std::uint32_t first, std::uint32_t count)
+	noexcept
+	{
+		return Node{ { box.min[0], box.min[1], box.min[2] }, first, { box.max[0], box.max[1], box.max[2] }, count };
+	}
+
+	/// <summary>
+	/// Split the nodes down to the leaves, ranges of at most defer_below objects go to the tasks instead when there are any
+	/// </summary>
+	/// <returns>Depth of the deepest node</returns>
+	std::uint32_t
+	BuildNodes(const BuildContext& context, std::vector<Node>& nodes, BuildRange root, std::uint32_t defer_below, std::vector<BuildRange>* tasks)
+	{
+		std::uint32_t depth = 0;
+
+		std::vector<BuildRange> stack{ root };
+		while (not stack.empty())
+		{
+			const BuildRange range = stack.back();
+			stack.pop_back();
+
+			depth = std::max(depth, range.depth);
+
+			if (range.count <= gl::scene::MaxLeafSize)
+			{
+				continue;
+			}
+
+			if (nullptr != tasks && range.count <= defer_below)
+			{
+				tasks->push_back(range);
+				continue;
+			}
+
+			BoundingBox left_bounds, right_bounds;
+			const std::uint32_t middle = Split(context, range.first, range.count, left_bounds, right_bounds);
+			const std::uint32_t left = static_cast<std::uint32_t>(nodes.size());
+
+			nodes.push_back(MakeNode(left_bounds, range.first, middle));
+			nodes.push_back(MakeNode(right_bounds, range.first + middle, range.count - middle));
+
+			nodes[range.node].first = left;
+			nodes[range.node].count = 0;
+
+			// The first child is split first, so its subtree is stored next to it
+			stack.push_back(BuildRange{ left + 1, range.first + middle, range.count - middle, range.depth + 1 });
+			stack.push_back(BuildRange{ left, range.first, middle, range.depth + 1 });
+		}
+
+		return depth;
+	}
+
+	[[nodiscard]]
+	bool
+	Overlaps(const float(&min)[3], const float(&max)[3], const BoundingBox& box)
+	noexcept
+	{
+		return min[0] <= box.max[0] && box.min[0] <= max[0]
+			&& min[1] <= box.max[1] && box.min[1] <= max[1]
+			&& min[2] <= box.max[2] && box.min[2] <= max[2];
+	}
+
+	[[nodiscard]]
+	bool
+	Contains(const BoundingBox& box, const float(&min)[3], const float(&max)[3])
+	noexcept
+	{
+		return box.min[0] <= min[0] && max[0] <= box.max[0]
+			&& box.min[1] <= min[1] && max[1] <= box.max[1]
+			&& box.min[2] <= min[2] && max[2] <= box.max[2];
+	}
+
+	enum class FrustumTest
+	{
+		Outside, Intersecting, Inside
+	};
+
+	[[nodiscard]]
+	FrustumTest
+	TestFrustum(const Frustum& frustum, const float(&min)[3], const float(&max)[3])
+	noexcept
+	{
+		const float centre[3] = { (min[0] + max[0]) * 0.5f, (min[1] + max[1]) * 0.5f, (min[2] + max[2]) * 0.5f };
+		const float extent[3] = { (max[0] - min[0]) * 0.5f, (max[1] - min[1]) * 0.5f, (max[2] - min[2]) * 0.5f };
+
+		FrustumTest result = FrustumTest::Inside;
+		for (const auto& plane : frustum.planes)
+		{
+			const float distance = plane[0] * centre[0] + plane[1] * centre[1] + plane[2] * centre[2] + plane[3];
+			const float radius = std::abs(plane[0]) * extent[0] + std::abs(plane[1]) * extent[1] + std::abs(plane[2]) * extent[2];
+
+			if (distance + radius < 0)
+			{
+				return FrustumTest::Outside;
+			}
+			else if (distance - radius < 0)
+			{
+				result = FrustumTest::Intersecting;
+			}
+		}
+
+		return result;
+	}
+
+	/// <summary>
+	/// Distance along the ray where it enters the box, infinity on a miss
+	/// </summary>
+	[[nodiscard]]
+	float
+	IntersectRay(const float(&origin)[3], const float(&inverse)[3], float limit, const float(&min)[3], const float(&max)[3])
+	noexcept
+	{
+		float near_distance = 0, far_distance = limit;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float t0 = (min[axis] - origin[axis]) * inverse[axis];
+			const float t1 = (max[axis] - origin[axis]) * inverse[axis];
+
+			// A zero times infinity is NaN, which leaves the distances as they are
+			near_distance = std::max(near_distance, std::min(t0, t1));
+			far_distance = std::min(far_distance, std::max(t0, t1));
+		}
+
+		return near_distance <= far_distance ? near_distance : std::numeric_limits<float>::infinity();
+	}
+
+	/// <summary>
+	/// Small traversal stack, which only goes to the heap for unusually deep hierarchies
+	/// </summary>
+	class TraversalStack
+	{
+	public:
+		explicit TraversalStack(std::uint32_t depth)
+		{
+			if (std::size(myLocal) <= depth + 1)
+			{
+				myHeap.resize(static_cast<std::size_t>(depth) + 2);
+				myData = myHeap.data();
+			}
+		}
+
+		void Push(std::uint32_t node) noexcept
+		{
+			myData[mySize++] = node;
+		}
+
+		[[nodiscard]]
+		std::uint32_t Pop() noexcept
+		{
+			return myData[--mySize];
+		}
+
+		[[nodiscard]]
+		bool IsEmpty() const noexcept
+		{
+			return 0 == mySize;
+		}
+
+	private:
+		std::uint32_t myLocal[64];
+		std::vector<std::uint32_t> myHeap{};
+		std::uint32_t* myData = myLocal;
+		std::uint32_t mySize = 0;
+	};
+
+	/// <summary>
+	/// Range of objects under a node, which are stored together since the build partitions them in place
+	/// </summary>
+	void
+	AppendSubtree(std::span<const Node> nodes, std::span<const std::uint32_t> objects, std::uint32_t index, std::vector<std::uint32_t>& result)
+	{
+		std::uint32_t leftmost = index, rightmost = index;
+
+		while (0 == nodes[leftmost].count)
+		{
+			leftmost = nodes[leftmost].first;
+		}
+
+		while (0 == nodes[rightmost].count)
+		{
+			rightmost = nodes[rightmost].first + 1;
+		}
+
+		const std::uint32_t first = nodes[leftmost].first;
+		const std::uint32_t last = nodes[rightmost].first + nodes[rightmost].count;
+
+		result.insert(result.end(), objects.begin() + first, objects.begin() + last);
+	}
+}
+
+gl::SceneIndex::SceneIndex()
+noexcept
+{}
+
+gl::SceneIndex::~SceneIndex()
+noexcept
+{}
+
+void
+gl::SceneIndex::Build(std::span<const gl::scene::BoundingBox> bounds, std::uint32_t threads)
+{
+	Clear();
+
+	if (bounds.empty())
+	{
+		return;
+	}
+
+	const std::uint32_t count = static_cast<std::uint32_t>(bounds.size());
+	const std::uint32_t workers = GetWorkerCount(threads);
+
+	myBounds.assign(bounds.begin(), bounds.end());
+	myObjects.resize(count);
+	std::iota(myObjects.begin(), myObjects.end(), 0U);
+
+	std::vector<std::array<float, 3>> centroids(count);
+	for (std::uint32_t i = 0; i < count; ++i)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			centroids[i][axis] = (myBounds[i].min[axis] + myBounds[i].max[axis]) * 0.5f;
+		}
+	}
+
+	const BuildContext context{ myBounds.data(), centroids.data(), myObjects.data() };
+
+	myNodes.reserve(static_cast<std::size_t>(count) * 2);
+	myNodes.push_back(MakeNode(context, 0, count));
+
+	// The top of the tree is split here until there are enough subtrees to keep every worker busy
+	const std::uint32_t defer_below = 1 < workers ? std::max(count / (workers * 8), 1024U) : 0;
+
+	std::vector<BuildRange> tasks{};
+	myDepth = BuildNodes(context, myNodes, BuildRange{ 0, 0, count, 0 }, defer_below, 1 < workers ? &tasks : nullptr);
+
+	if (tasks.empty())
+	{
+		return;
+	}
+
+	std::vector<std::vector<Node>> subtrees(tasks.size());
+	std::vector<std::uint32_t> depths(tasks.size());
+
+	ParallelFor(workers, static_cast<std::uint32_t>(tasks.size()), [&](std::uint32_t task, std::uint32_t) {
+		const BuildRange& range = tasks[task];
+
+		std::vector<Node>& subtree = subtrees[task];
+		subtree.reserve(static_cast<std::size_t>(range.count) * 2);
+		subtree.push_back(myNodes[range.node]);
+
+		depths[task] = BuildNodes(context, subtree, BuildRange{ 0, range.first, range.count, range.depth }, 0, nullptr);
+	});
+
+	// Splice the subtrees after the top of the tree, their roots replace the placeholders
+	for (std::size_t task = 0; task < tasks.size(); ++task)
+	{
+		std::vector<Node>& subtree = subtrees[task];
+		const std::uint32_t offset = static_cast<std::uint32_t>(myNodes.size());
+
+		for (Node& node : subtree)
+		{
+			if (0 == node.count)
+			{
+				node.first = offset + node.first - 1;
+			}
+		}
+
+		myNodes[tasks[task].node] = subtree.front();
+		myNodes.insert(myNodes.end(), subtree.begin() + 1, subtree.end());
+
+		myDepth = std::max(myDepth, depths[task]);
+	}
+}
+
+void
+gl::SceneIndex::Clear()
+noexcept
+{
+	myNodes.clear();
+	myObjects.clear();
+	myBounds.clear();
+	myDepth = 0;
+}
+
+void
+gl::SceneIndex::Update(std::uint32_t object, const gl::scene::BoundingBox& bounds)
+noexcept
+{
+	if (object < myBounds.size())
+	{
+		myBounds[object] = bounds;
+	}
+}
+
+void
+gl::SceneIndex::Refit()
+noexcept
+{
+	// Children always come after their parent
+	for (std::size_t i = myNodes.size(); 0 < i; --i)
+	{
+		Node& node = myNodes[i - 1];
+		BoundingBox box = MakeEmptyBox();
+
+		if (0 == node.count)
+		{
+			Grow(box, myNodes[node.first].min, myNodes[node.first].max);
+			Grow(box, myNodes[node.first + 1].min, myNodes[node.first + 1].max);
+		}
+		else
+		{
+			for (std::uint32_t k = node.first; k < node.first + node.count; ++k)
+			{
+				Grow(box, myBounds[myObjects[k]].min, myBounds[myObjects[k]].max);
+			}
+		}
+
+		std::copy_n(box.min, 3, node.min);
+		std::copy_n(box.max, 3, node.max);
+	}
+}
+
+void
+gl::SceneIndex::QueryFrustum(const gl::scene::Frustum& frustum, std::vector<std::uint32_t>& result)
+const
+{
+	if (myNodes.empty())
+	{
+		return;
+	}
+
+	TraversalStack stack{ myDepth };
+	stack.Push(0);
+
+	while (not stack.IsEmpty())
+	{
+		const std::uint32_t index = stack.Pop();
+		const Node& node = myNodes[index];
+
+		const FrustumTest test = TestFrustum(frustum, node.min, node.max);
+		if (FrustumTest::Outside == test)
+		{
+			continue;
+		}
+		else if (FrustumTest::Inside == test)
+		{
+			AppendSubtree(myNodes, myObjects, index, result);
+		}
+		else if (0 == node.count)
+		{
+			stack.Push(node.first + 1);
+			stack.Push(node.first);
+		}
+		else
+		{
+			for (std::uint32_t k = node.first; k < node.first + node.count; ++k)
+			{
+				const BoundingBox& box = myBounds[myObjects[k]];
+
+				if (FrustumTest::Outside != TestFrustum(frustum, box.min, box.max))
+				{
+					result.push_back(myObjects[k]);
+				}
+			}
+		}
+	}
+}
+
+void
+gl::SceneIndex::QueryBox(const gl::scene::BoundingBox& box, std::vector<std::uint32_t>& result)
+const
+{
+	if (myNodes.empty())
+	{
+		return;
+	}
+
+	TraversalStack stack{ myDepth };
+	stack.Push(0);
+
+	while (not stack.IsEmpty())
+	{
+		const std::uint32_t index = stack.Pop();
+		const Node& node = myNodes[index];
+
+		if (not Overlaps(node.min, node.max, box))
+		{
+			continue;
+		}
+		else if (Contains(box, node.min, node.max))
+		{
+			AppendSubtree(myNodes, myObjects, index, result);
+		}
+		else if (0 == node.count)
+		{
+			stack.Push(node.first + 1);
+			stack.Push(node.first);
+		}
+		else
+		{
+			for (std::uint32_t k = node.first; k < node.first + node.count; ++k)
+			{
+				const BoundingBox& object = myBounds[myObjects[k]];
+
+				if (Overlaps(object.min, object.max, box))
+				{
+					result.push_back(myObjects[k]);
+				}
+			}
+		}
+	}
+}
+
+gl::scene::RayHit
+gl::SceneIndex::Raycast(const gl::scene::Ray& ray)
+const
+{
+	scene::RayHit result{};
+
+	if (myNodes.empty())
+	{
+		return result;
+	}
+
+	const float inverse[3] = { 1 / ray.direction[0], 1 / ray.direction[1], 1 / ray.direction[2] };
+	float limit = ray.maxDistance;
+
+	TraversalStack stack{ myDepth };
+	stack.Push(0);
+
+	while (not stack.IsEmpty())
+	{
+		const Node& node = myNodes[stack.Pop()];
+
+		// Missed, or pushed before a nearer hit was found, as the limit is the nearest hit so far
+		if (std::isinf(IntersectRay(ray.origin, inverse, limit, node.min, node.max)))
+		{
+			continue;
+		}
+
+		if (0 != node.count)
+		{
+			for (std::uint32_t k = node.first; k < node.first + node.count; ++k)
+			{
+				const BoundingBox& box = myBounds[myObjects[k]];
+				const float distance = IntersectRay(ray.origin, inverse, limit, box.min, box.max);
+
+				if (distance < result.distance)
+				{
+					result = scene::RayHit{ myObjects[k], distance };
+					limit = distance;
+				}
+			}
+
+			continue;
+		}
+
+		std::uint32_t near_child = node.first, far_child = node.first + 1;
+		float near_distance = IntersectRay(ray.origin, inverse, limit, myNodes[near_child].min, myNodes[near_child].max);
+		float far_distance = IntersectRay(ray.origin, inverse, limit, myNodes[far_child].min, myNodes[far_child].max);
+
+		if (far_distance < near_distance)
+		{
+			std::swap(near_child, far_child);
+			std::swap(near_distance, far_distance);
+		}
+
+		// The nearer child goes on top, so it is visited first
+		if (not std::isinf(far_distance))
+		{
+			stack.Push(far_child);
+		}
+
+		if (not std::isinf(near_distance))
+		{
+			stack.Push(near_child);
+		}
+	}
+
+	return result;
+}
+
+void
+gl::SceneIndex::QueryFrustums(std::span<const gl::scene::Frustum> frustums, std::vector<std::vector<std::uint32_t>>& results, std::uint32_t threads)
+const
+{
+	results.resize(frustums.size());
+
+	ParallelFor(GetWorkerCount(threads), static_cast<std::uint32_t>(frustums.size()), [&](std::uint32_t query, std::uint32_t) {
+		results[query].clear();
+		QueryFrustum(frustums[query], results[query]);
+	});
+}
+
+void
+gl::SceneIndex::QueryBoxes(std::span<const gl::scene::BoundingBox> boxes, std::vector<std::vector<std::uint32_t>>& results, std::uint32_t threads)
+const
+{
+	results.resize(boxes.size());
+
+	ParallelFor(GetWorkerCount(threads), static_cast<std::uint32_t>(boxes.size()), [&](std::uint32_t query, std::uint32_t) {
+		results[query].clear();
+		QueryBox(boxes[query], results[query]);
+	});
+}
+
+void
+gl::SceneIndex::Raycast(std::span<const gl::scene::Ray> rays, std::span<gl::scene::RayHit> hits, std::uint32_t threads)
+const
+{
+	const std::uint32_t count = static_cast<std::uint32_t>(std::min(rays.size(), hits.size()));
+
+	// Rays are cheap, so each task takes a run of them
+	constexpr std::uint32_t run = 64;
+
+	ParallelFor(GetWorkerCount(threads), (count + run - 1) / run, [&](std::uint32_t task, std::uint32_t) {
+		for (std::uint32_t i = task * run; i < std::min(count, task * run + run); ++i)
+		{
+			hits[i] = Raycast(rays[i]);
+		}
+	});
+}
+
+const gl::scene::BoundingBox&
+gl::SceneIndex::GetBounds(std::uint32_t object)
+const noexcept
+{
+	return myBounds[object];
+}
+
+std::span<const gl::scene::Node>
+gl::SceneIndex::GetNodes()
+const noexcept
+{
+	return myNodes;
+}
+
+std::span<const std::uint32_t>
+gl::SceneIndex::GetObjects()
+const noexcept
+{
+	return myObjects;
+}
+
+std::size_t
+gl::SceneIndex::GetObjectCount()
+const noexcept
+{
+	return myBounds.size();
+}
+
+std::size_t
+gl::SceneIndex::GetNodeCount()
+const noexcept
+{
+	return myNodes.size();
+}
+
+std::uint32_t
+gl::SceneIndex::GetDepth()
+const noexcept
+{
+	return myDepth;
+}
+
+bool
+gl::SceneIndex::IsEmpty()
+const noexcept
+{
+	return myNodes.empty();
+}
+
+gl::scene::Benchmark
+gl::scene::MeasureSceneIndex(std::size_t objects, std::size_t queries, std::uint32_t threads)
+{
+	using clock = std::chrono::steady_clock;
+	using seconds = std::chrono::duration<double>;
+
+	std::mt19937 engine{ 0x5EED };
+	std::uniform_real_distribution<float> position{ -1000.0f, 1000.0f };
+	std::uniform_real_distribution<float> size{ 0.5f, 4.0f };
+	std::uniform_real_distribution<float> direction{ -1.0f, 1.0f };
+	std::uniform_real_distribution<float> jitter{ -1.0f, 1.0f };
+
+	std::vector<BoundingBox> bounds(objects);
+	for (BoundingBox& box : bounds)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float centre = position(engine), extent = size(engine);
+
+			box.min[axis] = centre - extent;
+			box.max[axis] = centre + extent;
+		}
+	}
+
+	Benchmark result{};
+	result.objects = objects;
+	result.threads = GetWorkerCount(threads);
+
+	SceneIndex index{};
+
+	auto start = clock::now();
+	index.Build(bounds, threads);
+	result.buildSeconds = seconds{ clock::now() - start }.count();
+
+	// Every object moves a little
+	for (std::uint32_t i = 0; i < objects; ++i)
+	{
+		BoundingBox box = bounds[i];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float offset = jitter(engine);
+
+			box.min[axis] += offset;
+			box.max[axis] += offset;
+		}
+
+		index.Update(i, box);
+	}
+
+	start = clock::now();
+	index.Refit();
+	result.refitSeconds = seconds{ clock::now() - start }.count();
+
+	if (0 == queries)
+	{
+		return result;
+	}
+
+	// Narrow perspective views from random places, looking down -z
+	std::vector<Frustum> frustums(queries);
+	for (Frustum& frustum : frustums)
+	{
+		const float x = position(engine), y = position(engine), z = position(engine);
+		const float near_plane = 1.0f, far_plane = 300.0f;
+
+		// Perspective of 90 degrees times a translation by -(x, y, z)
+		const float a = -(far_plane + near_plane) / (far_plane - near_plane), b = -2 * far_plane * near_plane / (far_plane - near_plane);
+		const float matrix[16] =
+		{
+			1, 0, 0, 0,
+			0, 1, 0, 0,
+			0, 0, a, -1,
+			-x, -y, -a * z + b, z,
+		};
+
+		frustum = Frustum::FromMatrix(matrix);
+	}
+
+	std::vector<BoundingBox> boxes(queries);
+	for (BoundingBox& box : boxes)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float centre = position(engine);
+
+			box.min[axis] = centre - 25.0f;
+			box.max[axis] = centre + 25.0f;
+		}
+	}
+
+	std::vector<Ray> rays(queries);
+	for (Ray& ray : rays)
+	{
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			ray.origin[axis] = position(engine);
+			ray.direction[axis] = direction(engine);
+		}
+	}
+
+	std::vector<std::vector<std::uint32_t>> results{};
+	std::vector<RayHit> hits(queries);
+
+	start = clock::now();
+	index.QueryFrustums(frustums, results, threads);
+	result.frustumQueriesPerSecond = static_cast<double>(queries) / seconds{ clock::now() - start }.count();
+
+	start = clock::now();
+	index.QueryBoxes(boxes, results, threads);
+	result.boxQueriesPerSecond = static_cast<double>(queries) / seconds{ clock::now() - start }.count();
+
+	start = clock::now();
+	index.Raycast(rays, hits, threads);
+	result.rayQueriesPerSecond = static_cast<double>(queries) / seconds{ clock::now() - start }.count();
+
+	return result;
+}
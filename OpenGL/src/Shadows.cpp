@@ -0,0 +1,616 @@
+module;
+#define NOMINMAX
+#include <Windows.h>
+#include "glew.h"
+#include <gl\gl.h>
+module Glib.Shadows;
+import <algorithm>;
+import <cmath>;
+import <bit>;
+import <utility>;
+
+namespace
+{
+	using Vector = std::array<float, 3>;
+
+	[[nodiscard]]
+	constexpr float
+	Dot(const Vector& lhs, const Vector& rhs)
+	noexcept
+	{
+		return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+	}
+
+	[[nodiscard]]
+	constexpr Vector
+	Cross(const Vector& lhs, const Vector& rhs)
+	noexcept
+	{
+		return { lhs[1] * rhs[2] - lhs[2] * rhs[1], lhs[2] * rhs[0] - lhs[0] * rhs[2], lhs[0] * rhs[1] - lhs[1] * rhs[0] };
+	}
+
+	[[nodiscard]]
+	Vector
+	Normalize(const Vector& vector)
+	noexcept
+	{
+		const float length = std::sqrt(Dot(vector, vector));
+		if (length <= 0)
+		{
+			return { 0.0f, 0.0f, -1.0f };
+		}
+
+		return { vector[0] / length, vector[1] / length, vector[2] / length };
+	}
+
+	void
+	SetCapability(GLenum capability, GLboolean enabled)
+	noexcept
+	{
+		if (GL_FALSE != enabled)
+		{
+			::glEnable(capability);
+		}
+		else
+		{
+			::glDisable(capability);
+		}
+	}
+}
+
+std::array<float, gl::shadow::MaxCascades + 1>
+gl::shadow::ComputeSplits(float near_plane, float far_plane, std::uint32_t count, float lambda)
+noexcept
+{
+	count = std::clamp(count, 1U, MaxCascades);
+	lambda = std::clamp(lambda, 0.0f, 1.0f);
+
+	std::array<float, MaxCascades + 1> result{};
+	result.fill(far_plane);
+	result[0] = near_plane;
+
+	for (std::uint32_t i = 1; i < count; ++i)
+	{
+		const float fraction = static_cast<float>(i) / static_cast<float>(count);
+		const float logarithmic = near_plane * std::pow(far_plane / near_plane, fraction);
+		const float uniform = near_plane + (far_plane - near_plane) * fraction;
+
+		result[i] = lambda * logarithmic + (1.0f - lambda) * uniform;
+	}
+
+	return result;
+}
+
+gl::shadow::Cascade
+gl::shadow::ComputeCascade(const float(&view)[16], float vertical_fov, float aspect, float near_depth, float far_depth, const float(&light_direction)[3], std::uint32_t resolution, float caster_distance)
+noexcept
+{
+	// Smallest sphere around the slice, its centre is on the view axis
+	const float tangent_y = std::tan(vertical_fov * 0.5f);
+	const float tangent_x = tangent_y * aspect;
+	const float spread = tangent_x * tangent_x + tangent_y * tangent_y;
+
+	const float centre_depth = std::min((far_depth + near_depth) * (1.0f + spread) * 0.5f, far_depth);
+	const float gap = far_depth - centre_depth;
+	float radius = std::sqrt(gap * gap + far_depth * far_depth * spread);
+	// A radius which keeps changing by rounding errors would resize the texels
+	radius = std::ceil(radius * 16.0f) / 16.0f;
+
+	// Back to world space by the transposed rotation of the view matrix
+	const Vector view_centre{ -view[12], -view[13], -view[14] - centre_depth };
+	const Vector centre{
+		view[0] * view_centre[0] + view[1] * view_centre[1] + view[2] * view_centre[2],
+		view[4] * view_centre[0] + view[5] * view_centre[1] + view[6] * view_centre[2],
+		view[8] * view_centre[0] + view[9] * view_centre[1] + view[10] * view_centre[2]
+	};
+
+	// The basis of the light only depends on its direction
+	const Vector forward = Normalize({ light_direction[0], light_direction[1], light_direction[2] });
+	const Vector reference = std::abs(forward[1]) < 0.99f ? Vector{ 0.0f, 1.0f, 0.0f } : Vector{ 1.0f, 0.0f, 0.0f };
+	const Vector right = Normalize(Cross(forward, reference));
+	const Vector up = Cross(right, forward);
+
+	const float texel = 2.0f * radius / static_cast<float>(std::max(resolution, 1U));
+
+	// Moving the projection by whole texels keeps the rasterization of the casters the same
+	const float x = std::floor(Dot(centre, right) / texel) * texel;
+	const float y = std::floor(Dot(centre, up) / texel) * texel;
+	const float z = -Dot(centre, forward);
+
+	const float left = x - radius, rightmost = x + radius;
+	const float bottom = y - radius, top = y + radius;
+	const float near_distance = -(z + radius + std::max(caster_distance, 0.0f));
+	const float far_distance = -(z - radius);
+
+	Cascade result{};
+
+	// Orthographic projection times the rotation into the light, column major
+	const float sx = 2.0f / (rightmost - left);
+	const float sy = 2.0f / (top - bottom);
+	const float sz = -2.0f / (far_distance - near_distance);
+
+	for (std::uint32_t column = 0; column < 3; ++column)
+	{
+		result.viewProjection[column * 4 + 0] = sx * right[column];
+		result.viewProjection[column * 4 + 1] = sy * up[column];
+		result.viewProjection[column * 4 + 2] = -sz * forward[column];
+		result.viewProjection[column * 4 + 3] = 0;
+	}
+
+	result.viewProjection[12] = -(rightmost + left) / (rightmost - left);
+	result.viewProjection[13] = -(top + bottom) / (top - bottom);
+	result.viewProjection[14] = -(far_distance + near_distance) / (far_distance - near_distance);
+	result.viewProjection[15] = 1;
+
+	result.atlasTransform[0] = 1;
+	result.atlasTransform[1] = 1;
+	result.atlasTransform[2] = 0;
+	result.atlasTransform[3] = 0;
+	result.nearDepth = near_depth;
+	result.farDepth = far_depth;
+	result.texelSize = texel;
+
+	return result;
+}
+
+gl::ShadowAtlas::ShadowAtlas(std::uint32_t size, std::uint32_t min_tile)
+	: mySize(std::bit_ceil(std::max(size, 1U)))
+	, myLevelCount(1)
+{
+	min_tile = std::min(std::bit_ceil(std::max(min_tile, 1U)), mySize);
+	while ((mySize >> myLevelCount) >= min_tile)
+	{
+		++myLevelCount;
+	}
+
+	Clear();
+}
+
+gl::ShadowAtlas::~ShadowAtlas()
+noexcept
+{
+	Destroy();
+}
+
+std::optional<gl::shadow::Tile>
+gl::ShadowAtlas::Allocate(std::uint32_t size)
+{
+	if (0 == size || mySize < size)
+	{
+		return std::nullopt;
+	}
+
+	const std::uint32_t level = GetLevel(size);
+
+	// The smallest free tile which is big enough
+	std::uint32_t source = level + 1;
+	while (0 < source && myFreeTiles[source - 1].empty())
+	{
+		--source;
+	}
+
+	if (0 == source)
+	{
+		return std::nullopt;
+	}
+
+	std::array<std::uint32_t, 2> tile = myFreeTiles[--source].back();
+	myFreeTiles[source].pop_back();
+
+	// Split it down to the level, keeping the first quadrant each time
+	for (; source < level; ++source)
+	{
+		const std::uint32_t half = mySize >> (source + 1);
+
+		myFreeTiles[source + 1].push_back({ tile[0] + half, tile[1] + half });
+		myFreeTiles[source + 1].push_back({ tile[0], tile[1] + half });
+		myFreeTiles[source + 1].push_back({ tile[0] + half, tile[1] });
+	}
+
+	const std::uint32_t tile_size = mySize >> level;
+	myFreeArea -= static_cast<std::uint64_t>(tile_size) * tile_size;
+
+	return shadow::Tile{ tile[0], tile[1], tile_size };
+}
+
+void
+gl::ShadowAtlas::Free(const gl::shadow::Tile& tile)
+{
+	if (0 == tile.size)
+	{
+		return;
+	}
+
+	std::uint32_t level = GetLevel(tile.size);
+	std::array<std::uint32_t, 2> position{ tile.x, tile.y };
+
+	myFreeArea += static_cast<std::uint64_t>(tile.size) * tile.size;
+
+	while (0 < level)
+	{
+		const std::uint32_t size = mySize >> level;
+		const std::uint32_t px = position[0] & ~(2 * size - 1);
+		const std::uint32_t py = position[1] & ~(2 * size - 1);
+
+		// Every other quadrant of the parent has to be free to merge
+		std::vector<std::array<std::uint32_t, 2>>& tiles = myFreeTiles[level];
+		std::array<std::size_t, 3> siblings{};
+		std::uint32_t found = 0;
+
+		for (std::size_t i = 0; i < tiles.size() && found < 3; ++i)
+		{
+			const std::array<std::uint32_t, 2>& other = tiles[i];
+			if (px == (other[0] & ~(2 * size - 1)) && py == (other[1] & ~(2 * size - 1)))
+			{
+				siblings[found++] = i;
+			}
+		}
+
+		if (found < 3)
+		{
+			break;
+		}
+
+		// Erase from the back so the other positions stay valid
+		for (std::uint32_t i = 3; 0 < i; --i)
+		{
+			tiles[siblings[i - 1]] = tiles.back();
+			tiles.pop_back();
+		}
+
+		position = { px, py };
+		--level;
+	}
+
+	myFreeTiles[level].push_back(position);
+}
+
+void
+gl::ShadowAtlas::Clear()
+{
+	myFreeTiles.assign(myLevelCount, {});
+	myFreeTiles[0].push_back({ 0, 0 });
+	myFreeArea = static_cast<std::uint64_t>(mySize) * mySize;
+}
+
+bool
+gl::ShadowAtlas::Create()
+noexcept
+{
+	if (0 != myFramebuffer)
+	{
+		return true;
+	}
+
+	::glGenTextures(1, std::addressof(myTexture));
+	::glBindTexture(GL_TEXTURE_2D, myTexture);
+	::glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, static_cast<GLsizei>(mySize), static_cast<GLsizei>(mySize), 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	::glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLint previous = 0;
+	::glGetIntegerv(GL_FRAMEBUFFER_BINDING, std::addressof(previous));
+
+	// Only a depth attachment, no colour is ever written
+	::glGenFramebuffers(1, std::addressof(myFramebuffer));
+	::glBindFramebuffer(GL_FRAMEBUFFER, myFramebuffer);
+	::glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, myTexture, 0);
+	::glDrawBuffer(GL_NONE);
+	::glReadBuffer(GL_NONE);
+
+	const bool complete = GL_FRAMEBUFFER_COMPLETE == ::glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	::glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+
+	if (!complete)
+	{
+		Destroy();
+	}
+
+	return complete;
+}
+
+void
+gl::ShadowAtlas::Destroy()
+noexcept
+{
+	if (0 != myFramebuffer)
+	{
+		::glDeleteFramebuffers(1, std::addressof(myFramebuffer));
+		myFramebuffer = 0;
+	}
+
+	if (0 != myTexture)
+	{
+		::glDeleteTextures(1, std::addressof(myTexture));
+		myTexture = 0;
+	}
+}
+
+void
+gl::ShadowAtlas::SetDepthBias(float slope_factor, float units)
+noexcept
+{
+	mySlopeBias = slope_factor;
+	myConstantBias = units;
+}
+
+void
+gl::ShadowAtlas::Begin()
+noexcept
+{
+	::glGetIntegerv(GL_FRAMEBUFFER_BINDING, std::addressof(myPrevious.framebuffer));
+	::glGetIntegerv(GL_VIEWPORT, myPrevious.viewport);
+	::glGetIntegerv(GL_SCISSOR_BOX, myPrevious.scissor);
+	::glGetIntegerv(GL_DEPTH_FUNC, std::addressof(myPrevious.depthFunction));
+	::glGetFloatv(GL_POLYGON_OFFSET_FACTOR, std::addressof(myPrevious.polygonOffset[0]));
+	::glGetFloatv(GL_POLYGON_OFFSET_UNITS, std::addressof(myPrevious.polygonOffset[1]));
+	::glGetBooleanv(GL_COLOR_WRITEMASK, myPrevious.colourMask);
+	::glGetBooleanv(GL_DEPTH_WRITEMASK, std::addressof(myPrevious.depthMask));
+	::glGetBooleanv(GL_DEPTH_TEST, std::addressof(myPrevious.depthTesting));
+	::glGetBooleanv(GL_SCISSOR_TEST, std::addressof(myPrevious.scissoring));
+	::glGetBooleanv(GL_POLYGON_OFFSET_FILL, std::addressof(myPrevious.offsetting));
+
+	::glBindFramebuffer(GL_FRAMEBUFFER, myFramebuffer);
+	::glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	::glDepthMask(GL_TRUE);
+	::glEnable(GL_DEPTH_TEST);
+	::glDepthFunc(GL_LEQUAL);
+	::glEnable(GL_SCISSOR_TEST);
+	::glEnable(GL_POLYGON_OFFSET_FILL);
+	::glPolygonOffset(mySlopeBias, myConstantBias);
+}
+
+void
+gl::ShadowAtlas::BeginTile(const gl::shadow::Tile& tile)
+noexcept
+{
+	const GLint x = static_cast<GLint>(tile.x), y = static_cast<GLint>(tile.y);
+	const GLsizei size = static_cast<GLsizei>(tile.size);
+
+	// The scissor keeps the clear inside of the tile
+	::glViewport(x, y, size, size);
+	::glScissor(x, y, size, size);
+	::glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void
+gl::ShadowAtlas::End()
+noexcept
+{
+	SetCapability(GL_POLYGON_OFFSET_FILL, myPrevious.offsetting);
+	SetCapability(GL_SCISSOR_TEST, myPrevious.scissoring);
+	SetCapability(GL_DEPTH_TEST, myPrevious.depthTesting);
+	::glPolygonOffset(myPrevious.polygonOffset[0], myPrevious.polygonOffset[1]);
+	::glScissor(myPrevious.scissor[0], myPrevious.scissor[1], myPrevious.scissor[2], myPrevious.scissor[3]);
+	::glDepthFunc(static_cast<GLenum>(myPrevious.depthFunction));
+	::glDepthMask(myPrevious.depthMask);
+	::glColorMask(myPrevious.colourMask[0], myPrevious.colourMask[1], myPrevious.colourMask[2], myPrevious.colourMask[3]);
+
+	::glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(myPrevious.framebuffer));
+	::glViewport(myPrevious.viewport[0], myPrevious.viewport[1], myPrevious.viewport[2], myPrevious.viewport[3]);
+}
+
+void
+gl::ShadowAtlas::Bind(std::uint32_t unit)
+const noexcept
+{
+	::glActiveTexture(GL_TEXTURE0 + unit);
+	::glBindTexture(GL_TEXTURE_2D, myTexture);
+}
+
+std::uint32_t
+gl::ShadowAtlas::GetSize()
+const noexcept
+{
+	return mySize;
+}
+
+std::uint64_t
+gl::ShadowAtlas::GetFreeArea()
+const noexcept
+{
+	return myFreeArea;
+}
+
+std::uint32_t
+gl::ShadowAtlas::GetTexture()
+const noexcept
+{
+	return myTexture;
+}
+
+bool
+gl::ShadowAtlas::IsCreated()
+const noexcept
+{
+	return 0 != myFramebuffer;
+}
+
+std::uint32_t
+gl::ShadowAtlas::GetLevel(std::uint32_t size)
+const noexcept
+{
+	// Level of the smallest tile holding the size
+	const std::uint32_t tile = std::bit_ceil(std::max(size, 1U));
+	const std::uint32_t level = static_cast<std::uint32_t>(std::countr_zero(mySize) - std::countr_zero(std::min(tile, mySize)));
+
+	return std::min(level, myLevelCount - 1);
+}
+
+gl::CascadedShadows::CascadedShadows(std::uint32_t cascades, std::uint32_t resolution, float lambda)
+noexcept
+	: myCount(std::clamp(cascades, 1U, shadow::MaxCascades))
+	, myResolution(std::max(resolution, 1U))
+	, myLambda(lambda)
+{}
+
+gl::CascadedShadows::~CascadedShadows()
+noexcept
+{}
+
+bool
+gl::CascadedShadows::Allocate(gl::ShadowAtlas& atlas)
+{
+	Release(atlas);
+
+	for (std::uint32_t i = 0; i < myCount; ++i)
+	{
+		const std::optional<shadow::Tile> tile = atlas.Allocate(myResolution);
+		if (!tile)
+		{
+			Release(atlas);
+			return false;
+		}
+
+		myTiles[i] = *tile;
+	}
+
+	myAtlasSize = atlas.GetSize();
+
+	return true;
+}
+
+void
+gl::CascadedShadows::Release(gl::ShadowAtlas& atlas)
+{
+	for (shadow::Tile& tile : myTiles)
+	{
+		atlas.Free(tile);
+		tile = {};
+	}
+
+	myAtlasSize = 0;
+}
+
+void
+gl::CascadedShadows::SetCasterDistance(float distance)
+noexcept
+{
+	myCasterDistance = distance;
+}
+
+void
+gl::CascadedShadows::Update(const float(&view)[16], float vertical_fov, float aspect, float near_plane, float far_plane, const float(&light_direction)[3])
+noexcept
+{
+	mySplits = shadow::ComputeSplits(near_plane, far_plane, myCount, myLambda);
+
+	for (std::uint32_t i = 0; i < myCount; ++i)
+	{
+		const shadow::Tile& tile = myTiles[i];
+
+		// The tile may be smaller than asked for when it wasn't allocated
+		const std::uint32_t resolution = 0 < tile.size ? tile.size : myResolution;
+
+		shadow::Cascade& cascade = myCascades[i];
+		cascade = shadow::ComputeCascade(view, vertical_fov, aspect, mySplits[i], mySplits[i + 1], light_direction, resolution, myCasterDistance);
+		cascade.tile = tile;
+
+		if (0 < myAtlasSize)
+		{
+			const float size = static_cast<float>(myAtlasSize);
+
+			cascade.atlasTransform[0] = static_cast<float>(tile.size) / size;
+			cascade.atlasTransform[1] = static_cast<float>(tile.size) / size;
+			cascade.atlasTransform[2] = static_cast<float>(tile.x) / size;
+			cascade.atlasTransform[3] = static_cast<float>(tile.y) / size;
+		}
+	}
+}
+
+void
+gl::CascadedShadows::Cull(const gl::SceneIndex& scene, std::uint32_t threads)
+{
+	std::array<scene::Frustum, shadow::MaxCascades> frustums{};
+	for (std::uint32_t i = 0; i < myCount; ++i)
+	{
+		frustums[i] = GetFrustum(i);
+	}
+
+	scene.QueryFrustums(std::span{ frustums.data(), myCount }, myCasters, threads);
+
+	myStatistics = {};
+	myStatistics.cascades = myCount;
+
+	for (std::uint32_t i = 0; i < myCount; ++i)
+	{
+		myStatistics.casters[i] = myCasters[i].size();
+		myStatistics.culled += scene.GetObjectCount() - myCasters[i].size();
+	}
+}
+
+void
+gl::CascadedShadows::Render(gl::ShadowAtlas& atlas, gl::Pipeline& pipeline, std::int32_t matrix_location, drawer_t drawer)
+{
+	if (!atlas.IsCreated() && !atlas.Create())
+	{
+		return;
+	}
+
+	atlas.Begin();
+	pipeline.Use();
+
+	for (std::uint32_t i = 0; i < myCount && i < myCasters.size(); ++i)
+	{
+		const shadow::Cascade& cascade = myCascades[i];
+		if (0 == cascade.tile.size)
+		{
+			continue;
+		}
+
+		atlas.BeginTile(cascade.tile);
+		::glUniformMatrix4fv(matrix_location, 1, GL_FALSE, cascade.viewProjection);
+
+		for (const std::uint32_t object : myCasters[i])
+		{
+			drawer(object);
+		}
+	}
+
+	atlas.End();
+}
+
+std::span<const gl::shadow::Cascade>
+gl::CascadedShadows::GetCascades()
+const noexcept
+{
+	return std::span{ myCascades.data(), myCount };
+}
+
+std::span<const float>
+gl::CascadedShadows::GetSplits()
+const noexcept
+{
+	return std::span{ mySplits.data(), myCount + 1 };
+}
+
+gl::scene::Frustum
+gl::CascadedShadows::GetFrustum(std::uint32_t cascade)
+const noexcept
+{
+	return scene::Frustum::FromMatrix(myCascades[cascade].viewProjection);
+}
+
+std::span<const std::uint32_t>
+gl::CascadedShadows::GetCasters(std::uint32_t cascade)
+const noexcept
+{
+	if (myCasters.size() <= cascade)
+	{
+		return {};
+	}
+
+	return myCasters[cascade];
+}
+
+const gl::shadow::Statistics&
+gl::CascadedShadows::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
@@ -0,0 +1,788 @@
+module;
+#define NOMINMAX
+#include <Windows.h>
+#include "glew.h"
+#include <gl\gl.h>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define GLIB_SPRITE_SSE 1
+#else
+#define GLIB_SPRITE_SSE 0
+#endif
+
+module Glib.SpriteBatch;
+import <cmath>;
+import <string_view>;
+import <limits>;
+import <algorithm>;
+import <numeric>;
+import <optional>;
+import <utility>;
+import <chrono>;
+import <random>;
+import Glib.RenderQueue;
+import Glib.Parallel;
+
+namespace
+{
+	constexpr std::string_view VertexSource = R"(#version 430 core
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texcoord;
+layout(location = 2) in vec4 colour;
+
+layout(location = 0) uniform mat4 projection;
+
+out vec2 spriteTexcoord;
+out vec4 spriteColour;
+
+void main()
+{
+	spriteTexcoord = texcoord;
+	spriteColour = colour;
+	gl_Position = projection * vec4(position, 0.0, 1.0);
+}
+)";
+
+	constexpr std::string_view FragmentSource = R"(#version 430 core
+layout(binding = 0) uniform sampler2D spriteTexture;
+
+in vec2 spriteTexcoord;
+in vec4 spriteColour;
+
+out vec4 fragment;
+
+void main()
+{
+	fragment = texture(spriteTexture, spriteTexcoord) * spriteColour;
+}
+)";
+
+	// Layer, blending, texture, then the submission order of the sprite
+	constexpr std::uint32_t LayerShift = 56;
+	constexpr std::uint32_t BlendShift = 48;
+	constexpr std::uint32_t TextureShift = 32;
+
+	// Distinct blendings and textures a key has room for, a batch which needs more draws in several parts
+	constexpr std::size_t MaxBlendModes = std::size_t{ 1 } << (LayerShift - BlendShift);
+	constexpr std::size_t MaxTextures = std::size_t{ 1 } << (BlendShift - TextureShift);
+
+	constexpr std::uint32_t QuadIndices[6] = { 0, 1, 2, 2, 3, 0 };
+
+	void
+	WriteSprite(const gl::sprite::Streams& streams, std::uint32_t index, gl::sprite::Vertex* output)
+	noexcept
+	{
+		const float x = streams.x[index], y = streams.y[index];
+		const float cos = streams.cos[index], sin = streams.sin[index];
+
+		const float lc = streams.left[index] * cos, ls = streams.left[index] * sin;
+		const float rc = streams.right[index] * cos, rs = streams.right[index] * sin;
+		const float tc = streams.top[index] * cos, ts = streams.top[index] * sin;
+		const float bc = streams.bottom[index] * cos, bs = streams.bottom[index] * sin;
+
+		const float u0 = streams.u0[index], v0 = streams.v0[index];
+		const float u1 = streams.u1[index], v1 = streams.v1[index];
+		const std::uint32_t colour = streams.colour[index];
+
+		output[0] = { x + lc - ts, y + ls + tc, u0, v0, colour };
+		output[1] = { x + rc - ts, y + rs + tc, u1, v0, colour };
+		output[2] = { x + rc - bs, y + rs + bc, u1, v1, colour };
+		output[3] = { x + lc - bs, y + ls + bc, u0, v1, colour };
+	}
+
+#if GLIB_SPRITE_SSE
+	[[nodiscard]]
+	__m128
+	Gather(const std::vector<float>& stream, const std::uint32_t* indices, bool contiguous)
+	noexcept
+	{
+		if (contiguous)
+		{
+			return _mm_loadu_ps(stream.data() + indices[0]);
+		}
+
+		return _mm_setr_ps(stream[indices[0]], stream[indices[1]], stream[indices[2]], stream[indices[3]]);
+	}
+
+	/// <summary>
+	/// Corners of four sprites, the fields are computed across the sprites then transposed into vertices
+	/// </summary>
+	void
+	WriteSprites(const gl::sprite::Streams& streams, const std::uint32_t* indices, gl::sprite::Vertex* output)
+	noexcept
+	{
+		const bool contiguous = indices[1] == indices[0] + 1 && indices[2] == indices[0] + 2 && indices[3] == indices[0] + 3;
+
+		const __m128 x = Gather(streams.x, indices, contiguous);
+		const __m128 y = Gather(streams.y, indices, contiguous);
+		const __m128 cos = Gather(streams.cos, indices, contiguous);
+		const __m128 sin = Gather(streams.sin, indices, contiguous);
+
+		const __m128 left = Gather(streams.left, indices, contiguous);
+		const __m128 right = Gather(streams.right, indices, contiguous);
+		const __m128 top = Gather(streams.top, indices, contiguous);
+		const __m128 bottom = Gather(streams.bottom, indices, contiguous);
+
+		const __m128 lc = _mm_mul_ps(left, cos), ls = _mm_mul_ps(left, sin);
+		const __m128 rc = _mm_mul_ps(right, cos), rs = _mm_mul_ps(right, sin);
+		const __m128 tc = _mm_mul_ps(top, cos), ts = _mm_mul_ps(top, sin);
+		const __m128 bc = _mm_mul_ps(bottom, cos), bs = _mm_mul_ps(bottom, sin);
+
+		const __m128 u0 = Gather(streams.u0, indices, contiguous);
+		const __m128 v0 = Gather(streams.v0, indices, contiguous);
+		const __m128 u1 = Gather(streams.u1, indices, contiguous);
+		const __m128 v1 = Gather(streams.v1, indices, contiguous);
+
+		const __m128 colour = _mm_castsi128_ps(_mm_setr_epi32(
+			static_cast<int>(streams.colour[indices[0]]), static_cast<int>(streams.colour[indices[1]]),
+			static_cast<int>(streams.colour[indices[2]]), static_cast<int>(streams.colour[indices[3]])));
+
+		const __m128 x0 = _mm_sub_ps(_mm_add_ps(x, lc), ts), y0 = _mm_add_ps(_mm_add_ps(y, ls), tc);
+		const __m128 x1 = _mm_sub_ps(_mm_add_ps(x, rc), ts), y1 = _mm_add_ps(_mm_add_ps(y, rs), tc);
+		const __m128 x2 = _mm_sub_ps(_mm_add_ps(x, rc), bs), y2 = _mm_add_ps(_mm_add_ps(y, rs), bc);
+		const __m128 x3 = _mm_sub_ps(_mm_add_ps(x, lc), bs), y3 = _mm_add_ps(_mm_add_ps(y, ls), bc);
+
+		// The four vertices of a sprite are eighty bytes, five whole vectors,
+		// so each group of fields is transposed from one sprite per lane into one of those vectors of every sprite
+		float* const destination = std::addressof(output->x);
+
+		const auto store = [destination](std::uint32_t row, __m128 a, __m128 b, __m128 c, __m128 d) noexcept {
+			_MM_TRANSPOSE4_PS(a, b, c, d);
+
+			// Every store stays within the five cache lines of the four sprites, for the write combining of mapped memory
+			_mm_storeu_ps(destination + row * 4, a);
+			_mm_storeu_ps(destination + row * 4 + 20, b);
+			_mm_storeu_ps(destination + row * 4 + 40, c);
+			_mm_storeu_ps(destination + row * 4 + 60, d);
+		};
+
+		store(0, x0, y0, u0, v0);
+		store(1, colour, x1, y1, u1);
+		store(2, v0, colour, x2, y2);
+		store(3, u1, v1, colour, x3);
+		store(4, y3, u0, v1, colour);
+	}
+#endif
+
+	[[nodiscard]]
+	bool
+	IsSameBlend(const gl::BlendMode& lhs, const gl::BlendMode& rhs)
+	noexcept
+	{
+		return lhs.srcOption == rhs.srcOption && lhs.dstOption == rhs.dstOption;
+	}
+
+	void
+	WaitFence(void*& fence, std::uint64_t& stalls)
+	noexcept
+	{
+		if (nullptr == fence)
+		{
+			return;
+		}
+
+		const GLsync sync = static_cast<GLsync>(fence);
+
+		GLenum status = ::glClientWaitSync(sync, 0, 0);
+		if (GL_TIMEOUT_EXPIRED == status)
+		{
+			++stalls;
+
+			do
+			{
+				status = ::glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000);
+			}
+			while (GL_TIMEOUT_EXPIRED == status);
+		}
+
+		::glDeleteSync(sync);
+		fence = nullptr;
+	}
+}
+
+void
+gl::sprite::Streams::Append(const gl::sprite::Sprite& sprite)
+{
+	const float left = -sprite.originX * sprite.width;
+	const float top = -sprite.originY * sprite.height;
+
+	x.push_back(sprite.x);
+	y.push_back(sprite.y);
+	this->left.push_back(left);
+	right.push_back(left + sprite.width);
+	this->top.push_back(top);
+	bottom.push_back(top + sprite.height);
+
+	if (0 == sprite.rotation)
+	{
+		cos.push_back(1);
+		sin.push_back(0);
+	}
+	else
+	{
+		cos.push_back(std::cos(sprite.rotation));
+		sin.push_back(std::sin(sprite.rotation));
+	}
+
+	u0.push_back(sprite.region.u0);
+	v0.push_back(sprite.region.v0);
+	u1.push_back(sprite.region.u1);
+	v1.push_back(sprite.region.v1);
+	colour.push_back(PackColour(sprite.colour));
+}
+
+void
+gl::sprite::Streams::Reserve(std::size_t count)
+{
+	for (std::vector<float>* stream : { &x, &y, &left, &right, &top, &bottom, &cos, &sin, &u0, &v0, &u1, &v1 })
+	{
+		stream->reserve(count);
+	}
+
+	colour.reserve(count);
+}
+
+void
+gl::sprite::Streams::Clear()
+noexcept
+{
+	for (std::vector<float>* stream : { &x, &y, &left, &right, &top, &bottom, &cos, &sin, &u0, &v0, &u1, &v1 })
+	{
+		stream->clear();
+	}
+
+	colour.clear();
+}
+
+std::size_t
+gl::sprite::Streams::GetSize()
+const noexcept
+{
+	return colour.size();
+}
+
+std::array<float, 16>
+gl::sprite::MakeProjection(float width, float height)
+noexcept
+{
+	std::array<float, 16> result{};
+	result[0] = 2.0f / std::max(width, 1.0f);
+	result[5] = -2.0f / std::max(height, 1.0f);
+	result[10] = -1.0f;
+	result[12] = -1.0f;
+	result[13] = 1.0f;
+	result[15] = 1.0f;
+
+	return result;
+}
+
+gl::sprite::Region
+gl::sprite::MakeRegion(const gl::Texture& texture, float x, float y, float width, float height)
+noexcept
+{
+	const float texture_width = static_cast<float>(std::max<std::size_t>(texture.GetWidth(), 1));
+	const float texture_height = static_cast<float>(std::max<std::size_t>(texture.GetHeight(), 1));
+
+	return Region{ x / texture_width, y / texture_height, (x + width) / texture_width, (y + height) / texture_height };
+}
+
+void
+gl::sprite::GenerateVertices(const gl::sprite::Streams& streams, std::span<const std::uint32_t> order, std::span<gl::sprite::Vertex> destination)
+noexcept
+{
+	const std::size_t count = std::min(order.size(), destination.size() / 4);
+	std::size_t i = 0;
+
+#if GLIB_SPRITE_SSE
+	for (; i + 4 <= count; i += 4)
+	{
+		WriteSprites(streams, order.data() + i, destination.data() + i * 4);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		WriteSprite(streams, order[i], destination.data() + i * 4);
+	}
+}
+
+void
+gl::sprite::GenerateVerticesScalar(const gl::sprite::Streams& streams, std::span<const std::uint32_t> order, std::span<gl::sprite::Vertex> destination)
+noexcept
+{
+	const std::size_t count = std::min(order.size(), destination.size() / 4);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		WriteSprite(streams, order[i], destination.data() + i * 4);
+	}
+}
+
+gl::sprite::Benchmark
+gl::sprite::MeasureGeneration(std::size_t sprites, std::uint32_t iterations)
+{
+	using clock = std::chrono::steady_clock;
+
+	std::mt19937 engine{ 44 };
+	std::uniform_real_distribution<float> position{ 0.0f, 1920.0f };
+	std::uniform_real_distribution<float> size{ 4.0f, 64.0f };
+	std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+	std::uniform_real_distribution<float> angle{ -3.14159265f, 3.14159265f };
+
+	Streams streams{};
+	streams.Reserve(sprites);
+
+	for (std::size_t i = 0; i < sprites; ++i)
+	{
+		Sprite sprite{};
+		sprite.x = position(engine);
+		sprite.y = position(engine);
+		sprite.width = size(engine);
+		sprite.height = size(engine);
+		sprite.originX = 0.5f;
+		sprite.originY = 0.5f;
+		sprite.rotation = angle(engine);
+		sprite.region = Region{ unit(engine) * 0.5f, unit(engine) * 0.5f, 0.5f + unit(engine) * 0.5f, 0.5f + unit(engine) * 0.5f };
+
+		streams.Append(sprite);
+	}
+
+	std::vector<std::uint32_t> order(sprites);
+	std::iota(order.begin(), order.end(), 0U);
+
+	std::vector<std::uint32_t> shuffled = order;
+	std::shuffle(shuffled.begin(), shuffled.end(), engine);
+
+	std::vector<Vertex> vertices(sprites * 4);
+	iterations = std::max(1U, iterations);
+
+	const auto measure = [&](auto&& generate, std::span<const std::uint32_t> indices) {
+		double best = std::numeric_limits<double>::max();
+
+		for (std::uint32_t i = 0; i < iterations; ++i)
+		{
+			const auto start = clock::now();
+			generate(streams, indices, std::span<Vertex>{ vertices });
+			best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+		}
+
+		return static_cast<double>(sprites) / std::max(best, 1e-9);
+	};
+
+	Benchmark result{};
+	result.sprites = sprites;
+	result.simdPerSecond = measure(GenerateVertices, order);
+	result.shuffledPerSecond = measure(GenerateVertices, shuffled);
+	result.scalarPerSecond = measure(GenerateVerticesScalar, order);
+
+	return result;
+}
+
+gl::SpriteBatch::SpriteBatch(std::uint32_t capacity, std::uint32_t sections)
+	: myCapacity(std::max(1U, capacity))
+	, mySectionCount(std::max(1U, sections))
+	, myFences(mySectionCount, nullptr)
+{}
+
+gl::SpriteBatch::~SpriteBatch()
+noexcept
+{
+	Destroy();
+}
+
+bool
+gl::SpriteBatch::Create()
+noexcept
+{
+	if (IsCreated())
+	{
+		return true;
+	}
+
+	myPipeline = std::make_unique<Pipeline>();
+
+	Shader vertex_shader{ shader::ShaderType::Vertex };
+	Shader fragment_shader{ shader::ShaderType::Fragment };
+
+	if (not myPipeline->IsValid()
+		|| shader::ErrorCode::Success != vertex_shader.Compile(VertexSource)
+		|| shader::ErrorCode::Success != fragment_shader.Compile(FragmentSource))
+	{
+		myPipeline.reset();
+		return false;
+	}
+
+	myPipeline->AddShader(std::move(vertex_shader));
+	myPipeline->AddShader(std::move(fragment_shader));
+	myPipeline->Start();
+
+	GLint linked = GL_FALSE;
+	::glGetProgramiv(myPipeline->GetID(), GL_LINK_STATUS, std::addressof(linked));
+	if (GL_FALSE == linked)
+	{
+		myPipeline.reset();
+		return false;
+	}
+
+	const GLsizeiptr ring_bytes = static_cast<GLsizeiptr>(mySectionCount) * myCapacity * 4 * sizeof(sprite::Vertex);
+
+	::glGenVertexArrays(1, std::addressof(myVertexArray));
+	::glBindVertexArray(myVertexArray);
+
+	::glGenBuffers(1, std::addressof(myVertexBuffer));
+	::glBindBuffer(GL_ARRAY_BUFFER, myVertexBuffer);
+
+	// Without immutable storage every section is mapped unsynchronized instead, the fences still guard it
+	isPersistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+	if (isPersistent)
+	{
+		constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		::glBufferStorage(GL_ARRAY_BUFFER, ring_bytes, nullptr, flags);
+		myMapping = static_cast<sprite::Vertex*>(::glMapBufferRange(GL_ARRAY_BUFFER, 0, ring_bytes, flags));
+	}
+	else
+	{
+		::glBufferData(GL_ARRAY_BUFFER, ring_bytes, nullptr, GL_STREAM_DRAW);
+	}
+
+	constexpr GLsizei stride = sizeof(sprite::Vertex);
+
+	::glEnableVertexAttribArray(0);
+	::glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(sprite::Vertex, x)));
+	::glEnableVertexAttribArray(1);
+	::glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(sprite::Vertex, u)));
+	::glEnableVertexAttribArray(2);
+	::glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(sprite::Vertex, colour)));
+
+	std::vector<std::uint32_t> indices(static_cast<std::size_t>(myCapacity) * 6);
+	for (std::uint32_t quad = 0; quad < myCapacity; ++quad)
+	{
+		for (std::uint32_t i = 0; i < 6; ++i)
+		{
+			indices[quad * 6 + i] = quad * 4 + QuadIndices[i];
+		}
+	}
+
+	::glGenBuffers(1, std::addressof(myIndexBuffer));
+	::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, myIndexBuffer);
+	::glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(std::uint32_t)), indices.data(), GL_STATIC_DRAW);
+
+	::glBindVertexArray(0);
+	::glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (isPersistent && nullptr == myMapping)
+	{
+		Destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void
+gl::SpriteBatch::Destroy()
+noexcept
+{
+	for (void*& fence : myFences)
+	{
+		if (nullptr != fence)
+		{
+			::glDeleteSync(static_cast<GLsync>(fence));
+			fence = nullptr;
+		}
+	}
+
+	// Deleting the buffer also unmaps it
+	if (0 != myVertexBuffer)
+	{
+		::glDeleteBuffers(1, std::addressof(myVertexBuffer));
+		myVertexBuffer = 0;
+		myMapping = nullptr;
+	}
+
+	if (0 != myIndexBuffer)
+	{
+		::glDeleteBuffers(1, std::addressof(myIndexBuffer));
+		myIndexBuffer = 0;
+	}
+
+	if (0 != myVertexArray)
+	{
+		::glDeleteVertexArrays(1, std::addressof(myVertexArray));
+		myVertexArray = 0;
+	}
+
+	myPipeline.reset();
+	myNextSection = 0;
+}
+
+void
+gl::SpriteBatch::Begin(const std::array<float, 16>& projection, gl::sprite::SortMode mode)
+noexcept
+{
+	myProjection = projection;
+	mySortMode = mode;
+	myStatistics = {};
+
+	Clear();
+}
+
+void
+gl::SpriteBatch::Draw(const gl::Texture& texture, const gl::sprite::Sprite& sprite, const gl::BlendMode& blend, std::uint8_t layer)
+{
+	if (IsFull(texture, blend))
+	{
+		Flush();
+	}
+
+	const std::uint64_t texture_index = GetTextureIndex(texture);
+	const std::uint64_t blend_index = GetBlendIndex(blend);
+	const std::uint64_t sequence = myStreams.GetSize();
+
+	std::uint64_t key = static_cast<std::uint64_t>(layer) << LayerShift | sequence;
+	if (sprite::SortMode::Texture == mySortMode)
+	{
+		key |= blend_index << BlendShift | texture_index << TextureShift;
+	}
+
+	isSorted = isSorted && (myKeys.empty() || myKeys.back() <= key);
+
+	myStreams.Append(sprite);
+	myStates.push_back(static_cast<std::uint32_t>(blend_index << 16 | texture_index));
+	myKeys.push_back(key);
+}
+
+void
+gl::SpriteBatch::End()
+{
+	Flush();
+}
+
+void
+gl::SpriteBatch::Flush()
+{
+	const std::size_t count = myStreams.GetSize();
+	myStatistics.sprites += count;
+
+	if (0 == count || not IsCreated())
+	{
+		Clear();
+		return;
+	}
+
+	myOrder.resize(count);
+	std::iota(myOrder.begin(), myOrder.end(), 0U);
+
+	if (not isSorted)
+	{
+		myScratchKeys.resize(count);
+		myScratchIndices.resize(count);
+		render::RadixSort(myKeys, myOrder, myScratchKeys, myScratchIndices, GetWorkerCount(0));
+	}
+
+	// The bindings of the caller are bound again once the sprites are drawn
+	GLint previous_program = 0, previous_unit = GL_TEXTURE0, previous_texture = 0, previous_array = 0, previous_buffer = 0;
+	::glGetIntegerv(GL_CURRENT_PROGRAM, std::addressof(previous_program));
+	::glGetIntegerv(GL_ACTIVE_TEXTURE, std::addressof(previous_unit));
+	::glGetIntegerv(GL_VERTEX_ARRAY_BINDING, std::addressof(previous_array));
+	::glGetIntegerv(GL_ARRAY_BUFFER_BINDING, std::addressof(previous_buffer));
+
+	myPipeline->Use();
+	::glUniformMatrix4fv(0, 1, GL_FALSE, myProjection.data());
+	::glActiveTexture(GL_TEXTURE0);
+	::glGetIntegerv(GL_TEXTURE_BINDING_2D, std::addressof(previous_texture));
+	::glBindVertexArray(myVertexArray);
+
+	// Constructed again for every run of another blending, the last one restores the previous state
+	std::optional<Blender> blender{};
+	std::uint32_t last_texture = std::numeric_limits<std::uint32_t>::max();
+	std::uint32_t last_blend = std::numeric_limits<std::uint32_t>::max();
+
+	for (std::size_t first = 0; first < count; first += myCapacity)
+	{
+		const std::uint32_t sprites = static_cast<std::uint32_t>(std::min<std::size_t>(myCapacity, count - first));
+		const std::span<const std::uint32_t> order = std::span<const std::uint32_t>{ myOrder }.subspan(first, sprites);
+
+		const std::uint32_t section = myNextSection;
+		myNextSection = (myNextSection + 1) % mySectionCount;
+
+		sprite::Vertex* const vertices = MapSection(section);
+		if (nullptr == vertices)
+		{
+			continue;
+		}
+
+		sprite::GenerateVertices(myStreams, order, std::span<sprite::Vertex>{ vertices, static_cast<std::size_t>(sprites) * 4 });
+		UnmapSection();
+		++myStatistics.sections;
+
+		const GLint base_vertex = static_cast<GLint>(section * myCapacity * 4);
+
+		for (std::uint32_t begin = 0; begin < sprites;)
+		{
+			const std::uint32_t state = myStates[order[begin]];
+
+			std::uint32_t end = begin + 1;
+			while (end < sprites && myStates[order[end]] == state)
+			{
+				++end;
+			}
+
+			const std::uint32_t blend = state >> 16;
+			const std::uint32_t texture = state & 0xFFFF;
+
+			if (blend != last_blend)
+			{
+				blender.reset();
+				blender.emplace(myBlendModes[blend]);
+				last_blend = blend;
+				++myStatistics.blendChanges;
+			}
+
+			if (texture != last_texture)
+			{
+				myTextures[texture]->Bind();
+				last_texture = texture;
+				++myStatistics.textureChanges;
+			}
+
+			const std::uintptr_t offset = static_cast<std::uintptr_t>(begin) * 6 * sizeof(std::uint32_t);
+			::glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>((end - begin) * 6), GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset), base_vertex);
+			++myStatistics.drawCalls;
+
+			begin = end;
+		}
+
+		myFences[section] = ::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	blender.reset();
+
+	::glBindVertexArray(static_cast<GLuint>(previous_array));
+	::glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(previous_buffer));
+	::glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previous_texture));
+	::glActiveTexture(static_cast<GLenum>(previous_unit));
+	::glUseProgram(static_cast<GLuint>(previous_program));
+
+	Clear();
+}
+
+const gl::sprite::Statistics&
+gl::SpriteBatch::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+std::size_t
+gl::SpriteBatch::GetSize()
+const noexcept
+{
+	return myStreams.GetSize();
+}
+
+bool
+gl::SpriteBatch::IsCreated()
+const noexcept
+{
+	return nullptr != myPipeline && 0 != myVertexArray;
+}
+
+bool
+gl::SpriteBatch::IsPersistent()
+const noexcept
+{
+	return isPersistent;
+}
+
+void
+gl::SpriteBatch::Clear()
+noexcept
+{
+	myStreams.Clear();
+	myStates.clear();
+	myKeys.clear();
+	myTextures.clear();
+	myTextureIndices.clear();
+	myBlendModes.clear();
+	isSorted = true;
+}
+
+bool
+gl::SpriteBatch::IsFull(const gl::Texture& texture, const gl::BlendMode& blend)
+const noexcept
+{
+	const bool is_texture_full = MaxTextures <= myTextures.size() && not myTextureIndices.contains(std::addressof(texture));
+	const bool is_blend_full = MaxBlendModes <= myBlendModes.size() && std::ranges::none_of(myBlendModes, [&blend](const BlendMode& mode) noexcept {
+		return IsSameBlend(mode, blend);
+	});
+
+	return is_texture_full || is_blend_full;
+}
+
+std::uint16_t
+gl::SpriteBatch::GetTextureIndex(const gl::Texture& texture)
+{
+	// Consecutive sprites mostly share their texture
+	if (not myTextures.empty() && myTextures.back() == std::addressof(texture))
+	{
+		return static_cast<std::uint16_t>(myTextures.size() - 1);
+	}
+
+	const auto [it, inserted] = myTextureIndices.try_emplace(std::addressof(texture), static_cast<std::uint16_t>(myTextures.size()));
+	if (inserted)
+	{
+		myTextures.push_back(std::addressof(texture));
+	}
+
+	return it->second;
+}
+
+std::uint8_t
+gl::SpriteBatch::GetBlendIndex(const gl::BlendMode& blend)
+{
+	for (std::size_t i = 0; i < myBlendModes.size(); ++i)
+	{
+		if (IsSameBlend(myBlendModes[i], blend))
+		{
+			return static_cast<std::uint8_t>(i);
+		}
+	}
+
+	myBlendModes.push_back(blend);
+
+	return static_cast<std::uint8_t>(myBlendModes.size() - 1);
+}
+
+gl::sprite::Vertex*
+gl::SpriteBatch::MapSection(std::uint32_t section)
+noexcept
+{
+	WaitFence(myFences[section], myStatistics.stalls);
+
+	const std::size_t first_vertex = static_cast<std::size_t>(section) * myCapacity * 4;
+
+	if (isPersistent)
+	{
+		return myMapping + first_vertex;
+	}
+
+	constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+	const GLsizeiptr section_bytes = static_cast<GLsizeiptr>(myCapacity) * 4 * sizeof(sprite::Vertex);
+
+	::glBindBuffer(GL_ARRAY_BUFFER, myVertexBuffer);
+
+	return static_cast<sprite::Vertex*>(::glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(first_vertex * sizeof(sprite::Vertex)), section_bytes, flags));
+}
+
+void
+gl::SpriteBatch::UnmapSection()
+noexcept
+{
+	if (not isPersistent)
+	{
+		::glUnmapBuffer(GL_ARRAY_BUFFER);
+		::glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
@@ -14,6 +14,7 @@ import Glib.Windows.Context.Renderer;
 import :System;
 import :Blender;
 import Glib.Culling;
+import Glib.DirtyRegion;
 import Glib.Legacy.Primitive;
 
 static inline constexpr ::PIXELFORMATDESCRIPTOR opengl_format =
@@ -72,6 +73,11 @@ noexcept
 		my_format.dwFlags |= PFD_DOUBLEBUFFER;
 	}
 
+	if (mySettings.partialRedraw)
+	{
+		my_format.dwFlags = (my_format.dwFlags & ~PFD_SWAP_EXCHANGE) | PFD_SWAP_COPY;
+	}
+
 	if (unsigned long error = _InitializePixelFormat(hdc, my_format, my_target); 0 != error)
 	{
 		return error;
@@ -88,10 +94,12 @@ noexcept
 	if (0 != (my_format.dwFlags & PFD_DOUBLEBUFFER))
 	{
 		myPainter = DoublePainter;
+		isPreservingFrame = 0 != (my_format.dwFlags & PFD_SWAP_COPY);
 	}
 	else
 	{
 		myPainter = SinglePainter;
+		isPreservingFrame = true;
 	}
 
 	::wglMakeCurrent(hdc, GetHandle());
@@ -174,6 +182,13 @@ const noexcept
 bool
 gl::System::BeginRendering(gl::win32::IContext& painter)
 noexcept
+{
+	return BeginRendering(painter, gl::Rect{});
+}
+
+bool
+gl::System::BeginRendering(gl::win32::IContext& painter, const gl::Rect& dirty)
+noexcept
 {
 	using namespace gl::legacy;
 
@@ -184,6 +199,18 @@ noexcept
 		return false;
 	}
 
+	// The clears and the draws below stay inside the scissor, the rest of the frame is the previous one
+	const gl::Rect area = gl::GetIntersection(dirty, gl::Rect{ 0, 0, clientWidth, clientHeight });
+	isScissoring = isPreservingFrame && not gl::IsEmpty(area)
+		&& gl::GetArea(area) < static_cast<long long>(clientWidth) * clientHeight;
+
+	if (isScissoring)
+	{
+		global::SetState(gl::State::TestScissor, true);
+		// From the bottom left corner of the client area
+		::glScissor(area.x, clientHeight - area.y - area.h, area.w, area.h);
+	}
+
 	const int& view_x = ViewX();
 	const int& view_y = ViewY();
 	const int& view_w = ViewWidth();
@@ -191,6 +218,11 @@ noexcept
 
 	nativeContext = std::addressof(painter);
 
+	if (nullptr != myProfiler)
+	{
+		myProfiler->BeginFrame();
+	}
+
 	myBlender->Apply();
 	global::SetViewport(view_x, view_y, view_w, view_h);
 	global::Clear(Clearance::DepthStencil);
@@ -233,6 +265,18 @@ noexcept
 	transform::SetMode(TransformMode::Projection);
 	transform::PopState();
 
+	if (isScissoring)
+	{
+		global::SetState(gl::State::TestScissor, false);
+		isScissoring = false;
+	}
+
+	// Before the swap, which may wait for the vertical blank
+	if (nullptr != myProfiler)
+	{
+		myProfiler->EndFrame();
+	}
+
 	myPainter(nativeContext);
 
 	return 0 != ::wglMakeCurrent(nullptr, nullptr);
@@ -492,3 +536,29 @@ const noexcept
 {
 	return aspectRatio;
 }
+
+void
+gl::System::SetProfiler(gl::GpuProfiler* profiler)
+noexcept
+{
+	if (nullptr != myProfiler && myProfiler != profiler)
+	{
+		myProfiler->EndFrame();
+	}
+
+	myProfiler = profiler;
+}
+
+gl::GpuProfiler*
+gl::System::GetProfiler()
+const noexcept
+{
+	return myProfiler;
+}
+
+bool
+gl::System::IsPreservingFrame()
+const noexcept
+{
+	return isPreservingFrame;
+}
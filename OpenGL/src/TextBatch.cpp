@@ -0,0 +1,376 @@
+module;
+#define NOMINMAX
+#include <Windows.h>
+#include "glew.h"
+#include <gl\gl.h>
+
+module Glib.TextBatch;
+import <string_view>;
+import <optional>;
+import <algorithm>;
+import <utility>;
+
+namespace
+{
+	constexpr std::string_view VertexSource = R"(#version 430 core
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texcoord;
+layout(location = 2) in vec4 colour;
+
+layout(location = 0) uniform mat4 projection;
+
+out vec2 glyphTexcoord;
+out vec4 glyphColour;
+
+void main()
+{
+	glyphTexcoord = texcoord;
+	glyphColour = colour;
+	gl_Position = projection * vec4(position, 0.0, 1.0);
+}
+)";
+
+	// The edge is at the half of the distance range, smoothed over about a pixel of the screen whatever the scale
+	constexpr std::string_view FragmentSource = R"(#version 430 core
+layout(binding = 0) uniform sampler2D glyphAtlas;
+
+in vec2 glyphTexcoord;
+in vec4 glyphColour;
+
+out vec4 fragment;
+
+void main()
+{
+	float distance = texture(glyphAtlas, glyphTexcoord).r;
+	float width = max(fwidth(distance) * 0.7, 1e-4);
+	float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+
+	fragment = vec4(glyphColour.rgb, glyphColour.a * coverage);
+}
+)";
+
+	constexpr std::uint32_t QuadIndices[6] = { 0, 1, 2, 2, 3, 0 };
+	// Quads the buffers are created for, they grow by doubling
+	constexpr std::size_t InitialCapacity = 1024;
+}
+
+std::size_t
+gl::text::GenerateQuads(const gl::FontAtlas& atlas, const gl::font::ShapedRun& run, float x, float y, float size, std::uint32_t colour, std::vector<gl::sprite::Vertex>& output)
+{
+	const float scale = size / static_cast<float>(atlas.GetGlyphSize());
+	const float texel = 1.0f / static_cast<float>(atlas.GetSize());
+
+	std::size_t result = 0;
+
+	for (const font::PositionedGlyph& positioned : run.glyphs)
+	{
+		const font::Glyph& glyph = atlas.GetGlyph(positioned.slot);
+		if (0 == glyph.rect.width)
+		{
+			continue;
+		}
+
+		const float left = x + (positioned.x + static_cast<float>(glyph.left)) * scale;
+		const float top = y + (positioned.y - static_cast<float>(glyph.top)) * scale;
+		const float right = left + static_cast<float>(glyph.rect.width) * scale;
+		const float bottom = top + static_cast<float>(glyph.rect.height) * scale;
+
+		const float u0 = static_cast<float>(glyph.rect.x) * texel;
+		const float v0 = static_cast<float>(glyph.rect.y) * texel;
+		const float u1 = static_cast<float>(glyph.rect.x + glyph.rect.width) * texel;
+		const float v1 = static_cast<float>(glyph.rect.y + glyph.rect.height) * texel;
+
+		output.push_back(sprite::Vertex{ left, top, u0, v0, colour });
+		output.push_back(sprite::Vertex{ right, top, u1, v0, colour });
+		output.push_back(sprite::Vertex{ right, bottom, u1, v1, colour });
+		output.push_back(sprite::Vertex{ left, bottom, u0, v1, colour });
+		++result;
+	}
+
+	return result;
+}
+
+gl::TextBatch::TextBatch(gl::FontAtlas& atlas)
+noexcept
+	: myAtlas(std::addressof(atlas))
+{}
+
+gl::TextBatch::~TextBatch()
+noexcept
+{
+	Destroy();
+}
+
+bool
+gl::TextBatch::Create()
+noexcept
+{
+	if (IsCreated())
+	{
+		return true;
+	}
+
+	myPipeline = std::make_unique<Pipeline>();
+
+	Shader vertex_shader{ shader::ShaderType::Vertex };
+	Shader fragment_shader{ shader::ShaderType::Fragment };
+
+	if (not myPipeline->IsValid()
+		|| shader::ErrorCode::Success != vertex_shader.Compile(VertexSource)
+		|| shader::ErrorCode::Success != fragment_shader.Compile(FragmentSource))
+	{
+		myPipeline.reset();
+		return false;
+	}
+
+	myPipeline->AddShader(std::move(vertex_shader));
+	myPipeline->AddShader(std::move(fragment_shader));
+	myPipeline->Start();
+
+	GLint linked = GL_FALSE;
+	::glGetProgramiv(myPipeline->GetID(), GL_LINK_STATUS, std::addressof(linked));
+	if (GL_FALSE == linked)
+	{
+		myPipeline.reset();
+		return false;
+	}
+
+	const GLsizei size = static_cast<GLsizei>(myAtlas->GetSize());
+
+	::glGenTextures(1, std::addressof(myTexture));
+	::glBindTexture(GL_TEXTURE_2D, myTexture);
+	::glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, size, size);
+	::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// The whole atlas once, then only what the new glyphs dirty
+	::glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	::glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RED, GL_UNSIGNED_BYTE, myAtlas->GetPixels().data());
+	::glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	::glBindTexture(GL_TEXTURE_2D, 0);
+	static_cast<void>(myAtlas->TakeDirtyRect());
+
+	::glGenVertexArrays(1, std::addressof(myVertexArray));
+	::glGenBuffers(1, std::addressof(myVertexBuffer));
+	::glGenBuffers(1, std::addressof(myIndexBuffer));
+
+	::glBindVertexArray(myVertexArray);
+	::glBindBuffer(GL_ARRAY_BUFFER, myVertexBuffer);
+
+	constexpr GLsizei stride = sizeof(sprite::Vertex);
+
+	::glEnableVertexAttribArray(0);
+	::glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(sprite::Vertex, x)));
+	::glEnableVertexAttribArray(1);
+	::glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(sprite::Vertex, u)));
+	::glEnableVertexAttribArray(2);
+	::glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(sprite::Vertex, colour)));
+
+	::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, myIndexBuffer);
+
+	::glBindVertexArray(0);
+	::glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	myCapacity = 0;
+	Reserve(InitialCapacity);
+
+	return true;
+}
+
+void
+gl::TextBatch::Destroy()
+noexcept
+{
+	if (0 != myTexture)
+	{
+		::glDeleteTextures(1, std::addressof(myTexture));
+		myTexture = 0;
+	}
+
+	if (0 != myVertexBuffer)
+	{
+		::glDeleteBuffers(1, std::addressof(myVertexBuffer));
+		myVertexBuffer = 0;
+	}
+
+	if (0 != myIndexBuffer)
+	{
+		::glDeleteBuffers(1, std::addressof(myIndexBuffer));
+		myIndexBuffer = 0;
+	}
+
+	if (0 != myVertexArray)
+	{
+		::glDeleteVertexArrays(1, std::addressof(myVertexArray));
+		myVertexArray = 0;
+	}
+
+	myPipeline.reset();
+	myCapacity = 0;
+}
+
+void
+gl::TextBatch::Begin(const std::array<float, 16>& projection)
+noexcept
+{
+	myProjection = projection;
+
+	myCharacters.clear();
+	myRequests.clear();
+}
+
+void
+gl::TextBatch::Draw(std::string_view text, float x, float y, float size, const gl::Colour& colour)
+{
+	if (text.empty())
+	{
+		return;
+	}
+
+	myRequests.push_back(Request{ myCharacters.size(), text.size(), x, y, size, PackColour(colour) });
+	myCharacters.append(text);
+}
+
+void
+gl::TextBatch::End()
+{
+	text::Statistics statistics{};
+	statistics.texts = myRequests.size();
+
+	if (myRequests.empty() || not IsCreated())
+	{
+		myStatistics = statistics;
+		return;
+	}
+
+	// Shaping a text may start the atlas over, which moves the glyphs of the texts shaped before it
+	for (std::uint32_t attempt = 0; attempt < 2; ++attempt)
+	{
+		const std::uint64_t generation = myAtlas->GetGeneration();
+		myVertices.clear();
+
+		for (const Request& request : myRequests)
+		{
+			const font::ShapedRun& run = myAtlas->Shape(std::string_view{ myCharacters }.substr(request.offset, request.length));
+			text::GenerateQuads(*myAtlas, run, request.x, request.y, request.size, request.colour, myVertices);
+		}
+
+		if (generation == myAtlas->GetGeneration())
+		{
+			break;
+		}
+
+		++statistics.rebuilds;
+	}
+
+	const std::size_t quads = myVertices.size() / 4;
+	statistics.glyphs = quads;
+
+	::glActiveTexture(GL_TEXTURE0);
+	::glBindTexture(GL_TEXTURE_2D, myTexture);
+
+	if (const std::optional<font::Rect> dirty = myAtlas->TakeDirtyRect(); dirty)
+	{
+		const std::uint32_t row = myAtlas->GetSize();
+		const std::uint8_t* const first = myAtlas->GetPixels().data() + static_cast<std::size_t>(dirty->y) * row + dirty->x;
+
+		::glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		::glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(row));
+		::glTexSubImage2D(GL_TEXTURE_2D, 0
+			, static_cast<GLint>(dirty->x), static_cast<GLint>(dirty->y)
+			, static_cast<GLsizei>(dirty->width), static_cast<GLsizei>(dirty->height)
+			, GL_RED, GL_UNSIGNED_BYTE, first);
+		::glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		::glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		statistics.uploadedBytes = static_cast<std::uint64_t>(dirty->width) * dirty->height;
+	}
+
+	if (0 < quads)
+	{
+		Reserve(quads);
+
+		// Orphaned every batch, so writing it never waits for the previous draw
+		const GLsizeiptr capacity_bytes = static_cast<GLsizeiptr>(myCapacity * 4 * sizeof(sprite::Vertex));
+		::glBindBuffer(GL_ARRAY_BUFFER, myVertexBuffer);
+		::glBufferData(GL_ARRAY_BUFFER, capacity_bytes, nullptr, GL_STREAM_DRAW);
+		::glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(myVertices.size() * sizeof(sprite::Vertex)), myVertices.data());
+		::glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		myPipeline->Use();
+		::glUniformMatrix4fv(0, 1, GL_FALSE, myProjection.data());
+		::glBindVertexArray(myVertexArray);
+
+		{
+			Blender blender{ DefaultAlpha };
+			::glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(quads * 6), GL_UNSIGNED_INT, nullptr);
+		}
+
+		++statistics.drawCalls;
+
+		::glBindVertexArray(0);
+		::glUseProgram(0);
+	}
+
+	::glBindTexture(GL_TEXTURE_2D, 0);
+
+	myStatistics = statistics;
+}
+
+gl::text::Extent
+gl::TextBatch::Measure(std::string_view text, float size)
+{
+	const font::ShapedRun& run = myAtlas->Shape(text);
+	const float scale = size / static_cast<float>(myAtlas->GetGlyphSize());
+
+	return text::Extent{ run.width * scale, run.height * scale };
+}
+
+gl::FontAtlas&
+gl::TextBatch::GetAtlas()
+const noexcept
+{
+	return *myAtlas;
+}
+
+const gl::text::Statistics&
+gl::TextBatch::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+bool
+gl::TextBatch::IsCreated()
+const noexcept
+{
+	return nullptr != myPipeline && 0 != myVertexArray;
+}
+
+void
+gl::TextBatch::Reserve(std::size_t quads)
+noexcept
+{
+	if (quads <= myCapacity)
+	{
+		return;
+	}
+
+	myCapacity = std::max(quads, std::max(InitialCapacity, myCapacity * 2));
+
+	std::vector<std::uint32_t> indices(myCapacity * 6);
+	for (std::size_t quad = 0; quad < myCapacity; ++quad)
+	{
+		for (std::size_t i = 0; i < 6; ++i)
+		{
+			indices[quad * 6 + i] = static_cast<std::uint32_t>(quad * 4 + QuadIndices[i]);
+		}
+	}
+
+	// Bound through the vertex array, which keeps the element buffer
+	::glBindVertexArray(myVertexArray);
+	::glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(std::uint32_t)), indices.data(), GL_STATIC_DRAW);
+	::glBindVertexArray(0);
+}
@@ -1,10 +1,144 @@
 module;
 #include <Windows.h>
-#include <gl/GL.h>
+#include "glew.h"
+#include <GL/GL.h>
 #undef LoadImage
 
 module Glib.Texture;
 import <stdexcept>;
+import Glib.Residency;
+import Glib.Png;
+
+namespace
+{
+	[[nodiscard]]
+	constexpr bool
+	HasMipmaps(const gl::texture::FilterMode& filter)
+	noexcept
+	{
+		switch (filter)
+		{
+			case gl::texture::FilterMode::NearestMipmapNearest:
+			case gl::texture::FilterMode::LinearMipmapNearest:
+			case gl::texture::FilterMode::NearestMipmapLinear:
+			case gl::texture::FilterMode::LinearMipmapLinear:
+			{
+				return true;
+			}
+
+			default:
+			{
+				return false;
+			}
+		}
+	}
+
+	// Colour keeps A, R, G, B in memory, which is BGRA read from the most significant byte
+	void
+	UploadPixels(const gl::texture::Blob& blob)
+	noexcept
+	{
+		::glBindTexture(GL_TEXTURE_2D, blob.textureID);
+		::glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0
+			, static_cast<GLsizei>(blob.width), static_cast<GLsizei>(blob.height)
+			, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8, blob.imgBuffer.get());
+
+		if (HasMipmaps(blob.minFilter))
+		{
+			::glGenerateMipmap(GL_TEXTURE_2D);
+		}
+	}
+
+	void
+	Register(gl::texture::Blob& blob, const std::uint32_t& mip_levels)
+	{
+		gl::residency::Tracker* const tracker = gl::residency::GetTracker();
+		if (nullptr == tracker)
+		{
+			return;
+		}
+
+		const std::size_t base_bytes = blob.width * blob.height * sizeof(gl::BitmapPixel);
+		const bool has_pixels = nullptr != blob.imgBuffer;
+
+		// The blob can be swapped or destroyed before the tracker calls back
+		blob.residencyAnchor = std::make_shared<gl::texture::Blob*>(std::addressof(blob));
+
+		std::function<void()> release_cpu_copy = [anchor = blob.residencyAnchor]() noexcept {
+			if (gl::texture::Blob* const target = *anchor; nullptr != target)
+			{
+				target->imgBuffer = nullptr;
+			}
+		};
+
+		std::function<void()> reload = nullptr;
+		if (has_pixels)
+		{
+			reload = [anchor = blob.residencyAnchor]() noexcept {
+				if (gl::texture::Blob* const target = *anchor; nullptr != target && nullptr != target->imgBuffer)
+				{
+					UploadPixels(*target);
+				}
+			};
+		}
+
+		blob.residencyHandle = tracker->OnCreate(gl::residency::ResourceKind::Texture, blob.textureID, base_bytes, mip_levels
+			, has_pixels ? base_bytes : 0
+			, std::move(release_cpu_copy), std::move(reload));
+
+		if (has_pixels)
+		{
+			tracker->OnUpload(blob.residencyHandle);
+		}
+	}
+
+	/// <summary>
+	/// Create the opengl texture of the blob, upload its pixels and report it to the tracker
+	/// </summary>
+	void
+	Create(gl::texture::Blob& blob)
+	{
+		const std::uint32_t mip_levels = HasMipmaps(blob.minFilter) ? gl::residency::ComputeMipLevels(blob.width, blob.height) : 1;
+
+		::glGenTextures(1, std::addressof(blob.textureID));
+		::glBindTexture(GL_TEXTURE_2D, blob.textureID);
+		::glTexStorage2D(GL_TEXTURE_2D, static_cast<GLsizei>(mip_levels), GL_RGBA8
+			, static_cast<GLsizei>(blob.width), static_cast<GLsizei>(blob.height));
+		::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLint>(blob.hWrap));
+		::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLint>(blob.vWrap));
+		::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(blob.minFilter));
+		::glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(blob.magFilter));
+
+		if (nullptr != blob.imgBuffer)
+		{
+			UploadPixels(blob);
+		}
+
+		Register(blob, mip_levels);
+	}
+}
+
+gl::texture::Blob::~Blob()
+noexcept
+{
+	if (residency::InvalidHandle != residencyHandle)
+	{
+		if (residency::Tracker* const tracker = residency::GetTracker(); nullptr != tracker)
+		{
+			tracker->OnDestroy(residencyHandle);
+		}
+	}
+
+	if (residencyAnchor)
+	{
+		*residencyAnchor = nullptr;
+	}
+
+	if (0 != textureID)
+	{
+		::glDeleteTextures(1, std::addressof(textureID));
+	}
+}
 
 gl::Texture::Texture(gl::Image&& image)
 	: base()
@@ -14,6 +148,9 @@ gl::Texture::Texture(gl::Image&& image)
 	myBlob->imgBuffer = std::move(image.GetBuffer());
 	myBlob->width = image.GetWidth();
 	myBlob->height = image.GetHeight();
+
+	Create(*myBlob);
+	myID = myBlob->textureID;
 }
 
 void
@@ -22,7 +159,16 @@ const noexcept
 {
 	if (myBlob)
 	{
+		global::NotifyStateChange();
 		glBindTexture(GL_TEXTURE_2D, myID);
+
+		if (residency::InvalidHandle != myBlob->residencyHandle)
+		{
+			if (residency::Tracker* const tracker = residency::GetTracker(); nullptr != tracker)
+			{
+				tracker->OnUse(myBlob->residencyHandle);
+			}
+		}
 	}
 }
 
@@ -30,6 +176,7 @@ void
 gl::Texture::Unbind()
 const noexcept
 {
+	global::NotifyStateChange();
 	glBindTexture(GL_TEXTURE_2D, 0);
 }
 
@@ -64,6 +211,25 @@ noexcept
 	myID = 0;
 }
 
+void
+gl::Texture::ReleaseCpuCopy()
+noexcept
+{
+	if (myBlob)
+	{
+		// Told first, as an evicted texture is uploaded again from the copy
+		if (residency::InvalidHandle != myBlob->residencyHandle)
+		{
+			if (residency::Tracker* const tracker = residency::GetTracker(); nullptr != tracker)
+			{
+				tracker->OnReleaseCpuCopy(myBlob->residencyHandle);
+			}
+		}
+
+		myBlob->imgBuffer = nullptr;
+	}
+}
+
 gl::Texture
 gl::Texture::EmptyTexture(std::uint32_t w, std::uint32_t h)
 noexcept
@@ -92,6 +258,9 @@ gl::Texture::Texture(const gl::FilePath& path
 	myBlob->vWrap = vwrap;
 	myBlob->minFilter = min;
 	myBlob->magFilter = mag;
+
+	Create(*myBlob);
+	myID = myBlob->textureID;
 }
 
 gl::Texture
@@ -134,7 +303,7 @@ noexcept
 
 	output.Destroy();
 
-	if (path.extension() == ".png")
+	if (png::HasPngExtension(path))
 	{
 		output = gl::Texture(path);
 		return true;
@@ -249,3 +418,10 @@ const noexcept
 {
 	return myBlob == nullptr;
 }
+
+bool
+gl::Texture::HasCpuCopy()
+const noexcept
+{
+	return myBlob && nullptr != myBlob->imgBuffer;
+}
@@ -12,6 +12,8 @@ void
 gl::transform::LoadIdentity()
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glLoadIdentity();
 }
 
@@ -19,6 +21,8 @@ void
 gl::transform::LookAt(float x, float y, float z, float tx, float ty, float tz, float ux, float uy, float uz)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::gluLookAt(double(x), double(y), double(z), double(tx), double(ty), double(tz), double(ux), double(uy), double(uz));
 }
 
@@ -26,6 +30,8 @@ void
 gl::transform::LookAt(double x, double y, double z, double tx, double ty, double tz, double ux, double uy, double uz)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::gluLookAt(x, y, z, tx, ty, tz, ux, uy, uz);
 }
 
@@ -33,6 +39,8 @@ void
 gl::transform::Projection(float fov, float aspect, float near, float far)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::gluPerspective(double(fov), double(aspect), double(near), double(far));
 }
 
@@ -40,6 +48,8 @@ void
 gl::transform::Projection(double fov, double aspect, double near, double far)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::gluPerspective(fov, aspect, near, far);
 }
 
@@ -47,6 +57,8 @@ void
 gl::transform::Ortho(float left, float right, float bottom, float top, float near, float far)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glOrtho(double(left), double(right), double(bottom), double(top), double(near), double(far));
 }
 
@@ -54,6 +66,8 @@ void
 gl::transform::Ortho(double left, double right, double bottom, double top, double near, double far)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glOrtho(left, right, bottom, top, near, far);
 }
 
@@ -61,6 +75,8 @@ void
 gl::transform::Translate(float x, float y, float z)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glTranslatef(x, y, z);
 }
 
@@ -68,6 +84,8 @@ void
 gl::transform::Translate(double x, double y, double z)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glTranslated(x, y, z);
 }
 
@@ -75,6 +93,8 @@ void
 gl::transform::Rotate(float angle, float x, float y, float z)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glRotatef(angle, x, y, z);
 }
 
@@ -82,6 +102,8 @@ void
 gl::transform::Rotate(double angle, double x, double y, double z)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glRotated(angle, x, y, z);
 }
 
@@ -89,6 +111,8 @@ void
 gl::transform::Scale(float x, float y, float z)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glScalef(x, y, z);
 }
 
@@ -96,6 +120,8 @@ void
 gl::transform::Scale(double x, double y, double z)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glScaled(x, y, z);
 }
 
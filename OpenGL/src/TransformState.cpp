@@ -9,6 +9,8 @@ void
 gl::transform::SetMode(gl::TransformMode mode)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glMatrixMode(static_cast<GLenum>(mode));
 }
 
@@ -16,6 +18,8 @@ void
 gl::transform::PushState()
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glPushMatrix();
 	::glLoadIdentity();
 }
@@ -24,18 +28,24 @@ void
 gl::transform::PopState()
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glPopMatrix();
 }
 
 gl::transform::Context::Context()
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glPushMatrix();
 }
 
 gl::transform::Context::Context(gl::TransformMode mode)
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glPushMatrix();
 	::glMatrixMode(static_cast<GLenum>(mode));
 	::glLoadIdentity();
@@ -44,5 +54,7 @@ noexcept
 gl::transform::Context::~Context()
 noexcept
 {
+	global::NotifyStateChange();
+
 	::glPopMatrix();
 }
@@ -0,0 +1,1485 @@
+module;
+#define NOMINMAX
+#include <Windows.h>
+#include "glew.h"
+#include <gl\gl.h>
+
+module Glib.VectorGraphics;
+import <cmath>;
+import <string_view>;
+import <limits>;
+import <algorithm>;
+import <bit>;
+import <utility>;
+import <chrono>;
+import <random>;
+
+namespace
+{
+	constexpr std::string_view VertexSource = R"(#version 430 core
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec4 colour;
+
+layout(location = 0) uniform mat4 projection;
+
+out vec4 shapeColour;
+
+void main()
+{
+	shapeColour = colour;
+	gl_Position = projection * vec4(position, 0.0, 1.0);
+}
+)";
+
+	constexpr std::string_view FragmentSource = R"(#version 430 core
+in vec4 shapeColour;
+
+out vec4 fragment;
+
+void main()
+{
+	fragment = shapeColour;
+}
+)";
+
+	constexpr float Pi = 3.14159265358979f;
+	// Points closer than this are merged before the tessellation
+	constexpr float MergeDistanceSquared = 1e-10f;
+
+	// Lengths of the dashes and the gaps, in multiples of the width
+	constexpr float DashPattern[] = { 4, 2 };
+	constexpr float DotsPattern[] = { 1, 1 };
+	constexpr float DashDotPattern[] = { 4, 2, 1, 2 };
+
+	constexpr std::uint64_t HashOffset = 14695981039346656037ULL;
+	constexpr std::uint64_t HashPrime = 1099511628211ULL;
+
+	[[nodiscard]]
+	constexpr std::uint64_t
+		HashCombine(std::uint64_t hash, std::uint64_t value)
+		noexcept
+	{
+		for (std::uint32_t i = 0; i < 8; ++i)
+		{
+			hash ^= (value >> (i * 8)) & 0xFFU;
+			hash *= HashPrime;
+		}
+
+		return hash;
+	}
+
+	/// <summary>
+	/// A coordinate in 256ths of a pixel, so the rounding of a translation does not change the shape
+	/// </summary>
+	[[nodiscard]]
+	std::int32_t
+		Quantize(float value)
+		noexcept
+	{
+		return static_cast<std::int32_t>(std::lround(value * 256.0f));
+	}
+
+	/// <summary>
+	/// The points of a path relative to its first one and its contours, as the cache compares them
+	/// </summary>
+	void
+		QuantizeShape(const gl::vector::Path& path, std::vector<std::int32_t>& points, std::vector<std::uint32_t>& contours)
+	{
+		const gl::vector::Point origin = path.GetOrigin();
+
+		points.clear();
+		for (const gl::vector::Point& point : path.GetPoints())
+		{
+			points.push_back(Quantize(point.x - origin.x));
+			points.push_back(Quantize(point.y - origin.y));
+		}
+
+		const std::span<const std::uint32_t> ends = path.GetContourEnds();
+
+		contours.clear();
+		for (std::size_t contour = 0; contour < ends.size(); ++contour)
+		{
+			contours.push_back(ends[contour] << 1 | (path.IsClosed(contour) ? 1U : 0U));
+		}
+	}
+
+	[[nodiscard]]
+	constexpr gl::vector::Point
+		operator+(const gl::vector::Point& lhs, const gl::vector::Point& rhs)
+		noexcept
+	{
+		return gl::vector::Point{ lhs.x + rhs.x, lhs.y + rhs.y };
+	}
+
+	[[nodiscard]]
+	constexpr gl::vector::Point
+		operator-(const gl::vector::Point& lhs, const gl::vector::Point& rhs)
+		noexcept
+	{
+		return gl::vector::Point{ lhs.x - rhs.x, lhs.y - rhs.y };
+	}
+
+	[[nodiscard]]
+	constexpr gl::vector::Point
+		operator*(const gl::vector::Point& point, float scale)
+		noexcept
+	{
+		return gl::vector::Point{ point.x * scale, point.y * scale };
+	}
+
+	[[nodiscard]]
+	constexpr float
+		Cross(const gl::vector::Point& lhs, const gl::vector::Point& rhs)
+		noexcept
+	{
+		return lhs.x * rhs.y - lhs.y * rhs.x;
+	}
+
+	[[nodiscard]]
+	constexpr float
+		Dot(const gl::vector::Point& lhs, const gl::vector::Point& rhs)
+		noexcept
+	{
+		return lhs.x * rhs.x + lhs.y * rhs.y;
+	}
+
+	[[nodiscard]]
+	constexpr float
+		DistanceSquared(const gl::vector::Point& lhs, const gl::vector::Point& rhs)
+		noexcept
+	{
+		const gl::vector::Point delta = lhs - rhs;
+		return Dot(delta, delta);
+	}
+
+	[[nodiscard]]
+	gl::vector::Point
+		Normalize(const gl::vector::Point& point)
+		noexcept
+	{
+		const float length = std::sqrt(Dot(point, point));
+		return 0 < length ? point * (1.0f / length) : gl::vector::Point{ 0, 0 };
+	}
+
+	[[nodiscard]]
+	constexpr gl::vector::Point
+		Rotate(const gl::vector::Point& point, float cos, float sin)
+		noexcept
+	{
+		return gl::vector::Point{ point.x * cos - point.y * sin, point.x * sin + point.y * cos };
+	}
+
+	/// <summary>
+	/// Segments an arc of a radius needs so its chords stay within the tolerance
+	/// </summary>
+	[[nodiscard]]
+	std::uint32_t
+		GetArcSegments(float radius, float sweep)
+		noexcept
+	{
+		sweep = std::abs(sweep);
+
+		float step = Pi * 0.5f;
+		if (gl::vector::DefaultTolerance < radius)
+		{
+			step = std::min(step, 2.0f * std::acos(1.0f - gl::vector::DefaultTolerance / radius));
+		}
+
+		return std::max(1U, static_cast<std::uint32_t>(std::ceil(sweep / step)));
+	}
+
+	/// <summary>
+	/// Copy a contour without the repeated points, nor the last point of a closed contour when it repeats the first
+	/// </summary>
+	void
+		CleanContour(std::span<const gl::vector::Point> points, bool closed, std::vector<gl::vector::Point>& output)
+	{
+		output.clear();
+
+		for (const gl::vector::Point& point : points)
+		{
+			if (output.empty() || MergeDistanceSquared < DistanceSquared(output.back(), point))
+			{
+				output.push_back(point);
+			}
+		}
+
+		if (closed && 1 < output.size() && DistanceSquared(output.front(), output.back()) <= MergeDistanceSquared)
+		{
+			output.pop_back();
+		}
+	}
+
+	void
+		AppendTriangle(gl::vector::Mesh& output, std::uint32_t a, std::uint32_t b, std::uint32_t c)
+	{
+		output.indices.push_back(a);
+		output.indices.push_back(b);
+		output.indices.push_back(c);
+	}
+
+	[[nodiscard]]
+	std::uint32_t
+		AppendPosition(gl::vector::Mesh& output, const gl::vector::Point& point)
+	{
+		output.positions.push_back(point);
+		return static_cast<std::uint32_t>(output.positions.size() - 1);
+	}
+
+	/// <summary>
+	/// A fan around the center, from its offset by the start and turning by the sweep
+	/// </summary>
+	void
+		AppendArcFan(gl::vector::Mesh& output, const gl::vector::Point& center, const gl::vector::Point& start, float sweep)
+	{
+		const std::uint32_t segments = GetArcSegments(std::sqrt(Dot(start, start)), sweep);
+		const float step = sweep / static_cast<float>(segments);
+
+		const std::uint32_t middle = AppendPosition(output, center);
+		std::uint32_t previous = AppendPosition(output, center + start);
+
+		for (std::uint32_t i = 1; i <= segments; ++i)
+		{
+			const float angle = step * static_cast<float>(i);
+			const std::uint32_t current = AppendPosition(output, center + Rotate(start, std::cos(angle), std::sin(angle)));
+
+			AppendTriangle(output, middle, previous, current);
+			previous = current;
+		}
+	}
+
+	[[nodiscard]]
+	bool
+		IsInside(const gl::vector::Point& point, const gl::vector::Point& a, const gl::vector::Point& b, const gl::vector::Point& c, float orientation)
+		noexcept
+	{
+		return 0 <= Cross(b - a, point - a) * orientation
+			&& 0 <= Cross(c - b, point - b) * orientation
+			&& 0 <= Cross(a - c, point - c) * orientation;
+	}
+
+	void
+		FillContour(std::span<const gl::vector::Point> polygon, gl::vector::Mesh& output)
+	{
+		const std::size_t count = polygon.size();
+		if (count < 3)
+		{
+			return;
+		}
+
+		float area = 0;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			area += Cross(polygon[i], polygon[(i + 1) % count]);
+		}
+
+		if (std::abs(area) <= std::numeric_limits<float>::epsilon())
+		{
+			return;
+		}
+
+		const float orientation = 0 < area ? 1.0f : -1.0f;
+		const std::uint32_t base = static_cast<std::uint32_t>(output.positions.size());
+		output.positions.insert(output.positions.end(), polygon.begin(), polygon.end());
+
+		const auto turn = [&](std::size_t previous, std::size_t current, std::size_t next) noexcept {
+			return Cross(polygon[current] - polygon[previous], polygon[next] - polygon[current]) * orientation;
+		};
+
+		// Circles and rounded rectangles never turn back, a fan covers them
+		bool convex = true;
+		for (std::size_t i = 0; i < count && convex; ++i)
+		{
+			convex = 0 <= turn((i + count - 1) % count, i, (i + 1) % count);
+		}
+
+		if (convex)
+		{
+			for (std::uint32_t i = 1; i + 1 < count; ++i)
+			{
+				AppendTriangle(output, base, base + i, base + i + 1);
+			}
+
+			return;
+		}
+
+		std::vector<std::uint32_t> remaining(count);
+		for (std::uint32_t i = 0; i < count; ++i)
+		{
+			remaining[i] = i;
+		}
+
+		std::size_t cursor = 0;
+		// Vertices tried since the last ear, a full round without one means the contour crosses itself
+		std::size_t failures = 0;
+
+		while (3 < remaining.size())
+		{
+			const std::size_t size = remaining.size();
+			cursor %= size;
+
+			const std::uint32_t previous = remaining[(cursor + size - 1) % size];
+			const std::uint32_t current = remaining[cursor];
+			const std::uint32_t next = remaining[(cursor + 1) % size];
+
+			bool ear = 0 < turn(previous, current, next);
+			for (std::size_t i = 0; i < size && ear; ++i)
+			{
+				const std::uint32_t other = remaining[i];
+				if (other == previous || other == current || other == next)
+				{
+					continue;
+				}
+
+				// Only the reflex vertices can be inside an ear
+				const std::uint32_t before = remaining[(i + size - 1) % size];
+				const std::uint32_t after = remaining[(i + 1) % size];
+				if (0 < turn(before, other, after))
+				{
+					continue;
+				}
+
+				ear = not IsInside(polygon[other], polygon[previous], polygon[current], polygon[next], orientation);
+			}
+
+			if (ear || size <= failures)
+			{
+				AppendTriangle(output, base + previous, base + current, base + next);
+				remaining.erase(remaining.begin() + static_cast<std::ptrdiff_t>(cursor));
+				failures = 0;
+			}
+			else
+			{
+				++cursor;
+				++failures;
+			}
+		}
+
+		AppendTriangle(output, base + remaining[0], base + remaining[1], base + remaining[2]);
+	}
+
+	void
+		StrokePolyline(std::span<const gl::vector::Point> points, bool closed, const gl::vector::Stroke& stroke, gl::vector::Mesh& output)
+	{
+		using gl::vector::Point;
+		using gl::vector::LineCap;
+		using gl::vector::LineJoin;
+
+		const float half = stroke.width * 0.5f;
+		const std::size_t count = points.size();
+
+		if (0 == count)
+		{
+			return;
+		}
+
+		if (1 == count)
+		{
+			// A dash or a path of a single point still leaves a dot with a square or a round cap
+			if (LineCap::Round == stroke.cap)
+			{
+				AppendArcFan(output, points[0], Point{ half, 0 }, 2.0f * Pi);
+			}
+			else if (LineCap::Square == stroke.cap)
+			{
+				const std::uint32_t first = AppendPosition(output, points[0] + Point{ -half, -half });
+				static_cast<void>(AppendPosition(output, points[0] + Point{ half, -half }));
+				static_cast<void>(AppendPosition(output, points[0] + Point{ half, half }));
+				static_cast<void>(AppendPosition(output, points[0] + Point{ -half, half }));
+
+				AppendTriangle(output, first, first + 1, first + 2);
+				AppendTriangle(output, first + 2, first + 3, first);
+			}
+
+			return;
+		}
+
+		closed = closed && 2 < count;
+		const std::size_t segments = closed ? count : count - 1;
+
+		const auto direction = [&](std::size_t segment) noexcept {
+			return Normalize(points[(segment + 1) % count] - points[segment]);
+		};
+
+		// A turn moves the inner corners of both of its segments to where their inner edges cross, so a translucent pen
+		// covers every pixel once. Returns the sign of the normal of the inner side, or zero when the quads keep their corners
+		// because the corner would fall past the middle of a segment, which still overlaps
+		const auto inner_corner = [&](std::size_t vertex, Point& corner) noexcept {
+			if (not closed && (0 == vertex || count - 1 == vertex))
+			{
+				return 0.0f;
+			}
+
+			const std::size_t before = (vertex + count - 1) % count;
+			const Point incoming = direction(before);
+			const Point outgoing = direction(vertex);
+			const float cross = Cross(incoming, outgoing);
+
+			if (std::abs(cross) <= 1e-6f)
+			{
+				return 0.0f;
+			}
+
+			// Half of the width by the tangent of half of the turn
+			const float trim = half * std::abs(cross) / (1.0f + Dot(incoming, outgoing));
+			const float shortest = std::min(DistanceSquared(points[before], points[vertex]), DistanceSquared(points[vertex], points[(vertex + 1) % count]));
+
+			if (not (4.0f * trim * trim <= shortest))
+			{
+				return 0.0f;
+			}
+
+			const float side = 0 < cross ? -1.0f : 1.0f;
+			corner = points[vertex] + Point{ incoming.y, -incoming.x } * (side * half) - incoming * trim;
+			return -side;
+		};
+
+		for (std::size_t segment = 0; segment < segments; ++segment)
+		{
+			Point begin = points[segment];
+			Point end = points[(segment + 1) % count];
+			const Point forward = direction(segment);
+			const Point normal = Point{ -forward.y, forward.x } * half;
+
+			Point begin_corner{}, end_corner{};
+			const float begin_side = inner_corner(segment, begin_corner);
+			const float end_side = inner_corner((segment + 1) % count, end_corner);
+
+			if (not closed && LineCap::Square == stroke.cap)
+			{
+				if (0 == segment)
+				{
+					begin = begin - forward * half;
+				}
+
+				if (segments == segment + 1)
+				{
+					end = end + forward * half;
+				}
+			}
+
+			const std::uint32_t first = AppendPosition(output, 0 < begin_side ? begin_corner : begin + normal);
+			static_cast<void>(AppendPosition(output, begin_side < 0 ? begin_corner : begin - normal));
+			static_cast<void>(AppendPosition(output, end_side < 0 ? end_corner : end - normal));
+			static_cast<void>(AppendPosition(output, 0 < end_side ? end_corner : end + normal));
+
+			AppendTriangle(output, first, first + 1, first + 2);
+			AppendTriangle(output, first + 2, first + 3, first);
+		}
+
+		// The joins fill the wedge left on the outer side of a turn, from the inner corner the quads share
+		const std::size_t first_join = closed ? 0 : 1;
+		const std::size_t last_join = closed ? count : count - 1;
+
+		for (std::size_t vertex = first_join; vertex < last_join; ++vertex)
+		{
+			const Point incoming = direction((vertex + count - 1) % count);
+			const Point outgoing = direction(vertex);
+			const float cross = Cross(incoming, outgoing);
+			const float dot = Dot(incoming, outgoing);
+
+			if (std::abs(cross) <= 1e-6f && 0 < dot)
+			{
+				continue;
+			}
+
+			const Point& center = points[vertex];
+			const float side = 0 < cross ? -1.0f : 1.0f;
+			const Point outer_in = Point{ -incoming.y, incoming.x } * (side * half);
+			const Point outer_out = Point{ -outgoing.y, outgoing.x } * (side * half);
+
+			Point corner{};
+			const bool shared = 0 != inner_corner(vertex, corner);
+			const Point& apex = shared ? corner : center;
+
+			LineJoin join = stroke.join;
+			if (LineJoin::Miter == join)
+			{
+				const Point bisector = Normalize(outer_in + outer_out);
+				const float cos_half = Dot(bisector, outer_in) / half;
+
+				if (cos_half <= 0 || stroke.miterLimit < 1.0f / cos_half)
+				{
+					join = LineJoin::Bevel;
+				}
+				else
+				{
+					const std::uint32_t middle = AppendPosition(output, apex);
+					const std::uint32_t a = AppendPosition(output, center + outer_in);
+					const std::uint32_t tip = AppendPosition(output, center + bisector * (half / cos_half));
+					const std::uint32_t b = AppendPosition(output, center + outer_out);
+
+					AppendTriangle(output, middle, a, tip);
+					AppendTriangle(output, middle, tip, b);
+					continue;
+				}
+			}
+
+			if (LineJoin::Round == join)
+			{
+				// A line turning back on itself goes around through the direction it came from
+				const float sweep = std::abs(cross) <= 1e-6f ? -side * Pi : std::atan2(Cross(outer_in, outer_out), Dot(outer_in, outer_out));
+				AppendArcFan(output, center, outer_in, sweep);
+
+				if (shared)
+				{
+					// Between the fan and the inner corner
+					const std::uint32_t middle = AppendPosition(output, corner);
+					const std::uint32_t a = AppendPosition(output, center + outer_in);
+					const std::uint32_t pivot = AppendPosition(output, center);
+					const std::uint32_t b = AppendPosition(output, center + outer_out);
+
+					AppendTriangle(output, middle, a, pivot);
+					AppendTriangle(output, middle, pivot, b);
+				}
+			}
+			else if (1e-6f < std::abs(cross))
+			{
+				const std::uint32_t middle = AppendPosition(output, apex);
+				const std::uint32_t a = AppendPosition(output, center + outer_in);
+				const std::uint32_t b = AppendPosition(output, center + outer_out);
+
+				AppendTriangle(output, middle, a, b);
+			}
+		}
+
+		if (not closed && LineCap::Round == stroke.cap)
+		{
+			const Point start = direction(0);
+			const Point finish = direction(segments - 1);
+
+			AppendArcFan(output, points[0], Point{ -start.y, start.x } * half, Pi);
+			AppendArcFan(output, points[count - 1], Point{ finish.y, -finish.x } * half, Pi);
+		}
+	}
+
+	/// <summary>
+	/// Cut a contour into the dashes of a pattern and stroke them as open lines
+	/// </summary>
+	void
+		StrokeDashes(std::span<const gl::vector::Point> points, bool closed, std::span<const float> pattern, const gl::vector::Stroke& stroke, gl::vector::Mesh& output)
+	{
+		using gl::vector::Point;
+
+		const std::size_t count = points.size();
+		if (count < 2)
+		{
+			StrokePolyline(points, false, stroke, output);
+			return;
+		}
+
+		const float scale = std::max(stroke.width, 1.0f);
+		const std::size_t segments = closed ? count : count - 1;
+
+		std::vector<Point> dash{ points[0] };
+		std::size_t phase = 0;
+		float remaining = pattern[0] * scale;
+		bool drawing = true;
+
+		for (std::size_t segment = 0; segment < segments; ++segment)
+		{
+			const Point& begin = points[segment];
+			const Point& end = points[(segment + 1) % count];
+			const float length = std::sqrt(DistanceSquared(begin, end));
+
+			float position = 0;
+			while (remaining < length - position)
+			{
+				position += remaining;
+				const Point cut = begin + (end - begin) * (position / length);
+
+				if (drawing)
+				{
+					dash.push_back(cut);
+					StrokePolyline(dash, false, stroke, output);
+					dash.clear();
+				}
+				else
+				{
+					dash.assign(1, cut);
+				}
+
+				drawing = not drawing;
+				phase = (phase + 1) % pattern.size();
+				remaining = pattern[phase] * scale;
+			}
+
+			remaining -= length - position;
+			if (drawing)
+			{
+				dash.push_back(end);
+			}
+		}
+
+		if (drawing && 1 < dash.size())
+		{
+			StrokePolyline(dash, false, stroke, output);
+		}
+	}
+}
+
+void
+gl::vector::Mesh::Clear()
+noexcept
+{
+	positions.clear();
+	indices.clear();
+}
+
+gl::vector::Path&
+gl::vector::Path::MoveTo(float x, float y)
+{
+	myPoints.push_back(Point{ x, y });
+	myContourEnds.push_back(static_cast<std::uint32_t>(myPoints.size()));
+	myClosedContours.push_back(false);
+	isOpen = true;
+
+	return *this;
+}
+
+gl::vector::Path&
+gl::vector::Path::LineTo(float x, float y)
+{
+	// A line without an open contour starts one
+	if (not isOpen)
+	{
+		return MoveTo(x, y);
+	}
+
+	myPoints.push_back(Point{ x, y });
+	myContourEnds.back() = static_cast<std::uint32_t>(myPoints.size());
+
+	return *this;
+}
+
+gl::vector::Path&
+gl::vector::Path::QuadraticTo(float control_x, float control_y, float x, float y)
+{
+	if (not isOpen)
+	{
+		return MoveTo(x, y);
+	}
+
+	const Point begin = myPoints.back();
+	const Point control{ control_x, control_y };
+	const Point end{ x, y };
+
+	// The chords of a quadratic curve in n pieces are off by at most |p0 - 2c + p2| / (8 n^2)
+	const Point curvature = begin - control * 2.0f + end;
+	const float deviation = std::sqrt(Dot(curvature, curvature)) / (8.0f * DefaultTolerance);
+	const std::uint32_t segments = std::max(1U, static_cast<std::uint32_t>(std::ceil(std::sqrt(deviation))));
+
+	for (std::uint32_t i = 1; i <= segments; ++i)
+	{
+		const float t = static_cast<float>(i) / static_cast<float>(segments);
+		const float u = 1.0f - t;
+
+		LineTo(u * u * begin.x + 2 * u * t * control.x + t * t * end.x
+			, u * u * begin.y + 2 * u * t * control.y + t * t * end.y);
+	}
+
+	return *this;
+}
+
+gl::vector::Path&
+gl::vector::Path::Close()
+noexcept
+{
+	if (isOpen)
+	{
+		myClosedContours.back() = true;
+		isOpen = false;
+	}
+
+	return *this;
+}
+
+gl::vector::Path&
+gl::vector::Path::AddRect(float x, float y, float width, float height)
+{
+	MoveTo(x, y);
+	LineTo(x + width, y);
+	LineTo(x + width, y + height);
+	LineTo(x, y + height);
+
+	return Close();
+}
+
+gl::vector::Path&
+gl::vector::Path::AddRoundedRect(float x, float y, float width, float height, float radius)
+{
+	radius = std::clamp(radius, 0.0f, std::min(std::abs(width), std::abs(height)) * 0.5f);
+	if (radius <= 0)
+	{
+		return AddRect(x, y, width, height);
+	}
+
+	const float right = x + width;
+	const float bottom = y + height;
+
+	MoveTo(x + radius, y);
+	LineTo(right - radius, y);
+	AddArc(right - radius, y + radius, radius, radius, -0.5f * Pi, 0);
+	LineTo(right, bottom - radius);
+	AddArc(right - radius, bottom - radius, radius, radius, 0, 0.5f * Pi);
+	LineTo(x + radius, bottom);
+	AddArc(x + radius, bottom - radius, radius, radius, 0.5f * Pi, Pi);
+	LineTo(x, y + radius);
+	AddArc(x + radius, y + radius, radius, radius, Pi, 1.5f * Pi);
+
+	return Close();
+}
+
+gl::vector::Path&
+gl::vector::Path::AddCircle(float center_x, float center_y, float radius)
+{
+	return AddEllipse(center_x, center_y, radius, radius);
+}
+
+gl::vector::Path&
+gl::vector::Path::AddEllipse(float center_x, float center_y, float radius_x, float radius_y)
+{
+	MoveTo(center_x + radius_x, center_y);
+	AddArc(center_x, center_y, radius_x, radius_y, 0, 2.0f * Pi);
+
+	return Close();
+}
+
+void
+gl::vector::Path::Clear()
+noexcept
+{
+	myPoints.clear();
+	myContourEnds.clear();
+	myClosedContours.clear();
+	isOpen = false;
+}
+
+std::uint64_t
+gl::vector::Path::GetHash()
+const noexcept
+{
+	const Point origin = GetOrigin();
+
+	std::uint64_t result = HashOffset;
+	for (std::size_t contour = 0; contour < myContourEnds.size(); ++contour)
+	{
+		result = HashCombine(result, static_cast<std::uint64_t>(myContourEnds[contour]) << 1 | (myClosedContours[contour] ? 1U : 0U));
+	}
+
+	for (const Point& point : myPoints)
+	{
+		result = HashCombine(result, static_cast<std::uint64_t>(static_cast<std::uint32_t>(Quantize(point.x - origin.x))) << 32 | static_cast<std::uint32_t>(Quantize(point.y - origin.y)));
+	}
+
+	return result;
+}
+
+gl::vector::Point
+gl::vector::Path::GetOrigin()
+const noexcept
+{
+	return myPoints.empty() ? Point{ 0, 0 } : myPoints.front();
+}
+
+bool
+gl::vector::Path::IsEmpty()
+const noexcept
+{
+	return myPoints.empty();
+}
+
+std::span<const gl::vector::Point>
+gl::vector::Path::GetPoints()
+const noexcept
+{
+	return myPoints;
+}
+
+std::span<const std::uint32_t>
+gl::vector::Path::GetContourEnds()
+const noexcept
+{
+	return myContourEnds;
+}
+
+bool
+gl::vector::Path::IsClosed(std::size_t contour)
+const noexcept
+{
+	return myClosedContours[contour];
+}
+
+void
+gl::vector::Path::AddArc(float center_x, float center_y, float radius_x, float radius_y, float begin, float end)
+{
+	const float sweep = end - begin;
+	const std::uint32_t segments = std::max(GetArcSegments(std::max(radius_x, radius_y), sweep), static_cast<std::uint32_t>(std::ceil(std::abs(sweep) / (Pi * 0.5f))));
+
+	for (std::uint32_t i = 1; i <= segments; ++i)
+	{
+		const float angle = begin + sweep * static_cast<float>(i) / static_cast<float>(segments);
+		LineTo(center_x + radius_x * std::cos(angle), center_y + radius_y * std::sin(angle));
+	}
+}
+
+void
+gl::vector::TessellateFill(const gl::vector::Path& path, gl::vector::Mesh& output)
+{
+	const std::span<const Point> points = path.GetPoints();
+	const std::span<const std::uint32_t> ends = path.GetContourEnds();
+
+	std::vector<Point> polygon{};
+	std::uint32_t begin = 0;
+
+	for (const std::uint32_t& end : ends)
+	{
+		// Every contour is filled as if it were closed
+		CleanContour(points.subspan(begin, end - begin), true, polygon);
+		FillContour(polygon, output);
+
+		begin = end;
+	}
+}
+
+void
+gl::vector::TessellateStroke(const gl::vector::Path& path, const gl::vector::Stroke& stroke, gl::vector::Mesh& output)
+{
+	if (stroke.width <= 0)
+	{
+		return;
+	}
+
+	std::span<const float> pattern{};
+	switch (stroke.dash)
+	{
+		case DashStyle::Dash:
+		{
+			pattern = DashPattern;
+		}
+		break;
+
+		case DashStyle::Dots:
+		{
+			pattern = DotsPattern;
+		}
+		break;
+
+		case DashStyle::DashDot:
+		{
+			pattern = DashDotPattern;
+		}
+		break;
+
+		default:
+		{}
+		break;
+	}
+
+	const std::span<const Point> points = path.GetPoints();
+	const std::span<const std::uint32_t> ends = path.GetContourEnds();
+
+	std::vector<Point> line{};
+	std::uint32_t begin = 0;
+
+	for (std::size_t contour = 0; contour < ends.size(); ++contour)
+	{
+		const bool closed = path.IsClosed(contour);
+		CleanContour(points.subspan(begin, ends[contour] - begin), closed, line);
+
+		if (pattern.empty())
+		{
+			StrokePolyline(line, closed, stroke, output);
+		}
+		else
+		{
+			StrokeDashes(line, closed, pattern, stroke, output);
+		}
+
+		begin = ends[contour];
+	}
+}
+
+std::size_t
+gl::vector::TessellationCache::BeginFrame()
+noexcept
+{
+	++myFrame;
+
+	return std::erase_if(myEntries, [this](const auto& pair) noexcept {
+		return DefaultCacheLifetime < myFrame - pair.second.lastFrame;
+	});
+}
+
+const gl::vector::Mesh&
+gl::vector::TessellationCache::GetFill(const gl::vector::Path& path, bool& hit)
+{
+	QuantizeShape(path, myShape.points, myShape.contours);
+	myShape.isStroke = false;
+	myShape.width = myShape.miterLimit = 0;
+	myShape.join = LineJoin::Miter;
+	myShape.cap = LineCap::Butt;
+	myShape.dash = DashStyle::Solid;
+
+	Entry& entry = Find(myShape, hit);
+
+	if (not hit)
+	{
+		TessellateFill(path, entry.mesh);
+
+		const Point origin = path.GetOrigin();
+		for (Point& position : entry.mesh.positions)
+		{
+			position = position - origin;
+		}
+	}
+
+	return entry.mesh;
+}
+
+const gl::vector::Mesh&
+gl::vector::TessellationCache::GetStroke(const gl::vector::Path& path, const gl::vector::Stroke& stroke, bool& hit)
+{
+	QuantizeShape(path, myShape.points, myShape.contours);
+	myShape.isStroke = true;
+	myShape.width = stroke.width;
+	myShape.miterLimit = stroke.miterLimit;
+	myShape.join = stroke.join;
+	myShape.cap = stroke.cap;
+	myShape.dash = stroke.dash;
+
+	Entry& entry = Find(myShape, hit);
+
+	if (not hit)
+	{
+		TessellateStroke(path, stroke, entry.mesh);
+
+		const Point origin = path.GetOrigin();
+		for (Point& position : entry.mesh.positions)
+		{
+			position = position - origin;
+		}
+	}
+
+	return entry.mesh;
+}
+
+void
+gl::vector::TessellationCache::Clear()
+noexcept
+{
+	myEntries.clear();
+}
+
+std::size_t
+gl::vector::TessellationCache::GetSize()
+const noexcept
+{
+	return myEntries.size();
+}
+
+gl::vector::TessellationCache::Entry&
+gl::vector::TessellationCache::Find(const gl::vector::TessellationCache::Shape& shape, bool& hit)
+{
+	// The fills and the strokes of the same path are told apart by the first word
+	std::uint64_t key = HashCombine(HashOffset, shape.isStroke ? 1U : 0U);
+	key = HashCombine(key, static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(shape.width)) << 32 | std::bit_cast<std::uint32_t>(shape.miterLimit));
+	key = HashCombine(key, static_cast<std::uint64_t>(shape.join) | static_cast<std::uint64_t>(shape.cap) << 8 | static_cast<std::uint64_t>(shape.dash) << 16);
+
+	for (const std::uint32_t& contour : shape.contours)
+	{
+		key = HashCombine(key, contour);
+	}
+
+	for (std::size_t i = 0; i + 1 < shape.points.size(); i += 2)
+	{
+		key = HashCombine(key, static_cast<std::uint64_t>(static_cast<std::uint32_t>(shape.points[i])) << 32 | static_cast<std::uint32_t>(shape.points[i + 1]));
+	}
+
+	auto [it, inserted] = myEntries.try_emplace(key);
+	Entry& entry = it->second;
+	entry.lastFrame = myFrame;
+
+	hit = not inserted && shape == entry.shape;
+	if (not hit)
+	{
+		entry.mesh.Clear();
+		entry.shape = shape;
+	}
+
+	return entry;
+}
+
+gl::vector::Benchmark
+gl::vector::MeasureTessellation(std::size_t paths, std::uint32_t iterations)
+{
+	using clock = std::chrono::steady_clock;
+
+	std::mt19937 engine{ 47 };
+	std::uniform_real_distribution<float> position{ 0.0f, 1920.0f };
+	std::uniform_real_distribution<float> size{ 4.0f, 128.0f };
+	std::uniform_real_distribution<float> offset{ -64.0f, 64.0f };
+
+	std::vector<Path> shapes(paths);
+	std::vector<Stroke> strokes(paths);
+
+	for (std::size_t i = 0; i < paths; ++i)
+	{
+		Path& path = shapes[i];
+		Stroke& stroke = strokes[i];
+		stroke.width = 1.0f + static_cast<float>(i % 4);
+		stroke.join = static_cast<LineJoin>(i % 3);
+		stroke.cap = static_cast<LineCap>(i % 3);
+
+		const float x = position(engine);
+		const float y = position(engine);
+
+		switch (i % 3)
+		{
+			case 0:
+			{
+				path.MoveTo(x, y);
+				for (std::uint32_t j = 0; j < 16; ++j)
+				{
+					path.LineTo(x + offset(engine), y + offset(engine));
+				}
+			}
+			break;
+
+			case 1:
+			{
+				path.AddRoundedRect(x, y, size(engine), size(engine), size(engine) * 0.125f);
+			}
+			break;
+
+			default:
+			{
+				path.AddCircle(x, y, size(engine));
+			}
+			break;
+		}
+	}
+
+	iterations = std::max(1U, iterations);
+
+	Benchmark result{};
+	result.paths = paths;
+
+	Mesh mesh{};
+	double best = std::numeric_limits<double>::max();
+
+	for (std::uint32_t i = 0; i < iterations; ++i)
+	{
+		const auto start = clock::now();
+
+		std::size_t vertices = 0;
+		for (std::size_t j = 0; j < paths; ++j)
+		{
+			mesh.Clear();
+			TessellateFill(shapes[j], mesh);
+			TessellateStroke(shapes[j], strokes[j], mesh);
+			vertices += mesh.positions.size();
+		}
+
+		best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+		result.vertices = vertices;
+	}
+
+	result.tessellatedPerSecond = static_cast<double>(paths) / std::max(best, 1e-9);
+
+	TessellationCache cache{};
+	best = std::numeric_limits<double>::max();
+
+	for (std::uint32_t i = 0; i <= iterations; ++i)
+	{
+		const auto start = clock::now();
+
+		bool hit = false;
+		for (std::size_t j = 0; j < paths; ++j)
+		{
+			static_cast<void>(cache.GetFill(shapes[j], hit));
+			static_cast<void>(cache.GetStroke(shapes[j], strokes[j], hit));
+		}
+
+		// The first round fills the cache
+		if (0 < i)
+		{
+			best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+		}
+	}
+
+	result.cachedPerSecond = static_cast<double>(paths) / std::max(best, 1e-9);
+
+	return result;
+}
+
+gl::vector::Stroke
+gl::vector::MakeStroke(const gl::win32::resource::Pen& pen)
+noexcept
+{
+	using gl::win32::resource::PenStyles;
+
+	// Wide pens of GDI are geometric, with round joins and round ends
+	Stroke result{};
+	result.colour = pen.GetColor();
+	result.width = static_cast<float>(std::max(pen.GetSize(), 1));
+	result.join = LineJoin::Round;
+	result.cap = LineCap::Round;
+
+	switch (pen.GetStyle())
+	{
+		case PenStyles::None:
+		{
+			result.width = 0;
+		}
+		break;
+
+		case PenStyles::Dash:
+		{
+			result.dash = DashStyle::Dash;
+			result.cap = LineCap::Butt;
+		}
+		break;
+
+		case PenStyles::Dots:
+		{
+			result.dash = DashStyle::Dots;
+			result.cap = LineCap::Butt;
+		}
+		break;
+
+		case PenStyles::DashDot:
+		{
+			result.dash = DashStyle::DashDot;
+			result.cap = LineCap::Butt;
+		}
+		break;
+
+		default:
+		{}
+		break;
+	}
+
+	return result;
+}
+
+gl::Colour
+gl::vector::GetBrushColour(const gl::win32::resource::ColorBrush& brush)
+noexcept
+{
+	::LOGBRUSH info{};
+	if (0 == ::GetObjectW(brush.GetHandle(), sizeof(info), std::addressof(info)))
+	{
+		return win32::colors::Black;
+	}
+
+	if (BS_NULL == info.lbStyle)
+	{
+		return win32::MakeColor(0, 0, 0, 0);
+	}
+
+	// Patterns are drawn in their colour
+	return win32::MakeColor(static_cast<win32::RawRGB>(info.lbColor));
+}
+
+gl::Colour
+gl::vector::GetComponentColour(gl::win32::ColoredComponent component)
+noexcept
+{
+	return win32::MakeColor(static_cast<win32::RawRGB>(::GetSysColor(static_cast<int>(component))));
+}
+
+gl::VectorRenderer::~VectorRenderer()
+noexcept
+{
+	Destroy();
+}
+
+bool
+gl::VectorRenderer::Create()
+noexcept
+{
+	if (IsCreated())
+	{
+		return true;
+	}
+
+	myPipeline = std::make_unique<Pipeline>();
+
+	Shader vertex_shader{ shader::ShaderType::Vertex };
+	Shader fragment_shader{ shader::ShaderType::Fragment };
+
+	if (not myPipeline->IsValid()
+		|| shader::ErrorCode::Success != vertex_shader.Compile(VertexSource)
+		|| shader::ErrorCode::Success != fragment_shader.Compile(FragmentSource))
+	{
+		myPipeline.reset();
+		return false;
+	}
+
+	myPipeline->AddShader(std::move(vertex_shader));
+	myPipeline->AddShader(std::move(fragment_shader));
+	myPipeline->Start();
+
+	GLint linked = GL_FALSE;
+	::glGetProgramiv(myPipeline->GetID(), GL_LINK_STATUS, std::addressof(linked));
+	if (GL_FALSE == linked)
+	{
+		myPipeline.reset();
+		return false;
+	}
+
+	::glGenVertexArrays(1, std::addressof(myVertexArray));
+	::glGenBuffers(1, std::addressof(myVertexBuffer));
+	::glGenBuffers(1, std::addressof(myIndexBuffer));
+
+	::glBindVertexArray(myVertexArray);
+	::glBindBuffer(GL_ARRAY_BUFFER, myVertexBuffer);
+
+	constexpr GLsizei stride = sizeof(vector::Vertex);
+
+	::glEnableVertexAttribArray(0);
+	::glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(vector::Vertex, x)));
+	::glEnableVertexAttribArray(1);
+	::glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(vector::Vertex, colour)));
+
+	::glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, myIndexBuffer);
+
+	::glBindVertexArray(0);
+	::glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return true;
+}
+
+void
+gl::VectorRenderer::Destroy()
+noexcept
+{
+	if (0 != myVertexBuffer)
+	{
+		::glDeleteBuffers(1, std::addressof(myVertexBuffer));
+		myVertexBuffer = 0;
+	}
+
+	if (0 != myIndexBuffer)
+	{
+		::glDeleteBuffers(1, std::addressof(myIndexBuffer));
+		myIndexBuffer = 0;
+	}
+
+	if (0 != myVertexArray)
+	{
+		::glDeleteVertexArrays(1, std::addressof(myVertexArray));
+		myVertexArray = 0;
+	}
+
+	myPipeline.reset();
+	myCache.Clear();
+}
+
+void
+gl::VectorRenderer::Begin(const std::array<float, 16>& projection)
+noexcept
+{
+	myProjection = projection;
+
+	myVertices.clear();
+	myIndices.clear();
+
+	myStatistics = vector::Statistics{};
+	myStatistics.evicted = myCache.BeginFrame();
+}
+
+void
+gl::VectorRenderer::Fill(const gl::vector::Path& path, const gl::Colour& colour)
+{
+	if (path.IsEmpty() || 0 == colour.A)
+	{
+		return;
+	}
+
+	bool hit = false;
+	const vector::Mesh& mesh = myCache.GetFill(path, hit);
+
+	++myStatistics.paths;
+	++(hit ? myStatistics.cacheHits : myStatistics.cacheMisses);
+
+	Append(mesh, path.GetOrigin(), colour);
+}
+
+void
+gl::VectorRenderer::Draw(const gl::vector::Path& path, const gl::vector::Stroke& stroke)
+{
+	if (path.IsEmpty() || stroke.width <= 0 || 0 == stroke.colour.A)
+	{
+		return;
+	}
+
+	bool hit = false;
+	const vector::Mesh& mesh = myCache.GetStroke(path, stroke, hit);
+
+	++myStatistics.paths;
+	++(hit ? myStatistics.cacheHits : myStatistics.cacheMisses);
+
+	Append(mesh, path.GetOrigin(), stroke.colour);
+}
+
+void
+gl::VectorRenderer::DrawLine(float x0, float y0, float x1, float y1, const gl::vector::Stroke& stroke)
+{
+	myScratchPath.Clear();
+	myScratchPath.MoveTo(x0, y0).LineTo(x1, y1);
+
+	Draw(myScratchPath, stroke);
+}
+
+void
+gl::VectorRenderer::DrawPolyline(std::span<const gl::vector::Point> points, bool closed, const gl::vector::Stroke& stroke)
+{
+	if (points.empty())
+	{
+		return;
+	}
+
+	myScratchPath.Clear();
+	myScratchPath.MoveTo(points[0].x, points[0].y);
+	for (const vector::Point& point : points.subspan(1))
+	{
+		myScratchPath.LineTo(point.x, point.y);
+	}
+
+	if (closed)
+	{
+		myScratchPath.Close();
+	}
+
+	Draw(myScratchPath, stroke);
+}
+
+void
+gl::VectorRenderer::FillPolygon(std::span<const gl::vector::Point> points, const gl::Colour& colour)
+{
+	if (points.empty())
+	{
+		return;
+	}
+
+	myScratchPath.Clear();
+	myScratchPath.MoveTo(points[0].x, points[0].y);
+	for (const vector::Point& point : points.subspan(1))
+	{
+		myScratchPath.LineTo(point.x, point.y);
+	}
+
+	Fill(myScratchPath.Close(), colour);
+}
+
+void
+gl::VectorRenderer::DrawRect(float x, float y, float width, float height, const gl::vector::Stroke& stroke)
+{
+	myScratchPath.Clear();
+	Draw(myScratchPath.AddRect(x, y, width, height), stroke);
+}
+
+void
+gl::VectorRenderer::FillRect(float x, float y, float width, float height, const gl::Colour& colour)
+{
+	myScratchPath.Clear();
+	Fill(myScratchPath.AddRect(x, y, width, height), colour);
+}
+
+void
+gl::VectorRenderer::DrawRoundedRect(float x, float y, float width, float height, float radius, const gl::vector::Stroke& stroke)
+{
+	myScratchPath.Clear();
+	Draw(myScratchPath.AddRoundedRect(x, y, width, height, radius), stroke);
+}
+
+void
+gl::VectorRenderer::FillRoundedRect(float x, float y, float width, float height, float radius, const gl::Colour& colour)
+{
+	myScratchPath.Clear();
+	Fill(myScratchPath.AddRoundedRect(x, y, width, height, radius), colour);
+}
+
+void
+gl::VectorRenderer::DrawCircle(float center_x, float center_y, float radius, const gl::vector::Stroke& stroke)
+{
+	myScratchPath.Clear();
+	Draw(myScratchPath.AddCircle(center_x, center_y, radius), stroke);
+}
+
+void
+gl::VectorRenderer::FillCircle(float center_x, float center_y, float radius, const gl::Colour& colour)
+{
+	myScratchPath.Clear();
+	Fill(myScratchPath.AddCircle(center_x, center_y, radius), colour);
+}
+
+void
+gl::VectorRenderer::End()
+{
+	myStatistics.vertices = myVertices.size();
+	myStatistics.indices = myIndices.size();
+
+	if (myIndices.empty() || not IsCreated())
+	{
+		return;
+	}
+
+	GLint previous_program = 0, previous_array = 0, previous_buffer = 0;
+	::glGetIntegerv(GL_CURRENT_PROGRAM, std::addressof(previous_program));
+	::glGetIntegerv(GL_VERTEX_ARRAY_BINDING, std::addressof(previous_array));
+	::glGetIntegerv(GL_ARRAY_BUFFER_BINDING, std::addressof(previous_buffer));
+
+	// Orphaned every frame, so writing them never waits for the previous draw
+	::glBindVertexArray(myVertexArray);
+	::glBindBuffer(GL_ARRAY_BUFFER, myVertexBuffer);
+	::glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(myVertices.size() * sizeof(vector::Vertex)), myVertices.data(), GL_STREAM_DRAW);
+	::glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(myIndices.size() * sizeof(std::uint32_t)), myIndices.data(), GL_STREAM_DRAW);
+
+	myPipeline->Use();
+	::glUniformMatrix4fv(0, 1, GL_FALSE, myProjection.data());
+
+	{
+		Blender blender{ DefaultAlpha };
+		::glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(myIndices.size()), GL_UNSIGNED_INT, nullptr);
+	}
+
+	++myStatistics.drawCalls;
+
+	::glBindVertexArray(static_cast<GLuint>(previous_array));
+	::glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(previous_buffer));
+	::glUseProgram(static_cast<GLuint>(previous_program));
+}
+
+const gl::vector::Statistics&
+gl::VectorRenderer::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+bool
+gl::VectorRenderer::IsCreated()
+const noexcept
+{
+	return nullptr != myPipeline && 0 != myVertexArray;
+}
+
+void
+gl::VectorRenderer::Append(const gl::vector::Mesh& mesh, const gl::vector::Point& origin, const gl::Colour& colour)
+{
+	const std::uint32_t base = static_cast<std::uint32_t>(myVertices.size());
+	const std::uint32_t packed = PackColour(colour);
+
+	for (const vector::Point& position : mesh.positions)
+	{
+		myVertices.push_back(vector::Vertex{ position.x + origin.x, position.y + origin.y, packed });
+	}
+
+	for (const std::uint32_t& index : mesh.indices)
+	{
+		myIndices.push_back(base + index);
+	}
+}
@@ -0,0 +1,539 @@
+module;
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GLIB_PACKING_F16C 1
+#define GLIB_PACKING_SSE2 1
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define GLIB_PACKING_F16C 0
+#define GLIB_PACKING_SSE2 1
+#else
+#define GLIB_PACKING_F16C 0
+#define GLIB_PACKING_SSE2 0
+#endif
+
+module Glib.VertexPacking;
+import <cmath>;
+import <bit>;
+import <algorithm>;
+import <limits>;
+import <vector>;
+import <chrono>;
+import <random>;
+
+namespace
+{
+	constexpr float SnormScale = 511.0f;
+	constexpr float UnormScale = 1023.0f;
+	constexpr float OctahedralScale = 32767.0f;
+
+	[[nodiscard]]
+	std::uint32_t
+	QuantizeSnorm(float value, float scale)
+	noexcept
+	{
+		return static_cast<std::uint32_t>(std::lrint(std::clamp(value, -1.0f, 1.0f) * scale));
+	}
+
+	[[nodiscard]]
+	std::uint32_t
+	QuantizeUnorm(float value, float scale)
+	noexcept
+	{
+		return static_cast<std::uint32_t>(std::lrint(std::clamp(value, 0.0f, 1.0f) * scale));
+	}
+
+	[[nodiscard]]
+	std::uint32_t
+	Combine(std::uint32_t x, std::uint32_t y, std::uint32_t z, std::uint32_t w)
+	noexcept
+	{
+		return (x & 0x3FF) | (y & 0x3FF) << 10 | (z & 0x3FF) << 20 | (w & 0x3) << 30;
+	}
+
+	[[nodiscard]]
+	std::array<float, 4>
+	ReadVector(const float* source, std::uint32_t components)
+	noexcept
+	{
+		return { source[0], source[1], source[2], 4 <= components ? source[3] : 0.0f };
+	}
+
+	[[nodiscard]]
+	gl::vertex::Octahedral
+	EncodeOctahedral(float x, float y, float z)
+	noexcept
+	{
+		const float sum = std::abs(x) + std::abs(y) + std::abs(z);
+		const float inverse = 0 < sum ? 1.0f / sum : 0.0f;
+
+		x *= inverse;
+		y *= inverse;
+		z *= inverse;
+
+		// The lower half folds over the diagonals
+		if (z < 0)
+		{
+			const float folded_x = std::copysign(1.0f - std::abs(y), x);
+			const float folded_y = std::copysign(1.0f - std::abs(x), y);
+
+			x = folded_x;
+			y = folded_y;
+		}
+
+		return { static_cast<std::int16_t>(std::lrint(x * OctahedralScale)), static_cast<std::int16_t>(std::lrint(y * OctahedralScale)) };
+	}
+
+#if GLIB_PACKING_SSE2
+	/// <summary>
+	/// Rounds to the nearest even like the scalar one, by Fabian Giesen
+	/// </summary>
+	[[nodiscard]]
+	__m128i
+	FloatToHalf(__m128 value)
+	noexcept
+	{
+		const __m128i sign_mask = _mm_set1_epi32(static_cast<int>(0x80000000u));
+		const __m128i half_max = _mm_set1_epi32((127 + 16) << 23);
+		const __m128i nan_bit = _mm_set1_epi32(0x200);
+		const __m128i infinity = _mm_set1_epi32(0x7C00);
+		const __m128i min_normal = _mm_set1_epi32((127 - 14) << 23);
+		const __m128i subnormal_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+		const __m128i normal_bias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+		const __m128 sign = _mm_and_ps(_mm_castsi128_ps(sign_mask), value);
+		const __m128 absolute = _mm_xor_ps(value, sign);
+		const __m128i absolute_bits = _mm_castps_si128(absolute);
+
+		const __m128i is_nan = _mm_castps_si128(_mm_cmpunord_ps(absolute, absolute));
+		const __m128i is_regular = _mm_cmpgt_epi32(half_max, absolute_bits);
+		const __m128i special = _mm_or_si128(_mm_and_si128(is_nan, nan_bit), infinity);
+
+		// The subnormal results are rounded by the addition itself
+		const __m128i is_subnormal = _mm_cmpgt_epi32(min_normal, absolute_bits);
+		const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absolute, _mm_castsi128_ps(subnormal_magic))), subnormal_magic);
+
+		const __m128i mantissa_odd = _mm_srai_epi32(_mm_slli_epi32(absolute_bits, 31 - 13), 31);
+		const __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absolute_bits, normal_bias), mantissa_odd), 13);
+
+		const __m128i finite = _mm_or_si128(_mm_and_si128(is_subnormal, subnormal), _mm_andnot_si128(is_subnormal, normal));
+		const __m128i joined = _mm_or_si128(_mm_and_si128(is_regular, finite), _mm_andnot_si128(is_regular, special));
+
+		// The sign shifted down keeps the lanes negative, so the saturating pack leaves them as they are
+		return _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+	}
+
+	[[nodiscard]]
+	__m128
+	HalfToFloat(__m128i value)
+	noexcept
+	{
+		const __m128i no_sign = _mm_set1_epi32(0x7FFF);
+		const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+		const __m128i largest_finite = _mm_set1_epi32(0x7BFF);
+		const __m128 special_exponent = _mm_castsi128_ps(_mm_set1_epi32(255 << 23));
+
+		const __m128i exponent_mantissa = _mm_and_si128(no_sign, value);
+		const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponent_mantissa, 13)), magic);
+		const __m128i was_special = _mm_cmpgt_epi32(exponent_mantissa, largest_finite);
+		const __m128i sign = _mm_slli_epi32(_mm_xor_si128(value, exponent_mantissa), 16);
+
+		const __m128 special = _mm_and_ps(_mm_castsi128_ps(was_special), special_exponent);
+
+		return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), special));
+	}
+
+	/// <summary>
+	/// Split four vectors of three floats into their components
+	/// </summary>
+	void
+	Deinterleave3(const float* source, __m128& x, __m128& y, __m128& z)
+	noexcept
+	{
+		const __m128 a = _mm_loadu_ps(source);
+		const __m128 b = _mm_loadu_ps(source + 4);
+		const __m128 c = _mm_loadu_ps(source + 8);
+
+		const __m128 x23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));
+		x = _mm_shuffle_ps(a, x23, _MM_SHUFFLE(2, 0, 3, 0));
+
+		const __m128 y01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+		const __m128 y23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+		y = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0));
+
+		const __m128 z01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+		const __m128 z23 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+		z = _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	void
+	LoadVectors(const float* source, std::uint32_t components, __m128& x, __m128& y, __m128& z, __m128& w)
+	noexcept
+	{
+		if (4 <= components)
+		{
+			x = _mm_loadu_ps(source);
+			y = _mm_loadu_ps(source + 4);
+			z = _mm_loadu_ps(source + 8);
+			w = _mm_loadu_ps(source + 12);
+
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+		}
+		else
+		{
+			Deinterleave3(source, x, y, z);
+			w = _mm_setzero_ps();
+		}
+	}
+
+	/// <summary>
+	/// Quantize the components of four vectors and combine them into 10, 10, 10 and 2 bits
+	/// </summary>
+	[[nodiscard]]
+	__m128i
+	Combine(__m128 x, __m128 y, __m128 z, __m128 w, __m128 low, float scale, float w_scale)
+	noexcept
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 component_scale = _mm_set1_ps(scale);
+
+		const __m128i xi = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(x, low), one), component_scale));
+		const __m128i yi = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(y, low), one), component_scale));
+		const __m128i zi = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(z, low), one), component_scale));
+		const __m128i wi = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(w, low), one), _mm_set1_ps(w_scale)));
+
+		const __m128i mask = _mm_set1_epi32(0x3FF);
+
+		__m128i result = _mm_and_si128(xi, mask);
+		result = _mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(yi, mask), 10));
+		result = _mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(zi, mask), 20));
+
+		return _mm_or_si128(result, _mm_slli_epi32(wi, 30));
+	}
+#endif
+}
+
+gl::vertex::Half
+gl::vertex::ToHalf(float value)
+noexcept
+{
+	constexpr std::uint32_t infinity = 255U << 23;
+	constexpr std::uint32_t half_max = (127U + 16) << 23;
+	constexpr std::uint32_t subnormal_magic = ((127U - 15) + (23 - 10) + 1) << 23;
+
+	std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+	const std::uint32_t sign = bits & 0x80000000u;
+	bits ^= sign;
+
+	std::uint32_t result;
+	if (half_max <= bits)
+	{
+		// Infinities stay, NaNs become quiet
+		result = infinity < bits ? 0x7E00 : 0x7C00;
+	}
+	else if (bits < (113U << 23))
+	{
+		const float rounded = std::bit_cast<float>(bits) + std::bit_cast<float>(subnormal_magic);
+		result = std::bit_cast<std::uint32_t>(rounded) - subnormal_magic;
+	}
+	else
+	{
+		const std::uint32_t mantissa_odd = (bits >> 13) & 1;
+
+		bits += (static_cast<std::uint32_t>(15 - 127) << 23) + 0xFFF;
+		bits += mantissa_odd;
+		result = bits >> 13;
+	}
+
+	return Half{ static_cast<std::uint16_t>(result | sign >> 16) };
+}
+
+float
+gl::vertex::FromHalf(Half value)
+noexcept
+{
+	constexpr std::uint32_t shifted_exponent = 0x7C00U << 13;
+	constexpr float magic = std::bit_cast<float>(113U << 23);
+
+	std::uint32_t bits = (value.bits & 0x7FFFU) << 13;
+	const std::uint32_t exponent = shifted_exponent & bits;
+
+	bits += (127U - 15) << 23;
+
+	if (exponent == shifted_exponent)
+	{
+		bits += (128U - 16) << 23;
+	}
+	else if (0 == exponent)
+	{
+		// Renormalize the subnormals
+		bits += 1U << 23;
+		bits = std::bit_cast<std::uint32_t>(std::bit_cast<float>(bits) - magic);
+	}
+
+	return std::bit_cast<float>(bits | (value.bits & 0x8000U) << 16);
+}
+
+void
+gl::vertex::PackHalf(std::span<const float> source, std::span<Half> destination)
+noexcept
+{
+	const std::size_t count = std::min(source.size(), destination.size());
+	std::size_t i = 0;
+
+#if GLIB_PACKING_F16C
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(source.data() + i), _MM_FROUND_TO_NEAREST_INT);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination.data() + i), halves);
+	}
+#elif GLIB_PACKING_SSE2
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i low = FloatToHalf(_mm_loadu_ps(source.data() + i));
+		const __m128i high = FloatToHalf(_mm_loadu_ps(source.data() + i + 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination.data() + i), _mm_packs_epi32(low, high));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		destination[i] = ToHalf(source[i]);
+	}
+}
+
+void
+gl::vertex::UnpackHalf(std::span<const Half> source, std::span<float> destination)
+noexcept
+{
+	const std::size_t count = std::min(source.size(), destination.size());
+	std::size_t i = 0;
+
+#if GLIB_PACKING_F16C
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source.data() + i));
+		_mm256_storeu_ps(destination.data() + i, _mm256_cvtph_ps(halves));
+	}
+#elif GLIB_PACKING_SSE2
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source.data() + i));
+		const __m128i zero = _mm_setzero_si128();
+
+		_mm_storeu_ps(destination.data() + i, HalfToFloat(_mm_unpacklo_epi16(halves, zero)));
+		_mm_storeu_ps(destination.data() + i + 4, HalfToFloat(_mm_unpackhi_epi16(halves, zero)));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		destination[i] = FromHalf(source[i]);
+	}
+}
+
+void
+gl::vertex::PackSnorm(std::span<const float> source, std::span<PackedSnorm> destination, std::uint32_t components)
+noexcept
+{
+	components = std::clamp(components, 3U, 4U);
+
+	const std::size_t count = std::min(source.size() / components, destination.size());
+	std::size_t i = 0;
+
+#if GLIB_PACKING_SSE2
+	const __m128 low = _mm_set1_ps(-1.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z, w;
+		LoadVectors(source.data() + i * components, components, x, y, z, w);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination.data() + i), Combine(x, y, z, w, low, SnormScale, 1.0f));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const auto v = ReadVector(source.data() + i * components, components);
+
+		destination[i].bits = Combine(QuantizeSnorm(v[0], SnormScale), QuantizeSnorm(v[1], SnormScale), QuantizeSnorm(v[2], SnormScale), QuantizeSnorm(v[3], 1.0f));
+	}
+}
+
+void
+gl::vertex::PackUnorm(std::span<const float> source, std::span<PackedUnorm> destination, std::uint32_t components)
+noexcept
+{
+	components = std::clamp(components, 3U, 4U);
+
+	const std::size_t count = std::min(source.size() / components, destination.size());
+	std::size_t i = 0;
+
+#if GLIB_PACKING_SSE2
+	const __m128 low = _mm_setzero_ps();
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z, w;
+		LoadVectors(source.data() + i * components, components, x, y, z, w);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination.data() + i), Combine(x, y, z, w, low, UnormScale, 3.0f));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const auto v = ReadVector(source.data() + i * components, components);
+
+		destination[i].bits = Combine(QuantizeUnorm(v[0], UnormScale), QuantizeUnorm(v[1], UnormScale), QuantizeUnorm(v[2], UnormScale), QuantizeUnorm(v[3], 3.0f));
+	}
+}
+
+void
+gl::vertex::PackOctahedral(std::span<const float> normals, std::span<Octahedral> destination)
+noexcept
+{
+	const std::size_t count = std::min(normals.size() / 3, destination.size());
+	std::size_t i = 0;
+
+#if GLIB_PACKING_SSE2
+	const __m128 sign_mask = _mm_set1_ps(-0.0f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 scale = _mm_set1_ps(OctahedralScale);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z;
+		Deinterleave3(normals.data() + i * 3, x, y, z);
+
+		const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(sign_mask, x), _mm_andnot_ps(sign_mask, y)), _mm_andnot_ps(sign_mask, z));
+		const __m128 inverse = _mm_and_ps(_mm_cmpgt_ps(sum, zero), _mm_div_ps(one, sum));
+
+		x = _mm_mul_ps(x, inverse);
+		y = _mm_mul_ps(y, inverse);
+		z = _mm_mul_ps(z, inverse);
+
+		const __m128 folded_x = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(sign_mask, y)), _mm_and_ps(sign_mask, x));
+		const __m128 folded_y = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(sign_mask, x)), _mm_and_ps(sign_mask, y));
+
+		const __m128 lower = _mm_cmplt_ps(z, zero);
+		x = _mm_or_ps(_mm_and_ps(lower, folded_x), _mm_andnot_ps(lower, x));
+		y = _mm_or_ps(_mm_and_ps(lower, folded_y), _mm_andnot_ps(lower, y));
+
+		const __m128i xi = _mm_cvtps_epi32(_mm_mul_ps(x, scale));
+		const __m128i yi = _mm_cvtps_epi32(_mm_mul_ps(y, scale));
+
+		const __m128i packed = _mm_packs_epi32(_mm_unpacklo_epi32(xi, yi), _mm_unpackhi_epi32(xi, yi));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination.data() + i), packed);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		destination[i] = EncodeOctahedral(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+	}
+}
+
+std::array<float, 4>
+gl::vertex::Unpack(PackedSnorm value)
+noexcept
+{
+	const std::int32_t bits = static_cast<std::int32_t>(value.bits);
+
+	// Shift each component to the top, so the arithmetic shift extends its sign
+	const float x = static_cast<float>(static_cast<std::int32_t>(value.bits << 22) >> 22);
+	const float y = static_cast<float>(static_cast<std::int32_t>(value.bits << 12) >> 22);
+	const float z = static_cast<float>(static_cast<std::int32_t>(value.bits << 2) >> 22);
+	const float w = static_cast<float>(bits >> 30);
+
+	return { std::max(x / SnormScale, -1.0f), std::max(y / SnormScale, -1.0f), std::max(z / SnormScale, -1.0f), std::max(w, -1.0f) };
+}
+
+std::array<float, 4>
+gl::vertex::Unpack(PackedUnorm value)
+noexcept
+{
+	return {
+		static_cast<float>(value.bits & 0x3FF) / UnormScale,
+		static_cast<float>(value.bits >> 10 & 0x3FF) / UnormScale,
+		static_cast<float>(value.bits >> 20 & 0x3FF) / UnormScale,
+		static_cast<float>(value.bits >> 30) / 3.0f
+	};
+}
+
+std::array<float, 3>
+gl::vertex::Unpack(Octahedral value)
+noexcept
+{
+	float x = std::max(value.x / OctahedralScale, -1.0f);
+	float y = std::max(value.y / OctahedralScale, -1.0f);
+	const float z = 1.0f - std::abs(x) - std::abs(y);
+
+	// Unfold the lower half
+	const float t = std::max(-z, 0.0f);
+	x += 0 <= x ? -t : t;
+	y += 0 <= y ? -t : t;
+
+	const float length = std::sqrt(x * x + y * y + z * z);
+
+	return { x / length, y / length, z / length };
+}
+
+gl::vertex::Benchmark
+gl::vertex::MeasurePacking(std::size_t values, std::uint32_t iterations)
+{
+	// Whole vectors of three and of four
+	values = std::max<std::size_t>(values / 12 * 12, 12);
+
+	std::mt19937 engine{ 0x5EED };
+	std::uniform_real_distribution<float> distribution{ -1.0f, 1.0f };
+
+	std::vector<float> source(values);
+	for (float& value : source)
+	{
+		value = distribution(engine);
+	}
+
+	std::vector<Half> halves(values);
+	std::vector<PackedSnorm> snorms(values / 4);
+	std::vector<Octahedral> octahedrals(values / 3);
+
+	Benchmark result{};
+	result.values = values;
+
+	const auto measure = [iterations](auto&& func) {
+		double best = std::numeric_limits<double>::max();
+
+		for (std::uint32_t i = 0; i < std::max(1U, iterations); ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			func();
+			best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		return std::max(best, 1e-9);
+	};
+
+	result.halfPerSecond = static_cast<double>(values) / measure([&] {
+		PackHalf(source, halves);
+	});
+
+	result.scalarHalfPerSecond = static_cast<double>(values) / measure([&] {
+		for (std::size_t i = 0; i < values; ++i)
+		{
+			halves[i] = ToHalf(source[i]);
+		}
+	});
+
+	result.snormPerSecond = static_cast<double>(snorms.size()) / measure([&] {
+		PackSnorm(source, snorms, 4);
+	});
+
+	result.octahedralPerSecond = static_cast<double>(octahedrals.size()) / measure([&] {
+		PackOctahedral(source, octahedrals);
+	});
+
+	return result;
+}
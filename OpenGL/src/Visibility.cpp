@@ -0,0 +1,663 @@
+module;
+#if defined(__AVX__)
+#include <immintrin.h>
+#define GLIB_VISIBILITY_AVX 1
+#define GLIB_VISIBILITY_SSE2 0
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define GLIB_VISIBILITY_AVX 0
+#define GLIB_VISIBILITY_SSE2 1
+#else
+#define GLIB_VISIBILITY_AVX 0
+#define GLIB_VISIBILITY_SSE2 0
+#endif
+
+module Glib.Visibility;
+import <cmath>;
+import <bit>;
+import <algorithm>;
+import <chrono>;
+import <random>;
+
+namespace
+{
+	// Bounds of the objects in structure of arrays
+	struct BoundsView
+	{
+		const float* centreX;
+		const float* centreY;
+		const float* centreZ;
+		const float* extentX;
+		const float* extentY;
+		const float* extentZ;
+		const float* radius;
+	};
+
+	/// <summary>
+	/// Visibility of a single object, the plane distance of its centre is pushed out by the radius and the projected extents
+	/// </summary>
+	[[nodiscard]]
+	bool
+	TestObject(const gl::visibility::Frustum& frustum, const BoundsView& bounds, std::size_t index)
+	noexcept
+	{
+		for (const auto& plane : frustum.planes)
+		{
+			const float distance = plane[0] * bounds.centreX[index] + plane[1] * bounds.centreY[index] + plane[2] * bounds.centreZ[index] + plane[3]
+				+ bounds.radius[index]
+				+ std::abs(plane[0]) * bounds.extentX[index] + std::abs(plane[1]) * bounds.extentY[index] + std::abs(plane[2]) * bounds.extentZ[index];
+
+			if (distance < 0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// Visibility of BatchSize objects starting at first, as a bit mask
+	/// </summary>
+	[[nodiscard]]
+	std::uint32_t
+	TestBatch(const gl::visibility::Frustum& frustum, const BoundsView& bounds, std::size_t first)
+	noexcept
+	{
+#if GLIB_VISIBILITY_AVX
+		const __m256 cx = _mm256_loadu_ps(bounds.centreX + first);
+		const __m256 cy = _mm256_loadu_ps(bounds.centreY + first);
+		const __m256 cz = _mm256_loadu_ps(bounds.centreZ + first);
+		const __m256 ex = _mm256_loadu_ps(bounds.extentX + first);
+		const __m256 ey = _mm256_loadu_ps(bounds.extentY + first);
+		const __m256 ez = _mm256_loadu_ps(bounds.extentZ + first);
+		const __m256 radius = _mm256_loadu_ps(bounds.radius + first);
+		const __m256 zero = _mm256_setzero_ps();
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (const auto& plane : frustum.planes)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane[0]), cx), _mm256_set1_ps(plane[3]));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane[1]), cy));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane[2]), cz));
+			distance = _mm256_add_ps(distance, radius);
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(std::abs(plane[0])), ex));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(std::abs(plane[1])), ey));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(std::abs(plane[2])), ez));
+
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+		}
+
+		return static_cast<std::uint32_t>(_mm256_movemask_ps(inside));
+#elif GLIB_VISIBILITY_SSE2
+		// Two halves of four
+		std::uint32_t result = 0;
+
+		for (std::size_t half = 0; half < 2; ++half)
+		{
+			const std::size_t offset = first + half * 4;
+
+			const __m128 cx = _mm_loadu_ps(bounds.centreX + offset);
+			const __m128 cy = _mm_loadu_ps(bounds.centreY + offset);
+			const __m128 cz = _mm_loadu_ps(bounds.centreZ + offset);
+			const __m128 ex = _mm_loadu_ps(bounds.extentX + offset);
+			const __m128 ey = _mm_loadu_ps(bounds.extentY + offset);
+			const __m128 ez = _mm_loadu_ps(bounds.extentZ + offset);
+			const __m128 radius = _mm_loadu_ps(bounds.radius + offset);
+			const __m128 zero = _mm_setzero_ps();
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const auto& plane : frustum.planes)
+			{
+				__m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), cx), _mm_set1_ps(plane[3]));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane[1]), cy));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane[2]), cz));
+				distance = _mm_add_ps(distance, radius);
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(std::abs(plane[0])), ex));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(std::abs(plane[1])), ey));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(std::abs(plane[2])), ez));
+
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+			}
+
+			result |= static_cast<std::uint32_t>(_mm_movemask_ps(inside)) << (half * 4);
+		}
+
+		return result;
+#else
+		std::uint32_t result = 0;
+
+		for (std::size_t i = 0; i < gl::visibility::BatchSize; ++i)
+		{
+			result |= static_cast<std::uint32_t>(TestObject(frustum, bounds, first + i)) << i;
+		}
+
+		return result;
+#endif
+	}
+
+	[[nodiscard]]
+	constexpr std::size_t
+	GetPaddedSize(std::size_t count)
+	noexcept
+	{
+		return (count + gl::visibility::BatchSize - 1) / gl::visibility::BatchSize * gl::visibility::BatchSize;
+	}
+}
+
+gl::visibility::Frustum
+gl::visibility::Frustum::FromMatrix(const float(&matrix)[16])
+noexcept
+{
+	// Rows of the column major matrix
+	const auto row = [&](int index) noexcept -> std::array<float, 4> {
+		return { matrix[index], matrix[4 + index], matrix[8 + index], matrix[12 + index] };
+	};
+
+	const std::array<float, 4> x = row(0), y = row(1), z = row(2), w = row(3);
+
+	Frustum result{};
+	for (int i = 0; i < 4; ++i)
+	{
+		result.planes[0][i] = w[i] + x[i];
+		result.planes[1][i] = w[i] - x[i];
+		result.planes[2][i] = w[i] + y[i];
+		result.planes[3][i] = w[i] - y[i];
+		result.planes[4][i] = w[i] + z[i];
+		result.planes[5][i] = w[i] - z[i];
+	}
+
+	for (auto& plane : result.planes)
+	{
+		const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		if (0 < length)
+		{
+			for (float& value : plane)
+			{
+				value /= length;
+			}
+		}
+	}
+
+	return result;
+}
+
+gl::VisibilityStage::VisibilityStage()
+noexcept
+{
+	myViewProjection = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+	float matrix[16];
+	std::copy_n(myViewProjection.begin(), 16, matrix);
+	myFrustum = visibility::Frustum::FromMatrix(matrix);
+}
+
+gl::VisibilityStage::~VisibilityStage()
+noexcept
+{}
+
+void
+gl::VisibilityStage::Clear()
+noexcept
+{
+	myCentreX.clear();
+	myCentreY.clear();
+	myCentreZ.clear();
+	myExtentX.clear();
+	myExtentY.clear();
+	myExtentZ.clear();
+	myRadius.clear();
+	myDrawables.clear();
+	myVisible.clear();
+
+	if (myOccluder)
+	{
+		myOccluder->Clear(Colour{ 0.0f, 0.0f, 0.0f, 0.0f }, 1.0f);
+	}
+
+	myStatistics = {};
+}
+
+void
+gl::VisibilityStage::SetViewProjection(const float(&matrix)[16])
+noexcept
+{
+	std::copy_n(matrix, 16, myViewProjection.begin());
+	myFrustum = visibility::Frustum::FromMatrix(matrix);
+
+	if (myOccluder)
+	{
+		myOccluder->SetTransform(matrix);
+	}
+}
+
+void
+gl::VisibilityStage::EnableOcclusion(std::uint32_t width, std::uint32_t height, std::uint32_t threads)
+{
+	myOccluder.emplace(width, height, threads);
+
+	float matrix[16];
+	std::copy_n(myViewProjection.begin(), 16, matrix);
+	myOccluder->SetTransform(matrix);
+
+	// Only the depth matters, open meshes occlude from both sides
+	raster::DrawState state{};
+	state.culling = false;
+	myOccluder->SetState(state);
+	myOccluder->Clear(Colour{ 0.0f, 0.0f, 0.0f, 0.0f }, 1.0f);
+
+	myHierarchy.clear();
+	myLevelSizes.clear();
+}
+
+void
+gl::VisibilityStage::DisableOcclusion()
+noexcept
+{
+	myOccluder.reset();
+	myHierarchy.clear();
+	myLevelSizes.clear();
+}
+
+bool
+gl::VisibilityStage::IsOccluding()
+const noexcept
+{
+	return myOccluder.has_value();
+}
+
+bool
+gl::VisibilityStage::AddOccluder(const gl::raster::VertexInput& input)
+{
+	if (not myOccluder)
+	{
+		return false;
+	}
+
+	return myOccluder->Draw(input);
+}
+
+bool
+gl::VisibilityStage::AddOccluder(const gl::visibility::BoundingBox& box)
+{
+	if (not myOccluder)
+	{
+		return false;
+	}
+
+	float corners[8][3];
+	for (std::uint32_t i = 0; i < 8; ++i)
+	{
+		corners[i][0] = (i & 1) ? box.max[0] : box.min[0];
+		corners[i][1] = (i & 2) ? box.max[1] : box.min[1];
+		corners[i][2] = (i & 4) ? box.max[2] : box.min[2];
+	}
+
+	static constexpr std::uint32_t faces[36] =
+	{
+		0, 2, 1, 1, 2, 3, // -z
+		4, 5, 6, 5, 7, 6, // +z
+		0, 1, 4, 1, 5, 4, // -y
+		2, 6, 3, 3, 6, 7, // +y
+		0, 4, 2, 2, 4, 6, // -x
+		1, 3, 5, 3, 7, 5, // +x
+	};
+
+	BufferLayout layout{};
+	layout.SetStride(sizeof(corners[0]));
+	layout.AddElement<float>(3);
+
+	raster::VertexInput input{};
+	input.vertices = std::as_bytes(std::span{ corners });
+	input.layout = &layout;
+	input.indices = faces;
+
+	return myOccluder->Draw(input);
+}
+
+std::uint32_t
+gl::VisibilityStage::Submit(const gl::visibility::BoundingSphere& bounds, gl::Primitive primitive, std::uint32_t vertices_count, renderer_t&& renderer)
+{
+	return Append(bounds.x, bounds.y, bounds.z, 0, 0, 0, bounds.radius, primitive, vertices_count, std::move(renderer));
+}
+
+std::uint32_t
+gl::VisibilityStage::Submit(const gl::visibility::BoundingBox& bounds, gl::Primitive primitive, std::uint32_t vertices_count, renderer_t&& renderer)
+{
+	return Append((bounds.min[0] + bounds.max[0]) * 0.5f, (bounds.min[1] + bounds.max[1]) * 0.5f, (bounds.min[2] + bounds.max[2]) * 0.5f
+		, (bounds.max[0] - bounds.min[0]) * 0.5f, (bounds.max[1] - bounds.min[1]) * 0.5f, (bounds.max[2] - bounds.min[2]) * 0.5f
+		, 0, primitive, vertices_count, std::move(renderer));
+}
+
+void
+gl::VisibilityStage::Cull()
+{
+	const std::size_t count = myDrawables.size();
+
+	myVisible.clear();
+	myStatistics = {};
+	myStatistics.submitted = count;
+
+	// The last batch reads zeroed padding, whose bits are ignored
+	const std::size_t padded = GetPaddedSize(count);
+	for (std::vector<float>* column : { &myCentreX, &myCentreY, &myCentreZ, &myExtentX, &myExtentY, &myExtentZ, &myRadius })
+	{
+		column->resize(padded);
+	}
+
+	if (myOccluder)
+	{
+		myOccluder->Finish();
+		BuildHierarchy();
+	}
+
+	const BoundsView bounds{ myCentreX.data(), myCentreY.data(), myCentreZ.data(), myExtentX.data(), myExtentY.data(), myExtentZ.data(), myRadius.data() };
+
+	for (std::size_t first = 0; first < count; first += visibility::BatchSize)
+	{
+		const std::size_t lanes = std::min(visibility::BatchSize, count - first);
+		const std::uint32_t inside = TestBatch(myFrustum, bounds, first) & ((1U << lanes) - 1);
+
+		myStatistics.frustumCulled += lanes - static_cast<std::size_t>(std::popcount(inside));
+
+		for (std::uint32_t mask = inside; 0 != mask; mask &= mask - 1)
+		{
+			const std::size_t index = first + static_cast<std::size_t>(std::countr_zero(mask));
+
+			if (myOccluder && IsOccluded(index))
+			{
+				++myStatistics.occlusionCulled;
+			}
+			else
+			{
+				myVisible.push_back(static_cast<std::uint32_t>(index));
+			}
+		}
+	}
+
+	myStatistics.visible = myVisible.size();
+
+	for (std::vector<float>* column : { &myCentreX, &myCentreY, &myCentreZ, &myExtentX, &myExtentY, &myExtentZ, &myRadius })
+	{
+		column->resize(count);
+	}
+}
+
+void
+gl::VisibilityStage::Render(const gl::Pipeline& pipeline)
+{
+	for (const std::uint32_t index : myVisible)
+	{
+		Drawable& drawable = myDrawables[index];
+
+		if (drawable.renderer)
+		{
+			drawable.renderer();
+		}
+
+		pipeline.Render(drawable.primitive, drawable.count);
+	}
+}
+
+std::span<const std::uint32_t>
+gl::VisibilityStage::GetVisible()
+const noexcept
+{
+	return myVisible;
+}
+
+const gl::visibility::Statistics&
+gl::VisibilityStage::GetStatistics()
+const noexcept
+{
+	return myStatistics;
+}
+
+const gl::visibility::Frustum&
+gl::VisibilityStage::GetFrustum()
+const noexcept
+{
+	return myFrustum;
+}
+
+std::uint32_t
+gl::VisibilityStage::Append(float cx, float cy, float cz, float ex, float ey, float ez, float radius, gl::Primitive primitive, std::uint32_t vertices_count, renderer_t&& renderer)
+{
+	const std::uint32_t index = static_cast<std::uint32_t>(myDrawables.size());
+
+	myCentreX.push_back(cx);
+	myCentreY.push_back(cy);
+	myCentreZ.push_back(cz);
+	myExtentX.push_back(std::abs(ex));
+	myExtentY.push_back(std::abs(ey));
+	myExtentZ.push_back(std::abs(ez));
+	myRadius.push_back(std::abs(radius));
+	myDrawables.push_back(Drawable{ primitive, vertices_count, std::move(renderer) });
+
+	return index;
+}
+
+void
+gl::VisibilityStage::BuildHierarchy()
+{
+	const std::uint32_t width = myOccluder->GetWidth();
+	const std::uint32_t height = myOccluder->GetHeight();
+	const std::span<const ScreenPixel> pixels = myOccluder->GetPixels();
+
+	myHierarchy.resize(1);
+	myLevelSizes.assign(1, { width, height });
+
+	std::vector<float>& base = myHierarchy[0];
+	base.resize(pixels.size());
+	std::transform(pixels.begin(), pixels.end(), base.begin(), [](const ScreenPixel& pixel) noexcept {
+		return pixel.depth;
+	});
+
+	// Each texel keeps the farthest depth of the two by two texels below it
+	while (1 < myLevelSizes.back()[0] || 1 < myLevelSizes.back()[1])
+	{
+		const auto [source_width, source_height] = myLevelSizes.back();
+		const std::uint32_t level_width = std::max(1U, (source_width + 1) / 2);
+		const std::uint32_t level_height = std::max(1U, (source_height + 1) / 2);
+
+		std::vector<float> level(static_cast<std::size_t>(level_width) * level_height);
+		const std::vector<float>& source = myHierarchy.back();
+
+		for (std::uint32_t y = 0; y < level_height; ++y)
+		{
+			const std::uint32_t y0 = std::min(y * 2, source_height - 1), y1 = std::min(y * 2 + 1, source_height - 1);
+
+			for (std::uint32_t x = 0; x < level_width; ++x)
+			{
+				const std::uint32_t x0 = std::min(x * 2, source_width - 1), x1 = std::min(x * 2 + 1, source_width - 1);
+
+				level[static_cast<std::size_t>(y) * level_width + x] = std::max(
+					std::max(source[static_cast<std::size_t>(y0) * source_width + x0], source[static_cast<std::size_t>(y0) * source_width + x1]),
+					std::max(source[static_cast<std::size_t>(y1) * source_width + x0], source[static_cast<std::size_t>(y1) * source_width + x1]));
+			}
+		}
+
+		myHierarchy.push_back(std::move(level));
+		myLevelSizes.push_back({ level_width, level_height });
+	}
+}
+
+bool
+gl::VisibilityStage::IsOccluded(std::size_t index)
+const noexcept
+{
+	if (myHierarchy.empty())
+	{
+		return false;
+	}
+
+	const float ex = myExtentX[index] + myRadius[index];
+	const float ey = myExtentY[index] + myRadius[index];
+	const float ez = myExtentZ[index] + myRadius[index];
+	const std::array<float, 16>& m = myViewProjection;
+
+	float min_x = 1, max_x = -1, min_y = 1, max_y = -1, min_z = 1;
+	for (std::uint32_t i = 0; i < 8; ++i)
+	{
+		const float x = myCentreX[index] + ((i & 1) ? ex : -ex);
+		const float y = myCentreY[index] + ((i & 2) ? ey : -ey);
+		const float z = myCentreZ[index] + ((i & 4) ? ez : -ez);
+
+		const float clip_w = m[3] * x + m[7] * y + m[11] * z + m[15];
+
+		// Any corner behind the eye makes the projected rectangle unbounded
+		if (clip_w <= 1e-6f)
+		{
+			return false;
+		}
+
+		const float clip_x = m[0] * x + m[4] * y + m[8] * z + m[12];
+		const float clip_y = m[1] * x + m[5] * y + m[9] * z + m[13];
+		const float clip_z = m[2] * x + m[6] * y + m[10] * z + m[14];
+
+		min_x = std::min(min_x, clip_x / clip_w);
+		max_x = std::max(max_x, clip_x / clip_w);
+		min_y = std::min(min_y, clip_y / clip_w);
+		max_y = std::max(max_y, clip_y / clip_w);
+		min_z = std::min(min_z, clip_z / clip_w);
+	}
+
+	const float nearest = min_z * 0.5f + 0.5f;
+	if (nearest <= 0)
+	{
+		return false;
+	}
+
+	const auto [width, height] = myLevelSizes[0];
+
+	// Texels touched by the rectangle, rows go down as in the rasterizer
+	const auto to_texel = [](float value, std::uint32_t size) noexcept -> std::uint32_t {
+		const float texel = std::floor(std::clamp(value, 0.0f, 1.0f) * static_cast<float>(size));
+		return std::min(static_cast<std::uint32_t>(texel), size - 1);
+	};
+
+	std::uint32_t x0 = to_texel((min_x + 1) * 0.5f, width), x1 = to_texel((max_x + 1) * 0.5f, width);
+	std::uint32_t y0 = to_texel((1 - max_y) * 0.5f, height), y1 = to_texel((1 - min_y) * 0.5f, height);
+
+	// Finest level where the rectangle spans at most four texels each way, coarser levels reach too far past its edges
+	std::size_t level = 0;
+	while (level + 1 < myHierarchy.size() && (3 < x1 - x0 || 3 < y1 - y0))
+	{
+		x0 /= 2;
+		x1 /= 2;
+		y0 /= 2;
+		y1 /= 2;
+		++level;
+	}
+
+	const std::vector<float>& depths = myHierarchy[level];
+	const std::uint32_t level_width = myLevelSizes[level][0];
+
+	float farthest = 0;
+	for (std::uint32_t y = y0; y <= y1; ++y)
+	{
+		for (std::uint32_t x = x0; x <= x1; ++x)
+		{
+			farthest = std::max(farthest, depths[static_cast<std::size_t>(y) * level_width + x]);
+		}
+	}
+
+	return farthest < nearest;
+}
+
+gl::visibility::Benchmark
+gl::visibility::MeasureCulling(std::size_t objects, std::uint32_t iterations)
+{
+	// Perspective of 90 degrees looking down -z, from 1 to 1000
+	const float near_plane = 1.0f, far_plane = 1000.0f;
+	const float matrix[16] =
+	{
+		1, 0, 0, 0,
+		0, 1, 0, 0,
+		0, 0, -(far_plane + near_plane) / (far_plane - near_plane), -1,
+		0, 0, -2 * far_plane * near_plane / (far_plane - near_plane), 0,
+	};
+
+	const Frustum frustum = Frustum::FromMatrix(matrix);
+
+	std::mt19937 engine{ 0x5EED };
+	std::uniform_real_distribution<float> position{ -500.0f, 500.0f };
+	std::uniform_real_distribution<float> size{ 0.5f, 5.0f };
+
+	const std::size_t padded = GetPaddedSize(objects);
+	std::vector<float> columns[7];
+	for (std::vector<float>& column : columns)
+	{
+		column.resize(padded);
+	}
+
+	for (std::size_t i = 0; i < objects; ++i)
+	{
+		columns[0][i] = position(engine);
+		columns[1][i] = position(engine);
+		columns[2][i] = -std::abs(position(engine));
+
+		// Every other object is a box
+		if (0 == i % 2)
+		{
+			columns[6][i] = size(engine);
+		}
+		else
+		{
+			columns[3][i] = size(engine);
+			columns[4][i] = size(engine);
+			columns[5][i] = size(engine);
+		}
+	}
+
+	const BoundsView bounds{ columns[0].data(), columns[1].data(), columns[2].data(), columns[3].data(), columns[4].data(), columns[5].data(), columns[6].data() };
+
+	const auto measure = [&](auto&& test) {
+		double best = 0;
+		for (std::uint32_t i = 0; i < std::max(1U, iterations); ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			const std::size_t visible = test();
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+			// Keeps the loop from being optimized out
+			if (objects < visible)
+			{
+				return 0.0;
+			}
+
+			if (0 < elapsed.count())
+			{
+				best = std::max(best, static_cast<double>(objects) / elapsed.count());
+			}
+		}
+
+		return best;
+	};
+
+	Benchmark result{};
+	result.objects = objects;
+
+	result.batchedPerSecond = measure([&]() noexcept {
+		std::size_t visible = 0;
+		for (std::size_t first = 0; first < objects; first += BatchSize)
+		{
+			const std::size_t lanes = std::min(BatchSize, objects - first);
+			visible += static_cast<std::size_t>(std::popcount(TestBatch(frustum, bounds, first) & ((1U << lanes) - 1)));
+		}
+
+		return visible;
+	});
+
+	result.scalarPerSecond = measure([&]() noexcept {
+		std::size_t visible = 0;
+		for (std::size_t i = 0; i < objects; ++i)
+		{
+			visible += static_cast<std::size_t>(TestObject(frustum, bounds, i));
+		}
+
+		return visible;
+	});
+
+	return result;
+}
@@ -19,6 +19,7 @@
 #include <memory>
 #include <vector>
 #include <array>
+#include <thread>
 #include <assert.h>
 #include <string.h>
 
@@ -46,6 +47,20 @@
 #include <emmintrin.h>		// SSE2
 #include <smmintrin.h>		// SSE4.1
 #include <wmmintrin.h>		// pclmul
+#include <immintrin.h>		// AVX2, AVX-512, VPCLMULQDQ
+
+// The wider kernels are compiled for their own instruction sets and only called after the runtime checks.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define FPNG_TARGET_AVX2
+#define FPNG_TARGET_AVX512
+#define FPNG_TARGET_VPCLMUL256
+#define FPNG_TARGET_VPCLMUL512
+#else
+#define FPNG_TARGET_AVX2 __attribute__((target("avx2")))
+#define FPNG_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#define FPNG_TARGET_VPCLMUL256 __attribute__((target("avx2,pclmul,vpclmulqdq")))
+#define FPNG_TARGET_VPCLMUL512 __attribute__((target("avx512f,avx512bw,pclmul,vpclmulqdq")))
+#endif
 #endif
 
 #ifndef FPNG_NO_STDIO
@@ -273,43 +288,90 @@ namespace fpng
 #if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE 
 	// See Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction":
 	// https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/fast-crc-computation-generic-polynomials-pclmulqdq-paper.pdf
-	// Requires PCLMUL and SSE 4.1. This function skips Step 1 (fold by 4) for simplicity/less code.
-	static uint32_t crc32_pclmul(const uint8_t* p, size_t size, uint32_t crc)
-	{
-		assert(size >= 16);
-
-		// See page 22 (bit reflected constants for gzip)
+	// See page 22 (bit reflected constants for gzip)
 #ifdef _MSC_VER
-		static const uint64_t __declspec(align(16))
+	static const uint64_t __declspec(align(16))
 #else
-		static const uint64_t __attribute__((aligned(16)))
+	static const uint64_t __attribute__((aligned(16)))
 #endif
-			s_u[2] = { 0x1DB710641, 0x1F7011641 }, s_k5k0[2] = { 0x163CD6124, 0 }, s_k3k4[2] = { 0x1751997D0, 0xCCAA009E };
-
-		// Load first 16 bytes, apply initial CRC32
-		__m128i b = _mm_xor_si128(_mm_cvtsi32_si128(~crc), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+		s_crc32_u[2] = { 0x1DB710641, 0x1F7011641 }, s_crc32_k5k0[2] = { 0x163CD6124, 0 }, s_crc32_k3k4[2] = { 0x1751997D0, 0xCCAA009E };
 
+	// Folds the remaining 16 byte blocks into b, then reduces it to the CRC-32. size must be a multiple of 16.
+	static uint32_t crc32_pclmul_finish(__m128i b, const uint8_t* p, size_t size)
+	{
 		// We're skipping directly to Step 2 page 12 - iteratively folding by 1 (by 4 is overkill for our needs)
-		const __m128i k3k4 = _mm_load_si128(reinterpret_cast<const __m128i*>(s_k3k4));
+		const __m128i k3k4 = _mm_load_si128(reinterpret_cast<const __m128i*>(s_crc32_k3k4));
 
-		for (size -= 16, p += 16; size >= 16; size -= 16, p += 16)
+		for (; size >= 16; size -= 16, p += 16)
 			b = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(b, k3k4, 17), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))), _mm_clmulepi64_si128(b, k3k4, 0));
 
 		// Final stages: fold to 64-bits, 32-bit Barrett reduction
-		const __m128i z = _mm_set_epi32(0, ~0, 0, ~0), u = _mm_load_si128(reinterpret_cast<const __m128i*>(s_u));
+		const __m128i z = _mm_set_epi32(0, ~0, 0, ~0), u = _mm_load_si128(reinterpret_cast<const __m128i*>(s_crc32_u));
 		b = _mm_xor_si128(_mm_srli_si128(b, 8), _mm_clmulepi64_si128(b, k3k4, 16));
-		b = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(b, z), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s_k5k0)), 0), _mm_srli_si128(b, 4));
+		b = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(b, z), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s_crc32_k5k0)), 0), _mm_srli_si128(b, 4));
 		return ~_mm_extract_epi32(_mm_xor_si128(b, _mm_clmulepi64_si128(_mm_and_si128(_mm_clmulepi64_si128(_mm_and_si128(b, z), u, 16), z), u, 0)), 1);
 	}
 
-	static uint32_t crc32_sse41_simd(const unsigned char* buf, size_t len, uint32_t prev_crc32)
+	// Requires PCLMUL and SSE 4.1. This function skips Step 1 (fold by 4) for simplicity/less code.
+	static uint32_t crc32_pclmul(const uint8_t* p, size_t size, uint32_t crc)
 	{
-		if (len < 16)
-			return crc32_slice_by_4(buf, len, prev_crc32);
+		assert(size >= 16);
 
-		uint32_t simd_len = len & ~15;
-		uint32_t c = crc32_pclmul(buf, simd_len, prev_crc32);
-		return crc32_slice_by_4(buf + simd_len, len - simd_len, c);
+		// Load first 16 bytes, apply initial CRC32
+		const __m128i b = _mm_xor_si128(_mm_cvtsi32_si128(~crc), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+
+		return crc32_pclmul_finish(b, p + 16, size - 16);
+	}
+
+	// VPCLMULQDQ folds two 128-bit lanes 256 bits apart per step, then the lanes are folded together by 128 bits.
+	FPNG_TARGET_VPCLMUL256
+	static uint32_t crc32_vpclmul_256(const uint8_t* p, size_t size, uint32_t crc)
+	{
+		assert(size >= 64);
+
+		// x^(256+32) and x^(256-32) mod P, bit reflected
+		const __m256i k = _mm256_setr_epi64x(0xF1DA05AA, 0x15A546366, 0xF1DA05AA, 0x15A546366);
+
+		__m256i x = _mm256_xor_si256(_mm256_zextsi128_si256(_mm_cvtsi32_si128(~crc)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+
+		for (size -= 32, p += 32; size >= 32; size -= 32, p += 32)
+			x = _mm256_xor_si256(_mm256_xor_si256(_mm256_clmulepi64_epi128(x, k, 0x11), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))), _mm256_clmulepi64_epi128(x, k, 0x00));
+
+		const __m128i k3k4 = _mm_load_si128(reinterpret_cast<const __m128i*>(s_crc32_k3k4));
+
+		__m128i b = _mm256_castsi256_si128(x);
+		b = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(b, k3k4, 17), _mm256_extracti128_si256(x, 1)), _mm_clmulepi64_si128(b, k3k4, 0));
+
+		return crc32_pclmul_finish(b, p, size);
+	}
+
+	// The same with four 128-bit lanes 512 bits apart
+	FPNG_TARGET_VPCLMUL512
+	static uint32_t crc32_vpclmul_512(const uint8_t* p, size_t size, uint32_t crc)
+	{
+		assert(size >= 128);
+
+		// x^(512+32) and x^(512-32) mod P, bit reflected, in every lane
+		const __m512i k = _mm512_set_epi64(0x1C6E41596, 0x154442BD4, 0x1C6E41596, 0x154442BD4, 0x1C6E41596, 0x154442BD4, 0x1C6E41596, 0x154442BD4);
+
+		__m512i x = _mm512_xor_si512(_mm512_zextsi128_si512(_mm_cvtsi32_si128(~crc)), _mm512_loadu_si512(p));
+
+		// 0x96 is a three way xor
+		for (size -= 64, p += 64; size >= 64; size -= 64, p += 64)
+			x = _mm512_ternarylogic_epi64(_mm512_clmulepi64_epi128(x, k, 0x11), _mm512_clmulepi64_epi128(x, k, 0x00), _mm512_loadu_si512(p), 0x96);
+
+		const __m128i k3k4 = _mm_load_si128(reinterpret_cast<const __m128i*>(s_crc32_k3k4));
+
+		// Read back from memory, as _mm512_extracti32x4_epi32 starts from an undefined vector on some compilers
+		alignas(64) __m128i lanes[4];
+		_mm512_store_si512(lanes, x);
+
+		__m128i b = lanes[0];
+		b = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(b, k3k4, 17), lanes[1]), _mm_clmulepi64_si128(b, k3k4, 0));
+		b = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(b, k3k4, 17), lanes[2]), _mm_clmulepi64_si128(b, k3k4, 0));
+		b = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(b, k3k4, 17), lanes[3]), _mm_clmulepi64_si128(b, k3k4, 0));
+
+		return crc32_pclmul_finish(b, p, size);
 	}
 #endif
 
@@ -360,6 +422,14 @@ namespace fpng
 				do_cpuid(1, 0, (uint32_t*)regs);
 #endif
 				extract_x86_flags(regs[2], regs[3]);
+
+				// The OS has to save the wider registers across context switches
+				if ((regs[2] & (1 << 27)) != 0)
+				{
+					const uint64_t xcr0 = read_xcr0();
+					m_has_os_avx = (xcr0 & 0x6) == 0x6;
+					m_has_os_avx512 = (xcr0 & 0xE6) == 0xE6;
+				}
 			}
 
 			if (max_eax >= 7U)
@@ -369,26 +439,63 @@ namespace fpng
 #else
 				do_cpuid(7, 0, (uint32_t*)regs);
 #endif
-				extract_x86_extended_flags(regs[1]);
+				extract_x86_extended_flags(regs[1], regs[2]);
 			}
 
 			m_initialized = true;
 		}
 
 		[[nodiscard]]
-		constexpr bool can_use_sse41() const noexcept
+		constexpr uint32_t best_isa() const noexcept
+		{
+			if (!(m_has_sse && m_has_sse2 && m_has_sse3 && m_has_ssse3 && m_has_sse41))
+				return FPNG_ISA_SCALAR;
+
+			if (!(m_has_avx && m_has_avx2 && m_has_os_avx))
+				return FPNG_ISA_SSE41;
+
+			if (!(m_has_avx512f && m_has_avx512bw && m_has_os_avx512))
+				return FPNG_ISA_AVX2;
+
+			return FPNG_ISA_AVX512;
+		}
+
+		[[nodiscard]]
+		uint32_t active_isa() const noexcept;
+
+		[[nodiscard]]
+		bool can_use_sse41() const noexcept
 		{
-			return m_has_sse && m_has_sse2 && m_has_sse3 && m_has_ssse3 && m_has_sse41;
+			return FPNG_ISA_SSE41 <= active_isa();
 		}
 
 		[[nodiscard]]
-		constexpr bool can_use_pclmul() const noexcept
+		bool can_use_pclmul() const noexcept
 		{
 			return m_has_pclmulqdq && can_use_sse41();
 		}
 
+		[[nodiscard]]
+		bool can_use_avx2() const noexcept
+		{
+			return FPNG_ISA_AVX2 <= active_isa();
+		}
+
+		[[nodiscard]]
+		bool can_use_avx512() const noexcept
+		{
+			return FPNG_ISA_AVX512 <= active_isa();
+		}
+
+		[[nodiscard]]
+		bool can_use_vpclmul() const noexcept
+		{
+			return m_has_vpclmulqdq && m_has_pclmulqdq && can_use_avx2();
+		}
+
 		bool m_initialized = false;
 		bool m_has_fpu = false, m_has_mmx = false, m_has_sse = false, m_has_sse2 = false, m_has_sse3 = false, m_has_ssse3 = false, m_has_sse41 = false, m_has_sse42 = false, m_has_avx = false, m_has_avx2 = false, m_has_pclmulqdq = false;
+		bool m_has_avx512f = false, m_has_avx512bw = false, m_has_vpclmulqdq = false, m_has_os_avx = false, m_has_os_avx512 = false;
 
 	private:
 		constexpr void extract_x86_flags(uint32_t ecx, uint32_t edx) noexcept
@@ -398,14 +505,35 @@ namespace fpng
 			m_has_pclmulqdq = (ecx & (1 << 1)) != 0; m_has_avx = (ecx & (1 << 28)) != 0;
 		}
 
-		constexpr void extract_x86_extended_flags(uint32_t ebx) noexcept
+		constexpr void extract_x86_extended_flags(uint32_t ebx, uint32_t ecx) noexcept
+		{
+			m_has_avx2 = (ebx & (1 << 5)) != 0; m_has_avx512f = (ebx & (1 << 16)) != 0; m_has_avx512bw = (ebx & (1 << 30)) != 0;
+			m_has_vpclmulqdq = (ecx & (1 << 10)) != 0;
+		}
+
+		static uint64_t read_xcr0() noexcept
 		{
-			m_has_avx2 = (ebx & (1 << 5)) != 0;
+#ifdef _MSC_VER
+			return _xgetbv(0);
+#else
+			uint32_t eax = 0, edx = 0;
+			__asm__("xgetbv;" : "=a"(eax), "=d"(edx) : "c"(0));
+			return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
 		}
 	};
 
 	cpu_info g_cpu_info{};
 
+	// Set by fpng_set_max_isa(), to compare the kernels on the same machine.
+	// Every thread has its own, so capping one never changes the kernels another thread is running.
+	static thread_local uint32_t g_max_isa = FPNG_ISA_AVX512;
+
+	uint32_t cpu_info::active_isa() const noexcept
+	{
+		return minimum(best_isa(), g_max_isa);
+	}
+
 	void fpng_init()
 	{
 		g_cpu_info.init();
@@ -426,12 +554,81 @@ namespace fpng
 #endif
 	}
 
+	uint32_t fpng_cpu_best_isa()
+	{
+#if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE 
+		assert(g_cpu_info.m_initialized);
+		return g_cpu_info.best_isa();
+#else
+		return FPNG_ISA_SCALAR;
+#endif
+	}
+
+	uint32_t fpng_get_isa()
+	{
+#if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE 
+		assert(g_cpu_info.m_initialized);
+		return g_cpu_info.active_isa();
+#else
+		return FPNG_ISA_SCALAR;
+#endif
+	}
+
+	uint32_t fpng_set_max_isa(uint32_t isa)
+	{
+#if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE 
+		const uint32_t previous = g_max_isa;
+		g_max_isa = minimum<uint32_t>(isa, FPNG_ISA_AVX512);
+		return previous;
+#else
+		(void)isa;
+		return FPNG_ISA_SCALAR;
+#endif
+	}
+
+	const char* fpng_isa_name(uint32_t isa)
+	{
+		switch (isa)
+		{
+			case FPNG_ISA_SCALAR: return "Scalar";
+			case FPNG_ISA_SSE41: return "SSE4.1";
+			case FPNG_ISA_AVX2: return "AVX2";
+			case FPNG_ISA_AVX512: return "AVX-512";
+			default: return "Unknown";
+		}
+	}
+
+#if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE 
+	static uint32_t crc32_simd(const uint8_t* buf, size_t len, uint32_t prev_crc32)
+	{
+		if (len < 16)
+			return crc32_slice_by_4(buf, len, prev_crc32);
+
+		const size_t simd_len = len & ~static_cast<size_t>(15);
+
+		uint32_t c;
+		if ((simd_len >= 256) && g_cpu_info.can_use_vpclmul())
+		{
+			if (g_cpu_info.can_use_avx512())
+				c = crc32_vpclmul_512(buf, simd_len, prev_crc32);
+			else
+				c = crc32_vpclmul_256(buf, simd_len, prev_crc32);
+		}
+		else
+		{
+			c = crc32_pclmul(buf, simd_len, prev_crc32);
+		}
+
+		return crc32_slice_by_4(buf + simd_len, len - simd_len, c);
+	}
+#endif
+
 	[[nodiscard]]
 	uint32_t fpng_crc32(const void* pData, size_t size, uint32_t prev_crc32)
 	{
 #if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE 
 		if (g_cpu_info.can_use_pclmul())
-			return crc32_sse41_simd(static_cast<const uint8_t*>(pData), size, prev_crc32);
+			return crc32_simd(static_cast<const uint8_t*>(pData), size, prev_crc32);
 #endif
 
 		return crc32_slice_by_4(pData, size, prev_crc32);
@@ -498,6 +695,129 @@ namespace fpng
 
 		return (s1 % K) | ((s2 % K) << 16);
 	}
+
+	// AVX2, 32 bytes per iteration: s1 gathers the byte sums, s2 the sums weighted by their distance to the block end
+	[[nodiscard]]
+	FPNG_TARGET_AVX2
+	static uint32_t adler32_avx2(const uint8_t* p, size_t len, uint32_t initial)
+	{
+		uint64_t s1 = initial & 0xFFFF, s2 = initial >> 16;
+		const uint32_t K = 65521;
+
+		const __m256i weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+		const __m256i ones = _mm256_set1_epi16(1);
+		const __m256i zero = _mm256_setzero_si256();
+
+		while (len >= 32)
+		{
+			// 173 * 32 bytes stay below the 5552 bytes limit of the 32-bit sums
+			const size_t n = minimum<size_t>(len >> 5, 173);
+
+			__m256i vs1 = _mm256_setzero_si256(), vs1_prefix = _mm256_setzero_si256(), vs2 = _mm256_setzero_si256();
+
+			for (size_t i = 0; i < n; i++)
+			{
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i * 32));
+
+				vs1_prefix = _mm256_add_epi32(vs1_prefix, vs1);
+				vs1 = _mm256_add_epi32(vs1, _mm256_sad_epu8(v, zero));
+				vs2 = _mm256_add_epi32(vs2, _mm256_madd_epi16(_mm256_maddubs_epi16(v, weights), ones));
+			}
+
+			uint32_t a[8], b[8], c[8];
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(a), vs1);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(b), vs1_prefix);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(c), vs2);
+
+			uint64_t sum1 = 0, prefix = 0, sum2 = 0;
+			for (uint32_t i = 0; i < 8; i++)
+			{
+				sum1 += a[i];
+				prefix += b[i];
+				sum2 += c[i];
+			}
+
+			s2 = (s2 + s1 * 32 * n + prefix * 32 + sum2) % K;
+			s1 = (s1 + sum1) % K;
+
+			p += n * 32;
+			len -= n * 32;
+		}
+
+		for (; len; len--)
+		{
+			s1 += *p++;
+			s2 += s1;
+		}
+
+		return static_cast<uint32_t>((s1 % K) | ((s2 % K) << 16));
+	}
+
+	// Sum of the 32-bit lanes through the two 256-bit halves.
+	// _mm512_reduce_add_epi32 and _mm512_extracti64x4_epi64 start from an undefined vector on some compilers, the halves are read back from memory instead.
+	[[nodiscard]]
+	FPNG_TARGET_AVX512
+	static inline uint32_t reduce_add_epi32_avx512(const __m512i v)
+	{
+		alignas(64) uint32_t lanes[16];
+		_mm512_store_si512(lanes, v);
+
+		const __m256i half = _mm256_add_epi32(_mm256_load_si256(reinterpret_cast<const __m256i*>(lanes)), _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes + 8)));
+		const __m128i quarter = _mm_add_epi32(_mm256_castsi256_si128(half), _mm256_extracti128_si256(half, 1));
+		const __m128i pairs = _mm_add_epi32(quarter, _mm_shuffle_epi32(quarter, _MM_SHUFFLE(1, 0, 3, 2)));
+		const __m128i total = _mm_add_epi32(pairs, _mm_shuffle_epi32(pairs, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		return static_cast<uint32_t>(_mm_cvtsi128_si32(total));
+	}
+
+	// AVX-512 BW, 64 bytes per iteration
+	[[nodiscard]]
+	FPNG_TARGET_AVX512
+	static uint32_t adler32_avx512(const uint8_t* p, size_t len, uint32_t initial)
+	{
+		uint64_t s1 = initial & 0xFFFF, s2 = initial >> 16;
+		const uint32_t K = 65521;
+
+		const __m512i weights = _mm512_set_epi8(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32
+			, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64);
+		const __m512i ones = _mm512_set1_epi16(1);
+		const __m512i zero = _mm512_setzero_si512();
+
+		while (len >= 64)
+		{
+			// 86 * 64 bytes stay below the 5552 bytes limit of the 32-bit sums
+			const size_t n = minimum<size_t>(len >> 6, 86);
+
+			__m512i vs1 = _mm512_setzero_si512(), vs1_prefix = _mm512_setzero_si512(), vs2 = _mm512_setzero_si512();
+
+			for (size_t i = 0; i < n; i++)
+			{
+				const __m512i v = _mm512_loadu_si512(p + i * 64);
+
+				vs1_prefix = _mm512_add_epi32(vs1_prefix, vs1);
+				vs1 = _mm512_add_epi32(vs1, _mm512_sad_epu8(v, zero));
+				vs2 = _mm512_add_epi32(vs2, _mm512_madd_epi16(_mm512_maddubs_epi16(v, weights), ones));
+			}
+
+			const uint64_t sum1 = reduce_add_epi32_avx512(vs1);
+			const uint64_t prefix = reduce_add_epi32_avx512(vs1_prefix);
+			const uint64_t sum2 = reduce_add_epi32_avx512(vs2);
+
+			s2 = (s2 + s1 * 64 * n + prefix * 64 + sum2) % K;
+			s1 = (s1 + sum1) % K;
+
+			p += n * 64;
+			len -= n * 64;
+		}
+
+		for (; len; len--)
+		{
+			s1 += *p++;
+			s2 += s1;
+		}
+
+		return static_cast<uint32_t>((s1 % K) | ((s2 % K) << 16));
+	}
 #endif
 
 	[[nodiscard]]
@@ -522,6 +842,12 @@ namespace fpng
 	uint32_t fpng_adler32(const void* pData, size_t size, uint32_t adler)
 	{
 #if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE 
+		if (g_cpu_info.can_use_avx512())
+			return adler32_avx512((const uint8_t*)pData, size, adler);
+
+		if (g_cpu_info.can_use_avx2())
+			return adler32_avx2((const uint8_t*)pData, size, adler);
+
 		if (g_cpu_info.can_use_sse41())
 			return adler32_sse_16((const uint8_t*)pData, size, adler);
 #endif
@@ -1721,6 +2047,55 @@ do { \
 		}
 	}
 
+#if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE
+	// Up filter kernels, each returns the number of bytes it processed
+	static size_t filter_up_sse41(uint8_t* pDst, const uint8_t* pSrc, const uint8_t* pPrev_src, size_t size)
+	{
+		size_t ofs = 0;
+
+		for (; size - ofs >= 16; ofs += 16)
+		{
+			_mm_storeu_si128((__m128i*)(pDst + ofs), _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(pSrc + ofs)), _mm_loadu_si128((const __m128i*)(pPrev_src + ofs))));
+		}
+
+		return ofs;
+	}
+
+	FPNG_TARGET_AVX2
+	static size_t filter_up_avx2(uint8_t* pDst, const uint8_t* pSrc, const uint8_t* pPrev_src, size_t size)
+	{
+		size_t ofs = 0;
+
+		for (; size - ofs >= 32; ofs += 32)
+		{
+			_mm256_storeu_si256((__m256i*)(pDst + ofs), _mm256_sub_epi8(_mm256_loadu_si256((const __m256i*)(pSrc + ofs)), _mm256_loadu_si256((const __m256i*)(pPrev_src + ofs))));
+		}
+
+		return ofs;
+	}
+
+	FPNG_TARGET_AVX512
+	static size_t filter_up_avx512(uint8_t* pDst, const uint8_t* pSrc, const uint8_t* pPrev_src, size_t size)
+	{
+		size_t ofs = 0;
+
+		for (; size - ofs >= 64; ofs += 64)
+		{
+			_mm512_storeu_si512(pDst + ofs, _mm512_sub_epi8(_mm512_loadu_si512(pSrc + ofs), _mm512_loadu_si512(pPrev_src + ofs)));
+		}
+
+		// The tail goes through a masked load and store
+		if (const size_t rest = size - ofs; rest)
+		{
+			const __mmask64 mask = _cvtu64_mask64((1ULL << rest) - 1);
+			_mm512_mask_storeu_epi8(pDst + ofs, mask, _mm512_sub_epi8(_mm512_maskz_loadu_epi8(mask, pSrc + ofs), _mm512_maskz_loadu_epi8(mask, pPrev_src + ofs)));
+			ofs = size;
+		}
+
+		return ofs;
+	}
+#endif
+
 	void apply_filter(const uint32_t& filter
 		, const size_t& w, const size_t&
 		, const size_t& num_chans, const size_t& bpl
@@ -1746,14 +2121,17 @@ do { \
 #if FPNG_X86_OR_X64_CPU && !FPNG_NO_SSE
 				if (g_cpu_info.can_use_sse41())
 				{
-					size_t bytes_to_process = w * num_chans, ofs = 0;
+					const size_t bytes_to_process = w * num_chans;
 
-					for (; bytes_to_process >= 16; bytes_to_process -= 16, ofs += 16)
-					{
-						_mm_storeu_si128((__m128i*)(pDst + ofs), _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(pSrc + ofs)), _mm_loadu_si128((const __m128i*)(pPrev_src + ofs))));
-					}
+					size_t ofs;
+					if (g_cpu_info.can_use_avx512())
+						ofs = filter_up_avx512(pDst, pSrc, pPrev_src, bytes_to_process);
+					else if (g_cpu_info.can_use_avx2())
+						ofs = filter_up_avx2(pDst, pSrc, pPrev_src, bytes_to_process);
+					else
+						ofs = filter_up_sse41(pDst, pSrc, pPrev_src, bytes_to_process);
 
-					for (; bytes_to_process; bytes_to_process--, ofs++)
+					for (; ofs < bytes_to_process; ofs++)
 					{
 						pDst[ofs] = static_cast<uint8_t>(pSrc[ofs] - pPrev_src[ofs]);
 					}
@@ -1798,6 +2176,54 @@ do { \
 		}
 	}
 
+	static constexpr size_t PNG_HEADER_SIZE = 58;
+
+	// Writes the PNG header, the fdEC chunk, and closes the IDAT chunk whose zlib stream starts at PNG_HEADER_SIZE.
+	static void write_png_container(std::vector<uint8_t>& out_buf, const size_t& w, const size_t& h, const size_t& num_chans)
+	{
+		const uint32_t idat_len = (uint32_t)out_buf.size() - PNG_HEADER_SIZE;
+		// Write real PNG header, fdEC chunk, and the beginning of the IDAT chunk
+		{
+			constexpr uint8_t s_color_type[] = { 0x00, 0x00, 0x04, 0x02, 0x06 };
+
+			uint8_t pnghdr[58] = {
+				0x89,0x50,0x4e,0x47,0x0d,0x0a,0x1a,0x0a,   // PNG sig
+				0x00,0x00,0x00,0x0d, 'I','H','D','R',  // IHDR chunk len, type
+				0,0,(uint8_t)(w >> 8),(uint8_t)w, // width
+				0,0,(uint8_t)(h >> 8),(uint8_t)h, // height
+				8,   //bit_depth
+				s_color_type[num_chans], // color_type
+				0, // compression
+				0, // filter
+				0, // interlace
+				0, 0, 0, 0, // IHDR crc32
+				0, 0, 0, 5, 'f', 'd', 'E', 'C', 82, 36, 147, 227, FPNG_FDEC_VERSION,   0xE5, 0xAB, 0x62, 0x99, // our custom private, ancillary, do not copy, fdEC chunk
+			  (uint8_t)(idat_len >> 24),(uint8_t)(idat_len >> 16),(uint8_t)(idat_len >> 8),(uint8_t)idat_len, 'I','D','A','T' // IDATA chunk len, type
+			};
+
+			// Compute IHDR CRC32
+			uint32_t c = (uint32_t)fpng_crc32(pnghdr + 12, 17, FPNG_CRC32_INIT);
+			for (size_t i = 0; i < 4; ++i, c <<= 8)
+			{
+				((uint8_t*)(pnghdr + 29))[i] = (uint8_t)(c >> 24);
+			}
+
+			memcpy(out_buf.data(), pnghdr, PNG_HEADER_SIZE);
+		}
+
+		// Write IDAT chunk's CRC32 and a 0 length IEND chunk
+		vector_append(out_buf, "\0\0\0\0\0\0\0\0\x49\x45\x4e\x44\xae\x42\x60\x82", 16); // IDAT CRC32, followed by the IEND chunk
+
+		// Compute IDAT crc32
+		uint32_t c = (uint32_t)fpng_crc32(out_buf.data() + PNG_HEADER_SIZE - 4, static_cast<size_t>(idat_len) + 4, FPNG_CRC32_INIT);
+
+		auto* const& target = out_buf.data() + out_buf.size() - 16ULL;
+		for (size_t i = 0; i < 4; ++i, c <<= 8)
+		{
+			*(target + i) = static_cast<uint8_t>(c >> 24);
+		}
+	}
+
 	bool fpng_encode_image_to_memory(const void* pImage, size_t w, size_t h, size_t num_chans, std::vector<uint8_t>& out_buf, uint32_t flags)
 	{
 		if (!endian_check())
@@ -1837,7 +2263,6 @@ do { \
 			temp_buf_ofs += 1 + bpl;
 		}
 
-		constexpr size_t PNG_HEADER_SIZE = 58;
 		constexpr size_t out_ofs = PNG_HEADER_SIZE;
 
 		out_buf.resize((out_ofs + (bpl + 1ULL) * h + 7ULL) & ~7ULL);
@@ -1907,47 +2332,369 @@ do { \
 
 		out_buf.resize(out_ofs + zlib_size);
 
-		const uint32_t idat_len = (uint32_t)out_buf.size() - PNG_HEADER_SIZE;
-		// Write real PNG header, fdEC chunk, and the beginning of the IDAT chunk
-		{
-			constexpr uint8_t s_color_type[] = { 0x00, 0x00, 0x04, 0x02, 0x06 };
+		write_png_container(out_buf, w, h, num_chans);
 
-			uint8_t pnghdr[58] = {
-				0x89,0x50,0x4e,0x47,0x0d,0x0a,0x1a,0x0a,   // PNG sig
-				0x00,0x00,0x00,0x0d, 'I','H','D','R',  // IHDR chunk len, type
-				0,0,(uint8_t)(w >> 8),(uint8_t)w, // width
-				0,0,(uint8_t)(h >> 8),(uint8_t)h, // height
-				8,   //bit_depth
-				s_color_type[num_chans], // color_type
-				0, // compression
-				0, // filter
-				0, // interlace
-				0, 0, 0, 0, // IHDR crc32
-				0, 0, 0, 5, 'f', 'd', 'E', 'C', 82, 36, 147, 227, FPNG_FDEC_VERSION,   0xE5, 0xAB, 0x62, 0x99, // our custom private, ancillary, do not copy, fdEC chunk
-			  (uint8_t)(idat_len >> 24),(uint8_t)(idat_len >> 16),(uint8_t)(idat_len >> 8),(uint8_t)idat_len, 'I','D','A','T' // IDATA chunk len, type
-			};
+		return true;
+	}
 
-			// Compute IHDR CRC32
-			uint32_t c = (uint32_t)fpng_crc32(pnghdr + 12, 17, FPNG_CRC32_INIT);
-			for (size_t i = 0; i < 4; ++i, c <<= 8)
+	// ---- Parallel encoding
+	//
+	// Each scanline starts with a literal pixel and RLE matches never cross scanlines, so stripes of rows can be coded
+	// independently with the static one-pass Huffman tables. The stripes are bit-concatenated afterwards into one dynamic block,
+	// which keeps the output decodable by fpng_decode_memory().
+
+	static const size_t FPNG_MIN_STRIPE_ROWS = 16;
+
+	struct defl_stripe
+	{
+		std::vector<uint8_t> m_bytes;
+		uint64_t m_bit_buf = 0;
+		int m_bit_buf_size = 0;
+		uint32_t m_adler32 = FPNG_ADLER32_INIT;
+		size_t m_filtered_len = 0;
+		bool m_ok = false;
+	};
+
+	struct defl_bit_writer
+	{
+		std::vector<uint8_t>& m_buf;
+		uint64_t m_bit_buf = 0;
+		int m_bit_buf_size = 0;
+
+		void put_bits(uint64_t bits, int len)
+		{
+			assert(len <= 32);
+			m_bit_buf |= bits << m_bit_buf_size;
+			m_bit_buf_size += len;
+
+			while (m_bit_buf_size >= 8)
 			{
-				((uint8_t*)(pnghdr + 29))[i] = (uint8_t)(c >> 24);
+				m_buf.push_back(static_cast<uint8_t>(m_bit_buf));
+				m_bit_buf >>= 8;
+				m_bit_buf_size -= 8;
 			}
+		}
 
-			memcpy(out_buf.data(), pnghdr, PNG_HEADER_SIZE);
+		void put_bytes(const uint8_t* pSrc, size_t len)
+		{
+			if (!m_bit_buf_size)
+			{
+				vector_append(m_buf, pSrc, len);
+				return;
+			}
+
+			for (; len >= 4; len -= 4, pSrc += 4)
+			{
+				put_bits(READ_LE32(pSrc), 32);
+			}
+
+			for (; len; len--, pSrc++)
+			{
+				put_bits(*pSrc, 8);
+			}
 		}
 
-		// Write IDAT chunk's CRC32 and a 0 length IEND chunk
-		vector_append(out_buf, "\0\0\0\0\0\0\0\0\x49\x45\x4e\x44\xae\x42\x60\x82", 16); // IDAT CRC32, followed by the IEND chunk
+		void flush()
+		{
+			if (m_bit_buf_size)
+			{
+				put_bits(0, 8 - m_bit_buf_size);
+			}
+		}
+	};
 
-		// Compute IDAT crc32
-		uint32_t c = (uint32_t)fpng_crc32(out_buf.data() + PNG_HEADER_SIZE - 4, static_cast<size_t>(idat_len) + 4, FPNG_CRC32_INIT);
+	// Same as zlib's adler32_combine(): the checksum of A+B from the checksums of A and B.
+	[[nodiscard]]
+	static uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2)
+	{
+		constexpr uint32_t BASE = 65521U;
 
-		auto* const& target = out_buf.data() + out_buf.size() - 16ULL;
-		for (size_t i = 0; i < 4; ++i, c <<= 8)
+		const uint32_t rem = static_cast<uint32_t>(len2 % BASE);
+		uint32_t sum1 = adler1 & 0xFFFF;
+		uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(rem) * sum1) % BASE);
+
+		sum1 += (adler2 & 0xFFFF) + BASE - 1;
+		sum2 += ((adler1 >> 16) & 0xFFFF) + ((adler2 >> 16) & 0xFFFF) + BASE - rem;
+
+		if (sum1 >= BASE) sum1 -= BASE;
+		if (sum1 >= BASE) sum1 -= BASE;
+		if (sum2 >= (BASE << 1)) sum2 -= (BASE << 1);
+		if (sum2 >= BASE) sum2 -= BASE;
+
+		return sum1 | (sum2 << 16);
+	}
+
+	// Codes filtered rows without the zlib header, the block prefix and the EOB. Whole bytes go into pDst, the remaining bits stay in bit_buf.
+	template<size_t num_chans, typename Codes>
+	[[nodiscard]]
+	static size_t pixel_deflate_stripe_one_pass(const Codes& codes
+		, const uint8_t* const& pImg, const size_t& w, const size_t& h
+		, uint8_t* const& pDst, const size_t& dst_buf_size
+		, uint64_t& out_bit_buf, int& out_bit_buf_size)
+	{
+		static_assert(num_chans == 3 || num_chans == 4);
+
+		constexpr uint32_t max_match_bytes = (num_chans == 3) ? 255 : 252;
+
+		const auto read_pixel = [](const uint8_t* p) -> uint32_t {
+			if constexpr (num_chans == 3)
+			{
+				return READ_RGB_PIXEL(p);
+			}
+			else
+			{
+				return READ_LE32(p);
+			}
+		};
+
+		size_t dst_ofs = 0;
+		uint64_t bit_buf = 0;
+		int bit_buf_size = 0;
+
+		const size_t bpl = 1 + w * num_chans;
+		const uint8_t* pSrc = pImg;
+		size_t src_ofs = 0;
+
+		for (uint32_t y = 0; y < h; y++)
 		{
-			*(target + i) = static_cast<uint8_t>(c >> 24);
+			const size_t end_src_ofs = src_ofs + bpl;
+
+			const uint32_t filter_lit = pSrc[src_ofs++];
+			PUT_BITS_CZ(codes[filter_lit].m_code, codes[filter_lit].m_code_size);
+
+			PUT_BITS_FLUSH;
+
+			uint32_t prev_lits = read_pixel(pSrc + src_ofs);
+			for (size_t c = 0; c < num_chans; c++)
+			{
+				const uint32_t lit = (prev_lits >> (c * 8)) & 0xFF;
+				PUT_BITS_CZ(codes[lit].m_code, codes[lit].m_code_size);
+			}
+			src_ofs += num_chans;
+
+			PUT_BITS_FLUSH;
+
+			while (src_ofs < end_src_ofs)
+			{
+				const uint32_t lits = read_pixel(pSrc + src_ofs);
+
+				bool use_literals = true;
+
+				if (lits == prev_lits)
+				{
+					uint32_t match_len = num_chans;
+					const uint32_t max_match_len = minimum<uint32_t>(max_match_bytes, (uint32_t)(end_src_ofs - src_ofs));
+
+					while (match_len < max_match_len)
+					{
+						if (read_pixel(pSrc + src_ofs + match_len) != lits)
+							break;
+						match_len += num_chans;
+					}
+
+					const uint32_t adj_match_len = match_len - 3;
+					const uint32_t match_code_bits = codes[g_defl_len_sym[adj_match_len]].m_code_size;
+					const uint32_t len_extra_bits = g_defl_len_extra[adj_match_len];
+
+					use_literals = false;
+
+					if constexpr (num_chans == 4)
+					{
+						if (match_len == 4)
+						{
+							// See if just encoding 4 literals would be cheaper than using a short match.
+							const uint32_t lit_bits = codes[lits & 0xFF].m_code_size + codes[(lits >> 8) & 0xFF].m_code_size +
+								codes[(lits >> 16) & 0xFF].m_code_size + codes[(lits >> 24)].m_code_size;
+
+							use_literals = (match_code_bits + len_extra_bits + 1) > lit_bits;
+						}
+					}
+
+					if (!use_literals)
+					{
+						PUT_BITS_CZ(codes[g_defl_len_sym[adj_match_len]].m_code, match_code_bits);
+						PUT_BITS(adj_match_len & g_bitmasks[len_extra_bits], len_extra_bits + 1); // +1 for the match distance Huff code which is always 0
+
+						src_ofs += match_len;
+					}
+				}
+
+				if (use_literals)
+				{
+					for (size_t c = 0; c < num_chans; c++)
+					{
+						const uint32_t lit = (lits >> (c * 8)) & 0xFF;
+						PUT_BITS_CZ(codes[lit].m_code, codes[lit].m_code_size);
+					}
+
+					src_ofs += num_chans;
+					prev_lits = lits;
+				}
+
+				PUT_BITS_FLUSH;
+			}
+		}
+
+		assert(src_ofs == h * bpl);
+		assert(bit_buf_size <= 7);
+
+		out_bit_buf = bit_buf;
+		out_bit_buf_size = bit_buf_size;
+
+		return dst_ofs;
+	}
+
+	bool fpng_encode_image_to_memory_parallel(const void* pImage, size_t w, size_t h, size_t num_chans, std::vector<uint8_t>& out_buf, uint32_t num_threads)
+	{
+		if (!endian_check())
+		{
+			assert(0);
+			return false;
+		}
+
+		if ((w < 1) || (h < 1) || (w * (uint64_t)h > UINT32_MAX) || (w > FPNG_MAX_SUPPORTED_DIM) || (h > FPNG_MAX_SUPPORTED_DIM))
+		{
+			assert(0);
+			return false;
+		}
+
+		if ((num_chans != 3) && (num_chans != 4))
+		{
+			assert(0);
+			return false;
+		}
+
+		if (!num_threads)
+		{
+			num_threads = maximum<uint32_t>(1, std::thread::hardware_concurrency());
+		}
+
+		const size_t rows_per_stripe = maximum<size_t>(FPNG_MIN_STRIPE_ROWS, (h + num_threads - 1) / num_threads);
+		const size_t num_stripes = (h + rows_per_stripe - 1) / rows_per_stripe;
+
+		if (num_stripes <= 1)
+		{
+			return fpng_encode_image_to_memory(pImage, w, h, num_chans, out_buf);
+		}
+
+		const size_t bpl = w * num_chans;
+		const uint8_t* const pImage_u8 = static_cast<const uint8_t*>(pImage);
+
+		std::vector<defl_stripe> stripes(num_stripes);
+
+		const auto encode_stripe = [&](const size_t index) {
+			defl_stripe& stripe = stripes[index];
+
+			const size_t first_row = index * rows_per_stripe;
+			const size_t rows = minimum<size_t>(rows_per_stripe, h - first_row);
+
+			// Filter the rows of this stripe, the previous row is read from the source image even across stripes
+			std::vector<uint8_t> filtered((bpl + 1) * rows + 8);
+			for (size_t y = first_row, ofs = 0; y < first_row + rows; ++y, ofs += bpl + 1)
+			{
+				const uint8_t* pSrc = pImage_u8 + y * bpl;
+				const uint8_t* pPrev_src = y ? (pImage_u8 + (y - 1) * bpl) : nullptr;
+
+				apply_filter(y ? 2 : 0, w, h, num_chans, bpl, pSrc, pPrev_src, filtered.data() + ofs);
+			}
+
+			stripe.m_filtered_len = (bpl + 1) * rows;
+			stripe.m_adler32 = fpng_adler32(filtered.data(), stripe.m_filtered_len, FPNG_ADLER32_INIT);
+
+			stripe.m_bytes.resize(stripe.m_filtered_len * 2 + 64);
+
+			size_t size;
+			if (num_chans == 3)
+			{
+				size = pixel_deflate_stripe_one_pass<3>(g_dyn_huff_3_codes, filtered.data(), w, rows, stripe.m_bytes.data(), stripe.m_bytes.size(), stripe.m_bit_buf, stripe.m_bit_buf_size);
+			}
+			else
+			{
+				size = pixel_deflate_stripe_one_pass<4>(g_dyn_huff_4_codes, filtered.data(), w, rows, stripe.m_bytes.data(), stripe.m_bytes.size(), stripe.m_bit_buf, stripe.m_bit_buf_size);
+			}
+
+			stripe.m_bytes.resize(size);
+			stripe.m_ok = (0 < size) || (0 < stripe.m_bit_buf_size);
+		};
+
+		{
+			std::vector<std::thread> workers;
+			workers.reserve(num_stripes - 1);
+
+			// The workers run the kernels their caller is capped to
+			const uint32_t max_isa = fpng_get_isa();
+
+			for (size_t i = 1; i < num_stripes; i++)
+			{
+				workers.emplace_back([&encode_stripe, max_isa](const size_t index) {
+					fpng_set_max_isa(max_isa);
+					encode_stripe(index);
+				}, i);
+			}
+
+			encode_stripe(0);
+
+			for (std::thread& worker : workers)
+			{
+				worker.join();
+			}
+		}
+
+		size_t total_size = 0;
+		for (const defl_stripe& stripe : stripes)
+		{
+			if (!stripe.m_ok)
+			{
+				// A stripe didn't fit, let the single threaded path fall back to raw blocks.
+				return fpng_encode_image_to_memory(pImage, w, h, num_chans, out_buf);
+			}
+
+			total_size += stripe.m_bytes.size() + 1;
+		}
+
+		out_buf.clear();
+		out_buf.reserve(PNG_HEADER_SIZE + sizeof(g_dyn_huff_4) + total_size + 32);
+		out_buf.resize(PNG_HEADER_SIZE);
+
+		defl_bit_writer writer{ out_buf };
+
+		if (num_chans == 3)
+		{
+			vector_append(out_buf, g_dyn_huff_3, sizeof(g_dyn_huff_3));
+			writer.put_bits(DYN_HUFF_3_BITBUF, DYN_HUFF_3_BITBUF_SIZE);
+		}
+		else
+		{
+			vector_append(out_buf, g_dyn_huff_4, sizeof(g_dyn_huff_4));
+			writer.put_bits(DYN_HUFF_4_BITBUF, DYN_HUFF_4_BITBUF_SIZE);
+		}
+
+		uint32_t adler = FPNG_ADLER32_INIT;
+		for (const defl_stripe& stripe : stripes)
+		{
+			writer.put_bytes(stripe.m_bytes.data(), stripe.m_bytes.size());
+			writer.put_bits(stripe.m_bit_buf, stripe.m_bit_buf_size);
+
+			adler = adler32_combine(adler, stripe.m_adler32, stripe.m_filtered_len);
+		}
+
+		if (num_chans == 3)
+		{
+			writer.put_bits(g_dyn_huff_3_codes[256].m_code, g_dyn_huff_3_codes[256].m_code_size);
+		}
+		else
+		{
+			writer.put_bits(g_dyn_huff_4_codes[256].m_code, g_dyn_huff_4_codes[256].m_code_size);
 		}
+		writer.flush();
+
+		// Write zlib adler32
+		for (uint32_t i = 0; i < 4; i++, adler <<= 8)
+		{
+			out_buf.push_back(static_cast<uint8_t>(adler >> 24));
+		}
+
+		write_png_container(out_buf, w, h, num_chans);
 
 		return true;
 	}
@@ -2144,7 +2891,7 @@ do { \
 		num_clen_codes += 4;
 
 		//uint8_t clen_codesizes[DEFL_MAX_HUFF_SYMBOLS_2]{};
-		std::unique_ptr<uint8_t[]> clen_codesizes(new uint8_t[DEFL_MAX_HUFF_SYMBOLS_2]);
+		std::unique_ptr<uint8_t[]> clen_codesizes(new uint8_t[DEFL_MAX_HUFF_SYMBOLS_2]());
 
 		for (uint32_t i = 0; i < num_clen_codes; i++)
 		{
@@ -3198,40 +3945,21 @@ do { \
 	};
 #pragma pack(pop)
 
-	int fpng_get_info_internal(const void* pImage
-		, size_t image_size, size_t& width, size_t& height
-		, size_t& channels_in_file
-		, size_t& idat_ofs, size_t& idat_len)
-	{
-		constexpr uint8_t s_png_sig[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
-
-		if (!endian_check())
-		{
-			assert(0);
-			return false;
-		}
-
-		width = 0;
-		height = 0;
-		channels_in_file = 0;
-		idat_ofs = 0, idat_len = 0;
+	static constexpr size_t PNG_IHDR_END = 8 + sizeof(png_ihdr);
 
-		// Ensure the file has at least a minimum possible size
-		if (image_size < (sizeof(s_png_sig) + sizeof(png_ihdr) + sizeof(png_chunk_prefix) + 1 + sizeof(uint32_t) + sizeof(png_iend)))
-		{
-			return FPNG_DECODE_FAILED_NOT_PNG;
-		}
+	static constexpr uint8_t s_png_sig[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
 
-		if (memcmp(pImage, s_png_sig, 8) != 0)
+	// Validates the png signature and the IHDR chunk, pHeader must hold PNG_IHDR_END bytes
+	static int parse_png_ihdr(const uint8_t* pHeader, size_t& width, size_t& height, size_t& channels_in_file)
+	{
+		if (memcmp(pHeader, s_png_sig, 8) != 0)
 		{
 			return FPNG_DECODE_FAILED_NOT_PNG;
 		}
 
-		const uint8_t* pImage_u8 = static_cast<const uint8_t*>(pImage) + 8;
+		const uint8_t* pImage_u8 = pHeader + 8;
 
 		const png_ihdr& ihdr = *reinterpret_cast<const png_ihdr*>(pImage_u8);
-		pImage_u8 += sizeof(png_ihdr);
-
 		if (READ_BE32(&ihdr.m_prefix.m_length) != IHDR_EXPECTED_LENGTH)
 		{
 			return FPNG_DECODE_FAILED_NOT_PNG;
@@ -3273,18 +4001,50 @@ do { \
 			return FPNG_DECODE_NOT_FPNG;
 		}
 
-		// Scan all the chunks. Look for one IDAT, IEND, and our custom fdEC chunk that indicates the file was compressed by us. Skip any ancillary chunks.
-		bool found_fdec_chunk = false;
+		return FPNG_DECODE_SUCCESS;
+	}
 
-		for (; ; )
+	int fpng_get_info_internal(const void* pImage
+		, size_t image_size, size_t& width, size_t& height
+		, size_t& channels_in_file
+		, size_t& idat_ofs, size_t& idat_len)
+	{
+		if (!endian_check())
 		{
-			const size_t src_ofs = pImage_u8 - static_cast<const uint8_t*>(pImage);
-			if (image_size <= src_ofs)
-			{
-				return FPNG_DECODE_FAILED_CHUNK_PARSING;
-			}
+			assert(0);
+			return false;
+		}
 
-			const size_t bytes_remaining = image_size - src_ofs;
+		width = 0;
+		height = 0;
+		channels_in_file = 0;
+		idat_ofs = 0, idat_len = 0;
+
+		// Ensure the file has at least a minimum possible size
+		if (image_size < (sizeof(s_png_sig) + sizeof(png_ihdr) + sizeof(png_chunk_prefix) + 1 + sizeof(uint32_t) + sizeof(png_iend)))
+		{
+			return FPNG_DECODE_FAILED_NOT_PNG;
+		}
+
+		if (int status = parse_png_ihdr(static_cast<const uint8_t*>(pImage), width, height, channels_in_file); FPNG_DECODE_SUCCESS != status)
+		{
+			return status;
+		}
+
+		const uint8_t* pImage_u8 = static_cast<const uint8_t*>(pImage) + PNG_IHDR_END;
+
+		// Scan all the chunks. Look for one IDAT, IEND, and our custom fdEC chunk that indicates the file was compressed by us. Skip any ancillary chunks.
+		bool found_fdec_chunk = false;
+
+		for (; ; )
+		{
+			const size_t src_ofs = pImage_u8 - static_cast<const uint8_t*>(pImage);
+			if (image_size <= src_ofs)
+			{
+				return FPNG_DECODE_FAILED_CHUNK_PARSING;
+			}
+
+			const size_t bytes_remaining = image_size - src_ofs;
 			if (bytes_remaining < sizeof(uint32_t) * 3)
 			{
 				return FPNG_DECODE_FAILED_CHUNK_PARSING;
@@ -3293,7 +4053,7 @@ do { \
 			const png_chunk_prefix* pChunk = reinterpret_cast<const png_chunk_prefix*>(pImage_u8);
 
 			const uint32_t chunk_len = READ_BE32(&pChunk->m_length);
-			if ((src_ofs + sizeof(uint32_t) + chunk_len + sizeof(uint32_t)) > image_size)
+			if ((src_ofs + sizeof(png_chunk_prefix) + chunk_len + sizeof(uint32_t)) > image_size)
 			{
 				return FPNG_DECODE_FAILED_CHUNK_PARSING;
 			}
@@ -3479,6 +4239,683 @@ do { \
 		return FPNG_DECODE_SUCCESS;
 	}
 
+	// Streaming decompression
+
+	// Unused bytes kept in the IDAT window are never less than this
+	static constexpr size_t FPNG_STREAM_MIN_WINDOW = 64 * 1024;
+
+	class fpng_stream_source
+	{
+	public:
+		fpng_stream_source(fpng_read_func pRead, void* pUser) noexcept
+			: m_pRead(pRead), m_pUser(pUser)
+		{}
+
+		// Reads exactly size bytes
+		[[nodiscard]]
+		bool read(void* pDst, size_t size)
+		{
+			uint8_t* pBytes = static_cast<uint8_t*>(pDst);
+
+			while (size)
+			{
+				const size_t n = m_pRead(m_pUser, pBytes, size);
+				if ((!n) || (n > size))
+				{
+					return false;
+				}
+
+				pBytes += n;
+				size -= n;
+			}
+
+			return true;
+		}
+
+		// Reads and discards size bytes, updating the running crc32
+		[[nodiscard]]
+		bool skip(size_t size, uint32_t& crc32)
+		{
+			uint8_t scratch[1024];
+
+			while (size)
+			{
+				const size_t n = minimum(size, sizeof(scratch));
+				if (!read(scratch, n))
+				{
+					return false;
+				}
+
+				crc32 = fpng_crc32(scratch, n, crc32);
+				size -= n;
+			}
+
+			return true;
+		}
+
+	private:
+		fpng_read_func m_pRead;
+		void* m_pUser;
+	};
+
+	// The bit buffer reads ahead past the end of the IDAT, which fpng_decode_memory() gets from the CRC and IEND bytes
+	static constexpr size_t FPNG_STREAM_PADDING = 8;
+
+	// Holds the part of the IDAT stream which is not decoded yet.
+	// The window grows to at most two worst case scanlines, regardless of the image height.
+	class fpng_idat_window
+	{
+	public:
+		fpng_idat_window(fpng_stream_source& source, size_t idat_len, size_t capacity)
+			: m_source(source), m_buf(capacity + FPNG_STREAM_PADDING), m_remaining(idat_len)
+			, m_crc32(fpng_crc32(reinterpret_cast<const uint8_t*>("IDAT"), 4, FPNG_CRC32_INIT))
+		{}
+
+		// Moves the unread bytes to the front and reads until the window is full or the IDAT ends
+		[[nodiscard]]
+		bool refill(size_t& src_ofs, size_t& src_len)
+		{
+			if (src_ofs)
+			{
+				memmove(m_buf.data(), m_buf.data() + src_ofs, src_len - src_ofs);
+				src_len -= src_ofs;
+				src_ofs = 0;
+			}
+
+			const size_t n = minimum(m_buf.size() - FPNG_STREAM_PADDING - src_len, m_remaining);
+			if (n)
+			{
+				if (!m_source.read(m_buf.data() + src_len, n))
+				{
+					return false;
+				}
+
+				m_crc32 = fpng_crc32(m_buf.data() + src_len, n, m_crc32);
+				src_len += n;
+				m_remaining -= n;
+			}
+
+			if ((!m_remaining) && (!m_padded))
+			{
+				memset(m_buf.data() + src_len, 0, FPNG_STREAM_PADDING);
+				src_len += FPNG_STREAM_PADDING;
+				m_padded = true;
+			}
+
+			return true;
+		}
+
+		// Reads the crc32 following the IDAT, once all of it went through the window
+		[[nodiscard]]
+		int finish()
+		{
+			uint32_t expected_crc32;
+			if (!m_source.read(&expected_crc32, sizeof(expected_crc32)))
+			{
+				return FPNG_DECODE_FAILED_CHUNK_PARSING;
+			}
+
+#if !FPNG_DISABLE_DECODE_CRC32_CHECKS
+			if (m_crc32 != READ_BE32(&expected_crc32))
+			{
+				return FPNG_DECODE_FAILED_HEADER_CRC32;
+			}
+#endif
+
+			return FPNG_DECODE_SUCCESS;
+		}
+
+		[[nodiscard]] const uint8_t* data() const noexcept { return m_buf.data(); }
+		[[nodiscard]] bool exhausted() const noexcept { return 0 == m_remaining; }
+
+	private:
+		fpng_stream_source& m_source;
+		std::vector<uint8_t> m_buf;
+		size_t m_remaining;
+		uint32_t m_crc32;
+		bool m_padded = false;
+	};
+
+	// Converts a reconstructed scanline to the requested channels and passes it to the sink
+	class fpng_row_emitter
+	{
+	public:
+		fpng_row_emitter(fpng_row_func pRow, void* pUser, size_t w, size_t h, size_t src_chans, size_t dst_chans)
+			: m_pRow(pRow), m_pUser(pUser)
+			, m_width(w), m_height(h), m_src_chans(src_chans), m_dst_chans(dst_chans)
+			, m_converted(src_chans != dst_chans ? w * dst_chans : 0)
+		{}
+
+		[[nodiscard]]
+		bool emit(const uint8_t* pSrc_row, size_t y)
+		{
+			const uint8_t* pRow = pSrc_row;
+
+			if (m_src_chans != m_dst_chans)
+			{
+				uint8_t* pDst = m_converted.data();
+
+				for (size_t x = 0; x < m_width; x++, pSrc_row += m_src_chans, pDst += m_dst_chans)
+				{
+					pDst[0] = pSrc_row[0];
+					pDst[1] = pSrc_row[1];
+					pDst[2] = pSrc_row[2];
+
+					if (m_dst_chans == 4)
+					{
+						pDst[3] = 0xFF;
+					}
+				}
+
+				pRow = m_converted.data();
+			}
+
+			return m_pRow(m_pUser, pRow, y, m_width, m_height, m_dst_chans);
+		}
+
+	private:
+		fpng_row_func m_pRow;
+		void* m_pUser;
+		size_t m_width, m_height, m_src_chans, m_dst_chans;
+		std::vector<uint8_t> m_converted;
+	};
+
+	enum class fpng_stream_result
+	{
+		success,
+		invalid,
+		read_failed,
+		aborted
+	};
+
+	// Stored blocks: every scanline is a zero filter byte followed by the raw pixels
+	static fpng_stream_result fpng_stream_raw_decompress(fpng_idat_window& window
+		, size_t& src_ofs, size_t& src_len
+		, fpng_row_emitter& emitter, uint8_t* pRow
+		, const size_t& w, const size_t& h, const size_t& src_chans)
+	{
+		const size_t src_bpl = w * src_chans;
+
+		size_t y = 0;
+		size_t raster_ofs = 0;
+
+		for (; ; )
+		{
+			if ((src_ofs + 5) > src_len)
+			{
+				if (!window.refill(src_ofs, src_len))
+					return fpng_stream_result::read_failed;
+
+				if ((src_ofs + 5) > src_len)
+					return fpng_stream_result::invalid;
+			}
+
+			const uint8_t* pSrc = window.data();
+
+			const bool bfinal = (pSrc[src_ofs] & 1) != 0;
+			const uint32_t btype = (pSrc[src_ofs] >> 1) & 3;
+			if (btype != 0)
+				return fpng_stream_result::invalid;
+
+			const uint32_t len = pSrc[src_ofs + 1] | (pSrc[src_ofs + 2] << 8);
+			const uint32_t nlen = pSrc[src_ofs + 3] | (pSrc[src_ofs + 4] << 8);
+			src_ofs += 5;
+
+			if (len != (~nlen & 0xFFFF))
+				return fpng_stream_result::invalid;
+
+			for (uint32_t i = 0; i < len; )
+			{
+				if (src_ofs == src_len)
+				{
+					if (!window.refill(src_ofs, src_len))
+						return fpng_stream_result::read_failed;
+
+					if (src_ofs == src_len)
+						return fpng_stream_result::invalid;
+				}
+
+				pSrc = window.data();
+
+				const size_t n = minimum<size_t>(len - i, src_len - src_ofs);
+
+				for (size_t j = 0; j < n; j++)
+				{
+					const uint8_t c = pSrc[src_ofs + j];
+
+					if (!raster_ofs)
+					{
+						// Check filter type
+						if ((c != 0) || (y == h))
+							return fpng_stream_result::invalid;
+					}
+					else
+					{
+						pRow[raster_ofs - 1] = c;
+					}
+
+					if (++raster_ofs == (src_bpl + 1))
+					{
+						if (!emitter.emit(pRow, y))
+							return fpng_stream_result::aborted;
+
+						raster_ofs = 0;
+						y++;
+					}
+				}
+
+				src_ofs += n;
+				i += static_cast<uint32_t>(n);
+			}
+
+			if (bfinal)
+				break;
+		}
+
+		if ((raster_ofs != 0) || (y != h))
+			return fpng_stream_result::invalid;
+
+		return fpng_stream_result::success;
+	}
+
+	// Huffman coded block: the same constraints as fpng_pixel_zlib_decompress_3/4, one scanline at a time
+	static fpng_stream_result fpng_stream_dynamic_decompress(fpng_idat_window& window
+		, size_t& src_ofs, size_t& src_len
+		, fpng_row_emitter& emitter, uint8_t* pPrev_scanline, uint8_t* pCur_scanline
+		, const size_t& w, const size_t& h, const size_t& src_chans)
+	{
+		const size_t src_bpl = w * src_chans;
+
+		// Every byte of a scanline costs at most one 12 bit literal, plus 8 bytes of bit buffer look ahead
+		const size_t max_row_bytes = ((src_bpl + 1) * FPNG_DECODER_TABLE_BITS + 7) / 8 + 8;
+
+		const uint8_t* pSrc = window.data();
+
+		if ((src_ofs + 4) > src_len)
+			return fpng_stream_result::invalid;
+
+		uint64_t bit_buf = READ_LE32(pSrc + src_ofs);
+		src_ofs += 4;
+
+		size_t bit_buf_size = 32;
+
+		// The bit reading macros bail out with false, so they only run inside of these lambdas
+		const auto read_block_header = [&]() -> bool
+		{
+			uint32_t bfinal, btype;
+			GET_BITS(bfinal, 1);
+			GET_BITS(btype, 2);
+
+			// Must be the final block or it's not valid, and type=2 (dynamic)
+			if ((bfinal != 1) || (btype != 2))
+				return false;
+
+			return true;
+		};
+
+		if (!read_block_header())
+			return fpng_stream_result::invalid;
+
+		std::unique_ptr<uint32_t[]> lit_table(new uint32_t[FPNG_DECODER_TABLE_SIZE]);
+
+		if (!prepare_dynamic_block(pSrc, src_len, src_ofs, bit_buf_size, bit_buf, lit_table.get(), src_chans))
+			return fpng_stream_result::invalid;
+
+		const auto decode_symbol = [&](uint32_t& sym) -> bool
+		{
+			assert(bit_buf_size >= FPNG_DECODER_TABLE_BITS);
+			sym = lit_table[bit_buf & (FPNG_DECODER_TABLE_SIZE - 1)];
+
+			const uint32_t sym_len = (sym >> 9) & 15;
+			if (!sym_len)
+				return false;
+
+			SKIP_BITS(sym_len);
+			sym &= 511;
+
+			return true;
+		};
+
+		const auto decode_row = [&](const uint32_t& y) -> bool
+		{
+			uint32_t filter;
+			if (!decode_symbol(filter))
+				return false;
+
+			if (filter != (y ? 2U : 0U))
+				return false;
+
+			uint8_t deltas[4]{};
+			size_t x_ofs = 0;
+
+			while (x_ofs < src_bpl)
+			{
+				uint32_t lit0;
+				if (!decode_symbol(lit0))
+					return false;
+
+				if (lit0 < 256)
+				{
+					deltas[0] = static_cast<uint8_t>(lit0);
+
+					for (size_t c = 1; c < src_chans; c++)
+					{
+						uint32_t lit;
+						if ((!decode_symbol(lit)) || (lit >= 256))
+							return false;
+
+						deltas[c] = static_cast<uint8_t>(lit);
+					}
+
+					for (size_t c = 0; c < src_chans; c++)
+					{
+						pCur_scanline[x_ofs + c] = static_cast<uint8_t>((y ? pPrev_scanline[x_ofs + c] : 0) + deltas[c]);
+					}
+
+					x_ofs += src_chans;
+					continue;
+				}
+
+				// Can't be EOB - we still have more pixels to decompress.
+				// A match at the start of a scanline would reach into the filter byte.
+				if ((lit0 == 256) || (lit0 > 285) || (!x_ofs))
+					return false;
+
+				// Must be an RLE match against the previous pixel.
+				uint32_t run_len = s_length_range[lit0 - 257];
+				if (s_length_extra[lit0 - 257])
+				{
+					uint32_t e;
+					GET_BITS(e, s_length_extra[lit0 - 257]);
+
+					run_len += e;
+				}
+
+				// Skip match distance - it's always the same (3 or 4)
+				SKIP_BITS(1);
+
+				// Matches must always be a multiple of 3/4 bytes, and cannot cross scanlines.
+				if ((run_len % src_chans) || ((x_ofs + run_len) > src_bpl))
+					return false;
+
+				const size_t x_ofs_end = x_ofs + run_len;
+				do
+				{
+					for (size_t c = 0; c < src_chans; c++)
+					{
+						pCur_scanline[x_ofs + c] = static_cast<uint8_t>((y ? pPrev_scanline[x_ofs + c] : 0) + deltas[c]);
+					}
+
+					x_ofs += src_chans;
+				}
+				while (x_ofs < x_ofs_end);
+			}
+
+			return true;
+		};
+
+		for (uint32_t y = 0; y < h; y++)
+		{
+			// Keep a whole scanline of compressed data in the window
+			if ((!window.exhausted()) && ((src_len - src_ofs) < max_row_bytes))
+			{
+				if (!window.refill(src_ofs, src_len))
+					return fpng_stream_result::read_failed;
+
+				pSrc = window.data();
+			}
+
+			if (!decode_row(y))
+				return fpng_stream_result::invalid;
+
+			if (!emitter.emit(pCur_scanline, y))
+				return fpng_stream_result::aborted;
+
+			std::swap(pPrev_scanline, pCur_scanline);
+		}
+
+		// The last symbol should be EOB
+		uint32_t lit0 = lit_table[bit_buf & (FPNG_DECODER_TABLE_SIZE - 1)];
+		const uint32_t lit0_len = (lit0 >> 9) & 15;
+		if ((!lit0_len) || ((lit0 & 511) != 256))
+			return fpng_stream_result::invalid;
+
+		bit_buf_size -= lit0_len;
+		bit_buf >>= lit0_len;
+
+		bit_buf_size -= bit_buf_size & 7;
+
+		// Only the zlib adler32 may be left, like fpng_pixel_zlib_decompress_3/4 require
+		const size_t unread = (src_len - src_ofs) + (bit_buf_size >> 3);
+		if (!window.exhausted() || (unread != sizeof(uint32_t) + FPNG_STREAM_PADDING))
+			return fpng_stream_result::invalid;
+
+		return fpng_stream_result::success;
+	}
+
+	int fpng_decode_stream(fpng_read_func pRead, void* pRead_user
+		, fpng_row_func pRow, void* pRow_user
+		, size_t& width, size_t& height
+		, size_t& channels_in_file, size_t desired_channels)
+	{
+		width = 0;
+		height = 0;
+		channels_in_file = 0;
+
+		if ((!pRead) || (!pRow) || ((desired_channels != 3) && (desired_channels != 4)))
+		{
+			assert(0);
+			return FPNG_DECODE_INVALID_ARG;
+		}
+
+		if (!endian_check())
+		{
+			assert(0);
+			return FPNG_DECODE_INVALID_ARG;
+		}
+
+		fpng_stream_source source{ pRead, pRead_user };
+
+		uint8_t header[PNG_IHDR_END];
+		if (!source.read(header, sizeof(header)))
+		{
+			return FPNG_DECODE_FAILED_NOT_PNG;
+		}
+
+		if (int status = parse_png_ihdr(header, width, height, channels_in_file); FPNG_DECODE_SUCCESS != status)
+		{
+			return status;
+		}
+
+		// Walk the chunks until the IDAT, the fdEC chunk has to come first
+		bool found_fdec_chunk = false;
+		size_t idat_len = 0;
+
+		for (; ; )
+		{
+			png_chunk_prefix chunk;
+			if (!source.read(&chunk, sizeof(chunk)))
+			{
+				return FPNG_DECODE_FAILED_CHUNK_PARSING;
+			}
+
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				const uint8_t c = chunk.m_type[i];
+				const bool is_upper = (c >= 65) && (c <= 90), is_lower = (c >= 97) && (c <= 122);
+				if ((!is_upper) && (!is_lower))
+				{
+					return FPNG_DECODE_FAILED_CHUNK_PARSING;
+				}
+			}
+
+			const uint32_t chunk_len = READ_BE32(&chunk.m_length);
+
+			if (memcmp(chunk.m_type, "IDAT", 4) == 0)
+			{
+				if (!found_fdec_chunk)
+				{
+					return FPNG_DECODE_NOT_FPNG;
+				}
+
+				idat_len = chunk_len;
+
+				// Sanity check the IDAT chunk length
+				if (idat_len < 7)
+				{
+					return FPNG_DECODE_FAILED_INVALID_IDAT;
+				}
+
+				break;
+			}
+
+			if (memcmp(chunk.m_type, "IEND", 4) == 0)
+			{
+				return FPNG_DECODE_NOT_FPNG;
+			}
+
+			uint32_t actual_crc32 = fpng_crc32(chunk.m_type, sizeof(chunk.m_type), FPNG_CRC32_INIT);
+
+			if (memcmp(chunk.m_type, "fdEC", 4) == 0)
+			{
+				uint8_t fdec[5];
+
+				// We've got our fdEC chunk. Now make sure it's big enough and check its contents.
+				if ((found_fdec_chunk) || (chunk_len != sizeof(fdec)))
+				{
+					return FPNG_DECODE_NOT_FPNG;
+				}
+
+				if (!source.read(fdec, sizeof(fdec)))
+				{
+					return FPNG_DECODE_FAILED_CHUNK_PARSING;
+				}
+
+				// Check fdEC chunk sig and version
+				if ((fdec[0] != 82) || (fdec[1] != 36) || (fdec[2] != 147) || (fdec[3] != 227) || (fdec[4] != FPNG_FDEC_VERSION))
+				{
+					return FPNG_DECODE_NOT_FPNG;
+				}
+
+				actual_crc32 = fpng_crc32(fdec, sizeof(fdec), actual_crc32);
+				found_fdec_chunk = true;
+			}
+			else
+			{
+				// Bail if it's a critical chunk - can't be FPNG
+				if ((chunk.m_type[0] & 32) == 0)
+				{
+					return FPNG_DECODE_NOT_FPNG;
+				}
+
+				// ancillary chunk - skip it
+				if (!source.skip(chunk_len, actual_crc32))
+				{
+					return FPNG_DECODE_FAILED_CHUNK_PARSING;
+				}
+			}
+
+			uint32_t expected_crc32;
+			if (!source.read(&expected_crc32, sizeof(expected_crc32)))
+			{
+				return FPNG_DECODE_FAILED_CHUNK_PARSING;
+			}
+
+#if !FPNG_DISABLE_DECODE_CRC32_CHECKS
+			if (actual_crc32 != READ_BE32(&expected_crc32))
+			{
+				return FPNG_DECODE_FAILED_HEADER_CRC32;
+			}
+#endif
+		}
+
+		const size_t src_bpl = width * channels_in_file;
+		const size_t max_row_bytes = ((src_bpl + 1) * FPNG_DECODER_TABLE_BITS + 7) / 8 + 8;
+
+		fpng_idat_window window{ source, idat_len, maximum(FPNG_STREAM_MIN_WINDOW, max_row_bytes * 2) };
+		fpng_row_emitter emitter{ pRow, pRow_user, width, height, channels_in_file, desired_channels };
+
+		size_t src_ofs = 0, src_len = 0;
+		if (!window.refill(src_ofs, src_len))
+		{
+			return FPNG_DECODE_FILE_READ_FAILED;
+		}
+
+		const uint8_t* pSrc = window.data();
+
+		// check zlib header
+		if ((src_len < 3) || (pSrc[0] != 0x78) || (pSrc[1] != 0x01))
+		{
+			return FPNG_DECODE_NOT_FPNG;
+		}
+
+		src_ofs = 2;
+
+		// Previous and current scanlines
+		std::vector<uint8_t> scanlines(src_bpl * 2);
+
+		fpng_stream_result result;
+		if ((pSrc[src_ofs] & 6) == 0)
+		{
+			result = fpng_stream_raw_decompress(window, src_ofs, src_len, emitter, scanlines.data(), width, height, channels_in_file);
+		}
+		else
+		{
+			result = fpng_stream_dynamic_decompress(window, src_ofs, src_len, emitter, scanlines.data(), scanlines.data() + src_bpl, width, height, channels_in_file);
+		}
+
+		switch (result)
+		{
+			case fpng_stream_result::success:
+				// The rows are out already, a damaged or cut chunk still fails the decoding like fpng_decode_memory()
+				return window.finish();
+
+			case fpng_stream_result::read_failed:
+				return FPNG_DECODE_FILE_READ_FAILED;
+
+			case fpng_stream_result::aborted:
+				return FPNG_DECODE_ABORTED;
+
+			default:
+				// Corrupted, or it doesn't conform to one of our zlib/Deflate constraints.
+				return FPNG_DECODE_NOT_FPNG;
+		}
+	}
+
+	struct fpng_memory_source
+	{
+		const uint8_t* m_pData;
+		size_t m_size;
+		size_t m_ofs;
+	};
+
+	static size_t fpng_read_memory(void* pUser, void* pDst, size_t size)
+	{
+		fpng_memory_source& source = *static_cast<fpng_memory_source*>(pUser);
+
+		const size_t n = minimum(size, source.m_size - source.m_ofs);
+		memcpy(pDst, source.m_pData + source.m_ofs, n);
+		source.m_ofs += n;
+
+		return n;
+	}
+
+	int fpng_decode_memory_rows(const void* pImage, size_t image_size
+		, fpng_row_func pRow, void* pRow_user
+		, size_t& width, size_t& height
+		, size_t& channels_in_file, size_t desired_channels)
+	{
+		if ((!pImage) || (!image_size))
+		{
+			assert(0);
+			return FPNG_DECODE_INVALID_ARG;
+		}
+
+		fpng_memory_source source{ static_cast<const uint8_t*>(pImage), image_size, 0 };
+
+		return fpng_decode_stream(fpng_read_memory, &source, pRow, pRow_user, width, height, channels_in_file, desired_channels);
+	}
+
 #ifndef FPNG_NO_STDIO
 	int fpng_decode_file(const char* pFilename, std::vector<uint8_t>& out, size_t& width, size_t& height, size_t& channels_in_file, size_t desired_channels)
 	{
@@ -3528,6 +4965,31 @@ do { \
 
 		return fpng_decode_memory(buf.data(), buf.size(), out, width, height, channels_in_file, desired_channels);
 		}
+
+	static size_t fpng_read_file(void* pUser, void* pDst, size_t size)
+	{
+		return fread(pDst, 1, size, static_cast<FILE*>(pUser));
+	}
+
+	int fpng_decode_file_rows(const char* pFilename, fpng_row_func pRow, void* pRow_user, size_t& width, size_t& height, size_t& channels_in_file, size_t desired_channels)
+	{
+		FILE* pFile = nullptr;
+
+#ifdef _MSC_VER
+		fopen_s(&pFile, pFilename, "rb");
+#else
+		pFile = fopen(pFilename, "rb");
+#endif
+
+		if (!pFile)
+			return FPNG_DECODE_FILE_OPEN_FAILED;
+
+		const int status = fpng_decode_stream(fpng_read_file, pFile, pRow, pRow_user, width, height, channels_in_file, desired_channels);
+
+		fclose(pFile);
+
+		return status;
+	}
 #endif
 
 } // namespace fpng
@@ -0,0 +1,277 @@
+#include <gtest/gtest.h>
+#include "Glib.Rect.hpp"
+#include "Glib.DirtyRegion.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	[[nodiscard]]
+	bool
+	IsEqual(const gl::Rect& lhs, const gl::Rect& rhs)
+	{
+		return lhs.x == rhs.x && lhs.y == rhs.y && lhs.w == rhs.w && lhs.h == rhs.h;
+	}
+
+	// The rectangles of a region never overlap
+	void
+	ExpectDisjoint(std::span<const gl::Rect> rects)
+	{
+		for (std::size_t i = 0; i < rects.size(); ++i)
+		{
+			for (std::size_t j = i + 1; j < rects.size(); ++j)
+			{
+				EXPECT_TRUE(gl::IsEmpty(gl::GetIntersection(rects[i], rects[j]))) << i << " and " << j;
+			}
+		}
+	}
+}
+
+TEST(Rect, IntersectionsAndUnions)
+{
+	const gl::Rect a{ 0, 0, 10, 10 };
+	const gl::Rect b{ 5, 5, 10, 10 };
+
+	EXPECT_TRUE(IsEqual(gl::Rect{ 5, 5, 5, 5 }, gl::GetIntersection(a, b)));
+	EXPECT_TRUE(IsEqual(gl::Rect{ 0, 0, 15, 15 }, gl::GetUnion(a, b)));
+
+	// Touching is not overlapping
+	EXPECT_TRUE(gl::IsEmpty(gl::GetIntersection(a, gl::Rect{ 10, 0, 5, 5 })));
+
+	// The empty rectangles are left out of a union
+	EXPECT_TRUE(IsEqual(b, gl::GetUnion(gl::Rect{ -100, -100, 0, 0 }, b)));
+	EXPECT_TRUE(IsEqual(a, gl::GetUnion(a, gl::Rect{ 100, 100, 5, -1 })));
+	EXPECT_EQ(0, gl::GetArea(gl::Rect{ 0, 0, -5, 5 }));
+
+	EXPECT_TRUE(gl::Contains(a, gl::Rect{ 2, 2, 8, 8 }));
+	EXPECT_FALSE(gl::Contains(a, b));
+}
+
+TEST(DirtyRegion, IgnoresEmptyRects)
+{
+	gl::DirtyRegion region{};
+	region.Add(gl::Rect{ 0, 0, 0, 10 });
+	region.Add(gl::Rect{ 0, 0, 10, -1 });
+
+	EXPECT_TRUE(region.IsEmpty());
+	EXPECT_TRUE(gl::IsEmpty(region.GetBounds()));
+	EXPECT_EQ(0, region.GetArea());
+}
+
+TEST(DirtyRegion, MergesOverlappingAndTouchingRects)
+{
+	gl::DirtyRegion region{};
+	region.Add(gl::Rect{ 0, 0, 10, 10 });
+	region.Add(gl::Rect{ 5, 5, 10, 10 });
+
+	ASSERT_EQ(1U, region.GetRects().size());
+	EXPECT_TRUE(IsEqual(gl::Rect{ 0, 0, 15, 15 }, region.GetRects()[0]));
+
+	// Side by side, the union wastes nothing
+	region.Add(gl::Rect{ 15, 0, 5, 15 });
+	ASSERT_EQ(1U, region.GetRects().size());
+	EXPECT_TRUE(IsEqual(gl::Rect{ 0, 0, 20, 15 }, region.GetRects()[0]));
+
+	// Inside the region already
+	region.Add(gl::Rect{ 2, 2, 3, 3 });
+	ASSERT_EQ(1U, region.GetRects().size());
+	EXPECT_EQ(20 * 15, region.GetArea());
+}
+
+TEST(DirtyRegion, MergesCloseRectsWhenLittleIsWasted)
+{
+	gl::DirtyRegion region{};
+	region.Add(gl::Rect{ 0, 0, 10, 10 });
+	// A column apart, the union wastes a twentieth
+	region.Add(gl::Rect{ 11, 0, 10, 10 });
+
+	ASSERT_EQ(1U, region.GetRects().size());
+	EXPECT_TRUE(IsEqual(gl::Rect{ 0, 0, 21, 10 }, region.GetRects()[0]));
+
+	// Diagonally away, the union would be mostly waste
+	region.Add(gl::Rect{ 40, 40, 10, 10 });
+	EXPECT_EQ(2U, region.GetRects().size());
+	EXPECT_EQ(210 + 100, region.GetArea());
+	EXPECT_TRUE(IsEqual(gl::Rect{ 0, 0, 50, 50 }, region.GetBounds()));
+}
+
+TEST(DirtyRegion, AGrownRectSwallowsTheOnesItReaches)
+{
+	gl::DirtyRegion region{};
+	region.Add(gl::Rect{ 0, 0, 10, 10 });
+	region.Add(gl::Rect{ 50, 0, 10, 10 });
+	region.Add(gl::Rect{ 100, 0, 10, 10 });
+	ASSERT_EQ(3U, region.GetRects().size());
+
+	// Overlaps the first, then its union overlaps the two others
+	region.Add(gl::Rect{ 5, 0, 100, 10 });
+
+	ASSERT_EQ(1U, region.GetRects().size());
+	EXPECT_TRUE(IsEqual(gl::Rect{ 0, 0, 110, 10 }, region.GetRects()[0]));
+}
+
+TEST(DirtyRegion, StaysWithinTheLimit)
+{
+	constexpr std::size_t Limit = 4;
+
+	gl::DirtyRegion region{ Limit };
+	std::mt19937 random{ 11 };
+	std::uniform_int_distribution<int> position{ 0, 1000 };
+	std::uniform_int_distribution<int> size{ 1, 20 };
+
+	std::vector<gl::Rect> added{};
+	for (int i = 0; i < 200; ++i)
+	{
+		const gl::Rect rect{ position(random), position(random), size(random), size(random) };
+		region.Add(rect);
+		added.push_back(rect);
+
+		ASSERT_GE(Limit, region.GetRects().size());
+	}
+
+	const std::span<const gl::Rect> rects = region.GetRects();
+	ExpectDisjoint(rects);
+
+	// Every rectangle is still covered, by one rectangle of the region
+	for (const gl::Rect& rect : added)
+	{
+		EXPECT_TRUE(std::ranges::any_of(rects, [&](const gl::Rect& dirty) { return gl::Contains(dirty, rect); }));
+	}
+}
+
+TEST(DirtyRegion, MergesTheCheapestPairPastTheLimit)
+{
+	gl::DirtyRegion region{ 2 };
+	region.Add(gl::Rect{ 0, 0, 10, 10 });
+	region.Add(gl::Rect{ 100, 0, 10, 10 });
+	// Closer to the second than the first is to either
+	region.Add(gl::Rect{ 100, 30, 10, 10 });
+
+	ASSERT_EQ(2U, region.GetRects().size());
+	EXPECT_TRUE(std::ranges::any_of(region.GetRects(), [](const gl::Rect& rect) { return IsEqual(gl::Rect{ 0, 0, 10, 10 }, rect); }));
+	EXPECT_TRUE(std::ranges::any_of(region.GetRects(), [](const gl::Rect& rect) { return IsEqual(gl::Rect{ 100, 0, 10, 40 }, rect); }));
+}
+
+TEST(DirtyRegion, ClipCutsAndDrops)
+{
+	gl::DirtyRegion region{};
+	region.Add(gl::Rect{ -5, -5, 10, 10 });
+	region.Add(gl::Rect{ 50, 50, 10, 10 });
+	region.Add(gl::Rect{ 200, 200, 10, 10 });
+
+	region.Clip(gl::Rect{ 0, 0, 100, 100 });
+
+	ASSERT_EQ(2U, region.GetRects().size());
+	EXPECT_EQ(25 + 100, region.GetArea());
+	EXPECT_TRUE(gl::Contains(gl::Rect{ 0, 0, 100, 100 }, region.GetBounds()));
+
+	region.Clear();
+	EXPECT_TRUE(region.IsEmpty());
+}
+
+TEST(DirtyRegion, KeepsAtLeastOneRect)
+{
+	gl::DirtyRegion region{ 0 };
+	EXPECT_EQ(1U, region.GetLimit());
+
+	region.Add(gl::Rect{ 0, 0, 10, 10 });
+	region.Add(gl::Rect{ 90, 90, 10, 10 });
+
+	ASSERT_EQ(1U, region.GetRects().size());
+	EXPECT_TRUE(IsEqual(gl::Rect{ 0, 0, 100, 100 }, region.GetRects()[0]));
+	EXPECT_EQ(gl::DirtyRegion::DefaultLimit, gl::DirtyRegion{}.GetLimit());
+}
+
+TEST(SharedDirtyRegion, TakesTheRectsAndStartsOver)
+{
+	const gl::Rect client{ 0, 0, 100, 100 };
+
+	gl::SharedDirtyRegion shared{};
+	shared.Add(gl::Rect{ 10, 10, 20, 20 });
+	shared.Add(gl::Rect{ 90, 90, 20, 20 });
+
+	// Asked to paint what is already dirty
+	gl::DirtyRegion frame{};
+	shared.Take(gl::Rect{ 10, 10, 5, 5 }, client, frame);
+
+	ASSERT_EQ(2U, frame.GetRects().size());
+	EXPECT_EQ(400 + 100, frame.GetArea());
+	EXPECT_TRUE(gl::Contains(client, frame.GetBounds()));
+
+	// Nothing was invalidated since, the system still asks for a paint
+	shared.Take(gl::Rect{ 40, 40, 10, 10 }, client, frame);
+	ASSERT_EQ(1U, frame.GetRects().size());
+	EXPECT_TRUE(IsEqual(gl::Rect{ 40, 40, 10, 10 }, frame.GetRects()[0]));
+
+	shared.Take(gl::Rect{}, client, frame);
+	EXPECT_TRUE(frame.IsEmpty());
+}
+
+TEST(SharedDirtyRegion, ResetReplacesEveryRect)
+{
+	gl::SharedDirtyRegion shared{};
+	shared.Add(gl::Rect{ 0, 0, 10, 10 });
+	shared.Add(gl::Rect{ 50, 50, 10, 10 });
+	shared.Reset(gl::Rect{ 0, 0, 20, 20 });
+
+	gl::DirtyRegion frame{};
+	shared.Take(gl::Rect{}, gl::Rect{ 0, 0, 100, 100 }, frame);
+
+	ASSERT_EQ(1U, frame.GetRects().size());
+	EXPECT_TRUE(IsEqual(gl::Rect{ 0, 0, 20, 20 }, frame.GetRects()[0]));
+}
+
+TEST(SharedDirtyRegion, NoRectIsLostBetweenThreads)
+{
+	constexpr int Workers = 4;
+	constexpr int RectsPerWorker = 500;
+	const gl::Rect client{ 0, 0, Workers * 10, RectsPerWorker * 10 };
+
+	gl::SharedDirtyRegion shared{};
+	std::atomic<int> running{ Workers };
+
+	// Every worker invalidates its own column, a cell at a time
+	std::vector<std::thread> workers{};
+	for (int worker = 0; worker < Workers; ++worker)
+	{
+		workers.emplace_back([&, worker] {
+			for (int i = 0; i < RectsPerWorker; ++i)
+			{
+				shared.Add(gl::Rect{ worker * 10, i * 10, 10, 10 });
+			}
+
+			running.fetch_sub(1);
+		});
+	}
+
+	// Paint while they do, until a paint after the last of them
+	std::vector<gl::Rect> painted{};
+	gl::DirtyRegion frame{};
+	bool is_last = false;
+	while (not is_last)
+	{
+		is_last = 0 == running.load();
+
+		shared.Take(gl::Rect{}, client, frame);
+		painted.insert(painted.end(), frame.GetRects().begin(), frame.GetRects().end());
+	}
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	for (int worker = 0; worker < Workers; ++worker)
+	{
+		for (int i = 0; i < RectsPerWorker; ++i)
+		{
+			const gl::Rect cell{ worker * 10, i * 10, 10, 10 };
+			ASSERT_TRUE(std::ranges::any_of(painted, [&](const gl::Rect& rect) { return gl::Contains(rect, cell); })) << worker << ", " << i;
+		}
+	}
+}
@@ -0,0 +1,933 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "Glib.Font.hpp"
+#include "Glib.TextBatch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr std::uint32_t UnitsPerEm = 1000;
+
+	// Glyphs of the test font
+	constexpr std::uint32_t Space = 1;
+	constexpr std::uint32_t Square = 2;
+	constexpr std::uint32_t Ring = 3;
+	constexpr std::uint32_t HalfSquare = 4;
+	constexpr std::uint32_t Round = 5;
+	constexpr std::uint32_t GlyphCount = 6;
+
+	class Writer
+	{
+	public:
+		void
+		U16(std::uint32_t value)
+		{
+			bytes.push_back(static_cast<std::uint8_t>(value >> 8));
+			bytes.push_back(static_cast<std::uint8_t>(value));
+		}
+
+		void
+		U32(std::uint32_t value)
+		{
+			U16(value >> 16);
+			U16(value & 0xFFFF);
+		}
+
+		void
+		Tag(const char(&name)[5])
+		{
+			bytes.insert(bytes.end(), name, name + 4);
+		}
+
+		void
+		Align(std::size_t alignment)
+		{
+			bytes.resize((bytes.size() + alignment - 1) / alignment * alignment);
+		}
+
+		std::vector<std::uint8_t> bytes{};
+	};
+
+	struct Contour
+	{
+		std::vector<gl::font::Point> points;
+		// Off the curve, quadratic controls
+		bool isCurved = false;
+	};
+
+	// A simple glyph, every coordinate written as a word
+	void
+	WriteGlyph(Writer& glyf, const std::vector<Contour>& contours)
+	{
+		glyf.U16(static_cast<std::uint32_t>(contours.size()));
+		for (int i = 0; i < 4; ++i)
+		{
+			glyf.U16(0);
+		}
+
+		std::uint32_t end = 0;
+		for (const Contour& contour : contours)
+		{
+			end += static_cast<std::uint32_t>(contour.points.size());
+			glyf.U16(end - 1);
+		}
+
+		// No instructions
+		glyf.U16(0);
+
+		for (const Contour& contour : contours)
+		{
+			for (std::size_t i = 0; i < contour.points.size(); ++i)
+			{
+				glyf.bytes.push_back(contour.isCurved ? 0x00 : 0x01);
+			}
+		}
+
+		std::int32_t previous = 0;
+		for (const Contour& contour : contours)
+		{
+			for (const gl::font::Point& point : contour.points)
+			{
+				glyf.U16(static_cast<std::uint16_t>(static_cast<std::int32_t>(point.x) - previous));
+				previous = static_cast<std::int32_t>(point.x);
+			}
+		}
+
+		previous = 0;
+		for (const Contour& contour : contours)
+		{
+			for (const gl::font::Point& point : contour.points)
+			{
+				glyf.U16(static_cast<std::uint16_t>(static_cast<std::int32_t>(point.y) - previous));
+				previous = static_cast<std::int32_t>(point.y);
+			}
+		}
+
+		glyf.Align(2);
+	}
+
+	/// <summary>
+	/// A TrueType font of a few glyphs, built in memory so the tests need no font file
+	/// <para>' ' has no outline, 'A' is a square, 'B' a square with a hole, 'C' the square at half its size moved right by a composite,
+	/// 'D' a contour of controls only. 'A' and 'B' are kerned, 'D' has no metric of its own.</para>
+	/// </summary>
+	[[nodiscard]]
+	std::vector<std::uint8_t>
+	MakeFont()
+	{
+		const Contour square{ { { 100, 0 }, { 100, 700 }, { 600, 700 }, { 600, 0 } } };
+
+		// Glyph data, and the offset of every glyph in it
+		Writer glyf{};
+		std::vector<std::uint32_t> loca{ 0, 0, 0 };
+
+		WriteGlyph(glyf, { square });
+		loca.push_back(static_cast<std::uint32_t>(glyf.bytes.size()));
+
+		WriteGlyph(glyf, { Contour{ { { 0, 0 }, { 0, 800 }, { 800, 800 }, { 800, 0 } } }, Contour{ { { 200, 200 }, { 600, 200 }, { 600, 600 }, { 200, 600 } } } });
+		loca.push_back(static_cast<std::uint32_t>(glyf.bytes.size()));
+
+		// Words as offsets, with one scale
+		glyf.U16(0xFFFF);
+		for (int i = 0; i < 4; ++i)
+		{
+			glyf.U16(0);
+		}
+		glyf.U16(0x0001 | 0x0002 | 0x0008);
+		glyf.U16(Square);
+		glyf.U16(500);
+		glyf.U16(0);
+		glyf.U16(0x2000);
+		loca.push_back(static_cast<std::uint32_t>(glyf.bytes.size()));
+
+		WriteGlyph(glyf, { Contour{ { { 500, 0 }, { 1000, 500 }, { 500, 1000 }, { 0, 500 } }, true } });
+		loca.push_back(static_cast<std::uint32_t>(glyf.bytes.size()));
+
+		Writer head{};
+		head.U32(0x00010000);
+		head.U32(0x00010000);
+		head.U32(0);
+		head.U32(0x5F0F3CF5);
+		head.U16(0);
+		head.U16(UnitsPerEm);
+		head.bytes.resize(50);
+		// Short offsets in the location table
+		head.U16(0);
+		head.U16(0);
+
+		Writer maxp{};
+		maxp.U32(0x00005000);
+		maxp.U16(GlyphCount);
+
+		constexpr std::uint32_t MetricCount = 5;
+
+		Writer hhea{};
+		hhea.U32(0x00010000);
+		hhea.U16(800);
+		hhea.U16(static_cast<std::uint16_t>(-200));
+		hhea.U16(0);
+		hhea.bytes.resize(34);
+		hhea.U16(MetricCount);
+
+		Writer hmtx{};
+		for (const std::uint32_t advance : { 500, 250, 700, 900, 600 })
+		{
+			hmtx.U16(advance);
+			hmtx.U16(0);
+		}
+
+		Writer location{};
+		for (const std::uint32_t offset : loca)
+		{
+			location.U16(offset / 2);
+		}
+
+		// ' ' to the glyph 1 and 'A' to 'D' to the glyphs 2 to 5
+		struct Segment
+		{
+			std::uint32_t start, end, glyph;
+		};
+		constexpr Segment segments[] = { { 0x20, 0x20, Space }, { 0x41, 0x44, Square }, { 0xFFFF, 0xFFFF, 0 } };
+
+		Writer cmap{};
+		cmap.U16(0);
+		cmap.U16(1);
+		cmap.U16(3);
+		cmap.U16(1);
+		cmap.U32(12);
+		cmap.U16(4);
+		cmap.U16(16 + 8 * std::size(segments));
+		cmap.U16(0);
+		cmap.U16(2 * std::size(segments));
+		cmap.U16(0);
+		cmap.U16(0);
+		cmap.U16(0);
+		for (const Segment& segment : segments)
+		{
+			cmap.U16(segment.end);
+		}
+		cmap.U16(0);
+		for (const Segment& segment : segments)
+		{
+			cmap.U16(segment.start);
+		}
+		for (const Segment& segment : segments)
+		{
+			cmap.U16(0xFFFF == segment.start ? 1 : (segment.glyph - segment.start) & 0xFFFF);
+		}
+		for (std::size_t i = 0; i < std::size(segments); ++i)
+		{
+			cmap.U16(0);
+		}
+
+		Writer kern{};
+		kern.U16(0);
+		kern.U16(1);
+		kern.U16(0);
+		kern.U16(14 + 6);
+		kern.U16(0x0001);
+		kern.U16(1);
+		kern.U16(0);
+		kern.U16(0);
+		kern.U16(0);
+		kern.U16(Square);
+		kern.U16(Ring);
+		kern.U16(static_cast<std::uint16_t>(-100));
+
+		struct Table
+		{
+			const char(&tag)[5];
+			const Writer& data;
+		};
+		const Table tables[] =
+		{
+			{ "cmap", cmap }, { "glyf", glyf }, { "head", head }, { "hhea", hhea },
+			{ "hmtx", hmtx }, { "kern", kern }, { "loca", location }, { "maxp", maxp },
+		};
+
+		Writer font{};
+		font.U32(0x00010000);
+		font.U16(std::size(tables));
+		font.U16(0);
+		font.U16(0);
+		font.U16(0);
+
+		std::uint32_t offset = static_cast<std::uint32_t>(12 + 16 * std::size(tables));
+		for (const Table& table : tables)
+		{
+			font.Tag(table.tag);
+			font.U32(0);
+			font.U32(offset);
+			font.U32(static_cast<std::uint32_t>(table.data.bytes.size()));
+			offset += static_cast<std::uint32_t>((table.data.bytes.size() + 3) / 4 * 4);
+		}
+
+		for (const Table& table : tables)
+		{
+			font.bytes.insert(font.bytes.end(), table.data.bytes.begin(), table.data.bytes.end());
+			font.Align(4);
+		}
+
+		return std::move(font.bytes);
+	}
+
+	[[nodiscard]]
+	gl::font::Outline
+	MakeSquare(float x, float y, float size, bool is_reversed = false)
+	{
+		gl::font::Outline result{};
+		result.points = { { x, y }, { x, y + size }, { x + size, y + size }, { x + size, y } };
+		if (is_reversed)
+		{
+			std::ranges::reverse(result.points);
+		}
+
+		result.contourEnds = { 4 };
+
+		return result;
+	}
+
+	void
+	AppendContour(gl::font::Outline& outline, const gl::font::Outline& contour)
+	{
+		outline.points.insert(outline.points.end(), contour.points.begin(), contour.points.end());
+		outline.contourEnds.push_back(static_cast<std::uint32_t>(outline.points.size()));
+	}
+
+	// The value at a point of the outline, in pixels with the y axis going up
+	[[nodiscard]]
+	std::uint8_t
+	Sample(const gl::font::Bitmap& bitmap, float x, float y)
+	{
+		const std::int32_t column = static_cast<std::int32_t>(x - static_cast<float>(bitmap.left));
+		const std::int32_t row = static_cast<std::int32_t>(static_cast<float>(bitmap.top) - y);
+
+		EXPECT_LE(0, column);
+		EXPECT_LE(0, row);
+		EXPECT_GT(static_cast<std::int32_t>(bitmap.width), column);
+		EXPECT_GT(static_cast<std::int32_t>(bitmap.height), row);
+
+		return bitmap.pixels[static_cast<std::size_t>(row) * bitmap.width + static_cast<std::size_t>(column)];
+	}
+
+	[[nodiscard]]
+	bool
+	Contains(const gl::font::Rect& outer, const gl::font::Rect& inner)
+	{
+		return outer.x <= inner.x && outer.y <= inner.y
+			&& inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+	}
+}
+
+TEST(DecodeUtf8, DecodesEveryLength)
+{
+	std::u32string codepoints{};
+	gl::font::DecodeUtf8("a\xC3\xA9\xE2\x9C\x93\xF0\x9F\x98\x80", codepoints);
+
+	EXPECT_EQ(U"aé✓\U0001F600", codepoints);
+}
+
+TEST(DecodeUtf8, ReplacesInvalidSequences)
+{
+	std::u32string codepoints{};
+
+	// Overlong
+	gl::font::DecodeUtf8("\xC0\xAF", codepoints);
+	EXPECT_EQ(U"�", codepoints);
+
+	// Surrogate
+	gl::font::DecodeUtf8("\xED\xA0\x80", codepoints);
+	EXPECT_EQ(U"�", codepoints);
+
+	// Beyond the code space
+	gl::font::DecodeUtf8("\xF4\x90\x80\x80", codepoints);
+	EXPECT_EQ(U"�", codepoints);
+
+	// A continuation without a lead, and a truncated sequence which does not swallow what follows
+	gl::font::DecodeUtf8("\x80x\xE2\x9Cy\xFF", codepoints);
+	EXPECT_EQ(U"�x�y�", codepoints);
+}
+
+TEST(FontFile, ReadsTheTables)
+{
+	const gl::font::FontFile font{ MakeFont() };
+	ASSERT_TRUE(font.IsValid());
+
+	const gl::font::Metrics& metrics = font.GetMetrics();
+	EXPECT_EQ(UnitsPerEm, metrics.unitsPerEm);
+	EXPECT_EQ(GlyphCount, metrics.glyphCount);
+	EXPECT_FLOAT_EQ(800, metrics.ascender);
+	EXPECT_FLOAT_EQ(-200, metrics.descender);
+
+	EXPECT_EQ(Space, font.GetGlyphIndex(U' '));
+	EXPECT_EQ(Square, font.GetGlyphIndex(U'A'));
+	EXPECT_EQ(Round, font.GetGlyphIndex(U'D'));
+	EXPECT_EQ(0U, font.GetGlyphIndex(U'E'));
+	EXPECT_EQ(0U, font.GetGlyphIndex(U'\U0001F600'));
+
+	EXPECT_FLOAT_EQ(700, font.GetAdvance(Square));
+	// The glyphs after the last metric share it
+	EXPECT_FLOAT_EQ(600, font.GetAdvance(Round));
+
+	EXPECT_FLOAT_EQ(-100, font.GetKerning(Square, Ring));
+	EXPECT_FLOAT_EQ(0, font.GetKerning(Ring, Square));
+}
+
+TEST(FontFile, RejectsBrokenFonts)
+{
+	std::vector<std::uint8_t> bytes = MakeFont();
+	bytes.resize(bytes.size() / 2);
+
+	const gl::font::FontFile truncated{ std::move(bytes) };
+	EXPECT_FALSE(truncated.IsValid());
+
+	const gl::font::FontFile garbage{ std::vector<std::uint8_t>(256, 0xAB) };
+	EXPECT_FALSE(garbage.IsValid());
+	EXPECT_EQ(0U, garbage.GetGlyphIndex(U'A'));
+
+	gl::font::Outline outline{};
+	EXPECT_FALSE(garbage.GetOutline(Square, outline, 1));
+
+	EXPECT_FALSE(gl::font::FontFile::Open(GLIB_TEST_DATA "/missing.ttf").has_value());
+}
+
+TEST(FontFile, ReadsSimpleAndCompositeOutlines)
+{
+	const gl::font::FontFile font{ MakeFont() };
+	gl::font::Outline outline{};
+
+	EXPECT_FALSE(font.GetOutline(Space, outline, 1));
+	EXPECT_FALSE(font.GetOutline(GlyphCount, outline, 1));
+
+	ASSERT_TRUE(font.GetOutline(Square, outline, 1));
+	ASSERT_EQ(1U, outline.contourEnds.size());
+	ASSERT_EQ(4U, outline.points.size());
+	EXPECT_FLOAT_EQ(100, outline.points[0].x);
+	EXPECT_FLOAT_EQ(700, outline.points[1].y);
+	EXPECT_FLOAT_EQ(600, outline.points[2].x);
+
+	ASSERT_TRUE(font.GetOutline(Ring, outline, 1));
+	EXPECT_EQ((std::vector<std::uint32_t>{ 4, 8 }), outline.contourEnds);
+
+	// The square scaled by a half then moved
+	ASSERT_TRUE(font.GetOutline(HalfSquare, outline, 1));
+	ASSERT_EQ(4U, outline.points.size());
+	EXPECT_FLOAT_EQ(550, outline.points[0].x);
+	EXPECT_FLOAT_EQ(0, outline.points[0].y);
+	EXPECT_FLOAT_EQ(800, outline.points[2].x);
+	EXPECT_FLOAT_EQ(350, outline.points[2].y);
+}
+
+TEST(FontFile, FlattensCurvesWithinTheTolerance)
+{
+	const gl::font::FontFile font{ MakeFont() };
+	gl::font::Outline coarse{}, fine{};
+
+	ASSERT_TRUE(font.GetOutline(Round, coarse, 50));
+	ASSERT_TRUE(font.GetOutline(Round, fine, 1));
+	EXPECT_LT(4U, coarse.points.size());
+	EXPECT_LT(coarse.points.size(), fine.points.size());
+
+	// The controls are the corners of a diamond, the curves stay inside it and only touch it between two controls
+	float nearest = 500;
+	for (const gl::font::Point& point : fine.points)
+	{
+		const float distance = std::abs(point.x - 500) + std::abs(point.y - 500);
+		EXPECT_GE(500 + 1e-2f, distance);
+		nearest = std::min(nearest, distance);
+	}
+
+	EXPECT_GT(400, nearest);
+}
+
+TEST(RasterizeSdf, EdgesAreHalfWay)
+{
+	gl::font::Bitmap bitmap{};
+	gl::font::RasterizeSdf(MakeSquare(0, 0, 10), 1, 4, bitmap);
+
+	// The spread on every side
+	EXPECT_EQ(18U, bitmap.width);
+	EXPECT_EQ(18U, bitmap.height);
+	EXPECT_EQ(-4, bitmap.left);
+	EXPECT_EQ(14, bitmap.top);
+	ASSERT_EQ(18U * 18U, bitmap.pixels.size());
+
+	EXPECT_EQ(255, Sample(bitmap, 5, 5));
+	EXPECT_EQ(0, Sample(bitmap, -3.5f, 13.5f));
+
+	// Half a pixel on either side of the left edge
+	const std::uint8_t inside = Sample(bitmap, 0.5f, 5);
+	const std::uint8_t outside = Sample(bitmap, -0.5f, 5);
+	EXPECT_LT(128, inside);
+	EXPECT_GT(128, outside);
+	EXPECT_EQ(255, inside + outside);
+
+	// Rising across the edge up to the spread, the same across the other one
+	for (float x = -3.5f; x < 4; ++x)
+	{
+		EXPECT_LT(Sample(bitmap, x, 5.5f), Sample(bitmap, x + 1, 5.5f)) << x;
+		EXPECT_EQ(Sample(bitmap, x, 5.5f), Sample(bitmap, 10 - x, 5.5f)) << x;
+	}
+}
+
+TEST(RasterizeSdf, ScalesTheOutline)
+{
+	gl::font::Bitmap bitmap{};
+	gl::font::RasterizeSdf(MakeSquare(100, 0, 500), 0.02f, 2, bitmap);
+
+	EXPECT_EQ(14U, bitmap.width);
+	EXPECT_EQ(0, bitmap.left);
+	EXPECT_EQ(12, bitmap.top);
+	EXPECT_LT(128, Sample(bitmap, 7, 5));
+}
+
+TEST(RasterizeSdf, InsideFollowsTheNonZeroWinding)
+{
+	gl::font::Bitmap clockwise{}, counterclockwise{};
+	gl::font::RasterizeSdf(MakeSquare(0, 0, 10), 1, 4, clockwise);
+	gl::font::RasterizeSdf(MakeSquare(0, 0, 10, true), 1, 4, counterclockwise);
+	EXPECT_EQ(clockwise.pixels, counterclockwise.pixels);
+
+	// A contour wound the other way is a hole
+	gl::font::Outline ring = MakeSquare(0, 0, 20);
+	AppendContour(ring, MakeSquare(5, 5, 10, true));
+
+	gl::font::Bitmap bitmap{};
+	gl::font::RasterizeSdf(ring, 1, 4, bitmap);
+	EXPECT_EQ(0, Sample(bitmap, 10, 10));
+	EXPECT_LT(128, Sample(bitmap, 2.5f, 10));
+	EXPECT_LT(128, Sample(bitmap, 17.5f, 10));
+
+	// The same way, overlapping, is not
+	gl::font::Outline overlap = MakeSquare(0, 0, 20);
+	AppendContour(overlap, MakeSquare(5, 5, 10));
+
+	gl::font::RasterizeSdf(overlap, 1, 4, bitmap);
+	EXPECT_LT(128, Sample(bitmap, 10, 10));
+}
+
+TEST(RasterizeSdf, EmptyOutlinesGiveEmptyBitmaps)
+{
+	gl::font::Bitmap bitmap{};
+	gl::font::RasterizeSdf(MakeSquare(0, 0, 10), 1, 4, bitmap);
+	gl::font::RasterizeSdf(gl::font::Outline{}, 1, 4, bitmap);
+
+	EXPECT_EQ(0U, bitmap.width);
+	EXPECT_EQ(0U, bitmap.height);
+	EXPECT_TRUE(bitmap.pixels.empty());
+}
+
+TEST(ShelfPacker, PacksWithoutOverlapsUntilFull)
+{
+	gl::font::ShelfPacker packer{ 256, 256, 1 };
+	std::mt19937 random{ 7 };
+	std::uniform_int_distribution<std::uint32_t> size{ 4, 40 };
+
+	const gl::font::Rect bounds{ 0, 0, 256, 256 };
+	std::vector<gl::font::Rect> rects{};
+	std::uint64_t area = 0;
+
+	while (true)
+	{
+		const std::optional<gl::font::Rect> rect = packer.Pack(size(random), size(random));
+		if (not rect)
+		{
+			break;
+		}
+
+		EXPECT_TRUE(Contains(bounds, *rect));
+		area += static_cast<std::uint64_t>(rect->width) * rect->height;
+		rects.push_back(*rect);
+	}
+
+	ASSERT_LT(20U, rects.size());
+	EXPECT_EQ(area, packer.GetUsedArea());
+
+	// With the padding between them
+	for (std::size_t i = 0; i < rects.size(); ++i)
+	{
+		for (std::size_t j = i + 1; j < rects.size(); ++j)
+		{
+			const gl::font::Rect& a = rects[i];
+			const gl::font::Rect& b = rects[j];
+			const bool is_apart = a.x + a.width + 1 <= b.x || b.x + b.width + 1 <= a.x
+				|| a.y + a.height + 1 <= b.y || b.y + b.height + 1 <= a.y;
+
+			EXPECT_TRUE(is_apart) << i << " and " << j;
+		}
+	}
+
+	packer.Clear();
+	EXPECT_EQ(0U, packer.GetUsedArea());
+
+	const std::optional<gl::font::Rect> first = packer.Pack(10, 10);
+	ASSERT_TRUE(first.has_value());
+	EXPECT_EQ(0U, first->x);
+	EXPECT_EQ(0U, first->y);
+}
+
+TEST(ShelfPacker, RejectsWhatIsLargerThanTheArea)
+{
+	gl::font::ShelfPacker packer{ 64, 64, 1 };
+
+	EXPECT_FALSE(packer.Pack(64, 8).has_value());
+	EXPECT_FALSE(packer.Pack(8, 64).has_value());
+	EXPECT_TRUE(packer.Pack(63, 63).has_value());
+	EXPECT_FALSE(packer.Pack(1, 1).has_value());
+}
+
+TEST(FontAtlas, ShapesWithTheAdvancesAndTheKerning)
+{
+	// A tenth of a pixel per font unit
+	gl::FontAtlas atlas{ gl::font::FontFile{ MakeFont() }, 100, 512 };
+
+	const gl::font::ShapedRun& run = atlas.Shape("AB A\n\tC");
+	ASSERT_EQ(5U, run.glyphs.size());
+
+	EXPECT_FLOAT_EQ(100, atlas.GetLineHeight());
+	EXPECT_FLOAT_EQ(80, atlas.GetAscender());
+
+	EXPECT_FLOAT_EQ(0, run.glyphs[0].x);
+	EXPECT_FLOAT_EQ(80, run.glyphs[0].y);
+	EXPECT_FLOAT_EQ(70 - 10, run.glyphs[1].x);
+	EXPECT_FLOAT_EQ(60 + 90, run.glyphs[2].x);
+	EXPECT_FLOAT_EQ(150 + 25, run.glyphs[3].x);
+	// A tabulation is four spaces
+	EXPECT_FLOAT_EQ(100, run.glyphs[4].x);
+	EXPECT_FLOAT_EQ(180, run.glyphs[4].y);
+
+	EXPECT_FLOAT_EQ(175 + 70, run.width);
+	EXPECT_FLOAT_EQ(200, run.height);
+
+	// The two squares share their slot
+	EXPECT_EQ(run.glyphs[0].slot, run.glyphs[3].slot);
+	EXPECT_EQ(Square, atlas.GetGlyph(run.glyphs[0].slot).index);
+	EXPECT_EQ(HalfSquare, atlas.GetGlyph(run.glyphs[4].slot).index);
+
+	// The space is laid out, without an area
+	EXPECT_EQ(Space, atlas.GetGlyph(run.glyphs[2].slot).index);
+	EXPECT_EQ(0U, atlas.GetGlyph(run.glyphs[2].slot).rect.width);
+	EXPECT_EQ(4U, atlas.GetStatistics().glyphs);
+}
+
+TEST(FontAtlas, GlyphsAreTheirDistanceFields)
+{
+	const gl::font::FontFile font{ MakeFont() };
+	gl::FontAtlas atlas{ gl::font::FontFile{ MakeFont() }, 40, 256, 3 };
+
+	const gl::font::ShapedRun& run = atlas.Shape("BA");
+	ASSERT_EQ(2U, run.glyphs.size());
+
+	const gl::font::Glyph& glyph = atlas.GetGlyph(run.glyphs[0].slot);
+
+	gl::font::Outline outline{};
+	ASSERT_TRUE(font.GetOutline(Ring, outline, 1));
+	gl::font::Bitmap bitmap{};
+	gl::font::RasterizeSdf(outline, 40.0f / UnitsPerEm, 3, bitmap);
+
+	ASSERT_EQ(bitmap.width, glyph.rect.width);
+	ASSERT_EQ(bitmap.height, glyph.rect.height);
+	EXPECT_EQ(bitmap.left, glyph.left);
+	EXPECT_EQ(bitmap.top, glyph.top);
+	EXPECT_FLOAT_EQ(36, glyph.advance);
+
+	const std::span<const std::uint8_t> pixels = atlas.GetPixels();
+	ASSERT_EQ(256U * 256U, pixels.size());
+
+	for (std::uint32_t row = 0; row < bitmap.height; ++row)
+	{
+		for (std::uint32_t column = 0; column < bitmap.width; ++column)
+		{
+			ASSERT_EQ(bitmap.pixels[row * bitmap.width + column], pixels[(glyph.rect.y + row) * 256 + glyph.rect.x + column]) << row << ", " << column;
+		}
+	}
+}
+
+TEST(FontAtlas, DirtyRectCoversTheNewGlyphs)
+{
+	gl::FontAtlas atlas{ gl::font::FontFile{ MakeFont() }, 40, 256 };
+
+	const gl::font::ShapedRun& first = atlas.Shape("AB");
+	const std::optional<gl::font::Rect> dirty = atlas.TakeDirtyRect();
+	ASSERT_TRUE(dirty.has_value());
+	for (const gl::font::PositionedGlyph& glyph : first.glyphs)
+	{
+		EXPECT_TRUE(Contains(*dirty, atlas.GetGlyph(glyph.slot).rect));
+	}
+
+	// Nothing new
+	EXPECT_FALSE(atlas.TakeDirtyRect().has_value());
+	atlas.Shape("BA");
+	EXPECT_FALSE(atlas.TakeDirtyRect().has_value());
+
+	const gl::font::ShapedRun& second = atlas.Shape("D");
+	const std::optional<gl::font::Rect> added = atlas.TakeDirtyRect();
+	ASSERT_TRUE(added.has_value());
+	EXPECT_TRUE(Contains(*added, atlas.GetGlyph(second.glyphs[0].slot).rect));
+	EXPECT_FALSE(Contains(*added, atlas.GetGlyph(first.glyphs[0].slot).rect));
+
+	// Everything after a clear
+	atlas.Clear();
+	const std::optional<gl::font::Rect> cleared = atlas.TakeDirtyRect();
+	ASSERT_TRUE(cleared.has_value());
+	EXPECT_EQ(256U, cleared->width);
+	EXPECT_EQ(256U, cleared->height);
+}
+
+TEST(FontAtlas, RunsAreCachedUntilUnused)
+{
+	gl::FontAtlas atlas{ gl::font::FontFile{ MakeFont() }, 40, 256 };
+
+	const gl::font::ShapedRun& run = atlas.Shape("ABC");
+	EXPECT_EQ(&run, &atlas.Shape("ABC"));
+	EXPECT_EQ(1U, atlas.GetStatistics().runHits);
+	EXPECT_EQ(1U, atlas.GetStatistics().runMisses);
+	EXPECT_EQ(3U, atlas.GetStatistics().rasterizedGlyphs);
+
+	// Kept while it is used
+	for (std::uint32_t frame = 0; frame < 2 * gl::font::DefaultRunLifetime; ++frame)
+	{
+		atlas.BeginFrame();
+		atlas.Shape("ABC");
+	}
+	EXPECT_EQ(0U, atlas.GetStatistics().evictedRuns);
+
+	for (std::uint32_t frame = 0; frame <= gl::font::DefaultRunLifetime; ++frame)
+	{
+		atlas.BeginFrame();
+	}
+	EXPECT_EQ(1U, atlas.GetStatistics().evictedRuns);
+
+	// Shaped again, from the glyphs already there
+	atlas.Shape("ABC");
+	EXPECT_EQ(2U, atlas.GetStatistics().runMisses);
+	EXPECT_EQ(3U, atlas.GetStatistics().rasterizedGlyphs);
+}
+
+TEST(FontAtlas, StartsOverWhenFull)
+{
+	// Room for the square or the ring, not both
+	gl::FontAtlas atlas{ gl::font::FontFile{ MakeFont() }, 100, 128 };
+
+	const gl::font::ShapedRun& square = atlas.Shape("A");
+	EXPECT_EQ(0U, square.generation);
+	EXPECT_NE(0U, atlas.GetGlyph(square.glyphs[0].slot).rect.width);
+
+	const gl::font::ShapedRun& ring = atlas.Shape("B");
+	EXPECT_EQ(1U, atlas.GetGeneration());
+	EXPECT_EQ(1U, atlas.GetStatistics().resets);
+	EXPECT_EQ(1U, ring.generation);
+	EXPECT_EQ(1U, atlas.GetStatistics().glyphs);
+	EXPECT_EQ(Ring, atlas.GetGlyph(ring.glyphs[0].slot).index);
+	EXPECT_NE(0U, atlas.GetGlyph(ring.glyphs[0].slot).rect.width);
+
+	// A text too large for the atlas is laid out, with the glyphs which did not fit left out of it
+	const gl::font::ShapedRun& both = atlas.Shape("AB");
+	ASSERT_EQ(2U, both.glyphs.size());
+	EXPECT_EQ(2U, atlas.GetStatistics().resets);
+
+	const gl::font::Rect& first = atlas.GetGlyph(both.glyphs[0].slot).rect;
+	const gl::font::Rect& second = atlas.GetGlyph(both.glyphs[1].slot).rect;
+	EXPECT_TRUE((0 == first.width) != (0 == second.width));
+}
+
+TEST(FontAtlas, GivesTheSamePixelsOnAnyThreadCount)
+{
+	gl::FontAtlas single{ gl::font::FontFile{ MakeFont() }, 48, 256, 4, 1 };
+	gl::FontAtlas parallel{ gl::font::FontFile{ MakeFont() }, 48, 256, 4, 4 };
+
+	EXPECT_EQ(5U, single.Prepare(U" ABCD"));
+	EXPECT_EQ(5U, parallel.Prepare(U" ABCD"));
+	EXPECT_EQ(0U, parallel.Prepare(U"DCBA"));
+
+	EXPECT_TRUE(std::ranges::equal(single.GetPixels(), parallel.GetPixels()));
+	EXPECT_EQ(single.GetStatistics().usedArea, parallel.GetStatistics().usedArea);
+}
+
+TEST(TextBatch, QuadsFollowTheRunAndTheAtlas)
+{
+	gl::FontAtlas atlas{ gl::font::FontFile{ MakeFont() }, 100, 512 };
+	const gl::font::ShapedRun& run = atlas.Shape("A A");
+	ASSERT_EQ(3U, run.glyphs.size());
+
+	// Appended after what is there
+	std::vector<gl::sprite::Vertex> vertices(4);
+	// Half the glyph size
+	EXPECT_EQ(2U, gl::text::GenerateQuads(atlas, run, 10, 20, 50, 0xFF00FF00U, vertices));
+	ASSERT_EQ(12U, vertices.size());
+
+	// The space has no quad
+	for (const std::size_t i : { std::size_t{ 0 }, std::size_t{ 2 } })
+	{
+		const gl::font::PositionedGlyph& positioned = run.glyphs[i];
+		const gl::font::Glyph& glyph = atlas.GetGlyph(positioned.slot);
+		const gl::sprite::Vertex* const quad = vertices.data() + 4 + i * 2;
+
+		const float left = 10 + (positioned.x + static_cast<float>(glyph.left)) * 0.5f;
+		const float top = 20 + (positioned.y - static_cast<float>(glyph.top)) * 0.5f;
+
+		EXPECT_FLOAT_EQ(left, quad[0].x);
+		EXPECT_FLOAT_EQ(top, quad[0].y);
+		EXPECT_FLOAT_EQ(left + static_cast<float>(glyph.rect.width) * 0.5f, quad[2].x);
+		EXPECT_FLOAT_EQ(top + static_cast<float>(glyph.rect.height) * 0.5f, quad[2].y);
+		EXPECT_EQ(quad[0].y, quad[1].y);
+		EXPECT_EQ(quad[2].x, quad[1].x);
+		EXPECT_EQ(quad[0].x, quad[3].x);
+		EXPECT_EQ(quad[2].y, quad[3].y);
+
+		EXPECT_FLOAT_EQ(static_cast<float>(glyph.rect.x) / 512, quad[0].u);
+		EXPECT_FLOAT_EQ(static_cast<float>(glyph.rect.y) / 512, quad[0].v);
+		EXPECT_FLOAT_EQ(static_cast<float>(glyph.rect.x + glyph.rect.width) / 512, quad[2].u);
+		EXPECT_FLOAT_EQ(static_cast<float>(glyph.rect.y + glyph.rect.height) / 512, quad[2].v);
+
+		for (std::size_t corner = 0; corner < 4; ++corner)
+		{
+			EXPECT_EQ(0xFF00FF00U, quad[corner].colour);
+		}
+	}
+
+	// The second square is further right by the advances
+	EXPECT_FLOAT_EQ((run.glyphs[2].x - run.glyphs[0].x) * 0.5f, vertices[8].x - vertices[4].x);
+}
+
+TEST(TextBatch, MeasuresAtTheDrawnSize)
+{
+	gl::FontAtlas atlas{ gl::font::FontFile{ MakeFont() }, 100, 512 };
+	gl::TextBatch batch{ atlas };
+
+	// Without a context
+	const gl::text::Extent extent = batch.Measure("AB A\n\tC", 50);
+	EXPECT_FLOAT_EQ(245 / 2.0f, extent.width);
+	EXPECT_FLOAT_EQ(200 / 2.0f, extent.height);
+	EXPECT_FALSE(batch.IsCreated());
+}
+
+TEST(TextBatch, DrawsEveryTextInOneCall)
+{
+	glstub::Reset();
+
+	gl::FontAtlas atlas{ gl::font::FontFile{ MakeFont() }, 40, 256 };
+	gl::TextBatch batch{ atlas };
+	ASSERT_TRUE(batch.Create());
+
+	// The whole atlas once
+	ASSERT_EQ(1U, glstub::CountCalls("glTexSubImage2D"));
+	EXPECT_EQ(256, glstub::FindCalls("glTexSubImage2D")[0].args[4]);
+
+	const gl::Colour red{ std::uint8_t{ 255 }, std::uint8_t{ 0 }, std::uint8_t{ 0 }, std::uint8_t{ 255 } };
+
+	batch.Begin(gl::sprite::MakeProjection(640, 480));
+	batch.Draw("AB", 10, 10, 20, red);
+	batch.Draw("", 0, 0, 20);
+	batch.Draw("C A", 0, 50, 30);
+	batch.End();
+
+	const gl::text::Statistics& statistics = batch.GetStatistics();
+	EXPECT_EQ(2U, statistics.texts);
+	EXPECT_EQ(4U, statistics.glyphs);
+	EXPECT_EQ(1U, statistics.drawCalls);
+	EXPECT_EQ(0U, statistics.rebuilds);
+	EXPECT_NE(0U, statistics.uploadedBytes);
+	EXPECT_LT(statistics.uploadedBytes, 256U * 256U);
+
+	const std::vector<glstub::Call> draws = glstub::FindCalls("glDrawElements");
+	ASSERT_EQ(1U, draws.size());
+	EXPECT_EQ((std::vector<std::int64_t>{ GL_TRIANGLES, 4 * 6, GL_UNSIGNED_INT, 0 }), draws[0].args);
+	ASSERT_EQ(2U, glstub::CountCalls("glTexSubImage2D"));
+
+	// The vertex buffer holds the quads of both texts, in the order they were drawn
+	std::vector<gl::sprite::Vertex> expected{};
+	gl::text::GenerateQuads(atlas, atlas.Shape("AB"), 10, 10, 20, gl::PackColour(red), expected);
+	gl::text::GenerateQuads(atlas, atlas.Shape("C A"), 0, 50, 30, gl::PackColour(gl::win32::colors::White), expected);
+	ASSERT_EQ(16U, expected.size());
+
+	GLuint vertex_buffer = 0;
+	for (const glstub::Call& bind : glstub::FindCalls("glBindBuffer"))
+	{
+		if (GL_ARRAY_BUFFER == bind.args[0] && 0 != bind.args[1])
+		{
+			vertex_buffer = static_cast<GLuint>(bind.args[1]);
+		}
+	}
+
+	const std::vector<std::uint8_t>& uploaded = glstub::GetState().buffers[vertex_buffer];
+	ASSERT_LE(expected.size() * sizeof(gl::sprite::Vertex), uploaded.size());
+	EXPECT_EQ(0, std::memcmp(expected.data(), uploaded.data(), expected.size() * sizeof(gl::sprite::Vertex)));
+
+	// Left unbound
+	EXPECT_EQ(0, glstub::GetState().integers[GL_CURRENT_PROGRAM][0]);
+	EXPECT_EQ(0, glstub::GetState().integers[GL_VERTEX_ARRAY_BINDING][0]);
+
+	// The glyphs are there already, nothing is uploaded
+	batch.Begin(gl::sprite::MakeProjection(640, 480));
+	batch.Draw("AB", 10, 10, 20, red);
+	batch.Draw("C A", 0, 50, 30);
+	batch.End();
+
+	EXPECT_EQ(4U, batch.GetStatistics().glyphs);
+	EXPECT_EQ(0U, batch.GetStatistics().uploadedBytes);
+	EXPECT_EQ(2U, glstub::CountCalls("glTexSubImage2D"));
+	EXPECT_EQ(2U, glstub::CountCalls("glDrawElements"));
+}
+
+TEST(TextBatch, GeneratesAgainWhenTheAtlasStartsOver)
+{
+	glstub::Reset();
+
+	// Room for the square or the ring, the ring is there first
+	gl::FontAtlas atlas{ gl::font::FontFile{ MakeFont() }, 100, 128 };
+	atlas.Shape("B");
+
+	gl::TextBatch batch{ atlas };
+	ASSERT_TRUE(batch.Create());
+
+	batch.Begin(gl::sprite::MakeProjection(640, 480));
+	batch.Draw("A", 0, 0, 100);
+	batch.Draw("A", 0, 100, 100);
+	batch.End();
+
+	const gl::text::Statistics& statistics = batch.GetStatistics();
+	EXPECT_EQ(1U, statistics.rebuilds);
+	EXPECT_EQ(2U, statistics.glyphs);
+	EXPECT_EQ(1U, atlas.GetGeneration());
+	// Everything, as the atlas was cleared
+	EXPECT_EQ(128U * 128U, statistics.uploadedBytes);
+
+	// The quads point at the square where it is now
+	const gl::font::ShapedRun& run = atlas.Shape("A");
+	EXPECT_EQ(1U, run.generation);
+	const gl::font::Glyph& glyph = atlas.GetGlyph(run.glyphs[0].slot);
+	EXPECT_EQ(Square, glyph.index);
+	EXPECT_NE(0U, glyph.rect.width);
+
+	const std::vector<glstub::Call> draws = glstub::FindCalls("glDrawElements");
+	ASSERT_EQ(1U, draws.size());
+	EXPECT_EQ(2 * 6, draws[0].args[1]);
+}
+
+TEST(TextBatch, RecordsWithoutDrawingUntilCreated)
+{
+	glstub::Reset();
+
+	gl::FontAtlas atlas{ gl::font::FontFile{ MakeFont() }, 40, 256 };
+	gl::TextBatch batch{ atlas };
+
+	batch.Begin(gl::sprite::MakeProjection(640, 480));
+	batch.Draw("AB", 0, 0, 20);
+	batch.End();
+
+	EXPECT_FALSE(batch.IsCreated());
+	EXPECT_EQ(1U, batch.GetStatistics().texts);
+	EXPECT_EQ(0U, batch.GetStatistics().drawCalls);
+	EXPECT_EQ(0U, glstub::CountCalls("glDrawElements"));
+	EXPECT_EQ(0U, glstub::CountCalls("glTexSubImage2D"));
+}
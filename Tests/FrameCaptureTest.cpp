@@ -0,0 +1,305 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "fpng.h"
+#include "Glib.FrameCapture.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Runs of flat colour between noisy patches, like a rendered frame
+	[[nodiscard]]
+	std::vector<std::uint8_t> MakeImage(const std::size_t& width, const std::size_t& height, const std::size_t& channels)
+	{
+		std::mt19937 random{ 7 };
+		std::vector<std::uint8_t> result(width * height * channels);
+
+		for (std::size_t y = 0; y < height; ++y)
+		{
+			for (std::size_t x = 0; x < width; ++x)
+			{
+				const bool flat = 0 == (x / 16 + y / 9) % 3;
+
+				for (std::size_t c = 0; c < channels; ++c)
+				{
+					result[(y * width + x) * channels + c] = flat ? static_cast<std::uint8_t>(40 * c + y / 64) : static_cast<std::uint8_t>(random() % 256);
+				}
+			}
+		}
+
+		return result;
+	}
+
+	[[nodiscard]]
+	std::vector<std::uint8_t> Decode(const std::vector<std::uint8_t>& encoded, const std::size_t& channels, std::size_t& width, std::size_t& height)
+	{
+		std::vector<std::uint8_t> result{};
+		std::size_t decoded_channels = 0;
+
+		const int status = fpng::fpng_decode_memory(encoded.data(), static_cast<std::uint32_t>(encoded.size()), result, width, height, decoded_channels, static_cast<std::uint32_t>(channels));
+		EXPECT_EQ(fpng::FPNG_DECODE_SUCCESS, status);
+
+		return result;
+	}
+
+	class FrameCaptureTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			glstub::Reset();
+
+			directory = std::filesystem::temp_directory_path() / ::testing::UnitTest::GetInstance()->current_test_info()->name();
+			std::filesystem::remove_all(directory);
+			std::filesystem::create_directories(directory);
+		}
+
+		void TearDown() override
+		{
+			std::filesystem::remove_all(directory);
+		}
+
+		std::filesystem::path directory;
+	};
+}
+
+TEST(EncodePng, RoundTripsEveryThreadCount)
+{
+	for (const std::size_t channels : { 3U, 4U })
+	{
+		const std::vector<std::uint8_t> image = MakeImage(1280, 720, channels);
+
+		for (const std::uint32_t threads : { 0U, 1U, 2U, 3U, 8U })
+		{
+			std::vector<std::uint8_t> encoded{};
+			ASSERT_TRUE(gl::capture::EncodePng(image.data(), 1280, 720, channels, encoded, threads));
+
+			std::size_t width = 0, height = 0;
+			const std::vector<std::uint8_t> decoded = Decode(encoded, channels, width, height);
+
+			EXPECT_EQ(1280U, width);
+			EXPECT_EQ(720U, height);
+			EXPECT_EQ(image, decoded) << channels << " channels on " << threads << " threads";
+		}
+	}
+}
+
+TEST(EncodePng, RoundTripsSmallerThanAStripe)
+{
+	const std::vector<std::uint8_t> image = MakeImage(3, 2, 4);
+
+	std::vector<std::uint8_t> encoded{};
+	ASSERT_TRUE(gl::capture::EncodePng(image.data(), 3, 2, 4, encoded, 16));
+
+	std::size_t width = 0, height = 0;
+	EXPECT_EQ(image, Decode(encoded, 4, width, height));
+}
+
+TEST(EncodePng, ReportsThroughputAgainstSingleThreaded)
+{
+	const std::vector<std::uint8_t> image = MakeImage(1920, 1080, 3);
+
+	const gl::capture::Benchmark result = gl::capture::MeasureEncoding(image.data(), 1920, 1080, 3, 4);
+
+	EXPECT_LT(0.0, result.singleThreaded);
+	EXPECT_LT(0.0, result.parallel);
+	EXPECT_LE(1U, result.threads);
+
+	std::cout << "fpng 1920x1080 RGB: " << result.singleThreaded << " MB/s single threaded, "
+		<< result.parallel << " MB/s on " << result.threads << " threads\n";
+
+	RecordProperty("single_threaded_mbps", static_cast<int>(result.singleThreaded));
+	RecordProperty("parallel_mbps", static_cast<int>(result.parallel));
+}
+
+TEST(InstructionSets, ChecksumsMatchScalarOnAnyLengthAndAlignment)
+{
+	fpng::fpng_init();
+	const std::uint32_t best = fpng::fpng_cpu_best_isa();
+	const std::uint32_t previous = fpng::fpng_set_max_isa(fpng::FPNG_ISA_SCALAR);
+
+	std::mt19937 random{ 29 };
+	std::vector<std::uint8_t> bytes(8192);
+	for (std::uint8_t& byte : bytes)
+	{
+		byte = static_cast<std::uint8_t>(random());
+	}
+
+	// Short tails, the 256 bytes of the wide CRC-32 kernels and the blocks of the Adler-32 sums
+	std::uniform_int_distribution<std::size_t> offsets{ 0, 63 };
+	std::uniform_int_distribution<std::size_t> lengths{ 0, 6000 };
+
+	for (int i = 0; i < 300; ++i)
+	{
+		const std::size_t offset = offsets(random);
+		const std::size_t length = i < 64 ? static_cast<std::size_t>(i) : lengths(random);
+		const std::uint32_t crc = static_cast<std::uint32_t>(random());
+		const std::uint32_t adler = static_cast<std::uint32_t>(random() % 65521U) | (static_cast<std::uint32_t>(random() % 65521U) << 16);
+
+		fpng::fpng_set_max_isa(fpng::FPNG_ISA_SCALAR);
+		const std::uint32_t expected_crc = fpng::fpng_crc32(bytes.data() + offset, length, crc);
+		const std::uint32_t expected_adler = fpng::fpng_adler32(bytes.data() + offset, length, adler);
+
+		for (std::uint32_t isa = fpng::FPNG_ISA_SSE41; isa <= best; ++isa)
+		{
+			fpng::fpng_set_max_isa(isa);
+
+			EXPECT_EQ(expected_crc, fpng::fpng_crc32(bytes.data() + offset, length, crc)) << fpng::fpng_isa_name(isa) << ", " << length << " bytes at " << offset;
+			EXPECT_EQ(expected_adler, fpng::fpng_adler32(bytes.data() + offset, length, adler)) << fpng::fpng_isa_name(isa) << ", " << length << " bytes at " << offset;
+		}
+	}
+
+	fpng::fpng_set_max_isa(previous);
+}
+
+// The rows after the first are Up filtered, so the kernels are compared through the bytes they produce
+TEST(InstructionSets, EncodingMatchesScalarOnAnyRowLength)
+{
+	fpng::fpng_init();
+	const std::uint32_t best = fpng::fpng_cpu_best_isa();
+	const std::uint32_t previous = fpng::fpng_set_max_isa(fpng::FPNG_ISA_SCALAR);
+
+	for (const std::size_t channels : { 3U, 4U })
+	{
+		for (const std::size_t width : { 1U, 5U, 11U, 21U, 43U, 64U, 85U, 257U })
+		{
+			const std::size_t height = 37;
+			const std::vector<std::uint8_t> image = MakeImage(width, height, channels);
+
+			fpng::fpng_set_max_isa(fpng::FPNG_ISA_SCALAR);
+			std::vector<std::uint8_t> expected{};
+			ASSERT_TRUE(fpng::fpng_encode_image_to_memory(image.data(), width, height, channels, expected));
+
+			for (std::uint32_t isa = fpng::FPNG_ISA_SSE41; isa <= best; ++isa)
+			{
+				fpng::fpng_set_max_isa(isa);
+
+				std::vector<std::uint8_t> encoded{};
+				ASSERT_TRUE(fpng::fpng_encode_image_to_memory(image.data(), width, height, channels, encoded));
+				EXPECT_EQ(expected, encoded) << fpng::fpng_isa_name(isa) << ", " << width << " pixels of " << channels << " channels";
+			}
+		}
+	}
+
+	fpng::fpng_set_max_isa(previous);
+}
+
+TEST(InstructionSets, TheCapBelongsToTheCallingThread)
+{
+	fpng::fpng_init();
+	const std::uint32_t best = fpng::fpng_cpu_best_isa();
+	const std::uint32_t previous = fpng::fpng_set_max_isa(fpng::FPNG_ISA_SCALAR);
+
+	EXPECT_EQ(static_cast<std::uint32_t>(fpng::FPNG_ISA_SCALAR), fpng::fpng_get_isa());
+
+	std::uint32_t other = fpng::FPNG_ISA_SCALAR;
+	std::thread{ [&other] { other = fpng::fpng_get_isa(); } }.join();
+	EXPECT_EQ(best, other);
+
+	// The workers of the parallel encoder follow their caller, so the stripes match the scalar encoding
+	const std::vector<std::uint8_t> image = MakeImage(333, 512, 4);
+	std::vector<std::uint8_t> scalar{};
+	ASSERT_TRUE(fpng::fpng_encode_image_to_memory_parallel(image.data(), 333, 512, 4, scalar, 4));
+
+	fpng::fpng_set_max_isa(previous);
+
+	std::vector<std::uint8_t> encoded{};
+	ASSERT_TRUE(fpng::fpng_encode_image_to_memory_parallel(image.data(), 333, 512, 4, encoded, 4));
+	EXPECT_EQ(scalar, encoded);
+}
+
+TEST_F(FrameCaptureTest, WritesFlippedFrames)
+{
+	gl::capture::Descriptor descriptor{};
+	descriptor.directory = directory;
+	descriptor.ringSize = 2;
+
+	gl::FrameCapture capture{ descriptor };
+	ASSERT_TRUE(capture.Start(gl::Rect{ 0, 0, 64, 32 }));
+
+	for (int i = 0; i < 3; ++i)
+	{
+		EXPECT_TRUE(capture.Capture());
+	}
+	capture.Stop();
+
+	EXPECT_EQ(3U, capture.GetStatistics().encodedFrames);
+	EXPECT_EQ(0U, capture.GetStatistics().droppedFrames);
+	EXPECT_TRUE(glstub::GetState().syncs.empty());
+
+	// The stub reads bytes depending on their offset only, rows come from the bottom
+	std::vector<std::uint8_t> expected(64 * 32 * 3);
+	for (std::size_t y = 0; y < 32; ++y)
+	{
+		for (std::size_t i = 0; i < 64 * 3; ++i)
+		{
+			const std::size_t offset = (31 - y) * 64 * 3 + i;
+			expected[y * 64 * 3 + i] = static_cast<std::uint8_t>(offset * 31 + (offset >> 8));
+		}
+	}
+
+	for (int frame = 0; frame < 3; ++frame)
+	{
+		const std::filesystem::path path = directory / ("frame_00000" + std::to_string(frame) + ".png");
+		ASSERT_TRUE(std::filesystem::exists(path)) << path;
+
+		std::vector<std::uint8_t> decoded{};
+		std::size_t width = 0, height = 0, channels = 0;
+		ASSERT_EQ(fpng::FPNG_DECODE_SUCCESS, fpng::fpng_decode_file(path.string().c_str(), decoded, width, height, channels, 3));
+		EXPECT_EQ(expected, decoded);
+	}
+}
+
+TEST_F(FrameCaptureTest, DeletesFencesOfFailedWaits)
+{
+	glstub::GetState().waitResult = GL_WAIT_FAILED;
+
+	gl::capture::Descriptor descriptor{};
+	descriptor.directory = directory;
+	descriptor.ringSize = 2;
+
+	gl::FrameCapture capture{ descriptor };
+	ASSERT_TRUE(capture.Start(gl::Rect{ 0, 0, 16, 16 }));
+
+	for (int i = 0; i < 5; ++i)
+	{
+		EXPECT_TRUE(capture.Capture());
+	}
+
+	// Three captures reused a slot whose fence failed
+	EXPECT_EQ(3U, capture.GetStatistics().droppedFrames);
+	EXPECT_EQ(2U, glstub::GetState().syncs.size());
+
+	capture.Stop();
+
+	EXPECT_EQ(5U, capture.GetStatistics().droppedFrames);
+	EXPECT_EQ(0U, capture.GetStatistics().encodedFrames);
+	EXPECT_TRUE(glstub::GetState().syncs.empty());
+	EXPECT_EQ(glstub::CountCalls("glFenceSync"), glstub::CountCalls("glDeleteSync"));
+}
+
+TEST_F(FrameCaptureTest, KeepsFencesStillInFlight)
+{
+	glstub::GetState().waitResult = GL_TIMEOUT_EXPIRED;
+
+	gl::capture::Descriptor descriptor{};
+	descriptor.directory = directory;
+
+	gl::FrameCapture capture{ descriptor };
+	ASSERT_TRUE(capture.Start(gl::Rect{ 0, 0, 16, 16 }));
+	EXPECT_TRUE(capture.Capture());
+
+	EXPECT_EQ(0U, capture.Poll());
+	EXPECT_EQ(1U, glstub::GetState().syncs.size());
+
+	glstub::GetState().waitResult = GL_ALREADY_SIGNALED;
+	EXPECT_EQ(1U, capture.Poll());
+	EXPECT_TRUE(glstub::GetState().syncs.empty());
+
+	capture.Stop();
+	EXPECT_EQ(1U, capture.GetStatistics().encodedFrames);
+}
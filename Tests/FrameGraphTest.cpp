@@ -0,0 +1,480 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "RecordingDevice.hpp"
+#include "Glib.hpp"
+#include "Glib.RenderTarget.hpp"
+#include "Glib.FrameGraph.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	using gl::graph::Usage;
+
+	constexpr gl::target::Description Full{ 1920, 1080, gl::target::Format::RGBA16F };
+	constexpr gl::target::Description Depth{ 1920, 1080, gl::target::Format::Depth24Stencil8 };
+
+	// A deferred frame with a debug view nobody looks at
+	struct DeferredFrame
+	{
+		gl::graph::ResourceId backbuffer, lights, depth, debug, hdr, bloom;
+		gl::graph::PassId prepass, view, culling, shading, blur, tonemap;
+		std::vector<std::string> ran{};
+		bool hasTargets = true;
+
+		void Declare(gl::FrameGraph& graph)
+		{
+			graph.Reset();
+			ran.clear();
+
+			backbuffer = graph.ImportTarget("Backbuffer", nullptr);
+			lights = graph.ImportBuffer("Lights");
+			depth = graph.CreateTarget("Depth", Depth);
+			debug = graph.CreateTarget("Debug", Full);
+			hdr = graph.CreateTarget("HDR", Full);
+			bloom = graph.CreateTarget("Bloom", Full);
+
+			prepass = AddPass(graph, "Prepass", { depth });
+			graph.Write(prepass, depth, Usage::Attachment);
+
+			view = AddPass(graph, "Debug", { debug });
+			graph.Read(view, depth, Usage::Sampled);
+			graph.Write(view, debug, Usage::Attachment);
+
+			culling = AddPass(graph, "LightCulling", { depth });
+			graph.Read(culling, depth, Usage::Sampled);
+			graph.Write(culling, lights, Usage::StorageBuffer);
+
+			shading = AddPass(graph, "Shading", { depth, hdr });
+			graph.Read(shading, depth, Usage::Attachment);
+			graph.Read(shading, lights, Usage::StorageBuffer);
+			graph.Write(shading, hdr, Usage::Attachment);
+
+			blur = AddPass(graph, "Bloom", { hdr, bloom });
+			graph.Read(blur, hdr, Usage::Sampled);
+			graph.Write(blur, bloom, Usage::Image);
+
+			tonemap = AddPass(graph, "Tonemap", { hdr, bloom });
+			graph.Read(tonemap, hdr, Usage::Sampled);
+			graph.Read(tonemap, bloom, Usage::Sampled);
+			graph.Write(tonemap, backbuffer, Usage::Attachment);
+		}
+
+		// Every pass checks the targets it uses are there while it runs
+		gl::graph::PassId AddPass(gl::FrameGraph& graph, const char* name, std::vector<gl::graph::ResourceId> targets)
+		{
+			return graph.AddPass(name, [this, &graph, name, targets = std::move(targets)]() noexcept {
+				ran.emplace_back(name);
+
+				for (const gl::graph::ResourceId target : targets)
+				{
+					hasTargets = hasTargets && nullptr != graph.GetTarget(target);
+				}
+			});
+		}
+	};
+
+	class FrameGraphTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			glstub::Reset();
+		}
+	};
+}
+
+TEST_F(FrameGraphTest, PassesNothingUsesAreCulled)
+{
+	gl::FrameGraph graph{};
+	DeferredFrame frame{};
+	frame.Declare(graph);
+	graph.Compile();
+
+	EXPECT_TRUE(graph.IsCulled(frame.view));
+	for (const gl::graph::PassId pass : { frame.prepass, frame.culling, frame.shading, frame.blur, frame.tonemap })
+	{
+		EXPECT_FALSE(graph.IsCulled(pass)) << graph.GetPassName(pass);
+	}
+
+	const gl::graph::Statistics& statistics = graph.GetStatistics();
+	EXPECT_EQ(6U, statistics.passes);
+	EXPECT_EQ(1U, statistics.culledPasses);
+	EXPECT_EQ(5U, graph.GetSchedule().size());
+	// The debug target is never allocated
+	EXPECT_EQ(3U, statistics.transientResources);
+	EXPECT_EQ(gl::graph::Invalid, graph.GetLifetime(frame.debug).first);
+
+	// Unless the pass asks to stay
+	frame.Declare(graph);
+	graph.SetSideEffect(frame.view);
+	graph.Compile();
+	EXPECT_FALSE(graph.IsCulled(frame.view));
+	EXPECT_EQ(6U, graph.GetSchedule().size());
+}
+
+TEST_F(FrameGraphTest, ExecuteRunsTheScheduleWithItsTargets)
+{
+	glstub::RecordingDevice device{};
+	gl::TransientTargets targets{ device };
+	gl::FrameGraph graph{};
+	DeferredFrame frame{};
+
+	frame.Declare(graph);
+	graph.Compile();
+
+	targets.BeginFrame();
+	graph.Execute(targets);
+	targets.EndFrame();
+
+	EXPECT_EQ((std::vector<std::string>{ "Prepass", "LightCulling", "Shading", "Bloom", "Tonemap" }), frame.ran);
+	EXPECT_TRUE(frame.hasTargets);
+
+	// The targets exist only while the graph executes
+	EXPECT_EQ(nullptr, graph.GetTarget(frame.hdr));
+	EXPECT_EQ(nullptr, graph.GetTarget(frame.backbuffer));
+
+	// Depth, then the hdr and the bloom which overlap
+	EXPECT_EQ(3U, graph.GetStatistics().physicalTargets);
+	EXPECT_EQ(3U, targets.GetStatistics().created);
+	EXPECT_TRUE(device.errors.empty()) << device.errors.front();
+
+	// The next frames find their targets in the pool
+	for (int i = 0; i < 3; ++i)
+	{
+		frame.Declare(graph);
+		graph.Compile();
+
+		targets.BeginFrame();
+		graph.Execute(targets);
+		targets.EndFrame();
+
+		EXPECT_EQ(0U, targets.GetStatistics().created);
+		EXPECT_EQ(5U, frame.ran.size());
+	}
+
+	EXPECT_EQ(3U, device.created.size());
+}
+
+TEST_F(FrameGraphTest, BarriersFollowTheIncoherentWritesOnly)
+{
+	glstub::RecordingDevice device{};
+	gl::TransientTargets targets{ device };
+	gl::FrameGraph graph{};
+	DeferredFrame frame{};
+
+	frame.Declare(graph);
+	graph.Compile();
+
+	std::vector<std::pair<std::string, std::uint32_t>> barriers{};
+	for (const gl::graph::ScheduledPass& scheduled : graph.GetSchedule())
+	{
+		if (gl::graph::NoBarrier != scheduled.barriers)
+		{
+			barriers.emplace_back(graph.GetPassName(scheduled.pass), scheduled.barriers);
+		}
+	}
+
+	// The light list is read as storage, the bloom image is sampled, and the attachments need nothing
+	const std::vector<std::pair<std::string, std::uint32_t>> expected{
+		{ "Shading", gl::graph::ShaderStorageBarrier },
+		{ "Tonemap", gl::graph::TextureFetchBarrier },
+	};
+	EXPECT_EQ(expected, barriers);
+	EXPECT_EQ(2U, graph.GetStatistics().barriers);
+
+	targets.BeginFrame();
+	graph.Execute(targets);
+	targets.EndFrame();
+
+	const std::vector<glstub::Call> calls = glstub::FindCalls("glMemoryBarrier");
+	ASSERT_EQ(2U, calls.size());
+	EXPECT_EQ(gl::graph::ShaderStorageBarrier, calls[0].args[0]);
+	EXPECT_EQ(gl::graph::TextureFetchBarrier, calls[1].args[0]);
+}
+
+TEST_F(FrameGraphTest, OneBarrierCoversTheEarlierWrites)
+{
+	gl::FrameGraph graph{};
+
+	const gl::graph::ResourceId output = graph.ImportTarget("Output", nullptr);
+	const gl::graph::ResourceId first = graph.CreateTarget("First", Full);
+	const gl::graph::ResourceId second = graph.CreateTarget("Second", Full);
+
+	const gl::graph::PassId a = graph.AddPass("A", {});
+	graph.Write(a, first, Usage::Image);
+	const gl::graph::PassId b = graph.AddPass("B", {});
+	graph.Write(b, second, Usage::Image);
+
+	// C waits for both writes, so its barrier is there before D reads
+	const gl::graph::PassId c = graph.AddPass("C", {});
+	graph.Read(c, first, Usage::Sampled);
+	graph.Read(c, second, Usage::Sampled);
+	graph.Write(c, output, Usage::Attachment);
+	const gl::graph::PassId d = graph.AddPass("D", {});
+	graph.Read(d, second, Usage::Sampled);
+	graph.Write(d, output, Usage::Attachment);
+
+	graph.Compile();
+
+	std::uint32_t count = 0;
+	for (const gl::graph::ScheduledPass& scheduled : graph.GetSchedule())
+	{
+		if (gl::graph::NoBarrier != scheduled.barriers)
+		{
+			EXPECT_EQ(gl::graph::TextureFetchBarrier, scheduled.barriers);
+			++count;
+		}
+	}
+
+	EXPECT_EQ(1U, count);
+}
+
+TEST_F(FrameGraphTest, PingPongChainsAliasTheirTargets)
+{
+	glstub::RecordingDevice device{};
+	gl::TransientTargets targets{ device };
+	gl::FrameGraph graph{};
+
+	const gl::graph::ResourceId output = graph.ImportTarget("Output", nullptr);
+
+	gl::graph::ResourceId previous = gl::graph::Invalid;
+	for (int i = 0; i < 6; ++i)
+	{
+		const gl::graph::ResourceId current = graph.CreateTarget("Blur", Full);
+		const gl::graph::PassId pass = graph.AddPass("Blur", {});
+
+		if (gl::graph::Invalid != previous)
+		{
+			graph.Read(pass, previous, Usage::Sampled);
+		}
+		graph.Write(pass, current, Usage::Attachment);
+
+		previous = current;
+	}
+
+	const gl::graph::PassId present = graph.AddPass("Present", {});
+	graph.Read(present, previous, Usage::Sampled);
+	graph.Write(present, output, Usage::Attachment);
+
+	graph.Compile();
+
+	// Each target lives from its writer to its reader
+	for (gl::graph::ResourceId resource = 1; resource <= 6; ++resource)
+	{
+		const gl::graph::Lifetime lifetime = graph.GetLifetime(resource);
+		EXPECT_EQ(resource - 1, lifetime.first);
+		EXPECT_EQ(resource, lifetime.last);
+	}
+
+	const gl::graph::Statistics& statistics = graph.GetStatistics();
+	EXPECT_EQ(6U, statistics.transientResources);
+	EXPECT_EQ(2U, statistics.physicalTargets);
+	EXPECT_EQ(2U * gl::target::GetByteSize(Full), statistics.peakBytes);
+	EXPECT_EQ(6U * gl::target::GetByteSize(Full), statistics.unaliasedBytes);
+
+	// And the pool agrees with the graph
+	targets.BeginFrame();
+	graph.Execute(targets);
+	targets.EndFrame();
+
+	EXPECT_EQ(statistics.physicalTargets, targets.GetStatistics().created);
+	EXPECT_EQ(statistics.peakBytes, targets.GetStatistics().peakBytes);
+	EXPECT_EQ(4U, targets.GetStatistics().aliased);
+	EXPECT_TRUE(device.errors.empty()) << device.errors.front();
+}
+
+TEST_F(FrameGraphTest, ScheduleFinishesABranchBeforeStartingTheNext)
+{
+	gl::FrameGraph graph{};
+
+	const gl::graph::ResourceId output = graph.ImportTarget("Output", nullptr);
+	const gl::graph::ResourceId left = graph.CreateTarget("Left", Full);
+	const gl::graph::ResourceId right = graph.CreateTarget("Right", Full);
+
+	// Declared interleaved, the two producers come first
+	const gl::graph::PassId produce_left = graph.AddPass("ProduceLeft", {});
+	graph.Write(produce_left, left, Usage::Attachment);
+	const gl::graph::PassId produce_right = graph.AddPass("ProduceRight", {});
+	graph.Write(produce_right, right, Usage::Attachment);
+	const gl::graph::PassId consume_left = graph.AddPass("ConsumeLeft", {});
+	graph.Read(consume_left, left, Usage::Sampled);
+	graph.Write(consume_left, output, Usage::Attachment);
+	const gl::graph::PassId consume_right = graph.AddPass("ConsumeRight", {});
+	graph.Read(consume_right, right, Usage::Sampled);
+	graph.Write(consume_right, output, Usage::Attachment);
+
+	graph.Compile();
+
+	std::vector<gl::graph::PassId> order{};
+	for (const gl::graph::ScheduledPass& scheduled : graph.GetSchedule())
+	{
+		order.push_back(scheduled.pass);
+	}
+
+	EXPECT_EQ((std::vector<gl::graph::PassId>{ produce_left, consume_left, produce_right, consume_right }), order);
+	EXPECT_EQ(1U, graph.GetStatistics().physicalTargets);
+	EXPECT_EQ(gl::target::GetByteSize(Full), graph.GetStatistics().peakBytes);
+}
+
+TEST_F(FrameGraphTest, ImportedTargetsAreHandedOutAsTheyAre)
+{
+	glstub::RecordingDevice device{};
+	gl::TransientTargets targets{ device };
+	gl::RenderTarget history{ Full, device };
+
+	gl::FrameGraph graph{};
+	const gl::graph::ResourceId imported = graph.ImportTarget("History", &history);
+	const gl::graph::ResourceId backbuffer = graph.ImportTarget("Backbuffer", nullptr);
+
+	const gl::RenderTarget* seen = nullptr;
+	const gl::RenderTarget* default_framebuffer = &history;
+
+	const gl::graph::PassId pass = graph.AddPass("Resolve", [&]() noexcept {
+		seen = graph.GetTarget(imported);
+		default_framebuffer = graph.GetTarget(backbuffer);
+	});
+	graph.Read(pass, imported, Usage::Sampled);
+	graph.Write(pass, backbuffer, Usage::Attachment);
+
+	graph.Compile();
+	EXPECT_EQ(0U, graph.GetStatistics().transientResources);
+
+	targets.BeginFrame();
+	graph.Execute(targets);
+	targets.EndFrame();
+
+	EXPECT_EQ(&history, seen);
+	EXPECT_EQ(nullptr, default_framebuffer);
+	EXPECT_EQ(0U, targets.GetStatistics().acquired);
+	EXPECT_EQ(&history, graph.GetTarget(imported));
+}
+
+TEST_F(FrameGraphTest, RandomGraphsKeepTheirDependencies)
+{
+	std::mt19937 engine{ 9 };
+
+	for (int iteration = 0; iteration < 200; ++iteration)
+	{
+		gl::FrameGraph graph{};
+
+		std::vector<gl::graph::ResourceId> resources{ graph.ImportTarget("Output", nullptr), graph.ImportBuffer("Storage") };
+		for (int i = 0; i < 10; ++i)
+		{
+			resources.push_back(graph.CreateTarget("Target", gl::target::Description{ 64U << (engine() % 2), 64, gl::target::Format::RGBA8 }));
+		}
+
+		struct Declared
+		{
+			gl::graph::ResourceId resource;
+			bool isWrite;
+		};
+
+		const std::uint32_t pass_count = 1 + engine() % 60;
+		std::vector<std::vector<Declared>> declared(pass_count);
+
+		for (std::uint32_t pass = 0; pass < pass_count; ++pass)
+		{
+			const gl::graph::PassId id = graph.AddPass("Pass", {});
+
+			const std::uint32_t count = 1 + engine() % 4;
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				const gl::graph::ResourceId resource = resources[engine() % resources.size()];
+				const bool is_write = 0 != engine() % 2;
+
+				if (is_write)
+				{
+					graph.Write(id, resource, 0 == engine() % 4 ? Usage::Image : Usage::Attachment);
+				}
+				else
+				{
+					graph.Read(id, resource, static_cast<Usage>(engine() % 8));
+				}
+
+				declared[pass].push_back(Declared{ resource, is_write });
+			}
+
+			if (0 == engine() % 10)
+			{
+				graph.SetSideEffect(id);
+			}
+		}
+
+		graph.Compile();
+
+		std::vector<std::int64_t> positions(pass_count, -1);
+		std::int64_t position = 0;
+		for (const gl::graph::ScheduledPass& scheduled : graph.GetSchedule())
+		{
+			positions[scheduled.pass] = position++;
+		}
+
+		for (std::uint32_t pass = 0; pass < pass_count; ++pass)
+		{
+			ASSERT_EQ(graph.IsCulled(pass), positions[pass] < 0);
+		}
+
+		// Two live passes sharing a resource which one of them writes keep the order they were declared in
+		for (std::uint32_t a = 0; a < pass_count; ++a)
+		{
+			for (std::uint32_t b = a + 1; b < pass_count; ++b)
+			{
+				if (positions[a] < 0 || positions[b] < 0)
+				{
+					continue;
+				}
+
+				for (const Declared& first : declared[a])
+				{
+					for (const Declared& second : declared[b])
+					{
+						if (first.resource == second.resource && (first.isWrite || second.isWrite))
+						{
+							ASSERT_LT(positions[a], positions[b]) << "iteration " << iteration;
+						}
+					}
+				}
+			}
+		}
+
+		// And the lifetimes cover every use
+		for (std::uint32_t pass = 0; pass < pass_count; ++pass)
+		{
+			if (positions[pass] < 0)
+			{
+				continue;
+			}
+
+			for (const Declared& access : declared[pass])
+			{
+				const gl::graph::Lifetime lifetime = graph.GetLifetime(access.resource);
+				ASSERT_LE(static_cast<std::int64_t>(lifetime.first), positions[pass]);
+				ASSERT_GE(static_cast<std::int64_t>(lifetime.last), positions[pass]);
+			}
+		}
+
+		const gl::graph::Statistics& statistics = graph.GetStatistics();
+		ASSERT_LE(statistics.physicalTargets, statistics.transientResources);
+		ASSERT_LE(statistics.peakBytes, statistics.unaliasedBytes);
+	}
+}
+
+TEST_F(FrameGraphTest, MeasureCompilation)
+{
+	const gl::graph::Benchmark benchmark = gl::graph::MeasureCompilation(1024, 4);
+
+	EXPECT_EQ(1024U, benchmark.passes);
+	EXPECT_LT(0.0, benchmark.passesPerSecond);
+	EXPECT_EQ(1024U, benchmark.statistics.passes);
+	EXPECT_LT(0U, benchmark.statistics.physicalTargets);
+	EXPECT_LT(benchmark.statistics.physicalTargets, benchmark.statistics.transientResources);
+	EXPECT_LT(benchmark.statistics.peakBytes, benchmark.statistics.unaliasedBytes);
+
+	std::printf("%u passes compiled in %.3f ms, %u of %u targets and %u barriers\n", benchmark.passes, benchmark.seconds * 1e3,
+		benchmark.statistics.physicalTargets, benchmark.statistics.transientResources, benchmark.statistics.barriers);
+}
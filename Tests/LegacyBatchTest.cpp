@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "Glib.Legacy.Primitive.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace
+{
+	// Every vertex is told apart by its x, the index it was added at
+	void
+	AddVertices(gl::legacy::PrimitiveBatch& batch, const std::size_t& count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			batch.AddVertex(static_cast<float>(i), 0.0f, 0.0f);
+		}
+	}
+
+	[[nodiscard]]
+	std::vector<int>
+	GetIndices(const gl::legacy::PrimitiveBatch& batch)
+	{
+		std::vector<int> result{};
+		for (const gl::legacy::BatchVertex& vertex : batch.GetVertices())
+		{
+			result.push_back(static_cast<int>(vertex.position[0]));
+		}
+
+		return result;
+	}
+
+	[[nodiscard]]
+	std::vector<int>
+	Record(gl::Primitive mode, const std::size_t& count)
+	{
+		gl::legacy::PrimitiveBatch batch{};
+		batch.Begin(mode);
+		AddVertices(batch, count);
+		batch.End();
+
+		return GetIndices(batch);
+	}
+}
+
+TEST(PrimitiveBatch, QuadsBecomeTwoTrianglesEach)
+{
+	// The ninth vertex starts a quad which never ends
+	EXPECT_EQ((std::vector<int>{ 0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7 }), Record(gl::Primitive::Quads, 9));
+}
+
+TEST(PrimitiveBatch, QuadStripsKeepTheirWinding)
+{
+	EXPECT_EQ((std::vector<int>{ 0, 1, 3, 0, 3, 2, 2, 3, 5, 2, 5, 4 }), Record(gl::Primitive::QuadStrip, 7));
+}
+
+TEST(PrimitiveBatch, PolygonsAreFans)
+{
+	EXPECT_EQ((std::vector<int>{ 0, 1, 2, 0, 2, 3, 0, 3, 4 }), Record(gl::Primitive::Polygon, 5));
+	EXPECT_EQ(Record(gl::Primitive::TriangleFan, 5), Record(gl::Primitive::Polygon, 5));
+}
+
+TEST(PrimitiveBatch, StripsAndLoopsBecomeLists)
+{
+	EXPECT_EQ((std::vector<int>{ 0, 1, 2, 2, 1, 3, 2, 3, 4 }), Record(gl::Primitive::TriangleStrip, 5));
+	EXPECT_EQ((std::vector<int>{ 0, 1, 1, 2 }), Record(gl::Primitive::LineStrip, 3));
+	EXPECT_EQ((std::vector<int>{ 0, 1, 1, 2, 2, 0 }), Record(gl::Primitive::LineLoop, 3));
+}
+
+TEST(PrimitiveBatch, DropsIncompletePrimitives)
+{
+	EXPECT_EQ((std::vector<int>{ 0, 1 }), Record(gl::Primitive::Lines, 3));
+	EXPECT_EQ((std::vector<int>{ 0, 1, 2 }), Record(gl::Primitive::Triangles, 5));
+	EXPECT_TRUE(Record(gl::Primitive::QuadStrip, 3).empty());
+	EXPECT_TRUE(Record(gl::Primitive::Polygon, 2).empty());
+	EXPECT_TRUE(Record(gl::Primitive::LineLoop, 1).empty());
+
+	gl::legacy::PrimitiveBatch batch{};
+	batch.Begin(gl::Primitive::Quads);
+	AddVertices(batch, 3);
+	batch.End();
+
+	EXPECT_TRUE(batch.IsEmpty());
+	EXPECT_TRUE(batch.GetRanges().empty());
+}
+
+TEST(PrimitiveBatch, MergesConsecutiveBlocksOfTheSameTopology)
+{
+	gl::legacy::PrimitiveBatch batch{};
+
+	// Triangles, quads and fans all end up as triangles
+	batch.Begin(gl::Primitive::Triangles);
+	AddVertices(batch, 3);
+	batch.End();
+	batch.Begin(gl::Primitive::Quads);
+	AddVertices(batch, 4);
+	batch.End();
+	batch.Begin(gl::Primitive::TriangleFan);
+	AddVertices(batch, 4);
+	batch.End();
+
+	ASSERT_EQ(1U, batch.GetRanges().size());
+	EXPECT_EQ(gl::Primitive::Triangles, batch.GetRanges()[0].topology);
+	EXPECT_EQ(0U, batch.GetRanges()[0].first);
+	EXPECT_EQ(15U, batch.GetRanges()[0].count);
+
+	// Another topology starts a range, and so does the next change back
+	batch.Begin(gl::Primitive::LineStrip);
+	AddVertices(batch, 3);
+	batch.End();
+	batch.Begin(gl::Primitive::Triangles);
+	AddVertices(batch, 3);
+	batch.End();
+
+	ASSERT_EQ(3U, batch.GetRanges().size());
+	EXPECT_EQ(gl::Primitive::Lines, batch.GetRanges()[1].topology);
+	EXPECT_EQ(15U, batch.GetRanges()[1].first);
+	EXPECT_EQ(4U, batch.GetRanges()[1].count);
+	EXPECT_EQ(gl::Primitive::Triangles, batch.GetRanges()[2].topology);
+	EXPECT_EQ(19U, batch.GetRanges()[2].first);
+	EXPECT_EQ(22U, batch.GetVertices().size());
+
+	// An empty block in between leaves the ranges as they were
+	batch.Begin(gl::Primitive::Triangles);
+	batch.End();
+	batch.Begin(gl::Primitive::Triangles);
+	AddVertices(batch, 3);
+	batch.End();
+	EXPECT_EQ(3U, batch.GetRanges().size());
+	EXPECT_EQ(6U, batch.GetRanges()[2].count);
+}
+
+TEST(PrimitiveBatch, RecordsTheCurrentAttributes)
+{
+	gl::legacy::PrimitiveBatch batch{};
+
+	// Outside of a block, as opengl ignores it
+	batch.AddVertex(9.0f, 9.0f, 9.0f);
+
+	batch.SetColour(10, 20, 30, 40);
+	batch.Begin(gl::Primitive::Points);
+	// Nested blocks are ignored
+	batch.Begin(gl::Primitive::Lines);
+	batch.AddVertex(1.0f, 2.0f, 3.0f);
+	batch.SetNormal(0.0f, 1.0f, 0.0f);
+	batch.SetTexCoord(0.5f, 0.25f);
+	batch.AddVertex(4.0f, 5.0f, 6.0f);
+
+	// The block isn't converted yet
+	EXPECT_TRUE(batch.IsRecording());
+	EXPECT_TRUE(batch.GetVertices().empty());
+	batch.End();
+
+	ASSERT_EQ(2U, batch.GetVertices().size());
+	ASSERT_EQ(1U, batch.GetRanges().size());
+	EXPECT_EQ(gl::Primitive::Points, batch.GetRanges()[0].topology);
+
+	const gl::legacy::BatchVertex& first = batch.GetVertices()[0];
+	const gl::legacy::BatchVertex& second = batch.GetVertices()[1];
+	EXPECT_EQ(1.0f, first.position[0]);
+	EXPECT_EQ(30, first.colour[2]);
+	EXPECT_EQ(1.0f, first.normal[2]);
+	EXPECT_EQ(0.0f, first.texcoord[0]);
+	EXPECT_EQ(1.0f, second.normal[1]);
+	EXPECT_EQ(0.25f, second.texcoord[1]);
+	EXPECT_EQ(40, second.colour[3]);
+
+	// The attributes outlive a clear
+	batch.Clear();
+	EXPECT_TRUE(batch.IsEmpty());
+	EXPECT_EQ(10, batch.GetCurrent().colour[0]);
+}
+
+TEST(LegacyPrimitive, StateChangesFlushTheBatch)
+{
+	glstub::Reset();
+	gl::legacy::primitive::SetBackend(gl::legacy::primitive::Backend::Batched);
+	ASSERT_NE(nullptr, gl::global::GetStateListener());
+
+	gl::legacy::primitive::Begin(gl::Primitive::Quads);
+	gl::legacy::primitive::Vertex(0.0f, 0.0f, 0.0f);
+	gl::legacy::primitive::Vertex(1.0f, 0.0f, 0.0f);
+	gl::legacy::primitive::Vertex(1.0f, 1.0f, 0.0f);
+	gl::legacy::primitive::Vertex(0.0f, 1.0f, 0.0f);
+	gl::legacy::primitive::End();
+
+	gl::legacy::primitive::Begin(gl::Primitive::Triangles);
+	gl::legacy::primitive::Vertex(2.0f, 0.0f, 0.0f);
+	gl::legacy::primitive::Vertex(3.0f, 0.0f, 0.0f);
+	gl::legacy::primitive::Vertex(3.0f, 1.0f, 0.0f);
+	gl::legacy::primitive::End();
+
+	// Recorded, merged, and not drawn yet
+	ASSERT_EQ(1U, gl::legacy::primitive::GetBatch().GetRanges().size());
+	EXPECT_EQ(0U, glstub::CountCalls("glDrawArrays"));
+	EXPECT_EQ(0U, glstub::CountCalls("glBegin"));
+
+	// As a texture binding or a blending change does
+	gl::global::NotifyStateChange();
+
+	const std::vector<glstub::Call> draws = glstub::FindCalls("glDrawArrays");
+	ASSERT_EQ(1U, draws.size());
+	EXPECT_EQ((std::vector<std::int64_t>{ GL_TRIANGLES, 0, 9 }), draws[0].args);
+	EXPECT_TRUE(gl::legacy::primitive::GetBatch().IsEmpty());
+	// The current attributes are left as glEnd would have
+	EXPECT_EQ(1U, glstub::CountCalls("glColor4ubv"));
+
+	// Nothing left to draw
+	gl::global::NotifyStateChange();
+	EXPECT_EQ(1U, glstub::CountCalls("glDrawArrays"));
+
+	gl::legacy::primitive::SetBackend(gl::legacy::primitive::Backend::Immediate);
+	EXPECT_EQ(nullptr, gl::global::GetStateListener());
+}
+
+TEST(LegacyPrimitive, ABlockInProgressIsNotFlushed)
+{
+	glstub::Reset();
+	gl::legacy::primitive::SetBackend(gl::legacy::primitive::Backend::Batched);
+
+	gl::legacy::primitive::Begin(gl::Primitive::Lines);
+	gl::legacy::primitive::Vertex(0.0f, 0.0f, 0.0f);
+	gl::global::NotifyStateChange();
+	gl::legacy::primitive::Vertex(1.0f, 0.0f, 0.0f);
+	gl::legacy::primitive::End();
+
+	EXPECT_EQ(0U, glstub::CountCalls("glDrawArrays"));
+
+	// Switching back draws what was recorded, then goes straight to the driver
+	gl::legacy::primitive::SetBackend(gl::legacy::primitive::Backend::Immediate);
+
+	const std::vector<glstub::Call> draws = glstub::FindCalls("glDrawArrays");
+	ASSERT_EQ(1U, draws.size());
+	EXPECT_EQ((std::vector<std::int64_t>{ GL_LINES, 0, 2 }), draws[0].args);
+
+	gl::legacy::primitive::Begin(gl::Primitive::Lines);
+	gl::legacy::primitive::End();
+	EXPECT_EQ(1U, glstub::CountCalls("glBegin"));
+	EXPECT_EQ(1U, glstub::CountCalls("glEnd"));
+}
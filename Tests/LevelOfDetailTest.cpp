@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+#include "Glib.LevelOfDetail.hpp"
+#include "Glib.MeshOptimizer.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	using Position = std::array<float, 3>;
+
+	struct Grid
+	{
+		std::vector<Position> positions;
+		std::vector<std::uint32_t> indices;
+	};
+
+	// Unit sphere by longitude and latitude, the seam and the poles repeat their positions
+	[[nodiscard]]
+	Grid MakeSphere(const std::uint32_t& segments)
+	{
+		const std::uint32_t rings = segments / 2;
+
+		Grid result{};
+		for (std::uint32_t y = 0; y <= rings; ++y)
+		{
+			for (std::uint32_t x = 0; x <= segments; ++x)
+			{
+				const float u = 6.2831853f * x / segments;
+				const float v = 3.1415926f * y / rings;
+
+				result.positions.push_back({ std::cos(u) * std::sin(v), std::cos(v), std::sin(u) * std::sin(v) });
+			}
+		}
+
+		for (std::uint32_t y = 0; y < rings; ++y)
+		{
+			for (std::uint32_t x = 0; x < segments; ++x)
+			{
+				const std::uint32_t a = y * (segments + 1) + x, c = a + segments + 1;
+				result.indices.insert(result.indices.end(), { a, c, a + 1, a + 1, c, c + 1 });
+			}
+		}
+
+		return result;
+	}
+
+	// A flat square of size by size quads in the plane z = 0
+	[[nodiscard]]
+	Grid MakePlane(const std::uint32_t& size)
+	{
+		Grid result{};
+		for (std::uint32_t y = 0; y <= size; ++y)
+		{
+			for (std::uint32_t x = 0; x <= size; ++x)
+			{
+				result.positions.push_back({ float(x), float(y), 0.0f });
+			}
+		}
+
+		for (std::uint32_t y = 0; y < size; ++y)
+		{
+			for (std::uint32_t x = 0; x < size; ++x)
+			{
+				const std::uint32_t a = y * (size + 1) + x, c = a + size + 1;
+				result.indices.insert(result.indices.end(), { a, a + 1, c, a + 1, c + 1, c });
+			}
+		}
+
+		return result;
+	}
+
+	[[nodiscard]]
+	std::span<const std::byte> GetBytes(const std::vector<Position>& positions) noexcept
+	{
+		return std::as_bytes(std::span{ positions });
+	}
+
+	[[nodiscard]]
+	double Length(const Position& p) noexcept
+	{
+		return std::sqrt(double(p[0]) * p[0] + double(p[1]) * p[1] + double(p[2]) * p[2]);
+	}
+
+	struct Surface
+	{
+		// Farthest the centre of a triangle gets from the unit sphere
+		double deviation = 0;
+		std::size_t flipped = 0;
+		std::size_t degenerate = 0;
+	};
+
+	[[nodiscard]]
+	Surface MeasureSphere(std::span<const std::uint32_t> indices, const std::vector<Position>& positions)
+	{
+		Surface result{};
+
+		for (std::size_t t = 0; t < indices.size() / 3; ++t)
+		{
+			const Position& a = positions[indices[t * 3]];
+			const Position& b = positions[indices[t * 3 + 1]];
+			const Position& c = positions[indices[t * 3 + 2]];
+
+			const Position centre{ (a[0] + b[0] + c[0]) / 3, (a[1] + b[1] + c[1]) / 3, (a[2] + b[2] + c[2]) / 3 };
+			result.deviation = std::max(result.deviation, 1.0 - Length(centre));
+
+			const Position e1{ b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const Position e2{ c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			const Position normal{ e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+
+			if (indices[t * 3] == indices[t * 3 + 1] || indices[t * 3 + 1] == indices[t * 3 + 2] || indices[t * 3] == indices[t * 3 + 2])
+			{
+				++result.degenerate;
+			}
+			// The sphere winds clockwise seen from the outside
+			else if (0 < normal[0] * centre[0] + normal[1] * centre[1] + normal[2] * centre[2])
+			{
+				++result.flipped;
+			}
+		}
+
+		return result;
+	}
+}
+
+TEST(Simplify, CollapsesAPlaneWithoutError)
+{
+	const Grid plane = MakePlane(32);
+
+	std::vector<std::uint32_t> result{};
+	const gl::lod::SimplifyResult outcome = gl::lod::Simplify(result, plane.indices, GetBytes(plane.positions), sizeof(Position), 0, plane.indices.size() / 8);
+
+	EXPECT_EQ(result.size(), outcome.indexCount);
+	EXPECT_LE(outcome.indexCount, plane.indices.size() / 8);
+	EXPECT_EQ(0U, outcome.indexCount % 3);
+	EXPECT_LT(outcome.error, 1e-4f);
+}
+
+TEST(Simplify, StaysUnderTheErrorLimit)
+{
+	const Grid sphere = MakeSphere(96);
+
+	float previous_error = 0;
+	std::size_t previous_count = sphere.indices.size();
+
+	for (const float max_error : { 0.001f, 0.005f, 0.02f, 0.1f })
+	{
+		std::vector<std::uint32_t> result{};
+		const gl::lod::SimplifyResult outcome = gl::lod::Simplify(result, sphere.indices, GetBytes(sphere.positions), sizeof(Position), 0, 0, max_error);
+
+		EXPECT_LE(outcome.error, max_error);
+		EXPECT_GE(outcome.error, previous_error);
+		EXPECT_LT(outcome.indexCount, previous_count) << max_error;
+
+		// The collapses only move vertices onto neighbours, the surface stays close and keeps its orientation
+		const Surface surface = MeasureSphere(result, sphere.positions);
+		EXPECT_LT(surface.deviation, max_error * 8 + 0.01) << max_error;
+		EXPECT_EQ(0U, surface.flipped) << max_error;
+		EXPECT_EQ(0U, surface.degenerate) << max_error;
+
+		previous_error = outcome.error;
+		previous_count = outcome.indexCount;
+	}
+}
+
+TEST(Simplify, LeavesInvalidInputAlone)
+{
+	const Grid sphere = MakeSphere(16);
+	std::vector<std::uint32_t> result{};
+
+	EXPECT_EQ(sphere.indices.size(), gl::lod::Simplify(result, sphere.indices, GetBytes(sphere.positions), 0, 0, 3).indexCount);
+	EXPECT_EQ(sphere.indices, result);
+
+	EXPECT_EQ(sphere.indices.size(), gl::lod::Simplify(result, sphere.indices, GetBytes(sphere.positions), sizeof(Position), 4, 3).indexCount);
+
+	std::vector<std::uint32_t> out_of_range = sphere.indices;
+	out_of_range[7] = static_cast<std::uint32_t>(sphere.positions.size());
+	EXPECT_EQ(out_of_range.size(), gl::lod::Simplify(result, out_of_range, GetBytes(sphere.positions), sizeof(Position), 0, 3).indexCount);
+}
+
+TEST(Simplify, ReportsItsSpeed)
+{
+	const gl::lod::Benchmark result = gl::lod::MeasureSimplification(256);
+
+	EXPECT_EQ(256U * 128U * 2U, result.triangles);
+	EXPECT_LE(result.resultTriangles, result.triangles / 4);
+	EXPECT_LT(0.0, result.trianglesPerSecond);
+	EXPECT_LT(result.error, 0.05f);
+
+	std::cout << "Simplified " << result.triangles << " triangles to " << result.resultTriangles << " in " << result.seconds * 1000.0
+		<< " ms, " << result.trianglesPerSecond / 1e6 << " M triangles/s, error " << result.error << "\n";
+
+	RecordProperty("triangles_per_second", static_cast<int>(result.trianglesPerSecond));
+}
+
+TEST(LodArena, RejectsVerticesWithoutAPosition)
+{
+	EXPECT_THROW(gl::LodArena(0), std::invalid_argument);
+	EXPECT_THROW(gl::LodArena(sizeof(Position) - 1), std::invalid_argument);
+	EXPECT_THROW(gl::LodArena(sizeof(Position) + 4, 8), std::invalid_argument);
+	EXPECT_NO_THROW(gl::LodArena(sizeof(Position) + 4, 4));
+}
+
+TEST(LodArena, BuildsACoarseningChain)
+{
+	const Grid sphere = MakeSphere(64);
+
+	gl::LodArena arena{ sizeof(Position) };
+	const std::uint32_t first = arena.Add(GetBytes(sphere.positions), sphere.indices, gl::lod::ChainOptions{ 6, 0.5f });
+	const std::uint32_t second = arena.Add(GetBytes(sphere.positions), sphere.indices, gl::lod::ChainOptions{ 3, 0.25f });
+
+	ASSERT_EQ(0U, first);
+	ASSERT_EQ(1U, second);
+
+	std::vector<Position> vertices(arena.GetVertices().size() / sizeof(Position));
+	std::memcpy(vertices.data(), arena.GetVertices().data(), arena.GetVertices().size());
+
+	for (const gl::lod::Mesh& mesh : arena.GetMeshes())
+	{
+		ASSERT_LE(2U, mesh.levelCount);
+		EXPECT_EQ(sphere.indices.size(), mesh.levels[0].indexCount);
+		EXPECT_EQ(0.0f, mesh.levels[0].error);
+
+		const std::vector<Position> mesh_vertices(vertices.begin() + mesh.baseVertex, vertices.begin() + mesh.baseVertex + mesh.vertexCount);
+
+		for (std::uint32_t l = 0; l < mesh.levelCount; ++l)
+		{
+			const gl::lod::Level& level = mesh.levels[l];
+			const std::span<const std::uint32_t> indices = arena.GetIndices().subspan(level.firstIndex, level.indexCount);
+
+			ASSERT_TRUE(std::all_of(indices.begin(), indices.end(), [&](std::uint32_t index) { return index < mesh.vertexCount; }));
+
+			if (0 < l)
+			{
+				EXPECT_LT(level.indexCount, mesh.levels[l - 1].indexCount);
+				EXPECT_GE(level.error, mesh.levels[l - 1].error);
+			}
+
+			const Surface surface = MeasureSphere(indices, mesh_vertices);
+			EXPECT_LT(surface.deviation, level.error * 8 + 0.01) << l;
+
+			// Past a quarter of the radius, what's left is mostly the locked seam and poles
+			if (level.error < 0.25f)
+			{
+				EXPECT_EQ(0U, surface.flipped) << l;
+			}
+
+			std::cout << "level " << l << ": " << level.indexCount / 3 << " triangles, error " << level.error << ", deviation " << surface.deviation << "\n";
+		}
+	}
+
+	arena.Clear();
+	EXPECT_TRUE(arena.GetMeshes().empty());
+	EXPECT_TRUE(arena.GetVertices().empty());
+}
+
+TEST(LodSelector, CoarsensWithDistanceWithoutFlickering)
+{
+	const Grid sphere = MakeSphere(64);
+
+	gl::LodArena arena{ sizeof(Position) };
+	const gl::lod::Mesh& mesh = arena.GetMesh(arena.Add(GetBytes(sphere.positions), sphere.indices, gl::lod::ChainOptions{ 5, 0.5f }));
+	ASSERT_LE(3U, mesh.levelCount);
+
+	gl::LodSelector selector{ 1.0f, 0.25f };
+
+	std::uint32_t level = gl::lod::MaxLevels;
+	std::uint32_t previous = 0;
+	for (float distance = 0.5f; distance < 1e5f; distance *= 1.5f)
+	{
+		level = selector.Select(mesh, distance, level);
+
+		EXPECT_GE(level, previous) << distance;
+		EXPECT_LE(selector.GetProjectedError(mesh.levels[level].error, distance), 1.0f) << distance;
+		previous = level;
+	}
+	EXPECT_EQ(mesh.levelCount - 1, level);
+
+	// Right at the distance where the level two projects to the threshold
+	const float limit = selector.GetProjectedError(mesh.levels[2].error, 1.0f);
+	level = selector.Select(mesh, limit * 1.01f, gl::lod::MaxLevels);
+
+	std::uint32_t changes = 0;
+	for (int i = 0; i < 100; ++i)
+	{
+		const std::uint32_t next = selector.Select(mesh, limit * (i % 2 ? 0.99f : 1.01f), level);
+		changes += next != level;
+		level = next;
+	}
+	EXPECT_EQ(0U, changes);
+}
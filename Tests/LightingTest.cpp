@@ -0,0 +1,362 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "Glib.Lighting.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr float FieldOfView = std::numbers::pi_v<float> / 3;
+	constexpr float Aspect = 16.0f / 9.0f;
+	constexpr float Near = 0.1f;
+	constexpr float Far = 200.0f;
+	constexpr float Identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+	class LightingTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			glstub::Reset();
+		}
+	};
+
+	[[nodiscard]]
+	gl::legacy::Light MakeLight(const float& x, const float& y, const float& z, const float& quadratic)
+	{
+		gl::legacy::Light light{};
+		light.position[0] = x;
+		light.position[1] = y;
+		light.position[2] = z;
+		light.quadraticAttenuation = quadratic;
+
+		return light;
+	}
+
+	[[nodiscard]]
+	gl::legacy::Light MakeSpot(const float& z, const float(&direction)[3], const float& cutoff)
+	{
+		gl::legacy::Light light = MakeLight(0, 0, z, 1.0f);
+		light.spotCutoff = cutoff;
+		std::copy(std::begin(direction), std::end(direction), light.spotDirection);
+
+		return light;
+	}
+
+	// Random point and spot lights in front of the camera
+	void AddRandomLights(gl::ClusteredLighting& clustered, const std::size_t& count, const std::uint32_t& seed)
+	{
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> spread{ -40.0f, 40.0f }, depth{ -100.0f, -1.0f }, unit{ -1.0f, 1.0f };
+		std::uniform_real_distribution<float> falloff{ 0.5f, 8.0f }, cutoff{ 10.0f, 80.0f };
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			gl::legacy::Light light = MakeLight(spread(random), spread(random) * 0.5f, depth(random), falloff(random));
+
+			if (0 == i % 3)
+			{
+				light.spotCutoff = cutoff(random);
+				light.spotDirection[0] = unit(random);
+				light.spotDirection[1] = unit(random);
+				light.spotDirection[2] = unit(random);
+			}
+
+			clustered.Add(light);
+		}
+	}
+
+	// Cluster of a view space point inside the frustum, the same way a shader finds it
+	[[nodiscard]]
+	std::uint32_t GetCluster(const gl::ClusteredLighting& clustered, const float(&point)[3])
+	{
+		const float tangent_y = std::tan(FieldOfView * 0.5f);
+		const float tangent_x = tangent_y * Aspect;
+		const float depth = -point[2];
+
+		const auto tile = [](const float& ndc, const std::uint32_t& count) {
+			return std::min(static_cast<std::uint32_t>((ndc + 1.0f) * 0.5f * static_cast<float>(count)), count - 1);
+		};
+
+		const std::uint32_t x = tile(point[0] / (depth * tangent_x), gl::lighting::DefaultClustersX);
+		const std::uint32_t y = tile(point[1] / (depth * tangent_y), gl::lighting::DefaultClustersY);
+
+		return clustered.GetClusterIndex(x, y, clustered.GetSlice(depth));
+	}
+
+	[[nodiscard]]
+	bool IsInFrustum(const float(&point)[3])
+	{
+		const float tangent_y = std::tan(FieldOfView * 0.5f);
+		const float depth = -point[2];
+
+		return Near < depth && depth < Far && std::abs(point[0]) < depth * tangent_y * Aspect && std::abs(point[1]) < depth * tangent_y;
+	}
+
+	[[nodiscard]]
+	bool HasLight(const gl::ClusteredLighting& clustered, const std::uint32_t& cluster, const std::uint32_t& light)
+	{
+		const gl::lighting::Cluster range = clustered.GetClusters()[cluster];
+		const auto indices = clustered.GetLightIndices().subspan(range.offset, range.count);
+
+		return std::find(indices.begin(), indices.end(), light) != indices.end();
+	}
+}
+
+TEST(Lighting, RangeEndsAtTheCutoff)
+{
+	gl::legacy::Light light{};
+	EXPECT_TRUE(std::isinf(gl::lighting::GetRange(light)));
+
+	light.quadraticAttenuation = 1.0f;
+	const float quadratic = gl::lighting::GetRange(light);
+	EXPECT_NEAR(1.0f / gl::lighting::IntensityCutoff, light.constantAttenuation + quadratic * quadratic, 1e-2f);
+
+	light.quadraticAttenuation = 0.0f;
+	light.linearAttenuation = 2.0f;
+	EXPECT_NEAR((1.0f / gl::lighting::IntensityCutoff - 1.0f) / 2.0f, gl::lighting::GetRange(light), 1e-3f);
+
+	// Dim or black lights reach nothing
+	light.constantAttenuation = 1000.0f;
+	EXPECT_EQ(0.0f, gl::lighting::GetRange(light));
+
+	light.constantAttenuation = 1.0f;
+	light.diffuse = gl::win32::Colour{ 0.0f, 0.0f, 0.0f };
+	EXPECT_EQ(0.0f, gl::lighting::GetRange(light));
+}
+
+TEST_F(LightingTest, BinsEveryPointALightReaches)
+{
+	gl::ClusteredLighting clustered{ gl::lighting::DefaultClustersX, gl::lighting::DefaultClustersY, gl::lighting::DefaultClustersZ, 4 };
+	clustered.SetView(Identity, FieldOfView, Aspect, Near, Far);
+	AddRandomLights(clustered, 600, 11);
+	clustered.Build();
+
+	const auto lights = clustered.GetLights();
+	ASSERT_EQ(600U, lights.size());
+
+	std::mt19937 random{ 5 };
+	std::uniform_real_distribution<float> unit{ -1.0f, 1.0f };
+
+	std::size_t checked = 0;
+	for (std::uint32_t index = 0; index < lights.size(); ++index)
+	{
+		const gl::lighting::GpuLight& light = lights[index];
+		const float range = light.position[3];
+
+		for (std::uint32_t sample = 0; sample < 64; ++sample)
+		{
+			const float offset[3] = { unit(random) * range, unit(random) * range, unit(random) * range };
+			const float distance = std::sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]);
+
+			// Strictly inside the light, away from the rounding of the cluster planes
+			if (0.95f * range < distance || distance <= 0)
+			{
+				continue;
+			}
+
+			const bool is_spot = -1.0f < light.direction[3];
+			if (is_spot && (offset[0] * light.direction[0] + offset[1] * light.direction[1] + offset[2] * light.direction[2]) / distance < light.direction[3] + 0.01f)
+			{
+				continue;
+			}
+
+			const float point[3] = { light.position[0] + offset[0], light.position[1] + offset[1], light.position[2] + offset[2] };
+			if (!IsInFrustum(point))
+			{
+				continue;
+			}
+
+			ASSERT_TRUE(HasLight(clustered, GetCluster(clustered, point), index)) << "light " << index << (is_spot ? " (spot)" : "");
+			++checked;
+		}
+	}
+
+	EXPECT_LT(1000U, checked);
+}
+
+TEST_F(LightingTest, GivesTheSameClustersOnAnyThreadCount)
+{
+	std::vector<std::uint32_t> expected_indices{};
+	std::vector<std::uint64_t> expected_clusters{};
+
+	for (const std::uint32_t threads : { 1U, 3U, 8U })
+	{
+		gl::ClusteredLighting clustered{ gl::lighting::DefaultClustersX, gl::lighting::DefaultClustersY, gl::lighting::DefaultClustersZ, threads };
+		clustered.SetView(Identity, FieldOfView, Aspect, Near, Far);
+		AddRandomLights(clustered, 2000, 3);
+		clustered.Build();
+
+		std::vector<std::uint64_t> clusters{};
+		for (const gl::lighting::Cluster& cluster : clustered.GetClusters())
+		{
+			clusters.push_back(static_cast<std::uint64_t>(cluster.offset) << 32 | cluster.count);
+
+			// The lights of a cluster keep the order they were added in
+			const auto indices = clustered.GetLightIndices().subspan(cluster.offset, cluster.count);
+			ASSERT_TRUE(std::is_sorted(indices.begin(), indices.end()));
+		}
+
+		const auto indices = clustered.GetLightIndices();
+		if (1 == threads)
+		{
+			expected_indices.assign(indices.begin(), indices.end());
+			expected_clusters = clusters;
+			continue;
+		}
+
+		EXPECT_EQ(expected_clusters, clusters) << threads << " threads";
+		EXPECT_TRUE(std::equal(indices.begin(), indices.end(), expected_indices.begin(), expected_indices.end())) << threads << " threads";
+	}
+}
+
+TEST_F(LightingTest, CullsLightsOutsideTheFrustum)
+{
+	gl::ClusteredLighting clustered{};
+	clustered.SetView(Identity, FieldOfView, Aspect, Near, Far);
+
+	// Visible, behind the camera, far to the left, and black
+	clustered.Add(MakeLight(0, 0, -10, 100.0f));
+	clustered.Add(MakeLight(0, 0, 30, 1.0f));
+	clustered.Add(MakeLight(-500, 0, -10, 1.0f));
+
+	gl::legacy::Light black = MakeLight(0, 0, -10, 1.0f);
+	black.diffuse = gl::win32::Colour{ 0.0f, 0.0f, 0.0f };
+	clustered.Add(black);
+
+	clustered.Build();
+
+	const gl::lighting::Statistics& statistics = clustered.GetStatistics();
+	EXPECT_EQ(4U, statistics.lights);
+	EXPECT_EQ(3U, statistics.culledLights);
+	EXPECT_LT(0U, statistics.references);
+	EXPECT_EQ(statistics.references, clustered.GetLightIndices().size());
+
+	for (const std::uint32_t index : clustered.GetLightIndices())
+	{
+		EXPECT_EQ(0U, index);
+	}
+
+	// Only the clusters around the light, its range is about 1.6
+	EXPECT_LT(statistics.occupiedClusters, statistics.clusters / 20);
+
+	const float centre[3] = { 0, 0, -10 };
+	EXPECT_TRUE(HasLight(clustered, GetCluster(clustered, centre), 0));
+
+	const float beyond[3] = { 0, 0, -40 };
+	EXPECT_FALSE(HasLight(clustered, GetCluster(clustered, beyond), 0));
+}
+
+TEST_F(LightingTest, KeepsSpotLightsToTheirCone)
+{
+	const float away[3] = { 0, 0, -1 };
+
+	gl::ClusteredLighting clustered{};
+	clustered.SetView(Identity, FieldOfView, Aspect, Near, Far);
+	clustered.Add(MakeSpot(-10, away, 20.0f));
+	clustered.Add(MakeLight(0, 0, -10, 1.0f));
+	clustered.Build();
+
+	// The point light reaches towards the camera, the spot light shining away does not
+	const std::uint32_t front = clustered.GetSlice(9.5f);
+	bool point_in_front = false;
+
+	for (std::uint32_t z = 0; z < gl::lighting::DefaultClustersZ; ++z)
+	{
+		for (std::uint32_t y = 0; y < gl::lighting::DefaultClustersY; ++y)
+		{
+			for (std::uint32_t x = 0; x < gl::lighting::DefaultClustersX; ++x)
+			{
+				const std::uint32_t cluster = clustered.GetClusterIndex(x, y, z);
+
+				if (z < front)
+				{
+					EXPECT_FALSE(HasLight(clustered, cluster, 0)) << x << ", " << y << ", " << z;
+					point_in_front |= HasLight(clustered, cluster, 1);
+				}
+			}
+		}
+	}
+
+	EXPECT_TRUE(point_in_front);
+
+	const float ahead[3] = { 0, 0, -20 };
+	EXPECT_TRUE(HasLight(clustered, GetCluster(clustered, ahead), 0));
+
+	// The spot cone is packed for the shader: view direction and cosine of the cutoff
+	const gl::lighting::GpuLight& spot = clustered.GetLights()[0];
+	EXPECT_FLOAT_EQ(-1.0f, spot.direction[2]);
+	EXPECT_NEAR(std::cos(20.0f * std::numbers::pi_v<float> / 180.0f), spot.direction[3], 1e-6f);
+	EXPECT_EQ(-1.0f, clustered.GetLights()[1].direction[3]);
+}
+
+TEST_F(LightingTest, SlicesMatchTheShaderParameters)
+{
+	gl::ClusteredLighting clustered{};
+	clustered.SetView(Identity, FieldOfView, Aspect, Near, Far);
+
+	const gl::lighting::ShaderParameters parameters = clustered.GetShaderParameters();
+	EXPECT_EQ(gl::lighting::DefaultClustersX, parameters.grid[0]);
+	EXPECT_EQ(gl::lighting::DefaultClustersZ, parameters.grid[2]);
+
+	for (const float depth : { 0.15f, 1.0f, 3.7f, 25.0f, 150.0f })
+	{
+		const float slice = std::log(depth) * parameters.sliceScale + parameters.sliceBias;
+		EXPECT_EQ(static_cast<std::uint32_t>(slice), clustered.GetSlice(depth)) << depth;
+	}
+
+	EXPECT_EQ(0U, clustered.GetSlice(0.01f));
+	EXPECT_EQ(gl::lighting::DefaultClustersZ - 1, clustered.GetSlice(1000.0f));
+}
+
+TEST_F(LightingTest, UploadsAndBindsThreeStorageBuffers)
+{
+	{
+		gl::ClusteredLighting clustered{ 4, 4, 4, 1 };
+		clustered.SetView(Identity, FieldOfView, Aspect, Near, Far);
+
+		// Empty blocks still get a buffer
+		clustered.Build();
+		clustered.Upload();
+		ASSERT_EQ(3U, glstub::CountCalls("glGenBuffers"));
+
+		clustered.Add(MakeLight(0, 0, -10, 1.0f));
+		clustered.Build();
+		clustered.Upload();
+		clustered.Bind(4, 5, 6);
+
+		// The buffers are made once and refilled
+		EXPECT_EQ(3U, glstub::CountCalls("glGenBuffers"));
+
+		const std::vector<glstub::Call> data = glstub::FindCalls("glBufferData");
+		ASSERT_EQ(6U, data.size());
+		EXPECT_EQ(static_cast<std::int64_t>(sizeof(gl::lighting::GpuLight)), data[3].args[1]);
+		EXPECT_EQ(static_cast<std::int64_t>(64 * sizeof(gl::lighting::Cluster)), data[4].args[1]);
+		EXPECT_EQ(static_cast<std::int64_t>(clustered.GetLightIndices().size() * sizeof(std::uint32_t)), data[5].args[1]);
+
+		const std::vector<glstub::Call> bindings = glstub::FindCalls("glBindBufferBase");
+		ASSERT_EQ(3U, bindings.size());
+		for (std::size_t i = 0; i < bindings.size(); ++i)
+		{
+			EXPECT_EQ(GL_SHADER_STORAGE_BUFFER, bindings[i].args[0]);
+			EXPECT_EQ(static_cast<std::int64_t>(4 + i), bindings[i].args[1]);
+			EXPECT_NE(0, bindings[i].args[2]);
+		}
+	}
+
+	EXPECT_EQ(3U, glstub::CountCalls("glDeleteBuffers"));
+	EXPECT_TRUE(glstub::GetState().buffers.empty());
+}
+
+TEST(Lighting, ReportsItsBinningTime)
+{
+	const gl::lighting::Benchmark result = gl::lighting::MeasureBinning(4096, 0, 2);
+
+	EXPECT_EQ(4096U, result.lights);
+	EXPECT_LT(0.0, result.seconds);
+	EXPECT_LT(0U, result.references);
+}
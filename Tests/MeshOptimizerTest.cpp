@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+#include "Glib.MeshOptimizer.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace
+{
+	struct Vertex
+	{
+		float position[3];
+		float uv[2];
+		// Identifies the vertex wherever it's moved to
+		std::uint32_t id;
+	};
+
+	struct Mesh
+	{
+		std::vector<Vertex> vertices;
+		std::vector<std::uint32_t> indices;
+	};
+
+	using Triangle = std::array<std::uint32_t, 3>;
+
+	// A sphere made of a size by size grid, with the triangles and the vertices shuffled
+	[[nodiscard]]
+	Mesh MakeShuffledSphere(const std::uint32_t& size, const std::uint32_t& seed)
+	{
+		std::mt19937 random{ seed };
+
+		Mesh grid{};
+		for (std::uint32_t y = 0; y <= size; ++y)
+		{
+			for (std::uint32_t x = 0; x <= size; ++x)
+			{
+				const float u = x * 6.2831853f / size;
+				const float v = y * 3.1415926f / size;
+				const std::uint32_t id = static_cast<std::uint32_t>(grid.vertices.size());
+
+				grid.vertices.push_back(Vertex{ { std::cos(u) * std::sin(v), std::cos(v), std::sin(u) * std::sin(v) }, { float(x), float(y) }, id });
+			}
+		}
+
+		for (std::uint32_t y = 0; y < size; ++y)
+		{
+			for (std::uint32_t x = 0; x < size; ++x)
+			{
+				const std::uint32_t a = y * (size + 1) + x, b = a + 1, c = a + size + 1, d = c + 1;
+				grid.indices.insert(grid.indices.end(), { a, c, b, b, c, d });
+			}
+		}
+
+		const std::size_t triangle_count = grid.indices.size() / 3;
+		std::vector<std::uint32_t> triangle_order(triangle_count);
+		std::iota(triangle_order.begin(), triangle_order.end(), 0U);
+		std::shuffle(triangle_order.begin(), triangle_order.end(), random);
+
+		std::vector<std::uint32_t> vertex_order(grid.vertices.size());
+		std::iota(vertex_order.begin(), vertex_order.end(), 0U);
+		std::shuffle(vertex_order.begin(), vertex_order.end(), random);
+
+		Mesh result{ std::vector<Vertex>(grid.vertices.size()), std::vector<std::uint32_t>(grid.indices.size()) };
+		for (std::size_t i = 0; i < grid.vertices.size(); ++i)
+		{
+			result.vertices[vertex_order[i]] = grid.vertices[i];
+		}
+
+		for (std::size_t t = 0; t < triangle_count; ++t)
+		{
+			for (std::size_t k = 0; k < 3; ++k)
+			{
+				result.indices[t * 3 + k] = vertex_order[grid.indices[triangle_order[t] * 3 + k]];
+			}
+		}
+
+		return result;
+	}
+
+	// The triangles by the ids of their vertices, rotated so the winding is kept, in a canonical order
+	[[nodiscard]]
+	std::vector<Triangle> GetTriangles(const std::vector<std::uint32_t>& indices, const std::vector<Vertex>& vertices)
+	{
+		std::vector<Triangle> result{};
+
+		for (std::size_t t = 0; t < indices.size() / 3; ++t)
+		{
+			Triangle triangle{ vertices[indices[t * 3]].id, vertices[indices[t * 3 + 1]].id, vertices[indices[t * 3 + 2]].id };
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+
+			result.push_back(triangle);
+		}
+
+		std::sort(result.begin(), result.end());
+
+		return result;
+	}
+
+	[[nodiscard]]
+	std::span<std::byte> GetBytes(std::vector<Vertex>& vertices) noexcept
+	{
+		return std::as_writable_bytes(std::span{ vertices });
+	}
+}
+
+TEST(MeshOptimizer, VertexCacheLowersTheMissRatio)
+{
+	for (const std::uint32_t size : { 8U, 40U, 120U })
+	{
+		Mesh mesh = MakeShuffledSphere(size, size);
+		const std::vector<Triangle> triangles = GetTriangles(mesh.indices, mesh.vertices);
+
+		const gl::mesh::CacheStatistics before = gl::mesh::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+		gl::mesh::OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+		const gl::mesh::CacheStatistics after = gl::mesh::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+		EXPECT_EQ(triangles, GetTriangles(mesh.indices, mesh.vertices)) << size;
+		EXPECT_EQ(before.triangles, after.triangles);
+		EXPECT_EQ(before.vertices, after.vertices);
+
+		// A shuffled list misses almost every vertex, a regular grid gets close to one per two triangles
+		EXPECT_GT(before.acmr, 2.0) << size;
+		EXPECT_LT(after.acmr, 0.85) << size;
+		EXPECT_LT(after.atvr, before.atvr) << size;
+	}
+}
+
+TEST(MeshOptimizer, OverdrawKeepsTheTrianglesAndTheCacheEfficiency)
+{
+	Mesh mesh = MakeShuffledSphere(60, 5);
+	const std::vector<Triangle> triangles = GetTriangles(mesh.indices, mesh.vertices);
+
+	gl::mesh::OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+	const double cache_acmr = gl::mesh::AnalyzeVertexCache(mesh.indices, mesh.vertices.size()).acmr;
+
+	gl::mesh::OptimizeOverdraw(mesh.indices, GetBytes(mesh.vertices), sizeof(Vertex), 0, 1.05f);
+	const double overdraw_acmr = gl::mesh::AnalyzeVertexCache(mesh.indices, mesh.vertices.size()).acmr;
+
+	EXPECT_EQ(triangles, GetTriangles(mesh.indices, mesh.vertices));
+	// Clusters are only cut where they stay under the threshold, their joints cost a few misses
+	EXPECT_LT(overdraw_acmr, cache_acmr * 1.05 + 0.05);
+}
+
+TEST(MeshOptimizer, VertexFetchRemapsEveryIndex)
+{
+	Mesh mesh = MakeShuffledSphere(30, 7);
+
+	// Unreferenced vertices go away
+	mesh.vertices.push_back(Vertex{ { 9, 9, 9 }, {}, 1000000 });
+	mesh.vertices.insert(mesh.vertices.begin(), Vertex{ { 8, 8, 8 }, {}, 1000001 });
+	for (std::uint32_t& index : mesh.indices)
+	{
+		++index;
+	}
+
+	const std::vector<Triangle> triangles = GetTriangles(mesh.indices, mesh.vertices);
+	const std::size_t referenced = mesh.vertices.size() - 2;
+
+	const std::size_t count = gl::mesh::OptimizeVertexFetch(mesh.indices, GetBytes(mesh.vertices), sizeof(Vertex));
+	ASSERT_EQ(referenced, count);
+	mesh.vertices.resize(count);
+
+	// Every index points at the same vertex as before
+	EXPECT_EQ(triangles, GetTriangles(mesh.indices, mesh.vertices));
+
+	// The vertices come in the order of their first use
+	std::uint32_t next = 0;
+	for (const std::uint32_t index : mesh.indices)
+	{
+		ASSERT_LE(index, next);
+		if (index == next)
+		{
+			++next;
+		}
+	}
+	EXPECT_EQ(count, next);
+
+	for (const Vertex& vertex : mesh.vertices)
+	{
+		EXPECT_LT(vertex.id, 1000000U);
+	}
+}
+
+TEST(MeshOptimizer, PipelineImprovesEveryStatistic)
+{
+	Mesh mesh = MakeShuffledSphere(100, 11);
+	const std::vector<Triangle> triangles = GetTriangles(mesh.indices, mesh.vertices);
+
+	const gl::mesh::CacheStatistics cache_before = gl::mesh::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+	const gl::mesh::FetchStatistics fetch_before = gl::mesh::AnalyzeVertexFetch(mesh.indices, mesh.vertices.size(), sizeof(Vertex));
+
+	const std::size_t count = gl::mesh::Optimize(mesh.indices, GetBytes(mesh.vertices), sizeof(Vertex));
+	ASSERT_EQ(mesh.vertices.size(), count);
+
+	const gl::mesh::CacheStatistics cache_after = gl::mesh::AnalyzeVertexCache(mesh.indices, count);
+	const gl::mesh::FetchStatistics fetch_after = gl::mesh::AnalyzeVertexFetch(mesh.indices, count, sizeof(Vertex));
+
+	EXPECT_EQ(triangles, GetTriangles(mesh.indices, mesh.vertices));
+	EXPECT_LT(cache_after.acmr, cache_before.acmr * 0.5);
+	// The shuffled vertices fetch a line for almost every vertex they transform
+	EXPECT_LT(fetch_after.overfetch, fetch_before.overfetch * 0.25);
+}
+
+TEST(MeshOptimizer, LeavesInvalidListsAlone)
+{
+	std::vector<std::uint32_t> out_of_range{ 0, 5, 1, 0, 1, 2 };
+	const std::vector<std::uint32_t> original = out_of_range;
+	std::vector<Vertex> vertices(3);
+
+	gl::mesh::OptimizeVertexCache(out_of_range, 3);
+	EXPECT_EQ(original, out_of_range);
+
+	EXPECT_EQ(3U, gl::mesh::OptimizeVertexFetch(out_of_range, GetBytes(vertices), sizeof(Vertex)));
+	EXPECT_EQ(original, out_of_range);
+
+	EXPECT_EQ(0U, gl::mesh::Optimize(out_of_range, GetBytes(vertices), 0));
+	EXPECT_EQ(0U, gl::mesh::AnalyzeVertexCache(out_of_range, 3).triangles);
+}
+
+TEST(MeshOptimizer, AnalyzesAKnownStrip)
+{
+	// Four triangles of a strip share two vertices with the previous one
+	const std::vector<std::uint32_t> strip{ 0, 1, 2, 2, 1, 3, 2, 3, 4, 4, 3, 5 };
+
+	const gl::mesh::CacheStatistics statistics = gl::mesh::AnalyzeVertexCache(strip, 6);
+	EXPECT_EQ(4U, statistics.triangles);
+	EXPECT_EQ(6U, statistics.vertices);
+	EXPECT_EQ(6U, statistics.misses);
+	EXPECT_DOUBLE_EQ(1.5, statistics.acmr);
+	EXPECT_DOUBLE_EQ(1.0, statistics.atvr);
+
+	// A cache of three entries evicts the vertex zero right before the last triangle needs it
+	const std::vector<std::uint32_t> fan{ 0, 1, 2, 0, 2, 3, 0, 3, 4 };
+	EXPECT_EQ(5U, gl::mesh::AnalyzeVertexCache(fan, 5, 16).misses);
+	EXPECT_EQ(6U, gl::mesh::AnalyzeVertexCache(fan, 5, 3).misses);
+}
+
+TEST(MeshOptimizer, FitsShortIndicesBelowTheRestartIndex)
+{
+	const std::vector<std::uint32_t> fits{ 0, 1, std::numeric_limits<std::uint16_t>::max() - 1U };
+	const std::vector<std::uint32_t> restart{ 0, 1, std::numeric_limits<std::uint16_t>::max() };
+	const std::vector<std::uint32_t> wide{ 0, 1, 1U << 20 };
+
+	EXPECT_TRUE(gl::mesh::FitsShortIndices(fits));
+	EXPECT_FALSE(gl::mesh::FitsShortIndices(restart));
+	EXPECT_FALSE(gl::mesh::FitsShortIndices(wide));
+	EXPECT_TRUE(gl::mesh::FitsShortIndices({}));
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include "Glib.Parallel.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(ParallelFor, VisitsEveryIndexOnce)
+{
+	for (const std::uint32_t threads : { 1U, 2U, 3U, 8U })
+	{
+		for (const std::uint32_t count : { 0U, 1U, 5U, 1000U })
+		{
+			std::vector<std::atomic<std::uint32_t>> visits(count);
+
+			gl::ParallelFor(threads, count, [&](std::uint32_t index, std::uint32_t) {
+				++visits[index];
+			});
+
+			for (std::uint32_t i = 0; i < count; ++i)
+			{
+				ASSERT_EQ(1U, visits[i].load()) << threads << " threads, " << count << " indices";
+			}
+		}
+	}
+}
+
+TEST(ParallelFor, HandsOutDistinctWorkersBelowTheCount)
+{
+	std::mutex mutex{};
+	std::set<std::uint32_t> workers{};
+	std::set<std::thread::id> ids{};
+
+	gl::ParallelFor(4, 400, [&](std::uint32_t, std::uint32_t worker) {
+		std::this_thread::sleep_for(std::chrono::microseconds{ 50 });
+
+		std::lock_guard lock{ mutex };
+		workers.insert(worker);
+		ids.insert(std::this_thread::get_id());
+	});
+
+	ASSERT_FALSE(workers.empty());
+	EXPECT_LT(*workers.rbegin(), 4U);
+	EXPECT_EQ(0U, *workers.begin());
+	// One thread per worker index
+	EXPECT_EQ(workers.size(), ids.size());
+}
+
+TEST(ParallelFor, RunsOnTheCallerWithOneWorker)
+{
+	const std::thread::id caller = std::this_thread::get_id();
+	std::vector<std::uint32_t> order{};
+
+	gl::ParallelFor(1, 16, [&](std::uint32_t index, std::uint32_t worker) {
+		EXPECT_EQ(caller, std::this_thread::get_id());
+		EXPECT_EQ(0U, worker);
+		order.push_back(index);
+	});
+
+	ASSERT_EQ(16U, order.size());
+	for (std::uint32_t i = 0; i < 16; ++i)
+	{
+		EXPECT_EQ(i, order[i]);
+	}
+}
+
+TEST(WorkerPool, KeepsItsThreadsBetweenLoops)
+{
+	gl::WorkerPool pool{};
+
+	for (int loop = 0; loop < 100; ++loop)
+	{
+		std::atomic<std::uint32_t> sum{ 0 };
+		pool.Run(4, 64, [](void* context, std::uint32_t index, std::uint32_t) {
+			*static_cast<std::atomic<std::uint32_t>*>(context) += index;
+		}, &sum);
+
+		ASSERT_EQ(64U * 63U / 2U, sum.load());
+		ASSERT_EQ(3U, pool.GetThreadCount());
+	}
+
+	// Smaller loops reuse the same threads, larger ones add the missing ones
+	pool.Run(2, 8, [](void*, std::uint32_t, std::uint32_t) {}, nullptr);
+	EXPECT_EQ(3U, pool.GetThreadCount());
+
+	pool.Run(6, 8, [](void*, std::uint32_t, std::uint32_t) {}, nullptr);
+	EXPECT_EQ(5U, pool.GetThreadCount());
+}
+
+TEST(WorkerPool, RunsNestedLoopsOnTheirCaller)
+{
+	std::vector<std::atomic<std::uint32_t>> visits(8 * 8);
+
+	gl::ParallelFor(4, 8, [&](std::uint32_t outer, std::uint32_t) {
+		const std::thread::id caller = std::this_thread::get_id();
+
+		gl::ParallelFor(4, 8, [&](std::uint32_t inner, std::uint32_t worker) {
+			EXPECT_EQ(caller, std::this_thread::get_id());
+			EXPECT_EQ(0U, worker);
+			++visits[outer * 8 + inner];
+		});
+	});
+
+	for (const std::atomic<std::uint32_t>& visit : visits)
+	{
+		EXPECT_EQ(1U, visit.load());
+	}
+}
+
+TEST(WorkerPool, RethrowsTheFirstException)
+{
+	std::atomic<std::uint32_t> calls{ 0 };
+
+	EXPECT_THROW(gl::ParallelFor(4, 10000, [&](std::uint32_t index, std::uint32_t) {
+		++calls;
+		if (100 == index)
+		{
+			throw std::runtime_error{ "task" };
+		}
+	}), std::runtime_error);
+
+	// The workers stopped early, and the pool still runs loops afterwards
+	EXPECT_LT(calls.load(), 10000U);
+
+	std::atomic<std::uint32_t> after{ 0 };
+	gl::ParallelFor(4, 100, [&](std::uint32_t, std::uint32_t) {
+		++after;
+	});
+	EXPECT_EQ(100U, after.load());
+}
+
+TEST(WorkerPool, SerialisesLoopsFromSeveralThreads)
+{
+	std::atomic<std::uint64_t> sum{ 0 };
+
+	std::vector<std::thread> callers{};
+	for (int caller = 0; caller < 4; ++caller)
+	{
+		callers.emplace_back([&]() {
+			for (int loop = 0; loop < 50; ++loop)
+			{
+				gl::ParallelFor(3, 100, [&](std::uint32_t index, std::uint32_t worker) {
+					EXPECT_LT(worker, 3U);
+					sum += index;
+				});
+			}
+		});
+	}
+
+	for (std::thread& caller : callers)
+	{
+		caller.join();
+	}
+
+	EXPECT_EQ(4U * 50U * (100U * 99U / 2U), sum.load());
+}
@@ -0,0 +1,383 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "Glib.hpp"
+#include "Glib.Particles.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Particles told apart by their x, which is the order they were spawned in
+	[[nodiscard]]
+	gl::particle::Pool
+	MakePool(std::size_t count, std::uint32_t seed)
+	{
+		std::mt19937 engine{ seed };
+		std::uniform_real_distribution<float> velocity{ -10.0f, 10.0f };
+		std::uniform_real_distribution<float> lifetime{ 0.5f, 4.0f };
+		std::uniform_real_distribution<float> size{ 0.5f, 3.0f };
+		std::uniform_real_distribution<float> life{ 0.0f, 1.5f };
+
+		gl::particle::Pool pool{ count };
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const float seconds = lifetime(engine);
+			EXPECT_TRUE(pool.Spawn(gl::particle::Particle{ static_cast<float>(i), 1, 2, velocity(engine), velocity(engine), velocity(engine), seconds, size(engine) }));
+
+			// Some already past their lifetime
+			pool.age[i] = life(engine) * seconds;
+		}
+
+		return pool;
+	}
+
+	void
+	ExpectSameFields(const gl::particle::Pool& expected, const gl::particle::Pool& actual)
+	{
+		ASSERT_EQ(expected.count, actual.count);
+
+		for (std::size_t i = 0; i < expected.count; ++i)
+		{
+			ASSERT_EQ(expected.x[i], actual.x[i]) << i;
+			ASSERT_EQ(expected.y[i], actual.y[i]) << i;
+			ASSERT_EQ(expected.z[i], actual.z[i]) << i;
+			ASSERT_EQ(expected.vx[i], actual.vx[i]) << i;
+			ASSERT_EQ(expected.vy[i], actual.vy[i]) << i;
+			ASSERT_EQ(expected.vz[i], actual.vz[i]) << i;
+			ASSERT_EQ(expected.age[i], actual.age[i]) << i;
+			ASSERT_EQ(expected.inverseLifetime[i], actual.inverseLifetime[i]) << i;
+			ASSERT_EQ(expected.size[i], actual.size[i]) << i;
+		}
+	}
+
+	[[nodiscard]]
+	gl::particle::Emitter
+	MakeEmitter(float x, float rate)
+	{
+		gl::particle::Emitter emitter{};
+		emitter.position = { x, 0, 0 };
+		emitter.spread = { 0, 0, 0 };
+		emitter.rate = rate;
+		emitter.minLifetime = emitter.maxLifetime = 100;
+
+		return emitter;
+	}
+
+	[[nodiscard]]
+	std::size_t
+	CountAt(const gl::particle::Pool& pool, std::size_t begin, std::size_t end, float x)
+	{
+		return static_cast<std::size_t>(std::count(pool.x.begin() + begin, pool.x.begin() + end, x));
+	}
+}
+
+TEST(ParticlePool, SpawnsUntilFull)
+{
+	gl::particle::Pool pool{ 3 };
+	EXPECT_EQ(3U, pool.GetCapacity());
+
+	EXPECT_TRUE(pool.Spawn(gl::particle::Particle{ 1, 2, 3, 4, 5, 6, 0.5f, 2 }));
+	EXPECT_TRUE(pool.Spawn(gl::particle::Particle{}));
+	// A lifetime of zero dies on the first update instead of dividing by zero
+	EXPECT_TRUE(pool.Spawn(gl::particle::Particle{ 0, 0, 0, 0, 0, 0, 0, 1 }));
+	EXPECT_FALSE(pool.Spawn(gl::particle::Particle{}));
+	EXPECT_EQ(3U, pool.GetSize());
+
+	EXPECT_EQ(3.0f, pool.z[0]);
+	EXPECT_EQ(6.0f, pool.vz[0]);
+	EXPECT_EQ(0.0f, pool.age[0]);
+	EXPECT_EQ(2.0f, pool.inverseLifetime[0]);
+	EXPECT_EQ(2.0f, pool.size[0]);
+	EXPECT_EQ(1e6f, pool.inverseLifetime[2]);
+
+	pool.Clear();
+	EXPECT_EQ(0U, pool.GetSize());
+	EXPECT_TRUE(pool.Spawn(gl::particle::Particle{}));
+}
+
+TEST(ParticlePool, KillMovesTheLastParticleIn)
+{
+	gl::particle::Pool pool = MakePool(5, 1);
+
+	pool.Kill(1);
+	ASSERT_EQ(4U, pool.GetSize());
+	EXPECT_EQ(4.0f, pool.x[1]);
+	// Every field follows
+	EXPECT_EQ(pool.vx[4], pool.vx[1]);
+	EXPECT_EQ(pool.age[4], pool.age[1]);
+	EXPECT_EQ(pool.inverseLifetime[4], pool.inverseLifetime[1]);
+
+	// The last one only goes away
+	pool.Kill(3);
+	ASSERT_EQ(3U, pool.GetSize());
+	EXPECT_EQ((std::vector<float>{ 0, 4, 2 }), std::vector<float>(pool.x.begin(), pool.x.begin() + 3));
+
+	pool.Kill(3);
+	EXPECT_EQ(3U, pool.GetSize());
+}
+
+TEST(ParticlePool, RemoveDeadKeepsEveryLivingParticle)
+{
+	for (const std::size_t count : { 0U, 1U, 3U, 4U, 7U, 13U, 64U, 257U })
+	{
+		gl::particle::Pool pool = MakePool(count, static_cast<std::uint32_t>(count));
+
+		// Dead at the end and in a row, which moves a dead particle into the place of another
+		if (4 <= count)
+		{
+			pool.age[count - 1] = pool.age[count - 2] = pool.age[1] = 10;
+		}
+
+		std::vector<float> living{};
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (pool.age[i] * pool.inverseLifetime[i] < 1.0f)
+			{
+				living.push_back(pool.x[i]);
+			}
+		}
+
+		EXPECT_EQ(count - living.size(), pool.RemoveDead()) << count;
+		ASSERT_EQ(living.size(), pool.GetSize());
+
+		std::vector<float> remaining(pool.x.begin(), pool.x.begin() + pool.count);
+		std::ranges::sort(remaining);
+		EXPECT_EQ(living, remaining) << count;
+
+		EXPECT_EQ(0U, pool.RemoveDead());
+	}
+}
+
+TEST(ParticleSimulation, SimdIntegrationMatchesTheScalarOne)
+{
+	// A drag over one per step would turn the velocities around without the clamp
+	for (const gl::particle::Forces forces : { gl::particle::Forces{}, gl::particle::Forces{ { 1, -9.8f, 3 }, 0.5f }, gl::particle::Forces{ { 0, 0, 0 }, 90.0f } })
+	{
+		for (const std::size_t count : { 1U, 2U, 3U, 4U, 5U, 6U, 7U, 9U, 103U })
+		{
+			for (const std::size_t begin : { 0U, 1U })
+			{
+				gl::particle::Pool simd = MakePool(count + 3, 5);
+				gl::particle::Pool scalar = MakePool(count + 3, 5);
+
+				gl::particle::Integrate(simd, begin, begin + count, 1.0f / 60, forces);
+				gl::particle::IntegrateScalar(scalar, begin, begin + count, 1.0f / 60, forces);
+
+				// Including the particles out of the range, which are left alone
+				ExpectSameFields(scalar, simd);
+				EXPECT_EQ(MakePool(count + 3, 5).x[begin + count], simd.x[begin + count]);
+			}
+		}
+	}
+}
+
+TEST(ParticleSimulation, InstancesAreLaidOutLikeTheScalarOnes)
+{
+	gl::particle::Gradient gradient{};
+	gradient.begin = { 1, 0, 0.25f, 1 };
+	gradient.end = { 0, 1, 1, 0 };
+	gradient.endSize = 3;
+
+	for (const std::size_t count : { 1U, 3U, 4U, 5U, 8U, 11U, 130U })
+	{
+		for (const std::size_t begin : { 0U, 2U })
+		{
+			const gl::particle::Pool pool = MakePool(begin + count, 9);
+
+			constexpr gl::particle::Instance Untouched{ -1, -1, -1, -1, 0xDEADBEEFU };
+			std::vector<gl::particle::Instance> simd(count + 1, Untouched);
+			std::vector<gl::particle::Instance> scalar(count + 1, Untouched);
+
+			gl::particle::WriteInstances(pool, begin, begin + count, gradient, simd.data());
+			// One at a time, as the ranges shorter than the SIMD width are written by the scalar code
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				gl::particle::WriteInstances(pool, begin + i, begin + i + 1, gradient, scalar.data() + i);
+			}
+
+			for (std::size_t i = 0; i <= count; ++i)
+			{
+				ASSERT_EQ(scalar[i].x, simd[i].x) << count << ", " << i;
+				ASSERT_EQ(scalar[i].y, simd[i].y) << count << ", " << i;
+				ASSERT_EQ(scalar[i].z, simd[i].z) << count << ", " << i;
+				ASSERT_EQ(scalar[i].size, simd[i].size) << count << ", " << i;
+				ASSERT_EQ(scalar[i].colour, simd[i].colour) << count << ", " << i;
+			}
+
+			EXPECT_EQ(Untouched.colour, simd[count].colour);
+		}
+	}
+}
+
+TEST(ParticleSimulation, InstancesFollowTheGradient)
+{
+	gl::particle::Pool pool{ 8 };
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		ASSERT_TRUE(pool.Spawn(gl::particle::Particle{ static_cast<float>(i), 10, 20, 0, 0, 0, 2, 4 }));
+	}
+
+	// Half way for the first four, past the end for the others
+	std::fill_n(pool.age.begin(), 4, 1.0f);
+	std::fill_n(pool.age.begin() + 4, 4, 5.0f);
+
+	gl::particle::Gradient gradient{};
+	gradient.begin = { 1, 0, 0, 1 };
+	gradient.end = { 0, 0, 1, 0 };
+	gradient.endSize = 0.5f;
+
+	gl::particle::Instance instances[8]{};
+	gl::particle::WriteInstances(pool, 0, 8, gradient, instances);
+
+	EXPECT_EQ(2.0f, instances[2].x);
+	EXPECT_EQ(10.0f, instances[2].y);
+	EXPECT_EQ(20.0f, instances[2].z);
+	EXPECT_EQ(3.0f, instances[2].size);
+	// Red in the lowest byte, a half rounded to the nearest even
+	EXPECT_EQ(0x80800080U, instances[2].colour);
+
+	EXPECT_EQ(2.0f, instances[6].size);
+	EXPECT_EQ(0x00FF0000U, instances[6].colour);
+}
+
+TEST(ParticleSystem, EmittersFillTheirOwnRanges)
+{
+	gl::ParticleSystem system{ 100, 4 };
+	system.SetForces(gl::particle::Forces{ { 0, 0, 0 }, 0 });
+
+	const gl::particle::EmitterId first = system.AddEmitter(MakeEmitter(1, 10));
+	const gl::particle::EmitterId second = system.AddEmitter(MakeEmitter(2, 20));
+	gl::particle::Emitter inactive = MakeEmitter(3, 1000);
+	inactive.isActive = false;
+	system.AddEmitter(inactive);
+
+	system.Update(1);
+
+	const gl::particle::Pool& pool = system.GetPool();
+	EXPECT_EQ(30U, system.GetStatistics().spawned);
+	EXPECT_EQ(0U, system.GetStatistics().dropped);
+	ASSERT_EQ(30U, system.GetSize());
+	EXPECT_EQ(10U, CountAt(pool, 0, 10, 1));
+	EXPECT_EQ(20U, CountAt(pool, 10, 30, 2));
+
+	// The first emitters get their particles, the last one what is left
+	system.GetEmitter(first).rate = 50;
+	system.GetEmitter(second).rate = 50;
+	system.Update(1);
+
+	EXPECT_EQ(70U, system.GetStatistics().spawned);
+	EXPECT_EQ(30U, system.GetStatistics().dropped);
+	EXPECT_EQ(100U, system.GetStatistics().alive);
+	EXPECT_EQ(50U, CountAt(pool, 30, 80, 1));
+	EXPECT_EQ(20U, CountAt(pool, 80, 100, 2));
+
+	// A full pool drops everything
+	system.Update(1);
+	EXPECT_EQ(0U, system.GetStatistics().spawned);
+	EXPECT_EQ(100U, system.GetStatistics().dropped);
+}
+
+TEST(ParticleSystem, RatesCarryTheirFractions)
+{
+	gl::ParticleSystem system{ 100, 1 };
+	system.AddEmitter(MakeEmitter(0, 2.5f));
+
+	system.Update(1);
+	EXPECT_EQ(2U, system.GetStatistics().spawned);
+	system.Update(1);
+	EXPECT_EQ(3U, system.GetStatistics().spawned);
+	EXPECT_EQ(5U, system.GetSize());
+}
+
+TEST(ParticleSystem, KillsAndGivesTheSameParticlesOnAnyThreadCount)
+{
+	const auto simulate = [](std::uint32_t threads) {
+		gl::ParticleSystem system{ 1U << 16, threads };
+
+		for (std::uint32_t i = 0; i < 5; ++i)
+		{
+			gl::particle::Emitter emitter = MakeEmitter(static_cast<float>(i), 3000);
+			emitter.minLifetime = 0.2f;
+			emitter.maxLifetime = 0.6f;
+			emitter.seed = i + 1;
+			system.AddEmitter(emitter);
+		}
+
+		std::uint64_t killed = 0;
+		for (std::uint32_t frame = 0; frame < 30; ++frame)
+		{
+			system.Update(1.0f / 30);
+			killed += system.GetStatistics().killed;
+		}
+
+		EXPECT_NE(0U, killed);
+		EXPECT_EQ(system.GetSize(), system.GetStatistics().alive);
+
+		return gl::particle::Pool{ system.GetPool() };
+	};
+
+	ExpectSameFields(simulate(1), simulate(4));
+}
+
+TEST(ParticleRenderer, DrawRestoresTheBindings)
+{
+	glstub::Reset();
+
+	gl::ParticleSystem system{ 1000, 2 };
+	system.AddEmitter(MakeEmitter(1, 300));
+	system.Update(1);
+	ASSERT_EQ(300U, system.GetSize());
+
+	gl::ParticleRenderer renderer{};
+	ASSERT_TRUE(renderer.Create());
+
+	// Bound by the caller before the particles are drawn
+	glstub::State& state = glstub::GetState();
+	state.integers[GL_CURRENT_PROGRAM] = { 77 };
+	state.integers[GL_VERTEX_ARRAY_BINDING] = { 88 };
+	state.integers[GL_ARRAY_BUFFER_BINDING] = { 99 };
+	state.booleans[GL_DEPTH_WRITEMASK] = { GL_TRUE };
+
+	const std::array<float, 16> identity{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	EXPECT_EQ(300U, renderer.Draw(system, identity, identity));
+
+	const std::vector<glstub::Call> draws = glstub::FindCalls("glDrawArraysInstanced");
+	ASSERT_EQ(1U, draws.size());
+	EXPECT_EQ((std::vector<std::int64_t>{ GL_TRIANGLE_STRIP, 0, 4, 300 }), draws[0].args);
+
+	EXPECT_EQ(77, state.integers[GL_CURRENT_PROGRAM][0]);
+	EXPECT_EQ(88, state.integers[GL_VERTEX_ARRAY_BINDING][0]);
+	EXPECT_EQ(99, state.integers[GL_ARRAY_BUFFER_BINDING][0]);
+	EXPECT_EQ(GL_TRUE, state.booleans[GL_DEPTH_WRITEMASK][0]);
+
+	// Written straight into the mapping
+	std::vector<gl::particle::Instance> expected(300);
+	ASSERT_EQ(300U, system.WriteInstances(expected));
+
+	const std::vector<glstub::Call> maps = glstub::FindCalls("glMapBufferRange");
+	ASSERT_EQ(1U, maps.size());
+	EXPECT_EQ(static_cast<std::int64_t>(300 * sizeof(gl::particle::Instance)), maps[0].args[2]);
+
+	GLuint instance_buffer = 0;
+	for (const glstub::Call& bind : glstub::FindCalls("glBindBuffer"))
+	{
+		if (GL_ARRAY_BUFFER == bind.args[0] && 99 != bind.args[1] && 0 != bind.args[1])
+		{
+			instance_buffer = static_cast<GLuint>(bind.args[1]);
+		}
+	}
+
+	const std::vector<std::uint8_t>& written = state.buffers[instance_buffer];
+	ASSERT_LE(expected.size() * sizeof(gl::particle::Instance), written.size());
+	EXPECT_EQ(0, std::memcmp(expected.data(), written.data(), expected.size() * sizeof(gl::particle::Instance)));
+
+	// Nothing to draw leaves everything alone
+	system.Clear();
+	const std::size_t calls = state.calls.size();
+	EXPECT_EQ(0U, renderer.Draw(system, identity, identity));
+	EXPECT_EQ(calls, state.calls.size());
+}
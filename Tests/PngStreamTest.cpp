@@ -0,0 +1,323 @@
+#include <gtest/gtest.h>
+#include "fpng.h"
+#include "Glib.Png.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct Image
+	{
+		std::size_t width, height, channels;
+		std::vector<std::uint8_t> pixels;
+		std::vector<std::uint8_t> file;
+	};
+
+	[[nodiscard]]
+	Image MakeImage(const std::size_t& width, const std::size_t& height, const std::size_t& channels, const std::uint32_t& seed)
+	{
+		std::mt19937 random{ seed };
+
+		Image result{ width, height, channels, std::vector<std::uint8_t>(width * height * channels), {} };
+		for (std::size_t i = 0; i < result.pixels.size(); ++i)
+		{
+			// Smooth enough for the matches, noisy enough for the literals
+			result.pixels[i] = static_cast<std::uint8_t>(i / channels % 97 + (random() % 4));
+		}
+
+		fpng::fpng_init();
+		EXPECT_TRUE(fpng::fpng_encode_image_to_memory(result.pixels.data(), width, height, channels, result.file));
+
+		return result;
+	}
+
+	// Hands out the file in pieces of a random size, down to single bytes
+	struct Reader
+	{
+		const std::vector<std::uint8_t>& file;
+		std::size_t position;
+		std::size_t maxPiece;
+		std::mt19937 random;
+
+		static std::size_t Read(void* user, void* dst, std::size_t size)
+		{
+			Reader& self = *static_cast<Reader*>(user);
+
+			const std::size_t piece = 1 + self.random() % self.maxPiece;
+			const std::size_t count = std::min({ size, piece, self.file.size() - self.position });
+
+			if (0 < count)
+			{
+				std::memcpy(dst, self.file.data() + self.position, count);
+				self.position += count;
+			}
+
+			return count;
+		}
+	};
+
+	struct Sink
+	{
+		std::vector<std::uint8_t> pixels;
+		std::size_t rows = 0;
+		bool inOrder = true;
+		std::size_t abortAt = static_cast<std::size_t>(-1);
+
+		static bool Write(void* user, const std::uint8_t* row, std::size_t y, std::size_t width, std::size_t height, std::size_t channels)
+		{
+			Sink& self = *static_cast<Sink*>(user);
+
+			if (y != self.rows || height <= y)
+			{
+				self.inOrder = false;
+				return false;
+			}
+
+			if (y == self.abortAt)
+			{
+				return false;
+			}
+
+			self.pixels.resize(width * height * channels);
+			std::memcpy(self.pixels.data() + y * width * channels, row, width * channels);
+			++self.rows;
+
+			return true;
+		}
+	};
+
+	struct StreamResult
+	{
+		int status;
+		Sink sink;
+	};
+
+	[[nodiscard]]
+	StreamResult DecodeStream(const std::vector<std::uint8_t>& file, const std::size_t& channels, const std::size_t& max_piece, const std::uint32_t& seed, const std::size_t& abort_at = static_cast<std::size_t>(-1))
+	{
+		Reader reader{ file, 0, max_piece, std::mt19937{ seed } };
+
+		StreamResult result{};
+		result.sink.abortAt = abort_at;
+
+		std::size_t width = 0, height = 0, file_channels = 0;
+		result.status = fpng::fpng_decode_stream(Reader::Read, &reader, Sink::Write, &result.sink, width, height, file_channels, channels);
+
+		return result;
+	}
+
+	[[nodiscard]]
+	std::uint32_t Crc32(const std::uint8_t* data, const std::size_t& size) noexcept
+	{
+		std::uint32_t crc = 0xFFFFFFFFU;
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+			}
+		}
+
+		return ~crc;
+	}
+
+	// Offset and length of the data of the first IDAT chunk
+	[[nodiscard]]
+	std::pair<std::size_t, std::size_t> FindIdat(const std::vector<std::uint8_t>& file)
+	{
+		std::size_t offset = 8;
+		while (offset + 12 <= file.size())
+		{
+			const std::size_t length = std::size_t{ file[offset] } << 24 | std::size_t{ file[offset + 1] } << 16 | std::size_t{ file[offset + 2] } << 8 | file[offset + 3];
+			if (0 == std::memcmp(file.data() + offset + 4, "IDAT", 4))
+			{
+				return { offset + 8, length };
+			}
+
+			offset += 12 + length;
+		}
+
+		return { 0, 0 };
+	}
+
+	void FixIdatCrc(std::vector<std::uint8_t>& file, const std::size_t& data, const std::size_t& length)
+	{
+		const std::uint32_t crc = Crc32(file.data() + data - 4, length + 4);
+
+		file[data + length + 0] = static_cast<std::uint8_t>(crc >> 24);
+		file[data + length + 1] = static_cast<std::uint8_t>(crc >> 16);
+		file[data + length + 2] = static_cast<std::uint8_t>(crc >> 8);
+		file[data + length + 3] = static_cast<std::uint8_t>(crc);
+	}
+}
+
+TEST(HasPngExtension, IgnoresCase)
+{
+	EXPECT_TRUE(gl::png::HasPngExtension("image.png"));
+	EXPECT_TRUE(gl::png::HasPngExtension("image.PNG"));
+	EXPECT_TRUE(gl::png::HasPngExtension("image.Png"));
+	EXPECT_TRUE(gl::png::HasPngExtension("dir/archive.tar.pNg"));
+}
+
+TEST(HasPngExtension, RejectsOtherNames)
+{
+	EXPECT_FALSE(gl::png::HasPngExtension(""));
+	EXPECT_FALSE(gl::png::HasPngExtension("png"));
+	EXPECT_FALSE(gl::png::HasPngExtension(".png"));
+	EXPECT_FALSE(gl::png::HasPngExtension("dir/.png"));
+	EXPECT_FALSE(gl::png::HasPngExtension("image.pngx"));
+	EXPECT_FALSE(gl::png::HasPngExtension("image.jpg"));
+	EXPECT_FALSE(gl::png::HasPngExtension("image_png"));
+}
+
+TEST(PngStream, MatchesTheMemoryDecoderForAnyPieceSize)
+{
+	for (const std::size_t channels : { 3U, 4U })
+	{
+		const Image image = MakeImage(301, 67, channels, 1);
+
+		for (const std::size_t max_piece : { 1U, 7U, 4096U, 1U << 20 })
+		{
+			const StreamResult result = DecodeStream(image.file, channels, max_piece, 2);
+
+			ASSERT_EQ(fpng::FPNG_DECODE_SUCCESS, result.status) << max_piece;
+			EXPECT_TRUE(result.sink.inOrder);
+			EXPECT_EQ(image.height, result.sink.rows);
+			EXPECT_EQ(image.pixels, result.sink.pixels);
+		}
+	}
+}
+
+TEST(PngStream, ConvertsChannels)
+{
+	const Image image = MakeImage(16, 9, 3, 3);
+
+	const StreamResult result = DecodeStream(image.file, 4, 64, 4);
+	ASSERT_EQ(fpng::FPNG_DECODE_SUCCESS, result.status);
+
+	for (std::size_t i = 0; i < 16 * 9; ++i)
+	{
+		EXPECT_EQ(image.pixels[i * 3 + 0], result.sink.pixels[i * 4 + 0]);
+		EXPECT_EQ(image.pixels[i * 3 + 2], result.sink.pixels[i * 4 + 2]);
+		EXPECT_EQ(0xFF, result.sink.pixels[i * 4 + 3]);
+	}
+}
+
+TEST(PngStream, StopsWhenTheSinkAborts)
+{
+	const Image image = MakeImage(40, 30, 4, 5);
+
+	const StreamResult result = DecodeStream(image.file, 4, 4096, 6, 10);
+
+	EXPECT_EQ(fpng::FPNG_DECODE_ABORTED, result.status);
+	EXPECT_EQ(10U, result.sink.rows);
+}
+
+TEST(PngStream, ChecksTheIdatCrc)
+{
+	Image image = MakeImage(20, 10, 3, 9);
+	const auto [data, length] = FindIdat(image.file);
+
+	image.file[data + length] ^= 1;
+
+	const StreamResult result = DecodeStream(image.file, 3, 4096, 10);
+	EXPECT_EQ(fpng::FPNG_DECODE_FAILED_HEADER_CRC32, result.status);
+}
+
+TEST(PngStream, FailsOnEveryTruncation)
+{
+	const Image image = MakeImage(64, 48, 3, 7);
+	const std::size_t row_bytes = 64 * 3;
+
+	// Nothing after the crc of the IDAT is read, the IEND may be cut
+	const auto [data, length] = FindIdat(image.file);
+	const std::size_t idat_end = data + length + 4;
+	ASSERT_LT(idat_end, image.file.size());
+
+	for (std::size_t size = 0; size < idat_end; ++size)
+	{
+		const std::vector<std::uint8_t> truncated(image.file.begin(), image.file.begin() + size);
+		const StreamResult result = DecodeStream(truncated, 3, 13, static_cast<std::uint32_t>(size));
+
+		ASSERT_NE(fpng::FPNG_DECODE_SUCCESS, result.status) << size;
+		ASSERT_TRUE(result.sink.inOrder) << size;
+		ASSERT_LT(result.sink.rows, image.height + 1) << size;
+
+		// The rows handed out before the failure are final
+		for (std::size_t y = 0; y < result.sink.rows; ++y)
+		{
+			ASSERT_TRUE(std::equal(image.pixels.begin() + y * row_bytes, image.pixels.begin() + (y + 1) * row_bytes, result.sink.pixels.begin() + y * row_bytes)) << size << " row " << y;
+		}
+	}
+}
+
+TEST(PngStream, SurvivesCorruptDeflateStreams)
+{
+	std::mt19937 random{ 11 };
+
+	for (const std::size_t channels : { 3U, 4U })
+	{
+		const Image image = MakeImage(97, 31, channels, 13);
+		const auto [data, length] = FindIdat(image.file);
+		ASSERT_LT(0U, length);
+
+		for (int iteration = 0; iteration < 3000; ++iteration)
+		{
+			std::vector<std::uint8_t> file = image.file;
+
+			// A valid crc gets the damage past the chunk checks and into the inflater
+			const int flips = 1 + static_cast<int>(random() % 4);
+			for (int i = 0; i < flips; ++i)
+			{
+				file[data + random() % length] ^= static_cast<std::uint8_t>(1U << (random() % 8));
+			}
+			FixIdatCrc(file, data, length);
+
+			const StreamResult result = DecodeStream(file, channels, 1 + random() % 512, random());
+			ASSERT_TRUE(result.sink.inOrder) << iteration;
+
+#ifdef NDEBUG
+			// fpng_decode_memory asserts on some malformed matches in debug builds
+			std::vector<std::uint8_t> memory{};
+			std::size_t width = 0, height = 0, file_channels = 0;
+			const int memory_status = fpng::fpng_decode_memory(file.data(), static_cast<std::uint32_t>(file.size()), memory, width, height, file_channels, static_cast<std::uint32_t>(channels));
+
+			// Both decoders accept the same streams and agree on their pixels
+			ASSERT_EQ(fpng::FPNG_DECODE_SUCCESS == memory_status, fpng::FPNG_DECODE_SUCCESS == result.status) << iteration;
+			if (fpng::FPNG_DECODE_SUCCESS == result.status)
+			{
+				ASSERT_EQ(memory, result.sink.pixels) << iteration;
+			}
+#endif
+		}
+	}
+}
+
+TEST(PngStream, SurvivesRandomBytes)
+{
+	std::mt19937 random{ 17 };
+	const Image image = MakeImage(33, 21, 4, 19);
+
+	for (int iteration = 0; iteration < 3000; ++iteration)
+	{
+		std::vector<std::uint8_t> file = image.file;
+
+		const int changes = 1 + static_cast<int>(random() % 8);
+		for (int i = 0; i < changes; ++i)
+		{
+			file[random() % file.size()] = static_cast<std::uint8_t>(random());
+		}
+		if (0 == random() % 4)
+		{
+			file.resize(random() % file.size());
+		}
+
+		const StreamResult result = DecodeStream(file, 4, 1 + random() % 64, random());
+		ASSERT_TRUE(result.sink.inOrder) << iteration;
+		ASSERT_LE(result.sink.rows, image.height) << iteration;
+	}
+}
@@ -0,0 +1,317 @@
+#include <gtest/gtest.h>
+#include "fpng.h"
+#include "Glib.Png.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const std::filesystem::path SuiteDirectory = std::filesystem::path{ GLIB_TEST_DATA } / "pngsuite";
+
+	struct Reference
+	{
+		std::size_t width, height;
+		std::uint32_t crc;
+	};
+
+	struct Chunk
+	{
+		std::string type;
+		std::vector<std::uint8_t> data;
+	};
+
+	[[nodiscard]]
+	std::vector<std::uint8_t> ReadFile(const std::filesystem::path& path)
+	{
+		std::ifstream stream{ path, std::ios::binary };
+		return std::vector<std::uint8_t>{ std::istreambuf_iterator<char>{ stream }, std::istreambuf_iterator<char>{} };
+	}
+
+	[[nodiscard]]
+	std::map<std::string, Reference> ReadReferences()
+	{
+		std::map<std::string, Reference> result{};
+
+		std::ifstream stream{ SuiteDirectory / "reference.txt" };
+		std::string line{};
+		while (std::getline(stream, line))
+		{
+			if (line.empty() || '#' == line.front())
+			{
+				continue;
+			}
+
+			std::istringstream fields{ line };
+			std::string name{};
+			Reference reference{};
+			fields >> name >> reference.width >> reference.height >> std::hex >> reference.crc;
+
+			result.emplace(name, reference);
+		}
+
+		return result;
+	}
+
+	[[nodiscard]]
+	std::uint32_t ReadBigEndian(const std::uint8_t* data) noexcept
+	{
+		return std::uint32_t{ data[0] } << 24 | std::uint32_t{ data[1] } << 16 | std::uint32_t{ data[2] } << 8 | data[3];
+	}
+
+	void WriteBigEndian(std::vector<std::uint8_t>& output, const std::uint32_t& value)
+	{
+		output.push_back(static_cast<std::uint8_t>(value >> 24));
+		output.push_back(static_cast<std::uint8_t>(value >> 16));
+		output.push_back(static_cast<std::uint8_t>(value >> 8));
+		output.push_back(static_cast<std::uint8_t>(value));
+	}
+
+	[[nodiscard]]
+	std::vector<Chunk> Split(const std::vector<std::uint8_t>& file)
+	{
+		std::vector<Chunk> result{};
+
+		for (std::size_t offset = 8; offset + 12 <= file.size();)
+		{
+			const std::uint32_t length = ReadBigEndian(file.data() + offset);
+
+			Chunk& chunk = result.emplace_back();
+			chunk.type.assign(reinterpret_cast<const char*>(file.data() + offset + 4), 4);
+			chunk.data.assign(file.begin() + offset + 8, file.begin() + offset + 8 + length);
+
+			offset += 12 + length;
+		}
+
+		return result;
+	}
+
+	// Every crc is computed again, so a test only breaks what it means to
+	[[nodiscard]]
+	std::vector<std::uint8_t> Join(const std::vector<Chunk>& chunks)
+	{
+		std::vector<std::uint8_t> result = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+		for (const Chunk& chunk : chunks)
+		{
+			WriteBigEndian(result, static_cast<std::uint32_t>(chunk.data.size()));
+
+			const std::size_t start = result.size();
+			result.insert(result.end(), chunk.type.begin(), chunk.type.end());
+			result.insert(result.end(), chunk.data.begin(), chunk.data.end());
+
+			WriteBigEndian(result, fpng::fpng_crc32(result.data() + start, result.size() - start));
+		}
+
+		return result;
+	}
+
+	[[nodiscard]]
+	gl::png::DecodeResult Decode(const std::vector<std::uint8_t>& file)
+	{
+		std::vector<std::uint8_t> rgba{};
+		std::size_t width = 0, height = 0;
+
+		return gl::png::Decode(file.data(), file.size(), rgba, width, height);
+	}
+
+	[[nodiscard]]
+	std::vector<Chunk> LoadChunks(const char* name)
+	{
+		return Split(ReadFile(SuiteDirectory / name));
+	}
+}
+
+TEST(PngSuite, DecodesEveryImageLikeTheReference)
+{
+	const std::map<std::string, Reference> references = ReadReferences();
+	ASSERT_FALSE(references.empty());
+
+	std::size_t decoded = 0;
+
+	for (const auto& entry : std::filesystem::directory_iterator{ SuiteDirectory })
+	{
+		if (".png" != entry.path().extension())
+		{
+			continue;
+		}
+
+		const std::string name = entry.path().filename().string();
+		SCOPED_TRACE(name);
+
+		const auto reference = references.find(name);
+		ASSERT_NE(reference, references.end()) << "missing from reference.txt";
+
+		const std::vector<std::uint8_t> file = ReadFile(entry.path());
+
+		gl::png::Header header{};
+		ASSERT_EQ(gl::png::DecodeResult::Success, gl::png::ReadHeader(file.data(), file.size(), header));
+		EXPECT_EQ(name.starts_with("basi") || name.ends_with("i.png"), header.interlaced);
+
+		std::vector<std::uint8_t> rgba{};
+		std::size_t width = 0, height = 0;
+		ASSERT_EQ(gl::png::DecodeResult::Success, gl::png::Decode(file.data(), file.size(), rgba, width, height));
+
+		EXPECT_EQ(reference->second.width, width);
+		EXPECT_EQ(reference->second.height, height);
+		ASSERT_EQ(width * height * 4, rgba.size());
+		EXPECT_EQ(reference->second.crc, fpng::fpng_crc32(rgba.data(), rgba.size()));
+
+		++decoded;
+	}
+
+	EXPECT_EQ(references.size(), decoded);
+}
+
+TEST(PngSuite, InterlacedMatchesProgressive)
+{
+	for (const char* suffix : { "0g01", "0g02", "0g04", "0g08", "0g16", "2c08", "2c16", "3p01", "3p02", "3p04", "3p08", "4a08", "4a16", "6a08", "6a16" })
+	{
+		SCOPED_TRACE(suffix);
+
+		const std::vector<std::uint8_t> progressive = ReadFile(SuiteDirectory / ("basn" + std::string{ suffix } + ".png"));
+		const std::vector<std::uint8_t> interlaced = ReadFile(SuiteDirectory / ("basi" + std::string{ suffix } + ".png"));
+
+		std::vector<std::uint8_t> expected{}, actual{};
+		std::size_t width = 0, height = 0;
+		ASSERT_EQ(gl::png::DecodeResult::Success, gl::png::Decode(progressive.data(), progressive.size(), expected, width, height));
+		ASSERT_EQ(gl::png::DecodeResult::Success, gl::png::Decode(interlaced.data(), interlaced.size(), actual, width, height));
+
+		EXPECT_EQ(expected, actual);
+	}
+}
+
+// The corrupt images of the full PngSuite, made from the valid ones
+TEST(PngSuite, RejectsBrokenSignatures)
+{
+	std::vector<std::uint8_t> file = ReadFile(SuiteDirectory / "basn0g01.png");
+
+	for (std::size_t i = 0; i < 8; ++i)
+	{
+		std::vector<std::uint8_t> broken = file;
+		broken[i] ^= 0x20;
+
+		EXPECT_EQ(gl::png::DecodeResult::NotPng, Decode(broken)) << i;
+	}
+
+	// xcrn0g04 and xlfn0g04, the line endings of a text transfer
+	std::vector<std::uint8_t> added_cr = file;
+	added_cr.insert(added_cr.begin() + 5, 13);
+	EXPECT_EQ(gl::png::DecodeResult::NotPng, Decode(added_cr));
+
+	std::vector<std::uint8_t> lf_only = file;
+	lf_only.erase(lf_only.begin() + 4);
+	EXPECT_EQ(gl::png::DecodeResult::NotPng, Decode(lf_only));
+}
+
+TEST(PngSuite, RejectsInvalidHeaders)
+{
+	const std::vector<Chunk> chunks = LoadChunks("basn2c08.png");
+	ASSERT_EQ("IHDR", chunks.front().type);
+
+	// xc1n0g08 and xc9n2c08
+	for (const std::uint8_t colour_type : { 1, 5, 7, 9 })
+	{
+		std::vector<Chunk> broken = chunks;
+		broken.front().data[9] = colour_type;
+		EXPECT_EQ(gl::png::DecodeResult::InvalidHeader, Decode(Join(broken))) << int{ colour_type };
+	}
+
+	// xd0n2c08, xd3n2c08 and xd9n2c08, plus depths only other colour types allow
+	for (const std::uint8_t depth : { 0, 1, 2, 3, 4, 9, 99 })
+	{
+		std::vector<Chunk> broken = chunks;
+		broken.front().data[8] = depth;
+		EXPECT_EQ(gl::png::DecodeResult::InvalidHeader, Decode(Join(broken))) << int{ depth };
+	}
+
+	std::vector<Chunk> no_width = chunks;
+	std::fill_n(no_width.front().data.begin(), 4, std::uint8_t{ 0 });
+	EXPECT_EQ(gl::png::DecodeResult::InvalidHeader, Decode(Join(no_width)));
+
+	std::vector<Chunk> bad_interlace = chunks;
+	bad_interlace.front().data[12] = 2;
+	EXPECT_EQ(gl::png::DecodeResult::InvalidHeader, Decode(Join(bad_interlace)));
+
+	// xhdn0g08, the crc of the header
+	std::vector<std::uint8_t> bad_crc = Join(chunks);
+	bad_crc[8 + 8 + 13] ^= 1;
+	EXPECT_NE(gl::png::DecodeResult::Success, Decode(bad_crc));
+}
+
+TEST(PngSuite, RejectsBrokenChunks)
+{
+	const std::vector<Chunk> chunks = LoadChunks("basn3p08.png");
+
+	// xcsn0g01, the crc of the image data
+	std::vector<std::uint8_t> bad_crc = Join(chunks);
+	bad_crc[bad_crc.size() - 12 - 1] ^= 1;
+	EXPECT_EQ(gl::png::DecodeResult::CorruptChunk, Decode(bad_crc));
+
+	// xdtn0g01, no image data
+	std::vector<Chunk> no_data{};
+	std::copy_if(chunks.begin(), chunks.end(), std::back_inserter(no_data), [](const Chunk& chunk) { return "IDAT" != chunk.type; });
+	EXPECT_EQ(gl::png::DecodeResult::CorruptChunk, Decode(Join(no_data)));
+
+	std::vector<Chunk> no_palette{};
+	std::copy_if(chunks.begin(), chunks.end(), std::back_inserter(no_palette), [](const Chunk& chunk) { return "PLTE" != chunk.type; });
+	EXPECT_EQ(gl::png::DecodeResult::CorruptChunk, Decode(Join(no_palette)));
+
+	std::vector<Chunk> unknown_critical = chunks;
+	unknown_critical.insert(unknown_critical.begin() + 1, Chunk{ "CRIT", { 1, 2, 3 } });
+	EXPECT_EQ(gl::png::DecodeResult::UnsupportedChunk, Decode(Join(unknown_critical)));
+
+	std::vector<Chunk> unknown_ancillary = chunks;
+	unknown_ancillary.insert(unknown_ancillary.begin() + 1, Chunk{ "anCi", { 1, 2, 3 } });
+	EXPECT_EQ(gl::png::DecodeResult::Success, Decode(Join(unknown_ancillary)));
+
+	const std::vector<std::uint8_t> file = Join(chunks);
+	for (std::size_t size = 8 + 8 + 13 + 4; size + 12 < file.size(); size += 7)
+	{
+		const std::vector<std::uint8_t> truncated(file.begin(), file.begin() + size);
+		EXPECT_NE(gl::png::DecodeResult::Success, Decode(truncated)) << size;
+	}
+}
+
+TEST(PngSuite, RejectsCorruptData)
+{
+	const std::vector<Chunk> chunks = LoadChunks("basn6a08.png");
+
+	std::vector<Chunk> bad_filter = chunks;
+	for (Chunk& chunk : bad_filter)
+	{
+		if ("IDAT" == chunk.type)
+		{
+			// A stored block around one row whose filter type doesn't exist
+			std::vector<std::uint8_t> row(1 + 32 * 4, 0);
+			row[0] = 5;
+
+			std::vector<std::uint8_t> stream = { 0x78, 0x01, 0x01 };
+			stream.push_back(static_cast<std::uint8_t>(row.size()));
+			stream.push_back(static_cast<std::uint8_t>(row.size() >> 8));
+			stream.push_back(static_cast<std::uint8_t>(~row.size()));
+			stream.push_back(static_cast<std::uint8_t>(~row.size() >> 8));
+			stream.insert(stream.end(), row.begin(), row.end());
+
+			chunk.data = stream;
+		}
+	}
+	EXPECT_EQ(gl::png::DecodeResult::CorruptData, Decode(Join(bad_filter)));
+
+	std::vector<Chunk> bad_stream = chunks;
+	for (Chunk& chunk : bad_stream)
+	{
+		if ("IDAT" == chunk.type)
+		{
+			chunk.data.resize(chunk.data.size() / 2);
+		}
+	}
+	EXPECT_EQ(gl::png::DecodeResult::CorruptData, Decode(Join(bad_stream)));
+}
@@ -0,0 +1,409 @@
+#include <gtest/gtest.h>
+#include "Glib.PointerSamples.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	[[nodiscard]]
+	gl::PointerSample
+	MakeRelative(long long time, float dx, float dy)
+	{
+		gl::PointerSample result{};
+		result.time = time;
+		result.x = dx;
+		result.y = dy;
+		result.pressure = 1;
+
+		return result;
+	}
+
+	[[nodiscard]]
+	gl::PointerSample
+	MakeAbsolute(long long time, float x, float y, float pressure = 1)
+	{
+		gl::PointerSample result{};
+		result.time = time;
+		result.x = x;
+		result.y = y;
+		result.pressure = pressure;
+		result.source = gl::PointerSource::Pen;
+		result.isAbsolute = true;
+
+		return result;
+	}
+
+	[[nodiscard]]
+	gl::RawMouseReport
+	MakeReport(int dx, int dy)
+	{
+		gl::RawMouseReport result{};
+		result.x = dx;
+		result.y = dy;
+
+		return result;
+	}
+
+	[[nodiscard]]
+	std::vector<long long>
+	GetTimes(gl::SampleRing& ring)
+	{
+		std::vector<gl::PointerSample> samples{};
+		ring.Drain(samples);
+
+		std::vector<long long> result{};
+		for (const gl::PointerSample& sample : samples)
+		{
+			result.push_back(sample.time);
+		}
+
+		return result;
+	}
+}
+
+TEST(SampleRing, DrainsInOrderAcrossTheEnd)
+{
+	gl::SampleRing ring{ 5 };
+	ASSERT_EQ(8U, ring.GetCapacity());
+
+	for (long long i = 0; i < 6; ++i)
+	{
+		ASSERT_TRUE(ring.Push(MakeRelative(i, 0, 0)));
+	}
+
+	gl::PointerSample first[4]{};
+	ASSERT_EQ(4U, ring.Drain(std::span<gl::PointerSample>{ first }));
+	EXPECT_EQ(0, first[0].time);
+	EXPECT_EQ(3, first[3].time);
+
+	// Wraps around the storage
+	for (long long i = 6; i < 12; ++i)
+	{
+		ASSERT_TRUE(ring.Push(MakeRelative(i, 0, 0)));
+	}
+	EXPECT_EQ(8U, ring.GetSize());
+
+	std::vector<gl::PointerSample> rest{};
+	ASSERT_EQ(8U, ring.Drain(rest));
+	for (std::size_t i = 0; i < rest.size(); ++i)
+	{
+		EXPECT_EQ(static_cast<long long>(i) + 4, rest[i].time);
+	}
+
+	EXPECT_TRUE(ring.IsEmpty());
+	EXPECT_EQ(0U, ring.Drain(rest));
+}
+
+TEST(SampleRing, DropsAndCountsWhenFull)
+{
+	gl::SampleRing ring{ 4 };
+
+	for (long long i = 0; i < 6; ++i)
+	{
+		ring.Push(MakeRelative(i, 0, 0));
+	}
+
+	EXPECT_EQ(2U, ring.TakeDropped());
+	EXPECT_EQ(0U, ring.TakeDropped());
+
+	// The oldest are kept, the ones being read are never overwritten
+	EXPECT_EQ((std::vector<long long>{ 0, 1, 2, 3 }), GetTimes(ring));
+
+	ring.Push(MakeRelative(10, 0, 0));
+	ring.Clear();
+	EXPECT_TRUE(ring.IsEmpty());
+}
+
+TEST(SampleRing, LosesNothingBetweenAProducerAndAConsumer)
+{
+	constexpr long long Count = 200'000;
+
+	gl::SampleRing ring{ 64 };
+
+	std::thread producer{ [&ring] {
+		for (long long i = 0; i < Count; ++i)
+		{
+			while (not ring.Push(MakeRelative(i, 1, 0)))
+			{
+				std::this_thread::yield();
+			}
+		}
+	} };
+
+	std::vector<gl::PointerSample> samples{};
+	samples.reserve(Count);
+	while (samples.size() < static_cast<std::size_t>(Count))
+	{
+		ring.Drain(samples);
+	}
+
+	producer.join();
+
+	for (long long i = 0; i < Count; ++i)
+	{
+		ASSERT_EQ(i, samples[static_cast<std::size_t>(i)].time);
+	}
+}
+
+TEST(RawMouseDecoder, SpreadsABatchOverTheIntervalSinceTheLastRead)
+{
+	gl::SampleRing ring{};
+	gl::RawMouseDecoder decoder{};
+
+	// Without a previous read, nothing to spread over
+	const gl::RawMouseReport two[] = { MakeReport(1, 0), MakeReport(1, 0) };
+	EXPECT_EQ(2U, decoder.Push(two, 1000, ring));
+	EXPECT_EQ((std::vector<long long>{ 1000, 1000 }), GetTimes(ring));
+
+	const gl::RawMouseReport four[] = { MakeReport(1, 0), MakeReport(2, 0), MakeReport(3, 0), MakeReport(4, 0) };
+	EXPECT_EQ(4U, decoder.Push(four, 5000, ring));
+	EXPECT_EQ((std::vector<long long>{ 2000, 3000, 4000, 5000 }), GetTimes(ring));
+
+	// After an idle time, at most at the slowest polling
+	EXPECT_EQ(2U, decoder.Push(two, 1'000'000, ring));
+	EXPECT_EQ((std::vector<long long>{ 1'000'000 - gl::RawMouseDecoder::MaxReportInterval, 1'000'000 }), GetTimes(ring));
+
+	// A clock going back does not send the samples to the future
+	EXPECT_EQ(2U, decoder.Push(two, 900'000, ring));
+	EXPECT_EQ((std::vector<long long>{ 900'000, 900'000 }), GetTimes(ring));
+
+	decoder.Reset();
+	EXPECT_EQ(2U, decoder.Push(two, 2'000'000, ring));
+	EXPECT_EQ((std::vector<long long>{ 2'000'000, 2'000'000 }), GetTimes(ring));
+}
+
+TEST(RawMouseDecoder, AbsoluteReportsKeepTheirWheelsAndButtonsWithoutMotion)
+{
+	gl::SampleRing ring{};
+	gl::RawMouseDecoder decoder{};
+
+	const gl::RawMouseReport first[] = { MakeReport(0, 0) };
+	decoder.Push(first, 0, ring);
+	ring.Clear();
+
+	gl::RawMouseReport press = MakeReport(30000, 30000);
+	press.isAbsolute = true;
+	press.pressed = gl::pointer_buttons::Left;
+
+	// Only a position, which the pointer messages bring
+	gl::RawMouseReport moved = MakeReport(31000, 29000);
+	moved.isAbsolute = true;
+
+	gl::RawMouseReport scroll = MakeReport(32000, 28000);
+	scroll.isAbsolute = true;
+	scroll.wheel = -120;
+	scroll.hwheel = 240;
+
+	gl::RawMouseReport release = MakeReport(32000, 28000);
+	release.isAbsolute = true;
+	release.released = gl::pointer_buttons::Left;
+
+	const gl::RawMouseReport reports[] = { MakeReport(5, -5), press, moved, scroll, release };
+	EXPECT_EQ(4U, decoder.Push(reports, 5000, ring));
+
+	std::vector<gl::PointerSample> samples{};
+	ring.Drain(samples);
+	ASSERT_EQ(4U, samples.size());
+
+	EXPECT_EQ(1000, samples[0].time);
+	EXPECT_FLOAT_EQ(5, samples[0].x);
+	EXPECT_FLOAT_EQ(-5, samples[0].y);
+	EXPECT_EQ(0U, samples[0].buttons);
+
+	// Every report still had its slot of the interval
+	EXPECT_EQ(2000, samples[1].time);
+	EXPECT_EQ(gl::pointer_buttons::Left, samples[1].buttons);
+	EXPECT_EQ(0, samples[1].wheel);
+
+	EXPECT_EQ(4000, samples[2].time);
+	EXPECT_EQ(gl::pointer_buttons::Left, samples[2].buttons);
+	EXPECT_EQ(-120, samples[2].wheel);
+	EXPECT_EQ(240, samples[2].hwheel);
+
+	EXPECT_EQ(5000, samples[3].time);
+	EXPECT_EQ(0U, samples[3].buttons);
+	EXPECT_EQ(0U, decoder.GetButtons());
+
+	for (std::size_t i = 1; i < samples.size(); ++i)
+	{
+		EXPECT_FLOAT_EQ(0, samples[i].x) << i;
+		EXPECT_FLOAT_EQ(0, samples[i].y) << i;
+		EXPECT_FALSE(samples[i].isAbsolute) << i;
+		EXPECT_EQ(gl::PointerSource::Mouse, samples[i].source) << i;
+	}
+}
+
+TEST(RawMouseDecoder, HoldsTheButtonsBetweenReads)
+{
+	gl::SampleRing ring{};
+	gl::RawMouseDecoder decoder{};
+
+	gl::RawMouseReport press = MakeReport(0, 0);
+	press.pressed = gl::pointer_buttons::Left | gl::pointer_buttons::Right;
+	const gl::RawMouseReport pressed[] = { press };
+	decoder.Push(pressed, 0, ring);
+
+	const gl::RawMouseReport moves[] = { MakeReport(1, 1), MakeReport(1, 1) };
+	decoder.Push(moves, 1000, ring);
+
+	gl::RawMouseReport release = MakeReport(0, 0);
+	release.released = gl::pointer_buttons::Left;
+	const gl::RawMouseReport released[] = { release };
+	decoder.Push(released, 2000, ring);
+
+	std::vector<gl::PointerSample> samples{};
+	ring.Drain(samples);
+	ASSERT_EQ(4U, samples.size());
+
+	const std::uint16_t both = gl::pointer_buttons::Left | gl::pointer_buttons::Right;
+	EXPECT_EQ(both, samples[0].buttons);
+	EXPECT_EQ(both, samples[2].buttons);
+	EXPECT_EQ(gl::pointer_buttons::Right, samples[3].buttons);
+	EXPECT_EQ(gl::pointer_buttons::Right, decoder.GetButtons());
+
+	decoder.Reset();
+	EXPECT_EQ(0U, decoder.GetButtons());
+}
+
+TEST(RawMouseDecoder, CountsOnlyWhatTheRingTook)
+{
+	gl::SampleRing ring{ 2 };
+	gl::RawMouseDecoder decoder{};
+
+	const gl::RawMouseReport reports[] = { MakeReport(1, 0), MakeReport(1, 0), MakeReport(1, 0) };
+	EXPECT_EQ(2U, decoder.Push(reports, 0, ring));
+	EXPECT_EQ(1U, ring.TakeDropped());
+}
+
+TEST(RawMouseDecoder, SpreadSamplesFollowAMouseReadAtTheFrames)
+{
+	// A mouse polling at 1000 Hz moving right at a count a report, read at frames of uneven lengths
+	constexpr long long Period = 1000;
+	constexpr long long Duration = 2'000'000;
+
+	gl::SampleRing ring{ 4096 };
+	gl::RawMouseDecoder decoder{};
+
+	std::mt19937 random{ 5 };
+	std::uniform_int_distribution<long long> frame{ 4000, 40000 };
+
+	std::vector<long long> generated{};
+	std::vector<gl::PointerSample> samples{};
+	std::vector<gl::RawMouseReport> batch{};
+
+	long long next_report = 300;
+	for (long long read = frame(random); read < Duration; read += frame(random))
+	{
+		batch.clear();
+		for (; next_report <= read; next_report += Period)
+		{
+			batch.push_back(MakeReport(1, 0));
+			generated.push_back(next_report);
+		}
+
+		ASSERT_EQ(batch.size(), decoder.Push(batch, read, ring));
+		ring.Drain(samples);
+	}
+
+	ASSERT_EQ(generated.size(), samples.size());
+	EXPECT_EQ(0U, ring.TakeDropped());
+
+	// The first read has no interval, the rest are within a report of when the mouse sent them
+	const std::size_t first_batch = static_cast<std::size_t>(std::ranges::count(samples, samples.front().time, &gl::PointerSample::time));
+
+	long long worst = 0;
+	for (std::size_t i = first_batch; i < samples.size(); ++i)
+	{
+		ASSERT_LE(samples[i - 1].time, samples[i].time);
+		worst = std::max(worst, std::abs(samples[i].time - generated[i]));
+	}
+
+	EXPECT_GE(Period, worst);
+
+	// So the movement of a window of time is the one of the mouse
+	const gl::PointerMotion motion = gl::Accumulate(samples, 500'000, 1'500'000);
+	EXPECT_NEAR(1000, motion.dx, 2);
+	EXPECT_EQ(0, motion.dy);
+}
+
+TEST(PointerSamples, InterpolateSkipsTheRelativeSamples)
+{
+	const gl::PointerSample history[] =
+	{
+		MakeAbsolute(100, 0, 0, 0),
+		MakeRelative(150, 50, 50),
+		MakeAbsolute(200, 10, 20, 1),
+		MakeAbsolute(300, 30, 20, 1),
+	};
+
+	const gl::PointerSample middle = gl::Interpolate(history, 150);
+	EXPECT_EQ(150, middle.time);
+	EXPECT_FLOAT_EQ(5, middle.x);
+	EXPECT_FLOAT_EQ(10, middle.y);
+	EXPECT_FLOAT_EQ(0.5f, middle.pressure);
+
+	// Outside of the history, the nearest
+	EXPECT_FLOAT_EQ(0, gl::Interpolate(history, 0).x);
+	EXPECT_FLOAT_EQ(30, gl::Interpolate(history, 1000).x);
+
+	const gl::PointerSample relative[] = { MakeRelative(100, 1, 1) };
+	EXPECT_FALSE(gl::Interpolate(relative, 100).isAbsolute);
+	EXPECT_EQ(0, gl::Interpolate(relative, 100).time);
+}
+
+TEST(PointerSamples, AccumulateSumsAHalfOpenWindow)
+{
+	gl::PointerSample wheel = MakeRelative(300, 0, 0);
+	wheel.wheel = 120;
+	wheel.hwheel = -120;
+
+	const gl::PointerSample history[] =
+	{
+		MakeRelative(100, 1, 2),
+		MakeRelative(200, 3, 4),
+		MakeAbsolute(250, 500, 500),
+		wheel,
+		MakeRelative(400, 5, 6),
+	};
+
+	const gl::PointerMotion motion = gl::Accumulate(history, 200, 400);
+	EXPECT_FLOAT_EQ(3, motion.dx);
+	EXPECT_FLOAT_EQ(4, motion.dy);
+	EXPECT_EQ(120, motion.wheel);
+	EXPECT_EQ(-120, motion.hwheel);
+	EXPECT_EQ(2U, motion.count);
+}
+
+TEST(PointerSamples, ResampleAtAFixedStep)
+{
+	const gl::PointerSample history[] =
+	{
+		MakeAbsolute(1000, 0, 0),
+		MakeRelative(1500, 9, 9),
+		MakeAbsolute(2000, 100, 0),
+		MakeAbsolute(4000, 100, 200),
+	};
+
+	gl::PointerSample output[6]{};
+	ASSERT_EQ(6U, gl::Resample(history, 500, 500, output));
+
+	const float expected_x[] = { 0, 0, 50, 100, 100, 100 };
+	const float expected_y[] = { 0, 0, 0, 0, 50, 100 };
+	for (std::size_t i = 0; i < std::size(output); ++i)
+	{
+		EXPECT_EQ(500 + 500 * static_cast<long long>(i), output[i].time);
+		EXPECT_FLOAT_EQ(expected_x[i], output[i].x) << i;
+		EXPECT_FLOAT_EQ(expected_y[i], output[i].y) << i;
+	}
+
+	EXPECT_EQ(0U, gl::Resample(history, 0, 0, output));
+
+	const gl::PointerSample relative[] = { MakeRelative(100, 1, 1) };
+	EXPECT_EQ(0U, gl::Resample(relative, 0, 10, output));
+}
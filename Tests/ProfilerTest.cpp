@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "FakeQueryBackend.hpp"
+#include "Glib.Profiler.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	// A frame of two passes, the second with a nested one
+	void DrawFrame(gl::GpuProfiler& profiler)
+	{
+		profiler.BeginFrame();
+		{
+			gl::profiler::Scope shadows{ profiler, "Shadows" };
+		}
+		{
+			gl::profiler::Scope lighting{ profiler, "Lighting" };
+			gl::profiler::Scope bloom{ profiler, "Bloom" };
+		}
+		profiler.EndFrame();
+	}
+}
+
+TEST(ProfilerTest, TheGpuClockIsAskedForOnlyAtCalibration)
+{
+	glstub::FakeQueryBackend backend{};
+	gl::GpuProfiler profiler{ backend };
+
+	for (int frame = 0; frame < 20; ++frame)
+	{
+		DrawFrame(profiler);
+		backend.Finish();
+	}
+
+	EXPECT_EQ(1U, backend.currentTimestamps);
+	EXPECT_EQ(1U, backend.createdBatches);
+
+	profiler.Calibrate();
+	DrawFrame(profiler);
+	DrawFrame(profiler);
+	EXPECT_EQ(2U, backend.currentTimestamps);
+
+	// New queries are calibrated again
+	profiler.Release();
+	DrawFrame(profiler);
+	EXPECT_EQ(3U, backend.currentTimestamps);
+	EXPECT_EQ(2U, backend.createdBatches);
+	EXPECT_TRUE(backend.errors.empty()) << backend.errors.front();
+}
+
+TEST(ProfilerTest, GpuTimesAreOnTheCpuTimeline)
+{
+	glstub::FakeQueryBackend backend{};
+	gl::GpuProfiler profiler{ backend };
+
+	// The GPU reaches every command a millisecond after the CPU wrote it
+	backend.delay = 1'000'000;
+
+	for (int frame = 0; frame < 5; ++frame)
+	{
+		DrawFrame(profiler);
+		backend.Finish();
+	}
+
+	profiler.Resolve();
+	const gl::profiler::FrameTimeline* latest = profiler.GetLatest();
+	ASSERT_NE(nullptr, latest);
+
+	// The offset of the GPU clock is gone, the delay is left
+	EXPECT_LE(1'000'000, latest->gpuBegin);
+	EXPECT_GT(50'000'000, latest->gpuBegin);
+
+	ASSERT_EQ(3U, latest->scopes.size());
+	for (const gl::profiler::ScopeTiming& scope : latest->scopes)
+	{
+		EXPECT_LE(scope.cpuBegin, scope.cpuEnd);
+		EXPECT_LE(scope.gpuBegin, scope.gpuEnd);
+		EXPECT_LE(latest->gpuBegin, scope.gpuBegin);
+		EXPECT_LE(scope.gpuEnd, latest->gpuEnd);
+		EXPECT_LE(scope.cpuBegin + 1'000'000, scope.gpuBegin);
+	}
+}
+
+TEST(ProfilerTest, SlotsInFlightAreSkippedWithoutWaiting)
+{
+	glstub::FakeQueryBackend backend{};
+	gl::GpuProfiler profiler{ backend, 3 };
+
+	// The GPU never catches up
+	for (int frame = 0; frame < 5; ++frame)
+	{
+		DrawFrame(profiler);
+	}
+
+	const gl::profiler::Statistics& statistics = profiler.GetStatistics();
+	EXPECT_EQ(5U, statistics.frames);
+	EXPECT_EQ(2U, statistics.skippedFrames);
+	EXPECT_EQ(0U, statistics.resolvedFrames);
+	EXPECT_EQ(nullptr, profiler.GetLatest());
+
+	// Then it does, and the frames are read in order
+	backend.Finish();
+	EXPECT_EQ(3U, profiler.Resolve());
+	ASSERT_NE(nullptr, profiler.GetLatest());
+	EXPECT_EQ(2U, profiler.GetLatest()->frame);
+	EXPECT_EQ(3U, profiler.GetLatest()->latency);
+
+	EXPECT_TRUE(backend.errors.empty()) << backend.errors.front();
+}
+
+TEST(ProfilerTest, FramesAreReadBackWhenTheirQueriesAreDone)
+{
+	glstub::FakeQueryBackend backend{};
+	gl::GpuProfiler profiler{ backend, 3 };
+
+	DrawFrame(profiler);
+	const std::uint64_t first_frame = backend.GetWrites();
+	DrawFrame(profiler);
+
+	// Only the first frame is done
+	backend.finished = first_frame;
+	EXPECT_EQ(1U, profiler.Resolve());
+	EXPECT_EQ(0U, profiler.GetLatest()->frame);
+	EXPECT_EQ(0U, profiler.Resolve());
+
+	// Half of the second one is not enough
+	backend.finished = first_frame + 3;
+	EXPECT_EQ(0U, profiler.Resolve());
+
+	backend.Finish();
+	EXPECT_EQ(1U, profiler.Resolve());
+	EXPECT_EQ(1U, profiler.GetLatest()->frame);
+
+	const gl::profiler::Statistics& statistics = profiler.GetStatistics();
+	EXPECT_EQ(2U, statistics.resolvedFrames);
+	EXPECT_EQ(statistics.resolvedFrames, statistics.cpuBoundFrames + statistics.gpuBoundFrames);
+	EXPECT_EQ(16U, statistics.queries);
+	EXPECT_TRUE(backend.errors.empty()) << backend.errors.front();
+}
+
+TEST(ProfilerTest, ScopesNestAndCloseWithTheirParents)
+{
+	glstub::FakeQueryBackend backend{};
+	gl::GpuProfiler profiler{ backend, 1 };
+
+	profiler.BeginFrame();
+	const gl::profiler::ScopeId outer = profiler.BeginScope("Outer");
+	const gl::profiler::ScopeId inner = profiler.BeginScope("Inner");
+	profiler.BeginScope("Innermost");
+	// Ending the outer scope ends the two left open in it
+	profiler.EndScope(outer);
+	profiler.EndScope(inner);
+	const gl::profiler::ScopeId open = profiler.BeginScope("Open");
+	profiler.EndFrame();
+
+	backend.Finish();
+	profiler.Resolve();
+
+	const gl::profiler::FrameTimeline* latest = profiler.GetLatest();
+	ASSERT_NE(nullptr, latest);
+	ASSERT_EQ(4U, latest->scopes.size());
+
+	EXPECT_EQ("Outer", latest->scopes[0].name);
+	EXPECT_EQ(0U, latest->scopes[0].depth);
+	EXPECT_EQ(gl::profiler::InvalidScope, latest->scopes[0].parent);
+	EXPECT_EQ(1U, latest->scopes[1].depth);
+	EXPECT_EQ(outer, latest->scopes[1].parent);
+	EXPECT_EQ(2U, latest->scopes[2].depth);
+	EXPECT_EQ(inner, latest->scopes[2].parent);
+
+	// The open scope is closed by the end of the frame, at the top level
+	EXPECT_EQ(0U, latest->scopes[open].depth);
+	EXPECT_LE(latest->scopes[open].gpuEnd, latest->gpuEnd);
+
+	// Every begin and end, once
+	EXPECT_EQ(2U + 2U * 4U, profiler.GetStatistics().queries);
+	EXPECT_TRUE(backend.errors.empty()) << backend.errors.front();
+}
+
+TEST(ProfilerTest, ScopesBeyondTheMaximumAreDropped)
+{
+	glstub::FakeQueryBackend backend{};
+	gl::GpuProfiler profiler{ backend, 2, 2 };
+
+	profiler.BeginFrame();
+	for (int i = 0; i < 5; ++i)
+	{
+		gl::profiler::Scope scope{ profiler, "Pass" };
+	}
+	profiler.EndFrame();
+
+	backend.Finish();
+	profiler.Resolve();
+
+	EXPECT_EQ(3U, profiler.GetStatistics().droppedScopes);
+	EXPECT_EQ(2U, profiler.GetLatest()->scopes.size());
+	EXPECT_EQ(6U, backend.GetWrites());
+}
+
+TEST(ProfilerTest, LongNamesAreCut)
+{
+	glstub::FakeQueryBackend backend{};
+	gl::GpuProfiler profiler{ backend, 1 };
+
+	const std::string name(200, 'x');
+
+	profiler.BeginFrame();
+	{
+		gl::profiler::Scope scope{ profiler, name };
+	}
+	profiler.EndFrame();
+
+	backend.Finish();
+	profiler.Resolve();
+
+	ASSERT_EQ(1U, profiler.GetLatest()->scopes.size());
+	EXPECT_EQ(std::string_view{ name }.substr(0, gl::profiler::MaxScopeName), profiler.GetLatest()->scopes[0].name);
+}
+
+TEST(ProfilerTest, DisabledProfilerWritesNothing)
+{
+	glstub::FakeQueryBackend backend{};
+
+	{
+		gl::GpuProfiler profiler{ backend };
+		profiler.SetEnabled(false);
+
+		DrawFrame(profiler);
+		EXPECT_EQ(0U, backend.createdBatches);
+		EXPECT_EQ(0U, backend.GetWrites());
+		EXPECT_EQ(gl::profiler::InvalidScope, profiler.BeginScope("Nothing"));
+
+		profiler.SetEnabled(true);
+		DrawFrame(profiler);
+		EXPECT_EQ(8U, backend.GetWrites());
+	}
+
+	// The queries go with the profiler
+	EXPECT_TRUE(backend.queries.empty());
+	EXPECT_TRUE(backend.errors.empty()) << backend.errors.front();
+}
+
+TEST(ProfilerTest, OpenGLBackendAsksForTheTimeOnce)
+{
+	glstub::Reset();
+
+	{
+		gl::GpuProfiler profiler{};
+
+		for (int frame = 0; frame < 10; ++frame)
+		{
+			DrawFrame(profiler);
+		}
+
+		EXPECT_EQ(1U, glstub::CountCalls("glGenQueries"));
+		EXPECT_EQ(8U * 10U, glstub::CountCalls("glQueryCounter"));
+		EXPECT_EQ(9U, profiler.GetStatistics().resolvedFrames);
+	}
+
+	const std::vector<glstub::Call> calls = glstub::FindCalls("glGetInteger64v");
+	ASSERT_EQ(1U, calls.size());
+	EXPECT_EQ(GL_TIMESTAMP, calls[0].args[0]);
+	EXPECT_EQ(1U, glstub::CountCalls("glDeleteQueries"));
+}
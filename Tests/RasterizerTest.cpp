@@ -0,0 +1,472 @@
+#include <gtest/gtest.h>
+#include "Glib.hpp"
+#include "Glib.Rasterizer.hpp"
+#include "Glib.VertexPacking.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	constexpr float Identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+	template<typename T>
+	void
+	Append(std::vector<std::byte>& bytes, const T& value)
+	{
+		const std::size_t size = bytes.size();
+		bytes.resize(size + sizeof(T));
+		std::memcpy(bytes.data() + size, &value, sizeof(T));
+	}
+
+	// A triangle covering the middle of the screen, the corners get the three packed colours
+	[[nodiscard]]
+	gl::ScreenPixel
+	DrawCentre(const gl::BufferLayout& layout, const std::vector<std::byte>& vertices, bool& drawn)
+	{
+		gl::SoftwareRasterizer rasterizer{ 16, 16, 1 };
+		rasterizer.SetTransform(Identity);
+
+		gl::raster::DrawState state{};
+		state.depthTesting = false;
+		rasterizer.SetState(state);
+
+		drawn = rasterizer.Draw(gl::raster::VertexInput{ .vertices = vertices, .layout = &layout, .positionElement = 0, .colourElement = 1 });
+		rasterizer.Finish();
+
+		return rasterizer.GetPixels()[8 * 16 + 8];
+	}
+
+	[[nodiscard]]
+	std::vector<std::byte>
+	MakeTriangle(const std::uint32_t& colour)
+	{
+		const float positions[3][2] = { { -1, -1 }, { 3, -1 }, { -1, 3 } };
+
+		std::vector<std::byte> bytes{};
+		for (const auto& position : positions)
+		{
+			Append(bytes, position);
+			Append(bytes, colour);
+		}
+
+		return bytes;
+	}
+
+	struct Vertex
+	{
+		float position[3];
+		float colour[4];
+	};
+
+	// A corner given in pixels of a size by size framebuffer, rows going down
+	[[nodiscard]]
+	Vertex
+	AtPixel(float x, float y, float size, float depth, const float(&colour)[4])
+	{
+		return Vertex{ { x / size * 2 - 1, 1 - y / size * 2, depth }, { colour[0], colour[1], colour[2], colour[3] } };
+	}
+
+	bool
+	DrawVertices(gl::SoftwareRasterizer& rasterizer, std::span<const Vertex> vertices)
+	{
+		gl::BufferLayout layout{};
+		layout.SetStride(sizeof(Vertex));
+		layout.AddElement<float>(3);
+		layout.AddElement<float>(4);
+
+		return rasterizer.Draw(gl::raster::VertexInput{ .vertices = std::as_bytes(vertices), .layout = &layout, .colourElement = 1 });
+	}
+
+	[[nodiscard]]
+	gl::raster::DrawState
+	MakeAdditive()
+	{
+		gl::raster::DrawState state{};
+		state.depthTesting = false;
+		state.blending = true;
+		state.blendMode = gl::BlendMode{ gl::BlendOption::One, gl::BlendOption::One };
+
+		return state;
+	}
+
+	[[nodiscard]]
+	const gl::ScreenPixel&
+	GetPixel(const gl::SoftwareRasterizer& rasterizer, std::uint32_t x, std::uint32_t y)
+	{
+		return rasterizer.GetPixels()[y * rasterizer.GetWidth() + x];
+	}
+}
+
+TEST(Rasterizer, DecodesNormalizedPackedColours)
+{
+	float rgba[4] = { 1.0f, 0.5f, 0.0f, 1.0f };
+	gl::vertex::PackedUnorm packed{};
+	gl::vertex::PackUnorm(rgba, std::span{ &packed, 1 });
+
+	gl::BufferLayout layout{};
+	layout.SetStride(12);
+	layout.AddElement<float>(2);
+	layout.AddElement<gl::vertex::PackedUnorm>(4);
+
+	bool drawn = false;
+	const gl::ScreenPixel pixel = DrawCentre(layout, MakeTriangle(packed.bits), drawn);
+
+	ASSERT_TRUE(drawn);
+	EXPECT_EQ(255, pixel.colour.R);
+	EXPECT_NEAR(128, pixel.colour.G, 1);
+	EXPECT_EQ(0, pixel.colour.B);
+	EXPECT_EQ(255, pixel.colour.A);
+}
+
+TEST(Rasterizer, DecodesPackedSnormPositions)
+{
+	// The top half of the screen, as signed normalized corners
+	const float corners[3][4] = { { -1, 0, 0, 1 }, { 1, 0, 0, 1 }, { 0, 1, 0, 1 } };
+
+	std::vector<std::byte> bytes{};
+	for (const auto& corner : corners)
+	{
+		gl::vertex::PackedSnorm packed{};
+		gl::vertex::PackSnorm(corner, std::span{ &packed, 1 });
+		Append(bytes, packed);
+	}
+
+	gl::BufferLayout layout{};
+	layout.AddElement<gl::vertex::PackedSnorm>(4);
+
+	gl::SoftwareRasterizer rasterizer{ 16, 16, 1 };
+	rasterizer.Clear(gl::Colour{ std::uint8_t{ 0 }, std::uint8_t{ 0 }, std::uint8_t{ 0 } });
+	rasterizer.SetTransform(Identity);
+
+	ASSERT_TRUE(rasterizer.Draw(gl::raster::VertexInput{ .vertices = bytes, .layout = &layout }));
+	rasterizer.Finish();
+
+	// Rows are stored top-down
+	EXPECT_EQ(255, rasterizer.GetPixels()[4 * 16 + 8].colour.R);
+	EXPECT_EQ(0, rasterizer.GetPixels()[12 * 16 + 8].colour.R);
+	EXPECT_EQ(1U, rasterizer.GetStatistics().binnedTriangles);
+}
+
+TEST(Rasterizer, ReadsUnnormalizedPackedIntegers)
+{
+	// Raw components of 255, 0 and 0 stay integers, the colour saturates to one
+	gl::BufferLayout layout{};
+	layout.SetStride(12);
+	layout.AddElement<float>(2);
+	layout.AddElement<gl::vertex::PackedUnorm>(4, false);
+
+	bool drawn = false;
+	const gl::ScreenPixel pixel = DrawCentre(layout, MakeTriangle(255U | 3U << 30), drawn);
+
+	ASSERT_TRUE(drawn);
+	EXPECT_EQ(255, pixel.colour.R);
+	EXPECT_EQ(0, pixel.colour.G);
+	EXPECT_EQ(0, pixel.colour.B);
+
+	// The sign of the snorm layout comes from the top bit of each field
+	gl::BufferLayout signed_layout{};
+	signed_layout.SetStride(12);
+	signed_layout.AddElement<float>(2);
+	signed_layout.AddElement<gl::vertex::PackedSnorm>(4, false);
+
+	const gl::ScreenPixel negative = DrawCentre(signed_layout, MakeTriangle(0x3FFU | 1U << 10 | 1U << 30), drawn);
+
+	ASSERT_TRUE(drawn);
+	EXPECT_EQ(0, negative.colour.R);
+	EXPECT_EQ(255, negative.colour.G);
+}
+
+TEST(Rasterizer, RefusesPackedElementsOfOtherCounts)
+{
+	gl::BufferLayout layout{};
+	layout.SetStride(12);
+	layout.AddElement<float>(2);
+	layout.AddElement<gl::vertex::PackedUnorm>(3);
+
+	bool drawn = true;
+	(void)DrawCentre(layout, MakeTriangle(0xFFFFFFFFU), drawn);
+
+	EXPECT_FALSE(drawn);
+}
+
+TEST(Rasterizer, SharedEdgesAreFilledOnce)
+{
+	constexpr float Quarter[4] = { 0.25f, 0.0f, 0.0f, 1.0f };
+	constexpr float Size = 16;
+
+	gl::SoftwareRasterizer rasterizer{ 16, 16, 1 };
+	rasterizer.Clear(gl::Colour{ std::uint8_t{ 0 }, std::uint8_t{ 0 }, std::uint8_t{ 0 } });
+	rasterizer.SetState(MakeAdditive());
+
+	// The diagonal runs through pixel centres, and so do the top and left edges
+	const Vertex quad[6] =
+	{
+		AtPixel(2.5f, 2.5f, Size, 0, Quarter), AtPixel(2.5f, 10.5f, Size, 0, Quarter), AtPixel(10.5f, 10.5f, Size, 0, Quarter),
+		AtPixel(2.5f, 2.5f, Size, 0, Quarter), AtPixel(10.5f, 10.5f, Size, 0, Quarter), AtPixel(10.5f, 2.5f, Size, 0, Quarter)
+	};
+
+	ASSERT_TRUE(DrawVertices(rasterizer, quad));
+	rasterizer.Finish();
+
+	// The top left edges own their pixels, the bottom right ones don't
+	for (std::uint32_t y = 0; y < 16; ++y)
+	{
+		for (std::uint32_t x = 0; x < 16; ++x)
+		{
+			const bool inside = 2 <= x && x < 10 && 2 <= y && y < 10;
+			EXPECT_EQ(inside ? 64 : 0, GetPixel(rasterizer, x, y).colour.R) << x << ", " << y;
+		}
+	}
+
+	EXPECT_EQ(64U, rasterizer.GetStatistics().shadedPixels);
+}
+
+TEST(Rasterizer, FansCoverEveryPixelOnce)
+{
+	constexpr float Quarter[4] = { 0.25f, 0.0f, 0.0f, 1.0f };
+	constexpr float Size = 32;
+	constexpr int Slices = 11;
+
+	gl::SoftwareRasterizer rasterizer{ 32, 32, 1 };
+	rasterizer.Clear(gl::Colour{ std::uint8_t{ 0 }, std::uint8_t{ 0 }, std::uint8_t{ 0 } });
+	rasterizer.SetState(MakeAdditive());
+
+	// Slices of a disc around an off grid centre, their edges cross pixel centres at any angle
+	std::vector<Vertex> fan{};
+	for (int i = 0; i < Slices; ++i)
+	{
+		const float a0 = 6.2831853f * i / Slices, a1 = 6.2831853f * (i + 1) / Slices;
+		fan.push_back(AtPixel(16.3f, 15.7f, Size, 0, Quarter));
+		fan.push_back(AtPixel(16.3f + 12 * std::cos(a1), 15.7f + 12 * std::sin(a1), Size, 0, Quarter));
+		fan.push_back(AtPixel(16.3f + 12 * std::cos(a0), 15.7f + 12 * std::sin(a0), Size, 0, Quarter));
+	}
+
+	ASSERT_TRUE(DrawVertices(rasterizer, fan));
+	rasterizer.Finish();
+
+	std::uint64_t covered = 0;
+	for (const gl::ScreenPixel& pixel : rasterizer.GetPixels())
+	{
+		ASSERT_TRUE(0 == pixel.colour.R || 64 == pixel.colour.R);
+		covered += 0 != pixel.colour.R;
+	}
+
+	// No gaps inside, and nothing shaded twice
+	EXPECT_EQ(64, GetPixel(rasterizer, 16, 15).colour.R);
+	EXPECT_EQ(64, GetPixel(rasterizer, 16, 5).colour.R);
+	EXPECT_EQ(covered, rasterizer.GetStatistics().shadedPixels);
+}
+
+TEST(Rasterizer, DepthTestKeepsTheNearest)
+{
+	constexpr float Red[4] = { 1, 0, 0, 1 };
+	constexpr float Green[4] = { 0, 1, 0, 1 };
+	constexpr float Blue[4] = { 0, 0, 1, 1 };
+	constexpr float Size = 16;
+
+	// Left, right and whole screen rectangles
+	const auto rectangle = [&](float x0, float x1, float depth, const float(&colour)[4]) {
+		return std::vector<Vertex>{
+			AtPixel(x0, 0, Size, depth, colour), AtPixel(x0, Size, Size, depth, colour), AtPixel(x1, Size, Size, depth, colour),
+			AtPixel(x0, 0, Size, depth, colour), AtPixel(x1, Size, Size, depth, colour), AtPixel(x1, 0, Size, depth, colour)
+		};
+	};
+
+	gl::SoftwareRasterizer rasterizer{ 16, 16, 2 };
+	rasterizer.Clear(gl::Colour{ std::uint8_t{ 0 }, std::uint8_t{ 0 }, std::uint8_t{ 0 } });
+
+	gl::raster::DrawState state{};
+	rasterizer.SetState(state);
+	ASSERT_TRUE(DrawVertices(rasterizer, rectangle(0, Size, 0.5f, Red)));
+	ASSERT_TRUE(DrawVertices(rasterizer, rectangle(0, 8, -0.5f, Green)));
+	// Behind the green half, in front of the red one
+	ASSERT_TRUE(DrawVertices(rasterizer, rectangle(0, Size, 0.0f, Blue)));
+
+	// In front of everything, but leaves the depth alone
+	state.depthWriting = false;
+	rasterizer.SetState(state);
+	ASSERT_TRUE(DrawVertices(rasterizer, rectangle(12, Size, -0.9f, Green)));
+
+	rasterizer.Finish();
+
+	const gl::ScreenPixel& left = GetPixel(rasterizer, 4, 8);
+	const gl::ScreenPixel& middle = GetPixel(rasterizer, 10, 8);
+	const gl::ScreenPixel& right = GetPixel(rasterizer, 14, 8);
+
+	EXPECT_EQ(255, left.colour.G);
+	EXPECT_FLOAT_EQ(0.25f, left.depth);
+	EXPECT_EQ(255, middle.colour.B);
+	EXPECT_FLOAT_EQ(0.5f, middle.depth);
+	EXPECT_EQ(255, right.colour.G);
+	EXPECT_FLOAT_EQ(0.5f, right.depth);
+
+	// Only what passes the comparison
+	state.depthWriting = true;
+	state.depthComparator = gl::Comparator::Greater;
+	rasterizer.SetState(state);
+	ASSERT_TRUE(DrawVertices(rasterizer, rectangle(0, Size, 0.2f, Red)));
+	rasterizer.Finish();
+
+	EXPECT_EQ(255, GetPixel(rasterizer, 4, 8).colour.R);
+	EXPECT_EQ(255, GetPixel(rasterizer, 10, 8).colour.R);
+	EXPECT_FLOAT_EQ(0.6f, GetPixel(rasterizer, 10, 8).depth);
+}
+
+TEST(Rasterizer, BlendsInSubmissionOrder)
+{
+	constexpr float HalfRed[4] = { 1, 0, 0, 0.5f };
+	constexpr float HalfGreen[4] = { 0, 1, 0, 0.5f };
+	constexpr float Size = 16;
+
+	const auto screen = [&](const float(&colour)[4]) {
+		return std::vector<Vertex>{ AtPixel(-16, -16, Size, 0, colour), AtPixel(-16, 48, Size, 0, colour), AtPixel(48, -16, Size, 0, colour) };
+	};
+
+	gl::raster::DrawState state{};
+	state.depthTesting = false;
+	state.blending = true;
+	state.blendMode = gl::DefaultAlpha;
+
+	// Over the clear colour
+	gl::SoftwareRasterizer over{ 16, 16, 4 };
+	over.Clear(gl::Colour{ std::uint8_t{ 0 }, std::uint8_t{ 0 }, std::uint8_t{ 255 } });
+	over.SetState(state);
+	ASSERT_TRUE(DrawVertices(over, screen(HalfRed)));
+	over.Finish();
+
+	EXPECT_EQ(128, GetPixel(over, 3, 3).colour.R);
+	EXPECT_EQ(0, GetPixel(over, 3, 3).colour.G);
+	EXPECT_EQ(128, GetPixel(over, 3, 3).colour.B);
+	EXPECT_EQ(191, GetPixel(over, 3, 3).colour.A);
+
+	// Both in one draw, binned by different workers, and in two draws
+	std::vector<Vertex> both = screen(HalfRed);
+	const std::vector<Vertex> green = screen(HalfGreen);
+	both.insert(both.end(), green.begin(), green.end());
+
+	gl::SoftwareRasterizer single{ 16, 16, 4 };
+	single.Clear(gl::Colour{ std::uint8_t{ 0 }, std::uint8_t{ 0 }, std::uint8_t{ 0 } });
+	single.SetState(state);
+	ASSERT_TRUE(DrawVertices(single, both));
+	single.Finish();
+
+	gl::SoftwareRasterizer separate{ 16, 16, 4 };
+	separate.Clear(gl::Colour{ std::uint8_t{ 0 }, std::uint8_t{ 0 }, std::uint8_t{ 0 } });
+	separate.SetState(state);
+	ASSERT_TRUE(DrawVertices(separate, screen(HalfRed)));
+	ASSERT_TRUE(DrawVertices(separate, green));
+	separate.Finish();
+
+	for (const gl::SoftwareRasterizer* rasterizer : { &single, &separate })
+	{
+		EXPECT_EQ(64, GetPixel(*rasterizer, 8, 8).colour.R);
+		EXPECT_EQ(128, GetPixel(*rasterizer, 8, 8).colour.G);
+	}
+}
+
+TEST(Rasterizer, CullsByWinding)
+{
+	constexpr float White[4] = { 1, 1, 1, 1 };
+	constexpr float Size = 16;
+
+	// Counter clockwise in normalized device coordinates, so clockwise on the rows going down
+	const Vertex front[3] = { AtPixel(2, 14, Size, 0, White), AtPixel(14, 14, Size, 0, White), AtPixel(8, 2, Size, 0, White) };
+	const Vertex back[3] = { front[0], front[2], front[1] };
+
+	const auto draw = [&](const Vertex(&triangle)[3], gl::Face face, bool clockwise) {
+		gl::raster::DrawState state{};
+		state.depthTesting = false;
+		state.culling = true;
+		state.cullFace = face;
+		state.clockwise = clockwise;
+
+		gl::SoftwareRasterizer rasterizer{ 16, 16, 1 };
+		rasterizer.Clear(gl::Colour{ std::uint8_t{ 0 }, std::uint8_t{ 0 }, std::uint8_t{ 0 } });
+		rasterizer.SetState(state);
+		EXPECT_TRUE(DrawVertices(rasterizer, triangle));
+		rasterizer.Finish();
+
+		const bool drawn = 255 == GetPixel(rasterizer, 8, 10).colour.R;
+		EXPECT_EQ(drawn ? 0U : 1U, rasterizer.GetStatistics().culledTriangles);
+
+		return drawn;
+	};
+
+	EXPECT_TRUE(draw(front, gl::Face::Back, false));
+	EXPECT_FALSE(draw(back, gl::Face::Back, false));
+	EXPECT_FALSE(draw(front, gl::Face::Front, false));
+	EXPECT_TRUE(draw(back, gl::Face::Front, false));
+
+	// Clockwise fronts
+	EXPECT_FALSE(draw(front, gl::Face::Back, true));
+	EXPECT_TRUE(draw(back, gl::Face::Back, true));
+
+	EXPECT_FALSE(draw(front, gl::Face::FrontAndBack, false));
+	EXPECT_FALSE(draw(back, gl::Face::FrontAndBack, false));
+}
+
+TEST(Rasterizer, SameImageOnAnyThreadCount)
+{
+	constexpr std::uint32_t Width = 200;
+	constexpr std::uint32_t Height = 150;
+
+	// Overlapping translucent triangles at random depths, some crossing the near plane and the tile borders
+	std::mt19937 engine{ 7 };
+	std::uniform_real_distribution<float> position{ -1.2f, 1.2f };
+	std::uniform_real_distribution<float> depth{ -1.1f, 1.0f };
+	std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+
+	std::vector<Vertex> vertices(3 * 500);
+	for (Vertex& vertex : vertices)
+	{
+		vertex = Vertex{ { position(engine), position(engine), depth(engine) }, { unit(engine), unit(engine), unit(engine), unit(engine) } };
+	}
+
+	gl::raster::DrawState state{};
+	state.blending = true;
+	state.blendMode = gl::DefaultAlpha;
+	state.depthComparator = gl::Comparator::LessOrEqual;
+
+	const auto render = [&](std::uint32_t threads) {
+		gl::SoftwareRasterizer rasterizer{ Width, Height, threads };
+		rasterizer.Clear(gl::Colour{ std::uint8_t{ 20 }, std::uint8_t{ 40 }, std::uint8_t{ 60 } });
+		rasterizer.SetState(state);
+
+		// Several draws, so the batches are ordered as well as the bins
+		for (std::size_t first = 0; first < vertices.size(); first += 300)
+		{
+			EXPECT_TRUE(DrawVertices(rasterizer, std::span{ vertices }.subspan(first, 300)));
+		}
+		rasterizer.Finish();
+
+		return std::make_pair(std::vector<gl::ScreenPixel>(rasterizer.GetPixels().begin(), rasterizer.GetPixels().end()), rasterizer.GetStatistics());
+	};
+
+	const auto [expected, expected_statistics] = render(1);
+	EXPECT_LT(0U, expected_statistics.clippedTriangles + expected_statistics.binnedTriangles);
+
+	for (const std::uint32_t threads : { 2U, 3U, 8U })
+	{
+		const auto [pixels, statistics] = render(threads);
+		ASSERT_EQ(expected.size(), pixels.size());
+
+		for (std::size_t i = 0; i < pixels.size(); ++i)
+		{
+			ASSERT_EQ(expected[i].colour.R, pixels[i].colour.R) << threads << " threads, pixel " << i;
+			ASSERT_EQ(expected[i].colour.G, pixels[i].colour.G) << threads << " threads, pixel " << i;
+			ASSERT_EQ(expected[i].colour.B, pixels[i].colour.B) << threads << " threads, pixel " << i;
+			ASSERT_EQ(expected[i].colour.A, pixels[i].colour.A) << threads << " threads, pixel " << i;
+			ASSERT_EQ(expected[i].depth, pixels[i].depth) << threads << " threads, pixel " << i;
+		}
+
+		EXPECT_EQ(expected_statistics.binnedTriangles, statistics.binnedTriangles);
+		EXPECT_EQ(expected_statistics.culledTriangles, statistics.culledTriangles);
+		EXPECT_EQ(expected_statistics.shadedPixels, statistics.shadedPixels);
+	}
+}
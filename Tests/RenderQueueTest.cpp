@@ -0,0 +1,296 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "Glib.hpp"
+#include "Glib.RenderQueue.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// Sorted through the queue's radix sort and through std::stable_sort, which have to agree on the order of equal keys too
+	void
+	ExpectStableOrder(const std::vector<std::uint64_t>& source, std::uint32_t threads)
+	{
+		std::vector<std::uint64_t> keys = source, scratch_keys(source.size());
+		std::vector<std::uint32_t> values(source.size()), scratch_values(source.size());
+		std::iota(values.begin(), values.end(), 0U);
+
+		gl::render::RadixSort(keys, values, scratch_keys, scratch_values, threads);
+
+		std::vector<std::pair<std::uint64_t, std::uint32_t>> expected(source.size());
+		for (std::size_t i = 0; i < source.size(); ++i)
+		{
+			expected[i] = { source[i], static_cast<std::uint32_t>(i) };
+		}
+
+		std::ranges::stable_sort(expected, {}, &std::pair<std::uint64_t, std::uint32_t>::first);
+
+		for (std::size_t i = 0; i < source.size(); ++i)
+		{
+			ASSERT_EQ(expected[i].first, keys[i]) << i << " of " << source.size();
+			ASSERT_EQ(expected[i].second, values[i]) << i << " of " << source.size();
+		}
+	}
+
+	[[nodiscard]]
+	gl::render::DrawItem
+	MakeItem(std::uint64_t key, gl::Pipeline* pipeline, const gl::Texture* texture, const gl::BufferObject* buffer, bool blending = false)
+	{
+		gl::render::DrawItem item{};
+		item.key = key;
+		item.pipeline = pipeline;
+		item.texture = texture;
+		item.buffer = buffer;
+		item.blending = blending;
+		item.blendMode = blending ? gl::DefaultAlpha : gl::Opaque;
+		item.count = 3;
+
+		return item;
+	}
+
+	class RenderQueueTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			glstub::Reset();
+		}
+	};
+}
+
+TEST(SortKey, NaNDepthIsTheNearest)
+{
+	constexpr float NaN = std::numeric_limits<float>::quiet_NaN();
+
+	// A constant expression would not compile if the conversion were undefined
+	static_assert(gl::render::MakeSortKey(1, 2, 3, NaN, false) == gl::render::MakeSortKey(1, 2, 3, 0.0f, false));
+	static_assert(gl::render::MakeSortKey(1, 2, 3, NaN, true) == gl::render::MakeSortKey(1, 2, 3, 0.0f, true));
+
+	volatile float depth = NaN;
+	EXPECT_EQ(gl::render::MakeSortKey(0, 7, 9, 0.0f, false), gl::render::MakeSortKey(0, 7, 9, depth, false));
+	EXPECT_EQ(gl::render::MakeSortKey(0, 7, 9, 0.0f, true), gl::render::MakeSortKey(0, 7, 9, -depth, true));
+}
+
+TEST(SortKey, OrdersLayersThenTranslucencyThenDepth)
+{
+	using gl::render::MakeSortKey;
+
+	// Layers first, whatever the rest
+	EXPECT_LT(MakeSortKey(0, 4095, 65535, 1.0f, true), MakeSortKey(1, 0, 0, 0.0f, false));
+	// Opaque before translucent
+	EXPECT_LT(MakeSortKey(2, 4095, 65535, 1.0f, false), MakeSortKey(2, 0, 0, 0.0f, true));
+	// Opaque by state, then front to back
+	EXPECT_LT(MakeSortKey(0, 1, 5, 1.0f, false), MakeSortKey(0, 2, 0, 0.0f, false));
+	EXPECT_LT(MakeSortKey(0, 1, 5, 0.25f, false), MakeSortKey(0, 1, 5, 0.5f, false));
+	// Translucent back to front, before the state
+	EXPECT_LT(MakeSortKey(0, 9, 9, 0.75f, true), MakeSortKey(0, 1, 1, 0.5f, true));
+	// Out of range depths are clamped
+	EXPECT_EQ(MakeSortKey(0, 1, 1, -3.0f, false), MakeSortKey(0, 1, 1, 0.0f, false));
+	EXPECT_EQ(MakeSortKey(0, 1, 1, 7.0f, true), MakeSortKey(0, 1, 1, 1.0f, true));
+}
+
+TEST(RadixSort, MatchesAStableSort)
+{
+	std::mt19937_64 engine{ 17 };
+
+	// Few distinct keys so most are equal, spread over every digit of the key
+	std::uniform_int_distribution<std::uint64_t> digit{ 0, 3 };
+	const auto make_key = [&]() {
+		std::uint64_t key = 0;
+		for (std::uint32_t i = 0; i < 8; ++i)
+		{
+			key |= digit(engine) << (i * 8 + 3 * (i % 2));
+		}
+
+		return key;
+	};
+
+	for (const std::size_t count : { 0U, 1U, 2U, 3U, 255U, 1000U })
+	{
+		std::vector<std::uint64_t> keys(count);
+		std::ranges::generate(keys, make_key);
+
+		ExpectStableOrder(keys, 1);
+		ExpectStableOrder(keys, 4);
+	}
+
+	// Enough keys for several workers
+	std::vector<std::uint64_t> keys(150000);
+	std::ranges::generate(keys, make_key);
+	ExpectStableOrder(keys, 4);
+	ExpectStableOrder(keys, 7);
+}
+
+TEST(RadixSort, KeepsEqualAndSortedKeysInPlace)
+{
+	std::vector<std::uint64_t> keys(40000, 0x0123456789ABCDEFULL);
+	ExpectStableOrder(keys, 3);
+
+	std::iota(keys.begin(), keys.end(), 0ULL);
+	ExpectStableOrder(keys, 3);
+
+	std::ranges::reverse(keys);
+	ExpectStableOrder(keys, 3);
+}
+
+TEST(RadixSort, SortsTheKeysOfRandomScenes)
+{
+	std::mt19937 engine{ 5 };
+	std::uniform_int_distribution<std::uint32_t> layer{ 0, 3 }, pipeline{ 0, 15 }, material{ 0, 63 };
+	std::uniform_real_distribution<float> depth{ -0.5f, 1.5f };
+	std::bernoulli_distribution translucent{ 0.3 };
+
+	std::vector<std::uint64_t> keys(70000);
+	for (std::uint64_t& key : keys)
+	{
+		key = gl::render::MakeSortKey(static_cast<std::uint8_t>(layer(engine)), static_cast<std::uint16_t>(pipeline(engine)), static_cast<std::uint16_t>(material(engine)), depth(engine), translucent(engine));
+	}
+
+	ExpectStableOrder(keys, 0);
+}
+
+TEST_F(RenderQueueTest, SubmitSkipsTheStatesItAlreadyBound)
+{
+	gl::Pipeline first_pipeline{}, second_pipeline{};
+	const gl::Texture first_texture = gl::LoadTexture("first.png");
+	const gl::Texture second_texture = gl::LoadTexture("second.png");
+
+	gl::BufferObject buffer{};
+	buffer.SetLayout([] {
+		gl::BufferLayout layout{};
+		layout.AddElement<float>(3);
+		return layout;
+	}());
+	buffer.Create(gl::buffer::BufferType::Array, gl::buffer::BufferUsage::StaticDraw, nullptr, 64);
+
+	glstub::Reset();
+
+	gl::RenderQueue queue{ 2 };
+
+	// Pushed out of order, drawn as the first pipeline with the first texture twice, then with the second texture, then the second pipeline with it
+	queue.Push(MakeItem(gl::render::MakeSortKey(0, 2, 0, 0.1f, false), &second_pipeline, &second_texture, &buffer));
+	queue.Push(MakeItem(gl::render::MakeSortKey(0, 1, 0, 0.5f, false), &first_pipeline, &first_texture, &buffer));
+	queue.Push(MakeItem(gl::render::MakeSortKey(0, 1, 1, 0.5f, false), &first_pipeline, &second_texture, &buffer));
+	queue.Push(MakeItem(gl::render::MakeSortKey(0, 1, 0, 0.2f, false), &first_pipeline, &first_texture, &buffer));
+
+	queue.Submit();
+
+	EXPECT_EQ((std::vector<std::uint32_t>{ 3, 1, 2, 0 }), (std::vector<std::uint32_t>(queue.GetOrder().begin(), queue.GetOrder().end())));
+
+	const gl::render::Statistics& statistics = queue.GetStatistics();
+	EXPECT_EQ(4U, statistics.items);
+	EXPECT_EQ(4U, statistics.drawCalls);
+	EXPECT_EQ(2U, statistics.pipelineChanges);
+	EXPECT_EQ(2U, statistics.textureChanges);
+	EXPECT_EQ(1U, statistics.bufferChanges);
+	// Only the first item sets the blending
+	EXPECT_EQ(1U, statistics.blendChanges);
+	// Two pipelines, two textures, three buffers and three blending states were left as they were
+	EXPECT_EQ(10U, statistics.skippedChanges);
+
+	// What reached opengl
+	const std::vector<glstub::Call> programs = glstub::FindCalls("glUseProgram");
+	ASSERT_EQ(2U, programs.size());
+	EXPECT_EQ(first_pipeline.GetID(), programs[0].args[0]);
+	EXPECT_EQ(second_pipeline.GetID(), programs[1].args[0]);
+
+	const std::vector<glstub::Call> textures = glstub::FindCalls("glBindTexture");
+	ASSERT_EQ(2U, textures.size());
+	EXPECT_EQ(first_texture.GetID(), textures[0].args[1]);
+	EXPECT_EQ(second_texture.GetID(), textures[1].args[1]);
+
+	// Bound once, and left bound with its attributes
+	const std::vector<glstub::Call> buffers = glstub::FindCalls("glBindBuffer");
+	ASSERT_EQ(1U, buffers.size());
+	EXPECT_EQ(buffer.GetID(), buffers[0].args[1]);
+	EXPECT_EQ(1U, glstub::CountCalls("glEnableVertexAttribArray"));
+	EXPECT_EQ(0U, glstub::CountCalls("glDisableVertexAttribArray"));
+	EXPECT_EQ(1U, glstub::CountCalls("glDisable"));
+	EXPECT_EQ(0U, glstub::CountCalls("glBlendFunc"));
+	EXPECT_EQ(4U, glstub::CountCalls("glDrawArrays"));
+}
+
+TEST_F(RenderQueueTest, SubmitChangesTheBlendingOnlyWhenItDiffers)
+{
+	gl::RenderQueue queue{ 1 };
+
+	std::vector<int> drawn{};
+	const auto push = [&](std::uint64_t key, bool blending, const gl::BlendMode& mode) {
+		gl::render::DrawItem item = MakeItem(key, nullptr, nullptr, nullptr, blending);
+		item.blendMode = mode;
+		item.renderer = [&drawn, key]() noexcept { drawn.push_back(static_cast<int>(key)); };
+		queue.Push(std::move(item));
+	};
+
+	const gl::BlendMode additive{ gl::BlendOption::One, gl::BlendOption::One };
+
+	push(1, false, gl::Opaque);
+	// The mode of an item without blending is ignored
+	push(2, false, additive);
+	push(3, true, gl::DefaultAlpha);
+	push(4, true, gl::DefaultAlpha);
+	push(5, true, additive);
+	push(6, false, gl::Opaque);
+
+	queue.Submit();
+
+	EXPECT_EQ((std::vector<int>{ 1, 2, 3, 4, 5, 6 }), drawn);
+	EXPECT_EQ(4U, queue.GetStatistics().blendChanges);
+	EXPECT_EQ(2U, queue.GetStatistics().skippedChanges);
+	EXPECT_EQ(0U, queue.GetStatistics().pipelineChanges);
+
+	// The renderers drew instead
+	EXPECT_EQ(0U, glstub::CountCalls("glDrawArrays"));
+
+	const std::vector<glstub::Call> functions = glstub::FindCalls("glBlendFunc");
+	ASSERT_EQ(2U, functions.size());
+	EXPECT_EQ((std::vector<std::int64_t>{ GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA }), functions[0].args);
+	EXPECT_EQ((std::vector<std::int64_t>{ GL_ONE, GL_ONE }), functions[1].args);
+	EXPECT_EQ(2U, glstub::CountCalls("glDisable"));
+	EXPECT_EQ(2U, glstub::CountCalls("glEnable"));
+	EXPECT_FALSE(glstub::GetState().capabilities.at(GL_BLEND));
+}
+
+TEST_F(RenderQueueTest, EqualKeysKeepTheirSubmissionOrder)
+{
+	gl::RenderQueue queue{ 4 };
+
+	std::vector<int> drawn{};
+	for (int i = 0; i < 20; ++i)
+	{
+		gl::render::DrawItem item{};
+		item.key = gl::render::MakeSortKey(static_cast<std::uint8_t>(i % 2), 0, 0, 0.5f, false);
+		item.renderer = [&drawn, i]() noexcept { drawn.push_back(i); };
+		queue.Push(std::move(item));
+	}
+
+	queue.Submit();
+
+	std::vector<int> expected{};
+	for (int i = 0; i < 20; i += 2)
+	{
+		expected.push_back(i);
+	}
+	for (int i = 1; i < 20; i += 2)
+	{
+		expected.push_back(i);
+	}
+
+	EXPECT_EQ(expected, drawn);
+
+	// Nothing pushed since, the order is kept
+	drawn.clear();
+	queue.Submit();
+	EXPECT_EQ(expected, drawn);
+
+	queue.Clear();
+	EXPECT_TRUE(queue.IsEmpty());
+	queue.Submit();
+	EXPECT_EQ(0U, queue.GetStatistics().drawCalls);
+}
@@ -0,0 +1,355 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "RecordingDevice.hpp"
+#include "Glib.hpp"
+#include "Glib.RenderTarget.hpp"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	constexpr gl::target::Description Scene{ 1920, 1080, gl::target::Format::RGBA16F };
+	constexpr gl::target::Description Depth{ 1920, 1080, gl::target::Format::Depth24Stencil8 };
+	constexpr gl::target::Description Half{ 960, 540, gl::target::Format::RGBA16F };
+
+	// A scene pass, a bloom chain ping-ponging at half size and a tonemap into the size of the scene
+	void DrawFrame(gl::TransientTargets& targets)
+	{
+		targets.BeginFrame();
+
+		const gl::target::Handle scene = targets.Acquire(Scene);
+		const gl::target::Handle depth = targets.Acquire(Depth);
+		const gl::target::Handle scene_colours[] = { scene };
+		targets.GetFramebuffer(scene_colours, depth).Bind();
+		targets.Release(depth);
+
+		const gl::target::Handle first = targets.Acquire(Half);
+		targets.Release(scene);
+		const gl::target::Handle second = targets.Acquire(Half);
+		targets.Release(first);
+		const gl::target::Handle third = targets.Acquire(Half);
+		const gl::target::Handle bloom_colours[] = { third };
+		targets.GetFramebuffer(bloom_colours).Bind();
+
+		const gl::target::Handle tonemap = targets.Acquire(Scene);
+		targets.Release(second);
+		targets.Release(third);
+		const gl::target::Handle tonemap_colours[] = { tonemap };
+		targets.GetFramebuffer(tonemap_colours).Bind();
+		targets.Release(tonemap);
+
+		targets.EndFrame();
+	}
+}
+
+TEST(RenderTargetTest, ReleasedTargetsAreAliasedInTheSameFrame)
+{
+	glstub::RecordingDevice device{};
+
+	{
+		gl::TransientTargets targets{ device };
+		targets.BeginFrame();
+
+		const gl::target::Handle first = targets.Acquire(Scene);
+		const std::uint32_t texture = targets.GetTarget(first).GetID();
+		targets.Release(first);
+
+		const gl::target::Handle second = targets.Acquire(Scene);
+		EXPECT_EQ(first, second);
+		EXPECT_EQ(texture, targets.GetTarget(second).GetID());
+
+		// Another description never shares the texture
+		const gl::target::Handle half = targets.Acquire(Half);
+		EXPECT_NE(texture, targets.GetTarget(half).GetID());
+
+		const gl::target::Statistics& statistics = targets.GetStatistics();
+		EXPECT_EQ(3U, statistics.acquired);
+		EXPECT_EQ(2U, statistics.created);
+		EXPECT_EQ(1U, statistics.aliased);
+		EXPECT_EQ(0U, statistics.reused);
+
+		targets.EndFrame();
+	}
+
+	EXPECT_TRUE(device.textures.empty());
+	EXPECT_TRUE(device.errors.empty()) << device.errors.front();
+}
+
+TEST(RenderTargetTest, TargetsInUseAreNeverShared)
+{
+	glstub::RecordingDevice device{};
+	gl::TransientTargets targets{ device };
+	targets.BeginFrame();
+
+	const gl::target::Handle first = targets.Acquire(Scene);
+	const gl::target::Handle second = targets.Acquire(Scene);
+
+	EXPECT_NE(first, second);
+	EXPECT_NE(targets.GetTarget(first).GetID(), targets.GetTarget(second).GetID());
+	EXPECT_EQ(2U, targets.GetStatistics().created);
+	EXPECT_EQ(2U * gl::target::GetByteSize(Scene), targets.GetStatistics().peakBytes);
+
+	// Nor after the end of the frame gave them back, for the rest of it
+	targets.EndFrame();
+	targets.BeginFrame();
+
+	const gl::target::Handle third = targets.Acquire(Scene);
+	const gl::target::Handle fourth = targets.Acquire(Scene);
+	EXPECT_NE(third, fourth);
+	EXPECT_EQ(0U, targets.GetStatistics().created);
+	EXPECT_EQ(2U, targets.GetStatistics().reused);
+	EXPECT_EQ(2U, device.created.size());
+}
+
+TEST(RenderTargetTest, TargetsAreReusedAcrossFrames)
+{
+	glstub::RecordingDevice device{};
+	gl::TransientTargets targets{ device };
+
+	targets.BeginFrame();
+	const std::uint32_t texture = targets.GetTarget(targets.Acquire(Scene)).GetID();
+	targets.EndFrame();
+
+	targets.BeginFrame();
+	const gl::target::Handle handle = targets.Acquire(Scene);
+	targets.EndFrame();
+
+	EXPECT_EQ(texture, targets.GetTarget(handle).GetID());
+	EXPECT_EQ(1U, targets.GetStatistics().reused);
+	EXPECT_EQ(0U, targets.GetStatistics().created);
+	EXPECT_EQ(1U, device.created.size());
+}
+
+TEST(RenderTargetTest, IdleTargetsAreDestroyedAfterTheirFrames)
+{
+	glstub::RecordingDevice device{};
+	gl::TransientTargets targets{ device, 2 };
+
+	targets.BeginFrame();
+	const gl::target::Handle handle = targets.Acquire(Scene);
+	const gl::target::Handle colours[] = { handle };
+	ASSERT_TRUE(targets.GetFramebuffer(colours).IsValid());
+	targets.EndFrame();
+
+	// Kept for two frames without use
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		targets.BeginFrame();
+		targets.EndFrame();
+
+		EXPECT_EQ(1U, device.textures.size());
+		EXPECT_EQ(1U, device.framebuffers.size());
+	}
+
+	targets.BeginFrame();
+	targets.EndFrame();
+
+	// The framebuffer goes with its target
+	EXPECT_TRUE(device.textures.empty());
+	EXPECT_TRUE(device.framebuffers.empty());
+
+	const gl::target::Statistics& statistics = targets.GetStatistics();
+	EXPECT_EQ(1U, statistics.destroyed);
+	EXPECT_EQ(0U, statistics.liveTargets);
+	EXPECT_EQ(0U, statistics.liveFramebuffers);
+	EXPECT_EQ(0U, statistics.residentBytes);
+
+	// The slot is handed out again, with a framebuffer of its new texture
+	targets.BeginFrame();
+	const gl::target::Handle again = targets.Acquire(Scene);
+	const gl::target::Handle again_colours[] = { again };
+	targets.GetFramebuffer(again_colours).Bind();
+	targets.EndFrame();
+
+	EXPECT_EQ(handle, again);
+	EXPECT_EQ(2U, device.created.size());
+	EXPECT_EQ(2U, device.createdFramebuffers);
+	EXPECT_TRUE(device.errors.empty()) << device.errors.front();
+}
+
+TEST(RenderTargetTest, FramebuffersAreCachedByTheirTargets)
+{
+	glstub::RecordingDevice device{};
+	gl::TransientTargets targets{ device };
+	targets.BeginFrame();
+
+	const gl::target::Handle colour = targets.Acquire(Scene);
+	const gl::target::Handle normal = targets.Acquire(Scene);
+	const gl::target::Handle depth = targets.Acquire(Depth);
+
+	const gl::target::Handle both[] = { colour, normal };
+	const gl::Framebuffer& first = targets.GetFramebuffer(both, depth);
+	const gl::Framebuffer& second = targets.GetFramebuffer(both, depth);
+
+	EXPECT_EQ(&first, &second);
+	EXPECT_EQ(1U, device.createdFramebuffers);
+	EXPECT_EQ(2U, first.GetColourCount());
+	EXPECT_EQ(Scene.width, first.GetWidth());
+	EXPECT_EQ(Scene.height, first.GetHeight());
+
+	// The attachments and their order tell the framebuffers apart
+	const gl::target::Handle swapped[] = { normal, colour };
+	EXPECT_NE(&first, &targets.GetFramebuffer(swapped, depth));
+	EXPECT_NE(&first, &targets.GetFramebuffer(both));
+	EXPECT_EQ(3U, device.createdFramebuffers);
+	EXPECT_EQ(3U, targets.GetStatistics().liveFramebuffers);
+
+	targets.EndFrame();
+}
+
+TEST(RenderTargetTest, MemoryStaysFlatFromFrameToFrame)
+{
+	glstub::RecordingDevice device{};
+
+	{
+		gl::TransientTargets targets{ device };
+
+		DrawFrame(targets);
+		const std::size_t textures = device.created.size();
+		const std::size_t framebuffers = device.createdFramebuffers;
+
+		// The bloom chain aliases its first target and the tonemap the scene
+		EXPECT_EQ(4U, textures);
+		EXPECT_EQ(2U, targets.GetStatistics().aliased);
+		EXPECT_EQ(gl::target::GetByteSize(Scene) + gl::target::GetByteSize(Depth), targets.GetStatistics().peakBytes);
+
+		for (int frame = 0; frame < 10; ++frame)
+		{
+			DrawFrame(targets);
+
+			const gl::target::Statistics& statistics = targets.GetStatistics();
+			EXPECT_EQ(0U, statistics.created);
+			EXPECT_EQ(0U, statistics.destroyed);
+			EXPECT_EQ(4U, statistics.reused);
+			EXPECT_EQ(2U, statistics.aliased);
+			EXPECT_EQ(4U, statistics.liveTargets);
+		}
+
+		EXPECT_EQ(textures, device.created.size());
+		EXPECT_EQ(framebuffers, device.createdFramebuffers);
+		EXPECT_EQ(4U, device.peakTextures);
+	}
+
+	EXPECT_TRUE(device.textures.empty());
+	EXPECT_TRUE(device.framebuffers.empty());
+	EXPECT_TRUE(device.errors.empty()) << device.errors.front();
+}
+
+TEST(RenderTargetTest, ClearDestroysEverything)
+{
+	glstub::RecordingDevice device{};
+	gl::TransientTargets targets{ device };
+
+	DrawFrame(targets);
+	targets.Clear();
+
+	EXPECT_TRUE(device.textures.empty());
+	EXPECT_TRUE(device.framebuffers.empty());
+
+	// And the pool still works afterwards
+	DrawFrame(targets);
+	EXPECT_EQ(4U, targets.GetStatistics().created);
+	EXPECT_TRUE(device.errors.empty()) << device.errors.front();
+}
+
+TEST(RenderTargetTest, MovesHandTheNamesOver)
+{
+	glstub::RecordingDevice device{};
+
+	{
+		gl::RenderTarget target{ gl::target::Description{ 4, 4, gl::target::Format::RGBA8 }, device };
+		gl::RenderTarget moved{ std::move(target) };
+		EXPECT_FALSE(target.IsValid());
+
+		gl::RenderTarget assigned{};
+		assigned = std::move(moved);
+		EXPECT_FALSE(moved.IsValid());
+		ASSERT_TRUE(assigned.IsValid());
+		EXPECT_EQ(4U, assigned.GetWidth());
+		EXPECT_EQ(64U, assigned.GetByteSize());
+
+		const gl::RenderTarget* colours[] = { &assigned };
+		gl::Framebuffer framebuffer{ colours, nullptr, device };
+		gl::Framebuffer other{ std::move(framebuffer) };
+		EXPECT_FALSE(framebuffer.IsValid());
+
+		other.Bind();
+		assigned.Bind(3);
+		framebuffer.Bind();
+		EXPECT_EQ((std::vector<std::uint32_t>{ other.GetID() }), device.boundFramebuffers);
+		EXPECT_EQ((std::vector<std::uint32_t>{ assigned.GetID() }), device.boundTextures);
+
+		// Assigning over a live target deletes it first
+		gl::RenderTarget replaced{ gl::target::Description{ 2, 2, gl::target::Format::R8 }, device };
+		replaced = gl::RenderTarget{ gl::target::Description{ 8, 8, gl::target::Format::R8 }, device };
+		EXPECT_EQ(1U, device.deletedTextures);
+	}
+
+	EXPECT_EQ(3U, device.deletedTextures);
+	EXPECT_TRUE(device.textures.empty());
+	EXPECT_TRUE(device.framebuffers.empty());
+	EXPECT_TRUE(device.errors.empty()) << device.errors.front();
+}
+
+TEST(RenderTargetTest, IncompleteFramebuffersAreNotCounted)
+{
+	glstub::RecordingDevice device{};
+	device.isComplete = false;
+
+	gl::TransientTargets targets{ device };
+	targets.BeginFrame();
+
+	const gl::target::Handle colours[] = { targets.Acquire(Scene) };
+	const gl::Framebuffer& framebuffer = targets.GetFramebuffer(colours);
+	EXPECT_FALSE(framebuffer.IsValid());
+	EXPECT_EQ(0U, targets.GetStatistics().liveFramebuffers);
+
+	framebuffer.Bind();
+	EXPECT_TRUE(device.boundFramebuffers.empty());
+
+	// Not cached either, the next try asks the device again
+	device.isComplete = true;
+	EXPECT_TRUE(targets.GetFramebuffer(colours).IsValid());
+	EXPECT_EQ(2U, device.createdFramebuffers);
+
+	targets.EndFrame();
+}
+
+TEST(RenderTargetTest, OpenGLDeviceKeepsTheBoundFramebuffer)
+{
+	glstub::Reset();
+	glstub::GetState().integers[GL_FRAMEBUFFER_BINDING] = { 5 };
+
+	{
+		gl::RenderTarget colour{ Half };
+		gl::RenderTarget depth{ gl::target::Description{ Half.width, Half.height, gl::target::Format::Depth24Stencil8 } };
+		ASSERT_EQ(2U, glstub::GetState().textures.size());
+
+		const std::vector<glstub::Call> storage = glstub::FindCalls("glTexStorage2D");
+		ASSERT_EQ(2U, storage.size());
+		EXPECT_EQ((std::vector<std::int64_t>{ GL_TEXTURE_2D, 1, GL_RGBA16F, 960, 540 }), storage[0].args);
+
+		const gl::RenderTarget* colours[] = { &colour };
+		gl::Framebuffer framebuffer{ colours, &depth };
+		ASSERT_TRUE(framebuffer.IsValid());
+
+		const std::vector<glstub::Call> attachments = glstub::FindCalls("glFramebufferTexture2D");
+		ASSERT_EQ(2U, attachments.size());
+		EXPECT_EQ(GL_COLOR_ATTACHMENT0, attachments[0].args[1]);
+		EXPECT_EQ(GL_DEPTH_STENCIL_ATTACHMENT, attachments[1].args[1]);
+		EXPECT_EQ((std::vector<GLint>{ 5 }), glstub::GetState().integers.at(GL_FRAMEBUFFER_BINDING));
+
+		framebuffer.Bind();
+		EXPECT_EQ((std::vector<GLint>{ 0, 0, 960, 540 }), glstub::GetState().integers.at(GL_VIEWPORT));
+
+		// An incomplete framebuffer is deleted right away
+		glstub::GetState().framebufferStatus = GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+		gl::Framebuffer incomplete{ colours, nullptr };
+		EXPECT_FALSE(incomplete.IsValid());
+		EXPECT_EQ(1U, glstub::GetState().framebuffers.size());
+	}
+
+	EXPECT_TRUE(glstub::GetState().textures.empty());
+	EXPECT_TRUE(glstub::GetState().framebuffers.empty());
+}
@@ -0,0 +1,391 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "Glib.Residency.hpp"
+#include "Glib.Texture.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Event
+	{
+		gl::residency::handle_t handle;
+		std::uint32_t object;
+		gl::residency::EvictAction action;
+	};
+
+	// Every notification of the manager, in order
+	struct Recorder
+	{
+		void
+		Listen(gl::ResidencyManager& manager)
+		{
+			manager.SetEvictHandler([this](const gl::residency::Allocation& allocation, gl::residency::EvictAction action) {
+				events.push_back(Event{ allocation.handle, allocation.object, action });
+			});
+		}
+
+		[[nodiscard]]
+		std::size_t
+		Count(gl::residency::EvictAction action)
+		const
+		{
+			std::size_t result = 0;
+			for (const Event& event : events)
+			{
+				result += action == event.action ? 1 : 0;
+			}
+
+			return result;
+		}
+
+		std::vector<Event> events;
+	};
+}
+
+TEST(ResidencyManager, AccountsTheBudgetAndThePeak)
+{
+	gl::ResidencyManager manager{ 1000 };
+
+	const auto buffer = manager.Allocate(gl::residency::ResourceKind::Buffer, 400, 1, 100);
+	// 256 + 64 + 16 + 4 + 1
+	const auto texture = manager.Allocate(gl::residency::ResourceKind::Texture, 256, 5);
+
+	EXPECT_EQ(741U, manager.GetResidentBytes());
+	EXPECT_EQ(100U, manager.GetStatistics().cpuBytes);
+	EXPECT_EQ(2U, manager.GetStatistics().numberOfAllocations);
+	EXPECT_FALSE(manager.IsOverBudget());
+
+	manager.Free(buffer);
+	EXPECT_EQ(341U, manager.GetResidentBytes());
+	EXPECT_EQ(0U, manager.GetStatistics().cpuBytes);
+	EXPECT_EQ(741U, manager.GetStatistics().peakBytes);
+	EXPECT_EQ(nullptr, manager.Find(buffer));
+
+	ASSERT_NE(nullptr, manager.Find(texture));
+	EXPECT_EQ(5U, manager.Find(texture)->mipLevels);
+
+	manager.SetBudget(300);
+	EXPECT_TRUE(manager.IsOverBudget());
+}
+
+TEST(ResidencyManager, EvictsTheLeastRecentlyUsedFirst)
+{
+	gl::ResidencyManager manager{ 250 };
+	Recorder recorder{};
+	recorder.Listen(manager);
+
+	const auto first = manager.Allocate(gl::residency::ResourceKind::Buffer, 100);
+	const auto second = manager.Allocate(gl::residency::ResourceKind::Buffer, 100);
+	const auto third = manager.Allocate(gl::residency::ResourceKind::Buffer, 100);
+
+	manager.BeginFrame();
+	EXPECT_TRUE(manager.Touch(first));
+	manager.BeginFrame();
+
+	// The second is now the least recently used
+	EXPECT_EQ(100U, manager.Enforce());
+
+	ASSERT_EQ(1U, recorder.events.size());
+	EXPECT_EQ(second, recorder.events[0].handle);
+	EXPECT_EQ(gl::residency::EvictAction::Evict, recorder.events[0].action);
+	EXPECT_FALSE(manager.Find(second)->isResident);
+	EXPECT_TRUE(manager.Find(third)->isResident);
+	EXPECT_EQ(1U, manager.GetStatistics().evictions);
+}
+
+TEST(ResidencyManager, KeepsWhatIsUsedInThisFrame)
+{
+	gl::ResidencyManager manager{ 100 };
+	Recorder recorder{};
+	recorder.Listen(manager);
+
+	const auto first = manager.Allocate(gl::residency::ResourceKind::Buffer, 100);
+	const auto second = manager.Allocate(gl::residency::ResourceKind::Buffer, 100);
+
+	manager.BeginFrame();
+	EXPECT_TRUE(manager.Touch(second));
+	EXPECT_TRUE(manager.Touch(first));
+
+	EXPECT_EQ(0U, manager.Enforce());
+	EXPECT_TRUE(recorder.events.empty());
+	EXPECT_TRUE(manager.IsOverBudget());
+
+	// Only the one left alone in the next frame goes
+	manager.BeginFrame();
+	EXPECT_TRUE(manager.Touch(first));
+	EXPECT_EQ(100U, manager.Enforce());
+	ASSERT_EQ(1U, recorder.events.size());
+	EXPECT_EQ(second, recorder.events[0].handle);
+}
+
+TEST(ResidencyManager, DropsMipsBeforeEvicting)
+{
+	gl::ResidencyManager manager{ 400 };
+	Recorder recorder{};
+	recorder.Listen(manager);
+
+	// 1024 + 256 + 64
+	const auto texture = manager.Allocate(gl::residency::ResourceKind::Texture, 1024, 3);
+	manager.BeginFrame();
+
+	EXPECT_EQ(1024U, manager.Enforce());
+	ASSERT_EQ(1U, recorder.events.size());
+	EXPECT_EQ(gl::residency::EvictAction::DropMip, recorder.events[0].action);
+	EXPECT_EQ(1U, manager.Find(texture)->residentMip);
+	EXPECT_EQ(320U, manager.GetResidentBytes());
+	EXPECT_FALSE(manager.Touch(texture));
+
+	// The last level is evicted with the resource, never dropped
+	manager.SetBudget(50);
+	manager.BeginFrame();
+	EXPECT_EQ(320U, manager.Enforce());
+
+	ASSERT_EQ(3U, recorder.events.size());
+	EXPECT_EQ(gl::residency::EvictAction::DropMip, recorder.events[1].action);
+	EXPECT_EQ(gl::residency::EvictAction::Evict, recorder.events[2].action);
+	EXPECT_EQ(2U, manager.GetStatistics().droppedMips);
+	EXPECT_EQ(0U, manager.GetResidentBytes());
+	EXPECT_FALSE(manager.Find(texture)->isResident);
+}
+
+TEST(ResidencyManager, RestoreNotifiesAndAccountsEveryLevel)
+{
+	gl::ResidencyManager manager{ 0 };
+	Recorder recorder{};
+	recorder.Listen(manager);
+
+	const auto texture = manager.Allocate(gl::residency::ResourceKind::Texture, 64, 4);
+	// Already resident, nothing to tell
+	manager.Restore(texture);
+	EXPECT_TRUE(recorder.events.empty());
+
+	manager.BeginFrame();
+	(void)manager.Enforce();
+	ASSERT_FALSE(manager.Find(texture)->isResident);
+	recorder.events.clear();
+
+	manager.Restore(texture);
+	ASSERT_EQ(1U, recorder.events.size());
+	EXPECT_EQ(gl::residency::EvictAction::Restore, recorder.events[0].action);
+	EXPECT_EQ(gl::residency::ComputeMipChainBytes(64, 4), manager.GetResidentBytes());
+	EXPECT_EQ(0U, manager.Find(texture)->residentMip);
+	EXPECT_TRUE(manager.Touch(texture));
+}
+
+TEST(ResidencyManager, TouchReloadsWhatWasEvicted)
+{
+	gl::ResidencyManager manager{ 0 };
+
+	std::vector<std::string> log{};
+	manager.SetEvictHandler([&log](const gl::residency::Allocation& allocation, gl::residency::EvictAction action) {
+		EXPECT_EQ(7U, allocation.object);
+		log.push_back(gl::residency::EvictAction::Restore == action ? "restore" : "evict");
+	});
+
+	const auto handle = manager.OnCreate(gl::residency::ResourceKind::Texture, 7, 16, 1, 16
+		, [] {}, [&log] { log.push_back("reload"); });
+
+	manager.BeginFrame();
+	EXPECT_EQ(16U, manager.Enforce());
+	EXPECT_EQ(0U, manager.GetResidentBytes());
+
+	// Sampling from the first level again before the contents come back
+	EXPECT_TRUE(manager.Touch(handle));
+	EXPECT_EQ((std::vector<std::string>{ "evict", "restore", "reload" }), log);
+	EXPECT_EQ(16U, manager.GetResidentBytes());
+	EXPECT_EQ(1U, manager.GetStatistics().reloads);
+
+	// Resident again, nothing more to upload
+	EXPECT_TRUE(manager.Touch(handle));
+	EXPECT_EQ(3U, log.size());
+}
+
+TEST(ResidencyManager, NeverEvictsWhatCanNotBeReloaded)
+{
+	gl::ResidencyManager manager{ 0 };
+	Recorder recorder{};
+	recorder.Listen(manager);
+
+	// A buffer filled once by its constructor
+	const auto buffer = manager.OnCreate(gl::residency::ResourceKind::Buffer, 3, 64, 1, 0, nullptr, nullptr);
+	const auto texture = manager.OnCreate(gl::residency::ResourceKind::Texture, 4, 64, 3, 0, nullptr, nullptr);
+	// Simulated, there are no contents to lose
+	const auto simulated = manager.Allocate(gl::residency::ResourceKind::Buffer, 64);
+
+	manager.BeginFrame();
+	EXPECT_EQ(64U, manager.Enforce());
+
+	ASSERT_EQ(1U, recorder.events.size());
+	EXPECT_EQ(simulated, recorder.events[0].handle);
+	EXPECT_TRUE(manager.Find(buffer)->isResident);
+	EXPECT_EQ(0U, manager.Find(texture)->residentMip);
+}
+
+TEST(ResidencyManager, ReleasesCpuCopiesOnceUploaded)
+{
+	gl::ResidencyManager manager{};
+	Recorder recorder{};
+	recorder.Listen(manager);
+
+	const auto kept = manager.OnCreate(gl::residency::ResourceKind::Texture, 1, 100, 1, 100, [] {}, [] {});
+	manager.OnUpload(kept);
+	EXPECT_EQ(100U, manager.GetStatistics().cpuBytes);
+	EXPECT_TRUE(recorder.events.empty());
+
+	manager.ReleaseCpuCopies(true);
+	const auto released = manager.OnCreate(gl::residency::ResourceKind::Texture, 2, 50, 1, 50, [] {}, [] {});
+	EXPECT_EQ(150U, manager.GetStatistics().cpuBytes);
+
+	manager.OnUpload(released);
+	ASSERT_EQ(1U, recorder.events.size());
+	EXPECT_EQ(gl::residency::EvictAction::ReleaseCpuCopy, recorder.events[0].action);
+	EXPECT_EQ(released, recorder.events[0].handle);
+	EXPECT_EQ(100U, manager.GetStatistics().cpuBytes);
+	EXPECT_EQ(1U, manager.GetStatistics().releasedCpuCopies);
+
+	// Its contents can not come back anymore
+	EXPECT_EQ(0U, manager.Find(released)->cpuBytes);
+	EXPECT_FALSE(manager.Find(released)->reload);
+
+	// Once only
+	manager.OnUpload(released);
+	EXPECT_EQ(1U, manager.GetStatistics().releasedCpuCopies);
+}
+
+TEST(ResidencyManager, ReleasingACopyReloadsFromItFirst)
+{
+	gl::ResidencyManager manager{ 0 };
+
+	std::vector<std::string> log{};
+	const auto handle = manager.OnCreate(gl::residency::ResourceKind::Texture, 5, 32, 1, 32
+		, [&log] { log.push_back("release"); }, [&log] { log.push_back("reload"); });
+
+	manager.BeginFrame();
+	EXPECT_EQ(32U, manager.Enforce());
+
+	// The owner releases it by itself, with the default handler the callback runs there
+	manager.SetEvictHandler(gl::residency::ApplyEviction);
+	glstub::Reset();
+	manager.OnReleaseCpuCopy(handle);
+
+	EXPECT_EQ((std::vector<std::string>{ "reload", "release" }), log);
+	EXPECT_EQ(0U, manager.GetStatistics().cpuBytes);
+	EXPECT_EQ(32U, manager.GetResidentBytes());
+	EXPECT_EQ(1U, glstub::CountCalls("glTextureParameteri"));
+}
+
+TEST(ResidencyManager, IgnoresUnknownHandles)
+{
+	gl::ResidencyManager manager{};
+
+	EXPECT_FALSE(manager.Touch(12345));
+	manager.Restore(12345);
+	manager.OnUpload(12345);
+	manager.OnReleaseCpuCopy(12345);
+	manager.Free(12345);
+
+	EXPECT_EQ(0U, manager.GetStatistics().numberOfAllocations);
+}
+
+TEST(TextureResidency, TheTrackerIsGivenTheTextureName)
+{
+	glstub::Reset();
+
+	gl::ResidencyManager manager{ 0 };
+	manager.Install();
+
+	std::vector<Event> events{};
+	manager.SetEvictHandler([&events](const gl::residency::Allocation& allocation, gl::residency::EvictAction action) {
+		events.push_back(Event{ allocation.handle, allocation.object, action });
+		gl::residency::ApplyEviction(allocation, action);
+	});
+
+	gl::Texture texture = gl::LoadTexture("checkerboard.png");
+	ASSERT_NE(0U, texture.GetID());
+	EXPECT_EQ(1U, glstub::GetState().textures.count(texture.GetID()));
+	EXPECT_EQ(1U, glstub::CountCalls("glTexSubImage2D"));
+	EXPECT_EQ(8U * 4U * sizeof(gl::BitmapPixel), manager.GetStatistics().cpuBytes);
+
+	manager.BeginFrame();
+	EXPECT_EQ(8U * 4U * sizeof(gl::BitmapPixel), manager.Enforce());
+
+	ASSERT_EQ(1U, events.size());
+	EXPECT_EQ(gl::residency::EvictAction::Evict, events[0].action);
+	EXPECT_EQ(texture.GetID(), events[0].object);
+	ASSERT_EQ(1U, glstub::CountCalls("glInvalidateTexImage"));
+	EXPECT_EQ(texture.GetID(), glstub::FindCalls("glInvalidateTexImage")[0].args[0]);
+
+	// Drawing with it uploads the pixels again
+	texture.Bind();
+	EXPECT_EQ(2U, glstub::CountCalls("glTexSubImage2D"));
+	ASSERT_EQ(2U, events.size());
+	EXPECT_EQ(gl::residency::EvictAction::Restore, events[1].action);
+	EXPECT_EQ(1U, manager.GetStatistics().reloads);
+
+	const std::uint32_t name = texture.GetID();
+	texture.Destroy();
+	EXPECT_EQ(0U, glstub::GetState().textures.count(name));
+	EXPECT_EQ(0U, manager.GetStatistics().numberOfAllocations);
+}
+
+TEST(TextureResidency, TheUploadReleasesTheCpuCopy)
+{
+	glstub::Reset();
+
+	gl::ResidencyManager manager{ 0 };
+	manager.ReleaseCpuCopies(true);
+	manager.Install();
+
+	gl::Texture texture = gl::LoadTexture("checkerboard.png");
+	EXPECT_FALSE(texture.HasCpuCopy());
+	EXPECT_EQ(1U, manager.GetStatistics().releasedCpuCopies);
+	EXPECT_EQ(0U, manager.GetStatistics().cpuBytes);
+
+	// Nothing is left to upload it again from
+	manager.BeginFrame();
+	EXPECT_EQ(0U, manager.Enforce());
+	EXPECT_EQ(0U, manager.GetStatistics().evictions);
+}
+
+TEST(TextureResidency, ReleasingTheCpuCopyIsAccounted)
+{
+	glstub::Reset();
+
+	gl::ResidencyManager manager{};
+	manager.Install();
+
+	gl::Texture texture = gl::LoadTexture("checkerboard.png");
+	ASSERT_TRUE(texture.HasCpuCopy());
+
+	texture.ReleaseCpuCopy();
+	EXPECT_FALSE(texture.HasCpuCopy());
+	EXPECT_EQ(0U, manager.GetStatistics().cpuBytes);
+	EXPECT_EQ(1U, manager.GetStatistics().releasedCpuCopies);
+}
+
+TEST(TextureResidency, TheAnchorFollowsASwap)
+{
+	std::shared_ptr<gl::texture::Blob*> anchor = nullptr;
+	{
+		gl::texture::Blob first{};
+		gl::texture::Blob second{};
+		first.residencyAnchor = std::make_shared<gl::texture::Blob*>(&first);
+		first.imgBuffer = std::make_unique<gl::BitmapPixel[]>(1);
+		anchor = first.residencyAnchor;
+
+		first.swap(second);
+		EXPECT_EQ(&second, *anchor);
+		EXPECT_EQ(nullptr, first.residencyAnchor);
+		EXPECT_NE(nullptr, second.imgBuffer);
+
+		second.swap(first);
+		EXPECT_EQ(&first, *anchor);
+	}
+
+	// The callbacks find nothing once the blob is gone
+	EXPECT_EQ(nullptr, *anchor);
+}
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "Glib.hpp"
+#include "Glib.Shadows.hpp"
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+	constexpr float Identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+	// A frame which has its own ideas about every state the shadow pass touches
+	void SetUpFrame()
+	{
+		glstub::State& state = glstub::GetState();
+
+		state.integers[GL_FRAMEBUFFER_BINDING] = { 7 };
+		state.integers[GL_VIEWPORT] = { 10, 20, 800, 600 };
+		state.integers[GL_SCISSOR_BOX] = { 1, 2, 3, 4 };
+		state.integers[GL_DEPTH_FUNC] = { GL_GREATER };
+		state.floats[GL_POLYGON_OFFSET_FACTOR] = { 0.5f };
+		state.floats[GL_POLYGON_OFFSET_UNITS] = { 1.5f };
+		state.booleans[GL_COLOR_WRITEMASK] = { GL_TRUE, GL_FALSE, GL_TRUE, GL_FALSE };
+		state.booleans[GL_DEPTH_WRITEMASK] = { GL_FALSE };
+		state.capabilities[GL_DEPTH_TEST] = false;
+		state.capabilities[GL_SCISSOR_TEST] = true;
+		state.capabilities[GL_POLYGON_OFFSET_FILL] = false;
+	}
+
+	void ExpectFrameRestored()
+	{
+		const glstub::State& state = glstub::GetState();
+
+		EXPECT_EQ((std::vector<GLint>{ 7 }), state.integers.at(GL_DRAW_FRAMEBUFFER_BINDING));
+		EXPECT_EQ((std::vector<GLint>{ 10, 20, 800, 600 }), state.integers.at(GL_VIEWPORT));
+		EXPECT_EQ((std::vector<GLint>{ 1, 2, 3, 4 }), state.integers.at(GL_SCISSOR_BOX));
+		EXPECT_EQ((std::vector<GLint>{ GL_GREATER }), state.integers.at(GL_DEPTH_FUNC));
+		EXPECT_EQ((std::vector<GLfloat>{ 0.5f }), state.floats.at(GL_POLYGON_OFFSET_FACTOR));
+		EXPECT_EQ((std::vector<GLfloat>{ 1.5f }), state.floats.at(GL_POLYGON_OFFSET_UNITS));
+		EXPECT_EQ((std::vector<GLboolean>{ GL_TRUE, GL_FALSE, GL_TRUE, GL_FALSE }), state.booleans.at(GL_COLOR_WRITEMASK));
+		EXPECT_EQ((std::vector<GLboolean>{ GL_FALSE }), state.booleans.at(GL_DEPTH_WRITEMASK));
+		EXPECT_FALSE(state.capabilities.at(GL_DEPTH_TEST));
+		EXPECT_TRUE(state.capabilities.at(GL_SCISSOR_TEST));
+		EXPECT_FALSE(state.capabilities.at(GL_POLYGON_OFFSET_FILL));
+	}
+
+	class ShadowsTest : public ::testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			glstub::Reset();
+		}
+	};
+}
+
+TEST_F(ShadowsTest, EndRestoresTheStatesBeginChanged)
+{
+	gl::ShadowAtlas atlas{ 1024 };
+	ASSERT_TRUE(atlas.Create());
+
+	SetUpFrame();
+	atlas.Begin();
+
+	// The depth pass itself
+	const glstub::State& state = glstub::GetState();
+	EXPECT_EQ((std::vector<GLboolean>{ GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE }), state.booleans.at(GL_COLOR_WRITEMASK));
+	EXPECT_EQ((std::vector<GLint>{ GL_LEQUAL }), state.integers.at(GL_DEPTH_FUNC));
+	EXPECT_TRUE(state.capabilities.at(GL_DEPTH_TEST));
+	EXPECT_TRUE(state.capabilities.at(GL_POLYGON_OFFSET_FILL));
+	EXPECT_EQ((std::vector<GLint>{ static_cast<GLint>(*state.framebuffers.begin()) }), state.integers.at(GL_DRAW_FRAMEBUFFER_BINDING));
+
+	atlas.BeginTile(gl::shadow::Tile{ 256, 512, 256 });
+	EXPECT_EQ((std::vector<GLint>{ 256, 512, 256, 256 }), state.integers.at(GL_SCISSOR_BOX));
+
+	atlas.End();
+	ExpectFrameRestored();
+
+	// And the other way around
+	glstub::GetState().capabilities[GL_DEPTH_TEST] = true;
+	glstub::GetState().capabilities[GL_SCISSOR_TEST] = false;
+	glstub::GetState().capabilities[GL_POLYGON_OFFSET_FILL] = true;
+
+	atlas.Begin();
+	atlas.End();
+
+	EXPECT_TRUE(glstub::GetState().capabilities.at(GL_DEPTH_TEST));
+	EXPECT_FALSE(glstub::GetState().capabilities.at(GL_SCISSOR_TEST));
+	EXPECT_TRUE(glstub::GetState().capabilities.at(GL_POLYGON_OFFSET_FILL));
+}
+
+TEST_F(ShadowsTest, RenderLeavesTheFrameAsItWas)
+{
+	gl::ShadowAtlas atlas{ 2048 };
+	gl::CascadedShadows shadows{ 2, 512 };
+	ASSERT_TRUE(shadows.Allocate(atlas));
+
+	const float light[3] = { 0.3f, -1.0f, 0.2f };
+	shadows.Update(Identity, 1.0f, 1.5f, 0.1f, 100.0f, light);
+
+	const std::vector<gl::scene::BoundingBox> boxes = { { { -1, -1, -6 }, { 1, 1, -4 } }, { { 2, -1, -40 }, { 4, 1, -38 } } };
+	gl::SceneIndex scene{};
+	scene.Build(boxes, 1);
+	shadows.Cull(scene, 1);
+
+	SetUpFrame();
+
+	gl::Pipeline pipeline{};
+	std::vector<std::uint32_t> drawn{};
+	shadows.Render(atlas, pipeline, 3, [&](std::uint32_t object) noexcept {
+		drawn.push_back(object);
+	});
+
+	ExpectFrameRestored();
+
+	// One matrix per cascade, and every caster of every cascade
+	EXPECT_EQ(2U, glstub::CountCalls("glUniformMatrix4fv"));
+
+	std::size_t casters = 0;
+	for (std::uint32_t i = 0; i < 2; ++i)
+	{
+		casters += shadows.GetCasters(i).size();
+	}
+	EXPECT_EQ(casters, drawn.size());
+	EXPECT_LT(0U, casters);
+}
+
+TEST_F(ShadowsTest, AtlasTilesNeverOverlapAndMergeBack)
+{
+	gl::ShadowAtlas atlas{ 1024, 64 };
+	const std::uint64_t whole = 1024ULL * 1024ULL;
+	ASSERT_EQ(whole, atlas.GetFreeArea());
+
+	std::vector<gl::shadow::Tile> tiles{};
+	for (const std::uint32_t size : { 512U, 100U, 256U, 64U, 64U, 200U, 128U })
+	{
+		const std::optional<gl::shadow::Tile> tile = atlas.Allocate(size);
+		ASSERT_TRUE(tile.has_value()) << size;
+
+		// Rounded up to a power of two, inside of the atlas and aligned to its size
+		EXPECT_LE(size, tile->size);
+		EXPECT_EQ(0U, tile->size & (tile->size - 1));
+		EXPECT_EQ(0U, tile->x % tile->size);
+		EXPECT_EQ(0U, tile->y % tile->size);
+		EXPECT_LE(tile->x + tile->size, 1024U);
+		EXPECT_LE(tile->y + tile->size, 1024U);
+
+		for (const gl::shadow::Tile& other : tiles)
+		{
+			const bool apart = tile->x + tile->size <= other.x || other.x + other.size <= tile->x || tile->y + tile->size <= other.y || other.y + other.size <= tile->y;
+			EXPECT_TRUE(apart);
+		}
+
+		tiles.push_back(*tile);
+	}
+
+	EXPECT_FALSE(atlas.Allocate(2048).has_value());
+	EXPECT_FALSE(atlas.Allocate(0).has_value());
+
+	for (const gl::shadow::Tile& tile : tiles)
+	{
+		atlas.Free(tile);
+	}
+
+	// The siblings merged, so the whole atlas is one tile again
+	EXPECT_EQ(whole, atlas.GetFreeArea());
+	EXPECT_TRUE(atlas.Allocate(1024).has_value());
+	EXPECT_FALSE(atlas.Allocate(64).has_value());
+}
+
+TEST_F(ShadowsTest, SplitsBlendLogarithmicAndUniform)
+{
+	const auto uniform = gl::shadow::ComputeSplits(1.0f, 101.0f, 4, 0.0f);
+	const auto logarithmic = gl::shadow::ComputeSplits(1.0f, 10000.0f, 4, 1.0f);
+
+	for (std::uint32_t i = 0; i <= 4; ++i)
+	{
+		EXPECT_NEAR(1.0f + 25.0f * static_cast<float>(i), uniform[i], 1e-3f);
+		EXPECT_NEAR(std::pow(10.0f, static_cast<float>(i)), logarithmic[i], logarithmic[i] * 1e-4f);
+	}
+}
+
+TEST_F(ShadowsTest, CreateReleasesEverythingOnAnIncompleteFramebuffer)
+{
+	glstub::GetState().framebufferStatus = GL_FRAMEBUFFER_UNSUPPORTED;
+
+	{
+		gl::ShadowAtlas atlas{ 512 };
+		EXPECT_FALSE(atlas.Create());
+		EXPECT_FALSE(atlas.IsCreated());
+	}
+
+	EXPECT_TRUE(glstub::GetState().textures.empty());
+	EXPECT_TRUE(glstub::GetState().framebuffers.empty());
+
+	glstub::GetState().framebufferStatus = GL_FRAMEBUFFER_COMPLETE;
+
+	{
+		gl::ShadowAtlas atlas{ 512 };
+		EXPECT_TRUE(atlas.Create());
+		EXPECT_EQ(1U, glstub::GetState().textures.size());
+	}
+
+	EXPECT_TRUE(glstub::GetState().textures.empty());
+	EXPECT_TRUE(glstub::GetState().framebuffers.empty());
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include "Glib.hpp"
+#include "Glib.SpriteBatch.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Random rotated sprites of random colours and regions
+	[[nodiscard]]
+	gl::sprite::Streams
+	MakeStreams(std::size_t count, std::uint32_t seed)
+	{
+		std::mt19937 engine{ seed };
+		std::uniform_real_distribution<float> position{ -500.0f, 500.0f };
+		std::uniform_real_distribution<float> size{ 1.0f, 64.0f };
+		std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+		std::uniform_real_distribution<float> angle{ -3.2f, 3.2f };
+		std::uniform_int_distribution<int> channel{ 0, 255 };
+
+		gl::sprite::Streams streams{};
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			gl::sprite::Sprite sprite{};
+			sprite.x = position(engine);
+			sprite.y = position(engine);
+			sprite.width = size(engine);
+			sprite.height = size(engine);
+			sprite.originX = unit(engine);
+			sprite.originY = unit(engine);
+			// Every third sprite is upright, which skips the trigonometry
+			sprite.rotation = 0 == i % 3 ? 0.0f : angle(engine);
+			sprite.region = gl::sprite::Region{ unit(engine), unit(engine), unit(engine), unit(engine) };
+			sprite.colour = gl::Colour{ static_cast<std::uint8_t>(channel(engine)), static_cast<std::uint8_t>(channel(engine))
+				, static_cast<std::uint8_t>(channel(engine)), static_cast<std::uint8_t>(channel(engine)) };
+
+			streams.Append(sprite);
+		}
+
+		return streams;
+	}
+
+	// Both generations write into buffers one sprite longer than the order, which must be left alone
+	void
+	ExpectSameVertices(const gl::sprite::Streams& streams, const std::vector<std::uint32_t>& order)
+	{
+		constexpr gl::sprite::Vertex Untouched{ -1.0f, -2.0f, -3.0f, -4.0f, 0xDEADBEEFU };
+
+		std::vector<gl::sprite::Vertex> simd((order.size() + 1) * 4, Untouched);
+		std::vector<gl::sprite::Vertex> scalar((order.size() + 1) * 4, Untouched);
+
+		gl::sprite::GenerateVertices(streams, order, simd);
+		gl::sprite::GenerateVerticesScalar(streams, order, scalar);
+
+		for (std::size_t i = 0; i < simd.size(); ++i)
+		{
+			ASSERT_EQ(scalar[i].x, simd[i].x) << "vertex " << i << " of " << order.size() << " sprites";
+			ASSERT_EQ(scalar[i].y, simd[i].y) << "vertex " << i << " of " << order.size() << " sprites";
+			ASSERT_EQ(scalar[i].u, simd[i].u) << "vertex " << i << " of " << order.size() << " sprites";
+			ASSERT_EQ(scalar[i].v, simd[i].v) << "vertex " << i << " of " << order.size() << " sprites";
+			ASSERT_EQ(scalar[i].colour, simd[i].colour) << "vertex " << i << " of " << order.size() << " sprites";
+		}
+
+		const gl::sprite::Vertex& past = simd.back();
+		EXPECT_EQ(Untouched.x, past.x);
+		EXPECT_EQ(Untouched.colour, past.colour);
+	}
+}
+
+TEST(SpriteBatch, VerticesOfAnUprightSprite)
+{
+	gl::sprite::Sprite sprite{};
+	sprite.x = 100;
+	sprite.y = 50;
+	sprite.width = 20;
+	sprite.height = 10;
+	sprite.originX = 0.5f;
+	sprite.originY = 1.0f;
+	sprite.region = gl::sprite::Region{ 0.25f, 0.5f, 0.75f, 1.0f };
+	sprite.colour = gl::Colour{ std::uint8_t{ 1 }, std::uint8_t{ 2 }, std::uint8_t{ 3 }, std::uint8_t{ 4 } };
+
+	gl::sprite::Streams streams{};
+	streams.Append(sprite);
+
+	const std::uint32_t order[1] = { 0 };
+	gl::sprite::Vertex vertices[4]{};
+	gl::sprite::GenerateVertices(streams, order, vertices);
+
+	// Top left, top right, bottom right, bottom left, around the bottom centre
+	EXPECT_EQ(90.0f, vertices[0].x);
+	EXPECT_EQ(40.0f, vertices[0].y);
+	EXPECT_EQ(110.0f, vertices[2].x);
+	EXPECT_EQ(50.0f, vertices[2].y);
+	EXPECT_EQ(0.75f, vertices[1].u);
+	EXPECT_EQ(0.5f, vertices[1].v);
+	EXPECT_EQ(0.25f, vertices[3].u);
+	EXPECT_EQ(1.0f, vertices[3].v);
+
+	// Red in the lowest byte
+	EXPECT_EQ(0x04030201U, vertices[0].colour);
+	EXPECT_EQ(0x04030201U, gl::PackColour(sprite.colour));
+}
+
+TEST(SpriteBatch, SimdVerticesMatchTheScalarOnesAtAnyCount)
+{
+	const gl::sprite::Streams streams = MakeStreams(1031, 9);
+
+	// Every remainder of four, in submission order so the loads are contiguous
+	for (std::size_t count = 0; count <= 13; ++count)
+	{
+		std::vector<std::uint32_t> order(count);
+		std::iota(order.begin(), order.end(), 0U);
+
+		ExpectSameVertices(streams, order);
+	}
+
+	std::vector<std::uint32_t> order(streams.GetSize());
+	std::iota(order.begin(), order.end(), 0U);
+	ExpectSameVertices(streams, order);
+
+	// Starting past the first sprite, so the contiguous loads are unaligned
+	order.erase(order.begin(), order.begin() + 3);
+	ExpectSameVertices(streams, order);
+}
+
+TEST(SpriteBatch, SimdVerticesMatchTheScalarOnesInAnyOrder)
+{
+	const gl::sprite::Streams streams = MakeStreams(517, 21);
+	std::mt19937 engine{ 4 };
+
+	for (const std::size_t count : { 5U, 6U, 7U, 258U, 517U })
+	{
+		std::vector<std::uint32_t> order(count);
+		std::iota(order.begin(), order.end(), 0U);
+		std::ranges::shuffle(order, engine);
+
+		ExpectSameVertices(streams, order);
+	}
+
+	// Repeated sprites, and runs of three which look almost contiguous
+	ExpectSameVertices(streams, { 7, 7, 7, 7, 3, 2, 1, 0, 4, 5, 6, 9, 10, 11, 12 });
+}
+
+TEST(SpriteBatch, GenerationStopsAtTheEndOfTheDestination)
+{
+	const gl::sprite::Streams streams = MakeStreams(11, 2);
+
+	std::vector<std::uint32_t> order(11);
+	std::iota(order.begin(), order.end(), 0U);
+
+	// Room for six sprites and a half
+	std::vector<gl::sprite::Vertex> simd(26), scalar(26);
+	gl::sprite::GenerateVertices(streams, order, simd);
+	gl::sprite::GenerateVerticesScalar(streams, order, scalar);
+
+	for (std::size_t i = 0; i < 24; ++i)
+	{
+		ASSERT_EQ(scalar[i].x, simd[i].x) << i;
+		ASSERT_EQ(scalar[i].colour, simd[i].colour) << i;
+	}
+
+	EXPECT_EQ(0.0f, simd[24].x);
+	EXPECT_EQ(0U, simd[25].colour);
+}
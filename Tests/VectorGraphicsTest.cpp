@@ -0,0 +1,410 @@
+#include <gtest/gtest.h>
+#include "GlStub.hpp"
+#include "Glib.hpp"
+#include "Glib.VectorGraphics.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace
+{
+	using gl::vector::Point;
+
+	[[nodiscard]]
+	float
+	Cross(const Point& origin, const Point& a, const Point& b)
+	{
+		return (a.x - origin.x) * (b.y - origin.y) - (a.y - origin.y) * (b.x - origin.x);
+	}
+
+	[[nodiscard]]
+	float
+	PolygonArea(std::span<const Point> polygon)
+	{
+		float area = 0;
+		for (std::size_t i = 0; i < polygon.size(); ++i)
+		{
+			const Point& a = polygon[i];
+			const Point& b = polygon[(i + 1) % polygon.size()];
+			area += a.x * b.y - a.y * b.x;
+		}
+
+		return std::abs(area) * 0.5f;
+	}
+
+	[[nodiscard]]
+	float
+	TrianglesArea(const gl::vector::Mesh& mesh)
+	{
+		float area = 0;
+		for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			area += std::abs(Cross(mesh.positions[mesh.indices[i]], mesh.positions[mesh.indices[i + 1]], mesh.positions[mesh.indices[i + 2]])) * 0.5f;
+		}
+
+		return area;
+	}
+
+	// Number of triangles strictly around the point, the samples stay off the shared edges
+	[[nodiscard]]
+	int
+	Coverage(const gl::vector::Mesh& mesh, const Point& point)
+	{
+		int result = 0;
+		for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			const Point& a = mesh.positions[mesh.indices[i]];
+			const Point& b = mesh.positions[mesh.indices[i + 1]];
+			const Point& c = mesh.positions[mesh.indices[i + 2]];
+
+			const float ab = Cross(a, b, point);
+			const float bc = Cross(b, c, point);
+			const float ca = Cross(c, a, point);
+
+			if ((0 < ab && 0 < bc && 0 < ca) || (ab < 0 && bc < 0 && ca < 0))
+			{
+				++result;
+			}
+		}
+
+		return result;
+	}
+
+	// Most triangles over any sample of a grid around the mesh, offset so no sample lands on a vertex or an edge
+	[[nodiscard]]
+	int
+	MostCoverage(const gl::vector::Mesh& mesh)
+	{
+		float left = 1e9f, top = 1e9f, right = -1e9f, bottom = -1e9f;
+		for (const Point& position : mesh.positions)
+		{
+			left = std::min(left, position.x);
+			top = std::min(top, position.y);
+			right = std::max(right, position.x);
+			bottom = std::max(bottom, position.y);
+		}
+
+		int result = 0;
+		for (float y = top + 0.0137f; y < bottom; y += 0.2331f)
+		{
+			for (float x = left + 0.0071f; x < right; x += 0.2173f)
+			{
+				result = std::max(result, Coverage(mesh, Point{ x, y }));
+			}
+		}
+
+		return result;
+	}
+
+	[[nodiscard]]
+	gl::vector::Path
+	MakePolyline(std::span<const Point> points, bool closed)
+	{
+		gl::vector::Path path{};
+		path.MoveTo(points[0].x, points[0].y);
+		for (std::size_t i = 1; i < points.size(); ++i)
+		{
+			path.LineTo(points[i].x, points[i].y);
+		}
+
+		if (closed)
+		{
+			path.Close();
+		}
+
+		return path;
+	}
+
+	[[nodiscard]]
+	gl::vector::Stroke
+	MakeStroke(float width, gl::vector::LineJoin join, gl::vector::LineCap cap = gl::vector::LineCap::Butt)
+	{
+		gl::vector::Stroke result{};
+		result.width = width;
+		result.join = join;
+		result.cap = cap;
+		return result;
+	}
+
+	void
+	ExpectFilledOnce(std::span<const Point> polygon)
+	{
+		gl::vector::Mesh mesh{};
+		gl::vector::TessellateFill(MakePolyline(polygon, true), mesh);
+
+		EXPECT_EQ((polygon.size() - 2) * 3, mesh.indices.size());
+		EXPECT_NEAR(PolygonArea(polygon), TrianglesArea(mesh), 1e-3f);
+		EXPECT_EQ(1, MostCoverage(mesh));
+	}
+}
+
+TEST(VectorTessellation, EarClippingFillsAConcavePolygonOnce)
+{
+	// A comb, whose teeth make most of the vertices reflex
+	const std::array<Point, 12> comb{ {
+		{ 0, 0 }, { 50, 0 }, { 50, 40 }, { 40, 40 }, { 40, 10 }, { 30, 10 },
+		{ 30, 40 }, { 20, 40 }, { 20, 10 }, { 10, 10 }, { 10, 40 }, { 0, 40 } } };
+	ExpectFilledOnce(comb);
+
+	// The same the other way around
+	std::array<Point, 12> reversed = comb;
+	std::ranges::reverse(reversed);
+	ExpectFilledOnce(reversed);
+
+	const std::array<Point, 10> star{ {
+		{ 50, 0 }, { 61, 35 }, { 98, 35 }, { 68, 57 }, { 79, 91 },
+		{ 50, 70 }, { 21, 91 }, { 32, 57 }, { 2, 35 }, { 39, 35 } } };
+	ExpectFilledOnce(star);
+}
+
+TEST(VectorTessellation, EarClippingKeepsCollinearVertices)
+{
+	// Points in the middle of the edges of an arrow, which is concave so the fan is not taken
+	const std::array<Point, 9> arrow{ {
+		{ 0, 0 }, { 20, 0 }, { 40, 0 }, { 40, 20 }, { 40, 40 },
+		{ 20, 40 }, { 0, 40 }, { 20, 20 }, { 10, 10 } } };
+
+	gl::vector::Mesh mesh{};
+	gl::vector::TessellateFill(MakePolyline(arrow, true), mesh);
+
+	EXPECT_EQ(arrow.size(), mesh.positions.size());
+	EXPECT_EQ((arrow.size() - 2) * 3, mesh.indices.size());
+	EXPECT_NEAR(PolygonArea(arrow), TrianglesArea(mesh), 1e-3f);
+	EXPECT_EQ(1, MostCoverage(mesh));
+
+	// A contour without area leaves nothing
+	const std::array<Point, 3> line{ { { 0, 0 }, { 10, 10 }, { 20, 20 } } };
+	mesh.Clear();
+	gl::vector::TessellateFill(MakePolyline(line, true), mesh);
+	EXPECT_TRUE(mesh.indices.empty());
+}
+
+TEST(VectorTessellation, MiterWithinTheLimitAndBevelBeyondIt)
+{
+	// A left turn of a right angle, whose outer corner is at (105, -5)
+	const std::array<Point, 3> corner{ { { 0, 0 }, { 100, 0 }, { 100, 100 } } };
+	const gl::vector::Path path = MakePolyline(corner, false);
+	const Point tip{ 104.2f, -4.6f };
+
+	gl::vector::Stroke stroke = MakeStroke(10, gl::vector::LineJoin::Miter);
+	gl::vector::Mesh miter{};
+	gl::vector::TessellateStroke(path, stroke, miter);
+	EXPECT_EQ(1, Coverage(miter, tip));
+
+	// The miter of a right angle is the square root of two times the half width
+	stroke.miterLimit = 1.4f;
+	gl::vector::Mesh limited{};
+	gl::vector::TessellateStroke(path, stroke, limited);
+	EXPECT_EQ(0, Coverage(limited, tip));
+
+	gl::vector::Mesh bevel{};
+	gl::vector::TessellateStroke(path, MakeStroke(10, gl::vector::LineJoin::Bevel), bevel);
+	EXPECT_EQ(0, Coverage(bevel, tip));
+	EXPECT_EQ(limited.positions.size(), bevel.positions.size());
+	EXPECT_NEAR(TrianglesArea(bevel), TrianglesArea(limited), 1e-3f);
+
+	// The bevel cuts the corner by the triangle between the outer edges
+	EXPECT_NEAR(12.5f, TrianglesArea(miter) - TrianglesArea(bevel), 1e-2f);
+	// Two segments of a hundred, short of the inner square of the turn
+	EXPECT_NEAR(2000.0f - 25.0f + 12.5f, TrianglesArea(bevel), 1e-2f);
+
+	// A sharp turn exceeds the default limit
+	const std::array<Point, 3> sharp{ { { 0, 0 }, { 100, 0 }, { 0, 10 } } };
+	gl::vector::Mesh sharp_miter{}, sharp_bevel{};
+	gl::vector::TessellateStroke(MakePolyline(sharp, false), MakeStroke(4, gl::vector::LineJoin::Miter), sharp_miter);
+	gl::vector::TessellateStroke(MakePolyline(sharp, false), MakeStroke(4, gl::vector::LineJoin::Bevel), sharp_bevel);
+	EXPECT_NEAR(TrianglesArea(sharp_bevel), TrianglesArea(sharp_miter), 1e-3f);
+}
+
+TEST(VectorTessellation, StrokesCoverEveryPixelOnce)
+{
+	using gl::vector::LineJoin;
+	using gl::vector::LineCap;
+
+	const std::array<Point, 5> zigzag{ { { 0, 0 }, { 40, 0 }, { 60, 30 }, { 80, -10 }, { 120, 15 } } };
+	const std::array<Point, 4> square{ { { 0, 0 }, { 50, 0 }, { 50, 50 }, { 0, 50 } } };
+
+	gl::vector::Path circle{};
+	circle.AddCircle(0, 0, 30);
+
+	for (const LineJoin join : { LineJoin::Miter, LineJoin::Bevel, LineJoin::Round })
+	{
+		for (const LineCap cap : { LineCap::Butt, LineCap::Square, LineCap::Round })
+		{
+			gl::vector::Mesh mesh{};
+			gl::vector::TessellateStroke(MakePolyline(zigzag, false), MakeStroke(6, join, cap), mesh);
+			EXPECT_EQ(1, MostCoverage(mesh)) << "zigzag, join " << static_cast<int>(join) << ", cap " << static_cast<int>(cap);
+
+			// Every point within the width of a segment is covered
+			for (std::size_t segment = 0; segment + 1 < zigzag.size(); ++segment)
+			{
+				const Point& begin = zigzag[segment];
+				const Point& end = zigzag[segment + 1];
+				const float length = std::hypot(end.x - begin.x, end.y - begin.y);
+				const Point normal{ (begin.y - end.y) / length, (end.x - begin.x) / length };
+
+				for (float along = 0.013f; along < 1.0f; along += 0.0497f)
+				{
+					for (const float across : { -2.9f, -1.3f, 0.1f, 1.7f, 2.9f })
+					{
+						const Point point{ begin.x + (end.x - begin.x) * along + normal.x * across, begin.y + (end.y - begin.y) * along + normal.y * across };
+						ASSERT_LE(1, Coverage(mesh, point)) << "segment " << segment << " at " << along << ", " << across;
+					}
+				}
+			}
+		}
+
+		gl::vector::Mesh closed{};
+		gl::vector::TessellateStroke(MakePolyline(square, true), MakeStroke(8, join), closed);
+		EXPECT_EQ(1, MostCoverage(closed)) << "square, join " << static_cast<int>(join);
+
+		gl::vector::Mesh round{};
+		gl::vector::TessellateStroke(circle, MakeStroke(5, join), round);
+		EXPECT_EQ(1, MostCoverage(round)) << "circle, join " << static_cast<int>(join);
+	}
+}
+
+TEST(VectorTessellation, DashesCarryTheirPhaseAcrossSegments)
+{
+	// Dashes of eight and gaps of four on a width of two
+	gl::vector::Stroke stroke = MakeStroke(2, gl::vector::LineJoin::Miter);
+	stroke.dash = gl::vector::DashStyle::Dash;
+
+	const std::array<Point, 2> straight{ { { 0, 0 }, { 100, 0 } } };
+	// Cut in the middle of the second dash and of the fourth gap
+	const std::array<Point, 4> cut{ { { 0, 0 }, { 13, 0 }, { 46, 0 }, { 100, 0 } } };
+
+	gl::vector::Mesh whole{}, pieces{};
+	gl::vector::TessellateStroke(MakePolyline(straight, false), stroke, whole);
+	gl::vector::TessellateStroke(MakePolyline(cut, false), stroke, pieces);
+
+	for (float x = 0.05f; x < 100.0f; x += 0.1f)
+	{
+		const bool dash = std::fmod(x, 12.0f) < 8.0f;
+		ASSERT_EQ(dash ? 1 : 0, Coverage(whole, Point{ x, 0.3f })) << x;
+		ASSERT_EQ(dash ? 1 : 0, Coverage(pieces, Point{ x, 0.3f })) << x;
+	}
+
+	// Eight whole dashes and a last one of four
+	EXPECT_NEAR(9 * 8 * 2 - 4 * 2, TrianglesArea(whole), 1e-2f);
+
+	// A turn inside of a gap keeps the phase too, two of its units are left after the corner
+	const std::array<Point, 3> bent{ { { 0, 0 }, { 10, 0 }, { 10, 50 } } };
+	gl::vector::Mesh turned{};
+	gl::vector::TessellateStroke(MakePolyline(bent, false), stroke, turned);
+
+	EXPECT_EQ(0, Coverage(turned, Point{ 10.3f, 1.5f }));
+	EXPECT_EQ(1, Coverage(turned, Point{ 10.3f, 2.5f }));
+	EXPECT_EQ(1, Coverage(turned, Point{ 10.3f, 9.5f }));
+	EXPECT_EQ(0, Coverage(turned, Point{ 10.3f, 10.5f }));
+	EXPECT_EQ(1, Coverage(turned, Point{ 10.3f, 14.5f }));
+}
+
+TEST(VectorTessellation, CacheHitsMovedShapesOnly)
+{
+	gl::vector::TessellationCache cache{};
+	bool hit = true;
+
+	const std::array<Point, 4> shape{ { { 0, 0 }, { 30, 0 }, { 30, 10 }, { 5, 20 } } };
+	std::array<Point, 4> moved = shape;
+	for (Point& point : moved)
+	{
+		point.x += 200.5f;
+		point.y -= 31.25f;
+	}
+
+	const gl::vector::Path path = MakePolyline(shape, true);
+	const gl::vector::Mesh& first = cache.GetFill(path, hit);
+	EXPECT_FALSE(hit);
+
+	gl::vector::Mesh expected{};
+	gl::vector::TessellateFill(path, expected);
+	ASSERT_EQ(expected.positions.size(), first.positions.size());
+	EXPECT_EQ(expected.indices, first.indices);
+
+	const gl::vector::Mesh& again = cache.GetFill(MakePolyline(moved, true), hit);
+	EXPECT_TRUE(hit);
+	EXPECT_EQ(&first, &again);
+	EXPECT_EQ(1U, cache.GetSize());
+
+	// Relative to the first point
+	EXPECT_EQ(0.0f, again.positions[0].x);
+	EXPECT_EQ(30.0f, again.positions[1].x);
+
+	// Another shape, the open contour, the stroke and another stroke all miss
+	std::array<Point, 4> changed = shape;
+	changed[3].x += 1;
+	static_cast<void>(cache.GetFill(MakePolyline(changed, true), hit));
+	EXPECT_FALSE(hit);
+
+	static_cast<void>(cache.GetFill(MakePolyline(shape, false), hit));
+	EXPECT_FALSE(hit);
+
+	const gl::vector::Stroke thin = MakeStroke(2, gl::vector::LineJoin::Miter);
+	gl::vector::Stroke thick = thin;
+	thick.width = 3;
+	gl::vector::Stroke rounded = thin;
+	rounded.join = gl::vector::LineJoin::Round;
+
+	static_cast<void>(cache.GetStroke(path, thin, hit));
+	EXPECT_FALSE(hit);
+	static_cast<void>(cache.GetStroke(path, thick, hit));
+	EXPECT_FALSE(hit);
+	static_cast<void>(cache.GetStroke(path, rounded, hit));
+	EXPECT_FALSE(hit);
+
+	const gl::vector::Mesh& stroked = cache.GetStroke(MakePolyline(moved, true), thin, hit);
+	EXPECT_TRUE(hit);
+	EXPECT_EQ(6U, cache.GetSize());
+
+	gl::vector::Mesh outline{};
+	gl::vector::TessellateStroke(path, thin, outline);
+	EXPECT_EQ(outline.indices, stroked.indices);
+
+	// Meshes unused for the lifetime are dropped
+	for (std::uint32_t frame = 0; frame < gl::vector::DefaultCacheLifetime; ++frame)
+	{
+		EXPECT_EQ(0U, cache.BeginFrame());
+	}
+
+	EXPECT_EQ(6U, cache.BeginFrame());
+	EXPECT_EQ(0U, cache.GetSize());
+
+	static_cast<void>(cache.GetFill(path, hit));
+	EXPECT_FALSE(hit);
+}
+
+TEST(VectorRenderer, EndRestoresTheBindings)
+{
+	glstub::Reset();
+
+	gl::VectorRenderer renderer{};
+	ASSERT_TRUE(renderer.Create());
+
+	// Bound by the caller before the shapes are drawn
+	glstub::State& state = glstub::GetState();
+	state.integers[GL_CURRENT_PROGRAM] = { 77 };
+	state.integers[GL_VERTEX_ARRAY_BINDING] = { 88 };
+	state.integers[GL_ARRAY_BUFFER_BINDING] = { 99 };
+
+	const std::array<float, 16> identity{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	renderer.Begin(identity);
+	renderer.FillRect(0, 0, 10, 10, gl::Colour{ std::uint8_t{ 255 }, std::uint8_t{ 0 }, std::uint8_t{ 0 }, std::uint8_t{ 128 } });
+	renderer.DrawCircle(20, 20, 5, MakeStroke(2, gl::vector::LineJoin::Round));
+	renderer.End();
+
+	const std::vector<glstub::Call> draws = glstub::FindCalls("glDrawElements");
+	ASSERT_EQ(1U, draws.size());
+	EXPECT_EQ(static_cast<std::int64_t>(renderer.GetStatistics().indices), draws[0].args[1]);
+	EXPECT_EQ(1U, renderer.GetStatistics().drawCalls);
+
+	EXPECT_EQ(77, state.integers[GL_CURRENT_PROGRAM][0]);
+	EXPECT_EQ(88, state.integers[GL_VERTEX_ARRAY_BINDING][0]);
+	EXPECT_EQ(99, state.integers[GL_ARRAY_BUFFER_BINDING][0]);
+
+	renderer.Destroy();
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include "Glib.VertexPacking.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+	[[nodiscard]]
+	std::vector<float> MakeValues(const std::size_t& count, const float& low, const float& high, const std::uint32_t& seed)
+	{
+		std::mt19937 random{ seed };
+		std::uniform_real_distribution<float> distribution{ low, high };
+
+		std::vector<float> result(count);
+		for (float& value : result)
+		{
+			value = distribution(random);
+		}
+
+		return result;
+	}
+}
+
+TEST(VertexPacking, EveryHalfRoundTrips)
+{
+	for (std::uint32_t bits = 0; bits < 0x10000; ++bits)
+	{
+		const gl::vertex::Half half{ static_cast<std::uint16_t>(bits) };
+		const float value = gl::vertex::FromHalf(half);
+
+		if (std::isnan(value))
+		{
+			// Any quiet nan will do
+			ASSERT_EQ(0x7E00, gl::vertex::ToHalf(value).bits & 0x7E00) << bits;
+			continue;
+		}
+
+		ASSERT_EQ(bits, gl::vertex::ToHalf(value).bits) << bits;
+	}
+}
+
+TEST(VertexPacking, HalvesRoundToTheNearest)
+{
+	std::vector<float> values = MakeValues(10007, -70000.0f, 70000.0f, 1);
+	const std::vector<float> small = MakeValues(10007, -1e-4f, 1e-4f, 2);
+	values.insert(values.end(), small.begin(), small.end());
+	values.insert(values.end(), { 0.0f, -0.0f, 65504.0f, 65520.0f, -1e9f, 6e-8f, 1e-9f, std::numeric_limits<float>::infinity() });
+
+	std::vector<gl::vertex::Half> packed(values.size());
+	gl::vertex::PackHalf(values, packed);
+
+	std::vector<float> unpacked(values.size());
+	gl::vertex::UnpackHalf(packed, unpacked);
+
+	for (std::size_t i = 0; i < values.size(); ++i)
+	{
+		// The vector path and the scalar one agree, the tail goes through the scalar one
+		ASSERT_EQ(gl::vertex::ToHalf(values[i]).bits, packed[i].bits) << values[i];
+		ASSERT_EQ(std::bit_cast<std::uint32_t>(gl::vertex::FromHalf(packed[i])), std::bit_cast<std::uint32_t>(unpacked[i]));
+
+		const float magnitude = std::abs(values[i]);
+		if (65520.0f <= magnitude)
+		{
+			EXPECT_TRUE(std::isinf(unpacked[i])) << values[i];
+		}
+		else if (6.103515625e-5f <= magnitude)
+		{
+			// Half an ulp of the eleven bits of precision
+			EXPECT_LE(std::abs(unpacked[i] - values[i]), magnitude * 0x1p-11f) << values[i];
+		}
+		else
+		{
+			// Subnormals have a fixed step
+			EXPECT_LE(std::abs(unpacked[i] - values[i]), 0x1p-25f) << values[i];
+		}
+	}
+}
+
+TEST(VertexPacking, SnormAndUnormStayWithinHalfAStep)
+{
+	for (const std::uint32_t components : { 3U, 4U })
+	{
+		const std::size_t count = 1003;
+		std::vector<float> values = MakeValues(count * components, -1.2f, 1.2f, components);
+		values[0] = -1.0f;
+		values[1] = 1.0f;
+
+		std::vector<gl::vertex::PackedSnorm> snorms(count);
+		std::vector<gl::vertex::PackedUnorm> unorms(count);
+		gl::vertex::PackSnorm(values, snorms, components);
+		gl::vertex::PackUnorm(values, unorms, components);
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const std::array<float, 4> snorm = gl::vertex::Unpack(snorms[i]);
+			const std::array<float, 4> unorm = gl::vertex::Unpack(unorms[i]);
+
+			for (std::uint32_t c = 0; c < 3; ++c)
+			{
+				const float value = values[i * components + c];
+
+				ASSERT_LE(std::abs(snorm[c] - std::clamp(value, -1.0f, 1.0f)), 0.5f / 511.0f + 1e-6f) << value;
+				ASSERT_LE(std::abs(unorm[c] - std::clamp(value, 0.0f, 1.0f)), 0.5f / 1023.0f + 1e-6f) << value;
+			}
+
+			// The two bits of the fourth component, missing ones are zero
+			const float w = 4 == components ? values[i * components + 3] : 0.0f;
+			ASSERT_EQ(std::nearbyint(std::clamp(w, -1.0f, 1.0f)), snorm[3]) << w;
+			ASSERT_NEAR(std::nearbyint(std::clamp(w, 0.0f, 1.0f) * 3.0f) / 3.0f, unorm[3], 1e-6f) << w;
+
+			// One vector at a time takes the scalar path
+			gl::vertex::PackedSnorm snorm_one{};
+			gl::vertex::PackedUnorm unorm_one{};
+			gl::vertex::PackSnorm(std::span{ values }.subspan(i * components, components), std::span{ &snorm_one, 1 }, components);
+			gl::vertex::PackUnorm(std::span{ values }.subspan(i * components, components), std::span{ &unorm_one, 1 }, components);
+
+			ASSERT_EQ(snorm_one.bits, snorms[i].bits) << i;
+			ASSERT_EQ(unorm_one.bits, unorms[i].bits) << i;
+		}
+
+		// The ends are exact
+		EXPECT_EQ(-1.0f, gl::vertex::Unpack(snorms[0])[0]);
+		EXPECT_EQ(1.0f, gl::vertex::Unpack(snorms[0])[1]);
+		EXPECT_EQ(1.0f, gl::vertex::Unpack(unorms[0])[1]);
+	}
+}
+
+TEST(VertexPacking, OctahedralNormalsKeepTheirDirection)
+{
+	std::mt19937 random{ 3 };
+	std::normal_distribution<float> distribution{};
+
+	const std::size_t count = 100003;
+	std::vector<float> normals(count * 3);
+	for (float& value : normals)
+	{
+		value = distribution(random);
+	}
+
+	// The poles, the folded half and a signed zero
+	const float special[] = { 0, 0, -1, 0, 0, 1, -0.0f, 1, -1e-7f, 1, 0, 0, 0, -1, 0 };
+	std::copy(std::begin(special), std::end(special), normals.begin());
+
+	std::vector<gl::vertex::Octahedral> packed(count);
+	gl::vertex::PackOctahedral(normals, packed);
+
+	double worst = 0;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const float* const n = normals.data() + i * 3;
+		const double length = std::sqrt(double(n[0]) * n[0] + double(n[1]) * n[1] + double(n[2]) * n[2]);
+
+		const std::array<float, 3> unpacked = gl::vertex::Unpack(packed[i]);
+		const double unpacked_length = std::sqrt(double(unpacked[0]) * unpacked[0] + double(unpacked[1]) * unpacked[1] + double(unpacked[2]) * unpacked[2]);
+		ASSERT_NEAR(1.0, unpacked_length, 1e-5) << i;
+
+		// In doubles, one float ulp below one is already 3e-4 radians
+		const double cosine = (double(unpacked[0]) * n[0] + double(unpacked[1]) * n[1] + double(unpacked[2]) * n[2]) / length / unpacked_length;
+		worst = std::max(worst, std::acos(std::min(1.0, cosine)));
+
+		gl::vertex::Octahedral one{};
+		gl::vertex::PackOctahedral(std::span{ normals }.subspan(i * 3, 3), std::span{ &one, 1 });
+		ASSERT_EQ(one.x, packed[i].x) << i;
+		ASSERT_EQ(one.y, packed[i].y) << i;
+	}
+
+	// Two shorts give steps of about 1e-4 radians over the octahedron
+	EXPECT_LT(worst, 2e-4) << worst;
+	RecordProperty("octahedral_worst_microradians", static_cast<int>(worst * 1e6));
+}
+
+TEST(VertexPacking, PackedTypesAreNormalizedByDefault)
+{
+	gl::BufferLayout layout{};
+	layout.AddElement<float>(3);
+	layout.AddElement<gl::vertex::Octahedral>(2);
+	layout.AddElement<gl::vertex::PackedSnorm>(4);
+	layout.AddElement<gl::vertex::PackedUnorm>(4);
+	layout.AddElement<gl::vertex::PackedUnorm>(4, false);
+	layout.AddElement<std::int16_t>(2);
+
+	const auto& elements = layout.GetElements();
+	ASSERT_EQ(6U, elements.size());
+
+	EXPECT_FALSE(std::get<4>(elements[0]));
+	EXPECT_TRUE(std::get<4>(elements[1]));
+	EXPECT_TRUE(std::get<4>(elements[2]));
+	EXPECT_TRUE(std::get<4>(elements[3]));
+	EXPECT_FALSE(std::get<4>(elements[4]));
+	EXPECT_FALSE(std::get<4>(elements[5]));
+
+	// The packed types take four bytes for the whole element
+	EXPECT_EQ(12, std::get<3>(elements[1]));
+	EXPECT_EQ(16, std::get<3>(elements[2]));
+	EXPECT_EQ(20, std::get<3>(elements[3]));
+	EXPECT_EQ(0x8D9F, std::get<1>(elements[2]));
+	EXPECT_EQ(0x8368, std::get<1>(elements[3]));
+}
+
+TEST(VertexPacking, ReportsItsThroughput)
+{
+	const gl::vertex::Benchmark result = gl::vertex::MeasurePacking(1 << 18, 4);
+
+	EXPECT_LT(0.0, result.halfPerSecond);
+	EXPECT_LT(0.0, result.snormPerSecond);
+	EXPECT_LT(0.0, result.octahedralPerSecond);
+
+	std::cout << "half " << result.halfPerSecond / 1e6 << " M/s, scalar half " << result.scalarHalfPerSecond / 1e6
+		<< " M/s, snorm " << result.snormPerSecond / 1e6 << " M/s, octahedral " << result.octahedralPerSecond / 1e6 << " M/s\n";
+}
@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+#include "Glib.hpp"
+#include "Glib.Visibility.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+	constexpr float Identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+	// Perspective of 90 degrees looking down -z, from 1 to 100
+	constexpr float Perspective[16] =
+	{
+		1, 0, 0, 0,
+		0, 1, 0, 0,
+		0, 0, -101.0f / 99.0f, -1,
+		0, 0, -200.0f / 99.0f, 0,
+	};
+
+	struct Bounds
+	{
+		float centre[3];
+		float extent[3];
+		float radius;
+	};
+
+	// Signed distance of the bounds to each plane, pushed out as the stage does it
+	[[nodiscard]]
+	std::vector<double>
+	GetDistances(const gl::visibility::Frustum& frustum, const Bounds& bounds)
+	{
+		std::vector<double> result{};
+		for (const auto& plane : frustum.planes)
+		{
+			double distance = plane[3] + bounds.radius;
+			for (int i = 0; i < 3; ++i)
+			{
+				distance += static_cast<double>(plane[i]) * bounds.centre[i] + std::abs(static_cast<double>(plane[i])) * bounds.extent[i];
+			}
+
+			result.push_back(distance);
+		}
+
+		return result;
+	}
+
+	[[nodiscard]]
+	gl::visibility::BoundingBox
+	MakeBox(float x0, float y0, float z0, float x1, float y1, float z1)
+	{
+		return gl::visibility::BoundingBox{ { x0, y0, z0 }, { x1, y1, z1 } };
+	}
+}
+
+TEST(Visibility, BatchesMatchTheScalarTestAtAnyCount)
+{
+	std::mt19937 engine{ 3 };
+	std::uniform_real_distribution<float> position{ -60.0f, 60.0f };
+	std::uniform_real_distribution<float> depth{ -120.0f, 10.0f };
+	std::uniform_real_distribution<float> size{ 0.1f, 8.0f };
+
+	gl::VisibilityStage stage{};
+	stage.SetViewProjection(Perspective);
+	const gl::visibility::Frustum frustum = stage.GetFrustum();
+
+	// Every remainder of the lanes, and counts short of a single batch
+	for (std::size_t count = 0; count <= 3 * gl::visibility::BatchSize + 1; ++count)
+	{
+		stage.Clear();
+
+		std::vector<std::uint32_t> expected{};
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			Bounds bounds{};
+			std::vector<double> distances{};
+
+			// Away from the planes, where the summation order could decide
+			do
+			{
+				bounds = Bounds{ { position(engine), position(engine), depth(engine) }, {}, 0 };
+				if (0 == i % 2)
+				{
+					bounds.radius = size(engine);
+				}
+				else
+				{
+					bounds.extent[0] = size(engine);
+					bounds.extent[1] = size(engine);
+					bounds.extent[2] = size(engine);
+				}
+
+				distances = GetDistances(frustum, bounds);
+			}
+			while (std::ranges::any_of(distances, [](double distance) { return std::abs(distance) < 1e-3; }));
+
+			if (std::ranges::none_of(distances, [](double distance) { return distance < 0; }))
+			{
+				expected.push_back(static_cast<std::uint32_t>(i));
+			}
+
+			if (0 == i % 2)
+			{
+				stage.Submit(gl::visibility::BoundingSphere{ bounds.centre[0], bounds.centre[1], bounds.centre[2], bounds.radius }, gl::Primitive::Triangles, 3);
+			}
+			else
+			{
+				stage.Submit(MakeBox(bounds.centre[0] - bounds.extent[0], bounds.centre[1] - bounds.extent[1], bounds.centre[2] - bounds.extent[2]
+					, bounds.centre[0] + bounds.extent[0], bounds.centre[1] + bounds.extent[1], bounds.centre[2] + bounds.extent[2]), gl::Primitive::Triangles, 3);
+			}
+		}
+
+		stage.Cull();
+
+		ASSERT_EQ(expected, (std::vector<std::uint32_t>(stage.GetVisible().begin(), stage.GetVisible().end()))) << count << " objects";
+		EXPECT_EQ(count, stage.GetStatistics().submitted);
+		EXPECT_EQ(count - expected.size(), stage.GetStatistics().frustumCulled);
+		EXPECT_EQ(expected.size(), stage.GetStatistics().visible);
+	}
+}
+
+TEST(Visibility, PaddingLanesAreNeverVisible)
+{
+	// The zeroed padding is a point at the origin, which is inside of this frustum
+	gl::VisibilityStage stage{};
+	stage.SetViewProjection(Identity);
+
+	for (std::size_t count = 1; count < 2 * gl::visibility::BatchSize; ++count)
+	{
+		stage.Clear();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			stage.Submit(gl::visibility::BoundingSphere{ 5, 5, 5, 1 }, gl::Primitive::Triangles, 3);
+		}
+
+		stage.Cull();
+
+		EXPECT_TRUE(stage.GetVisible().empty()) << count << " objects";
+		EXPECT_EQ(count, stage.GetStatistics().frustumCulled);
+	}
+
+	// Resubmitted after a cull, the previous padding is not read as bounds
+	stage.Clear();
+	stage.Submit(gl::visibility::BoundingSphere{ 0, 0, 0, 0.5f }, gl::Primitive::Triangles, 3);
+	stage.Submit(gl::visibility::BoundingSphere{ 5, 5, 5, 1 }, gl::Primitive::Triangles, 3);
+	stage.Cull();
+	stage.Submit(gl::visibility::BoundingSphere{ 5, 5, 5, 1 }, gl::Primitive::Triangles, 3);
+	stage.Cull();
+
+	ASSERT_EQ(1U, stage.GetVisible().size());
+	EXPECT_EQ(0U, stage.GetVisible()[0]);
+	EXPECT_EQ(2U, stage.GetStatistics().frustumCulled);
+}
+
+TEST(Visibility, FrustumPlanesAreNormalized)
+{
+	const gl::visibility::Frustum frustum = gl::visibility::Frustum::FromMatrix(Perspective);
+
+	for (const auto& plane : frustum.planes)
+	{
+		EXPECT_NEAR(1.0f, std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]), 1e-5f);
+	}
+
+	// The near plane faces down -z, one unit in front of the eye
+	EXPECT_NEAR(-1.0f, frustum.planes[4][2], 1e-5f);
+	EXPECT_NEAR(-1.0f, frustum.planes[4][3], 1e-4f);
+	// The far one faces back, a hundred units away
+	EXPECT_NEAR(1.0f, frustum.planes[5][2], 1e-5f);
+	EXPECT_NEAR(100.0f, frustum.planes[5][3], 1e-2f);
+}
+
+TEST(Visibility, BoxesBehindAnOccluderAreCulled)
+{
+	gl::VisibilityStage stage{};
+	stage.SetViewProjection(Identity);
+	stage.EnableOcclusion(64, 64, 2);
+
+	// A wall over the left half of the screen, at a depth of a quarter
+	ASSERT_TRUE(stage.AddOccluder(MakeBox(-1.5f, -1.5f, -0.5f, 0.0f, 1.5f, -0.4f)));
+
+	// Behind the wall, small and large
+	stage.Submit(MakeBox(-0.6f, -0.1f, 0.0f, -0.5f, 0.0f, 0.2f), gl::Primitive::Triangles, 3);
+	stage.Submit(MakeBox(-0.9f, -0.9f, 0.0f, -0.1f, 0.9f, 0.5f), gl::Primitive::Triangles, 3);
+	// In front of it
+	stage.Submit(MakeBox(-0.6f, -0.1f, -0.9f, -0.5f, 0.0f, -0.8f), gl::Primitive::Triangles, 3);
+	// Behind it, but reaching past its edge
+	stage.Submit(MakeBox(-0.5f, -0.1f, 0.0f, 0.5f, 0.0f, 0.2f), gl::Primitive::Triangles, 3);
+	// Beside it
+	stage.Submit(gl::visibility::BoundingSphere{ 0.5f, 0.5f, 0.5f, 0.1f }, gl::Primitive::Triangles, 3);
+	// Outside of the frustum
+	stage.Submit(gl::visibility::BoundingSphere{ 5.0f, 0.0f, 0.0f, 1.0f }, gl::Primitive::Triangles, 3);
+
+	stage.Cull();
+
+	EXPECT_EQ((std::vector<std::uint32_t>{ 2, 3, 4 }), (std::vector<std::uint32_t>(stage.GetVisible().begin(), stage.GetVisible().end())));
+
+	const gl::visibility::Statistics& statistics = stage.GetStatistics();
+	EXPECT_EQ(6U, statistics.submitted);
+	EXPECT_EQ(1U, statistics.frustumCulled);
+	EXPECT_EQ(2U, statistics.occlusionCulled);
+	EXPECT_EQ(3U, statistics.visible);
+
+	// Without occlusion, only the frustum is left
+	stage.DisableOcclusion();
+	stage.Cull();
+	EXPECT_EQ(5U, stage.GetStatistics().visible);
+	EXPECT_EQ(0U, stage.GetStatistics().occlusionCulled);
+	EXPECT_FALSE(stage.AddOccluder(MakeBox(-1, -1, -1, 1, 1, 1)));
+}
+
+TEST(Visibility, HierarchyKeepsTheFarthestDepthOfOddSizes)
+{
+	// Odd sizes, every level of the pyramid has a last texel of a single column or row
+	constexpr std::uint32_t Width = 37;
+	constexpr std::uint32_t Height = 23;
+
+	gl::VisibilityStage stage{};
+	stage.SetViewProjection(Identity);
+	stage.EnableOcclusion(Width, Height);
+
+	// The whole screen but its last column, whose centre is past 0.95
+	ASSERT_TRUE(stage.AddOccluder(MakeBox(-2.0f, -2.0f, -0.5f, 0.95f, 2.0f, -0.4f)));
+
+	// Spans the screen, so only the top of the pyramid is read
+	stage.Submit(MakeBox(-1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 0.5f), gl::Primitive::Triangles, 3);
+	// Behind the covered part only
+	stage.Submit(MakeBox(-1.0f, -1.0f, 0.0f, 0.5f, 1.0f, 0.5f), gl::Primitive::Triangles, 3);
+	// Behind the last column only
+	stage.Submit(MakeBox(0.98f, -0.2f, 0.0f, 0.99f, 0.2f, 0.5f), gl::Primitive::Triangles, 3);
+
+	stage.Cull();
+
+	EXPECT_EQ((std::vector<std::uint32_t>{ 0, 2 }), (std::vector<std::uint32_t>(stage.GetVisible().begin(), stage.GetVisible().end())));
+	EXPECT_EQ(1U, stage.GetStatistics().occlusionCulled);
+
+	// Once the last column is covered too, even the whole screen is hidden
+	stage.Clear();
+	ASSERT_TRUE(stage.AddOccluder(MakeBox(-2.0f, -2.0f, -0.5f, 2.0f, 2.0f, -0.4f)));
+	stage.Submit(MakeBox(-1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 0.5f), gl::Primitive::Triangles, 3);
+	stage.Submit(MakeBox(0.98f, -0.2f, 0.0f, 0.99f, 0.2f, 0.5f), gl::Primitive::Triangles, 3);
+	stage.Cull();
+
+	EXPECT_TRUE(stage.GetVisible().empty());
+	EXPECT_EQ(2U, stage.GetStatistics().occlusionCulled);
+}
+
+TEST(Visibility, ObjectsCrossingTheEyeAreNeverOccluded)
+{
+	gl::VisibilityStage stage{};
+	stage.SetViewProjection(Perspective);
+	stage.EnableOcclusion(32, 32);
+
+	// A wall filling the view, ten units away
+	ASSERT_TRUE(stage.AddOccluder(MakeBox(-50.0f, -50.0f, -10.5f, 50.0f, 50.0f, -10.0f)));
+
+	// Far behind the wall, and around the eye
+	stage.Submit(gl::visibility::BoundingSphere{ 0.0f, 0.0f, -50.0f, 2.0f }, gl::Primitive::Triangles, 3);
+	stage.Submit(gl::visibility::BoundingSphere{ 0.0f, 0.0f, -5.0f, 6.0f }, gl::Primitive::Triangles, 3);
+
+	stage.Cull();
+
+	EXPECT_EQ((std::vector<std::uint32_t>{ 1 }), (std::vector<std::uint32_t>(stage.GetVisible().begin(), stage.GetVisible().end())));
+	EXPECT_EQ(1U, stage.GetStatistics().occlusionCulled);
+}
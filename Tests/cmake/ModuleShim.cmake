@@ -0,0 +1,90 @@
+# Turns the module units of the library into headers and plain sources,
+# so the platform independent parts build with compilers lacking modules.
+#
+#   export module A.B;        ->  #pragma once
+#   export module A.B:C;      ->  #pragma once
+#   module A.B;               ->  #include "A.B.hpp"
+#   import <vector>;          ->  #include <vector>
+#   import A.B;               ->  #include "A.B.hpp"
+#   import :C;                ->  #include "A.B-C.hpp"
+#   export <declaration>      ->  <declaration>
+#
+# Non exported declarations of an interface become visible to every includer,
+# which is harmless for tests. The files are regenerated when their originals change.
+
+set(GLIB_SHIM_DIR "${CMAKE_BINARY_DIR}/shim")
+
+function(_glib_shim_header_name module output)
+	string(REPLACE ":" "-" name "${module}")
+	set(${output} "${name}.hpp" PARENT_SCOPE)
+endfunction()
+
+function(_glib_shim_convert input output_dir output)
+	file(READ "${input}" content)
+	set(content "\n${content}")
+
+	string(REGEX MATCH "\n(export )?module ([A-Za-z0-9_.]+)(:[A-Za-z0-9_]+)?;" declaration "${content}")
+	if(NOT declaration)
+		set(${output} "${input}" PARENT_SCOPE)
+		return()
+	endif()
+
+	set(primary "${CMAKE_MATCH_2}")
+	set(partition "${CMAKE_MATCH_3}")
+	set(is_interface FALSE)
+	if(CMAKE_MATCH_1)
+		set(is_interface TRUE)
+	endif()
+
+	string(REGEX REPLACE "\nmodule;" "\n" content "${content}")
+	string(REGEX REPLACE "\nexport module [A-Za-z0-9_.:]+;" "\n#pragma once" content "${content}")
+	string(REGEX REPLACE "\nmodule ([A-Za-z0-9_.]+):([A-Za-z0-9_]+);" "\n#include \"\\1-\\2.hpp\"" content "${content}")
+	string(REGEX REPLACE "\nmodule ([A-Za-z0-9_.]+);" "\n#include \"\\1.hpp\"" content "${content}")
+	string(REGEX REPLACE "\n(export )?import <([^>]+)>;" "\n#include <\\2>" content "${content}")
+	string(REGEX REPLACE "\n(export )?import :([A-Za-z0-9_]+);" "\n#include \"${primary}-\\2.hpp\"" content "${content}")
+	string(REGEX REPLACE "\n(export )?import ([A-Za-z0-9_.]+);" "\n#include \"\\2.hpp\"" content "${content}")
+	string(REGEX REPLACE "\n([\t ]*)export " "\n\\1" content "${content}")
+	string(REPLACE "<gl\\gl.h>" "<GL/GL.h>" content "${content}")
+	string(REPLACE "<gl\\glu.h>" "<GL/GLU.h>" content "${content}")
+
+	set(content "#line 1 \"${input}\"${content}")
+
+	if(is_interface)
+		_glib_shim_header_name("${primary}${partition}" name)
+		set(path "${output_dir}/${name}")
+	else()
+		get_filename_component(name "${input}" NAME)
+		set(path "${output_dir}/src/${name}")
+	endif()
+
+	# Rewriting an unchanged file would rebuild everything depending on it
+	set(previous "")
+	if(EXISTS "${path}")
+		file(READ "${path}" previous)
+	endif()
+	if(NOT previous STREQUAL content)
+		file(WRITE "${path}" "${content}")
+	endif()
+
+	set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS "${input}")
+	set(${output} "${path}" PARENT_SCOPE)
+endfunction()
+
+# glib_shim_interfaces(<files>...)
+# Convert module interfaces into headers named after their modules
+function(glib_shim_interfaces)
+	foreach(input IN LISTS ARGN)
+		_glib_shim_convert("${input}" "${GLIB_SHIM_DIR}" unused)
+	endforeach()
+endfunction()
+
+# glib_shim_sources(<output variable> <files>...)
+# Convert module implementations into plain sources, other files are kept as they are
+function(glib_shim_sources output)
+	set(result "")
+	foreach(input IN LISTS ARGN)
+		_glib_shim_convert("${input}" "${GLIB_SHIM_DIR}" path)
+		list(APPEND result "${path}")
+	endforeach()
+	set(${output} "${result}" PARENT_SCOPE)
+endfunction()
@@ -0,0 +1,35 @@
+#pragma once
+// Stands in for the primary module of the library, whose own interface declares functions needing a context.
+// Only the platform independent partitions the tests build against are gathered here.
+#include "Glib-Pixel.hpp"
+#include "Glib-Comparator.hpp"
+#include "Glib-State.hpp"
+#include "Glib-ClearBits.hpp"
+#include "Glib-Primitive.hpp"
+#include "Glib-BlendOption.hpp"
+#include "Glib-BlendMode.hpp"
+#include "Glib-Blender.hpp"
+#include "Glib-BufferType.hpp"
+#include "Glib-BufferUsage.hpp"
+#include "Glib-BufferLayout.hpp"
+#include "Glib-Object.hpp"
+#include "Glib-Shader.hpp"
+#include "Glib-Pipeline.hpp"
+#include "Glib-BufferObject.hpp"
+#include "Glib.Windows.Colour.hpp"
+
+// Declared by the primary interface, stub/GlobalState.cpp defines them for the tests
+namespace gl::global
+{
+	void SetState(const gl::State& state) noexcept;
+	void SetState(gl::State&& state) noexcept;
+	void SetState(const gl::State& state, bool flag) noexcept;
+	void SetState(gl::State&& state, bool flag) noexcept;
+	[[nodiscard]] bool IsBlending() noexcept;
+
+	using StateListener = void(*)() noexcept;
+
+	void SetStateListener(StateListener listener) noexcept;
+	[[nodiscard]] StateListener GetStateListener() noexcept;
+	void NotifyStateChange() noexcept;
+}
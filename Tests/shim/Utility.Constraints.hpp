@@ -0,0 +1,36 @@
+#pragma once
+// Stands in for the constraints module of the utility library, which lives outside of this tree.
+// Only what the handles of the windows resources use.
+#include <concepts>
+#include <functional>
+#include <type_traits>
+
+namespace util
+{
+	using std::copyable;
+	using std::default_initializable;
+	using std::movable;
+	using std::invoke_result_t;
+	using std::is_same_v;
+
+	template<typename Fn, typename... Args>
+	concept invocables = std::is_invocable_v<Fn, Args...>;
+	template<typename Fn, typename... Args>
+	concept nothrow_invocables = std::is_nothrow_invocable_v<Fn, Args...>;
+
+	template<typename... Ts>
+	concept nothrow_default_constructibles = (std::is_nothrow_default_constructible_v<Ts> && ...);
+	template<typename... Ts>
+	concept nothrow_copy_constructibles = (std::is_nothrow_copy_constructible_v<Ts> && ...);
+	template<typename... Ts>
+	concept nothrow_move_constructibles = (std::is_nothrow_move_constructible_v<Ts> && ...);
+	template<typename... Ts>
+	concept nothrow_copy_assignables = (std::is_nothrow_copy_assignable_v<Ts> && ...);
+	template<typename... Ts>
+	concept nothrow_move_assignables = (std::is_nothrow_move_assignable_v<Ts> && ...);
+	template<typename... Ts>
+	concept nothrow_destructibles = (std::is_nothrow_destructible_v<Ts> && ...);
+
+	template<typename T>
+	inline constexpr bool is_explicit_constructible_v = not std::is_convertible_v<const T&, T>;
+}
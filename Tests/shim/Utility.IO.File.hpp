@@ -0,0 +1,42 @@
+#pragma once
+// Stands in for the file module of the utility library, which lives outside of this tree.
+// Only what the shader loading uses.
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace util::io
+{
+	namespace file
+	{
+		enum class OpenModes
+		{
+			Read,
+			Binary
+		};
+	}
+
+	class File
+	{
+	public:
+		File(const std::filesystem::path& path, file::OpenModes mode)
+			: myStream(path, file::OpenModes::Binary == mode ? std::ios::in | std::ios::binary : std::ios::in)
+		{}
+
+		[[nodiscard]]
+		bool IsOpen() const noexcept
+		{
+			return myStream.is_open();
+		}
+
+		[[nodiscard]]
+		std::string Contents()
+		{
+			return std::string{ std::istreambuf_iterator<char>{ myStream }, std::istreambuf_iterator<char>{} };
+		}
+
+	private:
+		std::ifstream myStream;
+	};
+}
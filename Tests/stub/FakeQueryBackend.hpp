@@ -0,0 +1,144 @@
+#pragma once
+#include "Glib.Profiler.hpp"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace glstub
+{
+	/// <summary>
+	/// Timestamp queries of a pretend GPU, which runs as far as the test tells it to
+	/// <para>The GPU clock is the steady clock moved by an offset, and each write takes the time the GPU reaches it.</para>
+	/// </summary>
+	class FakeQueryBackend final : public gl::profiler::Backend
+	{
+	public:
+		struct Query
+		{
+			// Order of the write among every write, the GPU finishes them in that order
+			std::uint64_t sequence = 0;
+			std::uint64_t timestamp = 0;
+			bool isWritten = false;
+		};
+
+		void
+		CreateQueries(std::span<std::uint32_t> names)
+		noexcept override
+		{
+			for (std::uint32_t& name : names)
+			{
+				name = myNextName++;
+				queries[name] = Query{};
+			}
+
+			++createdBatches;
+		}
+
+		void
+		DeleteQueries(std::span<const std::uint32_t> names)
+		noexcept override
+		{
+			for (const std::uint32_t name : names)
+			{
+				if (0 == queries.erase(name))
+				{
+					errors.push_back("deleted the query " + std::to_string(name) + " twice");
+				}
+			}
+		}
+
+		void
+		WriteTimestamp(std::uint32_t name)
+		noexcept override
+		{
+			const auto it = queries.find(name);
+			if (it == queries.end())
+			{
+				errors.push_back("wrote the dead query " + std::to_string(name));
+				return;
+			}
+
+			it->second = Query{ myWrites++, Now() + delay, true };
+		}
+
+		[[nodiscard]]
+		bool
+		IsAvailable(std::uint32_t name)
+		noexcept override
+		{
+			const auto it = queries.find(name);
+			return it != queries.end() && it->second.isWritten && it->second.sequence < finished;
+		}
+
+		[[nodiscard]]
+		std::uint64_t
+		GetTimestamp(std::uint32_t name)
+		noexcept override
+		{
+			// A result read before it is available makes the real driver wait
+			if (!IsAvailable(name))
+			{
+				errors.push_back("waited for the query " + std::to_string(name));
+				return 0;
+			}
+
+			return queries[name].timestamp;
+		}
+
+		[[nodiscard]]
+		std::uint64_t
+		GetCurrentTimestamp()
+		noexcept override
+		{
+			++currentTimestamps;
+			return Now();
+		}
+
+		/// <summary>
+		/// The GPU catches up with every write so far
+		/// </summary>
+		void
+		Finish()
+		noexcept
+		{
+			finished = myWrites;
+		}
+
+		[[nodiscard]]
+		std::uint64_t
+		GetWrites()
+		const noexcept
+		{
+			return myWrites;
+		}
+
+		[[nodiscard]]
+		std::uint64_t
+		Now()
+		const noexcept
+		{
+			const auto now = std::chrono::steady_clock::now().time_since_epoch();
+			return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()) + clockOffset;
+		}
+
+		std::map<std::uint32_t, Query> queries{};
+		std::vector<std::string> errors{};
+
+		// Writes the GPU is done with
+		std::uint64_t finished = 0;
+		// How far the GPU clock is ahead of the CPU clock
+		std::uint64_t clockOffset = 1'000'000'000'000;
+		// How long after the write the GPU reaches it
+		std::uint64_t delay = 0;
+		std::size_t currentTimestamps = 0;
+		std::size_t createdBatches = 0;
+
+	private:
+		std::uint32_t myNextName = 1;
+		std::uint64_t myWrites = 0;
+	};
+}
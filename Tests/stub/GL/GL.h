@@ -0,0 +1,3 @@
+#pragma once
+// Everything of GL/GL.h is already declared by glew.h
+#include "glew.h"
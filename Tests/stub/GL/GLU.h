@@ -0,0 +1,3 @@
+#pragma once
+// Nothing of GL/GLU.h is called by the modules under test, glew.h declares what they share
+#include "glew.h"
@@ -0,0 +1,37 @@
+// The calls of gdi made by the sources under test, which answer as if every handle was invalid
+#include "Windows.h"
+#include "Glib.Windows.Resource.Pen.hpp"
+
+int
+GetObjectW(void*, int, void*)
+{
+	return 0;
+}
+
+unsigned long
+GetSysColor(int)
+{
+	return 0;
+}
+
+// The pen only keeps what it was made with, so the getters are copied from Native/src/Pen.cpp without its constructors
+const gl::win32::resource::PenStyles&
+gl::win32::resource::Pen::GetStyle()
+const& noexcept
+{
+	return myStyle;
+}
+
+const int&
+gl::win32::resource::Pen::GetSize()
+const& noexcept
+{
+	return mySize;
+}
+
+const gl::win32::Colour&
+gl::win32::resource::Pen::GetColor()
+const& noexcept
+{
+	return myColor;
+}
@@ -0,0 +1,943 @@
+#include "GlStub.hpp"
+#include <algorithm>
+#include <type_traits>
+
+namespace
+{
+	template<typename T>
+	[[nodiscard]]
+	std::int64_t ToArgument(const T& value) noexcept
+	{
+		if constexpr (std::is_pointer_v<T>)
+		{
+			return static_cast<std::int64_t>(reinterpret_cast<std::uintptr_t>(value));
+		}
+		else
+		{
+			return static_cast<std::int64_t>(value);
+		}
+	}
+
+	template<typename... Args>
+	void Record(const char* name, const Args&... args)
+	{
+		glstub::GetState().calls.push_back(glstub::Call{ name, { ToArgument(args)... } });
+	}
+
+	[[nodiscard]]
+	std::vector<std::uint8_t>* GetBound(const GLenum& target)
+	{
+		glstub::State& state = glstub::GetState();
+
+		const auto bound = state.boundBuffers.find(target);
+		if (bound == state.boundBuffers.end() || 0 == bound->second)
+		{
+			return nullptr;
+		}
+
+		return &state.buffers[bound->second];
+	}
+
+	void GLAPIENTRY GenBuffers(GLsizei n, GLuint* buffers)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+		{
+			buffers[i] = glstub::GetState().nextName++;
+			glstub::GetState().buffers[buffers[i]];
+		}
+
+		Record("glGenBuffers", n);
+	}
+
+	void GLAPIENTRY DeleteBuffers(GLsizei n, const GLuint* buffers)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+		{
+			glstub::GetState().buffers.erase(buffers[i]);
+			Record("glDeleteBuffers", buffers[i]);
+		}
+	}
+
+	void GLAPIENTRY BindBuffer(GLenum target, GLuint buffer)
+	{
+		glstub::GetState().boundBuffers[target] = buffer;
+		if (GL_ARRAY_BUFFER == target)
+		{
+			glstub::GetState().integers[GL_ARRAY_BUFFER_BINDING] = { static_cast<GLint>(buffer) };
+		}
+		Record("glBindBuffer", target, buffer);
+	}
+
+	void GLAPIENTRY BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		glstub::GetState().boundBuffers[target] = buffer;
+		Record("glBindBufferBase", target, index, buffer);
+	}
+
+	void GLAPIENTRY BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		if (std::vector<std::uint8_t>* storage = GetBound(target))
+		{
+			storage->assign(static_cast<std::size_t>(size), 0);
+			if (nullptr != data)
+			{
+				std::copy_n(static_cast<const std::uint8_t*>(data), size, storage->data());
+			}
+		}
+
+		Record("glBufferData", target, size, usage);
+	}
+
+	void GLAPIENTRY BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		std::vector<std::uint8_t>* storage = GetBound(target);
+		if (nullptr != storage && static_cast<std::size_t>(offset + size) <= storage->size())
+		{
+			std::copy_n(static_cast<const std::uint8_t*>(data), size, storage->data() + offset);
+		}
+
+		Record("glBufferSubData", target, offset, size);
+	}
+
+	void* GLAPIENTRY MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+	{
+		Record("glMapBufferRange", target, offset, length, access);
+
+		std::vector<std::uint8_t>* storage = GetBound(target);
+		if (nullptr == storage || storage->size() < static_cast<std::size_t>(offset + length))
+		{
+			return nullptr;
+		}
+
+		return storage->data() + offset;
+	}
+
+	GLboolean GLAPIENTRY UnmapBuffer(GLenum target)
+	{
+		Record("glUnmapBuffer", target);
+		return GL_TRUE;
+	}
+
+	GLsync GLAPIENTRY FenceSync(GLenum condition, GLbitfield flags)
+	{
+		glstub::State& state = glstub::GetState();
+
+		const std::uintptr_t sync = state.nextSync++;
+		state.syncs.insert(sync);
+
+		Record("glFenceSync", condition, flags);
+		return reinterpret_cast<GLsync>(sync);
+	}
+
+	GLenum GLAPIENTRY ClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+	{
+		Record("glClientWaitSync", sync, flags, timeout);
+		return glstub::GetState().waitResult;
+	}
+
+	void GLAPIENTRY DeleteSync(GLsync sync)
+	{
+		glstub::GetState().syncs.erase(reinterpret_cast<std::uintptr_t>(sync));
+		Record("glDeleteSync", sync);
+	}
+
+	void GLAPIENTRY GenQueries(GLsizei n, GLuint* queries)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+		{
+			queries[i] = glstub::GetState().nextName++;
+		}
+
+		Record("glGenQueries", n);
+	}
+
+	void GLAPIENTRY DeleteQueries(GLsizei n, const GLuint*)
+	{
+		Record("glDeleteQueries", n);
+	}
+
+	void GLAPIENTRY QueryCounter(GLuint query, GLenum target)
+	{
+		Record("glQueryCounter", query, target);
+	}
+
+	// Every result is available at once, and zero
+	void GLAPIENTRY GetQueryObjectiv(GLuint query, GLenum pname, GLint* params)
+	{
+		params[0] = GL_QUERY_RESULT_AVAILABLE == pname ? GL_TRUE : 0;
+		Record("glGetQueryObjectiv", query, pname);
+	}
+
+	void GLAPIENTRY GetQueryObjectui64v(GLuint query, GLenum pname, GLuint64* params)
+	{
+		params[0] = 0;
+		Record("glGetQueryObjectui64v", query, pname);
+	}
+
+	void GLAPIENTRY GetInteger64v(GLenum pname, GLint64* params)
+	{
+		params[0] = 0;
+		Record("glGetInteger64v", pname);
+	}
+
+	void GLAPIENTRY MemoryBarrier(GLbitfield barriers)
+	{
+		Record("glMemoryBarrier", barriers);
+	}
+
+	void GLAPIENTRY TexStorage2D(GLenum target, GLsizei levels, GLenum internal_format, GLsizei width, GLsizei height)
+	{
+		Record("glTexStorage2D", target, levels, internal_format, width, height);
+	}
+
+	void GLAPIENTRY GenerateMipmap(GLenum target)
+	{
+		Record("glGenerateMipmap", target);
+	}
+
+	void GLAPIENTRY TextureParameteri(GLuint texture, GLenum pname, GLint param)
+	{
+		Record("glTextureParameteri", texture, pname, param);
+	}
+
+	void GLAPIENTRY InvalidateTexImage(GLuint texture, GLint level)
+	{
+		Record("glInvalidateTexImage", texture, level);
+	}
+
+	void GLAPIENTRY InvalidateBufferData(GLuint buffer)
+	{
+		Record("glInvalidateBufferData", buffer);
+	}
+
+	void GLAPIENTRY ActiveTexture(GLenum texture)
+	{
+		glstub::State& state = glstub::GetState();
+
+		state.integers[GL_ACTIVE_TEXTURE] = { static_cast<GLint>(texture) };
+		state.integers[GL_TEXTURE_BINDING_2D] = { static_cast<GLint>(state.textureUnits[texture - GL_TEXTURE0]) };
+		Record("glActiveTexture", texture);
+	}
+
+	void GLAPIENTRY GenFramebuffers(GLsizei n, GLuint* framebuffers)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+		{
+			framebuffers[i] = glstub::GetState().nextName++;
+			glstub::GetState().framebuffers.insert(framebuffers[i]);
+		}
+
+		Record("glGenFramebuffers", n);
+	}
+
+	void GLAPIENTRY DeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+		{
+			glstub::GetState().framebuffers.erase(framebuffers[i]);
+			Record("glDeleteFramebuffers", framebuffers[i]);
+		}
+	}
+
+	void GLAPIENTRY BindFramebuffer(GLenum target, GLuint framebuffer)
+	{
+		glstub::State& state = glstub::GetState();
+
+		if (GL_FRAMEBUFFER == target || GL_DRAW_FRAMEBUFFER == target)
+		{
+			state.integers[GL_DRAW_FRAMEBUFFER_BINDING] = { static_cast<GLint>(framebuffer) };
+		}
+		if (GL_FRAMEBUFFER == target || GL_READ_FRAMEBUFFER == target)
+		{
+			state.integers[GL_READ_FRAMEBUFFER_BINDING] = { static_cast<GLint>(framebuffer) };
+		}
+
+		Record("glBindFramebuffer", target, framebuffer);
+	}
+
+	void GLAPIENTRY FramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+	{
+		Record("glFramebufferTexture2D", target, attachment, textarget, texture, level);
+	}
+
+	void GLAPIENTRY DrawBuffers(GLsizei n, const GLenum* buffers)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+		{
+			Record("glDrawBuffers", i, buffers[i]);
+		}
+	}
+
+	GLenum GLAPIENTRY CheckFramebufferStatus(GLenum target)
+	{
+		Record("glCheckFramebufferStatus", target);
+		return glstub::GetState().framebufferStatus;
+	}
+
+	GLuint GLAPIENTRY CreateProgram()
+	{
+		const GLuint program = glstub::GetState().nextName++;
+		glstub::GetState().programs.insert(program);
+
+		Record("glCreateProgram", program);
+		return program;
+	}
+
+	void GLAPIENTRY DeleteProgram(GLuint program)
+	{
+		glstub::GetState().programs.erase(program);
+		Record("glDeleteProgram", program);
+	}
+
+	void GLAPIENTRY UseProgram(GLuint program)
+	{
+		glstub::GetState().integers[GL_CURRENT_PROGRAM] = { static_cast<GLint>(program) };
+		Record("glUseProgram", program);
+	}
+
+	void GLAPIENTRY LinkProgram(GLuint program)
+	{
+		Record("glLinkProgram", program);
+	}
+
+	void GLAPIENTRY AttachShader(GLuint program, GLuint shader)
+	{
+		Record("glAttachShader", program, shader);
+	}
+
+	void GLAPIENTRY DetachShader(GLuint program, GLuint shader)
+	{
+		Record("glDetachShader", program, shader);
+	}
+
+	GLuint GLAPIENTRY CreateShader(GLenum type)
+	{
+		const GLuint shader = glstub::GetState().nextName++;
+		glstub::GetState().shaders.insert(shader);
+
+		Record("glCreateShader", type, shader);
+		return shader;
+	}
+
+	void GLAPIENTRY DeleteShader(GLuint shader)
+	{
+		glstub::GetState().shaders.erase(shader);
+		Record("glDeleteShader", shader);
+	}
+
+	void GLAPIENTRY ShaderSource(GLuint shader, GLsizei count, const GLchar* const* sources, const GLint* lengths)
+	{
+		Record("glShaderSource", shader, count, sources, lengths);
+	}
+
+	void GLAPIENTRY CompileShader(GLuint shader)
+	{
+		Record("glCompileShader", shader);
+	}
+
+	void GLAPIENTRY GetShaderiv(GLuint shader, GLenum pname, GLint* param)
+	{
+		param[0] = GL_COMPILE_STATUS == pname ? glstub::GetState().compileStatus : 0;
+		Record("glGetShaderiv", shader, pname);
+	}
+
+	void GLAPIENTRY GetShaderInfoLog(GLuint shader, GLsizei size, GLsizei* length, GLchar* log)
+	{
+		if (nullptr != length)
+		{
+			*length = 0;
+		}
+		if (0 < size)
+		{
+			log[0] = '\0';
+		}
+
+		Record("glGetShaderInfoLog", shader, size);
+	}
+
+	void GLAPIENTRY UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		Record("glUniformMatrix4fv", location, count, transpose, value);
+	}
+
+	void GLAPIENTRY EnableVertexAttribArray(GLuint index)
+	{
+		Record("glEnableVertexAttribArray", index);
+	}
+
+	void GLAPIENTRY DisableVertexAttribArray(GLuint index)
+	{
+		Record("glDisableVertexAttribArray", index);
+	}
+
+	void GLAPIENTRY CopyBufferSubData(GLenum read_target, GLenum write_target, GLintptr read_offset, GLintptr write_offset, GLsizeiptr size)
+	{
+		Record("glCopyBufferSubData", read_target, write_target, read_offset, write_offset, size);
+	}
+
+	void GLAPIENTRY VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+	{
+		Record("glVertexAttribPointer", index, size, type, normalized, stride, pointer);
+	}
+
+	void GLAPIENTRY BufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+	{
+		if (std::vector<std::uint8_t>* storage = GetBound(target))
+		{
+			storage->assign(static_cast<std::size_t>(size), 0);
+			if (nullptr != data)
+			{
+				std::copy_n(static_cast<const std::uint8_t*>(data), size, storage->data());
+			}
+		}
+
+		Record("glBufferStorage", target, size, flags);
+	}
+
+	void GLAPIENTRY GenVertexArrays(GLsizei n, GLuint* arrays)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+		{
+			arrays[i] = glstub::GetState().nextName++;
+		}
+
+		Record("glGenVertexArrays", n);
+	}
+
+	void GLAPIENTRY DeleteVertexArrays(GLsizei n, const GLuint* arrays)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+		{
+			Record("glDeleteVertexArrays", arrays[i]);
+		}
+	}
+
+	void GLAPIENTRY BindVertexArray(GLuint array)
+	{
+		glstub::GetState().integers[GL_VERTEX_ARRAY_BINDING] = { static_cast<GLint>(array) };
+		Record("glBindVertexArray", array);
+	}
+
+	// Every program links
+	void GLAPIENTRY GetProgramiv(GLuint program, GLenum pname, GLint* param)
+	{
+		*param = GL_TRUE;
+		Record("glGetProgramiv", program, pname);
+	}
+
+	void GLAPIENTRY VertexAttribDivisor(GLuint index, GLuint divisor)
+	{
+		Record("glVertexAttribDivisor", index, divisor);
+	}
+
+	void GLAPIENTRY DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+	{
+		Record("glDrawArraysInstanced", mode, first, count, instances);
+	}
+
+	void GLAPIENTRY DrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint base_vertex)
+	{
+		Record("glDrawElementsBaseVertex", mode, count, type, indices, base_vertex);
+	}
+
+	void
+	SetCapability(const char* name, const GLenum& capability, const bool& enabled)
+	{
+		glstub::GetState().capabilities[capability] = enabled;
+		Record(name, capability);
+	}
+}
+
+glstub::State&
+glstub::GetState()
+noexcept
+{
+	static State state{};
+	return state;
+}
+
+void
+glstub::Reset()
+{
+	GetState() = State{};
+}
+
+std::size_t
+glstub::CountCalls(std::string_view name)
+{
+	const std::vector<Call>& calls = GetState().calls;
+
+	return static_cast<std::size_t>(std::count_if(calls.begin(), calls.end(), [name](const Call& call) {
+		return call.name == name;
+	}));
+}
+
+std::vector<glstub::Call>
+glstub::FindCalls(std::string_view name)
+{
+	std::vector<Call> result{};
+
+	for (const Call& call : GetState().calls)
+	{
+		if (call.name == name)
+		{
+			result.push_back(call);
+		}
+	}
+
+	return result;
+}
+
+extern "C"
+{
+	void GLAPIENTRY glPixelStorei(GLenum pname, GLint param)
+	{
+		Record("glPixelStorei", pname, param);
+	}
+
+	void GLAPIENTRY glGetIntegerv(GLenum pname, GLint* params)
+	{
+		const auto it = glstub::GetState().integers.find(pname);
+		if (it != glstub::GetState().integers.end())
+		{
+			std::copy(it->second.begin(), it->second.end(), params);
+		}
+		else
+		{
+			params[0] = 0;
+		}
+
+		Record("glGetIntegerv", pname);
+	}
+
+	// Fills a pixel pack buffer with bytes that only depend on their offset
+	void GLAPIENTRY glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels)
+	{
+		Record("glReadPixels", x, y, width, height, format, type, pixels);
+
+		std::vector<std::uint8_t>* storage = GetBound(GL_PIXEL_PACK_BUFFER);
+		if (nullptr == storage)
+		{
+			return;
+		}
+
+		const std::size_t offset = reinterpret_cast<std::uintptr_t>(pixels);
+		for (std::size_t i = offset; i < storage->size(); ++i)
+		{
+			(*storage)[i] = static_cast<std::uint8_t>(i * 31 + (i >> 8));
+		}
+	}
+
+	void GLAPIENTRY glEnable(GLenum capability)
+	{
+		SetCapability("glEnable", capability, true);
+	}
+
+	void GLAPIENTRY glDisable(GLenum capability)
+	{
+		SetCapability("glDisable", capability, false);
+	}
+
+	GLboolean GLAPIENTRY glIsEnabled(GLenum capability)
+	{
+		Record("glIsEnabled", capability);
+		return glstub::GetState().capabilities[capability] ? GL_TRUE : GL_FALSE;
+	}
+
+	// The capabilities first, as opengl answers both through it
+	void GLAPIENTRY glGetBooleanv(GLenum pname, GLboolean* params)
+	{
+		const glstub::State& state = glstub::GetState();
+
+		if (const auto capability = state.capabilities.find(pname); capability != state.capabilities.end())
+		{
+			params[0] = capability->second ? GL_TRUE : GL_FALSE;
+		}
+		else if (const auto it = state.booleans.find(pname); it != state.booleans.end())
+		{
+			std::copy(it->second.begin(), it->second.end(), params);
+		}
+		else
+		{
+			params[0] = GL_FALSE;
+		}
+
+		Record("glGetBooleanv", pname);
+	}
+
+	void GLAPIENTRY glGetFloatv(GLenum pname, GLfloat* params)
+	{
+		const auto it = glstub::GetState().floats.find(pname);
+		if (it != glstub::GetState().floats.end())
+		{
+			std::copy(it->second.begin(), it->second.end(), params);
+		}
+		else
+		{
+			params[0] = 0;
+		}
+
+		Record("glGetFloatv", pname);
+	}
+
+	void GLAPIENTRY glDepthFunc(GLenum func)
+	{
+		glstub::GetState().integers[GL_DEPTH_FUNC] = { static_cast<GLint>(func) };
+		Record("glDepthFunc", func);
+	}
+
+	void GLAPIENTRY glDepthMask(GLboolean flag)
+	{
+		glstub::GetState().booleans[GL_DEPTH_WRITEMASK] = { flag };
+		Record("glDepthMask", flag);
+	}
+
+	void GLAPIENTRY glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha)
+	{
+		glstub::GetState().booleans[GL_COLOR_WRITEMASK] = { red, green, blue, alpha };
+		Record("glColorMask", red, green, blue, alpha);
+	}
+
+	void GLAPIENTRY glBlendFunc(GLenum source, GLenum destination)
+	{
+		glstub::GetState().integers[GL_BLEND_SRC] = { static_cast<GLint>(source) };
+		glstub::GetState().integers[GL_BLEND_DST] = { static_cast<GLint>(destination) };
+		Record("glBlendFunc", source, destination);
+	}
+
+	void GLAPIENTRY glPolygonOffset(GLfloat factor, GLfloat units)
+	{
+		glstub::GetState().floats[GL_POLYGON_OFFSET_FACTOR] = { factor };
+		glstub::GetState().floats[GL_POLYGON_OFFSET_UNITS] = { units };
+		Record("glPolygonOffset", factor, units);
+	}
+
+	void GLAPIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		glstub::GetState().integers[GL_VIEWPORT] = { x, y, width, height };
+		Record("glViewport", x, y, width, height);
+	}
+
+	void GLAPIENTRY glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+	{
+		glstub::GetState().integers[GL_SCISSOR_BOX] = { x, y, width, height };
+		Record("glScissor", x, y, width, height);
+	}
+
+	void GLAPIENTRY glClear(GLbitfield mask)
+	{
+		Record("glClear", mask);
+	}
+
+	void GLAPIENTRY glDrawBuffer(GLenum mode)
+	{
+		Record("glDrawBuffer", mode);
+	}
+
+	void GLAPIENTRY glReadBuffer(GLenum mode)
+	{
+		Record("glReadBuffer", mode);
+	}
+
+	void GLAPIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count)
+	{
+		Record("glDrawArrays", mode, first, count);
+	}
+
+	void GLAPIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+	{
+		Record("glDrawElements", mode, count, type, indices);
+	}
+
+	void GLAPIENTRY glGenTextures(GLsizei n, GLuint* textures)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+		{
+			textures[i] = glstub::GetState().nextName++;
+			glstub::GetState().textures.insert(textures[i]);
+		}
+
+		Record("glGenTextures", n);
+	}
+
+	void GLAPIENTRY glDeleteTextures(GLsizei n, const GLuint* textures)
+	{
+		for (GLsizei i = 0; i < n; ++i)
+		{
+			glstub::GetState().textures.erase(textures[i]);
+			Record("glDeleteTextures", textures[i]);
+		}
+	}
+
+	void GLAPIENTRY glBindTexture(GLenum target, GLuint texture)
+	{
+		glstub::State& state = glstub::GetState();
+
+		const auto active = state.integers.find(GL_ACTIVE_TEXTURE);
+		const GLuint unit = active == state.integers.end() ? 0 : static_cast<GLuint>(active->second[0]) - GL_TEXTURE0;
+
+		if (GL_TEXTURE_2D == target)
+		{
+			state.textureUnits[unit] = texture;
+			state.integers[GL_TEXTURE_BINDING_2D] = { static_cast<GLint>(texture) };
+		}
+
+		Record("glBindTexture", target, texture);
+	}
+
+	void GLAPIENTRY glTexImage2D(GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+	{
+		Record("glTexImage2D", target, level, internal_format, width, height, border, format, type, pixels);
+	}
+
+	void GLAPIENTRY glTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+	{
+		Record("glTexSubImage2D", target, level, x, y, width, height, format, type, pixels);
+	}
+
+	void GLAPIENTRY glTexParameteri(GLenum target, GLenum pname, GLint param)
+	{
+		Record("glTexParameteri", target, pname, param);
+	}
+
+	// The fixed function entry points of the legacy primitives, only recorded
+	void GLAPIENTRY glBegin(GLenum mode)
+	{
+		Record("glBegin", mode);
+	}
+
+	void GLAPIENTRY glEnd()
+	{
+		Record("glEnd");
+	}
+
+	void GLAPIENTRY glColor3d(GLdouble red, GLdouble green, GLdouble blue)
+	{
+		Record("glColor3d", red, green, blue);
+	}
+
+	void GLAPIENTRY glColor3f(GLfloat red, GLfloat green, GLfloat blue)
+	{
+		Record("glColor3f", red, green, blue);
+	}
+
+	void GLAPIENTRY glColor3i(GLint red, GLint green, GLint blue)
+	{
+		Record("glColor3i", red, green, blue);
+	}
+
+	void GLAPIENTRY glColor3ub(GLubyte red, GLubyte green, GLubyte blue)
+	{
+		Record("glColor3ub", red, green, blue);
+	}
+
+	void GLAPIENTRY glColor4d(GLdouble red, GLdouble green, GLdouble blue, GLdouble alpha)
+	{
+		Record("glColor4d", red, green, blue, alpha);
+	}
+
+	void GLAPIENTRY glColor4f(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+	{
+		Record("glColor4f", red, green, blue, alpha);
+	}
+
+	void GLAPIENTRY glColor4i(GLint red, GLint green, GLint blue, GLint alpha)
+	{
+		Record("glColor4i", red, green, blue, alpha);
+	}
+
+	void GLAPIENTRY glColor4ub(GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha)
+	{
+		Record("glColor4ub", red, green, blue, alpha);
+	}
+
+	void GLAPIENTRY glColor4ubv(const GLubyte* v)
+	{
+		Record("glColor4ubv", v);
+	}
+
+	void GLAPIENTRY glNormal3d(GLdouble nx, GLdouble ny, GLdouble nz)
+	{
+		Record("glNormal3d", nx, ny, nz);
+	}
+
+	void GLAPIENTRY glNormal3dv(const GLdouble* v)
+	{
+		Record("glNormal3dv", v);
+	}
+
+	void GLAPIENTRY glNormal3f(GLfloat nx, GLfloat ny, GLfloat nz)
+	{
+		Record("glNormal3f", nx, ny, nz);
+	}
+
+	void GLAPIENTRY glNormal3fv(const GLfloat* v)
+	{
+		Record("glNormal3fv", v);
+	}
+
+	void GLAPIENTRY glNormal3i(GLint nx, GLint ny, GLint nz)
+	{
+		Record("glNormal3i", nx, ny, nz);
+	}
+
+	void GLAPIENTRY glNormal3iv(const GLint* v)
+	{
+		Record("glNormal3iv", v);
+	}
+
+	void GLAPIENTRY glTexCoord2d(GLdouble s, GLdouble t)
+	{
+		Record("glTexCoord2d", s, t);
+	}
+
+	void GLAPIENTRY glTexCoord2dv(const GLdouble* v)
+	{
+		Record("glTexCoord2dv", v);
+	}
+
+	void GLAPIENTRY glTexCoord2f(GLfloat s, GLfloat t)
+	{
+		Record("glTexCoord2f", s, t);
+	}
+
+	void GLAPIENTRY glTexCoord2fv(const GLfloat* v)
+	{
+		Record("glTexCoord2fv", v);
+	}
+
+	void GLAPIENTRY glTexCoord2i(GLint s, GLint t)
+	{
+		Record("glTexCoord2i", s, t);
+	}
+
+	void GLAPIENTRY glTexCoord2iv(const GLint* v)
+	{
+		Record("glTexCoord2iv", v);
+	}
+
+	void GLAPIENTRY glVertex3d(GLdouble x, GLdouble y, GLdouble z)
+	{
+		Record("glVertex3d", x, y, z);
+	}
+
+	void GLAPIENTRY glVertex3dv(const GLdouble* v)
+	{
+		Record("glVertex3dv", v);
+	}
+
+	void GLAPIENTRY glVertex3f(GLfloat x, GLfloat y, GLfloat z)
+	{
+		Record("glVertex3f", x, y, z);
+	}
+
+	void GLAPIENTRY glVertex3fv(const GLfloat* v)
+	{
+		Record("glVertex3fv", v);
+	}
+
+	void GLAPIENTRY glVertex3i(GLint x, GLint y, GLint z)
+	{
+		Record("glVertex3i", x, y, z);
+	}
+
+	void GLAPIENTRY glVertex3iv(const GLint* v)
+	{
+		Record("glVertex3iv", v);
+	}
+
+	void GLAPIENTRY glEnableClientState(GLenum array)
+	{
+		Record("glEnableClientState", array);
+	}
+
+	void GLAPIENTRY glPushClientAttrib(GLbitfield mask)
+	{
+		Record("glPushClientAttrib", mask);
+	}
+
+	void GLAPIENTRY glPopClientAttrib()
+	{
+		Record("glPopClientAttrib");
+	}
+
+	void GLAPIENTRY glVertexPointer(GLint size, GLenum type, GLsizei stride, const void* pointer)
+	{
+		Record("glVertexPointer", size, type, stride, pointer);
+	}
+
+	void GLAPIENTRY glNormalPointer(GLenum type, GLsizei stride, const void* pointer)
+	{
+		Record("glNormalPointer", type, stride, pointer);
+	}
+
+	void GLAPIENTRY glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const void* pointer)
+	{
+		Record("glTexCoordPointer", size, type, stride, pointer);
+	}
+
+	void GLAPIENTRY glColorPointer(GLint size, GLenum type, GLsizei stride, const void* pointer)
+	{
+		Record("glColorPointer", size, type, stride, pointer);
+	}
+
+	PFNGLGENBUFFERSPROC __glewGenBuffers = GenBuffers;
+	PFNGLDELETEBUFFERSPROC __glewDeleteBuffers = DeleteBuffers;
+	PFNGLBINDBUFFERPROC __glewBindBuffer = BindBuffer;
+	PFNGLBINDBUFFERBASEPROC __glewBindBufferBase = BindBufferBase;
+	PFNGLBUFFERDATAPROC __glewBufferData = BufferData;
+	PFNGLBUFFERSUBDATAPROC __glewBufferSubData = BufferSubData;
+	PFNGLMAPBUFFERRANGEPROC __glewMapBufferRange = MapBufferRange;
+	PFNGLUNMAPBUFFERPROC __glewUnmapBuffer = UnmapBuffer;
+	PFNGLFENCESYNCPROC __glewFenceSync = FenceSync;
+	PFNGLCLIENTWAITSYNCPROC __glewClientWaitSync = ClientWaitSync;
+	PFNGLDELETESYNCPROC __glewDeleteSync = DeleteSync;
+	PFNGLGENQUERIESPROC __glewGenQueries = GenQueries;
+	PFNGLDELETEQUERIESPROC __glewDeleteQueries = DeleteQueries;
+	PFNGLQUERYCOUNTERPROC __glewQueryCounter = QueryCounter;
+	PFNGLGETQUERYOBJECTIVPROC __glewGetQueryObjectiv = GetQueryObjectiv;
+	PFNGLGETQUERYOBJECTUI64VPROC __glewGetQueryObjectui64v = GetQueryObjectui64v;
+	PFNGLGETINTEGER64VPROC __glewGetInteger64v = GetInteger64v;
+	PFNGLMEMORYBARRIERPROC __glewMemoryBarrier = MemoryBarrier;
+	PFNGLTEXSTORAGE2DPROC __glewTexStorage2D = TexStorage2D;
+	PFNGLGENERATEMIPMAPPROC __glewGenerateMipmap = GenerateMipmap;
+	PFNGLTEXTUREPARAMETERIPROC __glewTextureParameteri = TextureParameteri;
+	PFNGLINVALIDATETEXIMAGEPROC __glewInvalidateTexImage = InvalidateTexImage;
+	PFNGLINVALIDATEBUFFERDATAPROC __glewInvalidateBufferData = InvalidateBufferData;
+	PFNGLACTIVETEXTUREPROC __glewActiveTexture = ActiveTexture;
+	PFNGLGENFRAMEBUFFERSPROC __glewGenFramebuffers = GenFramebuffers;
+	PFNGLDELETEFRAMEBUFFERSPROC __glewDeleteFramebuffers = DeleteFramebuffers;
+	PFNGLBINDFRAMEBUFFERPROC __glewBindFramebuffer = BindFramebuffer;
+	PFNGLFRAMEBUFFERTEXTURE2DPROC __glewFramebufferTexture2D = FramebufferTexture2D;
+	PFNGLDRAWBUFFERSPROC __glewDrawBuffers = DrawBuffers;
+	PFNGLCHECKFRAMEBUFFERSTATUSPROC __glewCheckFramebufferStatus = CheckFramebufferStatus;
+	PFNGLCREATEPROGRAMPROC __glewCreateProgram = CreateProgram;
+	PFNGLDELETEPROGRAMPROC __glewDeleteProgram = DeleteProgram;
+	PFNGLUSEPROGRAMPROC __glewUseProgram = UseProgram;
+	PFNGLLINKPROGRAMPROC __glewLinkProgram = LinkProgram;
+	PFNGLATTACHSHADERPROC __glewAttachShader = AttachShader;
+	PFNGLDETACHSHADERPROC __glewDetachShader = DetachShader;
+	PFNGLCREATESHADERPROC __glewCreateShader = CreateShader;
+	PFNGLDELETESHADERPROC __glewDeleteShader = DeleteShader;
+	PFNGLSHADERSOURCEPROC __glewShaderSource = ShaderSource;
+	PFNGLCOMPILESHADERPROC __glewCompileShader = CompileShader;
+	PFNGLGETSHADERIVPROC __glewGetShaderiv = GetShaderiv;
+	PFNGLGETSHADERINFOLOGPROC __glewGetShaderInfoLog = GetShaderInfoLog;
+	PFNGLUNIFORMMATRIX4FVPROC __glewUniformMatrix4fv = UniformMatrix4fv;
+	PFNGLENABLEVERTEXATTRIBARRAYPROC __glewEnableVertexAttribArray = EnableVertexAttribArray;
+	PFNGLDISABLEVERTEXATTRIBARRAYPROC __glewDisableVertexAttribArray = DisableVertexAttribArray;
+	PFNGLVERTEXATTRIBPOINTERPROC __glewVertexAttribPointer = VertexAttribPointer;
+	PFNGLCOPYBUFFERSUBDATAPROC __glewCopyBufferSubData = CopyBufferSubData;
+	PFNGLBUFFERSTORAGEPROC __glewBufferStorage = BufferStorage;
+	PFNGLGENVERTEXARRAYSPROC __glewGenVertexArrays = GenVertexArrays;
+	PFNGLDELETEVERTEXARRAYSPROC __glewDeleteVertexArrays = DeleteVertexArrays;
+	PFNGLBINDVERTEXARRAYPROC __glewBindVertexArray = BindVertexArray;
+	PFNGLGETPROGRAMIVPROC __glewGetProgramiv = GetProgramiv;
+	PFNGLDRAWELEMENTSBASEVERTEXPROC __glewDrawElementsBaseVertex = DrawElementsBaseVertex;
+	PFNGLVERTEXATTRIBDIVISORPROC __glewVertexAttribDivisor = VertexAttribDivisor;
+	PFNGLDRAWARRAYSINSTANCEDPROC __glewDrawArraysInstanced = DrawArraysInstanced;
+
+	// The persistent mappings are always there
+	GLboolean __GLEW_VERSION_4_4 = GL_TRUE;
+	GLboolean __GLEW_ARB_buffer_storage = GL_TRUE;
+}
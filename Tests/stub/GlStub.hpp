@@ -0,0 +1,61 @@
+#pragma once
+#include "glew.h"
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// <summary>
+/// A recording opengl without a context
+/// <para>Every entry point used by the tests appends its call, and keeps just enough state to answer the queries of the library.</para>
+/// </summary>
+namespace glstub
+{
+	struct Call
+	{
+		std::string name;
+		std::vector<std::int64_t> args;
+	};
+
+	struct State
+	{
+		std::vector<Call> calls;
+
+		// Set by glEnable and glDisable, read back by glIsEnabled and glGetBooleanv
+		std::map<GLenum, bool> capabilities;
+		// The state setters write their values here, as the queries return them
+		std::map<GLenum, std::vector<GLint>> integers;
+		std::map<GLenum, std::vector<GLboolean>> booleans;
+		std::map<GLenum, std::vector<GLfloat>> floats;
+
+		GLuint nextName = 1;
+		std::map<GLuint, std::vector<std::uint8_t>> buffers;
+		std::map<GLenum, GLuint> boundBuffers;
+
+		std::set<GLuint> textures;
+		// Texture bound to each unit
+		std::map<GLuint, GLuint> textureUnits;
+		std::set<GLuint> framebuffers;
+		// What every glCheckFramebufferStatus answers
+		GLenum framebufferStatus = GL_FRAMEBUFFER_COMPLETE;
+
+		std::set<GLuint> programs;
+		std::set<GLuint> shaders;
+		// What glGetShaderiv answers for GL_COMPILE_STATUS
+		GLint compileStatus = GL_TRUE;
+
+		std::uintptr_t nextSync = 1;
+		std::set<std::uintptr_t> syncs;
+		// What every glClientWaitSync answers
+		GLenum waitResult = GL_ALREADY_SIGNALED;
+	};
+
+	[[nodiscard]] State& GetState() noexcept;
+	void Reset();
+
+	[[nodiscard]] std::size_t CountCalls(std::string_view name);
+	[[nodiscard]] std::vector<Call> FindCalls(std::string_view name);
+}
@@ -0,0 +1,81 @@
+#include "Glib.hpp"
+#include "glew.h"
+
+// The global states of OpenGL.cpp, whose other functions need a context
+namespace
+{
+	constinit gl::global::StateListener state_listener = nullptr;
+}
+
+void
+gl::global::SetState(const gl::State& state)
+noexcept
+{
+	NotifyStateChange();
+
+	::glEnable(static_cast<GLenum>(state));
+}
+
+void
+gl::global::SetState(gl::State&& state)
+noexcept
+{
+	SetState(static_cast<const gl::State&>(state));
+}
+
+void
+gl::global::SetState(const gl::State& state, bool flag)
+noexcept
+{
+	NotifyStateChange();
+
+	if (flag)
+	{
+		::glEnable(static_cast<GLenum>(state));
+	}
+	else
+	{
+		::glDisable(static_cast<GLenum>(state));
+	}
+}
+
+void
+gl::global::SetState(gl::State&& state, bool flag)
+noexcept
+{
+	SetState(static_cast<const gl::State&>(state), flag);
+}
+
+bool
+gl::global::IsBlending()
+noexcept
+{
+	GLboolean result{};
+	::glGetBooleanv(GL_BLEND, &result);
+
+	return GL_TRUE == result;
+}
+
+void
+gl::global::SetStateListener(gl::global::StateListener listener)
+noexcept
+{
+	state_listener = listener;
+}
+
+gl::global::StateListener
+gl::global::GetStateListener()
+noexcept
+{
+	return state_listener;
+}
+
+void
+gl::global::NotifyStateChange()
+noexcept
+{
+	if (nullptr != state_listener)
+	{
+		state_listener();
+	}
+}
@@ -0,0 +1,55 @@
+#include "Glib.Texture.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Image.cpp decodes through ATL, every image of the tests is a checkerboard instead
+gl::Image
+gl::LoadImage(const gl::FilePath&)
+{
+	constexpr std::size_t Width = 8;
+	constexpr std::size_t Height = 4;
+
+	gl::Image result{};
+	result.imgBuffer = std::make_unique<gl::BitmapPixel[]>(Width * Height);
+	result.imgBufferSize = Width * Height * sizeof(gl::BitmapPixel);
+	result.imgHSize = Width;
+	result.imgVSize = Height;
+	result.bitsPerPixel = 32;
+
+	for (std::size_t i = 0; i < Width * Height; ++i)
+	{
+		const std::uint8_t value = (i + i / Width) % 2 ? 0xFFU : 0x00U;
+		result.imgBuffer[i] = gl::BitmapPixel{ gl::Colour{ value, value, value } };
+	}
+
+	return result;
+}
+
+gl::Image::buffer_t&
+gl::Image::GetBuffer()
+noexcept
+{
+	return imgBuffer;
+}
+
+std::size_t
+gl::Image::GetWidth()
+const noexcept
+{
+	return imgHSize;
+}
+
+std::size_t
+gl::Image::GetHeight()
+const noexcept
+{
+	return imgVSize;
+}
+
+bool
+gl::Image::IsEmpty()
+const noexcept
+{
+	return nullptr == imgBuffer;
+}
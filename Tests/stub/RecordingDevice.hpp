@@ -0,0 +1,131 @@
+#pragma once
+#include "Glib.RenderTarget.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace glstub
+{
+	/// <summary>
+	/// A render target device which only hands out names
+	/// <para>It keeps the live textures and framebuffers, and writes down every misuse of them in errors instead of failing.</para>
+	/// </summary>
+	class RecordingDevice final : public gl::target::Device
+	{
+	public:
+		struct Texture
+		{
+			std::uint32_t name;
+			gl::target::Description description;
+		};
+
+		[[nodiscard]]
+		std::uint32_t
+		CreateTexture(const gl::target::Description& description)
+		noexcept override
+		{
+			const std::uint32_t texture = myNextName++;
+
+			textures.insert(texture);
+			created.push_back(Texture{ texture, description });
+			peakTextures = std::max(peakTextures, textures.size());
+
+			return texture;
+		}
+
+		void
+		DeleteTexture(std::uint32_t texture)
+		noexcept override
+		{
+			if (0 == textures.erase(texture))
+			{
+				errors.push_back("deleted the texture " + std::to_string(texture) + " twice");
+			}
+
+			++deletedTextures;
+		}
+
+		void
+		BindTexture(std::uint32_t unit, std::uint32_t texture)
+		noexcept override
+		{
+			if (!textures.contains(texture))
+			{
+				errors.push_back("bound the dead texture " + std::to_string(texture) + " to the unit " + std::to_string(unit));
+			}
+
+			boundTextures.push_back(texture);
+		}
+
+		[[nodiscard]]
+		std::uint32_t
+		CreateFramebuffer(std::span<const std::uint32_t> colours, std::uint32_t depth, gl::target::Format)
+		noexcept override
+		{
+			for (const std::uint32_t colour : colours)
+			{
+				if (!textures.contains(colour))
+				{
+					errors.push_back("attached the dead texture " + std::to_string(colour));
+				}
+			}
+
+			if (0 != depth && !textures.contains(depth))
+			{
+				errors.push_back("attached the dead depth texture " + std::to_string(depth));
+			}
+
+			++createdFramebuffers;
+			if (!isComplete)
+			{
+				return 0;
+			}
+
+			const std::uint32_t framebuffer = myNextName++;
+			framebuffers.insert(framebuffer);
+
+			return framebuffer;
+		}
+
+		void
+		DeleteFramebuffer(std::uint32_t framebuffer)
+		noexcept override
+		{
+			if (0 == framebuffers.erase(framebuffer))
+			{
+				errors.push_back("deleted the framebuffer " + std::to_string(framebuffer) + " twice");
+			}
+		}
+
+		void
+		BindFramebuffer(std::uint32_t framebuffer, std::uint32_t, std::uint32_t)
+		noexcept override
+		{
+			if (0 != framebuffer && !framebuffers.contains(framebuffer))
+			{
+				errors.push_back("bound the dead framebuffer " + std::to_string(framebuffer));
+			}
+
+			boundFramebuffers.push_back(framebuffer);
+		}
+
+		std::set<std::uint32_t> textures{};
+		std::set<std::uint32_t> framebuffers{};
+		std::vector<Texture> created{};
+		std::vector<std::uint32_t> boundTextures{};
+		std::vector<std::uint32_t> boundFramebuffers{};
+		std::vector<std::string> errors{};
+
+		std::size_t peakTextures = 0;
+		std::size_t deletedTextures = 0;
+		std::size_t createdFramebuffers = 0;
+		// What every CreateFramebuffer answers, false makes it return zero
+		bool isComplete = true;
+
+	private:
+		std::uint32_t myNextName = 1;
+	};
+}
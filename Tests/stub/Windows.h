@@ -0,0 +1,36 @@
+#pragma once
+// Stands in for the windows headers included before glew by the sources under test
+
+// The handles and records the windows resource interfaces name, opaque as no test reaches the system
+#ifndef CALLBACK
+#define CALLBACK
+#endif
+
+struct HWND__;
+struct HINSTANCE__;
+struct HDC__;
+struct HGLRC__;
+struct HMENU__;
+struct HBITMAP__;
+struct HICON__;
+struct HBRUSH__;
+struct HPEN__;
+struct HPALETTE__;
+struct HFONT__;
+struct tagWNDCLASSEXW;
+struct tagRECT;
+struct tagPAINTSTRUCT;
+struct tagPIXELFORMATDESCRIPTOR;
+
+#define BS_NULL 1
+
+typedef struct tagLOGBRUSH
+{
+	unsigned int lbStyle;
+	unsigned long lbColor;
+	unsigned long long lbHatch;
+} LOGBRUSH;
+
+// Defined by stub/Gdi.cpp
+int GetObjectW(void* handle, int size, void* output);
+unsigned long GetSysColor(int index);
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+// The colour of the windows runtime, the only part of it the tests need
+namespace winrt::Windows::UI
+{
+	struct Color
+	{
+		std::uint8_t A;
+		std::uint8_t R;
+		std::uint8_t G;
+		std::uint8_t B;
+	};
+}